@@ -18,11 +18,12 @@
 ** along with this program. If not, see https://www.gnu.org/licenses/.
 */
 
-#include "../stdafx.h"
+#include <cassert>
 #include "../Common.h"
 #include <algorithm>  // std::min
 #include "APU.h"
 #include "2A03.h"
+#include "StateArchive.h"		// // //
 #include "../RegisterState.h"		// // //
 #include "utils/variadic_minmax.h"
 #include "nsfplay/xgm/devices/devinfo.h"		// // !!
@@ -52,6 +53,8 @@ void C2A03::Reset()
 
 	m_Apu1.Reset();
 	m_Apu2.Reset();
+	m_Apu1.SetMask(m_iChannelMask & 0x03);
+	m_Apu2.SetMask(m_iChannelMask >> 2 & 0x07);
 
 	Synth2A03SS.clear();
 	Synth2A03TND.clear();
@@ -73,6 +76,22 @@ void C2A03::Reset()
 	}
 }
 
+void CSampleMem::SerializeState(CStateArchive &State)		// // //
+{
+	State(m_pMemory, m_iMemSize);
+}
+
+void C2A03::SerializeState(CStateArchive &State)		// // //
+{
+	CSoundChip2::SerializeState(State);
+	m_SampleMem.SerializeState(State);
+	m_Apu1.SerializeState(State);
+	m_Apu2.SerializeState(State);
+	State(m_ChannelLevels, m_iTime);
+	Synth2A03SS.serialize_state(State);
+	Synth2A03TND.serialize_state(State);
+}
+
 void C2A03::UpdateFilter(blip_eq_t eq)
 {
 	Synth2A03SS.treble_eq(eq);
@@ -132,6 +151,14 @@ void C2A03::Write(uint16_t Address, uint8_t Value)
 	m_Apu2.Write(Address, Value);
 }
 
+void C2A03::SetChannelMask(uint32_t Mask)
+{
+	// Pulse 1 and 2 live in APU1, triangle, noise and DPCM in APU2
+	m_iChannelMask = Mask;
+	m_Apu1.SetMask(Mask & 0x03);
+	m_Apu2.SetMask(Mask >> 2 & 0x07);
+}
+
 uint8_t C2A03::Read(uint16_t Address, bool &Mapped)
 {
 	switch (Address) {
@@ -142,7 +169,7 @@ uint8_t C2A03::Read(uint16_t Address, bool &Mapped)
 		// Each Read() call updates different bits in the byte.
 		Mapped |= m_Apu1.Read(Address, /*mut*/ out);
 		Mapped |= m_Apu2.Read(Address, /*mut*/ out);
-		ASSERT((out & 0xFF) == out);
+		assert((out & 0xFF) == out);
 		return out;
 	}
 	}
@@ -168,7 +195,7 @@ double C2A03::GetFreq(int Channel) const		// // !!
 
 int C2A03::GetChannelLevel(int Channel)
 {
-	ASSERT(0 <= Channel && Channel < 5);
+	assert(0 <= Channel && Channel < 5);
 	if (0 <= Channel && Channel < 5) {
 		return m_ChannelLevels[Channel].getLevel();
 	}
@@ -177,7 +204,7 @@ int C2A03::GetChannelLevel(int Channel)
 
 int C2A03::GetChannelLevelRange(int Channel) const
 {
-	ASSERT(0 <= Channel && Channel < 5);
+	assert(0 <= Channel && Channel < 5);
 	switch (Channel) {
 	case 0: case 1: case 2: case 3:
 		// pulse/tri/noise
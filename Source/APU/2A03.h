@@ -54,6 +54,9 @@ public:
 		m_iMemSize = 0;
 	}
 
+	/// The sample is referenced, not copied.
+	void SerializeState(CStateArchive &State);		// // //
+
 // impl xgm::IDevice
 
 	// CSampleMem as IDevice is only used by NES_DMC.
@@ -63,11 +66,11 @@ public:
 	void Reset() override {}
 
 	// not called, don't care
-	bool Write(UINT32 adr, UINT32 val, UINT32 id) override {
+	bool Write(xgm::UINT32 adr, xgm::UINT32 val, xgm::UINT32 id) override {
 		return false;
 	}
 
-	bool Read(UINT32 adr, UINT32& val, UINT32 id) override {
+	bool Read(xgm::UINT32 adr, xgm::UINT32& val, xgm::UINT32 id) override {
 		val = Read((uint16_t)adr);
 		return true;
 	}
@@ -89,10 +92,12 @@ public:
 
 	void Write(uint16_t Address, uint8_t Value) override;
 	uint8_t Read(uint16_t Address, bool &Mapped) override;
+	void SetChannelMask(uint32_t Mask) override;
 
 	double GetFreq(int Channel) const override;		// // //
 	int GetChannelLevel(int Channel) override;
 	int GetChannelLevelRange(int Channel) const override;
+	void SerializeState(CStateArchive &State) override;		// // //
 
 public:
 	void UpdateMixingAPU1(double v, bool UseSurveyMix = false);
@@ -121,4 +126,5 @@ private:
 	Blip_Synth<blip_good_quality> Synth2A03TND;
 
 	uint32_t	m_iTime = 0;  // Clock counter, used as a timestamp for Blip_Buffer, resets every new frame
+	uint32_t	m_iChannelMask = 0;		// Silenced channels, nsfplay clears its masks on reset
 };
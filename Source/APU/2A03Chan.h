@@ -31,6 +31,11 @@ public:
 		return m_iPeriod;
 	}
 
+	void SerializeState(CStateArchive &State) override {		// // //
+		CChannel::SerializeState(State);
+		State(m_iControlReg, m_iEnabled, m_iPeriod, m_iLengthCounter, m_iCounter);
+	}
+
 protected:
 	inline void Mix(int32_t Value) {
 		if (m_iLastValue != Value) {
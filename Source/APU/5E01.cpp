@@ -20,11 +20,12 @@
 ** must bear this legend.
 */
 
-#include "../stdafx.h"
+#include <cassert>
 #include "../Common.h"
 #include <algorithm>  // std::min
 #include "APU.h"
 #include "5E01.h"
+#include "StateArchive.h"		// // //
 #include "../RegisterState.h"		// // //
 #include "utils/variadic_minmax.h"
 #include "nsfplay/xgm/devices/devinfo.h"		// // !!
@@ -54,6 +55,8 @@ void C5E01::Reset()
 
 	m_Apu1.Reset();
 	m_Apu2.Reset();
+	m_Apu1.SetMask(m_iChannelMask & 0x03);
+	m_Apu2.SetMask(m_iChannelMask >> 2 & 0x07);
 
 	Synth5E01SS.clear();
 	Synth5E01TND.clear();
@@ -75,6 +78,22 @@ void C5E01::Reset()
 	}
 }
 
+void C5E01SampleMem::SerializeState(CStateArchive &State)		// // //
+{
+	State(m_pMemory, m_iMemSize);
+}
+
+void C5E01::SerializeState(CStateArchive &State)		// // //
+{
+	CSoundChip2::SerializeState(State);
+	m_SampleMem.SerializeState(State);
+	m_Apu1.SerializeState(State);
+	m_Apu2.SerializeState(State);
+	State(m_ChannelLevels, m_iTime);
+	Synth5E01SS.serialize_state(State);
+	Synth5E01TND.serialize_state(State);
+}
+
 void C5E01::UpdateFilter(blip_eq_t eq)
 {
 	Synth5E01SS.treble_eq(eq);
@@ -134,6 +153,14 @@ void C5E01::Write(uint16_t Address, uint8_t Value)
 	m_Apu2.Write(Address, Value);
 }
 
+void C5E01::SetChannelMask(uint32_t Mask)
+{
+	// Pulse 1 and 2 live in APU1, triangle, noise and DPCM in APU2
+	m_iChannelMask = Mask;
+	m_Apu1.SetMask(Mask & 0x03);
+	m_Apu2.SetMask(Mask >> 2 & 0x07);
+}
+
 uint8_t C5E01::Read(uint16_t Address, bool &Mapped)
 {
 	switch (Address) {
@@ -144,7 +171,7 @@ uint8_t C5E01::Read(uint16_t Address, bool &Mapped)
 		// Each Read() call updates different bits in the byte.
 		Mapped |= m_Apu1.Read(Address, /*mut*/ out);
 		Mapped |= m_Apu2.Read(Address, /*mut*/ out);
-		ASSERT((out & 0xFF) == out);
+		assert((out & 0xFF) == out);
 		return out;
 	}
 	}
@@ -170,7 +197,7 @@ double C5E01::GetFreq(int Channel) const		// // !!
 
 int C5E01::GetChannelLevel(int Channel)
 {
-	//ASSERT(0 <= Channel && Channel < 5);
+	//assert(0 <= Channel && Channel < 5);
 	if (0 <= Channel && Channel < 5) {
 		return m_ChannelLevels[Channel].getLevel();
 	}
@@ -179,7 +206,7 @@ int C5E01::GetChannelLevel(int Channel)
 
 int C5E01::GetChannelLevelRange(int Channel) const
 {
-	//ASSERT(0 <= Channel && Channel < 5);
+	//assert(0 <= Channel && Channel < 5);
 	switch (Channel) {
 	case 0: case 1: case 2: case 3:
 		// pulse/tri/noise
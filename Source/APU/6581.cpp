@@ -20,7 +20,6 @@
 ** must bear this legend.
 */
 
-#include "../stdafx.h"
 #include "../Common.h"
 #include <algorithm>  // std::min
 #include "APU.h"
@@ -29,6 +28,8 @@
 #include "../RegisterState.h"		// // //
 #include "utils/variadic_minmax.h"
 #include "residfp/SID.h"		// // !!
+#include "residfp/resample/ZeroOrderResampler.h"
+#include "StateArchive.h"		// // //
 
 // // // 6581 sound chip class
 
@@ -46,11 +47,20 @@ void C6581::Reset()
 	m_Sid.reset();
 	Synth6581.clear();
 
-	m_Sid.setSamplingParameters(CAPU::BASE_FREQ_ATARI, SamplingMethod::DECIMATE, 44100, 44100);
 	m_Sid.setFilter6581Curve(0.875);
 	m_Sid.setChipModel(MOS6581);
 	m_Sid.enableFilter(true);
+	ConfigureSampling();
+}
 
+void C6581::SerializeState(CStateArchive &State)		// // //
+{
+	CSoundChip2::SerializeState(State);
+	m_Sid.SerializeState(State);
+	if (auto pZeroOrder = dynamic_cast<reSIDfp::ZeroOrderResampler *>(m_Sid.resampler.get()))
+		pZeroOrder->SerializeState(State);
+	State(m_ChannelLevels, m_iTime, m_iStepOverrun);
+	Synth6581.serialize_state(State);
 }
 
 void C6581::UpdateFilter(blip_eq_t eq)
@@ -59,12 +69,22 @@ void C6581::UpdateFilter(blip_eq_t eq)
 }
 
 void C6581::SetSampleSpeed(uint32_t SampleRate) {
-	m_Sid.setSamplingParameters(CAPU::BASE_FREQ_ATARI, SamplingMethod::DECIMATE, SampleRate, SampleRate);
+	m_iSampleRate = SampleRate;
+	ConfigureSampling();
+}
+
+void C6581::ConfigureSampling()
+{
+	// The external filter is always tuned for the Atari clock, as before.
+	m_Sid.setSamplingParameters(CAPU::BASE_FREQ_ATARI, SamplingMethod::DECIMATE, m_iSampleRate, m_iSampleRate);
+	m_iStepOverrun = 0;
 }
 
 void C6581::Process(uint32_t Time, Blip_Buffer& Output)
 {
-	uint32_t now = 0;
+	// A step can run past the end of the previous call, so start where it ended
+	// instead of clocking the chip faster than the rest of the APU.
+	uint32_t now = m_iStepOverrun;
 
 	auto get_output = [this](uint32_t dclocks, uint32_t now, Blip_Buffer& blip_buf) {
 		short buf = {};
@@ -74,10 +94,7 @@ void C6581::Process(uint32_t Time, Blip_Buffer& Output)
 		m_Sid.externalFilter->clock((unsigned short)(m_iInput));
 
 		Synth6581.update(m_iTime + now, (int)(m_Sid.output() * 0.25), &blip_buf);
-		// channel levels
-		m_ChannelLevels[0].update((uint8_t)((m_Sid.voice[0]->output(m_Sid.voice[2]->wave()) + 2048 * 255) / 8192));
-		m_ChannelLevels[1].update((uint8_t)((m_Sid.voice[1]->output(m_Sid.voice[0]->wave()) + 2048 * 255) / 8192));
-		m_ChannelLevels[2].update((uint8_t)((m_Sid.voice[2]->output(m_Sid.voice[1]->wave()) + 2048 * 255) / 8192));
+		UpdateChannelLevels();
 	};
 
 	while (now < Time) {
@@ -90,9 +107,17 @@ void C6581::Process(uint32_t Time, Blip_Buffer& Output)
 		now += dclocks;
 	}
 
+	m_iStepOverrun = now - Time;
 	m_iTime += Time;
 }
 
+void C6581::UpdateChannelLevels()
+{
+	m_ChannelLevels[0].update((uint8_t)((m_Sid.voice[0]->output(m_Sid.voice[2]->wave()) + 2048 * 255) / 8192));
+	m_ChannelLevels[1].update((uint8_t)((m_Sid.voice[1]->output(m_Sid.voice[0]->wave()) + 2048 * 255) / 8192));
+	m_ChannelLevels[2].update((uint8_t)((m_Sid.voice[2]->output(m_Sid.voice[1]->wave()) + 2048 * 255) / 8192));
+}
+
 void C6581::EndFrame(Blip_Buffer&, gsl::span<int16_t>)
 {
 	m_iTime = 0;
@@ -104,6 +129,13 @@ void C6581::Write(uint16_t Address, uint8_t Value)
 		m_Sid.write(Address - 0xD400, Value);
 }
 
+void C6581::SetChannelMask(uint32_t Mask)
+{
+	// reSID-fp silences a voice by dropping its control register writes, and keeps that across resets
+	for (int i = 0; i < 3; ++i)
+		m_Sid.mute(i, (Mask >> i & 1) != 0);
+}
+
 uint8_t C6581::Read(uint16_t Address, bool& Mapped)
 {
 	//if (Address >= 0xD400 && Address <= 0xD41C)
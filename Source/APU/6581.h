@@ -42,15 +42,21 @@ public:
 
 	void Write(uint16_t Address, uint8_t Value) override;
 	uint8_t Read(uint16_t Address, bool& Mapped) override;
+	void SetChannelMask(uint32_t Mask) override;
 
 	double GetFreq(int Channel) const override;		// // //
 	int GetChannelLevel(int Channel) override;
 	int GetChannelLevelRange(int Channel) const override;
+	void SerializeState(CStateArchive &State) override;		// // //
 
 public:
 	void UpdateMix(double v);
 	void SetInput(int x);
 
+private:
+	void ConfigureSampling();
+	void UpdateChannelLevels();
+
 private:
 
 	reSIDfp::SID m_Sid;
@@ -63,4 +69,7 @@ private:
 	uint32_t	m_iTime = 0;  // Clock counter, used as a timestamp for Blip_Buffer, resets every new frame
 
 	int m_iInput = 0;
+
+	uint32_t	m_iSampleRate = 44100;
+	uint32_t	m_iStepOverrun = 0;			// Cycles the last step ran past the end of the previous Process()
 };
\ No newline at end of file
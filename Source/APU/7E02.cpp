@@ -20,11 +20,12 @@
 ** must bear this legend.
 */
 
-#include "../stdafx.h"
+#include <cassert>
 #include "../Common.h"
 #include <algorithm>  // std::min
 #include "APU.h"
 #include "7E02.h"
+#include "StateArchive.h"		// // //
 #include "../RegisterState.h"		// // //
 #include "utils/variadic_minmax.h"
 #include "nsfplay/xgm/devices/devinfo.h"		// // !!
@@ -54,6 +55,8 @@ void C7E02::Reset()
 
 	m_Apu1.Reset();
 	m_Apu2.Reset();
+	m_Apu1.SetMask(m_iChannelMask & 0x03);
+	m_Apu2.SetMask(m_iChannelMask >> 2 & 0x07);
 
 	Synth7E02FF.clear();
 	Synth7E02WND.clear();
@@ -75,6 +78,22 @@ void C7E02::Reset()
 	}
 }
 
+void C7E02SampleMem::SerializeState(CStateArchive &State)		// // //
+{
+	State(m_pMemory, m_iMemSize);
+}
+
+void C7E02::SerializeState(CStateArchive &State)		// // //
+{
+	CSoundChip2::SerializeState(State);
+	m_SampleMem.SerializeState(State);
+	m_Apu1.SerializeState(State);
+	m_Apu2.SerializeState(State);
+	State(m_ChannelLevels, m_iTime);
+	Synth7E02FF.serialize_state(State);
+	Synth7E02WND.serialize_state(State);
+}
+
 void C7E02::UpdateFilter(blip_eq_t eq)
 {
 	Synth7E02FF.treble_eq(eq);
@@ -134,6 +153,14 @@ void C7E02::Write(uint16_t Address, uint8_t Value)
 	m_Apu2.Write(Address, Value);
 }
 
+void C7E02::SetChannelMask(uint32_t Mask)
+{
+	// Pulse 1 and 2 live in APU1, triangle, noise and DPCM in APU2
+	m_iChannelMask = Mask;
+	m_Apu1.SetMask(Mask & 0x03);
+	m_Apu2.SetMask(Mask >> 2 & 0x07);
+}
+
 uint8_t C7E02::Read(uint16_t Address, bool &Mapped)
 {
 	switch (Address) {
@@ -144,7 +171,7 @@ uint8_t C7E02::Read(uint16_t Address, bool &Mapped)
 		// Each Read() call updates different bits in the byte.
 		Mapped |= m_Apu1.Read(Address, /*mut*/ out);
 		Mapped |= m_Apu2.Read(Address, /*mut*/ out);
-		ASSERT((out & 0xFF) == out);
+		assert((out & 0xFF) == out);
 		return out;
 	}
 	}
@@ -170,7 +197,7 @@ double C7E02::GetFreq(int Channel) const		// // !!
 
 int C7E02::GetChannelLevel(int Channel)
 {
-	//ASSERT(0 <= Channel && Channel < 5);
+	//assert(0 <= Channel && Channel < 5);
 	if (0 <= Channel && Channel < 5) {
 		return m_ChannelLevels[Channel].getLevel();
 	}
@@ -179,7 +206,7 @@ int C7E02::GetChannelLevel(int Channel)
 
 int C7E02::GetChannelLevelRange(int Channel) const
 {
-	//ASSERT(0 <= Channel && Channel < 5);
+	//assert(0 <= Channel && Channel < 5);
 	switch (Channel) {
 	case 0: case 1: case 2:
 		// fwg/tri
@@ -20,7 +20,7 @@
 
 #include <algorithm>		// // //
 #include <vector>
-#include "../stdafx.h"
+#include <cassert>
 #include <cstdio>
 #include <memory>
 #include <cmath>
@@ -42,8 +42,47 @@
 
 #include "SoundChip.h"
 #include "SoundChip2.h"
+#include "WorkerPool.h"
+#include "StateArchive.h"		// // //
 #include "../RegisterState.h"		// // //
-#include "../SpeedDlg.h"
+
+// Playing at FPS < 0.5*RATE_MIN will overflow blip_buffer.
+const int RATE_MIN = 16;		// // //
+
+namespace {
+
+// Channel ID ranges of every sound chip, in chan_id_t order
+struct stChipChannels {
+	int First;
+	int Count;
+	int Chip;
+};
+
+const stChipChannels CHIP_CHANNELS[] = {
+	{CHANID_2A03_SQUARE1, 5, SNDCHIP_NONE},
+	{CHANID_VRC6_PULSE1, 3, SNDCHIP_VRC6},
+	{CHANID_MMC5_SQUARE1, 3, SNDCHIP_MMC5},
+	{CHANID_N163_CH1, 8, SNDCHIP_N163},
+	{CHANID_FDS, 1, SNDCHIP_FDS},
+	{CHANID_VRC7_CH1, 6, SNDCHIP_VRC7},
+	{CHANID_5B_CH1, 3, SNDCHIP_5B},
+	{CHANID_AY8930_CH1, 3, SNDCHIP_AY8930},
+	{CHANID_AY_CH1, 3, SNDCHIP_AY},
+	{CHANID_YM2149F_CH1, 3, SNDCHIP_SSG},
+	{CHANID_5E01_SQUARE1, 5, SNDCHIP_5E01},
+	{CHANID_7E02_SQUARE1, 5, SNDCHIP_7E02},
+	{CHANID_OPLL_CH1, 9, SNDCHIP_OPLL},
+	{CHANID_6581_CH1, 3, SNDCHIP_6581},
+};
+
+const stChipChannels &FindChipChannels(int ChanID) {
+	for (const auto &Range : CHIP_CHANNELS)
+		if (ChanID >= Range.First && ChanID < Range.First + Range.Count)
+			return Range;
+	return CHIP_CHANNELS[0];
+}
+
+} // namespace
 
 const int		CAPU::SEQUENCER_FREQUENCY	= 240;		// // //
 const uint32_t	CAPU::BASE_FREQ_NTSC		= 1789773;		// 72.667
@@ -168,21 +207,23 @@ const uint8_t CAPU::LENGTH_TABLE[] = {
 };
 
 CAPU::CAPU(IAudioCallback *pCallback) :		// // //
-	m_pParent(pCallback),
-	m_iFrameCycles(0),
-	m_pSoundBuffer(NULL),
 	m_pMixer(new CMixer(this)),
+	m_pParent(pCallback),
 	m_p2A03(std::make_unique<C2A03>()),
+	m_p5E01(std::make_unique<C5E01>()), // Taken from E-FamiTracker by Euly
+	m_p7E02(std::make_unique<C7E02>()),
+	m_p6581(std::make_unique<C6581>()), // Taken from E-FamiTracker by Euly
 	m_pFDS(std::make_unique<CFDS>()),
 	m_pN163(std::make_unique<CN163>()),
 	m_pVRC7(std::make_unique<CVRC7>()),
-	m_p5E01(std::make_unique<C5E01>()), // Taken from E-FamiTracker by Euly
-	m_p7E02(std::make_unique<C7E02>()),
 	m_pOPLL(std::make_unique<COPLL>()),
-	m_p6581(std::make_unique<C6581>()), // Taken from E-FamiTracker by Euly
 	m_iExternalSoundChips(0),
+	m_iSampleRate(44100),		// // //
 	m_iCyclesToRun(0),
-	m_iSampleRate(44100)		// // //
+	m_iCycleCount(0),
+	m_iSoundBufferSize(0),
+	m_pSoundBuffer(NULL),
+	m_iFrameCycles(0)
 
 {
 	m_pMMC5 =	new CMMC5(m_pMixer);
@@ -195,6 +236,21 @@ CAPU::CAPU(IAudioCallback *pCallback) :		// // //
 	m_fLevelVRC7 = 1.0f;
 	m_fLevelOPLL = 1.0f;
 
+	m_p2A03->GetRegisterLogger()->SetJournal(&m_RegisterJournal, SNDCHIP_NONE);
+	m_pVRC6->GetRegisterLogger()->SetJournal(&m_RegisterJournal, SNDCHIP_VRC6);
+	m_pVRC7->GetRegisterLogger()->SetJournal(&m_RegisterJournal, SNDCHIP_VRC7);
+	m_pFDS->GetRegisterLogger()->SetJournal(&m_RegisterJournal, SNDCHIP_FDS);
+	m_pMMC5->GetRegisterLogger()->SetJournal(&m_RegisterJournal, SNDCHIP_MMC5);
+	m_pN163->GetRegisterLogger()->SetJournal(&m_RegisterJournal, SNDCHIP_N163);
+	m_pS5B->GetRegisterLogger()->SetJournal(&m_RegisterJournal, SNDCHIP_5B);
+	m_pAY8930->GetRegisterLogger()->SetJournal(&m_RegisterJournal, SNDCHIP_AY8930);
+	m_pAY->GetRegisterLogger()->SetJournal(&m_RegisterJournal, SNDCHIP_AY);
+	m_pYM2149F->GetRegisterLogger()->SetJournal(&m_RegisterJournal, SNDCHIP_SSG);
+	m_p5E01->GetRegisterLogger()->SetJournal(&m_RegisterJournal, SNDCHIP_5E01);
+	m_p7E02->GetRegisterLogger()->SetJournal(&m_RegisterJournal, SNDCHIP_7E02);
+	m_pOPLL->GetRegisterLogger()->SetJournal(&m_RegisterJournal, SNDCHIP_OPLL);
+	m_p6581->GetRegisterLogger()->SetJournal(&m_RegisterJournal, SNDCHIP_6581);
+
 #ifdef LOGGING
 	m_pLog = new CFile("apu_log.txt", CFile::modeCreate | CFile::modeWrite);
 	m_iFrame = 0;
@@ -203,16 +259,16 @@ CAPU::CAPU(IAudioCallback *pCallback) :		// // //
 
 CAPU::~CAPU()
 {
-	SAFE_RELEASE(m_pMMC5);
-	SAFE_RELEASE(m_pVRC6);
-	SAFE_RELEASE(m_pS5B);
-	SAFE_RELEASE(m_pAY8930);
-	SAFE_RELEASE(m_pAY);
-	SAFE_RELEASE(m_pYM2149F);
+	delete m_pMMC5;
+	delete m_pVRC6;
+	delete m_pS5B;
+	delete m_pAY8930;
+	delete m_pAY;
+	delete m_pYM2149F;
 
-	SAFE_RELEASE(m_pMixer);
+	delete m_pMixer;
 
-	SAFE_RELEASE(m_pSoundBuffer);
+	delete[] m_pSoundBuffer;
 
 #ifdef LOGGING
 	m_pLog->Close();
@@ -226,37 +282,87 @@ CAPU::~CAPU()
 //
 void CAPU::Process()
 {	
+	if (!m_Stems.empty() && m_iCyclesToRun > 0)
+		m_StemEvents.push_back({stStemEvent::PROCESS});
+
 	while (m_iCyclesToRun > 0) {
 
 		uint32_t Time = m_iCyclesToRun;
 		Time = std::min(Time, m_iSequencerNext - m_iSequencerClock);		// // //
 		Time = std::min(Time, m_iFrameClock);
+		if (m_iBlockCycleCount)		// // //
+			Time = std::min(Time, m_iBlockClock);
 
-		for (auto Chip : m_SoundChips)		// // //
-			Chip->Process(Time);
-		for (auto Chip : m_SoundChips2)
-			Chip->Process(Time, m_pMixer->GetBuffer());
+		if (m_pWorkerPool) {
+			for (auto Chip : m_InlineChips)
+				Chip->Process(Time, m_pMixer->GetBuffer());
+			m_ChipEvents.push_back({stChipEvent::PROCESS, Time});
+		}
+		else {
+			for (auto Chip : m_SoundChips)		// // //
+				Chip->Process(Time);
+			for (auto Chip : m_SoundChips2)
+				Chip->Process(Time, m_pMixer->GetBuffer());
+		}
 
 		m_iFrameCycles	  += Time;
+		m_iCycleCount	  += Time;
 		m_iSequencerClock += Time;
 		m_iFrameClock	  -= Time;
 		m_iCyclesToRun	  -= Time;
+		if (m_iBlockCycleCount)		// // //
+			m_iBlockClock -= Time;
 
 		if (m_iSequencerClock == m_iSequencerNext)
 			StepSequence();		// // //
 
 		if (m_iFrameClock == 0)
 			EndFrame();
+		else if (m_iBlockCycleCount && m_iBlockClock == 0)		// // //
+			FlushOutput(false);
 	}
 }
 
+// // // Ends the chip buffers at the current cycle and sends what they hold to the callback.
+// Between frames (EndOfFrame is false) the level meters are left alone.
+void CAPU::FlushOutput(bool EndOfFrame)
+{
+	// The APU will always output audio in 32 bit signed format
+	
+	if (m_pWorkerPool) {
+		RunChipTasks(true);
+		for (auto Chip : m_InlineChips)
+			Chip->EndFrame(m_pMixer->GetBuffer(), gsl::span(m_pSoundBuffer, m_iSoundBufferSize << 1));
+		m_pMixer->MixChipBuffers(m_iFrameCycles);
+	}
+	else {
+		for (auto Chip : m_SoundChips)		// // //
+			Chip->EndFrame();
+		for (auto Chip : m_SoundChips2)
+			Chip->EndFrame(m_pMixer->GetBuffer(), gsl::span(m_pSoundBuffer, m_iSoundBufferSize << 1));
+	}
+
+	if (EndOfFrame)
+		m_pMixer->FinishBuffer(m_iFrameCycles);
+	else
+		m_pMixer->FinishBlock(m_iFrameCycles);
+	int ReadSamples	= m_pMixer->ReadBuffer(m_pSoundBuffer);
+	m_pParent->FlushBuffer(m_pSoundBuffer, ReadSamples);
+
+	m_iFrameCycles = 0;
+	m_iBlockClock = m_iBlockCycleCount;
+}
+
 void CAPU::StepSequence()		// // //
 {
 	if (++m_iSequencerCount == SEQUENCER_FREQUENCY)
 		m_iSequencerClock = m_iSequencerCount = 0;
 	m_iSequencerNext = (uint64_t)BASE_FREQ_NTSC * (m_iSequencerCount + 1) / SEQUENCER_FREQUENCY;
 	m_p2A03->ClockSequence();
-	m_pMMC5->ClockSequence();		// // //
+	if (m_pWorkerPool && (m_iExternalSoundChips & SNDCHIP_MMC5))
+		m_ChipEvents.push_back({stChipEvent::CLOCK_SEQUENCE});
+	else
+		m_pMMC5->ClockSequence();		// // //
 	m_p5E01->ClockSequence(); // Taken from E-FamiTracker by Euly
 	m_p7E02->ClockSequence();
 
@@ -265,42 +371,145 @@ void CAPU::StepSequence()		// // //
 // End of audio frame, flush the buffer if enough samples has been produced, and start a new frame
 void CAPU::EndFrame()
 {
-	// The APU will always output audio in 32 bit signed format
-	
-	for (auto Chip : m_SoundChips)		// // //
-		Chip->EndFrame();
-	for (auto Chip : m_SoundChips2)
-		Chip->EndFrame(m_pMixer->GetBuffer(), gsl::span(m_pSoundBuffer, m_iSoundBufferSize << 1));
+	FlushOutput(true);		// // //
 
-	m_pMixer->FinishBuffer(m_iFrameCycles);
-	int ReadSamples	= m_pMixer->ReadBuffer(m_pSoundBuffer);
-	m_pParent->FlushBuffer(m_pSoundBuffer, ReadSamples);
-	
 	m_iFrameClock /*+*/= m_iFrameCycleCount;
-	m_iFrameCycles = 0;
 
 	for (auto& r : m_SoundChips)		// // //
 		r->GetRegisterLogger()->Step();
 	for (auto& r : m_SoundChips2)
 		r->GetRegisterLogger()->Step();
 
+	RunStems();
+
 #ifdef LOGGING
 	++m_iFrame;
 #endif
 }
 
+void CAPU::UpdateChipTasks()
+{
+	m_ChipTasks.clear();
+	m_InlineChips.clear();
+	m_ChipEvents.clear();
+
+	// The 2A03, 5E01 and 7E02 stay on the audio thread, since their DPCM
+	// sample memory is replaced and their DPCM state is read mid-frame.
+	if (m_iEmulationThreads > 1) {
+		const std::pair<int, CSoundChip *> CHIPS[] = {
+			{SNDCHIP_VRC6, m_pVRC6}, {SNDCHIP_MMC5, m_pMMC5}, {SNDCHIP_5B, m_pS5B},
+			{SNDCHIP_AY8930, m_pAY8930}, {SNDCHIP_AY, m_pAY}, {SNDCHIP_SSG, m_pYM2149F},
+		};
+		const std::pair<int, CSoundChip2 *> CHIPS2[] = {
+			{SNDCHIP_VRC7, m_pVRC7.get()}, {SNDCHIP_FDS, m_pFDS.get()}, {SNDCHIP_N163, m_pN163.get()},
+			{SNDCHIP_OPLL, m_pOPLL.get()}, {SNDCHIP_6581, m_p6581.get()},
+		};
+
+		int Offloaded = 0;
+		for (const auto &[Chip, pChip] : CHIPS)
+			if (m_iExternalSoundChips & Chip) {
+				m_ChipTasks.push_back({pChip, nullptr, nullptr});
+				Offloaded |= Chip;
+			}
+		for (const auto &[Chip, pChip] : CHIPS2)
+			Offloaded |= m_iExternalSoundChips & Chip;
+
+		m_pMixer->SetChipBuffers(Offloaded);
+		for (const auto &[Chip, pChip] : CHIPS2)
+			if (Offloaded & Chip)
+				m_ChipTasks.push_back({nullptr, pChip, &m_pMixer->GetBuffer(Chip)});
+	}
+
+	// A single offloaded chip would not run alongside anything
+	if (m_ChipTasks.size() < 2) {
+		m_ChipTasks.clear();
+		m_pWorkerPool.reset();
+		m_pMixer->SetChipBuffers(0);
+		return;
+	}
+
+	for (auto Chip : m_SoundChips2)
+		if (std::none_of(m_ChipTasks.begin(), m_ChipTasks.end(), [Chip] (const stChipTask &Task) { return Task.pChip2 == Chip; }))
+			m_InlineChips.push_back(Chip);
+	for (auto &Task : m_ChipTasks)
+		if (Task.pChip2)
+			Task.TempBuffer.resize(m_iSoundBufferSize << 1);
+
+	const unsigned Threads = std::min<unsigned>(m_iEmulationThreads, static_cast<unsigned>(m_ChipTasks.size()));
+	if (!m_pWorkerPool || m_pWorkerPool->GetThreadCount() != Threads)
+		m_pWorkerPool = std::make_unique<CWorkerPool>(Threads - 1);
+
+	// Keep the audio thread from allocating in the middle of a frame
+	m_ChipEvents.reserve(1024);
+}
+
+void CAPU::RunChipTasks(bool EndOfFrame)
+{
+	m_pWorkerPool->Run(static_cast<unsigned>(m_ChipTasks.size()), [this, EndOfFrame] (unsigned Index) {
+		stChipTask &Task = m_ChipTasks[Index];
+		for (const stChipEvent &Event : m_ChipEvents) {
+			switch (Event.Type) {
+			case stChipEvent::PROCESS:
+				if (Task.pChip)
+					Task.pChip->Process(Event.Time);
+				else
+					Task.pChip2->Process(Event.Time, *Task.pBuffer);
+				break;
+			case stChipEvent::WRITE:
+				if (Task.pChip)
+					Task.pChip->Write(Event.Address, Event.Value);
+				else
+					Task.pChip2->Write(Event.Address, Event.Value);
+				break;
+			case stChipEvent::CLOCK_SEQUENCE:
+				if (Task.pChip == m_pMMC5)
+					m_pMMC5->ClockSequence();
+				break;
+			}
+		}
+
+		if (EndOfFrame) {
+			if (Task.pChip)
+				Task.pChip->EndFrame();
+			else
+				Task.pChip2->EndFrame(*Task.pBuffer, Task.TempBuffer);
+		}
+	});
+
+	m_ChipEvents.clear();
+}
+
+void CAPU::SetEmulationThreads(unsigned Threads)
+{
+	// No events are pending between frames and every lane has been mixed,
+	// so the chips can change hands without a reset
+	m_iEmulationThreads = Threads;
+	UpdateChipTasks();
+}
+
+unsigned CAPU::GetEmulationThreads() const		// // //
+{
+	return m_iEmulationThreads;
+}
+
 void CAPU::Reset()
 {
 	// Reset APU
 	//
 	
+	m_ChipEvents.clear();
+	m_StemEvents.clear();
+	for (auto &Stem : m_Stems)
+		Stem->Reset();
 	m_iSequencerCount	= 0;		// // //
 	m_iSequencerClock	= 0;		// // //
 	m_iSequencerNext	= BASE_FREQ_NTSC / SEQUENCER_FREQUENCY;
 	
 	m_iCyclesToRun		= 0;
+	m_iCycleCount		= 0;
 	m_iFrameCycles		= 0;
 	m_iFrameClock		= m_iFrameCycleCount;
+	m_iBlockClock		= m_iBlockCycleCount;		// // //
 	
 	m_pMixer->ClearBuffer();
 	
@@ -318,6 +527,61 @@ void CAPU::Reset()
 #endif
 }
 
+void CAPU::SaveState(std::vector<uint8_t> &State)		// // //
+{
+	CStateArchive Archive = CStateArchive::Saving(State);
+	SerializeState(Archive);
+}
+
+bool CAPU::LoadState(const std::vector<uint8_t> &State)		// // //
+{
+	CStateArchive Archive = CStateArchive::Loading(State);
+	SerializeState(Archive);
+	if (Archive.IsValid())
+		return true;
+	Reset();
+	return false;
+}
+
+void CAPU::SerializeState(CStateArchive &State)
+{
+	// Checked on load, so that a state from a differently set up CAPU is rejected
+	// before anything sized by the setup is read
+	const uint32_t Setup[] = {
+		m_iSampleRate, m_iFrameCycleCount, m_iBlockCycleCount, static_cast<uint32_t>(m_iExternalSoundChips),
+		static_cast<uint32_t>(m_ChipTasks.size()), static_cast<uint32_t>(m_Stems.size()),
+	};
+	uint32_t Saved[std::size(Setup)];
+	std::copy(std::begin(Setup), std::end(Setup), Saved);
+	State(Saved);
+	if (!std::equal(std::begin(Setup), std::end(Setup), Saved)) {
+		State.Reject();
+		return;
+	}
+
+	State(m_iSequencerCount, m_iSequencerClock, m_iSequencerNext);
+	State(m_iCyclesToRun, m_iCycleCount, m_iFrameCycles, m_iFrameClock, m_iBlockClock);
+
+	m_pMixer->SerializeState(State, m_iFrameCycles);
+
+	// Inactive chips too, since the frame sequencer clocks some of them regardless
+	CSoundChip *const CHIPS[] = {m_pVRC6, m_pMMC5, m_pS5B, m_pAY8930, m_pAY, m_pYM2149F};
+	CSoundChip2 *const CHIPS2[] = {
+		m_p2A03.get(), m_pVRC7.get(), m_pFDS.get(), m_pN163.get(),
+		m_p5E01.get(), m_p7E02.get(), m_pOPLL.get(), m_p6581.get(),
+	};
+	for (auto Chip : CHIPS)
+		Chip->SerializeState(State);
+	for (auto Chip : CHIPS2)
+		Chip->SerializeState(State);
+
+	// Not yet replayed on the offloaded chips and the stems
+	State.Vector(m_ChipEvents);
+	State.Vector(m_StemEvents);
+	for (auto &Stem : m_Stems)
+		Stem->SerializeState(State);
+}
+
 void CAPU::SetExternalSound(int Chip)
 {
 	// Initialize list of active sound chips.
@@ -325,35 +589,44 @@ void CAPU::SetExternalSound(int Chip)
 	m_SoundChips.clear();
 	m_SoundChips2.clear();
 
-	m_SoundChips2.push_back(m_p2A03.get());		// // //
-	if (Chip & SNDCHIP_VRC6)
+	// A stem only emulates the chip its channel belongs to.
+	// The mixer still sees every chip in Chip, so that the stem's levels match the full mix.
+	const int Emulated = m_iSoloChannel == -1 ? Chip : GetChannelChip(m_iSoloChannel);
+
+	if (m_iSoloChannel == -1 || Emulated == SNDCHIP_NONE)
+		m_SoundChips2.push_back(m_p2A03.get());		// // //
+	if (Emulated & SNDCHIP_VRC6)
 		m_SoundChips.push_back(m_pVRC6);
-	if (Chip & SNDCHIP_VRC7)
+	if (Emulated & SNDCHIP_VRC7)
 		m_SoundChips2.push_back(m_pVRC7.get());
-	if (Chip & SNDCHIP_FDS)
+	if (Emulated & SNDCHIP_FDS)
 		m_SoundChips2.push_back(m_pFDS.get());
-	if (Chip & SNDCHIP_MMC5)
+	if (Emulated & SNDCHIP_MMC5)
 		m_SoundChips.push_back(m_pMMC5);
-	if (Chip & SNDCHIP_N163)
+	if (Emulated & SNDCHIP_N163)
 		m_SoundChips2.push_back(m_pN163.get());
-	if (Chip & SNDCHIP_5B)
+	if (Emulated & SNDCHIP_5B)
 		m_SoundChips.push_back(m_pS5B);
-	if (Chip & SNDCHIP_AY8930)
+	if (Emulated & SNDCHIP_AY8930)
 		m_SoundChips.push_back(m_pAY8930);
-	if (Chip & SNDCHIP_AY)
+	if (Emulated & SNDCHIP_AY)
 		m_SoundChips.push_back(m_pAY);
-	if (Chip & SNDCHIP_SSG)
+	if (Emulated & SNDCHIP_SSG)
 		m_SoundChips.push_back(m_pYM2149F);
-	if (Chip & SNDCHIP_5E01) // Taken from E-FamiTracker by Euly
+	if (Emulated & SNDCHIP_5E01) // Taken from E-FamiTracker by Euly
 		m_SoundChips2.push_back(m_p5E01.get());
-	if (Chip & SNDCHIP_7E02)
+	if (Emulated & SNDCHIP_7E02)
 		m_SoundChips2.push_back(m_p7E02.get());
-	if (Chip & SNDCHIP_OPLL)
+	if (Emulated & SNDCHIP_OPLL)
 		m_SoundChips2.push_back(m_pOPLL.get());
-	if (Chip & SNDCHIP_6581) // Taken from E-FamiTracker by Euly
+	if (Emulated & SNDCHIP_6581) // Taken from E-FamiTracker by Euly
 		m_SoundChips2.push_back(m_p6581.get());
 
-	// Set (unused) bitfield of external sound chips enabled.
+	// CSoundChip channels are silenced by the mixer instead
+	if (m_iSoloChannel != -1 && !m_SoundChips2.empty())
+		m_SoundChips2.front()->SetChannelMask(~(1u << (m_iSoloChannel - FindChipChannels(m_iSoloChannel).First)));
+
+	// Set bitfield of external sound chips enabled.
 	m_iExternalSoundChips = Chip;
 
 	// Reinitialize mixer with list of external sound chips (as well as m_SoundChips2).
@@ -372,11 +645,18 @@ void CAPU::SetExternalSound(int Chip)
 	// Feel free to complain.
 	m_pMixer->SetClockRate(m_pMixer->BlipBuffer.clock_rate());
 
+	UpdateChipTasks();
 	Reset();
 }
 
 void CAPU::ChangeMachineRate(int Machine, int FrameRate)		// // //
 {	
+	RunStems();
+	for (auto &Stem : m_Stems)
+		Stem->ChangeMachineRate(Machine, FrameRate);
+	m_iMachine = Machine;
+	m_iFrameRate = FrameRate;
+
 	uint32_t BaseFreq = (Machine == MACHINE_NTSC) ? BASE_FREQ_NTSC : BASE_FREQ_PAL;
 	m_p2A03->ChangeMachine(Machine);
 	m_p5E01->ChangeMachine(Machine); // Taken from E-FamiTracker by Euly
@@ -386,6 +666,27 @@ void CAPU::ChangeMachineRate(int Machine, int FrameRate)		// // //
 	m_pOPLL->SetSampleSpeed(m_iSampleRate, BaseFreq, FrameRate);
 	m_p6581->SetSampleSpeed(m_iSampleRate);
 	m_iFrameCycleCount = BaseFreq / FrameRate;
+	UpdateBlockCycles();		// // //
+}
+
+void CAPU::SetBlockSamples(uint32_t Samples)		// // //
+{
+	m_iBlockSamples = Samples;
+	UpdateBlockCycles();
+}
+
+uint32_t CAPU::GetBlockSamples() const		// // //
+{
+	return m_iBlockSamples;
+}
+
+void CAPU::UpdateBlockCycles()		// // //
+{
+	// Rounded down, so that no block holds more samples than asked for
+	const uint64_t BaseFreq = (m_iMachine == MACHINE_NTSC) ? BASE_FREQ_NTSC : BASE_FREQ_PAL;
+	const uint64_t Cycles = uint64_t(m_iBlockSamples) * BaseFreq / m_iSampleRate;
+	m_iBlockCycleCount = m_iBlockSamples && Cycles < m_iFrameCycleCount ? std::max<uint32_t>(uint32_t(Cycles), 1) : 0;
+	m_iBlockClock = m_iBlockCycleCount;
 }
 
 bool CAPU::SetupSound(int SampleRate, int NrChannels, int Machine)		// // //
@@ -410,13 +711,18 @@ bool CAPU::SetupSound(int SampleRate, int NrChannels, int Machine)		// // //
 
 	// m_pMixer->SetClockRate() is unnecessary, because ChangeMachineRate() assigns it anyway.
 
-	SAFE_RELEASE_ARRAY(m_pSoundBuffer);
+	delete[] m_pSoundBuffer;
 
 	m_pSoundBuffer = new int16_t[m_iSoundBufferSize << 1];
 	// `m_pSoundBuffer == NULL` can never happen.
 	// `new` throws std::bad_alloc on failure, and never returns null.
 
 	ChangeMachineRate(Machine, FrameRate);		// // //
+	UpdateChipTasks();
+
+	for (auto &Stem : m_Stems)
+		if (!Stem->SetupSound(SampleRate, NrChannels, Machine))
+			return false;
 
 	return true;
 }
@@ -426,6 +732,8 @@ void CAPU::AddCycles(int32_t Cycles)
 	if (Cycles < 0)
 		return;
 	m_iCyclesToRun += Cycles;
+	if (!m_Stems.empty())
+		m_StemEvents.push_back({stStemEvent::ADD_CYCLES, static_cast<uint32_t>(Cycles)});
 }
 
 void CAPU::Write(uint16_t Address, uint8_t Value)
@@ -434,10 +742,19 @@ void CAPU::Write(uint16_t Address, uint8_t Value)
 
 	Process();
 	
-	for (auto Chip : m_SoundChips)		// // //
-		Chip->Write(Address, Value);
-	for (auto Chip : m_SoundChips2)
-		Chip->Write(Address, Value);
+	if (m_pWorkerPool) {
+		for (auto Chip : m_InlineChips)
+			Chip->Write(Address, Value);
+		m_ChipEvents.push_back({stChipEvent::WRITE, 0, Address, Value});
+	}
+	else {
+		for (auto Chip : m_SoundChips)		// // //
+			Chip->Write(Address, Value);
+		for (auto Chip : m_SoundChips2)
+			Chip->Write(Address, Value);
+	}
+	if (!m_Stems.empty())
+		m_StemEvents.push_back({stStemEvent::WRITE, 0, Address, Value});
 
 	LogWrite(Address, Value);
 }
@@ -451,6 +768,10 @@ uint8_t CAPU::Read(uint16_t Address)
 	bool Mapped(false);
 
 	Process();
+
+	// Bring offloaded chips up to date before reading from them
+	if (m_pWorkerPool)
+		RunChipTasks(false);
 	
 	for (auto Chip : m_SoundChips)		// // //
 		if (!Mapped)
@@ -490,12 +811,12 @@ bool CAPU::DPCMPlaying() const
 
 void CAPU::WriteSample(const char *pBuf, int Size)		// // //
 {
-	m_p2A03->GetSampleMemory()->SetMem(pBuf, Size);
+	SetSample(SNDCHIP_NONE, pBuf, Size);
 }
 
 void CAPU::ClearSample()		// // //
 {
-	m_p2A03->GetSampleMemory()->Clear();
+	SetSample(SNDCHIP_NONE, nullptr, 0);
 }
 
 // 5E01
@@ -517,12 +838,12 @@ bool CAPU::DPCM5E01Playing() const
 
 void CAPU::Write5E01Sample(const char* pBuf, int Size)		// // //
 {
-	m_p5E01->GetSampleMemory()->SetMem(pBuf, Size);
+	SetSample(SNDCHIP_5E01, pBuf, Size);
 }
 
 void CAPU::Clear5E01Sample()		// // //
 {
-	m_p5E01->GetSampleMemory()->Clear();
+	SetSample(SNDCHIP_5E01, nullptr, 0);
 }
 
 // 7E02
@@ -543,12 +864,108 @@ bool CAPU::DPCM7E02Playing() const
 
 void CAPU::Write7E02Sample(const char* pBuf, int Size)		// // //
 {
-	m_p7E02->GetSampleMemory()->SetMem(pBuf, Size);
+	SetSample(SNDCHIP_7E02, pBuf, Size);
 }
 
 void CAPU::Clear7E02Sample()		// // //
 {
-	m_p7E02->GetSampleMemory()->Clear();
+	SetSample(SNDCHIP_7E02, nullptr, 0);
+}
+
+void CAPU::SetSample(int Chip, const char *pBuf, int Size)
+{
+	const auto Apply = [pBuf, Size] (auto *pMem) {
+		if (pBuf)
+			pMem->SetMem(pBuf, Size);
+		else
+			pMem->Clear();
+	};
+	switch (Chip) {
+	case SNDCHIP_5E01:
+		Apply(m_p5E01->GetSampleMemory());
+		break;
+	case SNDCHIP_7E02:
+		Apply(m_p7E02->GetSampleMemory());
+		break;
+	default:
+		Apply(m_p2A03->GetSampleMemory());
+		break;
+	}
+
+	if (!m_Stems.empty())
+		m_StemEvents.push_back({stStemEvent::SET_SAMPLE, 0, 0, 0, Chip, pBuf, Size});
+	if (IRegisterSink *pSink = m_RegisterJournal.GetSink())
+		pSink->OnSample(m_iCycleCount, Chip, pBuf, Size);
+}
+
+// Stems
+
+int CAPU::GetChannelChip(int ChanID)
+{
+	return FindChipChannels(ChanID).Chip;
+}
+
+void CAPU::SetStems(const std::vector<std::pair<int, IAudioCallback *>> &Stems, unsigned Threads)
+{
+	m_Stems.clear();
+	m_StemEvents.clear();
+	m_pStemPool.reset();
+
+	for (const auto &[ChanID, pCallback] : Stems) {
+		auto pStem = std::make_unique<CAPU>(pCallback);
+		pStem->m_iSoloChannel = ChanID;
+		pStem->m_pMixer->SetSoloChannel(ChanID);
+		ConfigureStem(*pStem);
+		m_Stems.push_back(std::move(pStem));
+	}
+
+	if (m_Stems.empty())
+		return;
+
+	Threads = std::clamp<unsigned>(Threads, 1, static_cast<unsigned>(m_Stems.size()));
+	m_pStemPool = std::make_unique<CWorkerPool>(Threads - 1);
+	m_StemEvents.reserve(4096);
+}
+
+void CAPU::ConfigureStem(CAPU &Stem) const
+{
+	// Same order as ~CAPUConfig()
+	Stem.SetupSound(m_iSampleRate, m_bStereoEnabled ? 2 : 1, m_iMachine);
+	Stem.ChangeMachineRate(m_iMachine, m_iFrameRate);
+	Stem.SetExternalSound(m_iExternalSoundChips);
+	for (int Chip = 0; Chip < CHIP_LEVEL_COUNT; ++Chip)
+		Stem.m_pMixer->SetChipLevel((chip_level_t)Chip, m_pMixer->GetChipLevel((chip_level_t)Chip));
+	Stem.m_pMixer->SetMixing(m_pMixer->m_MixerConfig);
+	Stem.m_pMixer->SetEmulation(m_pMixer->m_EmulatorConfig);
+	Stem.m_pMixer->RecomputeEmuMixState();
+}
+
+void CAPU::RunStems()
+{
+	if (m_StemEvents.empty())
+		return;
+
+	m_pStemPool->Run(static_cast<unsigned>(m_Stems.size()), [this] (unsigned Index) {
+		CAPU &Stem = *m_Stems[Index];
+		for (const stStemEvent &Event : m_StemEvents) {
+			switch (Event.Type) {
+			case stStemEvent::ADD_CYCLES:
+				Stem.AddCycles(Event.Cycles);
+				break;
+			case stStemEvent::PROCESS:
+				Stem.Process();
+				break;
+			case stStemEvent::WRITE:
+				Stem.Write(Event.Address, Event.Value);
+				break;
+			case stStemEvent::SET_SAMPLE:
+				Stem.SetSample(Event.Chip, Event.pSample, Event.SampleSize);
+				break;
+			}
+		}
+	});
+
+	m_StemEvents.clear();
 }
 
 #ifdef LOGGING
@@ -606,6 +1023,7 @@ int CAPU::GetMeterDecayRate() const		// // // 050B
 
 void CAPU::LogWrite(uint16_t Address, uint8_t Value)
 {
+	m_RegisterJournal.SetCycle(m_iCycleCount);
 	for (auto &r : m_SoundChips)		// // //
 		r->Log(Address, Value);
 	for (auto& r : m_SoundChips2)
@@ -641,7 +1059,7 @@ double CAPU::GetFreq(int Chip, int Chan) const
 		case SNDCHIP_OPLL:		return PtrGetFreq(*m_pOPLL);
 		case SNDCHIP_6581:		return PtrGetFreq(*m_p6581); // Taken from E-FamiTracker by Euly
 
-		default: AfxDebugBreak(); return 0.;
+		default: assert(false); return 0.;
 	}
 }
 
@@ -672,23 +1090,40 @@ CRegisterState *CAPU::GetRegState(int Chip, int Reg) const		// // //
 		case SNDCHIP_OPLL:	return PtrGetRegState(*m_pOPLL);
 		case SNDCHIP_6581:	return PtrGetRegState(*m_p6581);	 // Taken from E-FamiTracker by Euly
 
-		default: AfxDebugBreak(); return nullptr;
+		default: assert(false); return nullptr;
 	}
 }
 
+const CRegisterJournal &CAPU::GetRegisterJournal() const
+{
+	return m_RegisterJournal;
+}
+
+void CAPU::SetRegisterSink(IRegisterSink *pSink)
+{
+	m_RegisterJournal.SetSink(pSink);
+}
+
+uint64_t CAPU::GetCycleCount() const
+{
+	return m_iCycleCount;
+}
+
 void CAPUConfig::SetupEmulation(
 	bool N163DisableMultiplexing,
 	int UseOPLLPatchSet,
 	bool UseOPLLExt,
 	std::vector<uint8_t> UseOPLLPatchBytes,
-	std::vector<std::string> UseVRC7PatchNames)
+	std::vector<std::string> UseVRC7PatchNames,
+	bool UseOPLLNativeRate)
 {
 	m_EmulatorConfig = EmulatorConfig{
 		N163DisableMultiplexing,
 		UseOPLLPatchSet,
 		UseOPLLExt,
 		UseOPLLPatchBytes,
-		UseVRC7PatchNames
+		UseVRC7PatchNames,
+		UseOPLLNativeRate
 	};
 }
 
@@ -817,4 +1252,15 @@ CAPUConfig::~CAPUConfig() noexcept(false)
 
 	if (RecomputeEmuMixState)
 		m_Mixer->RecomputeEmuMixState();
+
+	// Stems follow every change, after catching up with the old configuration
+	if (!m_APU->m_Stems.empty())
+		m_APU->RunStems();
+	for (auto &pStem : m_APU->m_Stems) {
+		CAPUConfig StemConfig(pStem.get());
+		StemConfig.m_ExternalSound = m_ExternalSound;
+		std::copy(std::begin(m_ChipLevels), std::end(m_ChipLevels), std::begin(StemConfig.m_ChipLevels));
+		StemConfig.m_MixerConfig = m_MixerConfig;
+		StemConfig.m_EmulatorConfig = m_EmulatorConfig;
+	}
 }
@@ -34,6 +34,7 @@
 #include <exception>
 #include "VRC7.h"
 #include "OPLL.h"
+#include "../RegisterJournal.h"
 
 // External classes
 class C2A03;		// // //
@@ -54,11 +55,16 @@ class C6581;	// Taken from E-FamiTracker by Euly
 class CSoundChip;		// // //
 class CSoundChip2;
 class CRegisterState;		// // //
+class CWorkerPool;
+class CStateArchive;		// // //
 
 #ifdef LOGGING
 class CFile;
 #endif
 
+/// Lowest engine tick rate, in Hz. Sizes the per-frame sound buffer.
+extern const int RATE_MIN;
+
 class CAPU {
 public:
 	CAPU(IAudioCallback *pCallback);		// // //
@@ -80,6 +86,24 @@ public:
 	int	GetFDSModCounter() const;		// TODO: reading $4097 returns $00 for some reason, fix that and remove this hack instead
 	CRegisterState *GetRegState(int Chip, int Reg) const;		// // //
 
+	/// Cycle-stamped log of every register write, readable from any thread
+	/// through a CRegisterJournalReader.
+	const CRegisterJournal &GetRegisterJournal() const;
+	/// Attaches a sink receiving every register write and DPCM sample change on the
+	/// emulation thread, or detaches it if null. Stems never report to the sink.
+	void	SetRegisterSink(IRegisterSink *pSink);
+	/// CPU cycles emulated since the last Reset(), the time stamp of register writes.
+	uint64_t GetCycleCount() const;
+
+	/// Saves the emulation state of every chip, the mixer and the stems into State, so that LoadState() can resume from this exact point.
+	/// Must be called between calls to Process(), see CStateArchive for what is saved.
+	void	SaveState(std::vector<uint8_t> &State);
+	/// Restores a state saved by SaveState() of a CAPU set up the same way (sample rate,
+	/// machine, expansion chips, emulation options, threads and stems). Output after
+	/// this is identical to the output after the save. The register journal is not
+	/// rewound. Returns false and resets if State does not match this CAPU.
+	bool	LoadState(const std::vector<uint8_t> &State);
+
 	// 2A03
 	uint8_t	GetSamplePos() const;
 	uint8_t	GetDeltaCounter() const;
@@ -114,6 +138,38 @@ public:
 		return m_iSoundBufferSamples;
 	}
 
+	/// Flush the output every Samples samples within a frame instead of only at its end,
+	/// so that the audio callback receives blocks the size of the device period. Writes
+	/// keep their cycle positions and the output is the same, only split into smaller
+	/// pieces, except for emu2413 at the output rate, which then renders each block with
+	/// the registers written up to its end. Level meters, register logs and stems are
+	/// still updated once per frame. 0 flushes once per frame. Must be called between
+	/// frames, and stays in effect across SetupSound() and ChangeMachineRate().
+	void	SetBlockSamples(uint32_t Samples);		// // //
+	uint32_t GetBlockSamples() const;		// // //
+
+	/// Emulate the expansion chips on up to Threads threads (counting the audio thread)
+	/// instead of one after another. 0 or 1 turns parallel emulation off.
+	///
+	/// Offloaded chips are not run as they are written to. CAPU records the frame's
+	/// timeline (Process/Write/sequencer steps), and EndFrame() replays it on every
+	/// chip at once, each into its own Blip_Buffer, then mixes those into the shared one.
+	/// The output is identical to serial emulation. Must be called between frames.
+	void	SetEmulationThreads(unsigned Threads);
+	unsigned GetEmulationThreads() const;		// // //
+
+	/// Render the given channels into stems alongside the normal output, each stem
+	/// going to its own callback. Stems are emulated by copies of this CAPU that only
+	/// run the chip owning the channel with every other channel silenced. They replay
+	/// what happened to this CAPU every frame, on up to Threads threads, so the
+	/// engine only runs once. An empty list removes the stems. Must be called between
+	/// frames, while nothing has been written since the last Reset(), as the stems
+	/// start out reset. Reset() resets the stems along with this CAPU.
+	void	SetStems(const std::vector<std::pair<int, IAudioCallback *>> &Stems, unsigned Threads);
+
+	/// The SNDCHIP_ bit of the chip channel ChanID belongs to.
+	static int GetChannelChip(int ChanID);
+
 private:
 	void	SetExternalSound(int Chip);
 	// End configuration methods.
@@ -148,9 +204,20 @@ private:
 
 	void StepSequence();		// // //
 	void EndFrame();
+	void FlushOutput(bool EndOfFrame);		// // //
+	void UpdateBlockCycles();		// // //
+
+	void UpdateChipTasks();
+	void RunChipTasks(bool EndOfFrame);
 
 	void LogWrite(uint16_t Address, uint8_t Value);
 
+	void SerializeState(CStateArchive &State);		// // //
+
+	void ConfigureStem(CAPU &Stem) const;
+	void RunStems();
+	void SetSample(int Chip, const char *pBuf, int Size);
+
 private:
 	CMixer		*m_pMixer;
 	IAudioCallback *m_pParent;
@@ -173,16 +240,59 @@ private:
 	CYM2149F	*m_pYM2149F;
 
 	/// Bitfield of external sound chips enabled.
-	/// Never read, except for code hidden behind #ifdef LOGGING.
 	int			m_iExternalSoundChips;
 
 	std::vector<CSoundChip*> m_SoundChips;
 	std::vector<CSoundChip2*> m_SoundChips2;
 
+	// Parallel emulation, see SetEmulationThreads()
+	/// Something that happened to the offloaded chips during the current frame.
+	struct stChipEvent {
+		enum { PROCESS, WRITE, CLOCK_SEQUENCE } Type;
+		uint32_t Time;
+		uint16_t Address;
+		uint8_t Value;
+	};
+	/// An offloaded chip. Exactly one of pChip and pChip2 is set.
+	struct stChipTask {
+		CSoundChip *pChip;
+		CSoundChip2 *pChip2;
+		Blip_Buffer *pBuffer;				// Own buffer of pChip2
+		std::vector<int16_t> TempBuffer;	// Own scratch buffer for CSoundChip2::EndFrame()
+	};
+
+	unsigned	m_iEmulationThreads = 0;
+	std::unique_ptr<CWorkerPool> m_pWorkerPool;	// Non-null when parallel emulation is active
+	std::vector<stChipTask> m_ChipTasks;
+	std::vector<CSoundChip2*> m_InlineChips;	// Chips still emulated as they are written to
+	std::vector<stChipEvent> m_ChipEvents;
+
+	// Stem rendering, see SetStems()
+	/// Something done to this CAPU during the current frame, replayed on every stem.
+	struct stStemEvent {
+		enum { ADD_CYCLES, PROCESS, WRITE, SET_SAMPLE } Type;
+		uint32_t Cycles;
+		uint16_t Address;
+		uint8_t Value;
+		int Chip;					// DPCM sample owner, SNDCHIP_NONE, SNDCHIP_5E01 or SNDCHIP_7E02
+		const char *pSample;		// Null clears the sample memory
+		int SampleSize;
+	};
+
+	int			m_iSoloChannel = -1;		// Channel rendered by this CAPU if it is a stem
+	std::vector<std::unique_ptr<CAPU>> m_Stems;
+	std::unique_ptr<CWorkerPool> m_pStemPool;
+	std::vector<stStemEvent> m_StemEvents;
+
+	CRegisterJournal m_RegisterJournal;
+
 	uint32_t	m_iSampleRate;						// // //
+	int			m_iMachine = MACHINE_NTSC;
+	int			m_iFrameRate = FRAME_RATE_NTSC;
 	uint32_t	m_iFrameCycleCount;
 	uint32_t	m_iFrameClock;
 	uint32_t	m_iCyclesToRun;						// Number of cycles to process
+	uint64_t	m_iCycleCount;						// Cycles emulated since last reset
 
 	uint32_t	m_iSoundBufferSamples;				// Size of buffer, in samples
 	bool		m_bStereoEnabled;					// If stereo is enabled
@@ -192,7 +302,10 @@ private:
 	uint32_t	m_iBufferPointer;					// Fill pos in buffer
 	int16_t		*m_pSoundBuffer;					// Sound transfer buffer
 
-	uint32_t	m_iFrameCycles;						// Cycles emulated from start of frame
+	uint32_t	m_iFrameCycles;						// Cycles emulated since the last flush
+	uint32_t	m_iBlockSamples = 0;				// // // See SetBlockSamples()
+	uint32_t	m_iBlockCycleCount = 0;				// // // Cycles per block, 0 if frames are not split
+	uint32_t	m_iBlockClock = 0;					// // // Cycles left until the next block flush
 	uint32_t	m_iSequencerClock;					// Clock for frame sequencer
 	uint32_t	m_iSequencerNext;					// // // Next value for sequencer
 	uint8_t		m_iSequencerCount;					// // // Step count for sequencer
@@ -233,7 +346,8 @@ public:
 		int UseOPLLPatchSet,
 		bool UseOPLLExt,
 		std::vector<uint8_t> UseOPLLPatchBytes,
-		std::vector<std::string> UseVRC7PatchNames
+		std::vector<std::string> UseVRC7PatchNames,
+		bool UseOPLLNativeRate
 	);
 
 	void SetupMixer(
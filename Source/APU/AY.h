@@ -21,71 +21,28 @@
 
 #pragma once
 
-#include "SoundChip.h"
-#include "Channel.h"
-
-// // // 050B
-
-class CAYChannel : public CChannel
-{
-public:
-	friend class CAY;
-
-	CAYChannel(CMixer *pMixer, uint8_t ID);
-	
-	void Process(uint32_t Time);
-	void Reset();
-
-	uint32_t GetTime();
-	void Output(uint32_t Noise, uint32_t Envelope);
-
-	double GetFrequency() const override;
-
-private:
-	uint8_t m_iVolume;
-	uint32_t m_iPeriod;
-	uint32_t m_iPeriodClock;
-
-	bool m_bSquareHigh;
-	bool m_bSquareDisable;
-	bool m_bNoiseDisable;
+#include "PSG.h"
+
+// AY-3-8910, volume decreasing by 3 dB every other step
+
+struct CAYTraits : CPSGTraits {
+	static constexpr int CHIP = SNDCHIP_AY;
+	static constexpr uint8_t CHANNEL = CHANID_AY_CH1;
+	static constexpr uint16_t PORT = 0xC002;
+	static constexpr int32_t VOLUME[32] = {
+		  1,   1,   2,   2,
+		  3,   3,   4,   4,
+		  6,   6,   8,   8,
+		 11,  11,  16,  16,
+		 23,  23,  32,  32,
+		 45,  45,  64,  64,
+		 90,  90, 128, 128,
+		181, 181, 255, 255,
+	};
 };
 
-class CAY : public CSoundChip
+class CAY final : public CPSG<CAYTraits>
 {
 public:
-	CAY(CMixer *pMixer);
-	virtual ~CAY();
-	
-	void	Reset();
-	void	Process(uint32_t Time);
-	void	EndFrame();
-
-	void	Write(uint16_t Address, uint8_t Value);
-	uint8_t	Read(uint16_t Address, bool &Mapped);
-	void	Log(uint16_t Address, uint8_t Value);		// // //
-
-	double	GetFreq(int Channel) const override;		// // //
-
-private:
-	void	WriteReg(uint8_t Port, uint8_t Value);
-	void	RunEnvelope(uint32_t Time);
-	void	RunNoise(uint32_t Time);
-
-private:
-	CAYChannel *m_pChannel[3];
-
-	uint8_t m_cPort;
-
-	int m_iCounter;
-
-	uint32_t m_iNoisePeriod;
-	uint32_t m_iNoiseClock;
-	uint32_t m_iNoiseState;
-
-	uint32_t m_iEnvelopePeriod;
-	uint32_t m_iEnvelopeClock;
-	char m_iEnvelopeLevel;
-	char m_iEnvelopeShape;
-	bool m_bEnvelopeHold;
+	using CPSG::CPSG;
 };
@@ -23,80 +23,32 @@
 
 #pragma once
 
-#include "SoundChip.h"
-#include "Channel.h"
-
-// // // 050B
-
-class CAY8930Channel : public CChannel
-{
-public:
-	friend class CAY8930;
-
-	CAY8930Channel(CMixer *pMixer, uint8_t ID);
-	
-	void Process(uint32_t Time);
-	void RunEnvelope(uint32_t Time);
-	void Reset();
-
-	uint32_t GetTime();
-	void Output(uint32_t Noise);
-
-	double GetFrequency() const override;
-
-private:
-	uint8_t m_iVolume;
-	uint32_t m_iPeriod;
-	uint32_t m_iPeriodClock;
-
-	uint8_t m_iDutyCycleCounter;
-	uint8_t m_iDutyCycle;
-
-	bool m_bSquareHigh;
-	bool m_bSquareDisable;
-	bool m_bNoiseDisable;
-
-	uint32_t m_iEnvelopePeriod;
-	uint32_t m_iEnvelopeClock;
-	char m_iEnvelopeLevel;
-	char m_iEnvelopeShape;
-	bool m_bEnvelopeHold;
+#include "PSG.h"
+
+// AY8930, always in expanded mode
+
+struct CAY8930Traits : CPSGTraits {
+	static constexpr int CHIP = SNDCHIP_AY8930;
+	static constexpr uint8_t CHANNEL = CHANID_AY8930_CH1;
+	static constexpr uint16_t PORT = 0xC001;
+	static constexpr unsigned TONE_SHIFT = 0;
+	static constexpr unsigned ENVELOPE_SHIFT = 3;
+	static constexpr bool INVERTED = false;
+	static constexpr bool EXTENDED = true;
+	static constexpr int32_t VOLUME[32] = {
+		  1,   1,   1,   2,
+		  2,   2,   3,   4,
+		  4,   5,   6,   7,
+		  9,  11,  13,  15,
+		 18,  22,  26,  31,
+		 37,  45,  53,  63,
+		 75,  90, 107, 127,
+		151, 180, 214, 255,
+	};
 };
 
-class CAY8930 : public CSoundChip
+class CAY8930 final : public CPSG<CAY8930Traits>
 {
 public:
-	CAY8930(CMixer *pMixer);
-	virtual ~CAY8930();
-	
-	void	Reset();
-	void	Process(uint32_t Time);
-	void	EndFrame();
-
-	void	Write(uint16_t Address, uint8_t Value);
-	uint8_t	Read(uint16_t Address, bool &Mapped);
-	void	Log(uint16_t Address, uint8_t Value);		// // //
-
-	double	GetFreq(int Channel) const override;		// // //
-
-private:
-	void	WriteReg(uint8_t Port, uint8_t Value);
-	void	RunNoise(uint32_t Time);
-
-private:
-	CAY8930Channel *m_pChannel[3];
-
-	uint8_t m_cPort;
-
-	int m_iCounter;
-
-	uint32_t m_iNoisePeriod;
-	uint32_t m_iNoiseClock;
-	uint32_t m_iNoiseState;
-	uint32_t m_iNoiseValue;
-	uint32_t m_iNoiseLatch;
-
-	uint32_t m_iNoiseANDMask;
-	uint32_t m_iNoiseORMask;
-
+	using CPSG::CPSG;
 };
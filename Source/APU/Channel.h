@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include "StateArchive.h"		// // //
+
 class CMixer;
 
 //
@@ -38,6 +40,11 @@ public:
 
 	virtual double GetFrequency() const = 0;		// // //
 
+	/// Saves or restores the channel state, see CStateArchive. Overrides call this first.
+	virtual void SerializeState(CStateArchive &State) {		// // //
+		State(m_iTime, m_iLastValue);
+	}
+
 protected:
 	virtual void Mix(int32_t Value) {
 		int32_t Delta = Value - m_iLastValue;
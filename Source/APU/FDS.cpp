@@ -18,9 +18,11 @@
 ** along with this program. If not, see https://www.gnu.org/licenses/.
 */
 
-#include "../stdafx.h"
+#include <cassert>
 #include "APU.h"
 #include "FDS.h"
+#include "PostFilter.h"
+#include "StateArchive.h"		// // //
 #include "../RegisterState.h"		// // //
 #define _USE_MATH_DEFINES
 #include <math.h>		// !! !! M_PI
@@ -47,6 +49,15 @@ void CFDS::Reset()
 	m_BlipFDS.clear();
 }
 
+void CFDS::SerializeState(CStateArchive &State)		// // //
+{
+	CSoundChip2::SerializeState(State);
+	m_FDS.SerializeState(State);
+	State(m_ChannelLevel, m_lowPassState, m_iTime);
+	m_BlipFDS.serialize_state(State, m_iTime);
+	m_SynthFDS.serialize_state(State);
+}
+
 void CFDS::UpdateFilter(blip_eq_t eq)
 {
 	m_SynthFDS.treble_eq(eq); // Apply 2A03 global EQ on top of FDS's dedicated lowpass.
@@ -133,7 +144,7 @@ void CFDS::EndFrame(Blip_Buffer& Output, gsl::span<int16_t> TempBuffer)
 	// I'm not sure if this is true.
 	m_BlipFDS.end_frame(m_iTime);
 
-	ASSERT(size_t(m_BlipFDS.samples_avail()) <= TempBuffer.size());
+	assert(size_t(m_BlipFDS.samples_avail()) <= TempBuffer.size());
 
 	// We need to read samples into a sound buffer of length equal to CAPU::m_pSoundBuffer.
 	// TempBuffer points to the same memory as CAPU::m_pSoundBuffer (whose contents are not needed).
@@ -142,11 +153,7 @@ void CFDS::EndFrame(Blip_Buffer& Output, gsl::span<int16_t> TempBuffer)
 	auto unfilteredData = TempBuffer.subspan(0, nsamp_read);
 
 	// Low-pass FDS output.
-	for (auto& amplitude : unfilteredData) {
-		float out = m_lowPassState + m_alpha * (float(amplitude) - m_lowPassState);
-		amplitude = (int16_t) roundf(out);
-		m_lowPassState = out + 1e-18f;  // prevent denormal numbers
-	}
+	PostFilter::Lowpass(unfilteredData, m_alpha, m_lowPassState);
 
 	Output.mix_samples_raw(unfilteredData.data(), static_cast<blip_nsamp_t>(unfilteredData.size()));
 
@@ -195,7 +202,7 @@ double CFDS::GetModFreq() const
 }
 int CFDS::GetChannelLevel(int Channel)
 {
-	ASSERT(Channel == 0);
+	assert(Channel == 0);
 	if (Channel == 0) {
 		return m_ChannelLevel.getLevel();
 	}
@@ -204,7 +211,7 @@ int CFDS::GetChannelLevel(int Channel)
 
 int CFDS::GetChannelLevelRange(int Channel) const
 {
-	ASSERT(Channel == 0);
+	assert(Channel == 0);
 	if (Channel == 0) {
 		// The highest possible FDS volume level is achievable
 		// by explicitly setting the instrument volume to 32, leaving channel volume at F,
@@ -25,8 +25,6 @@
 #include "ChannelLevelState.h"
 #include "Blip_Buffer/Blip_Buffer.h"
 #include "APU/mesen/FdsAudio.h"
-#include "FamiTracker.h"
-#include "Settings.h"
 
 class CMixer;
 
@@ -44,8 +42,9 @@ public:
 	double	GetFreq(int Channel) const override;		// // //
 	int GetChannelLevel(int Channel) override;
 	int GetChannelLevelRange(int Channel) const override;
+	void SerializeState(CStateArchive &State) override;		// // //
 
-	int CFDS::GetModCounter() const;
+	int GetModCounter() const;
 
 	void UpdateFDSFilter(int CutoffHz);
 	void UpdateMixLevel(double v, bool UseSurveyMix = false);
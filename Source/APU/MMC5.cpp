@@ -29,17 +29,9 @@
 #include "../RegisterState.h"		// // //
 
 
-uint16_t PCMClock = 0x0000;
-uint32_t PCMPhase = 0x0000;
-uint16_t PCMPhaseL = 0x0000;
+// // // The sampler state lives in CMMC5, so that several APUs (stems, batch renders) can run at once
 
-uint16_t PCMPitch = 0x0100;
-uint16_t PCMVolume = 0xFF;
-
-uint8_t PCMTrigger = 0;
-uint8_t PCMLoop = 0;
-
-uint16_t PCMClockTime = 256;
+const uint16_t PCMClockTime = 256;		// CPU cycles between sample fetches
 
 const uint16_t PCMLength[5] = { 653, 2699, 4081, 6058, 639 };
 
@@ -966,16 +958,7 @@ uint8_t PCMData5[639] = {
 
 // woah, that's tons of HEX values!
 
-uint32_t PCMTime = 0;
-
-float Delta = 0;
-
-int minVal = 0;
-float maxVal = 0;
-
-const int DAChLen = 256;
-int DAChistory[DAChLen] = {};
-int DAChistorylen = 0;
+const uint8_t *const PCMData[5] = { PCMData1, PCMData2, PCMData3, PCMData4, PCMData5 };		// // //
 
 // MMC5 external sound
 
@@ -987,7 +970,15 @@ CMMC5::CMMC5(CMixer* pMixer) :
 	m_iMulLow(0),
 	m_iMulHigh(0),
 	m_iDAC(0),
-	m_iLastDACValue(0)
+	m_bDACMode(false),
+	m_iLastDACValue(0),
+	m_iPCMTime(0),
+	m_iPCMClock(0),
+	m_iPCMPhase(0),
+	m_iPCMPitch(0x0100),
+	m_iPCMVolume(0xFF),
+	m_iPCMTrigger(0),
+	m_fPCMLevel(0.0f)
 {
 	m_pRegisterLogger->AddRegisterRange(0x5000, 0x5007);		// // //
 	m_pRegisterLogger->AddRegisterRange(0x5015, 0x5015);
@@ -1015,6 +1006,19 @@ void CMMC5::Reset()
 	m_pSquare2->Write(0x01, 0x08);
 
 	m_iDAC = 0;
+	m_iPCMTrigger = 0;		// // //
+	m_iPCMClock = 0;
+	m_iPCMPhase = 0;
+}
+
+void CMMC5::SerializeState(CStateArchive &State)		// // //
+{
+	CSoundChip::SerializeState(State);
+	m_pSquare1->SerializeState(State);
+	m_pSquare2->SerializeState(State);
+	State.Bytes(m_pEXRAM, 0x400);
+	State(m_iMulLow, m_iMulHigh, m_iDAC, m_bDACMode, m_iTime, m_iLastDACValue,
+		m_iPCMTime, m_iPCMClock, m_iPCMPhase, m_iPCMPitch, m_iPCMVolume, m_iPCMTrigger, m_fPCMLevel);
 }
 
 void CMMC5::Write(uint16_t Address, uint8_t Value)
@@ -1066,18 +1070,17 @@ void CMMC5::Write(uint16_t Address, uint8_t Value)
 		break;
 
 	case 0x5112:
-		PCMTrigger = Value;
-		PCMPhase = 0;
-		PCMPhaseL = 0;
+		m_iPCMTrigger = Value;
+		m_iPCMPhase = 0;
 		break;
 	case 0x5113:
-		PCMPitch = (PCMPitch & 0xFF00) | (Value);
+		m_iPCMPitch = (m_iPCMPitch & 0xFF00) | (Value);
 		break;
 	case 0x5114:
-		PCMPitch = (PCMPitch & 0x00FF) | (Value << 8);
+		m_iPCMPitch = (m_iPCMPitch & 0x00FF) | (Value << 8);
 		break;
 	case 0x5115:
-		PCMVolume = Value * 0x11;
+		m_iPCMVolume = Value * 0x11;
 		break;
 		//case 0x5116:
 			//PCMLoop = Value;
@@ -1108,7 +1111,7 @@ void CMMC5::EndFrame()
 {
 	m_pSquare1->EndFrame();
 	m_pSquare2->EndFrame();
-	PCMTime = 0;
+	m_iPCMTime = 0;
 }
 
 void CMMC5::Process(uint32_t Time)
@@ -1116,82 +1119,95 @@ void CMMC5::Process(uint32_t Time)
 	m_pSquare1->Process(Time);
 	m_pSquare2->Process(Time);
 
-	// m_iValue = m_pSquare1->m_iValue + m_pSquare2->m_iValue;
-
-	uint32_t now = 0;
+	// // // The sampler only does something every PCMClockTime cycles, so run from one
+	// fetch to the next instead of cycle by cycle. This is the same as clocking it and
+	// sending the DAC output to the mixer every cycle, except that the mixer only gets
+	// the changes.
 
-	//auto get_output = [this](uint32_t dclocks, uint32_t now) {
-		//short buf = {};
-  //};
-
-	while (now < Time) {
-		if (PCMTrigger > 0)
-			PCMClock += 1;
+	uint32_t Now = 0;
+	while (Now < Time) {
+		uint32_t Span = Time - Now;
+		bool Fetch = false;
+		if (m_iPCMTrigger > 0) {
+			const uint32_t Next = PCMClockTime - m_iPCMClock;		// Fetches on the cycle the clock reaches PCMClockTime
+			if (Next <= Span) {
+				Span = Next;
+				Fetch = true;
+			}
+			m_iPCMClock += Span;
+		}
 		else {
-			PCMClock = 0;
-			PCMPhase = 0;
-			PCMPhaseL = 0;
+			m_iPCMClock = 0;
+			m_iPCMPhase = 0;
+		}
+
+		// Every cycle before the fetch outputs the current byte
+		const uint32_t Hold = Fetch ? Span - 1 : Span;
+		if (Hold > 0) {
+			OutputPCM(Now, Hold);
+			Now += Hold;
 		}
-		if (PCMClock >= PCMClockTime) {
-			PCMClock -= PCMClockTime;
+		if (!Fetch)
+			continue;
 
-			PCMPhase += PCMPitch;
-			if ((PCMPhase >> 8) >= PCMLength[PCMTrigger - 1]) {
-				if (PCMLoopPoints[PCMTrigger - 1] != 65535) {
-					PCMPhase += ((uint32_t)(PCMLoopPoints[PCMTrigger - 1]) << 8) - ((uint32_t)(PCMLength[PCMTrigger - 1]) << 8);
-				}
-				else {
-					PCMTrigger = false;
-					PCMPhase = 0;
-				}
+		m_iPCMClock -= PCMClockTime;
+		m_iPCMPhase += m_iPCMPitch;
+		if ((m_iPCMPhase >> 8) >= PCMLength[m_iPCMTrigger - 1]) {
+			if (PCMLoopPoints[m_iPCMTrigger - 1] != 65535) {
+				m_iPCMPhase += ((uint32_t)(PCMLoopPoints[m_iPCMTrigger - 1]) << 8) - ((uint32_t)(PCMLength[m_iPCMTrigger - 1]) << 8);
 			}
 			else {
-				switch (PCMTrigger) {
-				case 1:
-					m_iDAC = PCMData1[PCMPhase >> 8];
-					break;
-				case 2:
-					m_iDAC = PCMData2[PCMPhase >> 8];
-					break;
-				case 3:
-					m_iDAC = PCMData3[PCMPhase >> 8];
-					break;
-				case 4:
-					m_iDAC = PCMData4[PCMPhase >> 8];
-					break;
-				case 5:
-					m_iDAC = PCMData5[PCMPhase >> 8];
-					break;
-				default:
-					break;
-				}
+				m_iPCMTrigger = 0;
+				m_iPCMPhase = 0;
 			}
 		}
-		int out = ((m_iDAC * PCMVolume) >> 9) + 1;
+		else if (m_iPCMTrigger <= 5)
+			m_iDAC = PCMData[m_iPCMTrigger - 1][m_iPCMPhase >> 8];
 
-		//for (int i = DAChistorylen; i >= 1; i--)
-		//	DAChistory[i] = DAChistory[i - 1];
-		//DAChistory[0] = out;
-		//if (DAChistorylen < DAChLen-1)
-		//	DAChistorylen++;
-		//int min = 255;
-		//int max = 0;
-		//for (int i = 0; i <= DAChistorylen; i++) {
-		//	int val = DAChistory[i];
-		//	min = std::min(min, val);
-		//	max = std::max(max, val);
-		//}
-		//minVal = std::min(out, minVal);
-		if (Delta < out)
-			Delta += 0.01f;
-		if (Delta > out)
-			Delta -= 0.01f;
-		m_pMixer->AddValue(CHANID_MMC5_VOICE, SNDCHIP_MMC5, out, (int)(abs((float)(out)-Delta) * 2), now + PCMTime);
+		OutputPCM(Now, 1);
+		++Now;
+	}
+
+	m_iPCMTime += Time;
+}
 
-		now += 1;
+void CMMC5::OutputPCM(uint32_t Now, uint32_t Cycles)
+{
+	// Outputs the DAC for Cycles cycles from Now. The meter envelope only falls towards
+	// a steady output, so its highest level in a block is at the start or at a change.
+
+	const int Out = GetPCMOutput();
+	StepPCMLevel(Out, 1);
+	if (Out != m_iLastDACValue) {
+		m_pMixer->AddValue(CHANID_MMC5_VOICE, SNDCHIP_MMC5, Out, GetPCMLevel(Out), Now + m_iPCMTime);
+		m_iLastDACValue = Out;
+	}
+	else if (Now == 0) {
+		if (int Level = GetPCMLevel(Out))
+			m_pMixer->AddValue(CHANID_MMC5_VOICE, SNDCHIP_MMC5, Out, Level, m_iPCMTime);
 	}
+	StepPCMLevel(Out, Cycles - 1);
+}
 
-	PCMTime += Time;
+int CMMC5::GetPCMOutput() const
+{
+	return ((m_iDAC * m_iPCMVolume) >> 9) + 1;
+}
+
+void CMMC5::StepPCMLevel(int Out, uint32_t Cycles)
+{
+	// The meter envelope moves by 0.01 per cycle towards the output, and stays within 0.01 of it
+	const float Distance = Out - m_fPCMLevel;
+	const float Step = 0.01f * Cycles;
+	if (std::abs(Distance) <= Step)
+		m_fPCMLevel = static_cast<float>(Out);
+	else
+		m_fPCMLevel += Distance > 0.0f ? Step : -Step;
+}
+
+int CMMC5::GetPCMLevel(int Out) const
+{
+	return static_cast<int>(std::abs(Out - m_fPCMLevel) * 2);
 }
 
 double CMMC5::GetFreq(int Channel) const		// // //
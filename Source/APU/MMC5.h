@@ -37,6 +37,7 @@ public:
 	void EndFrame();
 	void Process(uint32_t Time);
 	double GetFreq(int Channel) const;		// // //
+	void SerializeState(CStateArchive &State) override;		// // //
 
 	void LengthCounterUpdate();
 	void EnvelopeUpdate();
@@ -56,5 +57,19 @@ private:
 	bool m_bDACMode;
 	uint32_t m_iTime;
 
-	int		m_iLastDACValue;
+	int		m_iLastDACValue;		// // // Last output sent to the mixer
+
+	// // // PCM sampler
+	void	OutputPCM(uint32_t Now, uint32_t Cycles);
+	int		GetPCMOutput() const;
+	void	StepPCMLevel(int Out, uint32_t Cycles);
+	int		GetPCMLevel(int Out) const;
+
+	uint32_t m_iPCMTime;		// Cycles since the start of the frame
+	uint16_t m_iPCMClock;
+	uint32_t m_iPCMPhase;		// 8.8 fixed point position in the sample
+	uint16_t m_iPCMPitch;
+	uint16_t m_iPCMVolume;
+	uint8_t	m_iPCMTrigger;		// Sample number + 1, 0 when stopped
+	float	m_fPCMLevel;		// Meter envelope
 };
\ No newline at end of file
@@ -63,7 +63,8 @@
 
 */
 
-#include "../stdafx.h"
+#include <cassert>
+#include <cstring>
 #include <memory>
 #include <algorithm>
 #include <cmath>
@@ -76,6 +77,7 @@
 #include "7E02.h"
 #include "OPLL.h"
 #include "6581.h"
+#include "StateArchive.h"		// // //
 
 #include "utils/variadic_minmax.h"
 
@@ -184,6 +186,55 @@ void CMixer::SetChipLevel(chip_level_t Chip, float Level)
 	}
 }
 
+float CMixer::GetChipLevel(chip_level_t Chip) const
+{
+	switch (Chip) {
+		case CHIP_LEVEL_APU1:
+			return m_fLevelAPU1;
+		case CHIP_LEVEL_APU2:
+			return m_fLevelAPU2;
+		case CHIP_LEVEL_VRC6:
+			return m_fLevelVRC6;
+		case CHIP_LEVEL_VRC7:
+			return m_fLevelVRC7;
+		case CHIP_LEVEL_FDS:
+			return m_fLevelFDS;
+		case CHIP_LEVEL_MMC5:
+			return m_fLevelMMC5;
+		case CHIP_LEVEL_N163:
+			return m_fLevelN163;
+		case CHIP_LEVEL_5B:		// // // 050B
+			return m_fLevel5B;
+		case CHIP_LEVEL_AY8930:
+			return m_fLevelAY8930;
+		case CHIP_LEVEL_AY:
+			return m_fLevelAY;
+		case CHIP_LEVEL_YM2149F:
+			return m_fLevelYM2149F;
+		case CHIP_LEVEL_5E01_APU1:
+			return m_fLevel5E01_APU1;
+		case CHIP_LEVEL_5E01_APU2:
+			return m_fLevel5E01_APU2;
+		case CHIP_LEVEL_7E02_APU1:
+			return m_fLevel7E02_APU1;
+		case CHIP_LEVEL_7E02_APU2:
+			return m_fLevel7E02_APU2;
+		case CHIP_LEVEL_OPLL:
+			return m_fLevelOPLL;
+		case CHIP_LEVEL_6581:
+			return m_fLevel6581;
+
+		case CHIP_LEVEL_COUNT:
+			break;
+	}
+	return 1.0f;
+}
+
+void CMixer::SetSoloChannel(int ChanID)
+{
+	m_iSoloChannel = ChanID;
+}
+
 float CMixer::GetAttenuation(bool UseSurveyMix) const
 {
 	float ATTENUATION_2A03 = 1.0f;
@@ -333,9 +384,11 @@ void CMixer::RecomputeEmuMixState()
 
 	chipN163.UpdateN163Filter(m_MixerConfig.N163Lowpass, m_EmulatorConfig.N163DisableMultiplexing);
 	chipFDS.UpdateFDSFilter(m_MixerConfig.FDSLowpass);
+	chipVRC7.SetNativeRate(m_EmulatorConfig.UseOPLLNativeRate);		// // //
+	chipOPLL.SetNativeRate(m_EmulatorConfig.UseOPLLNativeRate);
 
-	ASSERT(!m_EmulatorConfig.UseOPLLPatchBytes.empty());
-	ASSERT(m_EmulatorConfig.UseOPLLPatchBytes.size() == 19 * 8);
+	assert(!m_EmulatorConfig.UseOPLLPatchBytes.empty());
+	assert(m_EmulatorConfig.UseOPLLPatchBytes.size() == 19 * 8);
 
 	chipVRC7.UpdatePatchSet(
 		m_EmulatorConfig.UseOPLLPatchSet,
@@ -364,6 +417,7 @@ bool CMixer::AllocateBuffer(unsigned int BufferLength, uint32_t SampleRate, uint
 {
 	m_iSampleRate = SampleRate;
 	BlipBuffer.set_sample_rate(SampleRate, (BufferLength * 1000 * 2) / SampleRate);
+	UpdateChipBuffers();
 
 	// I don't know if BlipFDS is initialized or not.
 	// So I copied the above call to CMixer::UpdateSettings().
@@ -374,6 +428,7 @@ void CMixer::SetClockRate(uint32_t Rate)
 {
 	// Change the clockrate
 	BlipBuffer.clock_rate(Rate);
+	UpdateChipBuffers();
 
 	// Propagate the change to any sound chips with their own Blip_Buffer.
 	// Note that m_APU->m_SoundChips2 may not have been initialized yet,
@@ -386,6 +441,9 @@ void CMixer::SetClockRate(uint32_t Rate)
 void CMixer::ClearBuffer()
 {
 	BlipBuffer.clear();
+	for (auto &pBuffer : m_pChipBuffers)
+		if (pBuffer)
+			pBuffer->clear();
 
 	// What about CSoundChip2 which owns its own Blip_Synth?
 	// I've decided that CMixer should not be responsible for clearing those Blip_Synth,
@@ -399,6 +457,20 @@ void CMixer::ClearBuffer()
 	#undef X
 }
 
+void CMixer::SerializeState(CStateArchive &State, uint32_t FrameTime)		// // //
+{
+	BlipBuffer.serialize_state(State, FrameTime);
+	for (auto &pBuffer : m_pChipBuffers)
+		if (pBuffer)
+			pBuffer->serialize_state(State, FrameTime);
+
+	#define X(SYNTH)  SYNTH.serialize_state(State);
+	FOREACH_SYNTH(X, );
+	#undef X
+
+	State(m_iChannels, m_fChannelLevels, m_iChanLevelFallOff);
+}
+
 int CMixer::SamplesAvail() const
 {
 	return (int)BlipBuffer.samples_avail();
@@ -412,7 +484,7 @@ static int get_channel_level(CSoundChip2& chip, int channel) {
 	level = min(level, max);
 
 	int out = level * 16 / (max + 1);
-	ASSERT(0 <= out && out <= 15);
+	assert(0 <= out && out <= 15);
 
 	// Ensure that the division process never clips small levels to 0.
 	if (level > 0 && out <= 0) {
@@ -421,9 +493,14 @@ static int get_channel_level(CSoundChip2& chip, int channel) {
 	return out;
 }
 
-void CMixer::FinishBuffer(int t)
+void CMixer::FinishBlock(int t)		// // //
 {
 	BlipBuffer.end_frame(t);
+}
+
+void CMixer::FinishBuffer(int t)
+{
+	FinishBlock(t);		// // //
 
 	for (int i = 0; i < CHANNELS; ++i) {
 		// TODO: this is more complicated than 0.5.0 beta's implementation
@@ -483,32 +560,32 @@ void CMixer::FinishBuffer(int t)
 
 void CMixer::MixVRC6(int Value, int Time)
 {
-	SynthVRC6.offset(Time, Value, &BlipBuffer);
+	SynthVRC6.offset(Time, Value, &GetBuffer(SNDCHIP_VRC6));
 }
 
 void CMixer::MixMMC5(int Value, int Time)
 {
-	SynthMMC5.offset(Time, Value, &BlipBuffer);
+	SynthMMC5.offset(Time, Value, &GetBuffer(SNDCHIP_MMC5));
 }
 
 void CMixer::MixS5B(int Value, int Time)
 {
-	SynthS5B.offset(Time, Value, &BlipBuffer);
+	SynthS5B.offset(Time, Value, &GetBuffer(SNDCHIP_5B));
 }
 
 void CMixer::MixAY8930(int Value, int Time)
 {
-	SynthAY8930.offset(Time, Value, &BlipBuffer);
+	SynthAY8930.offset(Time, Value, &GetBuffer(SNDCHIP_AY8930));
 }
 
 void CMixer::MixAY(int Value, int Time)
 {
-	SynthAY.offset(Time, Value, &BlipBuffer);
+	SynthAY.offset(Time, Value, &GetBuffer(SNDCHIP_AY));
 }
 
 void CMixer::MixYM2149F(int Value, int Time)
 {
-	SynthYM2149F.offset(Time, Value, &BlipBuffer);
+	SynthYM2149F.offset(Time, Value, &GetBuffer(SNDCHIP_SSG));
 }
 
 void CMixer::AddValue(int ChanID, int Chip, int Value, int AbsValue, int FrameCycles)
@@ -520,6 +597,9 @@ void CMixer::AddValue(int ChanID, int Chip, int Value, int AbsValue, int FrameCy
 	StoreChannelLevel(ChanID, AbsValue);
 	m_iChannels[ChanID] = Value;
 
+	if (m_iSoloChannel != -1 && ChanID != m_iSoloChannel)
+		return;
+
 	// Unless otherwise notes, Value is already a delta.
 	switch (Chip) {
 		case SNDCHIP_NONE:
@@ -527,8 +607,9 @@ void CMixer::AddValue(int ChanID, int Chip, int Value, int AbsValue, int FrameCy
 			// (obtained by CMixer::GetBuffer()).
 			break;
 		case SNDCHIP_MMC5:
-			// Value == AbsValue.
-			MixMMC5(Delta, FrameCycles);
+			// Value == AbsValue. The MMC5 voice also updates only its meter level.
+			if (Delta)
+				MixMMC5(Delta, FrameCycles);
 			break;
 		case SNDCHIP_VRC6:
 			MixVRC6(Value, FrameCycles);
@@ -550,7 +631,54 @@ void CMixer::AddValue(int ChanID, int Chip, int Value, int AbsValue, int FrameCy
 
 int CMixer::ReadBuffer(void *Buffer)
 {
-	return BlipBuffer.read_samples((blip_amplitude_t*)Buffer, BlipBuffer.samples_avail());
+	int Samples = BlipBuffer.read_samples((blip_amplitude_t*)Buffer, BlipBuffer.samples_avail());
+
+	// Reading moves BlipBuffer's time offset, the chip buffers must follow it.
+	for (auto &pBuffer : m_pChipBuffers)
+		if (pBuffer)
+			pBuffer->sync_time(BlipBuffer);
+
+	return Samples;
+}
+
+void CMixer::SetChipBuffers(int Chips)
+{
+	static_assert(ChipBufferIndex(SNDCHIP_AY) == CHIP_BUFFER_COUNT - 1);
+
+	for (int i = 0; i < CHIP_BUFFER_COUNT; ++i) {
+		const int Chip = i ? 1 << (i - 1) : SNDCHIP_NONE;
+		if (!(Chips & Chip))
+			m_pChipBuffers[i].reset();
+		else if (!m_pChipBuffers[i])
+			m_pChipBuffers[i] = std::make_unique<Blip_Buffer>();
+	}
+	UpdateChipBuffers();
+}
+
+Blip_Buffer& CMixer::GetBuffer(int Chip)
+{
+	auto &pBuffer = m_pChipBuffers[ChipBufferIndex(Chip)];
+	return pBuffer ? *pBuffer : BlipBuffer;
+}
+
+void CMixer::MixChipBuffers(int t)
+{
+	for (auto &pBuffer : m_pChipBuffers)
+		if (pBuffer)
+			BlipBuffer.mix_deltas(*pBuffer, t);
+}
+
+void CMixer::UpdateChipBuffers()
+{
+	for (auto &pBuffer : m_pChipBuffers) {
+		if (!pBuffer)
+			continue;
+		if (BlipBuffer.sample_rate())
+			pBuffer->set_sample_rate(BlipBuffer.sample_rate(), BlipBuffer.length());
+		if (BlipBuffer.clock_rate())
+			pBuffer->clock_rate(BlipBuffer.clock_rate());
+		pBuffer->sync_time(BlipBuffer);
+	}
 }
 
 int32_t CMixer::GetChanOutput(uint8_t Chan) const
@@ -23,10 +23,11 @@
 
 #include "Types.h"
 #include "../Common.h"
-#include "../Blip_Buffer/blip_buffer.h"
+#include "../Blip_Buffer/Blip_Buffer.h"
 
 #include <vector>		// !! !!
 #include <string>		// !! !!
+#include <memory>
 
 enum chip_level_t {
 	CHIP_LEVEL_APU1,
@@ -56,6 +57,7 @@ class C5E01; // Taken from E-FamiTracker by Euly
 class C7E02;
 class COPLL;
 class C6581; // Taken from E-FamiTracker by Euly
+class CStateArchive;
 
 struct MixerConfig {
 	// Global lowpass
@@ -150,6 +152,9 @@ struct EmulatorConfig {
 		"",
 		""
 	};
+
+	// Run emu2413 at its own rate between register writes, resampled by Blip_Buffer
+	bool UseOPLLNativeRate = false;
 };
 
 class CMixer
@@ -173,9 +178,26 @@ public:
 	Blip_Buffer& GetBuffer() {
 		return BlipBuffer;
 	}
+
+	/// Gives every chip in the Chips bitfield its own Blip_Buffer, so that
+	/// these chips can be emulated on other threads. 0 removes them again.
+	void	SetChipBuffers(int Chips);
+	/// The buffer Chip synthesizes into: its own one if SetChipBuffers() gave it one,
+	/// otherwise the shared buffer.
+	Blip_Buffer& GetBuffer(int Chip);
+	/// Adds everything synthesized into the chip buffers this frame to the shared buffer.
+	/// Must be called before FinishBuffer().
+	void	MixChipBuffers(int t);
 	void	SetClockRate(uint32_t Rate);
 	void	ClearBuffer();
+	/// Saves or restores the contents of the Blip_Buffers, the state of the synths
+	/// owned by the mixer and the channel levels, see CStateArchive. FrameTime is the
+	/// number of clocks run since the buffer was last ended.
+	void	SerializeState(CStateArchive &State, uint32_t FrameTime);
 	void FinishBuffer(int t);
+	/// Ends the shared buffer at t without updating the channel levels, for flushes
+	/// within a frame. FinishBuffer() ends the frame.
+	void	FinishBlock(int t);		// // //
 	int		SamplesAvail() const;
 	void	MixSamples(blip_amplitude_t *pBuffer, uint32_t Count);
 	uint32_t	GetMixSampleCount(int t) const;
@@ -185,6 +207,9 @@ public:
 
 	int32_t	GetChanOutput(uint8_t Chan) const;
 	void	SetChipLevel(chip_level_t Chip, float Level);
+	float	GetChipLevel(chip_level_t Chip) const;
+	/// Only lets ChanID through to the CSoundChip synths, -1 lets every channel through.
+	void	SetSoloChannel(int ChanID);
 	uint32_t	ResampleDuration(uint32_t Time) const;
 
 	int		GetMeterDecayRate() const;		// // // 050B
@@ -201,6 +226,14 @@ private:
 	void StoreChannelLevel(int Channel, int Value);
 	void ClearChannelLevels();
 
+	void UpdateChipBuffers();
+	static constexpr int ChipBufferIndex(int Chip) {
+		int Index = 0;
+		for (; Chip; Chip >>= 1)
+			++Index;
+		return Index;
+	}
+
 	float GetAttenuation(bool UseSurveyMix) const;
 
 private:
@@ -238,8 +271,14 @@ private:
 	// Blip buffer object
 	Blip_Buffer	BlipBuffer;
 
+	// Per-chip buffers for parallel emulation, indexed by ChipBufferIndex().
+	// They follow BlipBuffer's rate and time offset, and are emptied into it every frame.
+	static const int CHIP_BUFFER_COUNT = 18;		// 2A03 plus every SNDCHIP_ bit up to SNDCHIP_AY
+	std::unique_ptr<Blip_Buffer> m_pChipBuffers[CHIP_BUFFER_COUNT];
+
 	int32_t		m_iChannels[CHANNELS];
 	int			m_iExternalChip;
+	int			m_iSoloChannel = -1;
 	uint32_t	m_iSampleRate;
 
 	// channel levels for volume meter
@@ -18,12 +18,12 @@
 ** along with this program. If not, see https://www.gnu.org/licenses/.
 */
 
-#include "../stdafx.h"
-#include "../FamiTracker.h"
-#include "../Settings.h"
+#include <cassert>
 #include "../Common.h"
 #include "APU.h"
 #include "N163.h"
+#include "PostFilter.h"
+#include "StateArchive.h"		// // //
 #include "../RegisterState.h"		// // //
 #define _USE_MATH_DEFINES
 #include <math.h>		// !! !! M_PI
@@ -49,12 +49,22 @@ void CN163::Reset()
 {
 	m_N163.Reset();
 	m_N163.SetMixing(m_bUseLinearMixing);
+	m_N163.SetChannelMask(m_iChannelMask);
 
 	m_iTime = 0;
 	m_SynthN163.clear();
 	m_BlipN163.clear();
 }
 
+void CN163::SerializeState(CStateArchive &State)		// // //
+{
+	CSoundChip2::SerializeState(State);
+	m_N163.SerializeState(State);
+	State(m_ChannelLevels, m_lowPassState, m_iTime);
+	m_BlipN163.serialize_state(State, m_iTime);
+	m_SynthN163.serialize_state(State);
+}
+
 void CN163::UpdateFilter(blip_eq_t eq)
 {
 	m_BlipN163.set_sample_rate(eq.sample_rate);
@@ -74,6 +84,15 @@ void CN163::Write(uint16_t Address, uint8_t Value)
 	m_N163.WriteRegister(Address, Value);
 }
 
+void CN163::SetChannelMask(uint32_t Mask)
+{
+	m_iChannelMask = 0;
+	for (int i = 0; i < 8; ++i)
+		if (Mask & (1 << i))
+			m_iChannelMask |= 1 << (7 - i);
+	m_N163.SetChannelMask(m_iChannelMask);
+}
+
 uint8_t CN163::Read(uint16_t Address, bool &Mapped)
 {
 	// Addresses for N163
@@ -130,6 +149,8 @@ void CN163::Process(uint32_t Time, Blip_Buffer& Output)
 void CN163::EndFrame(Blip_Buffer& Output, gsl::span<int16_t> TempBuffer)
 {
 	// log phase registers
+	// these are internal state rather than writes, so keep them out of the write journal
+	CRegisterLoggerBlock Block(m_pRegisterLogger.get());
 	for (int i = 0; i < 8; ++i) {
 		if (i <= m_N163.GetNumberOfChannels())
 			for (int j : {1, 3, 5}) {
@@ -141,17 +162,13 @@ void CN163::EndFrame(Blip_Buffer& Output, gsl::span<int16_t> TempBuffer)
 
 	m_BlipN163.end_frame(m_iTime);
 
-	ASSERT(size_t(m_BlipN163.samples_avail()) <= TempBuffer.size());
+	assert(size_t(m_BlipN163.samples_avail()) <= TempBuffer.size());
 
 	auto nsamp_read = m_BlipN163.read_samples(TempBuffer.data(), m_BlipN163.samples_avail());
 
 	auto unfilteredData = TempBuffer.subspan(0, nsamp_read);
 
-	for (auto& amplitude : unfilteredData) {
-		float out = m_lowPassState + m_alpha * (float(amplitude) - m_lowPassState);
-		amplitude = (int16_t)roundf(out);
-		m_lowPassState = out + 1e-18f;  // prevent denormal numbers
-	}
+	PostFilter::Lowpass(unfilteredData, m_alpha, m_lowPassState);
 
 	Output.mix_samples_raw(unfilteredData.data(), static_cast<blip_nsamp_t>(unfilteredData.size()));
 
@@ -169,7 +186,7 @@ double CN163::GetFreq(int Channel) const
 
 int CN163::GetChannelLevel(int Channel)
 {
-	ASSERT(0 <= Channel && Channel < 8);
+	assert(0 <= Channel && Channel < 8);
 	if (0 <= Channel && Channel < 8) {
 		return m_ChannelLevels[Channel].getLevel();
 	}
@@ -178,7 +195,7 @@ int CN163::GetChannelLevel(int Channel)
 
 int CN163::GetChannelLevelRange(int Channel) const
 {
-	ASSERT(0 <= Channel && Channel < 8);
+	assert(0 <= Channel && Channel < 8);
 	if (0 <= Channel && Channel < 8) {
 		// _channelOutput[channel] = (sample - 8) * volume;
 		// lowest output: -120
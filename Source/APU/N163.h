@@ -25,8 +25,6 @@
 #include "ChannelLevelState.h"
 #include "Blip_Buffer/Blip_Buffer.h"
 #include "APU/mesen/Namco163Audio.h"
-#include "FamiTracker.h"
-#include "Settings.h"
 
 class CN163 : public CSoundChip2 {
 public:
@@ -37,11 +35,13 @@ public:
 	void SetClockRate(uint32_t Rate) override;
 	void	Write(uint16_t Address, uint8_t Value) override;
 	uint8_t	Read(uint16_t Address, bool &Mapped) override;
+	void	SetChannelMask(uint32_t Mask) override;
 	void	Process(uint32_t Time, Blip_Buffer& Output) override;
 	void	EndFrame(Blip_Buffer& Output, gsl::span<int16_t> TempBuffer) override;
 	double	GetFreq(int Channel) const override;
 	int GetChannelLevel(int Channel) override;
 	int GetChannelLevelRange(int Channel) const override;
+	void SerializeState(CStateArchive &State) override;		// // //
 
 	void UpdateN163Filter(int CutoffHz, bool DisableMultiplex);
 	void UpdateMixLevel(double v, bool UseSurveyMix = false);
@@ -75,4 +75,5 @@ private:
 
 	int32_t m_iChannelSample[8];
 	bool m_bUseLinearMixing = false;		// // //
+	uint8_t m_iChannelMask = 0;		// In Namco163Audio's order, which runs from channel 8 down to 1
 };
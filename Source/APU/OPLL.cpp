@@ -18,15 +18,19 @@
 ** along with this program. If not, see https://www.gnu.org/licenses/.
 */
 
-#include "../stdafx.h"
-#include "../FamiTracker.h"
-#include "../Settings.h"
+#include <cassert>
+#include <algorithm>
+#include <cstring>
+#include <vector>
 #include "APU.h"
 #include "OPLL.h"
+#include "PostFilter.h"
+#include "StateArchive.h"		// // //
 #include "../RegisterState.h"		// // //
 
 const float  COPLL::AMPLIFY = 4.6f;		// Mixing amplification, VRC7 patch 14 is 4, 88 times stronger than a 50 % square @ v = 15
 const uint32_t COPLL::OPLL_CLOCK = CAPU::BASE_FREQ_VRC7;	// Clock frequency
+const uint32_t COPLL::OPLL_RATE = COPLL::OPLL_CLOCK / 72;		// // // 49716 Hz, one sample per 72 clocks
 
 COPLL::COPLL()
 {
@@ -44,19 +48,46 @@ COPLL::~COPLL()
 		m_pOPLLInt = NULL;
 	}
 
-	SAFE_RELEASE_ARRAY(m_pBuffer);
+	delete[] m_pBuffer;
+	delete[] m_pRawBuffer;
 }
 
 void COPLL::Reset()
 {
 	m_iBufferPtr = 0;
+	m_iLastSample = 0;
 	m_iTime = 0;
+	m_iNativePhase = 0;
 	m_BlipOPLL.clear();
+	m_SynthOPLL.clear();
 	if (m_pOPLLInt != NULL) {
 		// update patchset and OPLL type
 		OPLL_setChipType(m_pOPLLInt, 0);
 		OPLL_resetPatch(m_pOPLLInt, 7);
 		OPLL_reset(m_pOPLLInt);
+		OPLL_setMask(m_pOPLLInt, m_iChannelMask);
+	}
+}
+
+void COPLL::SerializeState(CStateArchive &State)		// // //
+{
+	CSoundChip2::SerializeState(State);
+	State(m_iTime, m_iBufferPtr, m_iLastSample, m_iSoundReg, m_iNativePhase, m_ChannelLevels);
+	m_BlipOPLL.serialize_state(State, m_iTime);
+	m_SynthOPLL.serialize_state(State);
+
+	// Samples generated ahead of the next frame
+	m_iBufferPtr = std::min(m_iBufferPtr, m_iMaxSamples);
+	if (m_pBuffer)
+		State.Bytes(m_pBuffer, m_iBufferPtr * sizeof(int16_t));
+
+	if (m_pOPLLInt != NULL) {
+		std::vector<uint8_t> Emulator(OPLL_getStateSize(m_pOPLLInt));
+		if (!State.IsLoading())
+			OPLL_saveState(m_pOPLLInt, Emulator.data());
+		State.Bytes(Emulator.data(), Emulator.size());
+		if (State.IsLoading())
+			OPLL_loadState(m_pOPLLInt, Emulator.data());
 	}
 }
 
@@ -78,15 +109,34 @@ void COPLL::SetSampleSpeed(uint32_t SampleRate, double ClockRate, uint32_t Frame
 		OPLL_delete(m_pOPLLInt);
 	}
 
-	m_pOPLLInt = OPLL_new(OPLL_CLOCK, SampleRate);
+	m_iSampleRate = SampleRate;
+	m_iCPUClock = static_cast<uint32_t>(ClockRate);
+	m_pOPLLInt = OPLL_new(OPLL_CLOCK, m_bNativeRate ? OPLL_RATE : SampleRate);
 
 	OPLL_reset(m_pOPLLInt);
+	OPLL_setMask(m_pOPLLInt, m_iChannelMask);
 
 	m_iMaxSamples = (SampleRate / FrameRate) * 2;	// Allow some overflow
 
-	SAFE_RELEASE_ARRAY(m_pBuffer);
+	delete[] m_pBuffer;
 	m_pBuffer = new int16_t[m_iMaxSamples];
 	memset(m_pBuffer, 0, sizeof(int16_t) * m_iMaxSamples);
+
+	delete[] m_pRawBuffer;
+	m_pRawBuffer = new int32_t[m_iMaxSamples];
+}
+
+void COPLL::SetNativeRate(bool Enable)		// // //
+{
+	if (m_bNativeRate == Enable)
+		return;
+	m_bNativeRate = Enable;
+	if (m_pOPLLInt != NULL)
+		OPLL_setRate(m_pOPLLInt, m_bNativeRate ? OPLL_RATE : m_iSampleRate);
+	m_iBufferPtr = 0;
+	m_iNativePhase = 0;
+	m_BlipOPLL.clear();
+	m_SynthOPLL.clear();
 }
 
 void COPLL::SetDirectVolume(double Volume)
@@ -115,6 +165,13 @@ void COPLL::Log(uint16_t Address, uint8_t Value)		// // //
 	}
 }
 
+void COPLL::SetChannelMask(uint32_t Mask)
+{
+	m_iChannelMask = Mask & 0x1FF;
+	if (m_pOPLLInt != NULL)
+		OPLL_setMask(m_pOPLLInt, m_iChannelMask);
+}
+
 uint8_t COPLL::Read(uint16_t Address, bool &Mapped)
 {
 	return 0;
@@ -122,37 +179,62 @@ uint8_t COPLL::Read(uint16_t Address, bool &Mapped)
 
 void COPLL::Process(uint32_t Time, Blip_Buffer& Output)
 {
-	// This cannot run in sync, fetch all samples at end of frame instead
+	if (!m_bNativeRate) {
+		// This cannot run in sync, fetch all samples at end of frame instead
+		m_iTime += Time;
+		return;
+	}
+
+	// // // Render every sample that falls within this block at its own CPU cycle. The APU
+	// calls Process() before each write, so the writes land between the right samples.
+	const uint64_t Period = 72ull * m_iCPUClock;
+	uint32_t Now = 0;
+	while (true) {
+		const uint32_t Wait = static_cast<uint32_t>((Period - m_iNativePhase + OPLL_CLOCK - 1) / OPLL_CLOCK);
+		if (Wait > Time - Now) {
+			m_iNativePhase += uint64_t(Time - Now) * OPLL_CLOCK;
+			break;
+		}
+		Now += Wait;
+		m_iNativePhase += uint64_t(Wait) * OPLL_CLOCK - Period;
+
+		m_SynthOPLL.update(m_iTime + Now, static_cast<int>(OPLL_calc(m_pOPLLInt) * m_DirectVolume), &m_BlipOPLL);
+		for (int i = 0; i < 9; i++)
+			m_ChannelLevels[i].update(static_cast<uint8_t>((255.0 * (OPLL_getchanvol(i) + 1.0)/4096.0)));
+	}
+
 	m_iTime += Time;
 }
 
 void COPLL::EndFrame(Blip_Buffer& Output, gsl::span<int16_t> TempBuffer)
 {
-	uint32_t WantSamples = Output.count_samples(m_iTime);
+	if (m_bNativeRate) {		// // //
+		m_BlipOPLL.end_frame(m_iTime);
 
-	static int32_t LastSample = 0;
+		assert(size_t(m_BlipOPLL.samples_avail()) <= TempBuffer.size());
+		auto nsamp_read = m_BlipOPLL.read_samples(TempBuffer.data(), m_BlipOPLL.samples_avail());
+		Output.mix_samples_raw(TempBuffer.data(), nsamp_read);
+
+		m_iTime = 0;
+		return;
+	}
+
+	uint32_t WantSamples = Output.count_samples(m_iTime);
 
 	// Generate OPLL samples
+	const uint32_t First = m_iBufferPtr;
 	while (m_iBufferPtr < WantSamples) {
-		int32_t RawSample = OPLL_calc(m_pOPLLInt);
-
 		// emu2413's waveform output ranges from -4095...4095
 		// fully rectified by abs(), so resulting waveform is around 0-4095
+		m_pRawBuffer[m_iBufferPtr++] = OPLL_calc(m_pOPLLInt);
 		for (int i = 0; i < 9; i++)
 			m_ChannelLevels[i].update(static_cast<uint8_t>((255.0 * (OPLL_getchanvol(i) + 1.0)/4096.0)));
-
-		// Apply direct volume, hacky workaround
-		int32_t Sample = static_cast<int32_t>(double(RawSample) * m_DirectVolume);
-
-		if (Sample > 32767)
-			Sample = 32767;
-		if (Sample < -32768)
-			Sample = -32768;
-
-		m_pBuffer[m_iBufferPtr++] = int16_t((Sample + LastSample) >> 1);
-		LastSample = Sample;
 	}
 
+	// Apply direct volume, hacky workaround
+	if (m_iBufferPtr > First)
+		PostFilter::ScaleAverage(m_pRawBuffer + First, m_pBuffer + First, m_iBufferPtr - First, m_DirectVolume, m_iLastSample);
+
 	Output.mix_samples((blip_amplitude_t*)m_pBuffer, WantSamples);
 
 	m_iBufferPtr -= WantSamples;
@@ -172,7 +254,7 @@ double COPLL::GetFreq(int Channel) const		// // //
 
 int COPLL::GetChannelLevel(int Channel)
 {
-	ASSERT(0 <= Channel && Channel < 9);
+	assert(0 <= Channel && Channel < 9);
 	if (0 <= Channel && Channel < 9) {
 		return m_ChannelLevels[Channel].getLevel();
 	}
@@ -194,8 +276,9 @@ void COPLL::UpdateMixLevel(double v, bool UseSurveyMix)
 	// hacky solution, since OPLL uses asynchronous direct buffer writes
 	SetDirectVolume(UseSurveyMix ? v : (v * AMPLIFY));
 	
-	// emu2413's waveform output ranges from -4095...4095
-	m_SynthOPLL.volume(v, UseSurveyMix ? 8191 : 10000);
+	// // // The native rate mode sends the same scaled output through m_SynthOPLL instead,
+	// in units of 16-bit audio. A power of two keeps Blip_Synth's delta factor exact.
+	m_SynthOPLL.volume(1.0, 65536);
 }
 
 void COPLL::UpdatePatchSet(int PatchSelection, bool UseExternalOPLLChip, uint8_t* PatchSet)
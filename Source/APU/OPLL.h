@@ -39,12 +39,15 @@ public:
 
 	void Write(uint16_t Address, uint8_t Value) override;
 	uint8_t Read(uint16_t Address, bool& Mapped) override;
+	void SetChannelMask(uint32_t Mask) override;
 
 	double GetFreq(int Channel) const override;		// // //
 	int GetChannelLevel(int Channel) override;
 	int GetChannelLevelRange(int Channel) const override;
+	void SerializeState(CStateArchive &State) override;		// // //
 
 	void SetSampleSpeed(uint32_t SampleRate, double ClockRate, uint32_t FrameRate);
+	void SetNativeRate(bool Enable);		// // //
 	void SetDirectVolume(double Volume);
 	void Log(uint16_t Address, uint8_t Value) override;		// // //
 
@@ -55,6 +58,7 @@ public:
 protected:
 	static const float  AMPLIFY;
 	static const uint32_t OPLL_CLOCK;
+	static const uint32_t OPLL_RATE;		// // // emu2413 output rate without its own resampler
 
 private:
 	OPLL		*m_pOPLLInt = NULL;
@@ -62,12 +66,22 @@ private:
 	uint32_t	m_iMaxSamples = 0;
 
 	int16_t		*m_pBuffer = NULL;
+	int32_t		*m_pRawBuffer = NULL;		// emu2413 output, before ScaleAverage
 	uint32_t	m_iBufferPtr;
+	int32_t		m_iLastSample = 0;		// Previous output sample, for the 2-tap lowpass
+	uint32_t	m_iChannelMask = 0;		// Silenced channels, OPLL_reset() clears the emulator's mask
 
 	uint8_t		m_iSoundReg = 0;
 
 	double		m_DirectVolume = 1.0f;
 
+	// // // Native rate mode: emu2413 runs at OPLL_RATE during Process(), between the
+	// register writes, and its output goes through m_BlipOPLL
+	bool		m_bNativeRate = false;
+	uint32_t	m_iSampleRate = 0;
+	uint32_t	m_iCPUClock = 0;
+	uint64_t	m_iNativePhase = 0;		// OPLL_CLOCK per CPU cycle, a sample is due every 72 * m_iCPUClock
+
 	// OPLL chip type
 	bool m_UseExternalOPLLChip = false;
 	// default OPLL patchset
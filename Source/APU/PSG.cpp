@@ -0,0 +1,363 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+#include <algorithm>
+#include "APU.h"
+#include "PSG.h"
+#include "S5B.h"
+#include "AY.h"
+#include "YM2149F.h"
+#include "AY8930.h"
+#include "StateArchive.h"
+#include "../RegisterState.h"
+
+// // // AY-3-8910 family core
+
+namespace {
+
+// Number of high steps out of 32 for each AY8930 duty cycle register value
+const uint8_t DUTY_WIDTH[16] = {
+	1, 2, 4, 8, 16, 24, 28, 30, 31, 31, 31, 31, 31, 31, 31, 31,
+};
+
+// Writes the low or high byte of a period counted in 1 << Shift cycles,
+// HighMask being the valid bits of the high byte
+inline void WritePeriodLow(uint32_t &Period, uint8_t Value, unsigned Shift, uint32_t HighMask)
+{
+	Period = (Period & (HighMask << (Shift + 8))) | (Value << Shift);
+}
+
+inline void WritePeriodHigh(uint32_t &Period, uint8_t Value, unsigned Shift, uint32_t HighMask)
+{
+	Period = (Period & (0xFFu << Shift)) | ((Value & HighMask) << (Shift + 8));
+}
+
+} // namespace
+
+template <typename Traits>
+CPSG<Traits>::CPSG(CMixer *pMixer) : CSoundChip(pMixer),
+	m_Tone(),
+	m_Envelope(),
+	m_cPort(0),
+	m_iTime(0)
+{
+	m_pRegisterLogger->AddRegisterRange(0x00, Traits::EXTENDED ? 0x1F : 0x0F);		// // //
+	Reset();
+}
+
+template <typename Traits>
+void CPSG<Traits>::Reset()
+{
+	m_iNoiseState = Traits::EXTENDED ? 0x1FFFF : 0xFFFF;
+	m_iNoisePeriod = (Traits::EXTENDED ? 0xFF : 0x1F) << 5;
+	m_iNoiseClock = 0;
+	m_iNoiseValue = 0;
+	m_iNoiseLatch = 0;
+	m_iNoiseANDMask = 0xFF;
+	m_iNoiseORMask = 0x00;
+
+	for (auto &Env : m_Envelope) {
+		Env.Period = 0;
+		Env.Clock = 0;
+		Env.Level = 0;
+		Env.Shape = 0;
+		Env.Hold = true;
+	}
+
+	for (auto &Chan : m_Tone) {
+		Chan.Volume = 0;
+		Chan.Period = 0;
+		Chan.PeriodClock = 0;
+		Chan.Step = 0;
+		Chan.DutyCycle = 0;
+		Chan.SquareDisable = true;
+		Chan.NoiseDisable = true;
+	}
+}
+
+template <typename Traits>
+void CPSG<Traits>::Process(uint32_t Time)
+{
+	// // // Writes since the last call take effect at their own cycle, not at the next event
+	const bool Noise = ((Traits::EXTENDED ? m_iNoiseLatch : m_iNoiseState) & 0x01) != 0;
+	for (int i = 0; i < 3; ++i)
+		Output(i, Noise);
+
+	while (Time > 0U) {
+		// Time to the next event of any generator. A counter already past its period,
+		// which a write can cause, fires right away, so that events never depend on
+		// where Process() is split.
+		uint32_t TimeToRun = Time;
+		for (const auto &Env : m_Envelope)
+			if (Env.Period)
+				TimeToRun = std::min(Env.Clock < Env.Period ? Env.Period - Env.Clock : 0U, TimeToRun);
+		if constexpr (Traits::EXTENDED)		// Twice as fast, see RunNoise()
+			TimeToRun = std::min(m_iNoiseClock < m_iNoisePeriod ? (m_iNoisePeriod - m_iNoiseClock + 1) / 2 : 0U, TimeToRun);
+		else
+			TimeToRun = std::min(m_iNoiseClock < m_iNoisePeriod ? m_iNoisePeriod - m_iNoiseClock : 0U, TimeToRun);
+		for (const auto &Chan : m_Tone)
+			if (Chan.Period >= 2U && Chan.Volume)
+				TimeToRun = std::min(Chan.PeriodClock < Chan.Period ? Chan.Period - Chan.PeriodClock : 0U, TimeToRun);
+
+		Time -= TimeToRun;
+		m_iTime += TimeToRun;
+
+		for (auto &Env : m_Envelope)
+			RunEnvelope(Env, TimeToRun);
+		RunNoise(TimeToRun);
+		for (auto &Chan : m_Tone)
+			RunTone(Chan, TimeToRun);
+
+		const bool Noise = ((Traits::EXTENDED ? m_iNoiseLatch : m_iNoiseState) & 0x01) != 0;
+		for (int i = 0; i < 3; ++i)
+			Output(i, Noise);
+	}
+}
+
+template <typename Traits>
+void CPSG<Traits>::Output(int Channel, bool Noise)
+{
+	stTone &Chan = m_Tone[Channel];
+	const stEnvelope &Env = m_Envelope[Traits::EXTENDED ? Channel : 0];
+
+	const int Level = ((Chan.Volume & 0x20) ? Env.Level : Chan.Volume) & 0x1F;
+	int32_t Value = Traits::VOLUME[Level];
+	const bool SquareHigh = Traits::EXTENDED ? Chan.Step < DUTY_WIDTH[Chan.DutyCycle & 0x0F] : Chan.Step != 0;
+	if (!Chan.SquareDisable && !SquareHigh && Chan.Period >= 2U)
+		Value = 0;
+	if (!Chan.NoiseDisable && !Noise)
+		Value = 0;
+	if (Traits::INVERTED)
+		Value = -Value;
+
+	if (const int32_t Delta = Value - Chan.LastValue)
+		m_pMixer->AddValue(Traits::CHANNEL + Channel, Traits::CHIP, Delta, Value, m_iTime);
+	Chan.LastValue = Value;
+}
+
+template <typename Traits>
+void CPSG<Traits>::EndFrame()
+{
+	m_iTime = 0;
+}
+
+template <typename Traits>
+void CPSG<Traits>::Write(uint16_t Address, uint8_t Value)
+{
+	switch (Address) {
+	case Traits::PORT:
+		m_cPort = Value & (Traits::EXTENDED ? 0x1F : 0x0F);
+		break;
+	case Traits::PORT + 0x2000:
+		WriteReg(m_cPort, Value);
+		break;
+	}
+}
+
+template <typename Traits>
+uint8_t CPSG<Traits>::Read(uint16_t Address, bool &Mapped)
+{
+	Mapped = false;
+	return 0U;
+}
+
+template <typename Traits>
+double CPSG<Traits>::GetFreq(int Channel) const		// // //
+{
+	if (Channel >= 0 && Channel < 3) {
+		const stTone &Chan = m_Tone[Channel];
+		if (Chan.SquareDisable || !Chan.Period)
+			return 0.;
+		return CAPU::BASE_FREQ_NTSC / 2. / (Chan.Period << (4 - Traits::TONE_SHIFT));
+	}
+	if (Channel >= 3 && Channel < 3 + ENVELOPES) {
+		const stEnvelope &Env = m_Envelope[Channel - 3];
+		if (!Env.Period)
+			return 0.;
+		if (!(Env.Shape & 0x08) || (Env.Shape & 0x01))
+			return 0.;
+		return CAPU::BASE_FREQ_NTSC / ((Env.Shape & 0x02) ? 64. : 32.) / Env.Period;
+	}
+	//TODO noise refresh rate
+	return 0.;
+}
+
+template <typename Traits>
+void CPSG<Traits>::WriteReg(uint8_t Port, uint8_t Value)
+{
+	const uint32_t TONE_HIGH_MASK = Traits::EXTENDED ? 0xFF : 0x0F;
+
+	switch (Port) {
+	case 0x00: case 0x02: case 0x04:
+		WritePeriodLow(m_Tone[Port >> 1].Period, Value, Traits::TONE_SHIFT, TONE_HIGH_MASK);
+		break;
+	case 0x01: case 0x03: case 0x05:
+		WritePeriodHigh(m_Tone[Port >> 1].Period, Value, Traits::TONE_SHIFT, TONE_HIGH_MASK);
+		break;
+	case 0x06:
+		m_iNoisePeriod = Value ? ((Value & (Traits::EXTENDED ? 0xFF : 0x1F)) << 5) : 0x10;
+		break;
+	case 0x07:
+		for (int i = 0; i < 3; ++i) {
+			m_Tone[i].SquareDisable = (Value & (1 << i)) != 0;
+			m_Tone[i].NoiseDisable = (Value & (1 << (i + 3))) != 0;
+		}
+		break;
+	case 0x08: case 0x09: case 0x0A:
+		m_Tone[Port - 0x08].Volume = Traits::EXTENDED ? Value : Value * 2;
+		break;
+	case 0x0B:
+		WritePeriodLow(m_Envelope[0].Period, Value, Traits::ENVELOPE_SHIFT, 0xFF);
+		break;
+	case 0x0C:
+		WritePeriodHigh(m_Envelope[0].Period, Value, Traits::ENVELOPE_SHIFT, 0xFF);
+		break;
+	case 0x0D:
+		TriggerEnvelope(m_Envelope[0], Value);
+		break;
+	}
+
+	if constexpr (Traits::EXTENDED) {
+		switch (Port) {
+		case 0x10: case 0x12:
+			WritePeriodLow(m_Envelope[(Port - 0x0E) >> 1].Period, Value, Traits::ENVELOPE_SHIFT, 0xFF);
+			break;
+		case 0x11: case 0x13:
+			WritePeriodHigh(m_Envelope[(Port - 0x0E) >> 1].Period, Value, Traits::ENVELOPE_SHIFT, 0xFF);
+			break;
+		case 0x14: case 0x15:
+			TriggerEnvelope(m_Envelope[Port - 0x13], Value);
+			break;
+		case 0x16: case 0x17: case 0x18:
+			m_Tone[Port - 0x16].DutyCycle = Value;
+			break;
+		case 0x19:
+			m_iNoiseANDMask = Value;
+			break;
+		case 0x1A:
+			m_iNoiseORMask = Value;
+			break;
+		}
+	}
+}
+
+template <typename Traits>
+void CPSG<Traits>::Log(uint16_t Address, uint8_t Value)		// // //
+{
+	switch (Address) {
+	case Traits::PORT: m_pRegisterLogger->SetPort(Value); break;
+	case Traits::PORT + 0x2000: m_pRegisterLogger->Write(Value); break;
+	}
+}
+
+template <typename Traits>
+void CPSG<Traits>::RunTone(stTone &Chan, uint32_t Time)
+{
+	// // // Silent channels are not stopped at, so they may go through several periods here
+	const uint32_t Period = std::max(Chan.Period, 1U);
+	if (Chan.PeriodClock >= Period) {
+		Chan.PeriodClock = 0;
+		++Chan.Step;
+	}
+	Chan.PeriodClock += Time;
+	if (Chan.PeriodClock >= Period) {
+		Chan.Step += static_cast<uint8_t>(Chan.PeriodClock / Period);
+		Chan.PeriodClock %= Period;
+	}
+	Chan.Step &= Traits::EXTENDED ? 0x1F : 0x01;
+}
+
+template <typename Traits>
+void CPSG<Traits>::TriggerEnvelope(stEnvelope &Env, uint8_t Shape)
+{
+	Env.Clock = 0;
+	Env.Shape = Shape;
+	Env.Hold = false;
+	Env.Level = (Shape & 0x04) ? 0 : 0x1F;
+}
+
+template <typename Traits>
+void CPSG<Traits>::RunEnvelope(stEnvelope &Env, uint32_t Time)
+{
+	Env.Clock += Time;
+	if (Env.Clock >= Env.Period && Env.Period) {
+		Env.Clock = 0;
+		if (!Env.Hold) {
+			Env.Level += (Env.Shape & 0x04) ? 1 : -1;
+			Env.Level &= 0x3F;
+		}
+		if (Env.Level & 0x20) {
+			if (Env.Shape & 0x08) {
+				if ((Env.Shape & 0x03) == 0x01 || (Env.Shape & 0x03) == 0x02)
+					Env.Shape ^= 0x04;
+				if (Env.Shape & 0x01)
+					Env.Hold = true;
+				Env.Level = (Env.Shape & 0x04) ? 0 : 0x1F;
+			}
+			else {
+				Env.Hold = true;
+				Env.Level = 0;
+			}
+		}
+	}
+}
+
+template <typename Traits>
+void CPSG<Traits>::SerializeState(CStateArchive &State)
+{
+	CSoundChip::SerializeState(State);
+	State(m_Tone, m_Envelope, m_cPort, m_iTime, m_iNoisePeriod, m_iNoiseClock, m_iNoiseState,
+		m_iNoiseValue, m_iNoiseLatch, m_iNoiseANDMask, m_iNoiseORMask);
+}
+
+template <typename Traits>
+void CPSG<Traits>::RunNoise(uint32_t Time)
+{
+	if constexpr (Traits::EXTENDED) {
+		m_iNoiseClock += Time * 2;
+		while (m_iNoiseClock >= m_iNoisePeriod) {
+			m_iNoiseClock -= m_iNoisePeriod;
+			if (m_iNoiseValue >= ((m_iNoiseState & 0xFF & m_iNoiseANDMask) | m_iNoiseORMask)) {
+				m_iNoiseValue = 0;
+				m_iNoiseLatch ^= 1;
+
+				// credits to Enfau
+				const uint32_t Feedback = (m_iNoiseState & 1) ^ ((m_iNoiseState >> 2) & 1);
+				m_iNoiseState >>= 1;
+				m_iNoiseState |= Feedback << 16;
+			}
+			m_iNoiseValue += 1;
+		}
+	}
+	else {
+		m_iNoiseClock += Time;
+		if (m_iNoiseClock >= m_iNoisePeriod) {
+			m_iNoiseClock = 0;
+			if (m_iNoiseState & 0x01)
+				m_iNoiseState ^= 0x24000;
+			m_iNoiseState >>= 1;
+		}
+	}
+}
+
+template class CPSG<CS5BTraits>;
+template class CPSG<CAYTraits>;
+template class CPSG<CYM2149FTraits>;
+template class CPSG<CAY8930Traits>;
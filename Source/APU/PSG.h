@@ -0,0 +1,118 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#pragma once
+
+#include "SoundChip.h"
+#include "Types.h"
+
+// // // AY-3-8910 family core, shared by the 5B, AY-3-8910, YM2149F and AY8930
+
+/// Defaults for the traits of CPSG. A variant derives from this and provides
+/// CHIP, CHANNEL, PORT and VOLUME, overriding the rest where it differs:
+///
+/// - CHIP: SNDCHIP_ value passed to the mixer.
+/// - CHANNEL: ID of the first of the three tone channels.
+/// - PORT: address of the register select port. The data port is PORT + 0x2000.
+/// - VOLUME: output level of each of the 32 volume / envelope steps.
+struct CPSGTraits {
+	/// Tone periods count in units of 1 << TONE_SHIFT CPU cycles (the clock divider).
+	static constexpr unsigned TONE_SHIFT = 4;
+	/// Envelope periods count in units of 1 << ENVELOPE_SHIFT CPU cycles.
+	static constexpr unsigned ENVELOPE_SHIFT = 4;
+	/// The chip output is negated before mixing.
+	static constexpr bool INVERTED = true;
+	/// AY8930 expanded mode: 5-bit volumes, 16-bit tone periods, duty cycles,
+	/// one envelope per channel, and noise with AND / OR masks.
+	static constexpr bool EXTENDED = false;
+};
+
+/// Three tone channels, noise and envelope of an AY-3-8910-style PSG.
+///
+/// Process() advances straight to the next tone, noise or envelope event of any
+/// channel, steps every generator over that time and mixes the three outputs.
+/// All variant differences are compile-time constants of Traits, so each variant
+/// gets its own copy of that loop without any virtual calls in it.
+template <typename Traits>
+class CPSG : public CSoundChip
+{
+public:
+	CPSG(CMixer *pMixer);
+
+	void	Reset() override;
+	void	Process(uint32_t Time) override;
+	void	EndFrame() override;
+
+	void	Write(uint16_t Address, uint8_t Value) override;
+	uint8_t	Read(uint16_t Address, bool &Mapped) override;
+	void	Log(uint16_t Address, uint8_t Value) override;		// // //
+
+	double	GetFreq(int Channel) const override;		// // //
+	void	SerializeState(CStateArchive &State) override;		// // //
+
+private:
+	static constexpr int ENVELOPES = Traits::EXTENDED ? 3 : 1;
+
+	struct stTone {
+		uint8_t Volume;
+		uint32_t Period;
+		uint32_t PeriodClock;
+		uint8_t Step;			// Square phase, or position in the 32-step duty cycle when extended
+		uint8_t DutyCycle;
+		bool SquareDisable;
+		bool NoiseDisable;
+		int32_t LastValue;		// Last value sent to the mixer
+	};
+
+	struct stEnvelope {
+		uint32_t Period;
+		uint32_t Clock;
+		int Level;
+		uint8_t Shape;
+		bool Hold;
+	};
+
+	void	WriteReg(uint8_t Port, uint8_t Value);
+	void	RunNoise(uint32_t Time);
+	void	Output(int Channel, bool Noise);
+
+	static void	RunTone(stTone &Chan, uint32_t Time);		// // //
+	static void	TriggerEnvelope(stEnvelope &Env, uint8_t Shape);
+	static void	RunEnvelope(stEnvelope &Env, uint32_t Time);
+
+private:
+	stTone m_Tone[3];
+	stEnvelope m_Envelope[ENVELOPES];
+
+	uint8_t m_cPort;
+
+	uint32_t m_iTime;				// Cycle counter, resets every new frame
+
+	uint32_t m_iNoisePeriod;
+	uint32_t m_iNoiseClock;
+	uint32_t m_iNoiseState;
+
+	// Extended noise
+	uint32_t m_iNoiseValue;
+	uint32_t m_iNoiseLatch;
+	uint32_t m_iNoiseANDMask;
+	uint32_t m_iNoiseORMask;
+};
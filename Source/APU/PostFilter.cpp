@@ -0,0 +1,326 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+#include "PostFilter.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(SIMD_HAS_SSE2) || defined(SIMD_HAS_AVX2)
+#include <immintrin.h>
+#endif
+#ifdef SIMD_HAS_NEON
+#include <arm_neon.h>
+#endif
+
+// The lowpass recurrence is inherently serial, so it always runs as the same scalar
+// loop. The kernels only vectorize the conversions around it: int16 to float on the
+// way in and round-half-away-from-zero (roundf) back to int16 on the way out.
+// ScaleAverage has no recurrence and is vectorized whole; it clamps in the double
+// domain before truncating, which gives the same result as truncating first.
+
+namespace {
+
+const std::size_t BLOCK_SIZE = 256;		// Samples converted per lowpass block
+
+struct stKernels {
+	void (*ToFloat)(const int16_t *pIn, float *pOut, std::size_t Count);
+	void (*FromFloat)(const float *pIn, int16_t *pOut, std::size_t Count);
+	void (*ScaleAverage)(const int32_t *pIn, int16_t *pOut, std::size_t Count, double Gain, int32_t &Last);
+};
+
+// // // Scalar
+
+void ToFloatScalar(const int16_t *pIn, float *pOut, std::size_t Count)
+{
+	for (std::size_t i = 0; i < Count; ++i)
+		pOut[i] = float(pIn[i]);
+}
+
+void FromFloatScalar(const float *pIn, int16_t *pOut, std::size_t Count)
+{
+	for (std::size_t i = 0; i < Count; ++i)
+		pOut[i] = (int16_t)roundf(pIn[i]);
+}
+
+void ScaleAverageScalar(const int32_t *pIn, int16_t *pOut, std::size_t Count, double Gain, int32_t &Last)
+{
+	for (std::size_t i = 0; i < Count; ++i) {
+		int32_t Sample = static_cast<int32_t>(double(pIn[i]) * Gain);
+
+		if (Sample > 32767)
+			Sample = 32767;
+		if (Sample < -32768)
+			Sample = -32768;
+
+		pOut[i] = int16_t((Sample + Last) >> 1);
+		Last = Sample;
+	}
+}
+
+// // // SSE2
+
+#ifdef SIMD_HAS_SSE2
+
+void ToFloatSSE2(const int16_t *pIn, float *pOut, std::size_t Count)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= Count; i += 8) {
+		const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pIn + i));
+		const __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+		const __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+		_mm_storeu_ps(pOut + i, _mm_cvtepi32_ps(lo));
+		_mm_storeu_ps(pOut + i + 4, _mm_cvtepi32_ps(hi));
+	}
+	ToFloatScalar(pIn + i, pOut + i, Count - i);
+}
+
+/// roundf() of four floats in the int16 range.
+inline __m128i RoundSSE2(__m128 x)
+{
+	const __m128i t = _mm_cvttps_epi32(x);
+	const __m128 Frac = _mm_sub_ps(x, _mm_cvtepi32_ps(t));		// exact
+	const __m128i Up = _mm_castps_si128(_mm_cmpge_ps(Frac, _mm_set1_ps(0.5f)));
+	const __m128i Down = _mm_castps_si128(_mm_cmple_ps(Frac, _mm_set1_ps(-0.5f)));
+	return _mm_add_epi32(_mm_sub_epi32(t, Up), Down);
+}
+
+void FromFloatSSE2(const float *pIn, int16_t *pOut, std::size_t Count)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= Count; i += 8) {
+		const __m128i lo = RoundSSE2(_mm_loadu_ps(pIn + i));
+		const __m128i hi = RoundSSE2(_mm_loadu_ps(pIn + i + 4));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(pOut + i), _mm_packs_epi32(lo, hi));
+	}
+	FromFloatScalar(pIn + i, pOut + i, Count - i);
+}
+
+/// Scales, clamps and truncates four samples.
+inline __m128i ScaleClampSSE2(__m128i x, __m128d Gain)
+{
+	const __m128d Min = _mm_set1_pd(-32768.0);
+	const __m128d Max = _mm_set1_pd(32767.0);
+	const __m128d lo = _mm_mul_pd(_mm_cvtepi32_pd(x), Gain);
+	const __m128d hi = _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(x, 0xEE)), Gain);
+	return _mm_unpacklo_epi64(
+		_mm_cvttpd_epi32(_mm_max_pd(_mm_min_pd(lo, Max), Min)),
+		_mm_cvttpd_epi32(_mm_max_pd(_mm_min_pd(hi, Max), Min)));
+}
+
+void ScaleAverageSSE2(const int32_t *pIn, int16_t *pOut, std::size_t Count, double Gain, int32_t &Last)
+{
+	const __m128d g = _mm_set1_pd(Gain);
+	__m128i Prev = _mm_cvtsi32_si128(Last);		// Previous sample in lane 0
+	std::size_t i = 0;
+	for (; i + 8 <= Count; i += 8) {
+		const __m128i s0 = ScaleClampSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pIn + i)), g);
+		const __m128i s1 = ScaleClampSSE2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pIn + i + 4)), g);
+		const __m128i p0 = _mm_or_si128(_mm_slli_si128(s0, 4), Prev);
+		const __m128i p1 = _mm_or_si128(_mm_slli_si128(s1, 4), _mm_srli_si128(s0, 12));
+		const __m128i a0 = _mm_srai_epi32(_mm_add_epi32(s0, p0), 1);
+		const __m128i a1 = _mm_srai_epi32(_mm_add_epi32(s1, p1), 1);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(pOut + i), _mm_packs_epi32(a0, a1));
+		Prev = _mm_srli_si128(s1, 12);
+	}
+	Last = _mm_cvtsi128_si32(Prev);
+	ScaleAverageScalar(pIn + i, pOut + i, Count - i, Gain, Last);
+}
+
+#endif
+
+// // // AVX2
+
+#ifdef SIMD_HAS_AVX2
+
+SIMD_TARGET_AVX2 void ToFloatAVX2(const int16_t *pIn, float *pOut, std::size_t Count)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= Count; i += 8) {
+		const __m256i x = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(pIn + i)));
+		_mm256_storeu_ps(pOut + i, _mm256_cvtepi32_ps(x));
+	}
+	ToFloatScalar(pIn + i, pOut + i, Count - i);
+}
+
+SIMD_TARGET_AVX2 void FromFloatAVX2(const float *pIn, int16_t *pOut, std::size_t Count)
+{
+	const __m256 Half = _mm256_set1_ps(0.5f);
+	const __m256 NegHalf = _mm256_set1_ps(-0.5f);
+	std::size_t i = 0;
+	for (; i + 8 <= Count; i += 8) {
+		const __m256 x = _mm256_loadu_ps(pIn + i);
+		const __m256i t = _mm256_cvttps_epi32(x);
+		const __m256 Frac = _mm256_sub_ps(x, _mm256_cvtepi32_ps(t));
+		const __m256i Up = _mm256_castps_si256(_mm256_cmp_ps(Frac, Half, _CMP_GE_OQ));
+		const __m256i Down = _mm256_castps_si256(_mm256_cmp_ps(Frac, NegHalf, _CMP_LE_OQ));
+		const __m256i r = _mm256_add_epi32(_mm256_sub_epi32(t, Up), Down);
+		const __m256i Packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(r, r), 0x08);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(pOut + i), _mm256_castsi256_si128(Packed));
+	}
+	FromFloatScalar(pIn + i, pOut + i, Count - i);
+}
+
+SIMD_TARGET_AVX2 void ScaleAverageAVX2(const int32_t *pIn, int16_t *pOut, std::size_t Count, double Gain, int32_t &Last)
+{
+	const __m256d g = _mm256_set1_pd(Gain);
+	const __m256d Min = _mm256_set1_pd(-32768.0);
+	const __m256d Max = _mm256_set1_pd(32767.0);
+	const __m256i Rotate = _mm256_setr_epi32(7, 0, 1, 2, 3, 4, 5, 6);
+	__m256i Prev = _mm256_set1_epi32(Last);		// Previous sample in every lane
+	std::size_t i = 0;
+	for (; i + 8 <= Count; i += 8) {
+		const __m128i x0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pIn + i));
+		const __m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pIn + i + 4));
+		const __m256d d0 = _mm256_max_pd(_mm256_min_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(x0), g), Max), Min);
+		const __m256d d1 = _mm256_max_pd(_mm256_min_pd(_mm256_mul_pd(_mm256_cvtepi32_pd(x1), g), Max), Min);
+		const __m256i s = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm256_cvttpd_epi32(d0)), _mm256_cvttpd_epi32(d1), 1);
+		const __m256i p = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(s, Rotate), Prev, 0x01);
+		const __m256i a = _mm256_srai_epi32(_mm256_add_epi32(s, p), 1);
+		const __m256i Packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, a), 0x08);
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(pOut + i), _mm256_castsi256_si128(Packed));
+		Prev = _mm256_permutevar8x32_epi32(s, _mm256_set1_epi32(7));
+	}
+	Last = _mm_cvtsi128_si32(_mm256_castsi256_si128(Prev));
+	ScaleAverageScalar(pIn + i, pOut + i, Count - i, Gain, Last);
+}
+
+#endif
+
+// // // NEON
+
+#ifdef SIMD_HAS_NEON
+
+void ToFloatNEON(const int16_t *pIn, float *pOut, std::size_t Count)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= Count; i += 8) {
+		const int16x8_t x = vld1q_s16(pIn + i);
+		vst1q_f32(pOut + i, vcvtq_f32_s32(vmovl_s16(vget_low_s16(x))));
+		vst1q_f32(pOut + i + 4, vcvtq_f32_s32(vmovl_s16(vget_high_s16(x))));
+	}
+	ToFloatScalar(pIn + i, pOut + i, Count - i);
+}
+
+void FromFloatNEON(const float *pIn, int16_t *pOut, std::size_t Count)
+{
+	std::size_t i = 0;
+	for (; i + 8 <= Count; i += 8) {
+		const int32x4_t lo = vcvtaq_s32_f32(vld1q_f32(pIn + i));		// ties away from zero, like roundf
+		const int32x4_t hi = vcvtaq_s32_f32(vld1q_f32(pIn + i + 4));
+		vst1q_s16(pOut + i, vcombine_s16(vqmovn_s32(lo), vqmovn_s32(hi)));
+	}
+	FromFloatScalar(pIn + i, pOut + i, Count - i);
+}
+
+inline int32x4_t ScaleClampNEON(int32x4_t x, float64x2_t Gain)
+{
+	const float64x2_t Min = vdupq_n_f64(-32768.0);
+	const float64x2_t Max = vdupq_n_f64(32767.0);
+	const float64x2_t lo = vmulq_f64(vcvtq_f64_s64(vmovl_s32(vget_low_s32(x))), Gain);
+	const float64x2_t hi = vmulq_f64(vcvtq_f64_s64(vmovl_high_s32(x)), Gain);
+	return vcombine_s32(
+		vmovn_s64(vcvtq_s64_f64(vmaxq_f64(vminq_f64(lo, Max), Min))),
+		vmovn_s64(vcvtq_s64_f64(vmaxq_f64(vminq_f64(hi, Max), Min))));
+}
+
+void ScaleAverageNEON(const int32_t *pIn, int16_t *pOut, std::size_t Count, double Gain, int32_t &Last)
+{
+	const float64x2_t g = vdupq_n_f64(Gain);
+	int32x4_t Prev = vdupq_n_s32(Last);		// Previous sample in lane 3
+	std::size_t i = 0;
+	for (; i + 8 <= Count; i += 8) {
+		const int32x4_t s0 = ScaleClampNEON(vld1q_s32(pIn + i), g);
+		const int32x4_t s1 = ScaleClampNEON(vld1q_s32(pIn + i + 4), g);
+		const int32x4_t a0 = vshrq_n_s32(vaddq_s32(s0, vextq_s32(Prev, s0, 3)), 1);
+		const int32x4_t a1 = vshrq_n_s32(vaddq_s32(s1, vextq_s32(s0, s1, 3)), 1);
+		vst1q_s16(pOut + i, vcombine_s16(vqmovn_s32(a0), vqmovn_s32(a1)));
+		Prev = s1;
+	}
+	Last = vgetq_lane_s32(Prev, 3);
+	ScaleAverageScalar(pIn + i, pOut + i, Count - i, Gain, Last);
+}
+
+#endif
+
+const stKernels &GetKernels(simd_t Level)
+{
+	static const stKernels KERNELS[SIMD_COUNT] = {
+		{ToFloatScalar, FromFloatScalar, ScaleAverageScalar},
+#ifdef SIMD_HAS_SSE2
+		{ToFloatSSE2, FromFloatSSE2, ScaleAverageSSE2},
+#else
+		{ToFloatScalar, FromFloatScalar, ScaleAverageScalar},
+#endif
+#ifdef SIMD_HAS_AVX2
+		{ToFloatAVX2, FromFloatAVX2, ScaleAverageAVX2},
+#else
+		{ToFloatScalar, FromFloatScalar, ScaleAverageScalar},
+#endif
+#ifdef SIMD_HAS_NEON
+		{ToFloatNEON, FromFloatNEON, ScaleAverageNEON},
+#else
+		{ToFloatScalar, FromFloatScalar, ScaleAverageScalar},
+#endif
+	};
+	assert(IsSimdSupported(Level));
+	return KERNELS[Level];
+}
+
+} // namespace
+
+namespace PostFilter {
+
+void Lowpass(simd_t Level, gsl::span<int16_t> Data, float Alpha, float &State)
+{
+	const stKernels &k = GetKernels(Level);
+	float Block[BLOCK_SIZE];
+	float s = State;
+
+	for (std::size_t Pos = 0, Size = Data.size(); Pos < Size; Pos += BLOCK_SIZE) {
+		const std::size_t Count = std::min(BLOCK_SIZE, Size - Pos);
+		k.ToFloat(Data.data() + Pos, Block, Count);
+		for (std::size_t i = 0; i < Count; ++i) {
+			float out = s + Alpha * (Block[i] - s);
+			Block[i] = out;
+			s = out + 1e-18f;  // prevent denormal numbers
+		}
+		k.FromFloat(Block, Data.data() + Pos, Count);
+	}
+
+	State = s;
+}
+
+void ScaleAverage(simd_t Level, const int32_t *pIn, int16_t *pOut, std::size_t Count, double Gain, int32_t &Last)
+{
+	GetKernels(Level).ScaleAverage(pIn, pOut, Count, Gain, Last);
+}
+
+void Lowpass(gsl::span<int16_t> Data, float Alpha, float &State)
+{
+	Lowpass(GetSimdLevel(), Data, Alpha, State);
+}
+
+void ScaleAverage(const int32_t *pIn, int16_t *pOut, std::size_t Count, double Gain, int32_t &Last)
+{
+	ScaleAverage(GetSimdLevel(), pIn, pOut, Count, Gain, Last);
+}
+
+} // namespace PostFilter
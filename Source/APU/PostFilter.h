@@ -0,0 +1,51 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "gsl/span"
+#include "Simd.h"
+
+/// Block filters run over a frame of chip output before it is mixed.
+///
+/// Each function processes a whole frame and dispatches to the kernels of
+/// GetSimdLevel(). The output is bit-identical at every level, and identical to
+/// the per-sample loops the chips used to run.
+namespace PostFilter {
+
+/// One-pole lowpass over Data, in place:
+/// y[n] = round(s + Alpha * (x[n] - s)), with s = y'[n - 1] + 1e-18f, where y' is the unrounded output.
+/// State holds s across calls. Used by the FDS and N163.
+void Lowpass(gsl::span<int16_t> Data, float Alpha, float &State);
+
+/// Scales raw emulator output by Gain, clamps it to 16 bits and averages every
+/// sample with the previous one: y[n] = (clamp(int(x[n] * Gain)) + clamp(int(x[n - 1] * Gain))) >> 1.
+/// Last holds the previous clamped sample across calls. Used by the VRC7 and OPLL.
+void ScaleAverage(const int32_t *pIn, int16_t *pOut, std::size_t Count, double Gain, int32_t &Last);
+
+/// Same as above, with the kernels of Level instead of GetSimdLevel().
+/// Level must be supported (see IsSimdSupported).
+void Lowpass(simd_t Level, gsl::span<int16_t> Data, float Alpha, float &State);
+void ScaleAverage(simd_t Level, const int32_t *pIn, int16_t *pOut, std::size_t Count, double Gain, int32_t &Last);
+
+} // namespace PostFilter
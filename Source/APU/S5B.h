@@ -21,71 +21,29 @@
 
 #pragma once
 
-#include "SoundChip.h"
-#include "Channel.h"
+#include "PSG.h"
 
 // // // 050B
-
-class CS5BChannel : public CChannel
-{
-public:
-	friend class CS5B;
-
-	CS5BChannel(CMixer *pMixer, uint8_t ID);
-	
-	void Process(uint32_t Time);
-	void Reset();
-
-	uint32_t GetTime();
-	void Output(uint32_t Noise, uint32_t Envelope);
-
-	double GetFrequency() const override;
-
-private:
-	uint8_t m_iVolume;
-	uint32_t m_iPeriod;
-	uint32_t m_iPeriodClock;
-
-	bool m_bSquareHigh;
-	bool m_bSquareDisable;
-	bool m_bNoiseDisable;
+// Sunsoft 5B
+
+struct CS5BTraits : CPSGTraits {
+	static constexpr int CHIP = SNDCHIP_5B;
+	static constexpr uint8_t CHANNEL = CHANID_5B_CH1;
+	static constexpr uint16_t PORT = 0xC000;
+	static constexpr int32_t VOLUME[32] = {
+		  0,   1,   1,   2,
+		  2,   3,   3,   4,
+		  5,   6,   7,   9,
+		 11,  13,  15,  18,
+		 22,  26,  31,  37,
+		 45,  53,  63,  76,
+		 90, 106, 127, 151,
+		180, 212, 255, 255,
+	};
 };
 
-class CS5B : public CSoundChip
+class CS5B final : public CPSG<CS5BTraits>
 {
 public:
-	CS5B(CMixer *pMixer);
-	virtual ~CS5B();
-	
-	void	Reset();
-	void	Process(uint32_t Time);
-	void	EndFrame();
-
-	void	Write(uint16_t Address, uint8_t Value);
-	uint8_t	Read(uint16_t Address, bool &Mapped);
-	void	Log(uint16_t Address, uint8_t Value);		// // //
-
-	double	GetFreq(int Channel) const override;		// // //
-
-private:
-	void	WriteReg(uint8_t Port, uint8_t Value);
-	void	RunEnvelope(uint32_t Time);
-	void	RunNoise(uint32_t Time);
-
-private:
-	CS5BChannel *m_pChannel[3];
-
-	uint8_t m_cPort;
-
-	int m_iCounter;
-
-	uint32_t m_iNoisePeriod;
-	uint32_t m_iNoiseClock;
-	uint32_t m_iNoiseState;
-
-	uint32_t m_iEnvelopePeriod;
-	uint32_t m_iEnvelopeClock;
-	char m_iEnvelopeLevel;
-	char m_iEnvelopeShape;
-	bool m_bEnvelopeHold;
+	using CPSG::CPSG;
 };
@@ -0,0 +1,103 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+#include "Simd.h"
+#include <atomic>
+
+#if defined(SIMD_HAS_AVX2) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+
+bool CpuHasAVX2()
+{
+#if !defined(SIMD_HAS_AVX2)
+	return false;
+#elif defined(_MSC_VER)
+	int Info[4];
+	__cpuid(Info, 0);
+	if (Info[0] < 7)
+		return false;
+	__cpuid(Info, 1);
+	const bool OSXSAVE = (Info[2] & (1 << 27)) != 0;
+	const bool AVX = (Info[2] & (1 << 28)) != 0;
+	if (!OSXSAVE || !AVX || (_xgetbv(0) & 0x6) != 0x6)		// OS saves the YMM registers
+		return false;
+	__cpuid(Info, 7);
+	return (Info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+simd_t DetectLevel()
+{
+	for (int i = SIMD_COUNT - 1; i > SIMD_NONE; --i)
+		if (IsSimdSupported(static_cast<simd_t>(i)))
+			return static_cast<simd_t>(i);
+	return SIMD_NONE;
+}
+
+} // namespace
+
+std::atomic<simd_t> g_SimdLevel(DetectLevel());
+
+bool IsSimdSupported(simd_t Level)
+{
+	switch (Level) {
+	case SIMD_NONE:
+		return true;
+#ifdef SIMD_HAS_SSE2
+	case SIMD_SSE2:
+		return true;
+#endif
+#ifdef SIMD_HAS_AVX2
+	case SIMD_AVX2: {
+		static const bool Supported = CpuHasAVX2();
+		return Supported;
+	}
+#endif
+#ifdef SIMD_HAS_NEON
+	case SIMD_NEON:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+void SetSimdLevel(simd_t Level)
+{
+	g_SimdLevel.store(IsSimdSupported(Level) ? Level : DetectLevel(), std::memory_order_relaxed);
+}
+
+const char *GetSimdName(simd_t Level)
+{
+	switch (Level) {
+	case SIMD_NONE: return "none";
+	case SIMD_SSE2: return "sse2";
+	case SIMD_AVX2: return "avx2";
+	case SIMD_NEON: return "neon";
+	default:        return "?";
+	}
+}
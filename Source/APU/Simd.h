@@ -0,0 +1,77 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#pragma once
+
+#include <atomic>
+
+// Runtime selection of the vector instruction set used by the sound kernels.
+//
+// Which kernels get compiled depends on the target: SSE2 on x86 when the compiler
+// may assume it (always on x64), AVX2 on x86 through per-function target attributes,
+// NEON on AArch64. Among those, the best one the running CPU supports is picked at
+// startup. Every level must produce the same output as SIMD_NONE.
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+#define SIMD_X86 1
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SIMD_HAS_SSE2 1
+#endif
+#if defined(_MSC_VER) || defined(__GNUC__)
+#define SIMD_HAS_AVX2 1
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SIMD_HAS_NEON 1
+#endif
+
+#if defined(SIMD_HAS_AVX2) && !defined(_MSC_VER)
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_TARGET_AVX2
+#endif
+
+enum simd_t {
+	SIMD_NONE,
+	SIMD_SSE2,
+	SIMD_AVX2,
+	SIMD_NEON,
+	SIMD_COUNT,
+};
+
+/// Checks whether kernels for Level were compiled in and the CPU can run them.
+bool IsSimdSupported(simd_t Level);
+
+/// Current level, defined in Simd.cpp. Use GetSimdLevel() and SetSimdLevel() instead.
+extern std::atomic<simd_t> g_SimdLevel;
+
+/// The level the kernels currently dispatch to. Inline, since it is read for every
+/// Blip_Synth impulse.
+inline simd_t GetSimdLevel()
+{
+	return g_SimdLevel.load(std::memory_order_relaxed);
+}
+
+/// Forces the kernels to Level, or to the best supported level if Level is not supported.
+/// Meant for comparing levels against each other; not synchronized with running kernels.
+void SetSimdLevel(simd_t Level);
+
+/// Short name of Level ("none", "sse2", "avx2" or "neon").
+const char *GetSimdName(simd_t Level);
@@ -18,9 +18,9 @@
 ** along with this program. If not, see https://www.gnu.org/licenses/.
 */
 
-#include "../stdafx.h"
 #include "SoundChip.h"
 #include "../RegisterState.h"
+#include "StateArchive.h"
 
 CSoundChip::CSoundChip(CMixer *pMixer) :
 	m_pMixer(pMixer),
@@ -50,3 +50,8 @@ CRegisterLogger *CSoundChip::GetRegisterLogger() const		// // //
 {
 	return m_pRegisterLogger;
 }
+
+void CSoundChip::SerializeState(CStateArchive &State)
+{
+	m_pRegisterLogger->SerializeState(State);
+}
@@ -25,6 +25,7 @@
 
 class CMixer;
 class CRegisterLogger;		// // //
+class CStateArchive;
 
 class CSoundChip {
 public:
@@ -44,6 +45,10 @@ public:
 	virtual void	Log(uint16_t Address, uint8_t Value);		// // //
 	CRegisterLogger *GetRegisterLogger() const;		// // //
 
+	/// Saves or restores the emulation state, see CStateArchive. Overrides pass
+	/// their own state after calling this, which handles the register logger.
+	virtual void	SerializeState(CStateArchive &State);
+
 protected:
 	CMixer *m_pMixer;
 	CRegisterLogger *m_pRegisterLogger;		// // //
@@ -18,9 +18,9 @@
 ** along with this program. If not, see https://www.gnu.org/licenses/.
 */
 
-#include "../stdafx.h"
 #include "SoundChip2.h"
 #include "../RegisterState.h"
+#include "StateArchive.h"
 
 CSoundChip2::CSoundChip2() :
 	m_pRegisterLogger(std::make_unique<CRegisterLogger>())
@@ -43,3 +43,8 @@ CRegisterLogger* CSoundChip2::GetRegisterLogger() const		// // //
 {
 	return m_pRegisterLogger.get();
 }
+
+void CSoundChip2::SerializeState(CStateArchive &State)
+{
+	m_pRegisterLogger->SerializeState(State);
+}
@@ -28,6 +28,7 @@
 #include <memory>
 
 class CRegisterLogger;		// // //
+class CStateArchive;
 class Blip_Buffer;
 
 class CSoundChip2 {
@@ -64,6 +65,11 @@ public:
 	virtual void	Write(uint16_t Address, uint8_t Value) = 0;
 	virtual uint8_t	Read(uint16_t Address, bool &Mapped) = 0;
 
+	/// Silence the channels whose bits are set in Mask, bit 0 being the chip's first channel.
+	/// Silenced channels keep running, they are only left out of the output.
+	/// The mask survives Reset(). Single-channel chips may ignore it.
+	virtual void	SetChannelMask(uint32_t Mask) {}
+
 	// TODO: unify with definitions in DetuneTable.cpp?
 	virtual double	GetFreq(int Channel) const;		// // //
 
@@ -90,6 +96,10 @@ public:
 	virtual void	Log(uint16_t Address, uint8_t Value);		// // //
 	CRegisterLogger *GetRegisterLogger() const;		// // //
 
+	/// Saves or restores the emulation state, see CStateArchive. Overrides pass
+	/// their own state after calling this, which handles the register logger.
+	virtual void	SerializeState(CStateArchive &State);
+
 protected:
 	std::unique_ptr<CRegisterLogger> m_pRegisterLogger;		// // //
 };
@@ -158,6 +158,15 @@ double CSquare::GetFrequency() const		// // //
 	return CPU_RATE / 16. / (m_iPeriod + 1.);
 }
 
+void CSquare::SerializeState(CStateArchive &State)		// // //
+{
+	C2A03Chan::SerializeState(State);
+	State(m_iDutyLength, m_iDutyCycle, m_iLooping, m_iEnvelopeFix, m_iEnvelopeSpeed,
+		m_iEnvelopeVolume, m_iFixedVolume, m_iEnvelopeCounter,
+		m_iSweepEnabled, m_iSweepPeriod, m_iSweepMode, m_iSweepShift,
+		m_iSweepCounter, m_iSweepResult, m_bSweepWritten);
+}
+
 void CSquare::LengthCounterUpdate()
 {
 	if ((m_iLooping == 0) && (m_iLengthCounter > 0)) 
@@ -0,0 +1,84 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+#include "StateArchive.h"
+#include <algorithm>
+#include <cstring>
+
+CStateArchive::CStateArchive(std::vector<uint8_t> *pSave, const std::vector<uint8_t> *pLoad,
+	object_list_t *pSaveObjects, const object_list_t *pLoadObjects) :
+	m_pSave(pSave),
+	m_pLoad(pLoad),
+	m_pSaveObjects(pSaveObjects),
+	m_pLoadObjects(pLoadObjects)
+{
+}
+
+CStateArchive CStateArchive::Saving(std::vector<uint8_t> &Data, object_list_t *pObjects)
+{
+	Data.clear();
+	if (pObjects)
+		pObjects->clear();
+	return CStateArchive(&Data, nullptr, pObjects, nullptr);
+}
+
+CStateArchive CStateArchive::Loading(const std::vector<uint8_t> &Data, const object_list_t *pObjects)
+{
+	return CStateArchive(nullptr, &Data, nullptr, pObjects);
+}
+
+bool CStateArchive::IsLoading() const
+{
+	return m_pLoad != nullptr;
+}
+
+std::size_t CStateArchive::Remaining() const
+{
+	return m_pLoad ? m_pLoad->size() - m_iPos : 0;
+}
+
+bool CStateArchive::IsValid() const
+{
+	return !m_pLoad || (!m_bOverrun && m_iPos == m_pLoad->size());
+}
+
+void CStateArchive::Reject()
+{
+	if (m_pLoad)
+		m_bOverrun = true;
+}
+
+void CStateArchive::Bytes(void *pData, std::size_t Size)
+{
+	if (Size == 0)
+		return;
+	if (m_pSave) {
+		const auto *pBytes = static_cast<const uint8_t *>(pData);
+		m_pSave->insert(m_pSave->end(), pBytes, pBytes + Size);
+		return;
+	}
+
+	const std::size_t Count = std::min(Size, m_pLoad->size() - m_iPos);
+	std::memcpy(pData, m_pLoad->data() + m_iPos, Count);
+	std::memset(static_cast<uint8_t *>(pData) + Count, 0, Size - Count);
+	m_iPos += Count;
+	if (Count < Size)
+		m_bOverrun = true;
+}
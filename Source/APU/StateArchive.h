@@ -0,0 +1,129 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/// Saves or restores the emulation state of the sound core.
+///
+/// Every stateful part (CAPU, CMixer, each sound chip and the emulator cores they wrap)
+/// has a SerializeState() that passes its members to the archive in a fixed order. The
+/// same call saves them when the archive is saving, and overwrites them from the saved
+/// data when it is loading, so the member list is written only once.
+///
+/// Only state is archived, not configuration: clock rates, mixing levels, filters and
+/// options are left alone, so a state can only be restored into a CAPU set up the same
+/// way. DPCM sample memory is archived as a pointer to the caller's sample, which must
+/// outlive the saved state.
+///
+/// Objects shared with the rest of the program (such as the instruments the player reads)
+/// are archived by reference with Object(), into an object list kept next to the data.
+class CStateArchive {
+public:
+	/// Shared objects referred to by the data, kept alive along with it.
+	using object_list_t = std::vector<std::shared_ptr<const void>>;
+
+	/// Archive saving into Data, which is cleared first, and into Objects if given.
+	static CStateArchive Saving(std::vector<uint8_t> &Data, object_list_t *pObjects = nullptr);
+	/// Archive restoring from Data and the Objects saved along with it.
+	static CStateArchive Loading(const std::vector<uint8_t> &Data, const object_list_t *pObjects = nullptr);
+
+	bool	IsLoading() const;
+	/// False if a load ran past the end of the data, or did not use all of it.
+	/// The values read past the end are zero.
+	bool	IsValid() const;
+
+	/// Saves or restores Values, which must be trivially copyable (arrays included).
+	template <typename... T>
+	CStateArchive &operator()(T &... Values) {
+		(Value(Values), ...);
+		return *this;
+	}
+
+	/// Fails a load, for data that does not fit what is being restored.
+	void	Reject();
+
+	/// Saves or restores Size raw bytes at pData.
+	void	Bytes(void *pData, std::size_t Size);
+
+	/// Saves or restores the size and elements of Values.
+	template <typename T>
+	void Vector(std::vector<T> &Values) {
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be archived");
+		uint64_t Size = Values.size();
+		Value(Size);
+		if (IsLoading()) {
+			if (Size > Remaining() / sizeof(T)) {
+				m_bOverrun = true;
+				Size = 0;
+			}
+			Values.resize(static_cast<std::size_t>(Size));
+		}
+		Bytes(Values.data(), Values.size() * sizeof(T));
+	}
+
+	/// Saves or restores a reference to a shared object, which must be restored as the
+	/// same type T. Requires an object list.
+	template <typename T>
+	void Object(std::shared_ptr<T> &pObject) {
+		uint32_t Index = 0;		// 0 for none
+		if (!IsLoading() && pObject) {
+			assert(m_pSaveObjects != nullptr);
+			m_pSaveObjects->push_back(pObject);
+			Index = static_cast<uint32_t>(m_pSaveObjects->size());
+		}
+		Value(Index);
+		if (!IsLoading())
+			return;
+		if (Index == 0)
+			pObject.reset();
+		else if (!m_pLoadObjects || Index > m_pLoadObjects->size()) {
+			m_bOverrun = true;
+			pObject.reset();
+		}
+		else
+			pObject = std::const_pointer_cast<T>(std::static_pointer_cast<const T>((*m_pLoadObjects)[Index - 1]));
+	}
+
+private:
+	CStateArchive(std::vector<uint8_t> *pSave, const std::vector<uint8_t> *pLoad,
+		object_list_t *pSaveObjects, const object_list_t *pLoadObjects);
+	std::size_t Remaining() const;
+
+	template <typename T>
+	void Value(T &Value) {
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be archived");
+		Bytes(&Value, sizeof(T));
+	}
+
+private:
+	std::vector<uint8_t> *m_pSave;
+	const std::vector<uint8_t> *m_pLoad;
+	object_list_t *m_pSaveObjects;
+	const object_list_t *m_pLoadObjects;
+	std::size_t m_iPos = 0;
+	bool m_bOverrun = false;
+};
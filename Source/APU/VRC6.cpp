@@ -40,6 +40,13 @@ void CVRC6_Pulse::Reset()
 	EndFrame();
 }
 
+void CVRC6_Pulse::SerializeState(CStateArchive &State)		// // //
+{
+	CChannel::SerializeState(State);
+	State(m_iDutyCycle, m_iVolume, m_iGate, m_iEnabled, m_iPeriod, m_iPeriodLow, m_iPeriodHigh,
+		m_iCounter, m_iDutyCycleCounter);
+}
+
 void CVRC6_Pulse::Write(uint16_t Address, uint8_t Value)
 {
 	switch (Address) {
@@ -110,6 +117,13 @@ void CVRC6_Sawtooth::Reset()
 	EndFrame();
 }
 
+void CVRC6_Sawtooth::SerializeState(CStateArchive &State)		// // //
+{
+	CChannel::SerializeState(State);
+	State(m_iPhaseAccumulator, m_iPhaseInput, m_iEnabled, m_iResetReg, m_iPeriod, m_iPeriodLow,
+		m_iPeriodHigh, m_iCounter);
+}
+
 void CVRC6_Sawtooth::Write(uint16_t Address, uint8_t Value)
 {
 	switch (Address) {
@@ -255,3 +269,11 @@ double CVRC6::GetFreq(int Channel) const		// // //
 	}
 	return 0.;
 }
+
+void CVRC6::SerializeState(CStateArchive &State)		// // //
+{
+	CSoundChip::SerializeState(State);
+	m_pPulse1->SerializeState(State);
+	m_pPulse2->SerializeState(State);
+	m_pSawtooth->SerializeState(State);
+}
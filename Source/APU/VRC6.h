@@ -31,6 +31,7 @@ public:
 	void Write(uint16_t Address, uint8_t Value);
 	void Process(int Time);
 	double GetFrequency() const;		// // //
+	void SerializeState(CStateArchive &State) override;		// // //
 
 private:
 	uint8_t	m_iDutyCycle, 
@@ -51,6 +52,7 @@ public:
 	void Write(uint16_t Address, uint8_t Value);
 	void Process(int Time);
 	double GetFrequency() const;		// // //
+	void SerializeState(CStateArchive &State) override;		// // //
 
 private:
 	uint8_t	m_iPhaseAccumulator, 
@@ -73,6 +75,7 @@ public:
 	void EndFrame();
 	void Process(uint32_t Time);
 	double GetFreq(int Channel) const override;		// // //
+	void SerializeState(CStateArchive &State) override;		// // //
 
 private:
 	CVRC6_Pulse	*m_pPulse1, *m_pPulse2;
@@ -0,0 +1,94 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+#include "WorkerPool.h"
+
+CWorkerPool::CWorkerPool(unsigned Workers)
+{
+	m_Threads.reserve(Workers);
+	for (unsigned i = 0; i < Workers; ++i)
+		m_Threads.emplace_back(&CWorkerPool::WorkerMain, this, i + 1);
+}
+
+CWorkerPool::~CWorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_bQuit = true;
+	}
+	m_Start.notify_all();
+	for (auto &Thread : m_Threads)
+		Thread.join();
+}
+
+unsigned CWorkerPool::GetThreadCount() const
+{
+	return static_cast<unsigned>(m_Threads.size()) + 1;
+}
+
+void CWorkerPool::Run(unsigned Count, const std::function<void(unsigned)> &Job)
+{
+	if (m_Threads.empty()) {
+		for (unsigned i = 0; i < Count; ++i)
+			Job(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> Lock(m_Mutex);
+		m_pJob = &Job;
+		m_iJobCount = Count;
+		m_iBusy = static_cast<unsigned>(m_Threads.size());
+		++m_iBatch;
+	}
+	m_Start.notify_all();
+
+	RunShare(0);
+
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+	m_Done.wait(Lock, [this] { return m_iBusy == 0; });
+	m_pJob = nullptr;
+}
+
+void CWorkerPool::WorkerMain(unsigned Thread)
+{
+	uint64_t Batch = 0;
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+	while (true) {
+		m_Start.wait(Lock, [&] { return m_bQuit || m_iBatch != Batch; });
+		if (m_bQuit)
+			return;
+		Batch = m_iBatch;
+
+		Lock.unlock();
+		RunShare(Thread);
+		Lock.lock();
+
+		if (--m_iBusy == 0)
+			m_Done.notify_one();
+	}
+}
+
+void CWorkerPool::RunShare(unsigned Thread) const
+{
+	const unsigned Step = GetThreadCount();
+	for (unsigned i = Thread; i < m_iJobCount; i += Step)
+		(*m_pJob)(i);
+}
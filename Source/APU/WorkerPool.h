@@ -0,0 +1,68 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// Small fixed pool of threads that run a batch of jobs and wait for all of them.
+///
+/// Used by CAPU to emulate expansion chips concurrently. Job i always runs on
+/// thread i % GetThreadCount(), where thread 0 is the caller of Run(), so a chip
+/// keeps being emulated on the same thread (and usually the same core) every frame.
+class CWorkerPool {
+public:
+	/// Workers is the number of threads started in addition to the caller.
+	explicit CWorkerPool(unsigned Workers);
+	~CWorkerPool();
+
+	CWorkerPool(const CWorkerPool &) = delete;
+	CWorkerPool &operator=(const CWorkerPool &) = delete;
+
+	/// Number of threads jobs are spread over, including the caller of Run().
+	unsigned GetThreadCount() const;
+
+	/// Calls Job(i) for every i in [0, Count), and returns once all calls have finished.
+	void Run(unsigned Count, const std::function<void(unsigned)> &Job);
+
+private:
+	void WorkerMain(unsigned Thread);
+	void RunShare(unsigned Thread) const;
+
+private:
+	std::vector<std::thread> m_Threads;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_Start;
+	std::condition_variable m_Done;
+
+	// Guarded by m_Mutex
+	const std::function<void(unsigned)> *m_pJob = nullptr;
+	unsigned m_iJobCount = 0;
+	uint64_t m_iBatch = 0;		// Incremented for every Run()
+	unsigned m_iBusy = 0;		// Workers still running the current batch
+	bool m_bQuit = false;
+};
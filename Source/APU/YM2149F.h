@@ -21,71 +21,28 @@
 
 #pragma once
 
-#include "SoundChip.h"
-#include "Channel.h"
-
-// // // 050B
-
-class CYM2149FChannel : public CChannel
-{
-public:
-	friend class CYM2149F;
-
-	CYM2149FChannel(CMixer *pMixer, uint8_t ID);
-	
-	void Process(uint32_t Time);
-	void Reset();
-
-	uint32_t GetTime();
-	void Output(uint32_t Noise, uint32_t Envelope);
-
-	double GetFrequency() const override;
-
-private:
-	uint8_t m_iVolume;
-	uint32_t m_iPeriod;
-	uint32_t m_iPeriodClock;
-
-	bool m_bSquareHigh;
-	bool m_bSquareDisable;
-	bool m_bNoiseDisable;
+#include "PSG.h"
+
+// YM2149F, volume decreasing by 1.5 dB every step
+
+struct CYM2149FTraits : CPSGTraits {
+	static constexpr int CHIP = SNDCHIP_SSG;
+	static constexpr uint8_t CHANNEL = CHANID_YM2149F_CH1;
+	static constexpr uint16_t PORT = 0xC003;
+	static constexpr int32_t VOLUME[32] = {
+		  1,   1,   2,   2,
+		  2,   3,   3,   4,
+		  5,   6,   7,   8,
+		 10,  11,  14,  16,
+		 19,  23,  27,  32,
+		 38,  45,  54,  64,
+		 76,  90, 108, 128,
+		152, 181, 215, 255,
+	};
 };
 
-class CYM2149F : public CSoundChip
+class CYM2149F final : public CPSG<CYM2149FTraits>
 {
 public:
-	CYM2149F(CMixer *pMixer);
-	virtual ~CYM2149F();
-	
-	void	Reset();
-	void	Process(uint32_t Time);
-	void	EndFrame();
-
-	void	Write(uint16_t Address, uint8_t Value);
-	uint8_t	Read(uint16_t Address, bool &Mapped);
-	void	Log(uint16_t Address, uint8_t Value);		// // //
-
-	double	GetFreq(int Channel) const override;		// // //
-
-private:
-	void	WriteReg(uint8_t Port, uint8_t Value);
-	void	RunEnvelope(uint32_t Time);
-	void	RunNoise(uint32_t Time);
-
-private:
-	CYM2149FChannel *m_pChannel[3];
-
-	uint8_t m_cPort;
-
-	int m_iCounter;
-
-	uint32_t m_iNoisePeriod;
-	uint32_t m_iNoiseClock;
-	uint32_t m_iNoiseState;
-
-	uint32_t m_iEnvelopePeriod;
-	uint32_t m_iEnvelopeClock;
-	char m_iEnvelopeLevel;
-	char m_iEnvelopeShape;
-	bool m_bEnvelopeHold;
+	using CPSG::CPSG;
 };
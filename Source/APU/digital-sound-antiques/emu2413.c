@@ -1481,6 +1481,70 @@ uint32_t OPLL_toggleMask(OPLL *opll, uint32_t mask) {
     return 0;
 }
 
+/* // // // State save / restore. Pointers are stored as indices, so a state can be loaded into another
+   OPLL. The clock, rate and mask of the OPLL being loaded into are kept. */
+size_t OPLL_getStateSize(const OPLL *opll) {
+  size_t size = sizeof(OPLL);
+  if (opll->conv)
+    size += sizeof(opll->conv->timer) + sizeof(int16_t) * LW * opll->conv->ch;
+  return size;
+}
+
+void OPLL_saveState(const OPLL *opll, uint8_t *state) {
+  OPLL copy = *opll;
+  int i;
+
+  for (i = 0; i < 18; i++) {
+    const OPLL_SLOT *slot = &opll->slot[i];
+    copy.slot[i].patch = (OPLL_PATCH *)(intptr_t)(slot->patch == &null_patch ? -1 : slot->patch - opll->patch);
+    copy.slot[i].wave_table = (uint16_t *)(intptr_t)(slot->wave_table == wave_table_map[1]);
+  }
+  copy.conv = NULL;
+  memcpy(state, &copy, sizeof(OPLL));
+  state += sizeof(OPLL);
+
+  if (opll->conv) {
+    memcpy(state, &opll->conv->timer, sizeof(opll->conv->timer));
+    state += sizeof(opll->conv->timer);
+    for (i = 0; i < opll->conv->ch; i++) {
+      memcpy(state, opll->conv->buf[i], sizeof(int16_t) * LW);
+      state += sizeof(int16_t) * LW;
+    }
+  }
+}
+
+void OPLL_loadState(OPLL *opll, const uint8_t *state) {
+  const uint32_t clk = opll->clk, rate = opll->rate, mask = opll->mask;
+  const double inp_step = opll->inp_step, out_step = opll->out_step;
+  OPLL_RateConv *conv = opll->conv;
+  int i;
+
+  memcpy(opll, state, sizeof(OPLL));
+  state += sizeof(OPLL);
+  opll->clk = clk;
+  opll->rate = rate;
+  opll->mask = mask;
+  opll->inp_step = inp_step;
+  opll->out_step = out_step;
+  opll->conv = conv;
+
+  for (i = 0; i < 18; i++) {
+    OPLL_SLOT *slot = &opll->slot[i];
+    const intptr_t patch = (intptr_t)slot->patch;
+    slot->patch = (patch >= 0 && patch < 19 * 2) ? &opll->patch[patch] : &null_patch;
+    slot->wave_table = wave_table_map[(intptr_t)slot->wave_table == 1];
+  }
+
+  if (conv) {
+    memcpy(&conv->timer, state, sizeof(conv->timer));
+    state += sizeof(conv->timer);
+    for (i = 0; i < conv->ch; i++) {
+      memcpy(conv->buf[i], state, sizeof(int16_t) * LW);
+      state += sizeof(int16_t) * LW;
+    }
+  }
+}
+
 int32_t OPLL_getchanvol(int i)
 {
     int retval = opll_volumes[i];
@@ -1,6 +1,7 @@
 #ifndef _EMU2413_H_
 #define _EMU2413_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -229,6 +230,15 @@ uint32_t OPLL_setMask(OPLL *, uint32_t mask);
  */
 uint32_t OPLL_toggleMask(OPLL *, uint32_t mask);
 
+/**
+ * Save / restore the emulation state (extra function - not in upstream emu2413)
+ * OPLL_saveState writes OPLL_getStateSize() bytes to state, which OPLL_loadState reads back
+ * into an OPLL with the same clock and rate. The mask of the OPLL being loaded into is kept.
+ */
+size_t OPLL_getStateSize(const OPLL *opll);
+void OPLL_saveState(const OPLL *opll, uint8_t *state);
+void OPLL_loadState(OPLL *opll, const uint8_t *state);
+
 /* for compatibility */
 #define OPLL_set_rate OPLL_setRate
 #define OPLL_set_quality OPLL_setQuality
@@ -1,5 +1,4 @@
 #pragma once
-#include "stdafx.h"
 #include <cstdint>
 
 class BaseFdsChannel
@@ -22,6 +21,13 @@ public:
 		_masterSpeed = masterSpeed;
 	}
 
+	// // // Passes the emulation state to 'state' (a CStateArchive), which saves or restores it.
+	template <class State>
+	void SerializeState(State &state)
+	{
+		state(_speed, _gain, _envelopeOff, _volumeIncrease, _frequency, _timer, _masterSpeed);
+	}
+
 	virtual void WriteReg(uint16_t addr, uint8_t value)
 	{
 		switch(addr & 0x03) {
@@ -1,7 +1,6 @@
 #pragma once
-#include "stdafx.h"
 #include <algorithm>
-#include "APU.h"
+#include "../APU.h"
 #include "BaseFdsChannel.h"
 #include "ModChannel.h"
 
@@ -163,6 +162,16 @@ public:
 		*this = {};
 	}
 
+	// // // Passes the emulation state to 'state' (a CStateArchive), which saves or restores it.
+	template <class State>
+	void SerializeState(State &state)
+	{
+		state(_waveTable, _waveWriteEnabled, _disableEnvelopes, _haltWaveform, _masterVolume,
+			_waveOverflowCounter, _wavePitch, _wavePosition);
+		_carrier.SerializeState(state);
+		_mod.SerializeState(state);
+	}
+
 	uint8_t ReadRegister(uint16_t addr)
 	{
 		uint8_t value = 0;
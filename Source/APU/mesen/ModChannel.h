@@ -1,5 +1,4 @@
 #pragma once
-#include "stdafx.h"
 #include "BaseFdsChannel.h"
 #include <assert.h>
 #include <algorithm>  // std::min
@@ -39,6 +38,14 @@ public:
 		}
 	}
 
+	// // //
+	template <class State>
+	void SerializeState(State &state)
+	{
+		BaseFdsChannel::SerializeState(state);
+		state(_counter, _modulationDisabled, _modTable, _modTablePosition, _overflowCounter, _output);
+	}
+
 	void WriteModTable(uint8_t value)
 	{
 		//"This register has no effect unless the mod unit is disabled via the high bit of $4087."
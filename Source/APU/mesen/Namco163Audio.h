@@ -1,5 +1,4 @@
 #pragma once
-#include "stdafx.h"
 #include "../APU.h"
 
 class Namco163Audio
@@ -17,6 +16,7 @@ private:
 	int16_t _lastOutput;
 	bool _disableSound;
 	bool _mixLinear;
+	uint8_t _channelMask;		// Channels left out of the output, indexed like _channelOutput
 
 	enum SoundReg
 	{
@@ -99,6 +99,11 @@ public:
 		_mixLinear = mixLinear;
 	}
 
+	void SetChannelMask(uint8_t mask)
+	{
+		_channelMask = mask;
+	}
+
 	void UpdateChannel(int channel)
 	{
 		uint32_t phase = GetPhase(channel);
@@ -121,7 +126,7 @@ public:
 			sample = _internalRam[samplePosition / 2] & 0x0F;
 		}
 
-		_channelOutput[channel] = (sample - 8) * volume;
+		_channelOutput[channel] = (_channelMask >> channel & 1) ? 0 : (sample - 8) * volume;
 		SetPhase(channel, phase);
 	}
 
@@ -177,12 +182,22 @@ public:
 		_lastOutput = 0;
 		_disableSound = false;
 		_mixLinear = false;
+		_channelMask = 0;
 	}
 
 	void Reset() {
 		*this = {};
 	}
 
+	// // // Passes the emulation state, but not the mixing options, to 'state' (a CStateArchive),
+	// which saves or restores it.
+	template <class State>
+	void SerializeState(State &state)
+	{
+		state(_channelOutput, _ramPosition, _autoIncrement, _updateCounter, _currentChannel,
+			_lastOutput, _disableSound, _internalRam);
+	}
+
 	uint8_t* GetInternalRam()
 	{
 		return _internalRam;
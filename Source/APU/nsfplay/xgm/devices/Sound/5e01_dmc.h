@@ -137,6 +137,20 @@ namespace xgm
     virtual ITrackInfo* GetTrackInfo(int trk);
 
     void SetCPU(NES_CPU* cpu_);
+
+    // // // Passes the emulation state, but not the configuration, to 'state'
+    // (a CStateArchive), which saves or restores it.
+    template <class State>
+    void SerializeState (State &state)
+    {
+      state (reg, len_reg, adr_reg, out, daddress, dlength, data, empty, damp, dac_lsb,
+             dmc_pop, dmc_pop_offset, dmc_pop_follow, mode, irq, counter, tphase, tduty, nfreq, dfreq,
+             tri_freq, linear_counter, linear_counter_reload, linear_counter_halt, linear_counter_control,
+             noise_volume, noise, noise_tap, envelope_loop, envelope_disable, envelope_write,
+             envelope_div_period, envelope_div, envelope_counter, enable, length_counter,
+             frame_sequence_count, frame_sequence_length, frame_sequence_step, frame_sequence_steps,
+             frame_irq, frame_irq_enable);
+    }
   };
 
 }
@@ -86,6 +86,17 @@ namespace xgm
     virtual void SetMask(int m){ mask = m; }
     virtual void SetStereoMix (int trk, xgm::INT16 mixl, xgm::INT16 mixr);
     virtual ITrackInfo *GetTrackInfo(int trk);
+
+    // // // Passes the emulation state, but not the configuration, to 'state'
+    // (a CStateArchive), which saves or restores it.
+    template <class State>
+    void SerializeState (State &state)
+    {
+      state (gclock, reg, out, scounter, sphase, duty, volume, freq, sfreq,
+             sweep_enable, sweep_mode, sweep_write, sweep_div_period, sweep_div, sweep_amount,
+             envelope_disable, envelope_loop, envelope_write, envelope_div_period, envelope_div, envelope_counter,
+             length_counter, enable);
+    }
   };
 
 }                               // namespace
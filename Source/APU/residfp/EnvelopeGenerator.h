@@ -381,6 +381,18 @@ public:
         env3(0)
     {}
 
+    /**
+     * Save or restore the emulation state through archive (a CStateArchive).
+     */
+    template <class Archive>
+    void SerializeState(Archive &archive)
+    {
+        archive(lfsr, rate, exponential_counter, exponential_counter_period,
+            new_exponential_counter_period, state_pipeline, envelope_pipeline,
+            exponential_pipeline, state, next_state, counter_enabled, gate, resetLfsr,
+            envelope_counter, attack, decay, sustain, release, env3);
+    }
+
     /**
      * SID reset.
      */
@@ -105,6 +105,15 @@ public:
      * SID reset.
      */
     void reset();
+
+    /**
+     * Save or restore the emulation state through state (a CStateArchive).
+     */
+    template <class State>
+    void SerializeState(State &state)
+    {
+        state(Vlp, Vhp);
+    }
 };
 
 } // namespace reSIDfp
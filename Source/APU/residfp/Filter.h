@@ -137,6 +137,16 @@ public:
      */
     void enable(bool enable);
 
+    /**
+     * Save or restore the register settings and the filter state through state (a CStateArchive).
+     */
+    template <class State>
+    void SerializeState(State &state)
+    {
+        state(currentGain, currentMixer, currentSummer, currentResonance, Vhp, Vbp, Vlp, ve,
+            fc, filt1, filt2, filt3, filtE, voice3off, hp, bp, lp, vol, filt);
+    }
+
     /**
      * SID reset.
      */
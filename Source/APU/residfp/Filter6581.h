@@ -367,7 +367,7 @@ public:
 
     ~Filter6581();
 
-    unsigned short Filter6581::clock(int voice1, int voice2, int voice3)
+    unsigned short clock(int voice1, int voice2, int voice3)
     {
       voice1 = (voice1 * voiceScaleS14 >> 18) + voiceDC;
       voice2 = (voice2 * voiceScaleS14 >> 18) + voiceDC;
@@ -401,6 +401,17 @@ public:
      * @param curvePosition 0 .. 1, where 0 sets center frequency high ("light") and 1 sets it low ("dark"), default is 0.5
      */
     void setFilterCurve(double curvePosition);
+
+    /**
+     * Save or restore the emulation state through state (a CStateArchive).
+     */
+    template <class State>
+    void SerializeState(State &state)
+    {
+        Filter::SerializeState(state);
+        hpIntegrator->SerializeState(state);
+        bpIntegrator->SerializeState(state);
+    }
 };
 
 } // namespace reSIDfp
@@ -363,6 +363,17 @@ public:
      * @param curvePosition 0 .. 1, where 0 sets center frequency high ("light") and 1 sets it low ("dark"), default is 0.5
      */
     void setFilterCurve(double curvePosition);
+
+    /**
+     * Save or restore the emulation state through state (a CStateArchive).
+     */
+    template <class State>
+    void SerializeState(State &state)
+    {
+        Filter::SerializeState(state);
+        hpIntegrator->SerializeState(state);
+        bpIntegrator->SerializeState(state);
+    }
 };
 
 } // namespace reSIDfp
@@ -226,6 +226,15 @@ public:
       // Return vo.
       return vx - (vc >> 14);
     }
+
+    /**
+     * Save or restore the emulation state through state (a CStateArchive).
+     */
+    template <class State>
+    void SerializeState(State &state)
+    {
+      state(Vddt_Vw_2, vx, vc);
+    }
 };
 
 } // namespace reSIDfp
@@ -131,6 +131,15 @@ public:
       // Return vo.
       return vx - (vc >> 14);
     }
+
+    /**
+     * Save or restore the emulation state through state (a CStateArchive).
+     */
+    template <class State>
+    void SerializeState(State &state)
+    {
+      state(vx, vc, nVgt, n_dac);
+    }
 };
 
 } // namespace reSIDfp
@@ -163,6 +163,21 @@ public:
      */
     ChipModel getChipModel() const { return model; }
 
+    /**
+     * Save or restore the emulation state through state (a CStateArchive).
+     * The resampler and the chip model are not included.
+     */
+    template <class State>
+    void SerializeState(State &state)
+    {
+        state(busValueTtl, nextVoiceSync, busValue);
+        for (auto &v : voice)
+            v->SerializeState(state);
+        filter6581->SerializeState(state);
+        filter8580->SerializeState(state);
+        externalFilter->SerializeState(state);
+    }
+
     /**
      * SID reset.
      */
@@ -82,6 +82,16 @@ public:
         envelopeGenerator->writeCONTROL_REG(control);
     }
 
+    /**
+     * Save or restore the emulation state through state (a CStateArchive).
+     */
+    template <class State>
+    void SerializeState(State &state)
+    {
+        waveformGenerator->SerializeState(state);
+        envelopeGenerator->SerializeState(state);
+    }
+
     /**
      * SID reset.
      */
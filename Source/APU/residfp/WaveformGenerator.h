@@ -282,6 +282,18 @@ public:
      */
     void writeCONTROL_REG(unsigned char control);
 
+    /**
+     * Save or restore the emulation state through state (a CStateArchive).
+     */
+    template <class State>
+    void SerializeState(State &state)
+    {
+        state(model_wave, wave, pw, shift_register, shift_pipeline, ring_msb_mask,
+            no_noise, noise_output, no_noise_or_noise_output, no_pulse, pulse_output,
+            waveform, floating_output_ttl, waveform_output, accumulator, freq,
+            tri_saw_pipeline, osc3, shift_register_reset, test, sync, msb_rising);
+    }
+
     /**
      * SID reset.
      */
@@ -106,6 +106,15 @@ public:
     int output() const override { return outputValue; }
 
     void reset() override;
+
+    /**
+     * Save or restore the emulation state through state (a CStateArchive).
+     */
+    template <class State>
+    void SerializeState(State &state)
+    {
+        state(sampleIndex, sampleOffset, outputValue, sample);
+    }
 };
 
 } // namespace reSIDfp
@@ -80,6 +80,15 @@ public:
         sampleOffset = 0;
         cachedSample = 0;
     }
+
+    /**
+     * Save or restore the emulation state through state (a CStateArchive).
+     */
+    template <class State>
+    void SerializeState(State &state)
+    {
+        state(cachedSample, sampleOffset, outputValue);
+    }
 };
 
 } // namespace reSIDfp
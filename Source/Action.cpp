@@ -38,6 +38,16 @@ bool Action::Merge(const Action *Other)		// // //
 	return false;
 }
 
+void Action::Compact(CUndoJournal &Journal)		// // //
+{
+}
+
+std::size_t Action::GetMemorySize() const		// // //
+{
+	// Enough for the editor states and the few fields most actions keep
+	return 256;
+}
+
 int Action::GetAction() const
 {
 	return m_iAction;
@@ -46,9 +56,9 @@ int Action::GetAction() const
 
 // History /////////////////////////////////////////////////////////////////
 
-const int History::MAX_LEVELS = 64;		// // //
+const std::size_t History::MEMORY_BUDGET = 64 * 1024 * 1024;		// // //
 
-History::History() : m_UndoStack(), m_RedoStack()
+History::History() : m_UndoStack(), m_RedoStack(), m_iActionSize(0)
 {
 }
 
@@ -56,17 +66,44 @@ void History::Clear()
 {
 	m_UndoStack.clear();
 	m_RedoStack.clear();
+	m_iActionSize = 0;		// // //
+	m_Journal.Clear();
 }
 
-void History::Push(Action *pAction)
+bool History::Push(Action *pAction)
 {
 	auto ptr = std::unique_ptr<Action>(pAction);		// // //
-	if (m_UndoStack.empty() || !(*m_UndoStack.rbegin())->Merge(pAction)) {
-		if (m_UndoStack.size() == MAX_LEVELS)
-			m_UndoStack.erase(m_UndoStack.begin(), m_UndoStack.begin() + 1);
-		m_UndoStack.push_back(std::move(ptr));
-	}
+
+	// // // Redo levels are the newest in the journal, release them before a merge extends the last entry
+	for (const auto &x : m_RedoStack)
+		m_iActionSize -= x->GetMemorySize();
 	m_RedoStack.clear();
+
+	if (!m_UndoStack.empty()) {
+		Action *pLast = m_UndoStack.rbegin()->get();
+		const std::size_t Size = pLast->GetMemorySize();
+		if (pLast->Merge(pAction)) {
+			m_iActionSize = m_iActionSize - Size + pLast->GetMemorySize();
+			return Trim();
+		}
+	}
+
+	pAction->Compact(m_Journal);		// // //
+	m_iActionSize += pAction->GetMemorySize();
+	m_UndoStack.push_back(std::move(ptr));
+	return Trim();
+}
+
+bool History::Trim()		// // //
+{
+	// Drop the oldest levels until the history fits, always keeping the newest one
+	bool Dropped = false;
+	while (m_UndoStack.size() > 1 && GetMemorySize() > MEMORY_BUDGET) {
+		m_iActionSize -= m_UndoStack.front()->GetMemorySize();
+		m_UndoStack.erase(m_UndoStack.begin());
+		Dropped = true;
+	}
+	return Dropped;
 }
 
 Action *History::PopUndo()
@@ -115,3 +152,8 @@ bool History::CanRedo() const
 {
 	return !m_RedoStack.empty();
 }
+
+std::size_t History::GetMemorySize() const		// // //
+{
+	return m_iActionSize + m_Journal.GetSize();
+}
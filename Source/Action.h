@@ -23,11 +23,12 @@
 
 #include <vector>
 #include <memory>
+#include "UndoJournal.h"		// // //
 
 // Undo / redo helper class
 
 //
-// Change MAX_LEVELS in the class History if you want more undo levels
+// Change MEMORY_BUDGET in the class History if you want to keep more undo levels
 //
 
 class CMainFrame;		// // //
@@ -62,6 +63,12 @@ public:
 	// // // Combine current action with another one, return true if permissible
 	virtual bool Merge(const Action *Other);
 
+	// // // Move the undo data into the shared journal, called once the action enters the history
+	virtual void Compact(CUndoJournal &Journal);
+
+	// // // Approximate memory held by the action outside of the journal, in bytes
+	virtual std::size_t GetMemorySize() const;
+
 	// Get the action type
 	int GetAction() const;
 
@@ -80,8 +87,8 @@ public:
 	// Clear the undo list
 	void Clear();
 
-	// Add new action to undo list
-	void Push(Action *pAction);
+	// Add new action to undo list, returns true if older actions were dropped to make room
+	bool Push(Action *pAction);
 
 	// Get first undo action object in queue
 	Action *PopUndo();
@@ -104,11 +111,19 @@ public:
 	// Returns true if there are redo objects available
 	bool CanRedo() const;
 
+	// // // Get memory held by all undo and redo levels
+	std::size_t GetMemorySize() const;
+
 public:
-	// Levels of undo in the editor. Higher value requires more memory
-	static const int MAX_LEVELS;
+	// // // Memory the undo levels may use before the oldest ones are dropped
+	static const std::size_t MEMORY_BUDGET;
+
+private:
+	bool Trim();		// // //
 
 private:
+	CUndoJournal m_Journal;		// // // Declared first, actions release their entries on destruction
 	std::vector<std::unique_ptr<Action>> m_UndoStack, m_RedoStack;
+	std::size_t m_iActionSize;		// // // Sum of GetMemorySize() over both stacks
 };
 
@@ -216,8 +216,9 @@ void Blip_Synth_Fast_::volume_unit( double new_unit )
 
 #if !BLIP_BUFFER_FAST
 
-Blip_Synth_::Blip_Synth_( short* p, int w ) :
+Blip_Synth_::Blip_Synth_( short* p, short* ph, int w ) :
     impulses( p ),
+    phases( ph ),
     width( w )
 {
     volume_unit_ = 0.0;
@@ -310,12 +311,29 @@ void Blip_Synth_::adjust_impulse()
         impulses [size - blip_res + p] += (short) error;
         //printf( "error: %ld\n", error );
     }
+    build_phases();
 
     //for ( int i = blip_res; i--; printf( "\n" ) )
     //  for ( int j = 0; j < width / 2; j++ )
     //      printf( "%5ld,", impulses [j * blip_res + i + 1] );
 }
 
+void Blip_Synth_::build_phases()
+{
+    // Same taps as the scalar Blip_Synth::offset_resampled(): the first half runs forward
+    // through the impulse at 'blip_res - phase', the second half backward through 'phase'.
+    int const half = width / 2;
+    for ( int phase = 0; phase < blip_res; phase++ )
+    {
+        short* row = phases + phase * width;
+        for ( int i = 0; i < half; i++ )
+        {
+            row [i]             = impulses [blip_res - phase + blip_res * i];
+            row [width - 1 - i] = impulses [phase + blip_res * i];
+        }
+    }
+}
+
 void Blip_Synth_::treble_eq( blip_eq_t const& eq )
 {
     float fimpulse [blip_res / 2 * (blip_widest_impulse_ - 1) + blip_res * 2];
@@ -418,7 +436,26 @@ blip_nsamp_t Blip_Buffer::read_samples( blip_amplitude_t* BLIP_RESTRICT out, bli
         int const bass = BLIP_READER_BASS( *this );
         BLIP_READER_BEGIN( reader, *this );
 
-        if ( !stereo )
+        blip_clamp_kernel_t clamp = blip_kernels().clamp;
+        if ( !stereo && clamp )
+        {
+            // The integrator is serial, so only the clamp runs in blocks
+            int const block_size = 256;
+            blip_long block [block_size];
+            for ( blip_nsamp_t n = count; n; )
+            {
+                blip_nsamp_t const m = n < block_size ? n : block_size;
+                for ( blip_nsamp_t i = 0; i < m; i++ )
+                {
+                    BLIP_READER_NEXT( reader, bass );
+                    block [i] = BLIP_READER_READ( reader );
+                }
+                clamp( block, out, m );
+                out += m;
+                n -= m;
+            }
+        }
+        else if ( !stereo )
         {
             for ( blip_nsamp_t n = count; n; --n )
             {
@@ -458,6 +495,12 @@ void Blip_Buffer::mix_samples( blip_amplitude_t const* in, blip_nsamp_t count )
 
     buf_t_* out = buffer_ + (offset_ >> BLIP_BUFFER_ACCURACY) + blip_widest_impulse_ / 2;
 
+    if ( blip_mix_kernel_t kernel = blip_kernels().mix )
+    {
+        out [count] -= kernel( in, out, count );
+        return;
+    }
+
     int const sample_shift = blip_sample_bits - 16;
     int prev = 0;
     while ( count-- )
@@ -480,6 +523,12 @@ void Blip_Buffer::mix_samples_raw(blip_amplitude_t const* in, blip_nsamp_t count
 
     buf_t_* out = buffer_ + (offset_ >> BLIP_BUFFER_ACCURACY);
 
+    if (blip_mix_kernel_t kernel = blip_kernels().mix)
+    {
+        out[count] -= kernel(in, out, count);
+        return;
+    }
+
     int const sample_shift = blip_sample_bits - 16;
     int prev = 0;
     while (count--)
@@ -491,3 +540,19 @@ void Blip_Buffer::mix_samples_raw(blip_amplitude_t const* in, blip_nsamp_t count
     }
     *out -= prev;
 }
+
+void Blip_Buffer::mix_deltas(Blip_Buffer& other, blip_nclock_t t)
+{
+    assert(other.offset_ == offset_ && other.factor_ == factor_);
+
+    blip_nsamp_t count = (other.resampled_time(t) >> BLIP_BUFFER_ACCURACY) + blip_buffer_extra_;
+    blip_nsamp_t const size = (buffer_size_ < other.buffer_size_ ? buffer_size_ : other.buffer_size_) + blip_buffer_extra_;
+    if (count > size)
+        count = size;
+
+    for (blip_nsamp_t i = 0; i < count; ++i)
+    {
+        buffer_[i] += other.buffer_[i];
+        other.buffer_[i] = 0;
+    }
+}
@@ -20,6 +20,8 @@
 
     // internal
     #include <limits.h>
+    #include <string.h>
+    #include "../APU/Simd.h"
     #if INT_MAX < 0x7FFFFFFF
         #error "int must be at least 32 bits"
     #endif
@@ -103,6 +105,22 @@ public:
     /// and is not delayed by the impulse width.
     void mix_samples_raw(blip_amplitude_t const* buf, blip_nsamp_t count);
 
+    /// Add everything synthesized into 'other' during a frame of 't' clocks
+    /// (before end_frame() on either buffer), then clear it from 'other'.
+    /// Both buffers must have the same sample rate, clock rate and time offset.
+    /// Since deltas are summed, the result is identical to synthesizing directly into this buffer.
+    void mix_deltas(Blip_Buffer& other, blip_nclock_t t);
+
+    /// Copy the time offset of 'other', so that deltas land on the same samples in both buffers.
+    void sync_time(Blip_Buffer const& other) { offset_ = other.offset_; }
+
+    /// Save or restore, through 'state' (a CStateArchive), everything that is not silence
+    /// yet: unread samples, deltas synthesized during the current time frame, which has
+    /// lasted 'time' clocks so far, and the reader's integrator. The buffer must be set up
+    /// the same way as when it was saved.
+    template<class State>
+    void serialize_state( State& state, blip_nclock_t time = 0 );
+
     // not documented yet
     void set_modified() { modified_ = 1; }
     int clear_modified() { int b = modified_; modified_ = 0; return b; }
@@ -184,16 +202,40 @@ private:
         int delta_factor;
 
         void volume_unit( double );
-        Blip_Synth_( short* impulses, int width );
+        Blip_Synth_( short* impulses, short* phases, int width );
         void treble_eq( blip_eq_t const& );
     private:
         double volume_unit_;
         short* const impulses;
+        short* const phases;
         int const width;
         blip_long kernel_unit;
         int impulses_size() const { return blip_res / 2 * width + 1; }
         void adjust_impulse();
+        void build_phases();
+    };
+
+    /// Adds 'width' taps of one impulse phase, scaled by 'delta', to 'out'.
+    /// 'row' holds the taps in output order (see Blip_Synth::phases).
+    typedef void (*blip_impulse_kernel_t)( short const* row, int width, blip_long delta, blip_long* out );
+
+    /// Clamps 'count' integrated samples (already shifted to 16 bits) to 16 bits and stores them.
+    typedef void (*blip_clamp_kernel_t)( blip_long const* in, blip_amplitude_t* out, blip_ulong count );
+
+    /// Adds the first difference of 'count' samples to 'out' (see Blip_Buffer::mix_samples),
+    /// and returns the last sample, shifted to internal resolution.
+    typedef blip_long (*blip_mix_kernel_t)( blip_amplitude_t const* in, blip_long* out, blip_ulong count );
+
+    /// Vectorized kernels of every SIMD level (see APU/Simd.h), null where the scalar code runs.
+    struct blip_kernels_t {
+        blip_impulse_kernel_t impulse;
+        blip_clamp_kernel_t clamp;
+        blip_mix_kernel_t mix;
     };
+    extern blip_kernels_t const blip_kernels_ [SIMD_COUNT];
+
+    /// Kernels of the SIMD level selected at runtime.
+    inline blip_kernels_t const& blip_kernels() { return blip_kernels_ [GetSimdLevel()]; }
 
 // Quality level. Start with blip_good_quality.
 const int blip_med_quality  = 8;
@@ -221,6 +263,10 @@ public:
     /// this acts like subtracting `dc_amp` from all future calls to update().
     void center_dc(int dc_amp) { impl.last_amp = dc_amp; }
 
+    /// Save or restore the last amplitude passed to update(), through 'state' (a CStateArchive).
+    template<class State>
+    void serialize_state( State& state ) { state( impl.last_amp ); }
+
     // Update amplitude of waveform at given time. Using this requires a separate
     // Blip_Synth for each waveform.
     // The actual output value (assuming no DC removal) is around
@@ -249,13 +295,16 @@ private:
     Blip_Synth_ impl;
     typedef short imp_t;
     imp_t impulses [blip_res * (quality / 2) + 1];
+    /// The taps of every phase of 'impulses', one contiguous row of 'quality' taps per phase,
+    /// so a vector kernel can insert an impulse without a strided gather.
+    imp_t phases [blip_res * quality];
 public:
-    Blip_Synth() : impl(impulses, quality) {}
+    Blip_Synth() : impl(impulses, phases, quality) {}
 
     // When update(...Amplitude) is called,
     // the actual output value (assuming no DC removal) is around
     // (Amplitude / range) * volume * 65536.
-    Blip_Synth(double volume, unsigned int range) : impl( impulses, quality ) {
+    Blip_Synth(double volume, unsigned int range) : impl( impulses, phases, quality ) {
         this->volume(volume, range);
     }
     // Cannot be moved or copied because this struct is self-referencing:
@@ -395,6 +444,12 @@ inline void Blip_Synth<quality>::offset_resampled( blip_resampled_time_t time,
     int const rev = fwd + quality - 2;
     int const mid = quality / 2 - 1;
 
+    if ( blip_impulse_kernel_t kernel = blip_kernels().impulse )
+    {
+        kernel( phases + phase * quality, quality, delta, buf + fwd );
+        return;
+    }
+
     imp_t const* BLIP_RESTRICT imp = impulses + blip_res - phase;
 
     #if defined (_M_IX86) || defined (_M_IA64) || defined (__i486__) || \
@@ -514,6 +569,21 @@ inline int  Blip_Buffer::output_latency() const { return blip_widest_impulse_ /
 inline blip_ulong Blip_Buffer::clock_rate() const     { return clock_rate_; }
 inline void Blip_Buffer::clock_rate( blip_ulong cps ) { factor_ = clock_rate_factor( clock_rate_ = cps ); }
 
+template<class State>
+void Blip_Buffer::serialize_state( State& state, blip_nclock_t time )
+{
+    state( offset_, reader_accum_, modified_ );
+    if ( !buffer_ )
+        return;
+
+    // Nothing synthesized so far reaches past 'count'
+    blip_nsamp_t count = (resampled_time( time ) >> BLIP_BUFFER_ACCURACY) + blip_buffer_extra_;
+    assert( count <= buffer_size_ + blip_buffer_extra_ );
+    state.Bytes( buffer_, count * sizeof *buffer_ );
+    if ( state.IsLoading() )
+        memset( buffer_ + count, 0, (buffer_size_ + blip_buffer_extra_ - count) * sizeof *buffer_ );
+}
+
 inline int Blip_Reader::begin( Blip_Buffer& blip_buf )
 {
     buf = blip_buf.buffer_;
@@ -0,0 +1,228 @@
+// Vectorized Blip_Buffer kernels, selected at runtime.
+
+#include "Blip_Buffer.h"
+
+#if defined(SIMD_HAS_SSE2) || defined(SIMD_HAS_AVX2)
+    #include <immintrin.h>
+#endif
+#ifdef SIMD_HAS_NEON
+    #include <arm_neon.h>
+#endif
+
+// Every kernel produces exactly the same buffer contents and samples as the scalar
+// code in Blip_Buffer.h and Blip_Buffer.cpp, including the wraparound of 32-bit
+// products. SIMD_NONE runs that scalar code unchanged.
+
+namespace {
+
+int const sample_shift = blip_sample_bits - 16;
+
+// SSE2
+
+#ifdef SIMD_HAS_SSE2
+
+// Low 32 bits of the products of four 32-bit lanes (SSE2 has no pmulld)
+inline __m128i mullo_sse2( __m128i a, __m128i b )
+{
+    __m128i even = _mm_mul_epu32( a, b );
+    __m128i odd  = _mm_mul_epu32( _mm_srli_epi64( a, 32 ), _mm_srli_epi64( b, 32 ) );
+    return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ),
+            _mm_shuffle_epi32( odd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+}
+
+void impulse_sse2( short const* row, int width, blip_long delta, blip_long* out )
+{
+    __m128i const d = _mm_set1_epi32( delta );
+    for ( int i = 0; i < width; i += 4 )
+    {
+        __m128i imp = _mm_loadl_epi64( (__m128i const*) (row + i) );
+        imp = _mm_srai_epi32( _mm_unpacklo_epi16( imp, imp ), 16 );
+        __m128i* p = (__m128i*) (out + i);
+        _mm_storeu_si128( p, _mm_add_epi32( _mm_loadu_si128( p ), mullo_sse2( imp, d ) ) );
+    }
+}
+
+void clamp_sse2( blip_long const* in, blip_amplitude_t* out, blip_ulong count )
+{
+    blip_ulong i = 0;
+    for ( ; i + 8 <= count; i += 8 )
+    {
+        __m128i lo = _mm_loadu_si128( (__m128i const*) (in + i) );
+        __m128i hi = _mm_loadu_si128( (__m128i const*) (in + i + 4) );
+        _mm_storeu_si128( (__m128i*) (out + i), _mm_packs_epi32( lo, hi ) );
+    }
+    for ( ; i < count; i++ )
+    {
+        blip_long s = in [i];
+        if ( (blip_amplitude_t) s != s )
+            s = 0x7FFF - (s >> 24);
+        out [i] = (blip_amplitude_t) s;
+    }
+}
+
+blip_long mix_sse2( blip_amplitude_t const* in, blip_long* out, blip_ulong count )
+{
+    __m128i prev = _mm_setzero_si128(); // previous sample in lane 0
+    blip_ulong i = 0;
+    for ( ; i + 8 <= count; i += 8 )
+    {
+        __m128i x  = _mm_loadu_si128( (__m128i const*) (in + i) );
+        __m128i s0 = _mm_slli_epi32( _mm_srai_epi32( _mm_unpacklo_epi16( x, x ), 16 ), sample_shift );
+        __m128i s1 = _mm_slli_epi32( _mm_srai_epi32( _mm_unpackhi_epi16( x, x ), 16 ), sample_shift );
+        __m128i p0 = _mm_or_si128( _mm_slli_si128( s0, 4 ), prev );
+        __m128i p1 = _mm_or_si128( _mm_slli_si128( s1, 4 ), _mm_srli_si128( s0, 12 ) );
+        __m128i* o = (__m128i*) (out + i);
+        _mm_storeu_si128( o,     _mm_add_epi32( _mm_loadu_si128( o ),     _mm_sub_epi32( s0, p0 ) ) );
+        _mm_storeu_si128( o + 1, _mm_add_epi32( _mm_loadu_si128( o + 1 ), _mm_sub_epi32( s1, p1 ) ) );
+        prev = _mm_srli_si128( s1, 12 );
+    }
+    blip_long last = _mm_cvtsi128_si32( prev );
+    for ( ; i < count; i++ )
+    {
+        blip_long s = (blip_long) in [i] << sample_shift;
+        out [i] += s - last;
+        last = s;
+    }
+    return last;
+}
+
+#endif
+
+// AVX2
+
+#ifdef SIMD_HAS_AVX2
+
+SIMD_TARGET_AVX2 void impulse_avx2( short const* row, int width, blip_long delta, blip_long* out )
+{
+    int i = 0;
+    __m256i const d = _mm256_set1_epi32( delta );
+    for ( ; i + 8 <= width; i += 8 )
+    {
+        __m256i imp = _mm256_cvtepi16_epi32( _mm_loadu_si128( (__m128i const*) (row + i) ) );
+        __m256i* p = (__m256i*) (out + i);
+        _mm256_storeu_si256( p, _mm256_add_epi32( _mm256_loadu_si256( p ), _mm256_mullo_epi32( imp, d ) ) );
+    }
+    if ( i < width )
+    {
+        __m128i imp = _mm_cvtepi16_epi32( _mm_loadl_epi64( (__m128i const*) (row + i) ) );
+        __m128i* p = (__m128i*) (out + i);
+        _mm_storeu_si128( p, _mm_add_epi32( _mm_loadu_si128( p ), _mm_mullo_epi32( imp, _mm256_castsi256_si128( d ) ) ) );
+    }
+}
+
+SIMD_TARGET_AVX2 void clamp_avx2( blip_long const* in, blip_amplitude_t* out, blip_ulong count )
+{
+    blip_ulong i = 0;
+    for ( ; i + 16 <= count; i += 16 )
+    {
+        __m256i lo = _mm256_loadu_si256( (__m256i const*) (in + i) );
+        __m256i hi = _mm256_loadu_si256( (__m256i const*) (in + i + 8) );
+        __m256i packed = _mm256_permute4x64_epi64( _mm256_packs_epi32( lo, hi ), 0xD8 );
+        _mm256_storeu_si256( (__m256i*) (out + i), packed );
+    }
+    for ( ; i < count; i++ )
+    {
+        blip_long s = in [i];
+        if ( (blip_amplitude_t) s != s )
+            s = 0x7FFF - (s >> 24);
+        out [i] = (blip_amplitude_t) s;
+    }
+}
+
+SIMD_TARGET_AVX2 blip_long mix_avx2( blip_amplitude_t const* in, blip_long* out, blip_ulong count )
+{
+    __m256i const rotate = _mm256_setr_epi32( 7, 0, 1, 2, 3, 4, 5, 6 );
+    __m256i prev = _mm256_setzero_si256(); // previous sample in every lane
+    blip_ulong i = 0;
+    for ( ; i + 8 <= count; i += 8 )
+    {
+        __m256i s = _mm256_slli_epi32( _mm256_cvtepi16_epi32( _mm_loadu_si128( (__m128i const*) (in + i) ) ), sample_shift );
+        __m256i p = _mm256_blend_epi32( _mm256_permutevar8x32_epi32( s, rotate ), prev, 0x01 );
+        __m256i* o = (__m256i*) (out + i);
+        _mm256_storeu_si256( o, _mm256_add_epi32( _mm256_loadu_si256( o ), _mm256_sub_epi32( s, p ) ) );
+        prev = _mm256_permutevar8x32_epi32( s, _mm256_set1_epi32( 7 ) );
+    }
+    blip_long last = _mm_cvtsi128_si32( _mm256_castsi256_si128( prev ) );
+    for ( ; i < count; i++ )
+    {
+        blip_long s = (blip_long) in [i] << sample_shift;
+        out [i] += s - last;
+        last = s;
+    }
+    return last;
+}
+
+#endif
+
+// NEON
+
+#ifdef SIMD_HAS_NEON
+
+void impulse_neon( short const* row, int width, blip_long delta, blip_long* out )
+{
+    for ( int i = 0; i < width; i += 4 )
+    {
+        int32x4_t imp = vmovl_s16( vld1_s16( row + i ) );
+        vst1q_s32( out + i, vmlaq_n_s32( vld1q_s32( out + i ), imp, delta ) );
+    }
+}
+
+void clamp_neon( blip_long const* in, blip_amplitude_t* out, blip_ulong count )
+{
+    blip_ulong i = 0;
+    for ( ; i + 8 <= count; i += 8 )
+        vst1q_s16( out + i, vcombine_s16( vqmovn_s32( vld1q_s32( in + i ) ), vqmovn_s32( vld1q_s32( in + i + 4 ) ) ) );
+    for ( ; i < count; i++ )
+    {
+        blip_long s = in [i];
+        if ( (blip_amplitude_t) s != s )
+            s = 0x7FFF - (s >> 24);
+        out [i] = (blip_amplitude_t) s;
+    }
+}
+
+blip_long mix_neon( blip_amplitude_t const* in, blip_long* out, blip_ulong count )
+{
+    int32x4_t prev = vdupq_n_s32( 0 ); // previous sample in lane 3
+    blip_ulong i = 0;
+    for ( ; i + 8 <= count; i += 8 )
+    {
+        int16x8_t x = vld1q_s16( in + i );
+        int32x4_t s0 = vshlq_n_s32( vmovl_s16( vget_low_s16( x ) ), sample_shift );
+        int32x4_t s1 = vshlq_n_s32( vmovl_s16( vget_high_s16( x ) ), sample_shift );
+        vst1q_s32( out + i,     vaddq_s32( vld1q_s32( out + i ),     vsubq_s32( s0, vextq_s32( prev, s0, 3 ) ) ) );
+        vst1q_s32( out + i + 4, vaddq_s32( vld1q_s32( out + i + 4 ), vsubq_s32( s1, vextq_s32( s0, s1, 3 ) ) ) );
+        prev = s1;
+    }
+    blip_long last = vgetq_lane_s32( prev, 3 );
+    for ( ; i < count; i++ )
+    {
+        blip_long s = (blip_long) in [i] << sample_shift;
+        out [i] += s - last;
+        last = s;
+    }
+    return last;
+}
+
+#endif
+
+} // namespace
+
+blip_kernels_t const blip_kernels_ [SIMD_COUNT] = {
+    { nullptr, nullptr, nullptr },
+#ifdef SIMD_HAS_SSE2
+    { impulse_sse2, clamp_sse2, mix_sse2 },
+#else
+    { nullptr, nullptr, nullptr },
+#endif
+#ifdef SIMD_HAS_AVX2
+    { impulse_avx2, clamp_avx2, mix_avx2 },
+#else
+    { nullptr, nullptr, nullptr },
+#endif
+#ifdef SIMD_HAS_NEON
+    { impulse_neon, clamp_neon, mix_neon },
+#else
+    { nullptr, nullptr, nullptr },
+#endif
+};
@@ -37,6 +37,7 @@
 #include "ChannelHandler.h"
 #include "APU/APU.h"
 #include "InstHandler.h"		// // //
+#include "APU/StateArchive.h"		// // //
 
 /*
  * Class CChannelHandler
@@ -46,6 +47,7 @@
 CChannelHandler::CChannelHandler(int MaxPeriod, int MaxVolume) : 
 	m_iChannelID(0), 
 	m_iInstTypeCurrent(INST_NONE),		// // //
+	m_iInstHandlerType(INST_NONE),		// // //
 	m_iInstrument(0),
 	m_pNoteLookupTable(nullptr),
 	m_pVibratoTable(nullptr),
@@ -133,7 +135,9 @@ void CChannelHandler::ResetChannel()
 	// Instrument 
 	m_iInstrument		= MAX_INSTRUMENTS;
 	m_iInstTypeCurrent	= INST_NONE;		// // //
+	m_iInstHandlerType	= INST_NONE;		// // //
 	m_pInstHandler.reset();		// // //
+	m_pInstrument.reset();		// // //
 
 	// Volume 
 	m_iVolume			= VOL_COLUMN_MAX;
@@ -189,6 +193,40 @@ void CChannelHandler::ResetChannel()
 	ClearRegisters();
 }
 
+void CChannelHandler::SerializeState(CStateArchive &State)		// // //
+{
+	bool HasHandler = m_pInstHandler != nullptr;
+	State(m_iInstTypeCurrent, m_iInstHandlerType, HasHandler);
+	State.Object(m_pInstrument);
+
+	if (State.IsLoading()) {
+		// Create and load the instrument handler the way HandleInstrument did, then restore its state
+		const inst_type_t Current = m_iInstTypeCurrent;
+		m_pInstHandler.reset();
+		m_iInstTypeCurrent = INST_NONE;
+		if (HasHandler)
+			CreateInstHandler(m_iInstHandlerType);
+		m_iInstTypeCurrent = Current;
+		if (HasHandler != (m_pInstHandler != nullptr)) {
+			State.Reject();
+			return;
+		}
+		if (m_pInstHandler && m_pInstrument)
+			m_pInstHandler->LoadInstrument(m_pInstrument);
+	}
+	if (m_pInstHandler)
+		m_pInstHandler->SerializeState(State);
+
+	State(m_bTrigger, m_bRelease, m_bGate, m_iInstrument, m_bForceReload);
+	State(m_iNote, m_iPeriod, m_iInstVolume, m_iInstDuty, m_iVolume, m_iDutyPeriod, m_iEchoBuffer);
+	State(m_bDelayEnabled, m_cDelayCounter, m_iDelayEffColumns, m_cnDelayed);
+	State(m_iVibratoDepth, m_iVibratoSpeed, m_iVibratoPhase, m_iTremoloDepth, m_iTremoloSpeed, m_iTremoloPhase);
+	State(m_iEffect, m_iEffectParam, m_iArpState, m_iPortaTo, m_iPortaSpeed);
+	State(m_iNoteCut, m_iNoteRelease, m_iNoteVolume, m_iDefaultVolume, m_iNewVolume);
+	State(m_iTranspose, m_bTransposeDown, m_iTransposeTarget, m_iHarmonic, m_iFinePitch);
+	State(m_iDefaultDuty, m_iVolSlide, m_iVolSlideTarget, m_iInstVolMacroEnabled);
+}
+
 CString CChannelHandler::GetStateString()		// // //
 {
 	CString log = "";
@@ -453,21 +491,22 @@ void CChannelHandler::HandleNoteData(stChanNote *pNoteData, int EffColumns)
 
 bool CChannelHandler::HandleInstrument(bool Trigger, bool NewInstrument)		// // //
 {
-	auto pDoc = m_pSoundGen->GetDocumentInterface();
-	if (!pDoc) return false;
-	std::shared_ptr<CInstrument> pInstrument = pDoc->GetInstrumentManager()->GetInstrument(m_iInstrument);
+	// // // The player reads the copy published by the editor, see CFamiTrackerDoc::PublishPlayback
+	std::shared_ptr<CInstrument> pInstrument = m_pSoundGen->GetPlaybackInstrument(m_iInstrument);
 	if (!pInstrument) return false;
 	
 	// load instrument here
 	inst_type_t instType = pInstrument->GetType();
-	if (NewInstrument)
-		CreateInstHandler(instType);
+	if (NewInstrument && CreateInstHandler(instType))
+		m_iInstHandlerType = instType;		// // //
 	m_iInstTypeCurrent = instType;
 
 	if (!m_pInstHandler)
 		return false;
-	if (NewInstrument)
+	if (NewInstrument) {
 		m_pInstHandler->LoadInstrument(pInstrument);
+		m_pInstrument = pInstrument;		// // //
+	}
 	if (Trigger || m_bForceReload)
 		m_pInstHandler->TriggerInstrument();
 
@@ -909,6 +948,13 @@ void CChannelHandler::ProcessChannel()
 		UpdateTargetVolumeSlide();
 	UpdateVibratoTremolo();
 	UpdateEffects();
+	if (m_pInstHandler && m_pInstrument && m_iInstrument != MAX_INSTRUMENTS) {		// // // Pick up edits to the playing instrument
+		std::shared_ptr<CInstrument> pInstrument = m_pSoundGen->GetPlaybackInstrument(m_iInstrument);
+		if (pInstrument && pInstrument != m_pInstrument && pInstrument->GetType() == m_iInstTypeCurrent) {
+			m_pInstHandler->ReloadInstrument(pInstrument);
+			m_pInstrument = pInstrument;
+		}
+	}
 	if (m_pInstHandler) m_pInstHandler->UpdateInstrument();		// // //
 	// instruments are updated after running effects and before writing to sound registers
 }
@@ -1024,7 +1070,7 @@ int CChannelHandler::LimitVolume(int Volume) const		// // //
 		return 0;
 
 	Volume = std::max(0, std::min(m_iMaxVolume, Volume));
-	if (Volume == 0 && !theApp.GetSettings()->General.bCutVolume && m_iInstVolume > 0 && m_iVolume > 0)		// // //
+	if (Volume == 0 && !m_pSoundGen->GetSettings()->General.bCutVolume && m_iInstVolume > 0 && m_iVolume > 0)		// // //
 		return 1;
 	return Volume;
 }
@@ -1037,7 +1083,6 @@ void CChannelHandler::AddCycles(int count)
 void CChannelHandler::WriteRegister(uint16_t Reg, uint8_t Value)
 {
 	m_pAPU->Write(Reg, Value);
-	m_pSoundGen->WriteRegister(Reg, Value);		// This method is dead. Blame #ifdef WRITE_VGM.
 }
 
 void CChannelHandler::RegisterKeyState(int Note)
@@ -1118,6 +1163,11 @@ bool CChannelHandler::IsReleasing() const
 	return m_bRelease;
 }
 
+void CChannelHandler::SetSequencePlayPos(const CSequence *pSequence, int Pos)		// // //
+{
+	m_pSoundGen->SetSequencePlayPos(pSequence, Pos);
+}
+
 void CChannelHandler::SetInstVolMacroEnabled(bool Stat)
 {
 	m_iInstVolMacroEnabled = Stat;
@@ -32,11 +32,14 @@ static const int DUTY_AY8930_FROM_VRC6[] = { 1, 2, 2, 3, 3, 3, 3, 4 };		// Taken
 class CInstHandler;
 class stChannelState;
 class CSoundGen;		// // //
+class CStateArchive;		// // //
 
 #include "ChannelHandlerInterface.h"
 #include <memory>		// // //
 #include <cstdint>
 
+class CInstrument;		// // //
+
 /*!
 	\brief An implementation of the channel handler.
 */
@@ -101,6 +104,14 @@ public:
 		\param State Pointer to a channel state object.
 		\sa CSoundGen::ApplyGlobalState */
 	virtual void	ApplyChannelState(stChannelState *State);	// // //
+	/*!	\brief Saves or restores the playback state of the channel handler.
+		\details Together with CAPU::SaveState, this holds everything that decides the output of
+		later ticks, so that playback resumes exactly where the state was saved. Settings applied by
+		the sound generator, such as the note table and the pitch mode, are not archived. Derived
+		classes archive their own members after calling this method.
+		\param State The archive, which must have an object list.
+		\sa CSoundGen::SerializePlayerState */
+	virtual void	SerializeState(CStateArchive &State);		// // //
 
 	/*!	\brief Sets the channel handler's note lookup table.
 		\param pNoteLookupTable Pointer to the note lookup table. */
@@ -350,6 +361,10 @@ public:		// // //
 	unsigned char GetArpParam() const override;		// // //
 	bool	IsActive() const override;
 	bool	IsReleasing() const override;
+	/*!	\brief Reports the position of a running instrument sequence to the sound generator, for the sequence editor.
+		\param pSequence The sequence.
+		\param Pos The sequence position, or -1 if the sequence has ended. */
+	void	SetSequencePlayPos(const CSequence *pSequence, int Pos) override;		// // //
 
 private:
 	void	UpdateNoteCut();
@@ -540,8 +555,16 @@ protected:
 		instruments not native to the current sound channel.
 		\sa CChannelHandler::ConvertDuty */
 	inst_type_t		m_iInstTypeCurrent;
+	/*!	\brief The instrument type the current instrument handler was created for.
+		\details Restoring a saved state creates the instrument handler again from this type. */
+	inst_type_t		m_iInstHandlerType;			// // //
 	/*!	\brief A pointer to the currently installed instrument handler. */
 	std::unique_ptr<CInstHandler>	m_pInstHandler;				// // //
+	/*!	\brief The published copy of the instrument last loaded into the instrument handler.
+		\details When the editor publishes a newer copy of the same instrument, the channel
+		handler reloads it on its next tick, so that edits are heard while a note plays.
+		\sa CInstHandler::ReloadInstrument */
+	std::shared_ptr<CInstrument>	m_pInstrument;				// // //
 
 	/*!	\brief The maximum pitch register value of the channel. */
 	int				m_iMaxPeriod;
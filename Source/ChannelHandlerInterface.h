@@ -20,6 +20,7 @@
 
 #pragma once
 
+class CSequence;		// // //
 
 /*!
 	\brief A pure virtual interface for channel handlers.
@@ -49,6 +50,8 @@ public:
 
 	virtual bool	IsActive() const = 0;
 	virtual bool	IsReleasing() const = 0;
+
+	virtual void	SetSequencePlayPos(const CSequence *, int) = 0;		// // //
 };
 
 class CDSample;
@@ -30,9 +30,11 @@
 #include "ChannelHandler.h"
 #include "Channels2A03.h"
 #include "Settings.h"
+#include "SoundGen.h"		// // //
 #include "InstHandler.h"		// // //
 #include "SeqInstHandler.h"		// // //
 #include "InstHandlerDPCM.h"		// // //
+#include "APU/StateArchive.h"		// // //
 
 CChannelHandler2A03::CChannelHandler2A03() :
 	CChannelHandler(0x7FF, 0x0F),
@@ -128,6 +130,12 @@ void CChannelHandler2A03::ResetChannel()
 	m_iLengthCounter = 1;
 }
 
+void CChannelHandler2A03::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler::SerializeState(State);
+	State(m_bHardwareEnvelope, m_bEnvelopeLoop, m_bResetEnvelope, m_iLengthCounter);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 // // // 2A03 Square
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -195,6 +203,12 @@ void C2A03Square::SetChannelID(int ID)		// // //
 	m_iChannel = ID - CHANID_2A03_SQUARE1;
 }
 
+void C2A03Square::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler2A03::SerializeState(State);
+	State(m_cSweep, m_bSweeping, m_iSweep, m_iLastPeriod);
+}
+
 int C2A03Square::ConvertDuty(int Duty)		// // //
 {
 	switch (m_iInstTypeCurrent) {
@@ -320,6 +334,12 @@ void CTriangleChan::ResetChannel()
 	m_iLinearCounter = -1;
 }
 
+void CTriangleChan::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler2A03::SerializeState(State);
+	State(m_iLinearCounter);
+}
+
 int CTriangleChan::GetChannelVolume() const
 {
 	return m_iVolume ? VOL_COLUMN_MAX : 0;
@@ -643,6 +663,13 @@ bool CDPCMChan::CreateInstHandler(inst_type_t Type)
 	return false;
 }
 
+void CDPCMChan::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler::SerializeState(State);
+	State(m_cDAC, m_iLoop, m_iOffset, m_iSampleLength, m_iLoopOffset, m_iLoopLength);
+	State(mRetriggerPeriod, mRetriggerCtr, m_iCustomPitch, mTriggerSample, mEnabled);
+}
+
 void CDPCMChan::resetPhase()
 {
 	// Trigger the sample again
@@ -724,7 +751,7 @@ void CDPCMChan::RefreshChannel()
 		// Cut sample
 		WriteRegister(0x4015, 0x0F);
 
-		if (!theApp.GetSettings()->General.bNoDPCMReset || theApp.IsPlaying()) {
+		if (!m_pSoundGen->GetSettings()->General.bNoDPCMReset || m_pSoundGen->IsPlaying()) {
 			WriteRegister(0x4011, 0);	// regain full volume for TN
 		}
 
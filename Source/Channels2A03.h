@@ -28,6 +28,7 @@ class CChannelHandler2A03 : public CChannelHandler {
 public:
 	CChannelHandler2A03();
 	virtual void ResetChannel();
+	void	SerializeState(CStateArchive &State) override;		// // //
 
 protected:
 	void	HandleNoteData(stChanNote* pNoteData, int EffColumns) override;
@@ -51,6 +52,7 @@ public:
 	C2A03Square();
 	void	RefreshChannel() override;
 	void	SetChannelID(int ID) override;		// // //
+	void	SerializeState(CStateArchive &State) override;		// // //
 	int getDutyMax() const override;
 protected:
 	static const char MAX_DUTY;
@@ -79,6 +81,7 @@ public:
 	CTriangleChan();
 	void	RefreshChannel() override;
 	void	ResetChannel() override;		// // //
+	void	SerializeState(CStateArchive &State) override;		// // //
 	int		GetChannelVolume() const override;		// // //
 protected:
 	bool	HandleEffect(effect_t EffNum, unsigned char EffParam) override;		// // //
@@ -114,6 +117,7 @@ class CDPCMChan : public CChannelHandler, public CChannelHandlerInterfaceDPCM {
 public:
 	CDPCMChan();		// // //
 	void	RefreshChannel() override;
+	void	SerializeState(CStateArchive &State) override;		// // //
 	int		GetChannelVolume() const override;		// // //
 
 	void WriteDCOffset(unsigned char Delta);		// // //
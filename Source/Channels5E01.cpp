@@ -32,9 +32,11 @@
 #include "ChannelHandler.h"
 #include "Channels5E01.h"
 #include "Settings.h"
+#include "SoundGen.h"		// // //
 #include "InstHandler.h"		// // //
 #include "SeqInstHandler.h"		// // //
 #include "InstHandlerDPCM.h"		// // //
+#include "APU/StateArchive.h"		// // //
 
 CChannelHandler5E01::CChannelHandler5E01() :
 	CChannelHandler(0x7FF, 0x0F),
@@ -130,6 +132,12 @@ void CChannelHandler5E01::ResetChannel()
 	m_iLengthCounter = 1;
 }
 
+void CChannelHandler5E01::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler::SerializeState(State);
+	State(m_bHardwareEnvelope, m_bEnvelopeLoop, m_bResetEnvelope, m_iLengthCounter);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 // // // 5E01 Square
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -197,6 +205,12 @@ void C5E01Square::SetChannelID(int ID)		// // //
 	m_iChannel = ID - CHANID_5E01_SQUARE1;
 }
 
+void C5E01Square::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler5E01::SerializeState(State);
+	State(m_cSweep, m_bSweeping, m_iSweep, m_iLastPeriod);
+}
+
 int C5E01Square::ConvertDuty(int Duty)		// // //
 {
 	switch (m_iInstTypeCurrent) {
@@ -324,6 +338,12 @@ void C5E01WaveformChan::ResetChannel()
 	m_iLinearCounter = -1;
 }
 
+void C5E01WaveformChan::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler5E01::SerializeState(State);
+	State(m_iLinearCounter);
+}
+
 int C5E01WaveformChan::GetChannelVolume() const
 {
 	return m_iVolume ? VOL_COLUMN_MAX : 0;
@@ -601,6 +621,13 @@ bool C5E01DPCMChan::CreateInstHandler(inst_type_t Type)
 	return false;
 }
 
+void C5E01DPCMChan::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler::SerializeState(State);
+	State(m_cDAC, m_iLoop, m_iOffset, m_iSampleLength, m_iLoopOffset, m_iLoopLength);
+	State(mRetriggerPeriod, mRetriggerCtr, m_iCustomPitch, mTriggerSample, mEnabled);
+}
+
 void C5E01DPCMChan::resetPhase()
 {
 	// Trigger the sample again
@@ -673,7 +700,7 @@ void C5E01DPCMChan::RefreshChannel()
 		// Cut sample
 		WriteRegister(0x4115, 0x0F);
 
-		if (!theApp.GetSettings()->General.bNoDPCMReset || theApp.IsPlaying()) {
+		if (!m_pSoundGen->GetSettings()->General.bNoDPCMReset || m_pSoundGen->IsPlaying()) {
 			WriteRegister(0x4111, 0);	// regain full volume for TN
 		}
 
@@ -30,6 +30,7 @@ class CChannelHandler5E01 : public CChannelHandler {
 public:
 	CChannelHandler5E01();
 	virtual void ResetChannel();
+	void	SerializeState(CStateArchive &State) override;		// // //
 
 protected:
 	void	HandleNoteData(stChanNote *pNoteData, int EffColumns) override;
@@ -53,6 +54,7 @@ public:
 	C5E01Square();
 	void	RefreshChannel() override;
 	void	SetChannelID(int ID) override;		// // //
+	void	SerializeState(CStateArchive &State) override;		// // //
 	int getDutyMax() const override;
 protected:
 	static const char MAX_DUTY;
@@ -81,6 +83,7 @@ public:
 	C5E01WaveformChan();
 	void	RefreshChannel() override;
 	void	ResetChannel() override;		// // //
+	void	SerializeState(CStateArchive &State) override;		// // //
 	int		GetChannelVolume() const override;		// // //
 	int   getDutyMax() const override;
 protected:
@@ -120,6 +123,7 @@ class C5E01DPCMChan : public CChannelHandler, public CChannelHandlerInterfaceDPC
 public:
 	C5E01DPCMChan();		// // //
 	void	RefreshChannel() override;
+	void	SerializeState(CStateArchive &State) override;		// // //
 	int		GetChannelVolume() const override;		// // //
 
 	void WriteDCOffset(unsigned char Delta);		// // //
@@ -35,16 +35,9 @@
 #include "SeqInstHandler.h"		// // //
 #include "InstrumentSID.h"
 #include "SeqInstHandlerSID.h"
+#include "APU/StateArchive.h"		// // //
 #include <map>
 
-// Static member variables, for the shared stuff in 6581
-unsigned char			  CChannelHandler6581::s_iGlobalVolume = 15;
-unsigned char			  CChannelHandler6581::s_iFilterResonance = 0;
-unsigned int			  CChannelHandler6581::s_iFilterCutoff = 0;
-unsigned char			  CChannelHandler6581::s_iFilterMode = 0;
-unsigned char			  CChannelHandler6581::s_iFilterEnable = 0;
-uint8_t					  CChannelHandler6581::s_iForceGate = 2;
-
 // Class functions
 
 
@@ -60,6 +53,7 @@ uint8_t					  CChannelHandler6581::s_iForceGate = 2;
 
 CChannelHandler6581::CChannelHandler6581() :
 	CChannelHandler(0xFFFF, 0xF),
+	m_pShared(std::make_shared<stSharedRegs>()),		// // //
 	m_bUpdate(false),
 	m_iEnvAD(0),
 	m_iEnvSR(0)
@@ -68,10 +62,24 @@ CChannelHandler6581::CChannelHandler6581() :
 	SetLinearPitch(true);
 }
 
+void CChannelHandler6581::ShareRegisters(const CChannelHandler6581 &Other)		// // //
+{
+	m_pShared = Other.m_pShared;
+}
+
 
 
 const char CChannelHandler6581::MAX_DUTY = 0x0F;
 
+void CChannelHandler6581::SerializeState(CStateArchive &State)		// // //
+{
+	// The volume and filter registers are shared by all channels, and archived by each of them
+	CChannelHandler::SerializeState(State);
+	State(m_pShared->GlobalVolume, m_pShared->FilterResonance, m_pShared->FilterCutoff, m_pShared->FilterMode, m_pShared->FilterEnable, m_pShared->ForceGate);
+	State(m_iPulseWidth, m_iTestBit, m_iGateBit, m_iRingBit, m_iSyncBit, m_iCurVol, m_iGateCounter);
+	State(m_iEnvAD, m_iEnvSR, m_bUpdate);
+}
+
 int CChannelHandler6581::GetDutyMax() const {
 	return MAX_DUTY;
 }
@@ -89,23 +97,23 @@ bool CChannelHandler6581::HandleEffect(effect_t EffNum, unsigned char EffParam)
 		break;
 	}
 	case EF_SID_FILTER_RESONANCE: {
-		s_iFilterResonance = EffParam & 0xF;
+		m_pShared->FilterResonance = EffParam & 0xF;
 		break;
 	}
 	case EF_SID_FILTER_CUTOFF_HI: {
-		s_iFilterCutoff = (s_iFilterCutoff & 0xFF0) | ((EffParam & 0xF));
+		m_pShared->FilterCutoff = (m_pShared->FilterCutoff & 0xFF0) | ((EffParam & 0xF));
 		break;
 	}
 	case EF_SID_FILTER_CUTOFF_LO: {
-		s_iFilterCutoff = (s_iFilterCutoff & 0xF) | ((EffParam & 0xFF) << 4);
+		m_pShared->FilterCutoff = (m_pShared->FilterCutoff & 0xF) | ((EffParam & 0xFF) << 4);
 		break;
 	}
 	case EF_SID_FILTER_MODE: {
 		if (EffParam == 0)
-			s_iFilterEnable &= ~(1U << (m_iChannelID - CHANID_6581_CH1));
+			m_pShared->FilterEnable &= ~(1U << (m_iChannelID - CHANID_6581_CH1));
 		else {
-			s_iFilterEnable |= (1U << (m_iChannelID - CHANID_6581_CH1));
-			s_iFilterMode = EffParam & 0xF;
+			m_pShared->FilterEnable |= (1U << (m_iChannelID - CHANID_6581_CH1));
+			m_pShared->FilterMode = EffParam & 0xF;
 		}
 		break;
 	}
@@ -120,7 +128,7 @@ bool CChannelHandler6581::HandleEffect(effect_t EffNum, unsigned char EffParam)
 		case 3:
 			m_iEnvSR = (m_iEnvSR & 0xF0) | (EffParam & 0x0F);
 		}
-		s_iFilterCutoff = (s_iFilterCutoff & 0xF) | ((EffParam & 0xFF) << 4);
+		m_pShared->FilterCutoff = (m_pShared->FilterCutoff & 0xF) | ((EffParam & 0xFF) << 4);
 		break;
 	}
 	case EF_SID_RING: {
@@ -131,7 +139,7 @@ bool CChannelHandler6581::HandleEffect(effect_t EffNum, unsigned char EffParam)
 		break;
 	}
 	case EF_SID_GATE_MODE: {
-		s_iForceGate = EffParam <= 2 ? EffParam : 2;
+		m_pShared->ForceGate = EffParam <= 2 ? EffParam : 2;
 	}
 	default: return CChannelHandler::HandleEffect(EffNum, EffParam);
 	}
@@ -160,7 +168,7 @@ void CChannelHandler6581::HandleNoteData(stChanNote* pNoteData, int EffColumns)
 		m_iGateCounter = 1;//((pNoteData->Instrument != HOLD_INSTRUMENT && pNoteData->Instrument != RELEASE_INSTRUMENT && pNoteData->Instrument != CUT_INSTRUMENT) || m_iGateBit == 0) ? 1 : 3;
 
 	//if (pNoteData->Vol < MAX_VOLUME) {
-	//	s_iGlobalVolume = pNoteData->Vol & 15;
+	//	m_pShared->GlobalVolume = pNoteData->Vol & 15;
 	//}
 }
 
@@ -217,12 +225,12 @@ void CChannelHandler6581::ResetChannel()
 	m_iGateBit = 0;
 	m_iTestBit = 0;
 	m_iGateCounter = 0;
-	s_iGlobalVolume = 15;
-	s_iFilterResonance = 0;
-	s_iFilterCutoff = 0;
-	s_iFilterMode = 0;
-	s_iFilterEnable = 0;
-	s_iForceGate = 2;
+	m_pShared->GlobalVolume = 15;
+	m_pShared->FilterResonance = 0;
+	m_pShared->FilterCutoff = 0;
+	m_pShared->FilterMode = 0;
+	m_pShared->FilterEnable = 0;
+	m_pShared->ForceGate = 2;
 	m_iEnvAD = 0;
 	m_iEnvSR = 0;
 	m_iCurVol = m_iVolume;
@@ -292,7 +300,7 @@ void CChannelHandler6581::RefreshChannel()
 
 	//if (m_iCurVol != m_iInstVolume && m_iInstVolume < MAX_VOLUME) {
 	//	m_iCurVol = m_iInstVolume;
-	//	s_iGlobalVolume = m_iInstVolume;
+	//	m_pShared->GlobalVolume = m_iInstVolume;
 	//}
 
 	if (m_iGateCounter > 0) {
@@ -311,7 +319,7 @@ void CChannelHandler6581::RefreshChannel()
 
 	unsigned char Waveform = (m_iDutyPeriod & 15) << 4;
 	Waveform |= 
-		s_iForceGate == 0x02 ? m_iGateBit : s_iForceGate
+		m_pShared->ForceGate == 0x02 ? m_iGateBit : m_pShared->ForceGate
 	| (m_iSyncBit << 1) | (m_iRingBit << 2) | (m_iTestBit << 3);
 
 	WriteReg(0x00 + Offset, LoFreq);
@@ -319,10 +327,10 @@ void CChannelHandler6581::RefreshChannel()
 	WriteReg(0x02 + Offset, LoPWM);
 	WriteReg(0x03 + Offset, HiPWM);
 	WriteReg(0x04 + Offset, Waveform);
-	WriteReg(0x15, (s_iFilterCutoff & 0xF));
-	WriteReg(0x16, (s_iFilterCutoff & 0xFF0) >> 4);
-	WriteReg(0x17, (s_iFilterResonance << 4) | s_iFilterEnable);
-	WriteReg(0x18, (s_iFilterMode << 4) | s_iGlobalVolume);
+	WriteReg(0x15, (m_pShared->FilterCutoff & 0xF));
+	WriteReg(0x16, (m_pShared->FilterCutoff & 0xFF0) >> 4);
+	WriteReg(0x17, (m_pShared->FilterResonance << 4) | m_pShared->FilterEnable);
+	WriteReg(0x18, (m_pShared->FilterMode << 4) | m_pShared->GlobalVolume);
 
 }
 
@@ -339,7 +347,7 @@ void CChannelHandler6581::SetPulseWidth(unsigned int PulseWidth)
 
 void CChannelHandler6581::SetFilterCutoff(unsigned int FilterCutoff)
 {
-	s_iFilterCutoff = FilterCutoff;
+	m_pShared->FilterCutoff = FilterCutoff;
 }
 
 unsigned int CChannelHandler6581::GetPulseWidth() const
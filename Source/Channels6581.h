@@ -31,6 +31,7 @@ public:
 	CChannelHandler6581();
 	void	ResetChannel() override;
 	void	RefreshChannel() override;
+	void	SerializeState(CStateArchive &State) override;		// // //
 
 	void  SetADSR(unsigned char EnvAD, unsigned char EnvSR) override final;
 	void  SetPulseWidth(unsigned int PulseWidth) override final;
@@ -58,14 +59,19 @@ protected:
 protected:
 	void WriteReg(int Reg, int Value);
 
-	// Static memebers
+	// Registers shared by the three voices of one chip
+public:
+	struct stSharedRegs {		// // //
+		unsigned char GlobalVolume = 15;
+		unsigned char FilterResonance = 0;
+		unsigned int  FilterCutoff = 0;
+		unsigned char FilterMode = 0;
+		unsigned char FilterEnable = 0;
+		uint8_t ForceGate = 2;
+	};
+	void	ShareRegisters(const CChannelHandler6581 &Other);		// // //
 protected:
-	static unsigned char s_iGlobalVolume;
-	static unsigned char s_iFilterResonance;
-	static unsigned int  s_iFilterCutoff;
-	static unsigned char s_iFilterMode;
-	static unsigned char s_iFilterEnable;
-	static uint8_t s_iForceGate;
+	std::shared_ptr<stSharedRegs> m_pShared;		// // //
 
 	// Instance members
 protected:
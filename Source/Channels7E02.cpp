@@ -30,9 +30,11 @@
 #include "ChannelHandler.h"
 #include "Channels7E02.h"
 #include "Settings.h"
+#include "SoundGen.h"		// // //
 #include "InstHandler.h"		// // //
 #include "SeqInstHandler.h"		// // //
 #include "InstHandlerDPCM.h"		// // //
+#include "APU/StateArchive.h"		// // //
 
 CChannelHandler7E02::CChannelHandler7E02() :
 	CChannelHandler(0x7FF, 0x0F),
@@ -128,6 +130,12 @@ void CChannelHandler7E02::ResetChannel()
 	m_iLengthCounter = 1;
 }
 
+void CChannelHandler7E02::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler::SerializeState(State);
+	State(m_bHardwareEnvelope, m_bEnvelopeLoop, m_bResetEnvelope, m_iLengthCounter);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 // // // 7E02 Square
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -195,6 +203,12 @@ void C7E02Square::SetChannelID(int ID)		// // //
 	m_iChannel = ID - CHANID_7E02_SQUARE1;
 }
 
+void C7E02Square::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler7E02::SerializeState(State);
+	State(m_cSweep, m_bSweeping, m_iSweep, m_iLastPeriod);
+}
+
 int C7E02Square::ConvertDuty(int Duty)		// // //
 {
 	switch (m_iInstTypeCurrent) {
@@ -334,6 +348,12 @@ void C7E02WaveformChan::ResetChannel()
 	m_iLinearCounter = -1;
 }
 
+void C7E02WaveformChan::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler7E02::SerializeState(State);
+	State(m_iLinearCounter);
+}
+
 int C7E02WaveformChan::GetChannelVolume() const
 {
 	return m_iVolume ? VOL_COLUMN_MAX : 0;
@@ -664,6 +684,13 @@ bool C7E02DPCMChan::CreateInstHandler(inst_type_t Type)
 	return false;
 }
 
+void C7E02DPCMChan::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler::SerializeState(State);
+	State(m_cDAC, m_iLoop, m_iOffset, m_iSampleLength, m_iLoopOffset, m_iLoopLength);
+	State(mRetriggerPeriod, mRetriggerCtr, m_iCustomPitch, mTriggerSample, mEnabled);
+}
+
 void C7E02DPCMChan::resetPhase()
 {
 	// Trigger the sample again
@@ -746,7 +773,7 @@ void C7E02DPCMChan::RefreshChannel()
 		// Cut sample
 		WriteRegister(0x4215, 0x0F);
 
-		if (!theApp.GetSettings()->General.bNoDPCMReset || theApp.IsPlaying()) {
+		if (!m_pSoundGen->GetSettings()->General.bNoDPCMReset || m_pSoundGen->IsPlaying()) {
 			WriteRegister(0x4211, 0);	// regain full volume for TN
 		}
 
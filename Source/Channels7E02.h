@@ -28,6 +28,7 @@ class CChannelHandler7E02 : public CChannelHandler {
 public:
 	CChannelHandler7E02();
 	virtual void ResetChannel();
+	void	SerializeState(CStateArchive &State) override;		// // //
 
 protected:
 	void	HandleNoteData(stChanNote* pNoteData, int EffColumns) override;
@@ -51,6 +52,7 @@ public:
 	C7E02Square();
 	void	RefreshChannel() override;
 	void	SetChannelID(int ID) override;		// // //
+	void	SerializeState(CStateArchive &State) override;		// // //
 	int getDutyMax() const override;
 protected:
 	static const char MAX_DUTY;
@@ -79,6 +81,7 @@ public:
 	C7E02WaveformChan();
 	void	RefreshChannel() override;
 	void	ResetChannel() override;		// // //
+	void	SerializeState(CStateArchive &State) override;		// // //
 	int		GetChannelVolume() const override;		// // //
 	int   getDutyMax() const override; // EFT
 protected:
@@ -117,6 +120,7 @@ class C7E02DPCMChan : public CChannelHandler, public CChannelHandlerInterfaceDPC
 public:
 	C7E02DPCMChan();		// // //
 	void	RefreshChannel() override;
+	void	SerializeState(CStateArchive &State) override;		// // //
 	int		GetChannelVolume() const override;		// // //
 
 	void WriteDCOffset(unsigned char Delta);		// // //
@@ -30,19 +30,9 @@
 #include "APU/APU.h"
 #include "InstHandler.h"		// // //
 #include "SeqInstHandlerS5B.h"		// // //
+#include "APU/StateArchive.h"		// // //
 #include <map>
 
-// Static member variables, for the shared stuff in AY
-int			  CChannelHandlerAY::s_iModes		= 0;
-int			  CChannelHandlerAY::s_iNoiseFreq	= 0;
-int			  CChannelHandlerAY::s_iNoisePrev	= -1;
-int			  CChannelHandlerAY::s_iDefaultNoise = 0;		// // //
-unsigned char CChannelHandlerAY::s_iEnvFreqHi	= 0;
-unsigned char CChannelHandlerAY::s_iEnvFreqLo	= 0;
-bool		  CChannelHandlerAY::s_bEnvTrigger	= false;		// // // 050B
-int			  CChannelHandlerAY::s_iEnvType	= 0;
-int			  CChannelHandlerAY::s_unused		= 0;		// // // 050B
-
 // Class functions
 
 void CChannelHandlerAY::SetMode(int Chan, int Square, int Noise)
@@ -51,17 +41,17 @@ void CChannelHandlerAY::SetMode(int Chan, int Square, int Noise)
 
 	switch (Chan) {
 		case 0:
-			s_iModes &= 0x36;
+			m_pShared->Modes &= 0x36;
 			break;
 		case 1:
-			s_iModes &= 0x2D;
+			m_pShared->Modes &= 0x2D;
 			break;
 		case 2:
-			s_iModes &= 0x1B;
+			m_pShared->Modes &= 0x1B;
 			break;
 	}
 
-	s_iModes |= (Noise << (3 + Chan)) | (Square << Chan);
+	m_pShared->Modes |= (Noise << (3 + Chan)) | (Square << Chan);
 }
 
 void CChannelHandlerAY::UpdateAutoEnvelope(int Period)		// // // 050B
@@ -74,34 +64,39 @@ void CChannelHandlerAY::UpdateAutoEnvelope(int Period)		// // // 050B
 		}
 		else if (m_iAutoEnvelopeShift < 8)
 			Period <<= 8 - m_iAutoEnvelopeShift;
-		s_iEnvFreqLo = Period & 0xFF;
-		s_iEnvFreqHi = Period >> 8;
+		m_pShared->EnvFreqLo = Period & 0xFF;
+		m_pShared->EnvFreqHi = Period >> 8;
 	}
 }
 
 void CChannelHandlerAY::UpdateRegs()		// // //
 {
 	// Done only once
-	if (s_iNoiseFreq != s_iNoisePrev)		// // //
-		WriteReg(0x06, (s_iNoisePrev = s_iNoiseFreq) ^ 0x1F);
-	WriteReg(0x07, s_iModes);
-	WriteReg(0x0B, s_iEnvFreqLo);
-	WriteReg(0x0C, s_iEnvFreqHi);
-	if (s_bEnvTrigger)		// // // 050B
-		WriteReg(0x0D, s_iEnvType);
-	s_bEnvTrigger = false;
+	if (m_pShared->NoiseFreq != m_pShared->NoisePrev)		// // //
+		WriteReg(0x06, (m_pShared->NoisePrev = m_pShared->NoiseFreq) ^ 0x1F);
+	WriteReg(0x07, m_pShared->Modes);
+	WriteReg(0x0B, m_pShared->EnvFreqLo);
+	WriteReg(0x0C, m_pShared->EnvFreqHi);
+	if (m_pShared->EnvTrigger)		// // // 050B
+		WriteReg(0x0D, m_pShared->EnvType);
+	m_pShared->EnvTrigger = false;
 }
 
 // Instance functions
 
 CChannelHandlerAY::CChannelHandlerAY() : 
 	CChannelHandler(0xFFF, 0x0F),
+	m_pShared(std::make_shared<stSharedRegs>()),		// // //
 	m_bEnvelopeEnabled(false),		// // // 050B
 	m_iAutoEnvelopeShift(0),		// // // 050B
 	m_bUpdate(false)
 {
 	m_iDefaultDuty = AY8910_MODE_SQUARE;		// // //
-	s_iDefaultNoise = 0;		// // //
+}
+
+void CChannelHandlerAY::ShareRegisters(const CChannelHandlerAY &Other)		// // //
+{
+	m_pShared = Other.m_pShared;
 }
 
 
@@ -114,6 +109,14 @@ static const std::map<EffParamT, ay8910_mode_t> VXX_TO_DUTY = {
 
 const char CChannelHandlerAY::MAX_DUTY = 0x07;		// = 1|2|4
 
+void CChannelHandlerAY::SerializeState(CStateArchive &State)		// // //
+{
+	// The mode, noise and envelope registers are shared by all channels, and archived by each of them
+	CChannelHandler::SerializeState(State);
+	State(m_pShared->Modes, m_pShared->NoiseFreq, m_pShared->NoisePrev, m_pShared->DefaultNoise, m_pShared->EnvFreqHi, m_pShared->EnvFreqLo, m_pShared->EnvTrigger, m_pShared->EnvType, m_pShared->Unused);
+	State(m_bEnvelopeEnabled, m_iAutoEnvelopeShift, m_bUpdate);
+}
+
 int CChannelHandlerAY::getDutyMax() const {
 	return MAX_DUTY;
 }
@@ -123,17 +126,17 @@ bool CChannelHandlerAY::HandleEffect(effect_t EffNum, EffParamT EffParam)
 {
 	switch (EffNum) {
 	case EF_SUNSOFT_NOISE: // W
-		s_iDefaultNoise = s_iNoiseFreq = EffParam & 0x1F;		// // // 050B
+		m_pShared->DefaultNoise = m_pShared->NoiseFreq = EffParam & 0x1F;		// // // 050B
 		break;
 	case EF_SUNSOFT_ENV_HI: // I
-		s_iEnvFreqHi = EffParam;
+		m_pShared->EnvFreqHi = EffParam;
 		break;
 	case EF_SUNSOFT_ENV_LO: // J
-		s_iEnvFreqLo = EffParam;
+		m_pShared->EnvFreqLo = EffParam;
 		break;
 	case EF_SUNSOFT_ENV_TYPE: // H
-		s_bEnvTrigger = true;		// // // 050B
-		s_iEnvType = EffParam & 0x0F;
+		m_pShared->EnvTrigger = true;		// // // 050B
+		m_pShared->EnvType = EffParam & 0x0F;
 		m_bUpdate = true;
 		m_bEnvelopeEnabled = EffParam != 0;
 		m_iAutoEnvelopeShift = EffParam >> 4;
@@ -177,7 +180,7 @@ void CChannelHandlerAY::HandleNote(int Note, int Octave)		// // //
 	*/
 
 	if (this->m_iDefaultDuty & AY8910_MODE_NOISE) {
-		s_iNoiseFreq = s_iDefaultNoise;
+		m_pShared->NoiseFreq = m_pShared->DefaultNoise;
 	}
 }
 
@@ -223,15 +226,15 @@ void CChannelHandlerAY::ResetChannel()
 	CChannelHandler::ResetChannel();
 
 	m_iDefaultDuty = m_iDutyPeriod = AY8910_MODE_SQUARE;
-	s_iDefaultNoise = s_iNoiseFreq = 0;		// // //
-	s_iNoisePrev = -1;		// // //
+	m_pShared->DefaultNoise = m_pShared->NoiseFreq = 0;		// // //
+	m_pShared->NoisePrev = -1;		// // //
 	m_bEnvelopeEnabled = false;
 	m_iAutoEnvelopeShift = 0;
-	s_iEnvFreqHi = 0;
-	s_iEnvFreqLo = 0;
-	s_iEnvType = 0;
-	s_unused = 0;		// // // 050B
-	s_bEnvTrigger = false;
+	m_pShared->EnvFreqHi = 0;
+	m_pShared->EnvFreqLo = 0;
+	m_pShared->EnvType = 0;
+	m_pShared->Unused = 0;		// // // 050B
+	m_pShared->EnvTrigger = false;
 }
 
 int CChannelHandlerAY::CalculateVolume() const		// // //
@@ -258,14 +261,14 @@ CString CChannelHandlerAY::GetCustomEffectString() const		// // //
 {
 	CString str = _T("");
 
-	if (s_iEnvFreqLo)
-		str.AppendFormat(_T(" H%02X"), s_iEnvFreqLo);
-	if (s_iEnvFreqHi)
-		str.AppendFormat(_T(" I%02X"), s_iEnvFreqHi);
-	if (s_iEnvType)
-		str.AppendFormat(_T(" J%02X"), s_iEnvType);
-	if (s_iDefaultNoise)
-		str.AppendFormat(_T(" W%02X"), s_iDefaultNoise);
+	if (m_pShared->EnvFreqLo)
+		str.AppendFormat(_T(" H%02X"), m_pShared->EnvFreqLo);
+	if (m_pShared->EnvFreqHi)
+		str.AppendFormat(_T(" I%02X"), m_pShared->EnvFreqHi);
+	if (m_pShared->EnvType)
+		str.AppendFormat(_T(" J%02X"), m_pShared->EnvType);
+	if (m_pShared->DefaultNoise)
+		str.AppendFormat(_T(" W%02X"), m_pShared->DefaultNoise);
 
 	return str;
 }
@@ -289,7 +292,7 @@ void CChannelHandlerAY::RefreshChannel()
 	WriteReg((m_iChannelID - CHANID_AY_CH1) + 8    , Volume | Envelope);
 
 	if (Envelope && (m_bTrigger || m_bUpdate))		// // // 050B
-		s_bEnvTrigger = true;
+		m_pShared->EnvTrigger = true;
 	m_bUpdate = false;
 
 	if (m_iChannelID == CHANID_AY_CH3)
@@ -298,5 +301,5 @@ void CChannelHandlerAY::RefreshChannel()
 
 void CChannelHandlerAY::SetNoiseFreq(int Pitch)		// // //
 {
-	s_iNoiseFreq = Pitch;
+	m_pShared->NoiseFreq = Pitch;
 }
@@ -32,17 +32,9 @@
 #include "APU/APU.h"
 #include "InstHandler.h"		// // //
 #include "SeqInstHandlerS5B.h"		// // //
+#include "APU/StateArchive.h"		// // //
 #include <map>
 
-// Static member variables, for the shared stuff in AY8930
-int			  CChannelHandlerAY8930::s_iModes		= 0;
-int			  CChannelHandlerAY8930::s_iNoiseFreq	= 0;
-int			  CChannelHandlerAY8930::s_iNoisePrev	= -1;
-int			  CChannelHandlerAY8930::s_iDefaultNoise = 0;		// // //
-int			  CChannelHandlerAY8930::s_iNoiseANDMask = 0x00;		// // //
-int			  CChannelHandlerAY8930::s_iNoiseORMask = 0xFF;		// // //
-int			  CChannelHandlerAY8930::s_unused		= 0;		// // // 050B
-
 // Class functions
 
 void CChannelHandlerAY8930::SetMode(int Chan, int Square, int Noise)
@@ -51,17 +43,17 @@ void CChannelHandlerAY8930::SetMode(int Chan, int Square, int Noise)
 
 	switch (Chan) {
 		case 0:
-			s_iModes &= 0x36;
+			m_pShared->Modes &= 0x36;
 			break;
 		case 1:
-			s_iModes &= 0x2D;
+			m_pShared->Modes &= 0x2D;
 			break;
 		case 2:
-			s_iModes &= 0x1B;
+			m_pShared->Modes &= 0x1B;
 			break;
 	}
 
-	s_iModes |= (Noise << (3 + Chan)) | (Square << Chan);
+	m_pShared->Modes |= (Noise << (3 + Chan)) | (Square << Chan);
 }
 
 void CChannelHandlerAY8930::UpdateAutoEnvelope(int Period)		// // // 050B
@@ -82,18 +74,19 @@ void CChannelHandlerAY8930::UpdateAutoEnvelope(int Period)		// // // 050B
 void CChannelHandlerAY8930::UpdateRegs()		// // //
 {
 	// Done only once
-	if (s_iNoiseFreq != s_iNoisePrev)		// // //
-		WriteReg(0x06, (s_iNoisePrev = s_iNoiseFreq) ^ 0xFF);
+	if (m_pShared->NoiseFreq != m_pShared->NoisePrev)		// // //
+		WriteReg(0x06, (m_pShared->NoisePrev = m_pShared->NoiseFreq) ^ 0xFF);
 
-	WriteReg(0x07, s_iModes);
-	WriteReg(0x19, s_iNoiseANDMask);
-	WriteReg(0x1A, s_iNoiseORMask);
+	WriteReg(0x07, m_pShared->Modes);
+	WriteReg(0x19, m_pShared->NoiseANDMask);
+	WriteReg(0x1A, m_pShared->NoiseORMask);
 }
 
 // Instance functions
 
 CChannelHandlerAY8930::CChannelHandlerAY8930() : 
 	CChannelHandler(0xFFFF, 0x1F),
+	m_pShared(std::make_shared<stSharedRegs>()),		// // //
 	m_bEnvelopeEnabled(false),		// // // 050B
 	m_iAutoEnvelopeShift(0),		// // // 050B
 	m_iEnvFreqHi(0),		// // // 050B
@@ -103,7 +96,12 @@ CChannelHandlerAY8930::CChannelHandlerAY8930() :
 	m_bUpdate(false)
 {
 	m_iDefaultDuty = AY8930_MODE_SQUARE;		// // //
-	s_iDefaultNoise = 0;		// // //
+	m_pShared->DefaultNoise = 0;		// // //
+}
+
+void CChannelHandlerAY8930::ShareRegisters(const CChannelHandlerAY8930 &Other)		// // //
+{
+	m_pShared = Other.m_pShared;
 }
 
 
@@ -116,6 +114,15 @@ static const std::map<EffParamT, ay8930_mode_t> VXX_TO_DUTY = {
 
 const char CChannelHandlerAY8930::MAX_DUTY = 0x07;		// = 1|2|4
 
+void CChannelHandlerAY8930::SerializeState(CStateArchive &State)		// // //
+{
+	// The mode, noise and envelope registers are shared by all channels, and archived by each of them
+	CChannelHandler::SerializeState(State);
+	State(m_pShared->Modes, m_pShared->NoiseFreq, m_pShared->NoisePrev, m_pShared->DefaultNoise, m_pShared->NoiseANDMask, m_pShared->NoiseORMask, m_pShared->Unused);
+	State(m_bEnvelopeEnabled, m_iAutoEnvelopeShift, m_iEnvFreqHi, m_iEnvFreqLo, m_iPulseWidth, m_iExVolume);
+	State(m_bEnvTrigger, m_iEnvType, m_bUpdate);
+}
+
 int CChannelHandlerAY8930::getDutyMax() const {
 	return MAX_DUTY;
 }
@@ -125,7 +132,7 @@ bool CChannelHandlerAY8930::HandleEffect(effect_t EffNum, unsigned char EffParam
 {
 	switch (EffNum) {
 	case EF_SUNSOFT_NOISE: // W
-		s_iDefaultNoise = s_iNoiseFreq = EffParam & 0xFF;		// // // 050B
+		m_pShared->DefaultNoise = m_pShared->NoiseFreq = EffParam & 0xFF;		// // // 050B
 		break;
 	case EF_SUNSOFT_ENV_HI: // I
 		m_iEnvFreqHi = EffParam;
@@ -144,10 +151,10 @@ bool CChannelHandlerAY8930::HandleEffect(effect_t EffNum, unsigned char EffParam
 		m_iPulseWidth = EffParam & 0x0F;
 		break;
 	case EF_AY8930_AND_MASK: // Y
-		s_iNoiseANDMask = EffParam;
+		m_pShared->NoiseANDMask = EffParam;
 		break;
 	case EF_AY8930_OR_MASK: // Z
-		s_iNoiseORMask = EffParam;
+		m_pShared->NoiseORMask = EffParam;
 		break;
 	case EF_AY8930_VOL:
 		m_iExVolume = EffParam & 1;
@@ -191,7 +198,7 @@ void CChannelHandlerAY8930::HandleNote(int Note, int Octave)		// // //
 	*/
 
 	if (this->m_iDefaultDuty & AY8930_MODE_NOISE) {
-		s_iNoiseFreq = s_iDefaultNoise;
+		m_pShared->NoiseFreq = m_pShared->DefaultNoise;
 	}
 }
 
@@ -237,10 +244,10 @@ void CChannelHandlerAY8930::ResetChannel()
 	CChannelHandler::ResetChannel();
 
 	m_iDefaultDuty = m_iDutyPeriod = AY8930_MODE_SQUARE;
-	s_iDefaultNoise = s_iNoiseFreq = 0;		// // //
-	s_iNoiseORMask = 0x00;		// // //
-	s_iNoiseANDMask = 0x0F;   // // //
-	s_iNoisePrev = -1;		// // //
+	m_pShared->DefaultNoise = m_pShared->NoiseFreq = 0;		// // //
+	m_pShared->NoiseORMask = 0x00;		// // //
+	m_pShared->NoiseANDMask = 0x0F;   // // //
+	m_pShared->NoisePrev = -1;		// // //
 	m_bEnvelopeEnabled = false;
 	m_iAutoEnvelopeShift = 0;
 	m_iEnvFreqHi = 0;
@@ -248,7 +255,7 @@ void CChannelHandlerAY8930::ResetChannel()
 	m_iEnvType = 0;
 	m_iPulseWidth = 0;
 	m_iExVolume = 0;
-	s_unused = 0;		// // // 050B
+	m_pShared->Unused = 0;		// // // 050B
 	m_bEnvTrigger = false;
 }
 
@@ -295,14 +302,14 @@ CString CChannelHandlerAY8930::GetCustomEffectString() const		// // //
 		str.AppendFormat(_T(" I%02X"), m_iEnvFreqHi);
 	if (m_iEnvType)
 		str.AppendFormat(_T(" J%02X"), m_iEnvType);
-	if (s_iDefaultNoise)
-		str.AppendFormat(_T(" W%02X"), s_iDefaultNoise);
+	if (m_pShared->DefaultNoise)
+		str.AppendFormat(_T(" W%02X"), m_pShared->DefaultNoise);
 	if (m_iPulseWidth)
 		str.AppendFormat(_T(" X%02X"), m_iPulseWidth);
-	if (s_iNoiseANDMask)
-		str.AppendFormat(_T(" Y%02X"), s_iNoiseANDMask);
-	if (s_iNoiseORMask)
-		str.AppendFormat(_T(" Z%02X"), s_iNoiseORMask);
+	if (m_pShared->NoiseANDMask)
+		str.AppendFormat(_T(" Y%02X"), m_pShared->NoiseANDMask);
+	if (m_pShared->NoiseORMask)
+		str.AppendFormat(_T(" Z%02X"), m_pShared->NoiseORMask);
 	if (m_iExVolume)
 		str.AppendFormat(_T(" S%02X"), m_iExVolume);
 
@@ -347,7 +354,7 @@ void CChannelHandlerAY8930::RefreshChannel()
 
 void CChannelHandlerAY8930::SetNoiseFreq(int Pitch)		// // //
 {
-	s_iNoiseFreq =  0xFF - (0x1F - (Pitch & 0x1F));
+	m_pShared->NoiseFreq =  0xFF - (0x1F - (Pitch & 0x1F));
 }
 
 
@@ -31,6 +31,7 @@ public:
 	CChannelHandlerAY8930();
 	void	ResetChannel() override;
 	void	RefreshChannel() override;
+	void	SerializeState(CStateArchive &State) override;		// // //
 
 	void	SetNoiseFreq(int Pitch) override final;		// // //
 	void	SetExtra(int Value) override;				// // //
@@ -54,21 +55,26 @@ protected:
 protected:
 	void WriteReg(int Reg, int Value);
 
-	// Static functions
+	// Shared register functions
 protected:	
-	static void SetMode(int Chan, int Square, int Noise);
+	void SetMode(int Chan, int Square, int Noise);		// // //
 	void UpdateAutoEnvelope(int Period);		// // // 050B
 	void UpdateRegs();		// // //
 
-	// Static memebers
+	// Registers shared by the three channels of one chip
+public:
+	struct stSharedRegs {		// // //
+		int Modes = 0;
+		int NoiseFreq = 0;
+		int NoisePrev = -1;
+		int DefaultNoise = 0;
+		int NoiseANDMask = 0x00;
+		int NoiseORMask = 0xFF;
+		int Unused = 0;		// 050B, unused
+	};
+	void	ShareRegisters(const CChannelHandlerAY8930 &Other);		// // //
 protected:
-	static int s_iModes;
-	static int s_iNoiseFreq;
-	static int s_iNoisePrev;		// // //
-	static int s_iDefaultNoise;		// // //
-	static int s_iNoiseANDMask;
-	static int s_iNoiseORMask;
-	static int s_unused;			// // // 050B, unused
+	std::shared_ptr<stSharedRegs> m_pShared;		// // //
 
 	// Instance members
 protected:
@@ -29,8 +29,9 @@
 #include "InstHandler.h"		// // //
 #include "SeqInstHandler.h"		// // //
 #include "SeqInstHandlerFDS.h"		// // //
-#include "FamiTracker.h"		// // //
+#include "SoundGen.h"		// // //
 #include "Settings.h"		// // //
+#include "APU/StateArchive.h"		// // //
 
 CChannelHandlerFDS::CChannelHandlerFDS() : 
 	FrequencyChannelHandler(0xFFF, 32)
@@ -132,7 +133,7 @@ void CChannelHandlerFDS::HandleRelease()
 
 int CChannelHandlerFDS::CalculateVolume() const		// // //
 {
-	if (!theApp.GetSettings()->General.bFDSOldVolume)		// // // match NSF setting
+	if (!m_pSoundGen->GetSettings()->General.bFDSOldVolume)		// // // match NSF setting
 		return LimitVolume(((m_iInstVolume + 1) * ((m_iVolume >> VOL_COLUMN_SHIFT) + 1) - 1) / 16 - GetTremolo());
 	return CChannelHandler::CalculateVolume();
 }
@@ -159,6 +160,14 @@ bool CChannelHandlerFDS::CreateInstHandler(inst_type_t Type)
 	return false;
 }
 
+void CChannelHandlerFDS::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler::SerializeState(State);
+	State(m_iModulationSpeed, m_iModulationDepth, m_iModulationDelay, m_iModTable, m_iWaveTable);
+	State(m_iVolModMode, m_iVolModRate, m_bVolModTrigger, m_bAutoModulation, m_iModulationOffset);
+	State(m_iEffModDepth, m_iEffModSpeedHi, m_iEffModSpeedLo);
+}
+
 void CChannelHandlerFDS::RefreshChannel()
 {
 	unsigned char Volume = CalculateVolume();
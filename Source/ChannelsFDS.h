@@ -24,6 +24,7 @@ class CChannelHandlerFDS : public FrequencyChannelHandler, public CChannelHandle
 public:
 	CChannelHandlerFDS();
 	virtual void RefreshChannel();
+	void	SerializeState(CStateArchive &State) override;		// // //
 protected:
 	void	HandleNoteData(stChanNote *pNoteData, int EffColumns) override;
 	bool	HandleEffect(effect_t EffNum, unsigned char EffParam) override;		// // //
@@ -28,6 +28,7 @@
 #include "ChannelsMMC5.h"
 #include "InstHandler.h"		// // //
 #include "SeqInstHandler.h"		// // //
+#include "APU/StateArchive.h"		// // //
 
 CChannelHandlerMMC5::CChannelHandlerMMC5() : CChannelHandler(0x7FF, 0x0F)
 {
@@ -115,6 +116,12 @@ void CChannelHandlerMMC5::ResetChannel()
 	m_iLengthCounter = 1;
 }
 
+void CChannelHandlerMMC5::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler::SerializeState(State);
+	State(m_bHardwareEnvelope, m_bEnvelopeLoop, m_bResetEnvelope, m_iLengthCounter, m_iLastPeriod);
+}
+
 // Taken from E-FamiTracker by Euly
 
 CChannelHandlerMMC5Voice::CChannelHandlerMMC5Voice() : CChannelHandler(0x7FF, 0x0F)
@@ -186,6 +193,12 @@ void CChannelHandlerMMC5Voice::ResetChannel()
 	m_iDAC = 0;		// // //
 }
 
+void CChannelHandlerMMC5Voice::SerializeState(CStateArchive &State)		// // //
+{
+	CChannelHandler::SerializeState(State);
+	State(m_iDAC);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
 // // // MMC5 Channels
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -28,6 +28,7 @@ class CChannelHandlerMMC5 : public CChannelHandler {
 public:
 	CChannelHandlerMMC5();
 	void	ResetChannel() override;
+	void	SerializeState(CStateArchive &State) override;		// // //
 	void	RefreshChannel() override;
 	int getDutyMax() const override;
 protected:
@@ -58,6 +59,7 @@ class CChannelHandlerMMC5Voice : public CChannelHandler { // Taken from E-FamiTr
 public:
 	CChannelHandlerMMC5Voice();
 	void	ResetChannel() override;
+	void	SerializeState(CStateArchive &State) override;		// // //
 	void	RefreshChannel() override;
 protected:
 	static const char MAX_DUTY;
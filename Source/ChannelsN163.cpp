@@ -30,6 +30,7 @@
 #include "InstHandler.h"		// // //
 #include "SeqInstHandler.h"		// // //
 #include "SeqInstHandlerN163.h"		// // //
+#include "APU/StateArchive.h"		// // //
 
 const int N163_PITCH_SLIDE_SHIFT = 2;	// Increase amplitude of pitch slides
 
@@ -52,6 +53,13 @@ void CChannelHandlerN163::ResetChannel()
 	m_bLoadWave = false;
 }
 
+void CChannelHandlerN163::SerializeState(CStateArchive &State)		// // //
+{
+	// The channel count is a module setting
+	CChannelHandler::SerializeState(State);
+	State(m_bLoadWave, m_bDisableLoad, m_iWaveLen, m_iWavePos, m_iWavePosOld, m_iWaveCount, m_bResetPhase);
+}
+
 bool CChannelHandlerN163::HandleEffect(effect_t EffNum, unsigned char EffParam)
 {
 	switch (EffNum) {
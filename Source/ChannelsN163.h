@@ -29,6 +29,7 @@ public:
 	CChannelHandlerN163();
 	void	RefreshChannel() override;
 	void	ResetChannel() override;
+	void	SerializeState(CStateArchive &State) override;		// // //
 
 	void	SetWaveLength(int Length);		// // //
 	void	SetWavePosition(int Pos);
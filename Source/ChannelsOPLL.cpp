@@ -28,37 +28,25 @@
 #include "ChannelsOPLL.h"
 #include "InstHandler.h"		// // //
 #include "InstHandlerOPLL.h"		// // //
-
-int g_iPercMode;	// Taken from 0CC-LLTracker
-int g_iPercModePrev;
-int g_iPercVolumeBD;
-int g_iPercVolumeSDHH;
-int g_iPercVolumeTOMCY;
+#include "APU/StateArchive.h"		// // //
 
 #define OPL_NOTE_ON 0x10
 #define OPL_SUSTAIN_ON 0x20
 
 const int OPLL_PITCH_RESOLUTION = 2;		// // // extra bits for internal pitch
 
-// True if custom instrument registers needs to be updated, shared among all channels
-bool CChannelHandlerOPLL::m_bRegsDirty = false;
-// Each bit represents that the custom patch register on that index has been updated
-char CChannelHandlerOPLL::m_cPatchFlag = 0;		// // // 050B
-// Custom instrument patch
-unsigned char CChannelHandlerOPLL::m_iPatchRegs[8];		// // // 050B
-
 CChannelHandlerOPLL::CChannelHandlerOPLL() : 
 	FrequencyChannelHandler((1 << (OPLL_PITCH_RESOLUTION + 9)) - 1, 15),		// // //
+	m_pShared(std::make_shared<stSharedRegs>()),		// // //
 	m_iCommand(OPLL_CMD_NONE),
 	m_iTriggeredNote(0)
 {
 	m_iVolume = VOL_COLUMN_MAX;
+}
 
-	g_iPercMode = 0; // Taken from 0CC-LLTracker
-	g_iPercModePrev = 0;
-	g_iPercVolumeBD = 15;
-	g_iPercVolumeSDHH = 15;
-	g_iPercVolumeTOMCY = 15;
+void CChannelHandlerOPLL::ShareRegisters(const CChannelHandlerOPLL &Other)		// // //
+{
+	m_pShared = Other.m_pShared;
 }
 
 void CChannelHandlerOPLL::SetChannelID(int ID)
@@ -67,6 +55,15 @@ void CChannelHandlerOPLL::SetChannelID(int ID)
 	m_iChannel = ID - CHANID_OPLL_CH1;
 }
 
+void CChannelHandlerOPLL::SerializeState(CStateArchive &State)		// // //
+{
+	// The patch and rhythm registers are shared by all channels, and archived by each of them
+	CChannelHandler::SerializeState(State);
+	State(m_pShared->RegsDirty, m_pShared->PatchFlag, m_pShared->PatchRegs);
+	State(m_pShared->PercMode, m_pShared->PercModePrev, m_pShared->PercVolumeBD, m_pShared->PercVolumeSDHH, m_pShared->PercVolumeTOMCY);
+	State(m_iPatch, m_bHold, m_iCommand, m_iTriggeredNote, m_iOctave, m_iOldOctave, m_iCustomPort);
+}
+
 void CChannelHandlerOPLL::SetPatch(unsigned char Patch)		// // //
 {
 	m_iDutyPeriod = Patch;
@@ -74,9 +71,9 @@ void CChannelHandlerOPLL::SetPatch(unsigned char Patch)		// // //
 
 void CChannelHandlerOPLL::SetCustomReg(size_t Index, unsigned char Val)		// // //
 {
-	ASSERT(Index < sizeof(m_iPatchRegs));
-	if (!(m_cPatchFlag & (1 << Index)))		// // // 050B
-		m_iPatchRegs[Index] = Val;
+	ASSERT(Index < sizeof(m_pShared->PatchRegs));
+	if (!(m_pShared->PatchFlag & (1 << Index)))		// // // 050B
+		m_pShared->PatchRegs[Index] = Val;
 }
 
 void CChannelHandlerOPLL::HandleNoteData(stChanNote *pNoteData, int EffColumns)
@@ -97,9 +94,9 @@ bool CChannelHandlerOPLL::HandleEffect(effect_t EffNum, unsigned char EffParam)
 		m_iCustomPort = EffParam & 0x07;
 		break;
 	case EF_VRC7_WRITE:		// // // 050B
-		m_iPatchRegs[m_iCustomPort] = EffParam;
-		m_cPatchFlag |= 1 << m_iCustomPort;
-		m_bRegsDirty = true;
+		m_pShared->PatchRegs[m_iCustomPort] = EffParam;
+		m_pShared->PatchFlag |= 1 << m_iCustomPort;
+		m_pShared->RegsDirty = true;
 		break;
 	case EF_DAC:	// Taken from 0CC-LLTracker
 		/*switch (EffParam & 0xf0)
@@ -108,10 +105,10 @@ bool CChannelHandlerOPLL::HandleEffect(effect_t EffNum, unsigned char EffParam)
 			switch (EffParam & 0x0f)
 			{
 			case 0x00://off
-				g_iPercMode &= ~0x20;
+				m_pShared->PercMode &= ~0x20;
 				break;
 			case 0x01://on
-				g_iPercMode |= 0x20;
+				m_pShared->PercMode |= 0x20;
 				break;
 			}
 			break;
@@ -119,9 +116,9 @@ bool CChannelHandlerOPLL::HandleEffect(effect_t EffNum, unsigned char EffParam)
 		what the heck????
 		*/
 		if (EffParam == 0x01) {
-			g_iPercMode |= 0x20;
+			m_pShared->PercMode |= 0x20;
 		} else {
-			g_iPercMode &= ~0x20;
+			m_pShared->PercMode &= ~0x20;
 		}
 		break;
 	default: return FrequencyChannelHandler::HandleEffect(EffNum, EffParam);
@@ -258,35 +255,35 @@ int CChannelHandlerOPLL::TriggerNote(int Note)
 		m_iCommand = OPLL_CMD_NOTE_ON;
 	m_iOctave = Note / NOTE_RANGE;
 
-	if (g_iPercMode & 0x20 && m_iChannelID >= CHANID_OPLL_CH7 && m_iChannelID <= CHANID_OPLL_CH9) { // Taken from 0CC-LLTracker
+	if (m_pShared->PercMode & 0x20 && m_iChannelID >= CHANID_OPLL_CH7 && m_iChannelID <= CHANID_OPLL_CH9) { // Taken from 0CC-LLTracker
 		switch (Note % 12)	//drum mapping similar to the MIDI drum layout
 		{
 		case 0:	//BD
 		case 1:
-			g_iPercMode |= 0x10;
-			g_iPercVolumeBD = (15 - CalculateVolume());
+			m_pShared->PercMode |= 0x10;
+			m_pShared->PercVolumeBD = (15 - CalculateVolume());
 			break;
 		case 2: //SD
 		case 3:
 		case 4:
-			g_iPercMode |= 0x08;
-			g_iPercVolumeSDHH = (g_iPercVolumeSDHH & 0xf0) | (15 - CalculateVolume());
+			m_pShared->PercMode |= 0x08;
+			m_pShared->PercVolumeSDHH = (m_pShared->PercVolumeSDHH & 0xf0) | (15 - CalculateVolume());
 			break;
 		case 5: //TOM
 		case 7:
 		case 9:
 		case 11:
-			g_iPercMode |= 0x04;
-			g_iPercVolumeTOMCY = (g_iPercVolumeTOMCY & 0x0f) | ((15 - CalculateVolume()) << 4);
+			m_pShared->PercMode |= 0x04;
+			m_pShared->PercVolumeTOMCY = (m_pShared->PercVolumeTOMCY & 0x0f) | ((15 - CalculateVolume()) << 4);
 			break;
 		case 10: //CY
-			g_iPercMode |= 0x02;
-			g_iPercVolumeTOMCY = (g_iPercVolumeTOMCY & 0xf0) | (15 - CalculateVolume());
+			m_pShared->PercMode |= 0x02;
+			m_pShared->PercVolumeTOMCY = (m_pShared->PercVolumeTOMCY & 0xf0) | (15 - CalculateVolume());
 			break;
 		case 6: //HH
 		case 8:
-			g_iPercMode |= 0x01;
-			g_iPercVolumeSDHH = (g_iPercVolumeSDHH & 0x0f) | ((15 - CalculateVolume()) << 4);
+			m_pShared->PercMode |= 0x01;
+			m_pShared->PercVolumeSDHH = (m_pShared->PercVolumeSDHH & 0x0f) | ((15 - CalculateVolume()) << 4);
 			break;
 		}
 	}
@@ -352,9 +349,9 @@ void COPLLChannel::RefreshChannel()
 	}
 
 	// Write custom instrument
-	if ((m_iDutyPeriod == 0 && m_iCommand == OPLL_CMD_NOTE_TRIGGER) || m_bRegsDirty) {
+	if ((m_iDutyPeriod == 0 && m_iCommand == OPLL_CMD_NOTE_TRIGGER) || m_pShared->RegsDirty) {
 		for (int i = 0; i < 8; ++i)
-			RegWrite(i, m_iPatchRegs[i]);
+			RegWrite(i, m_pShared->PatchRegs[i]);
 	}
 
 	int subindex = m_iChannelID - CHANID_OPLL_CH1;
@@ -362,7 +359,7 @@ void COPLLChannel::RefreshChannel()
 	{
 		//only send all percussion related writes from one of the channels
 
-		if (g_iPercMode & 0x20) {
+		if (m_pShared->PercMode & 0x20) {
 			//repeating writes will get filtered out during export
 
 			RegWrite(0x26, 0x00);	//force key off to percussion channels
@@ -375,13 +372,13 @@ void COPLLChannel::RefreshChannel()
 			RegWrite(0x27, 0x05);
 			RegWrite(0x28, 0x01);
 
-			RegWrite(0x0e, g_iPercMode);	//enable rhythm mode
-			RegWrite(0x36, g_iPercVolumeBD);	//percussion volume
-			RegWrite(0x37, g_iPercVolumeSDHH);
-			RegWrite(0x38, g_iPercVolumeTOMCY);
+			RegWrite(0x0e, m_pShared->PercMode);	//enable rhythm mode
+			RegWrite(0x36, m_pShared->PercVolumeBD);	//percussion volume
+			RegWrite(0x37, m_pShared->PercVolumeSDHH);
+			RegWrite(0x38, m_pShared->PercVolumeTOMCY);
 
-			g_iPercMode &= ~0x1f;
-		} else if (g_iPercModePrev & 0x20) {
+			m_pShared->PercMode &= ~0x1f;
+		} else if (m_pShared->PercModePrev & 0x20) {
 			RegWrite(0x0e, 0x00);	//disable rhythm mode
 			RegWrite(0x26, 0x00);	//force key off to percussion channels
 			RegWrite(0x27, 0x00);
@@ -391,10 +388,10 @@ void COPLLChannel::RefreshChannel()
 			RegWrite(0x38, 0x1f);
 		}
 
-		g_iPercModePrev = g_iPercMode;
+		m_pShared->PercModePrev = m_pShared->PercMode;
 	}
 
-	if ((g_iPercMode & 0x20) && (subindex >= 6)) return;	//don't allow notes on the percussion channels when percussion mode is enabled
+	if ((m_pShared->PercMode & 0x20) && (subindex >= 6)) return;	//don't allow notes on the percussion channels when percussion mode is enabled
 
 	int Cmd = 0;
 
@@ -426,7 +423,7 @@ void COPLLChannel::RefreshChannel()
 	RegWrite(0x20 + m_iChannel, ((Fnum >> 8) & 1) | (Bnum << 1) | Cmd);
 
 	if (m_iChannelID == CHANID_OPLL_CH9)		// // // 050B
-		m_cPatchFlag = 0;
+		m_pShared->PatchFlag = 0;
 }
 
 void COPLLChannel::ClearRegisters()
@@ -442,7 +439,7 @@ void COPLLChannel::ClearRegisters()
 
 	m_iCommand = OPLL_CMD_NOTE_HALT;
 	m_iCustomPort = 0;		// // // 050B
-	// g_iPercMode &= ~0x20;
+	// m_pShared->PercMode &= ~0x20;
 	// should we reset or not???
 
 }
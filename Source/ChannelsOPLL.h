@@ -39,6 +39,7 @@ class CChannelHandlerOPLL : public FrequencyChannelHandler, public CChannelHandl
 public:
 	CChannelHandlerOPLL();
 	void	SetChannelID(int ID) override;
+	void	SerializeState(CStateArchive &State) override;		// // //
 
 	void	SetPatch(unsigned char Patch);		// // //
 	void	SetCustomReg(size_t Index, unsigned char Val);		// // //
@@ -63,10 +64,21 @@ protected:
 	void CorrectOctave();		// // //
 	unsigned int GetFnum(int Note) const;
 
+	// Registers shared by all channels of one chip
+public:
+	struct stSharedRegs {		// // //
+		bool RegsDirty = false;		// True if custom instrument registers needs to be updated
+		char PatchFlag = 0;		// Each bit represents that the custom patch register on that index has been updated
+		unsigned char PatchRegs[8] = { };		// Custom instrument patch
+		int PercMode = 0;		// Taken from 0CC-LLTracker
+		int PercModePrev = 0;
+		int PercVolumeBD = 15;
+		int PercVolumeSDHH = 15;
+		int PercVolumeTOMCY = 15;
+	};
+	void	ShareRegisters(const CChannelHandlerOPLL &Other);		// // //
 protected:
-	static bool m_bRegsDirty;
-	static char m_cPatchFlag;		// // // 050B
-	static unsigned char m_iPatchRegs[8];		// // // 050B
+	std::shared_ptr<stSharedRegs> m_pShared;		// // //
 
 protected:
 	unsigned char m_iChannel;
@@ -30,19 +30,9 @@
 #include "APU/APU.h"
 #include "InstHandler.h"		// // //
 #include "SeqInstHandlerS5B.h"		// // //
+#include "APU/StateArchive.h"		// // //
 #include <map>
 
-// Static member variables, for the shared stuff in 5B
-int			  CChannelHandlerS5B::s_iModes		= 0;
-int			  CChannelHandlerS5B::s_iNoiseFreq	= 0;
-int			  CChannelHandlerS5B::s_iNoisePrev	= -1;
-int			  CChannelHandlerS5B::s_iDefaultNoise = 0;		// // //
-unsigned char CChannelHandlerS5B::s_iEnvFreqHi	= 0;
-unsigned char CChannelHandlerS5B::s_iEnvFreqLo	= 0;
-bool		  CChannelHandlerS5B::s_bEnvTrigger	= false;		// // // 050B
-int			  CChannelHandlerS5B::s_iEnvType	= 0;
-int			  CChannelHandlerS5B::s_unused		= 0;		// // // 050B
-
 // Class functions
 
 void CChannelHandlerS5B::SetMode(int Chan, int Square, int Noise)
@@ -51,17 +41,17 @@ void CChannelHandlerS5B::SetMode(int Chan, int Square, int Noise)
 
 	switch (Chan) {
 		case 0:
-			s_iModes &= 0x36;
+			m_pShared->Modes &= 0x36;
 			break;
 		case 1:
-			s_iModes &= 0x2D;
+			m_pShared->Modes &= 0x2D;
 			break;
 		case 2:
-			s_iModes &= 0x1B;
+			m_pShared->Modes &= 0x1B;
 			break;
 	}
 
-	s_iModes |= (Noise << (3 + Chan)) | (Square << Chan);
+	m_pShared->Modes |= (Noise << (3 + Chan)) | (Square << Chan);
 }
 
 void CChannelHandlerS5B::UpdateAutoEnvelope(int Period)		// // // 050B
@@ -74,34 +64,39 @@ void CChannelHandlerS5B::UpdateAutoEnvelope(int Period)		// // // 050B
 		}
 		else if (m_iAutoEnvelopeShift < 8)
 			Period <<= 8 - m_iAutoEnvelopeShift;
-		s_iEnvFreqLo = Period & 0xFF;
-		s_iEnvFreqHi = Period >> 8;
+		m_pShared->EnvFreqLo = Period & 0xFF;
+		m_pShared->EnvFreqHi = Period >> 8;
 	}
 }
 
 void CChannelHandlerS5B::UpdateRegs()		// // //
 {
 	// Done only once
-	if (s_iNoiseFreq != s_iNoisePrev)		// // //
-		WriteReg(0x06, (s_iNoisePrev = s_iNoiseFreq) ^ 0x1F);
-	WriteReg(0x07, s_iModes);
-	WriteReg(0x0B, s_iEnvFreqLo);
-	WriteReg(0x0C, s_iEnvFreqHi);
-	if (s_bEnvTrigger)		// // // 050B
-		WriteReg(0x0D, s_iEnvType);
-	s_bEnvTrigger = false;
+	if (m_pShared->NoiseFreq != m_pShared->NoisePrev)		// // //
+		WriteReg(0x06, (m_pShared->NoisePrev = m_pShared->NoiseFreq) ^ 0x1F);
+	WriteReg(0x07, m_pShared->Modes);
+	WriteReg(0x0B, m_pShared->EnvFreqLo);
+	WriteReg(0x0C, m_pShared->EnvFreqHi);
+	if (m_pShared->EnvTrigger)		// // // 050B
+		WriteReg(0x0D, m_pShared->EnvType);
+	m_pShared->EnvTrigger = false;
 }
 
 // Instance functions
 
 CChannelHandlerS5B::CChannelHandlerS5B() : 
 	CChannelHandler(0xFFF, 0x0F),
+	m_pShared(std::make_shared<stSharedRegs>()),		// // //
 	m_bEnvelopeEnabled(false),		// // // 050B
 	m_iAutoEnvelopeShift(0),		// // // 050B
 	m_bUpdate(false)
 {
 	m_iDefaultDuty = S5B_MODE_SQUARE;		// // //
-	s_iDefaultNoise = 0;		// // //
+}
+
+void CChannelHandlerS5B::ShareRegisters(const CChannelHandlerS5B &Other)		// // //
+{
+	m_pShared = Other.m_pShared;
 }
 
 
@@ -114,6 +109,14 @@ static const std::map<EffParamT, s5b_mode_t> VXX_TO_DUTY = {
 
 const char CChannelHandlerS5B::MAX_DUTY = 0x07;		// = 1|2|4
 
+void CChannelHandlerS5B::SerializeState(CStateArchive &State)		// // //
+{
+	// The mode, noise and envelope registers are shared by all channels, and archived by each of them
+	CChannelHandler::SerializeState(State);
+	State(m_pShared->Modes, m_pShared->NoiseFreq, m_pShared->NoisePrev, m_pShared->DefaultNoise, m_pShared->EnvFreqHi, m_pShared->EnvFreqLo, m_pShared->EnvTrigger, m_pShared->EnvType, m_pShared->Unused);
+	State(m_bEnvelopeEnabled, m_iAutoEnvelopeShift, m_bUpdate);
+}
+
 int CChannelHandlerS5B::getDutyMax() const {
 	return MAX_DUTY;
 }
@@ -123,17 +126,17 @@ bool CChannelHandlerS5B::HandleEffect(effect_t EffNum, EffParamT EffParam)
 {
 	switch (EffNum) {
 	case EF_SUNSOFT_NOISE: // W
-		s_iDefaultNoise = s_iNoiseFreq = EffParam & 0x1F;		// // // 050B
+		m_pShared->DefaultNoise = m_pShared->NoiseFreq = EffParam & 0x1F;		// // // 050B
 		break;
 	case EF_SUNSOFT_ENV_HI: // I
-		s_iEnvFreqHi = EffParam;
+		m_pShared->EnvFreqHi = EffParam;
 		break;
 	case EF_SUNSOFT_ENV_LO: // J
-		s_iEnvFreqLo = EffParam;
+		m_pShared->EnvFreqLo = EffParam;
 		break;
 	case EF_SUNSOFT_ENV_TYPE: // H
-		s_bEnvTrigger = true;		// // // 050B
-		s_iEnvType = EffParam & 0x0F;
+		m_pShared->EnvTrigger = true;		// // // 050B
+		m_pShared->EnvType = EffParam & 0x0F;
 		m_bUpdate = true;
 		m_bEnvelopeEnabled = EffParam != 0;
 		m_iAutoEnvelopeShift = EffParam >> 4;
@@ -177,7 +180,7 @@ void CChannelHandlerS5B::HandleNote(int Note, int Octave)		// // //
 	*/
 
 	if (this->m_iDefaultDuty & S5B_MODE_NOISE) {
-		s_iNoiseFreq = s_iDefaultNoise;
+		m_pShared->NoiseFreq = m_pShared->DefaultNoise;
 	}
 }
 
@@ -223,15 +226,15 @@ void CChannelHandlerS5B::ResetChannel()
 	CChannelHandler::ResetChannel();
 
 	m_iDefaultDuty = m_iDutyPeriod = S5B_MODE_SQUARE;
-	s_iDefaultNoise = s_iNoiseFreq = 0;		// // //
-	s_iNoisePrev = -1;		// // //
+	m_pShared->DefaultNoise = m_pShared->NoiseFreq = 0;		// // //
+	m_pShared->NoisePrev = -1;		// // //
 	m_bEnvelopeEnabled = false;
 	m_iAutoEnvelopeShift = 0;
-	s_iEnvFreqHi = 0;
-	s_iEnvFreqLo = 0;
-	s_iEnvType = 0;
-	s_unused = 0;		// // // 050B
-	s_bEnvTrigger = false;
+	m_pShared->EnvFreqHi = 0;
+	m_pShared->EnvFreqLo = 0;
+	m_pShared->EnvType = 0;
+	m_pShared->Unused = 0;		// // // 050B
+	m_pShared->EnvTrigger = false;
 }
 
 int CChannelHandlerS5B::CalculateVolume() const		// // //
@@ -258,14 +261,14 @@ CString CChannelHandlerS5B::GetCustomEffectString() const		// // //
 {
 	CString str = _T("");
 
-	if (s_iEnvFreqLo)
-		str.AppendFormat(_T(" H%02X"), s_iEnvFreqLo);
-	if (s_iEnvFreqHi)
-		str.AppendFormat(_T(" I%02X"), s_iEnvFreqHi);
-	if (s_iEnvType)
-		str.AppendFormat(_T(" J%02X"), s_iEnvType);
-	if (s_iDefaultNoise)
-		str.AppendFormat(_T(" W%02X"), s_iDefaultNoise);
+	if (m_pShared->EnvFreqLo)
+		str.AppendFormat(_T(" H%02X"), m_pShared->EnvFreqLo);
+	if (m_pShared->EnvFreqHi)
+		str.AppendFormat(_T(" I%02X"), m_pShared->EnvFreqHi);
+	if (m_pShared->EnvType)
+		str.AppendFormat(_T(" J%02X"), m_pShared->EnvType);
+	if (m_pShared->DefaultNoise)
+		str.AppendFormat(_T(" W%02X"), m_pShared->DefaultNoise);
 
 	return str;
 }
@@ -289,7 +292,7 @@ void CChannelHandlerS5B::RefreshChannel()
 	WriteReg((m_iChannelID - CHANID_5B_CH1) + 8    , Volume | Envelope);
 
 	if (Envelope && (m_bTrigger || m_bUpdate))		// // // 050B
-		s_bEnvTrigger = true;
+		m_pShared->EnvTrigger = true;
 	m_bUpdate = false;
 
 	if (m_iChannelID == CHANID_5B_CH3)
@@ -298,5 +301,5 @@ void CChannelHandlerS5B::RefreshChannel()
 
 void CChannelHandlerS5B::SetNoiseFreq(int Pitch)		// // //
 {
-	s_iNoiseFreq = Pitch;
+	m_pShared->NoiseFreq = Pitch;
 }
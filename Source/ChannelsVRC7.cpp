@@ -28,33 +28,41 @@
 #include "ChannelsVRC7.h"
 #include "InstHandler.h"		// // //
 #include "InstHandlerVRC7.h"		// // //
+#include "APU/StateArchive.h"		// // //
 
 #define OPL_NOTE_ON 0x10
 #define OPL_SUSTAIN_ON 0x20
 
 const int VRC7_PITCH_RESOLUTION = 2;		// // // extra bits for internal pitch
 
-// True if custom instrument registers needs to be updated, shared among all channels
-bool CChannelHandlerVRC7::m_bRegsDirty = false;
-// Each bit represents that the custom patch register on that index has been updated
-char CChannelHandlerVRC7::m_cPatchFlag = 0;		// // // 050B
-// Custom instrument patch
-unsigned char CChannelHandlerVRC7::m_iPatchRegs[8] = { };		// // // 050B
-
 CChannelHandlerVRC7::CChannelHandlerVRC7() : 
 	FrequencyChannelHandler((1 << (VRC7_PITCH_RESOLUTION + 9)) - 1, 15),		// // //
+	m_pShared(std::make_shared<stSharedRegs>()),		// // //
 	m_iCommand(CMD_NONE),
 	m_iTriggeredNote(0)
 {
 	m_iVolume = VOL_COLUMN_MAX;
 }
 
+void CChannelHandlerVRC7::ShareRegisters(const CChannelHandlerVRC7 &Other)		// // //
+{
+	m_pShared = Other.m_pShared;
+}
+
 void CChannelHandlerVRC7::SetChannelID(int ID)
 {
 	CChannelHandler::SetChannelID(ID);
 	m_iChannel = ID - CHANID_VRC7_CH1;
 }
 
+void CChannelHandlerVRC7::SerializeState(CStateArchive &State)		// // //
+{
+	// The patch registers are shared by all channels, and archived by each of them
+	CChannelHandler::SerializeState(State);
+	State(m_pShared->RegsDirty, m_pShared->PatchFlag, m_pShared->PatchRegs);
+	State(m_iPatch, m_bHold, m_iCommand, m_iTriggeredNote, m_iOctave, m_iOldOctave, m_iCustomPort);
+}
+
 void CChannelHandlerVRC7::SetPatch(unsigned char Patch)		// // //
 {
 	m_iDutyPeriod = Patch;
@@ -62,9 +70,9 @@ void CChannelHandlerVRC7::SetPatch(unsigned char Patch)		// // //
 
 void CChannelHandlerVRC7::SetCustomReg(size_t Index, unsigned char Val)		// // //
 {
-	ASSERT(Index < sizeof(m_iPatchRegs));
-	if (!(m_cPatchFlag & (1 << Index)))		// // // 050B
-		m_iPatchRegs[Index] = Val;
+	ASSERT(Index < sizeof(m_pShared->PatchRegs));
+	if (!(m_pShared->PatchFlag & (1 << Index)))		// // // 050B
+		m_pShared->PatchRegs[Index] = Val;
 }
 
 void CChannelHandlerVRC7::HandleNoteData(stChanNote *pNoteData, int EffColumns)
@@ -85,9 +93,9 @@ bool CChannelHandlerVRC7::HandleEffect(effect_t EffNum, unsigned char EffParam)
 		m_iCustomPort = EffParam & 0x07;
 		break;
 	case EF_VRC7_WRITE:		// // // 050B
-		m_iPatchRegs[m_iCustomPort] = EffParam;
-		m_cPatchFlag |= 1 << m_iCustomPort;
-		m_bRegsDirty = true;
+		m_pShared->PatchRegs[m_iCustomPort] = EffParam;
+		m_pShared->PatchFlag |= 1 << m_iCustomPort;
+		m_pShared->RegsDirty = true;
 		break;
 	default: return FrequencyChannelHandler::HandleEffect(EffNum, EffParam);
 	}
@@ -284,12 +292,12 @@ void CVRC7Channel::RefreshChannel()
 	}
 
 	// Write custom instrument
-	if ((m_iDutyPeriod == 0 && m_iCommand == CMD_NOTE_TRIGGER) || m_bRegsDirty) {
+	if ((m_iDutyPeriod == 0 && m_iCommand == CMD_NOTE_TRIGGER) || m_pShared->RegsDirty) {
 		for (int i = 0; i < 8; ++i)
-			RegWrite(i, m_iPatchRegs[i]);
+			RegWrite(i, m_pShared->PatchRegs[i]);
 	}
 
-	m_bRegsDirty = false;
+	m_pShared->RegsDirty = false;
 
 	if (!m_bGate)
 		m_iCommand = CMD_NOTE_HALT;
@@ -324,7 +332,7 @@ void CVRC7Channel::RefreshChannel()
 	RegWrite(0x20 + m_iChannel, ((Fnum >> 8) & 1) | (Bnum << 1) | Cmd);
 
 	if (m_iChannelID == CHANID_VRC7_CH6)		// // // 050B
-		m_cPatchFlag = 0;
+		m_pShared->PatchFlag = 0;
 }
 
 void CVRC7Channel::ClearRegisters()
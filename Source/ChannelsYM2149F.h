@@ -29,6 +29,7 @@ public:
 	CChannelHandlerYM2149F();
 	void	ResetChannel() override;
 	void	RefreshChannel() override;
+	void	SerializeState(CStateArchive &State) override;		// // //
 
 	void	SetNoiseFreq(int Pitch) override final;		// // //
 
@@ -51,23 +52,28 @@ protected:
 protected:
 	void WriteReg(int Reg, int Value);
 
-	// Static functions
+	// Shared register functions
 protected:	
-	static void SetMode(int Chan, int Square, int Noise);
+	void SetMode(int Chan, int Square, int Noise);		// // //
 	void UpdateAutoEnvelope(int Period);		// // // 050B
 	void UpdateRegs();		// // //
 
-	// Static memebers
+	// Registers shared by the three channels of one chip
+public:
+	struct stSharedRegs {		// // //
+		int Modes = 0;
+		int NoiseFreq = 0;
+		int NoisePrev = -1;
+		int DefaultNoise = 0;
+		unsigned char EnvFreqHi = 0;
+		unsigned char EnvFreqLo = 0;
+		bool EnvTrigger = false;		// 050B
+		int EnvType = 0;
+		int Unused = 0;		// 050B, unused
+	};
+	void	ShareRegisters(const CChannelHandlerYM2149F &Other);		// // //
 protected:
-	static int s_iModes;
-	static int s_iNoiseFreq;
-	static int s_iNoisePrev;		// // //
-	static int s_iDefaultNoise;		// // //
-	static unsigned char s_iEnvFreqHi;
-	static unsigned char s_iEnvFreqLo;
-	static bool s_bEnvTrigger;		// // // 050B
-	static int s_iEnvType;
-	static int s_unused;		// // // 050B, unused
+	std::shared_ptr<stSharedRegs> m_pShared;		// // //
 
 	// Instance members
 protected:
@@ -22,26 +22,56 @@
 #include "stdafx.h"
 #include "Chunk.h"
 
+// // // CChunkLabels - Label name table
+
+const unsigned int CChunkLabels::NONE = static_cast<unsigned int>(-1);
+
+unsigned int CChunkLabels::Intern(LPCSTR Name)
+{
+	auto Result = m_Index.try_emplace(Name, static_cast<unsigned int>(m_vNames.size()));
+	if (Result.second)
+		m_vNames.push_back(&Result.first->first);
+	return Result.first->second;
+}
+
+unsigned int CChunkLabels::Find(LPCSTR Name) const
+{
+	auto it = m_Index.find(Name);
+	return it != m_Index.end() ? it->second : NONE;
+}
+
+LPCSTR CChunkLabels::GetName(unsigned int ID) const
+{
+	return ID < m_vNames.size() ? m_vNames[ID]->c_str() : "";
+}
+
+unsigned int CChunkLabels::GetCount() const
+{
+	return static_cast<unsigned int>(m_vNames.size());
+}
+
+void CChunkLabels::Clear()
+{
+	m_vNames.clear();
+	m_Index.clear();
+}
+
 /**
  * CChunk - Stores NSF data
  *
  */
 
-CChunk::CChunk(chunk_type_t Type, CStringA label) : m_iType(Type), m_strLabel(label), m_iBank(0)
-{
-}
-
-CChunk::~CChunk()
+CChunk::CChunk(chunk_type_t Type, CStringA label, CChunkLabels &Labels) :		// // //
+	m_Labels(Labels), m_iLabel(Labels.Intern(label)), m_iDataSize(0), m_iBank(0), m_iType(Type)
 {
-	Clear();
 }
 
 void CChunk::Clear()
 {
-	for (auto x : m_vChunkData)
-		delete x;
-
 	m_vChunkData.clear();
+	m_vStrings.clear();
+	m_vAliases.clear();
+	m_iDataSize = 0;
 }
 
 chunk_type_t CChunk::GetType() const
@@ -51,7 +81,12 @@ chunk_type_t CChunk::GetType() const
 
 LPCSTR CChunk::GetLabel() const
 {
-	return m_strLabel;
+	return m_Labels.GetName(m_iLabel);
+}
+
+unsigned int CChunk::GetLabelID() const		// // //
+{
+	return m_iLabel;
 }
 
 void CChunk::SetBank(unsigned char Bank)
@@ -72,102 +107,132 @@ int CChunk::GetLength() const
 
 unsigned short CChunk::GetData(int index) const
 {
-	return m_vChunkData[index]->GetData();
+	return m_vChunkData[index].Type == CHUNK_DATA_STRING ? 0 : m_vChunkData[index].Data;		// // //
 }
 
 unsigned short CChunk::GetDataSize(int index) const
 {
-	return m_vChunkData[index]->GetSize();
+	const stChunkData &Item = m_vChunkData[index];		// // //
+	switch (Item.Type) {
+	case CHUNK_DATA_BYTE: case CHUNK_DATA_BANK:
+		return 1;
+	case CHUNK_DATA_WORD: case CHUNK_DATA_REFERENCE:
+		return 2;
+	case CHUNK_DATA_STRING:
+		return static_cast<unsigned short>(m_vStrings[Item.Index].size());
+	}
+	return 0;
 }
 
 void CChunk::StoreByte(unsigned char data)
 {
-	m_vChunkData.push_back(new CChunkDataByte(data));
+	m_vChunkData.push_back({CHUNK_DATA_BYTE, data, 0});		// // //
+	m_iDataSize += 1;
 }
 
 void CChunk::StoreWord(unsigned short data)
 {
-	m_vChunkData.push_back(new CChunkDataWord(data));
+	m_vChunkData.push_back({CHUNK_DATA_WORD, data, 0});		// // //
+	m_iDataSize += 2;
 }
 
 void CChunk::StoreReference(CStringA refName)
 {
-	m_vChunkData.push_back(new CChunkDataReference(refName));
+	m_vChunkData.push_back({CHUNK_DATA_REFERENCE, static_cast<unsigned short>(-1), m_Labels.Intern(refName)});		// // //
+	m_iDataSize += 2;
 }
 
 void CChunk::StoreBankReference(CStringA refName, int bank)
 {
-	m_vChunkData.push_back(new CChunkDataBank(refName, bank));
+	StoreBankReference(m_Labels.Intern(refName), bank);		// // //
+}
+
+void CChunk::StoreBankReference(unsigned int Label, int bank)		// // //
+{
+	m_vChunkData.push_back({CHUNK_DATA_BANK, static_cast<unsigned short>(bank), Label});
+	m_iDataSize += 1;
 }
 
 void CChunk::StoreString(const std::vector<char> &data)
 {
-	m_vChunkData.push_back(new CChunkDataString(data));
+	m_vChunkData.push_back({CHUNK_DATA_STRING, 0, static_cast<unsigned int>(m_vStrings.size())});		// // //
+	m_vStrings.push_back(data);
+	m_iDataSize += static_cast<unsigned int>(data.size());
 }
 
 void CChunk::ChangeByte(int index, unsigned char data)
 {
 	ASSERT(index < (int)m_vChunkData.size());
-	static_cast<CChunkDataByte*>(m_vChunkData[index])->m_data = data;
+	ASSERT(m_vChunkData[index].Type == CHUNK_DATA_BYTE);
+	m_vChunkData[index].Data = data;
 }
 
 void CChunk::SetupBankData(int index, unsigned char bank)
 {
 	ASSERT(index < (int)m_vChunkData.size());
-	static_cast<CChunkDataBank*>(m_vChunkData[index])->m_bank = bank;
+	ASSERT(m_vChunkData[index].Type == CHUNK_DATA_BANK);
+	m_vChunkData[index].Data = bank;
 }
 
 unsigned char CChunk::GetStringData(int index, int pos) const
 {
-	return static_cast<CChunkDataString*>(m_vChunkData[index])->m_vData[pos];
+	return GetStringData(index)[pos];
 }
 
 const std::vector<char> &CChunk::GetStringData(int index) const
 {
-	return (static_cast<CChunkDataString*>(m_vChunkData[index]))->m_vData;
+	return m_vStrings[m_vChunkData[index].Index];		// // //
 }
 
 LPCSTR CChunk::GetDataRefName(int index) const
 {	
-	CChunkDataReference *pChunkData = dynamic_cast<CChunkDataReference*>(m_vChunkData[index]);
-
-	if (pChunkData != NULL)
-		return pChunkData->m_refName;
-
-	return "";
+	return IsDataReference(index) ? m_Labels.GetName(m_vChunkData[index].Index) : "";		// // //
 }
 
-void CChunk::UpdateDataRefName(int index, CStringA &name)
+unsigned int CChunk::GetDataRefLabel(int index) const		// // //
 {
-	CChunkDataReference *pChunkData = dynamic_cast<CChunkDataReference*>(m_vChunkData[index]);
+	return IsDataReference(index) ? m_vChunkData[index].Index : CChunkLabels::NONE;
+}
 
-	if (pChunkData != NULL)
-		pChunkData->m_refName = name;
+void CChunk::UpdateDataRefLabel(int index, unsigned int Label)		// // //
+{
+	if (IsDataReference(index))
+		m_vChunkData[index].Index = Label;
 }
 
 bool CChunk::IsDataReference(int index) const 
 {
-	return dynamic_cast<CChunkDataReference*>(m_vChunkData[index]) != NULL;
+	return m_vChunkData[index].Type == CHUNK_DATA_REFERENCE;		// // //
 }
 
 bool CChunk::IsDataBank(int index) const
 {
-	return dynamic_cast<CChunkDataBank*>(m_vChunkData[index]) != NULL;
+	return m_vChunkData[index].Type == CHUNK_DATA_BANK;		// // //
 }
 
 unsigned int CChunk::CountDataSize() const
 {
 	// Count sizes of all data items
-	int Size = 0;
+	return m_iDataSize;		// // //
+}
 
-	for (const auto pChunk : m_vChunkData)
-		Size += pChunk->GetSize();
+void CChunk::AssignLabels(const std::vector<int> &Offsets)		// // //
+{
+	for (auto &Item : m_vChunkData) if (Item.Type == CHUNK_DATA_REFERENCE)
+		Item.Data = static_cast<unsigned short>(Item.Index < Offsets.size() ? Offsets[Item.Index] : 0);
+}
 
-	return Size;
+void CChunk::AddAlias(unsigned int Label, unsigned int Offset)		// // //
+{
+	m_vAliases.push_back({Label, Offset});
+}
+
+const std::vector<stChunkAlias> &CChunk::GetAliases() const		// // //
+{
+	return m_vAliases;
 }
 
-void CChunk::AssignLabels(CMap<CStringA, LPCSTR, int, int> &labelMap)
+LPCSTR CChunk::GetLabelName(unsigned int Label) const		// // //
 {
-	for (auto x : m_vChunkData) if (auto pChunkData = dynamic_cast<CChunkDataReference*>(x))
-		pChunkData->ref = labelMap[pChunkData->m_refName];
+	return m_Labels.GetName(Label);
 }
@@ -24,68 +24,60 @@
 
 // std::vector is required by this header file
 #include <vector>		// // //
+#include <string>		// // //
+#include <unordered_map>		// // //
 
 
 // Helper classes/objects for NSF compiling
 
 //
-// Chunk data classes
+// Label table
 //
 
-class CChunkData
+// // // Interns label names, so that chunk data refers to labels by a small integer ID
+// and resolving a label never compares strings
+class CChunkLabels
 {
 public:
-	CChunkData() {}
-	virtual ~CChunkData() {}
-	virtual int GetSize() const = 0;
-	virtual unsigned short GetData() const = 0;
-};
+	unsigned int	Intern(LPCSTR Name);
+	unsigned int	Find(LPCSTR Name) const;
+	LPCSTR			GetName(unsigned int ID) const;
+	unsigned int	GetCount() const;
+	void			Clear();
 
-class CChunkDataByte : public CChunkData
-{
 public:
-	CChunkDataByte(unsigned char data) : CChunkData(), m_data(data) {}
-	int GetSize() const { return 1; }
-	unsigned short GetData() const { return m_data; };
-	unsigned char m_data;
-};
+	static const unsigned int NONE;
 
-class CChunkDataWord : public CChunkData
-{
-public:
-	CChunkDataWord(unsigned short data) : CChunkData(), m_data(data) {}
-	int GetSize() const { return 2; }
-	unsigned short GetData() const { return m_data; };
-	unsigned short m_data;
+private:
+	std::unordered_map<std::string, unsigned int> m_Index;
+	std::vector<const std::string*> m_vNames;		// Keys of m_Index, which keep their address
 };
 
-class CChunkDataReference : public CChunkData
-{
-public:
-	CChunkDataReference(CStringA refName) : CChunkData(), m_refName(refName), ref(-1) {}
-	int GetSize() const { return 2; }
-	unsigned short GetData() const { return ref; };
-	CStringA m_refName;
-	unsigned short ref;
+//
+// Chunk data
+//
+
+enum chunk_data_t : unsigned char {		// // //
+	CHUNK_DATA_BYTE,
+	CHUNK_DATA_WORD,
+	CHUNK_DATA_REFERENCE,
+	CHUNK_DATA_BANK,
+	CHUNK_DATA_STRING,
 };
 
-class CChunkDataBank : public CChunkData
+// // // One data item, stored by value in the chunk instead of as a separate object
+struct stChunkData
 {
-public:
-	CChunkDataBank(CStringA bankOf, int bank) : CChunkData(), m_bankOf(bankOf), m_bank(bank) {}
-	int GetSize() const { return 1; }
-	unsigned short GetData() const { return m_bank; };
-	CStringA m_bankOf;	// Reference to a label which belongs to the bank this data should point to
-	unsigned int m_bank;
+	chunk_data_t Type;
+	unsigned short Data;		// Byte or word value, resolved label address, or bank number
+	unsigned int Index;			// Label ID of references and banks, string index of strings
 };
 
-class CChunkDataString : public CChunkData
+// // // Another label that points into the data of a chunk
+struct stChunkAlias
 {
-public:
-	CChunkDataString(const std::vector<char> &data) : CChunkData(), m_vData(data) {}
-	int GetSize() const { return static_cast<int>(m_vData.size()); }
-	unsigned short GetData() const { return 0; };	// Invalid for this type
-	std::vector<char> m_vData;
+	unsigned int Label;
+	unsigned int Offset;		// Bytes from the start of the chunk
 };
 
 
@@ -116,13 +108,13 @@ enum chunk_type_t {
 class CChunk
 {
 public:
-	CChunk(chunk_type_t Type, CStringA label);
-	~CChunk();
+	CChunk(chunk_type_t Type, CStringA label, CChunkLabels &Labels);		// // //
 
 	void			Clear();
 
 	chunk_type_t	GetType() const;
 	LPCSTR			GetLabel() const;
+	unsigned int	GetLabelID() const;		// // //
 	void			SetBank(unsigned char Bank);
 	unsigned char	GetBank() const;
 
@@ -134,6 +126,7 @@ public:
 	void			StoreWord(unsigned short data);
 	void			StoreReference(CStringA refName);
 	void			StoreBankReference(CStringA refName, int bank);
+	void			StoreBankReference(unsigned int Label, int bank);		// // //
 	void			StoreString(const std::vector<char> &data);
 
 	void			ChangeByte(int index, unsigned char data);
@@ -141,22 +134,31 @@ public:
 
 	unsigned char	GetStringData(int index, int pos) const;
 	LPCSTR			GetDataRefName(int index) const;
+	unsigned int	GetDataRefLabel(int index) const;		// // //
 	
 	bool			IsDataReference(int index) const;
 	bool			IsDataBank(int index) const;
 
 	const std::vector<char> &GetStringData(int index) const;
 
-	void			UpdateDataRefName(int index, CStringA &name);
+	void			UpdateDataRefLabel(int index, unsigned int Label);		// // //
 
 	unsigned int	CountDataSize() const;
 
-	void			AssignLabels(CMap<CStringA, LPCSTR, int, int> &labelMap);
+	void			AssignLabels(const std::vector<int> &Offsets);		// // //
+
+	void			AddAlias(unsigned int Label, unsigned int Offset);		// // //
+	const std::vector<stChunkAlias> &GetAliases() const;		// // //
+	LPCSTR			GetLabelName(unsigned int Label) const;		// // //
 
 private:
-	std::vector<CChunkData*> m_vChunkData;	// List of data stored in this chunk
+	std::vector<stChunkData> m_vChunkData;	// List of data stored in this chunk
+	std::vector<std::vector<char>> m_vStrings;		// // // String data items
+	std::vector<stChunkAlias> m_vAliases;		// // //
 
-	CStringA m_strLabel;		// Label of this chunk
+	CChunkLabels &m_Labels;		// // //
+	unsigned int m_iLabel;		// Label of this chunk
+	unsigned int m_iDataSize;	// // // Sum of data item sizes
 	unsigned char m_iBank;		// The bank this chunk will be stored in
 	chunk_type_t m_iType;		// Chunk type
 };
@@ -437,6 +437,10 @@ void CChunkRenderText::StorePatternChunk(CChunk *pChunk, CFile *pFile)
 	len = vec.size();
 
 	StoreByteString(&vec.front(), static_cast<int>(vec.size()), str, DEFAULT_LINE_BREAK);
+
+	// // // Patterns stored as the end of this one
+	for (const auto &Alias : pChunk->GetAliases())
+		str.AppendFormat("%s = %s + %u\n", pChunk->GetLabelName(Alias.Label), pChunk->GetLabel(), Alias.Offset);
 /*
 	for (int i = 0; i < len; ++i) {
 		str.AppendFormat("$%02X", (unsigned char)vec[i]);
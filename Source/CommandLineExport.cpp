@@ -23,10 +23,17 @@
 #include "FamiTrackerDoc.h"
 #include "CommandLineExport.h"
 #include "Compiler.h"
+#include "CompilerCache.h"		// // //
 #include "SoundGen.h"
 #include "TextExporter.h"
 #include "CustomExporters.h"
 #include "DocumentWrapper.h"
+#include "DocumentFile.h"
+#include "APU/WorkerPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
 
 // Command line export logger
 class CCommandLineLog : public CCompilerLog
@@ -43,7 +50,7 @@ private:
 };
 
 // Command line export function
-void CCommandLineExport::CommandLineExport(const CString& fileIn, const CString& fileOut, const CString& fileLog,  const CString& fileDPCM)
+void CCommandLineExport::CommandLineExport(const CString& fileIn, const CString& fileOut, const CString& fileLog,  const CString& fileDPCM, bool MergePatterns)		// // //
 {
 	// open log
 	bool bLog = false;
@@ -96,6 +103,7 @@ void CCommandLineExport::CommandLineExport(const CString& fileIn, const CString&
 
 	// export
 	CCompiler compiler(pExportDoc, new CCommandLineLog(&LogText));
+	compiler.SetMergePatternSuffixes(MergePatterns);		// // //
 	if (0 == ext.CompareNoCase(_T(".nsf"))) {
 		compiler.ExportNSF(fileOut, pExportDoc->GetMachine());
 		LogText += "\nNSF export complete.\n";
@@ -176,6 +184,28 @@ void CCommandLineExport::CommandLineExport(const CString& fileIn, const CString&
 		PrintCommandlineMessage(LogFile, LogText, bLog);
 		return;
 	}
+	else if (0 == ext.CompareNoCase(_T(".vgm"))) {
+		// The first track, played once, on a sound generator and document of its own like the batch renderer
+		bool Success = false;
+		try {
+			CString Output = fileOut;
+			auto pSoundGen = std::make_unique<CSoundGen>(theApp.GetSettings(), true);
+			if (auto pRenderDoc = CFamiTrackerDoc::LoadOffline(fileIn, pSoundGen.get())) {
+				Success = pSoundGen->RenderOffline(Output.GetBuffer(), SONG_LOOP_LIMIT, 1, 0, RENDER_VGM);
+				Output.ReleaseBuffer();
+			}
+		}
+		catch (std::exception &e) {
+			LogText += "Error: ";
+			LogText += e.what();
+			LogText += "\n";
+		}
+		LogText += Success ? "\nVGM export complete.\n" : "\nError: unable to render VGM file.\n";
+		LogText += "Press enter to continue . . .";
+		PrintCommandlineMessage(LogFile, LogText, bLog);
+		return;
+	}
+
 	else if (0 == ext.CompareNoCase(_T(".wav")))		// // !!
 	{
 		LogText += "\nWAVE export complete.\n";
@@ -235,6 +265,267 @@ void CCommandLineExport::CommandLineExport(const CString& fileIn, const CString&
 	return;
 }
 
+// Batch rendering
+
+namespace {
+
+struct stRenderJob {
+	CString Module;
+	int Track;							// 0-based
+	CString Output;
+	render_end_t EndType;
+	int EndParam;
+	std::string Log;
+};
+
+// Splits a job line at spaces and tabs, double quotes keep a field with spaces together
+std::vector<CString> SplitJobLine(const CString &Line)
+{
+	std::vector<CString> Fields;
+	CString Field;
+	bool Quoted = false;
+	bool HasField = false;
+
+	for (int i = 0; i < Line.GetLength(); ++i) {
+		TCHAR c = Line[i];
+		if (c == _T('"')) {
+			Quoted = !Quoted;
+			HasField = true;
+		}
+		else if (!Quoted && (c == _T(' ') || c == _T('\t'))) {
+			if (HasField)
+				Fields.push_back(Field);
+			Field.Empty();
+			HasField = false;
+		}
+		else {
+			Field += c;
+			HasField = true;
+		}
+	}
+	if (HasField)
+		Fields.push_back(Field);
+
+	return Fields;
+}
+
+CFamiTrackerDoc *OpenRenderDocument(const CString &Path)
+{
+	CObject* pObject = RUNTIME_CLASS(CFamiTrackerDoc)->CreateObject();
+	if (pObject == NULL || !pObject->IsKindOf(RUNTIME_CLASS(CFamiTrackerDoc)))
+		return NULL;
+
+	CFamiTrackerDoc *pDoc = static_cast<CFamiTrackerDoc*>(pObject);
+	if (!pDoc->OnOpenDocument(Path))
+		return NULL;
+	return pDoc;
+}
+
+} // namespace
+
+// Renders every job of a job file to WAV, or VGM for outputs ending in .vgm, one job per core.
+//
+// Each line of the job file is a module, a track number (starting at 1), an output file,
+// and optionally the length: a loop count, or a time in seconds with an "s" suffix.
+// The default is to play the track once. Empty lines and lines starting with # are skipped.
+//
+//	"C:\modules\my song.dnm"	1	"C:\renders\my song - 1.wav"
+//	C:\modules\other.dnm		3	C:\renders\other-3.wav		90s
+//
+// Every job loads its module into its own document and renders it with its own offline
+// CSoundGen, on the thread that runs the job. Jobs share nothing but the settings, which
+// are passed to each generator and only read while rendering.
+void CCommandLineExport::BatchRender(const CString& fileJobs, const CString& fileLog)
+{
+	bool bLog = false;
+	CStdioFile LogFile;
+	std::string LogText = "";
+
+	if (fileLog.GetLength() > 0)
+		bLog = (LogFile.Open(fileLog, CFile::modeCreate | CFile::modeWrite | CFile::typeText, NULL));
+
+	CStdioFile JobFile;
+	if (!JobFile.Open(fileJobs, CFile::modeRead | CFile::typeText)) {
+		LogText += "Error: unable to open job file: ";
+		LogText += fileJobs;
+		LogText += "\n";
+		LogText += "Press enter to continue . . .";
+		PrintCommandlineMessage(LogFile, LogText, bLog);
+		return;
+	}
+
+	// Read the job list
+	std::vector<stRenderJob> Jobs;
+	CString Line;
+	int LineNumber = 0;
+
+	while (JobFile.ReadString(Line)) {
+		++LineNumber;
+		Line.Trim();
+		if (Line.IsEmpty() || Line[0] == _T('#'))
+			continue;
+
+		std::vector<CString> Fields = SplitJobLine(Line);
+		if (Fields.size() < 3 || Fields.size() > 4 || _ttoi(Fields[1]) < 1) {
+			CString Error;
+			Error.Format(_T("Error: invalid job on line %d: "), LineNumber);
+			LogText += Error;
+			LogText += Line;
+			LogText += "\n";
+			continue;
+		}
+
+		stRenderJob Job {Fields[0], _ttoi(Fields[1]) - 1, Fields[2], SONG_LOOP_LIMIT, 1};
+		if (Fields.size() == 4) {
+			const CString &Length = Fields[3];
+			if (!Length.Right(1).CompareNoCase(_T("s"))) {
+				Job.EndType = SONG_TIME_LIMIT;
+				Job.EndParam = _ttoi(Length.Left(Length.GetLength() - 1));
+			}
+			else
+				Job.EndParam = _ttoi(Length);
+		}
+		Jobs.push_back(Job);
+	}
+
+	// Load and render, every thread takes the next job as soon as its previous one is done
+	const DWORD StartTime = GetTickCount();
+	CSettings *pSettings = theApp.GetSettings();
+	std::atomic<size_t> NextJob {0};
+	CWorkerPool Pool(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+
+	Pool.Run(Pool.GetThreadCount(), [&] (unsigned) {
+		for (size_t i = NextJob++; i < Jobs.size(); i = NextJob++) {
+			stRenderJob &Job = Jobs[i];
+
+			bool Success = false;
+			try {
+				const render_format_t Format = Job.Output.Right(4).CompareNoCase(_T(".vgm")) ? RENDER_WAV : RENDER_VGM;
+				auto pSoundGen = std::make_unique<CSoundGen>(pSettings, true);
+				auto pDocument = CFamiTrackerDoc::LoadOffline(Job.Module, pSoundGen.get());
+				if (!pDocument) {
+					Job.Log = "Error: unable to open document: ";
+					Job.Log += Job.Module;
+					continue;
+				}
+				if (static_cast<unsigned>(Job.Track) >= pDocument->GetTrackCount()) {
+					Job.Log = "Error: track does not exist: ";
+					Job.Log += Job.Module;
+					continue;
+				}
+				Success = pSoundGen->RenderOffline(Job.Output.GetBuffer(), Job.EndType, Job.EndParam, Job.Track, Format);
+				Job.Output.ReleaseBuffer();
+			}
+			catch (std::exception &e) {
+				Job.Log = "Error: ";
+				Job.Log += e.what();
+				Job.Log += ": ";
+			}
+
+			if (Success)
+				Job.Log = "Rendered: ";
+			else if (Job.Log.empty())
+				Job.Log = "Error: unable to render: ";
+			Job.Log += Job.Output;
+		}
+	});
+
+	int Rendered = 0;
+	for (const auto &Job : Jobs) {
+		if (Job.Log.rfind("Rendered: ", 0) == 0)
+			++Rendered;
+		LogText += Job.Log;
+		LogText += "\n";
+	}
+
+	CString Summary;
+	Summary.Format(_T("\n%d of %d tracks rendered in %.1f s on %u threads.\n"),
+		Rendered, static_cast<int>(Jobs.size()), (GetTickCount() - StartTime) / 1000.0, Pool.GetThreadCount());
+	LogText += Summary;
+	LogText += "Press enter to continue . . .";
+	PrintCommandlineMessage(LogFile, LogText, bLog);
+}
+
+// Load / save benchmark
+
+// Loads a module the given number of times, from the memory-mapped loader and from buffered
+// reads, then saves it as many times to a temporary file and compiles its NSF music data as
+// many times, and prints the average time of each.
+void CCommandLineExport::Benchmark(const CString& fileIn, int Iterations, const CString& fileLog)
+{
+	bool bLog = false;
+	CStdioFile LogFile;
+	std::string LogText = "";
+
+	if (fileLog.GetLength() > 0)
+		bLog = (LogFile.Open(fileLog, CFile::modeCreate | CFile::modeWrite | CFile::typeText, NULL));
+
+	Iterations = std::max(Iterations, 1);
+
+	CFamiTrackerDoc *pDocument = OpenRenderDocument(fileIn);
+	if (pDocument == NULL) {
+		LogText += "Error: unable to open document: ";
+		LogText += fileIn;
+		LogText += "\n";
+		LogText += "Press enter to continue . . .";
+		PrintCommandlineMessage(LogFile, LogText, bLog);
+		return;
+	}
+
+	bool Success = true;
+	const auto Measure = [Iterations] (const auto &Func) {
+		const auto Start = std::chrono::steady_clock::now();
+		for (int i = 0; i < Iterations; ++i)
+			Func();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count() / Iterations;
+	};
+
+	CDocumentFile::EnableMapping(false);
+	const double BufferedTime = Measure([&] { Success &= pDocument->OnOpenDocument(fileIn) != FALSE; });
+	CDocumentFile::EnableMapping(true);
+	const double MappedTime = Measure([&] { Success &= pDocument->OnOpenDocument(fileIn) != FALSE; });
+
+	TCHAR TempPath[MAX_PATH];
+	TCHAR TempFile[MAX_PATH];
+	GetTempPath(MAX_PATH, TempPath);
+	GetTempFileName(TempPath, _T("HNM"), 0, TempFile);
+	const double SaveTime = Measure([&] { Success &= pDocument->OnSaveDocument(TempFile) != FALSE; });
+	const double CompileTime = Measure([&] {
+		pDocument->GetCompilerCache().Clear();
+		CCompiler Compiler(pDocument, nullptr);
+		Success &= Compiler.CompileOnly();
+	});
+	const double CachedCompileTime = Measure([&] {		// Everything was compiled once by the previous run
+		CCompiler Compiler(pDocument, nullptr);
+		Success &= Compiler.CompileOnly();
+	});
+
+	CFileStatus Status;
+	const ULONGLONG FileSize = CFile::GetStatus(TempFile, Status) ? Status.m_size : 0;
+	DeleteFile(TempFile);
+	DeleteFile(CString(TempFile) + _T(".bak"));
+
+	CString Summary;
+	Summary.Format(_T("Module: %s (%u tracks, %llu bytes saved)\n"), (LPCTSTR)fileIn, pDocument->GetTrackCount(), FileSize);
+	LogText += Summary;
+	Summary.Format(_T("Load (buffered): %.2f ms\nLoad (mapped): %.2f ms\nSave: %.2f ms\nCompile: %.2f ms\nCompile (cached): %.2f ms\n"),
+		BufferedTime, MappedTime, SaveTime, CompileTime, CachedCompileTime);
+	LogText += Summary;
+	Summary.Format(_T("Average of %d iterations%s.\n"), Iterations, Success ? _T("") : _T(", some of which failed"));
+	LogText += Summary;
+
+	// Pattern memory, compared to a fixed table of 256-row patterns per track
+	unsigned int Patterns = 0;
+	const std::size_t PatternMemory = pDocument->GetPatternMemory(Patterns);
+	const std::size_t FixedMemory = Patterns * MAX_PATTERN_LENGTH * sizeof(stChanNote) +
+		pDocument->GetTrackCount() * MAX_CHANNELS * MAX_PATTERN * sizeof(stChanNote *);
+	Summary.Format(_T("Patterns: %u allocated, %.1f KiB (%.1f KiB with fixed-size patterns)\n"),
+		Patterns, PatternMemory / 1024.0, FixedMemory / 1024.0);
+	LogText += Summary;
+	LogText += "Press enter to continue . . .";
+	PrintCommandlineMessage(LogFile, LogText, bLog);
+}
+
 void CCommandLineExport::PrintCommandlineMessage(CStdioFile &LogFile, std::string &text, bool writelog)
 {
 	if (writelog)
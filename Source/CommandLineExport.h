@@ -23,7 +23,9 @@
 class CCommandLineExport
 {
 public:
-	void CommandLineExport(const CString& fileIn, const CString& fileOut, const CString& fileLog,  const CString& fileDPCM);
+	void CommandLineExport(const CString& fileIn, const CString& fileOut, const CString& fileLog,  const CString& fileDPCM, bool MergePatterns = true);		// // //
+	void BatchRender(const CString& fileJobs, const CString& fileLog);
+	void Benchmark(const CString& fileIn, int Iterations, const CString& fileLog);
 private:
 	void PrintCommandlineMessage(CStdioFile &LogFile, std::string &text, bool writelog);
 };
\ No newline at end of file
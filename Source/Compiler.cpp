@@ -37,6 +37,11 @@
 #include "Driver.h"
 #include "SoundGen.h"
 #include "APU/APU.h"
+#include "APU/WorkerPool.h"		// // //
+#include <algorithm>
+#include <cstdint>		// // //
+#include <thread>
+#include <unordered_set>
 
 //
 // This is the new NSF data compiler, music is compiled to an object list instead of a binary chunk
@@ -122,23 +127,41 @@ constexpr bool UseAllChips = true;
 constexpr bool UseAllChips = false;
 #endif
 
-CCompiler *CCompiler::pCompiler = NULL;
-
-CCompiler *CCompiler::GetCompiler()
-{
-	return pCompiler;
-}
-
 unsigned int CCompiler::AdjustSampleAddress(unsigned int Address)
 {
 	// Align samples to 64-byte pages
 	return (0x40 - (Address & 0x3F)) & 0x3F;
 }
 
+namespace {
+
+// // // A pattern compiled by StorePatterns
+struct stCompiledPattern {
+	int Pattern;
+	int Channel;
+	CCompilerCache::stPatternKey Key;
+	CCompilerCache::stPatternEntry Entry;
+	bool Cached;
+};
+
+// // // Collects the log of one pattern compiler
+class CBufferedLog : public CCompilerLog
+{
+public:
+	CBufferedLog(std::string &Text) : m_Text(Text) {}
+	void WriteLog(std::string_view text) override { m_Text += text; }
+	void Clear() override { m_Text.clear(); }
+private:
+	std::string &m_Text;
+};
+
+} // namespace
+
 // CCompiler
 
-CCompiler::CCompiler(CFamiTrackerDoc *pDoc, CCompilerLog *pLogger) :
+CCompiler::CCompiler(CFamiTrackerDoc *pDoc, CCompilerLog *pLogger, const CSoundGen *pSoundGen) :
 	m_pDocument(pDoc),
+	m_pSoundGen(pSoundGen ? pSoundGen : theApp.GetSoundGenerator()),
 	m_pLogger(pLogger),
 	m_iWaveTables(0),
 	m_pSamplePointersChunk(NULL),
@@ -146,19 +169,18 @@ CCompiler::CCompiler(CFamiTrackerDoc *pDoc, CCompilerLog *pLogger) :
 	m_pDriverData(NULL),
 	m_iLastBank(0),
 	m_iHashCollisions(0),
-	m_iFirstSampleBank(0)
+	m_iFirstSampleBank(0),
+	m_bMergePatternSuffixes(true),		// // //
+	m_CacheSession(),		// // //
+	m_iCachedPatterns(0),
+	m_iCachedChunks(0)
 {
-	ASSERT(CCompiler::pCompiler == NULL);
-	CCompiler::pCompiler = this;
-
 	m_iActualChip = m_pDocument->GetExpansionChip();		// // //
 	m_iActualNamcoChannels = m_pDocument->GetNamcoChannels();
 }
 
 CCompiler::~CCompiler()
 {
-	CCompiler::pCompiler = NULL;
-
 	Cleanup();
 
 	SAFE_RELEASE(m_pLogger);
@@ -208,6 +230,33 @@ bool CCompiler::OpenFile(LPCTSTR lpszFileName, CFile &file) const
 	return true;
 }
 
+void CCompiler::SetMergePatternSuffixes(bool Enable)		// // //
+{
+	m_bMergePatternSuffixes = Enable;
+}
+
+bool CCompiler::CompileOnly()		// // //
+{
+	// Build the music data and resolve its labels the same way as ExportNSF, without writing a file
+	bool Success = CompileData(true);
+
+	if (Success) {
+		if (m_bBankSwitched) {
+			AddBankswitching();
+			Success = ResolveLabelsBankswitched();
+			if (Success) {
+				UpdateFrameBanks();
+				UpdateSongBanks();
+			}
+		}
+		else
+			ResolveLabels();
+	}
+
+	Cleanup();
+	return Success;
+}
+
 void CCompiler::ExportNSF(LPCTSTR lpszFileName, int MachineType)
 {
 	ClearLog();
@@ -1180,7 +1229,6 @@ char *CCompiler::LoadDriver(const driver_t *pDriver, unsigned short Origin) cons
 	memcpy(pData, pDriver->driver, pDriver->driver_size);
 
 	// // // Custom pitch tables
-	CSoundGen *pSoundGen = theApp.GetSoundGenerator();
 	for (size_t i = 0; i < pDriver->freq_table_size; i += 2) {		// // //
 		int Table = pDriver->freq_table[i + 1];
 		switch (Table) {
@@ -1190,13 +1238,13 @@ char *CCompiler::LoadDriver(const driver_t *pDriver, unsigned short Origin) cons
 		case CDetuneTable::DETUNE_FDS:
 		case CDetuneTable::DETUNE_N163:
 			for (int j = 0; j < NOTE_COUNT; ++j) {
-				int Reg = pSoundGen->ReadPeriodTable(j, Table);
+				int Reg = m_pSoundGen->ReadPeriodTable(j, Table);
 				pData[pDriver->freq_table[i] + 2 * j] = Reg & 0xFF;
 				pData[pDriver->freq_table[i] + 2 * j + 1] = Reg >> 8;
 			} break;
 		case CDetuneTable::DETUNE_VRC7:
 			for (int j = 0; j <= NOTE_RANGE; ++j) { // one extra item
-				int Reg = pSoundGen->ReadPeriodTable(j % NOTE_RANGE, Table) * 4;
+				int Reg = m_pSoundGen->ReadPeriodTable(j % NOTE_RANGE, Table) * 4;
 				if (j == NOTE_RANGE) Reg <<= 1;
 				pData[pDriver->freq_table[i] + j] = Reg & 0xFF;
 				pData[pDriver->freq_table[i] + j + NOTE_RANGE + 1] = Reg >> 8;
@@ -1277,10 +1325,9 @@ void CCompiler::SetDriverSongAddress(char *pDriver, unsigned short Address) cons
 void CCompiler::PatchVibratoTable(char *pDriver) const
 {
 	// Copy the vibrato table, the stock one only works for new vibrato mode
-	const CSoundGen *pSoundGen = theApp.GetSoundGenerator();
 
 	for (int i = 0; i < 256; ++i) {
-		*(pDriver + m_iVibratoTableLocation + i) = (char)pSoundGen->ReadVibratoTable(i);
+		*(pDriver + m_iVibratoTableLocation + i) = (char)m_pSoundGen->ReadVibratoTable(i);
 	}
 }
 
@@ -1514,12 +1561,11 @@ void CCompiler::CreateNSFeFooter(stNSFeFooter *pFooter)
 
 	// write mixe chunk
 	memcpy(pFooter->mixe.Ident, "mixe", 4);
-	CSoundGen *pSoundGen = theApp.GetSoundGenerator();
 
 	for (uint8_t i = 0; i < CHIP_LEVEL_COUNT; i++) {
 		if (m_pDocument->GetLevelOffset(i) != 0) {
 			pFooter->mixe.Data.emplace_back(i);
-			emplace_int16(pFooter->mixe.Data, int16_t(m_pDocument->GetLevelOffset(i) * 10 + pSoundGen->SurveyMixLevels[i]));
+			emplace_int16(pFooter->mixe.Data, int16_t(m_pDocument->GetLevelOffset(i) * 10 + m_pSoundGen->SurveyMixLevels[i]));
 		}
 	}
 
@@ -1603,7 +1649,7 @@ void CCompiler::UpdateFrameBanks()
 		if (pChunk->GetType() == CHUNK_FRAME) {
 			// Add bank data
 			for (int j = 0; j < Channels; ++j) {
-				unsigned char bank = GetObjectByRef(pChunk->GetDataRefName(j))->GetBank();
+				unsigned char bank = GetObjectByRef(pChunk->GetDataRefLabel(j))->GetBank();		// // //
 				if (bank < PATTERN_SWITCH_BANK)
 					bank = PATTERN_SWITCH_BANK;
 				pChunk->SetupBankData(j + Channels, bank);
@@ -1617,7 +1663,7 @@ void CCompiler::UpdateSongBanks()
 	// Write bank numbers to song lists (can only be used when bankswitching is used)
 	ASSERT(m_bBankSwitched);
 	for (CChunk *pChunk : m_vSongChunks) {
-		int bank = GetObjectByRef(pChunk->GetDataRefName(0))->GetBank();
+		int bank = GetObjectByRef(pChunk->GetDataRefLabel(0))->GetBank();		// // //
 		if (bank < PATTERN_SWITCH_BANK)
 			bank = PATTERN_SWITCH_BANK;
 		pChunk->SetupBankData(m_iSongBankReference, bank);
@@ -1643,41 +1689,43 @@ void CCompiler::EnableBankswitching()
 void CCompiler::ResolveLabels()
 {
 	// Resolve label addresses, no banks since bankswitching is disabled
-	CMap<CStringA, LPCSTR, int, int> labelMap;
+	std::vector<int> Offsets(m_Labels.GetCount());		// // // Indexed by label ID
 
 	// Pass 1, collect labels
-	CollectLabels(labelMap);
+	CollectLabels(Offsets);
+	CollectAliases(Offsets);		// // //
 
 	// Pass 2
-	AssignLabels(labelMap);
+	AssignLabels(Offsets);
 }
 
 bool CCompiler::ResolveLabelsBankswitched()
 {
 	// Resolve label addresses and banks
-	CMap<CStringA, LPCSTR, int, int> labelMap;
+	std::vector<int> Offsets(m_Labels.GetCount());		// // // Indexed by label ID
 
 	// Pass 1, collect labels
-	if (!CollectLabelsBankswitched(labelMap))
+	if (!CollectLabelsBankswitched(Offsets))
 		return false;
+	CollectAliases(Offsets);		// // //
 
 	// Pass 2
-	AssignLabels(labelMap);
+	AssignLabels(Offsets);
 
 	return true;
 }
 
-void CCompiler::CollectLabels(CMap<CStringA, LPCSTR, int, int> &labelMap) const
+void CCompiler::CollectLabels(std::vector<int> &Offsets) const
 {
 	// Collect labels and assign offsets
 	int Offset = 0;
 	for (const CChunk *pChunk : m_vChunks) {
-		labelMap[pChunk->GetLabel()] = Offset;
+		Offsets[pChunk->GetLabelID()] = Offset;		// // //
 		Offset += pChunk->CountDataSize();
 	}
 }
 
-bool CCompiler::CollectLabelsBankswitched(CMap<CStringA, LPCSTR, int, int> &labelMap)
+bool CCompiler::CollectLabelsBankswitched(std::vector<int> &Offsets)
 {
 	int Offset = 0;
 	int Bank = PATTERN_SWITCH_BANK;
@@ -1694,7 +1742,7 @@ bool CCompiler::CollectLabelsBankswitched(CMap<CStringA, LPCSTR, int, int> &labe
 			case CHUNK_PATTERN:
 				break;
 			default:
-				labelMap[pChunk->GetLabel()] = Offset;
+				Offsets[pChunk->GetLabelID()] = Offset;		// // //
 				Offset += Size;
 		}
 	}
@@ -1726,7 +1774,7 @@ bool CCompiler::CollectLabelsBankswitched(CMap<CStringA, LPCSTR, int, int> &labe
 				}
 				// fall through
 			case CHUNK_FRAME:
-				labelMap[pChunk->GetLabel()] = Offset;
+				Offsets[pChunk->GetLabelID()] = Offset;		// // //
 				pChunk->SetBank(Bank < FixedBankPages ? ((Offset + DriverSizeAndNSFDRV) >> 12) : Bank);
 				Offset += Size;
 				break;
@@ -1736,7 +1784,7 @@ bool CCompiler::CollectLabelsBankswitched(CMap<CStringA, LPCSTR, int, int> &labe
 					Offset = FixedBankMaxSize - DriverSizeAndNSFDRV;
 					++Bank;
 				}
-				labelMap[pChunk->GetLabel()] = Offset;
+				Offsets[pChunk->GetLabelID()] = Offset;		// // //
 				pChunk->SetBank(Bank < FixedBankPages ? ((Offset + DriverSizeAndNSFDRV) >> 12) : Bank);
 				Offset += Size;
 				// fall through
@@ -1753,11 +1801,19 @@ bool CCompiler::CollectLabelsBankswitched(CMap<CStringA, LPCSTR, int, int> &labe
 	return true;
 }
 
-void CCompiler::AssignLabels(CMap<CStringA, LPCSTR, int, int> &labelMap)
+void CCompiler::CollectAliases(std::vector<int> &Offsets) const		// // //
+{
+	// Labels pointing into a chunk follow its offset
+	for (const CChunk *pChunk : m_vChunks)
+		for (const auto &Alias : pChunk->GetAliases())
+			Offsets[Alias.Label] = Offsets[pChunk->GetLabelID()] + Alias.Offset;
+}
+
+void CCompiler::AssignLabels(const std::vector<int> &Offsets)
 {
 	// Pass 2: assign addresses to labels
 	for (CChunk *pChunk : m_vChunks)
-		pChunk->AssignLabels(labelMap);
+		pChunk->AssignLabels(Offsets);
 }
 
 bool CCompiler::CompileData(bool bUseNSFDRV, bool bUseAllExp)
@@ -1866,6 +1922,11 @@ bool CCompiler::CompileData(bool bUseNSFDRV, bool bUseAllExp)
 	Print("Building music data...\n");
 
 	// Build music data
+	// // // Data compiled from objects unchanged since an earlier export is taken from the document's cache
+	CCompilerCache &Cache = m_pDocument->GetCompilerCache();
+	m_CacheSession = Cache.Begin();
+	m_iCachedPatterns = m_iCachedChunks = 0;
+
 	CreateMainHeader(bUseAllExp);
 	CreateSequenceList();
 	CreateInstrumentList();
@@ -1874,6 +1935,10 @@ bool CCompiler::CompileData(bool bUseNSFDRV, bool bUseAllExp)
 	StoreGrooves();		// // //
 	StoreSongs();
 
+	Cache.End(m_CacheSession);
+	if (m_iCachedPatterns > 0 || m_iCachedChunks > 0)		// // //
+		Print(" * Reused from the previous export: %i pattern(s), %i sequence, instrument and groove chunk(s)\n", m_iCachedPatterns, m_iCachedChunks);
+
 	// Determine if bankswitching is needed
 	m_bBankSwitched = false;
 	m_iMusicDataSize = CountData();
@@ -1915,10 +1980,10 @@ void CCompiler::Cleanup()
 {
 	// Delete objects
 
-	for (CChunk *pChunk : m_vChunks)
-		delete pChunk;
-
 	m_vChunks.clear();
+	m_Chunks.clear();		// // //
+	m_vLabelChunks.clear();
+	m_Labels.Clear();
 	m_vSequenceChunks.clear();
 	m_vInstrumentChunks.clear();
 	m_vGrooveChunks.clear();		// // //
@@ -1979,7 +2044,7 @@ void CCompiler::AddBankswitching()
 			int Length = pChunk->GetLength();
 			// Bank data is located at end
 			for (int j = 0; j < Length; ++j) {
-				pChunk->StoreBankReference(pChunk->GetDataRefName(j), 0);
+				pChunk->StoreBankReference(pChunk->GetDataRefLabel(j), 0);		// // //
 			}
 		}
 	}
@@ -2064,19 +2129,11 @@ bool CCompiler::IsInstrumentInPattern(int index) const
 	const int Channels = m_pDocument->GetAvailableChannels();
 
 	// Scan patterns in entire module
-	for (int i = 0; i < TrackCount; ++i) {
-		int PatternLength = m_pDocument->GetPatternLength(i);
-		for (int j = 0; j < Channels; ++j) {
-			for (int k = 0; k < MAX_PATTERN; ++k) {
-				for (int l = 0; l < PatternLength; ++l) {
-					stChanNote Note;
-					m_pDocument->GetDataAtPattern(i, k, j, l, &Note);
-					if (Note.Instrument == index)
-						return true;
-				}
-			}
-		}
-	}
+	for (int i = 0; i < TrackCount; ++i)
+		for (int j = 0; j < Channels; ++j)
+			for (int k = 0; k < MAX_PATTERN; ++k)
+				if (m_pDocument->IsInstrumentInPattern(i, k, j, index))		// // //
+					return true;
 
 	return false;
 }
@@ -2194,31 +2251,50 @@ int CCompiler::StoreSequence(const CSequence *pSeq, CStringA &label)
 	CChunk *pChunk = CreateChunk(CHUNK_SEQUENCE, label);
 	m_vSequenceChunks.push_back(pChunk);
 
-	// Store the sequence
-	int iItemCount	  = pSeq->GetItemCount();
-	int iLoopPoint	  = pSeq->GetLoopPoint();
-	int iReleasePoint = pSeq->GetReleasePoint();
-	int iSetting	  = pSeq->GetSetting();
+	return CompileCached(pChunk, {CHUNK_SEQUENCE, 0, {pSeq->GetVersion()}}, [&] {		// // //
+		// Store the sequence
+		int iItemCount	  = pSeq->GetItemCount();
+		int iLoopPoint	  = pSeq->GetLoopPoint();
+		int iReleasePoint = pSeq->GetReleasePoint();
+		int iSetting	  = pSeq->GetSetting();
 
-	if (iReleasePoint != -1)
-		iReleasePoint += 1;
-	else
-		iReleasePoint = 0;
+		if (iReleasePoint != -1)
+			iReleasePoint += 1;
+		else
+			iReleasePoint = 0;
 
-	if (iLoopPoint > iItemCount)
-		iLoopPoint = -1;
+		if (iLoopPoint > iItemCount)
+			iLoopPoint = -1;
 
-	pChunk->StoreByte((unsigned char)iItemCount);
-	pChunk->StoreByte((unsigned char)iLoopPoint);
-	pChunk->StoreByte((unsigned char)iReleasePoint);
-	pChunk->StoreByte((unsigned char)iSetting);
+		pChunk->StoreByte((unsigned char)iItemCount);
+		pChunk->StoreByte((unsigned char)iLoopPoint);
+		pChunk->StoreByte((unsigned char)iReleasePoint);
+		pChunk->StoreByte((unsigned char)iSetting);
 
-	for (int i = 0; i < iItemCount; ++i) {
-		pChunk->StoreByte(pSeq->GetItem(i));
-	}
+		for (int i = 0; i < iItemCount; ++i) {
+			pChunk->StoreByte(pSeq->GetItem(i));
+		}
 
-	// Return size of this chunk
-	return iItemCount + 4;
+		// Return size of this chunk
+		return iItemCount + 4;
+	});
+}
+
+int CCompiler::CompileCached(CChunk *pChunk, const CCompilerCache::stChunkKey &Key, const std::function<int()> &Compile)		// // //
+{
+	// Replays the chunk data compiled by an earlier export from the same objects, or compiles it
+	CCompilerCache &Cache = m_pDocument->GetCompilerCache();
+	CCompilerCache::stChunkEntry Entry;
+	if (Cache.Find(m_CacheSession, Key, Entry)) {
+		CCompilerCache::ReplayChunk(Entry, *pChunk);
+		++m_iCachedChunks;
+		return Entry.Size;
+	}
+
+	const int Begin = pChunk->GetLength();
+	const int Size = Compile();
+	Cache.Store(m_CacheSession, Key, CCompilerCache::RecordChunk(*pChunk, Begin, Size));
+	return Size;
 }
 
 // Instruments
@@ -2301,7 +2377,9 @@ void CCompiler::CreateInstrumentList()
 		}
 
 		// Returns number of bytes 
-		iTotalSize += pInstrument->Compile(pChunk, iIndex);		// // //
+		iTotalSize += CompileCached(pChunk, CCompilerCache::MakeInstrumentKey(pInstrument.get(), iIndex), [&] {		// // //
+			return pInstrument->Compile(pChunk, iIndex);
+		});
 
 		// // // Check if FDS
 		if (pInstrument->GetType() == INST_FDS && pWavetableChunk != NULL) {
@@ -2461,13 +2539,13 @@ void CCompiler::StoreGrooves()
 
 		CChunk *pChunk = CreateChunk(CHUNK_GROOVE, label);
 		m_vGrooveChunks.push_back(pChunk);
-		for (int j = 0; j < Groove->GetSize(); j++) {
-			pChunk->StoreByte(Groove->GetEntry(j));
-			Size++;
-		}
-		pChunk->StoreByte(0);
-		pChunk->StoreByte(Pos);
-		Size += 2;
+		Size += CompileCached(pChunk, {CHUNK_GROOVE, static_cast<int>(Pos), {Groove->GetVersion()}}, [&] {		// // //
+			for (int j = 0; j < Groove->GetSize(); j++)
+				pChunk->StoreByte(Groove->GetEntry(j));
+			pChunk->StoreByte(0);
+			pChunk->StoreByte(Pos);
+			return Groove->GetSize() + 2;
+		});
 		Count++;
 	}
 
@@ -2528,6 +2606,8 @@ void CCompiler::StoreSongs()
 	m_iSongBankReference = m_vSongChunks[0]->GetLength() - 1;	// Save bank value position (all songs are equal)
 
 	// Store actual songs
+	m_pDocument->GetCompilerCache().SetSettings(m_CacheSession,		// // //
+		CCompilerCache::MakeSettings(m_pDocument, m_iAssignedInstruments, (const unsigned char *)&m_iSamplesLookUp));
 	for (int i = 0; i < TrackCount; ++i) {
 		Print(" * Song %i:\n", i);
 		// Store frames
@@ -2535,10 +2615,12 @@ void CCompiler::StoreSongs()
 		// Store pattern data
 		StorePatterns(i);
 	}
-
 	if (m_iDuplicatePatterns > 0)
 		Print(" * %i duplicated pattern(s) removed\n", m_iDuplicatePatterns);
 
+	if (m_bMergePatternSuffixes)		// // //
+		MergePatternSuffixes();
+
 	Print("      Hash collisions: %i (of %i items)\n", m_iHashCollisions, m_PatternMap.GetCount());
 }
 
@@ -2611,60 +2693,81 @@ void CCompiler::StorePatterns(unsigned int Track)
 
 	const int iChannels = m_pDocument->GetAvailableChannels();
 
-	CPatternCompiler PatternCompiler(m_pDocument, m_iAssignedInstruments, (DPCM_List_t *)&m_iSamplesLookUp, m_pLogger);
-
 	int PatternCount = 0;
 	int PatternSize = 0;
 
-	// Iterate through all patterns
-	for (int i = 0; i < MAX_PATTERN; ++i) {
-		for (int j = 0; j < iChannels; ++j) {
-			// And store only used ones
-			if (IsPatternAddressed(Track, i, j)) {
-
-				// Compile pattern data
-				PatternCompiler.CompileData(Track, i, j);
+	// // // Collect the used patterns in the order they are stored
+	std::vector<stCompiledPattern> Patterns;
+	for (int i = 0; i < MAX_PATTERN; ++i)
+		for (int j = 0; j < iChannels; ++j)
+			if (IsPatternAddressed(Track, i, j))
+				Patterns.push_back({i, j});
+
+	// Compile pattern data, this only reads the document so every pattern can be compiled on its own thread
+	// // // Patterns that are unchanged since the last export are taken from the cache instead
+	CCompilerCache &Cache = m_pDocument->GetCompilerCache();
+	if (!m_pWorkerPool)
+		m_pWorkerPool = std::make_unique<CWorkerPool>(std::max(std::thread::hardware_concurrency(), 1u) - 1);
+	m_pWorkerPool->Run(static_cast<unsigned>(Patterns.size()), [&] (unsigned Index) {
+		stCompiledPattern &Pattern = Patterns[Index];
+		Pattern.Key = CCompilerCache::MakePatternKey(m_pDocument, m_CacheSession, Track, Pattern.Pattern, Pattern.Channel);
+		Pattern.Cached = Cache.Find(m_CacheSession, Pattern.Key, Pattern.Entry);
+		if (Pattern.Cached)
+			return;
+		CBufferedLog Log(Pattern.Entry.Log);		// Warnings are written after all patterns are done, in order
+		CPatternCompiler PatternCompiler(m_pDocument, m_iAssignedInstruments, (DPCM_List_t *)&m_iSamplesLookUp, &Log);
+		PatternCompiler.CompileData(Track, Pattern.Pattern, Pattern.Channel);
+		Pattern.Entry.Hash = PatternCompiler.GetHash();
+		Pattern.Entry.Data = PatternCompiler.GetData();
+	});
+
+	// Store them serially so that the output does not depend on the thread count
+	for (const auto &Pattern : Patterns) {
+		if (Pattern.Cached)
+			++m_iCachedPatterns;
+		else
+			Cache.Store(m_CacheSession, Pattern.Key, Pattern.Entry);
+		if (m_pLogger != NULL && !Pattern.Entry.Log.empty())
+			m_pLogger->WriteLog(Pattern.Entry.Log);
 
-				CStringA label;
-				label.Format(CChunkRenderText::LABEL_PATTERN, Track, i, j);
+		CStringA label;
+		label.Format(CChunkRenderText::LABEL_PATTERN, Track, Pattern.Pattern, Pattern.Channel);
 
-				bool StoreNew = true;
+		bool StoreNew = true;
 
 #ifdef REMOVE_DUPLICATE_PATTERNS
-				unsigned int Hash = PatternCompiler.GetHash();
-
-				// Check for duplicate patterns
-				CChunk *pDuplicate = m_PatternMap[Hash];
-
-				if (pDuplicate != NULL) {
-					// Hash only indicates that patterns may be equal, check exact data
-					if (PatternCompiler.CompareData(pDuplicate->GetStringData(PATTERN_CHUNK_INDEX))) {
-						// Duplicate was found, store a reference to existing pattern
-						m_DuplicateMap[label] = pDuplicate->GetLabel();
-						++m_iDuplicatePatterns;
-						StoreNew = false;
-					}
-				}
+		unsigned int Hash = Pattern.Entry.Hash;
+
+		// Check for duplicate patterns
+		CChunk *pDuplicate = m_PatternMap[Hash];
+
+		if (pDuplicate != NULL) {
+			// Hash only indicates that patterns may be equal, check exact data
+			if (Pattern.Entry.Data == pDuplicate->GetStringData(PATTERN_CHUNK_INDEX)) {
+				// Duplicate was found, store a reference to existing pattern
+				m_DuplicateMap[m_Labels.Intern(label)] = pDuplicate->GetLabelID();		// // //
+				++m_iDuplicatePatterns;
+				StoreNew = false;
+			}
+		}
 #endif /* REMOVE_DUPLICATE_PATTERNS */
 
-				if (StoreNew) {
-					// Store new pattern
-					CChunk *pChunk = CreateChunk(CHUNK_PATTERN, label);
-					m_vPatternChunks.push_back(pChunk);
+		if (StoreNew) {
+			// Store new pattern
+			CChunk *pChunk = CreateChunk(CHUNK_PATTERN, label);
+			m_vPatternChunks.push_back(pChunk);
 
 #ifdef REMOVE_DUPLICATE_PATTERNS
-					if (m_PatternMap[Hash] != NULL)
-						m_iHashCollisions++;
-					m_PatternMap[Hash] = pChunk;
+			if (m_PatternMap[Hash] != NULL)
+				m_iHashCollisions++;
+			m_PatternMap[Hash] = pChunk;
 #endif /* REMOVE_DUPLICATE_PATTERNS */
 
-					// Store pattern data as string
-					pChunk->StoreString(PatternCompiler.GetData());
+			// Store pattern data as string
+			pChunk->StoreString(Pattern.Entry.Data);
 
-					PatternSize += PatternCompiler.GetDataSize();
-					++PatternCount;
-				}
-			}
+			PatternSize += static_cast<int>(Pattern.Entry.Data.size());
+			++PatternCount;
 		}
 	}
 
@@ -2672,10 +2775,10 @@ void CCompiler::StorePatterns(unsigned int Track)
 	// Update references to duplicates
 	for (const auto pChunk : m_vFrameChunks) {
 		for (int j = 0, n = pChunk->GetLength(); j < n; ++j) {
-			CStringA str = m_DuplicateMap[pChunk->GetDataRefName(j)];
-			if (str.GetLength() != 0) {
+			auto it = m_DuplicateMap.find(pChunk->GetDataRefLabel(j));		// // //
+			if (it != m_DuplicateMap.end()) {
 				// Update reference
-				pChunk->UpdateDataRefName(j, str);
+				pChunk->UpdateDataRefLabel(j, it->second);
 			}
 		}
 	}
@@ -2684,12 +2787,80 @@ void CCompiler::StorePatterns(unsigned int Track)
 #ifdef LOCAL_DUPLICATE_PATTERN_REMOVAL
 	// Forget patterns when one whole track is stored
 	m_PatternMap.RemoveAll();
-	m_DuplicateMap.RemoveAll();
+	m_DuplicateMap.clear();
 #endif /* LOCAL_DUPLICATE_PATTERN_REMOVAL */
 
 	Print("      %i patterns (%i bytes)\n", PatternCount, PatternSize);
 }
 
+void CCompiler::MergePatternSuffixes()		// // //
+{
+	/*
+	 * The player reads a pattern from its start address with a fresh state every frame,
+	 * so a pattern whose data equals the last bytes of another one can point into it
+	 * instead of being stored. Longer patterns are kept first, each shorter one is
+	 * looked up among the ends of the patterns already kept.
+	 *
+	 */
+
+	std::vector<CChunk*> Order(m_vPatternChunks);
+	std::stable_sort(Order.begin(), Order.end(), [] (const CChunk *a, const CChunk *b) {
+		return a->GetStringData(PATTERN_CHUNK_INDEX).size() > b->GetStringData(PATTERN_CHUNK_INDEX).size();
+	});
+
+	// Hash of each end of the kept patterns, read backwards so it can be extended a byte at a time
+	const auto Hash = [] (std::uint64_t h, char x) {
+		return h * 0x100000001B3ull + static_cast<unsigned char>(x) + 1;
+	};
+	std::unordered_multimap<std::uint64_t, std::pair<CChunk*, unsigned int>> Suffixes;
+
+	std::unordered_set<const CChunk*> Merged;
+	unsigned int SavedSize = 0;
+
+	for (CChunk *pChunk : Order) {
+		const std::vector<char> &Data = pChunk->GetStringData(PATTERN_CHUNK_INDEX);
+
+		std::uint64_t h = 0;
+		for (auto it = Data.rbegin(); it != Data.rend(); ++it)
+			h = Hash(h, *it);
+
+		CChunk *pTarget = nullptr;
+		unsigned int Offset = 0;
+		for (auto [it, end] = Suffixes.equal_range(h); it != end && !pTarget; ++it) {
+			const std::vector<char> &Source = it->second.first->GetStringData(PATTERN_CHUNK_INDEX);
+			if (Source.size() - it->second.second == Data.size() && std::equal(Data.begin(), Data.end(), Source.begin() + it->second.second)) {
+				pTarget = it->second.first;
+				Offset = it->second.second;
+			}
+		}
+
+		if (pTarget) {
+			pTarget->AddAlias(pChunk->GetLabelID(), Offset);
+			m_vLabelChunks[pChunk->GetLabelID()] = pTarget;		// Bank of the pattern it is stored in
+			Merged.insert(pChunk);
+			SavedSize += static_cast<unsigned int>(Data.size());
+			continue;
+		}
+
+		h = 0;
+		for (unsigned int i = static_cast<unsigned int>(Data.size()); i-- > 0; ) {
+			h = Hash(h, Data[i]);
+			Suffixes.emplace(h, std::make_pair(pChunk, i));
+		}
+	}
+
+	if (Merged.empty())
+		return;
+
+	const auto IsMerged = [&Merged] (const CChunk *pChunk) {
+		return Merged.count(pChunk) != 0;
+	};
+	m_vChunks.erase(std::remove_if(m_vChunks.begin(), m_vChunks.end(), IsMerged), m_vChunks.end());
+	m_vPatternChunks.erase(std::remove_if(m_vPatternChunks.begin(), m_vPatternChunks.end(), IsMerged), m_vPatternChunks.end());
+
+	Print(" * %i pattern(s) stored at the end of others (%i bytes saved)\n", static_cast<int>(Merged.size()), SavedSize);
+}
+
 bool CCompiler::IsPatternAddressed(unsigned int Track, int Pattern, int Channel) const
 {
 	// Scan the frame list to see if a pattern is accessed for that frame
@@ -2854,39 +3025,38 @@ void CCompiler::ReadPeriodVibratoTables(int MachineType,
 	unsigned int *LUTN163,
 	unsigned int *LUTVibrato) const
 {
-	const CSoundGen *pSoundGen = theApp.GetSoundGenerator();
 	for (int i = 0; i <= CDetuneTable::DETUNE_N163; ++i) {		// // //
 		switch (i) {
 		case CDetuneTable::DETUNE_NTSC:
 			for (int j = 0; j < NOTE_COUNT; ++j)
-				LUTNTSC[j] = pSoundGen->ReadPeriodTable(j, i); break;
+				LUTNTSC[j] = m_pSoundGen->ReadPeriodTable(j, i); break;
 		case CDetuneTable::DETUNE_PAL:
 			if (MachineType != 0)
 				for (int j = 0; j < NOTE_COUNT; ++j)
-					LUTPAL[j] = pSoundGen->ReadPeriodTable(j, i); break;
+					LUTPAL[j] = m_pSoundGen->ReadPeriodTable(j, i); break;
 		case CDetuneTable::DETUNE_SAW:
 			if (m_iActualChip & SNDCHIP_VRC6)
 				for (int j = 0; j < NOTE_COUNT; ++j)
-					LUTSaw[j] = pSoundGen->ReadPeriodTable(j, i); break;
+					LUTSaw[j] = m_pSoundGen->ReadPeriodTable(j, i); break;
 		case CDetuneTable::DETUNE_VRC7:
 			if (m_iActualChip & SNDCHIP_VRC7)
 				for (int j = 0; j < NOTE_RANGE; ++j)
-					LUTVRC7[j] = pSoundGen->ReadPeriodTable(j, i); break;
+					LUTVRC7[j] = m_pSoundGen->ReadPeriodTable(j, i); break;
 		case CDetuneTable::DETUNE_FDS:
 			if (m_iActualChip & SNDCHIP_FDS)
 				for (int j = 0; j < NOTE_COUNT; ++j)
-					LUTFDS[j] = pSoundGen->ReadPeriodTable(j, i); break;
+					LUTFDS[j] = m_pSoundGen->ReadPeriodTable(j, i); break;
 		case CDetuneTable::DETUNE_N163:
 			if (m_iActualChip & SNDCHIP_N163)
 				for (int j = 0; j < NOTE_COUNT; ++j)
-					LUTN163[j] = pSoundGen->ReadPeriodTable(j, i); break;
+					LUTN163[j] = m_pSoundGen->ReadPeriodTable(j, i); break;
 		default:
 			AfxDebugBreak();
 		}
 	}
 
 	for (int i = 0; i < VIBRATO_LENGTH; ++i) {
-		LUTVibrato[i] = pSoundGen->ReadVibratoTable(i);
+		LUTVibrato[i] = m_pSoundGen->ReadVibratoTable(i);
 	}
 }
 
@@ -2915,8 +3085,16 @@ void CCompiler::CloseFileArray(CFilePtrArray &files)
 
 CChunk *CCompiler::CreateChunk(chunk_type_t Type, CStringA label)
 {
-	CChunk *pChunk = new CChunk(Type, label);
+	CChunk *pChunk = &m_Chunks.emplace_back(Type, label, m_Labels);		// // //
 	m_vChunks.push_back(pChunk);
+
+	// Index the first chunk of each label
+	const unsigned int ID = pChunk->GetLabelID();
+	if (ID >= m_vLabelChunks.size())
+		m_vLabelChunks.resize(ID + 1, nullptr);
+	if (m_vLabelChunks[ID] == nullptr)
+		m_vLabelChunks[ID] = pChunk;
+
 	return pChunk;
 }
 
@@ -2931,12 +3109,9 @@ int CCompiler::CountData() const
 	return Offset;
 }
 
-CChunk *CCompiler::GetObjectByRef(CStringA label) const
+CChunk *CCompiler::GetObjectByRef(unsigned int Label) const		// // //
 {
-	for (const auto pChunk : m_vChunks)
-		if (!label.Compare(pChunk->GetLabel()))
-			return pChunk;
-	return nullptr;
+	return Label < m_vLabelChunks.size() ? m_vLabelChunks[Label] : nullptr;
 }
 
 #if 0
@@ -22,6 +22,11 @@
 
 #include <memory>
 #include <string>
+#include <deque>		// // //
+#include <unordered_map>		// // //
+#include "Chunk.h"		// // //
+#include "CompilerCache.h"		// // //
+#include <functional>		// // //
 
 // NSF file header
 struct stNSFHeader {
@@ -83,10 +88,10 @@ struct stNSFeFooter {		// !! !!
 };
 
 struct driver_t;
-class CChunk;
-enum chunk_type_t;
+class CWorkerPool;		// // //
 class CDSample;		 // // //
 class CFamiTrackerDoc;		// // //
+class CSoundGen;
 class CSequence;		// // //
 class CInstrumentFDS;		// // //
 
@@ -107,7 +112,8 @@ public:
 class CCompiler
 {
 public:
-	CCompiler(CFamiTrackerDoc *pDoc, CCompilerLog *pLogger);
+	// Period and vibrato tables are read from pSoundGen, or from the application's sound generator if it is null
+	CCompiler(CFamiTrackerDoc *pDoc, CCompilerLog *pLogger, const CSoundGen *pSoundGen = nullptr);
 	~CCompiler();
 	
 	void	ExportNSF(LPCTSTR lpszFileName, int MachineType);
@@ -118,6 +124,11 @@ public:
 	void	ExportPRG(LPCTSTR lpszFileName, bool EnablePAL);
 	void	ExportASM(LPCTSTR lpszFileName, int MachineType, bool ExtraData);
 
+	bool	CompileOnly();		// // // Builds and links the music data without writing it
+
+	// // // Store patterns that equal the end of another pattern as a pointer into it (default on)
+	void	SetMergePatternSuffixes(bool Enable);
+
 private:
 	bool	OpenFile(LPCTSTR lpszFileName, CFile &file) const;
 
@@ -139,9 +150,10 @@ private:
 	bool	CompileData(bool bUseNSFDRV = false, bool UseAllExp = true);
 	void	ResolveLabels();
 	bool	ResolveLabelsBankswitched();
-	void	CollectLabels(CMap<CStringA, LPCSTR, int, int> &labelMap) const;
-	bool	CollectLabelsBankswitched(CMap<CStringA, LPCSTR, int, int> &labelMap);
-	void	AssignLabels(CMap<CStringA, LPCSTR, int, int> &labelMap);
+	void	CollectLabels(std::vector<int> &Offsets) const;		// // //
+	void	CollectAliases(std::vector<int> &Offsets) const;
+	bool	CollectLabelsBankswitched(std::vector<int> &Offsets);
+	void	AssignLabels(const std::vector<int> &Offsets);
 	void	AddBankswitching();
 	void	Cleanup();
 	void	CalculateLoadAddresses(unsigned short &MusicDataAddress, bool &bCompressedMode, bool ForceDecompress = false);
@@ -159,10 +171,12 @@ private:
 	void	CreateFrameList(unsigned int Track);
 
 	int		StoreSequence(const CSequence *pSeq, CStringA &label);
+	int		CompileCached(CChunk *pChunk, const CCompilerCache::stChunkKey &Key, const std::function<int()> &Compile);		// // //
 	void	StoreSamples();
 	void	StoreGrooves();		// // //
 	void	StoreSongs();
 	void	StorePatterns(unsigned int Track);
+	void	MergePatternSuffixes();		// // //
 
 	// Bankswitching functions
 	void	UpdateSamplePointers(unsigned int Origin);
@@ -209,7 +223,7 @@ private:
 
 	// Object list functions
 	CChunk	*CreateChunk(chunk_type_t Type, CStringA label);
-	CChunk	*GetObjectByRef(CStringA label) const;
+	CChunk	*GetObjectByRef(unsigned int Label) const;		// // //
 	int		CountData() const;
 
 	// Debugging
@@ -237,18 +251,17 @@ public:
 	static const int FLAG_VIBRATO;
 	static const int FLAG_LINEARPITCH;		// // //
 
-protected:
-	static CCompiler *pCompiler;			// Points to an active CCompiler object
-
 public:
-	static CCompiler *GetCompiler();		// Get the active CCompiler object, NULL otherwise
-
 	static unsigned int AdjustSampleAddress(unsigned int Address);
 
 private:
 	CFamiTrackerDoc *m_pDocument;
+	const CSoundGen *m_pSoundGen;
 
 	// Object lists
+	std::deque<CChunk> m_Chunks;			// // // Storage of all chunks, in creation order
+	CChunkLabels m_Labels;					// // // Names of all labels
+	std::vector<CChunk*> m_vLabelChunks;	// // // Chunk of each label ID, or null
 	std::vector<CChunk*> m_vChunks;
 	std::vector<CChunk*> m_vSequenceChunks;
 	std::vector<CChunk*> m_vInstrumentChunks;
@@ -305,6 +318,12 @@ private:
 	unsigned int	m_iSongBankReference;	// Offset to bank value in song header
 
 	unsigned int	m_iDuplicatePatterns;	// Number of duplicated patterns removed
+	bool			m_bMergePatternSuffixes;	// // // Run MergePatternSuffixes after storing the songs
+
+	// // // Reuse of data compiled by earlier exports of the document
+	CCompilerCache::stSession m_CacheSession;
+	unsigned int	m_iCachedPatterns;
+	unsigned int	m_iCachedChunks;
 
 	std::vector<int> m_vChanOrder;			// Channel order list
 
@@ -324,7 +343,8 @@ private:
 
 	// Optimization
 	CMap<UINT, UINT, CChunk*, CChunk*> m_PatternMap;
-	CMap<CStringA, LPCSTR, CStringA, LPCSTR> m_DuplicateMap;
+	std::unique_ptr<CWorkerPool> m_pWorkerPool;		// // // Compiles patterns, created on first use
+	std::unordered_map<unsigned int, unsigned int> m_DuplicateMap;		// // // Label IDs of duplicate patterns to the stored ones
 
 	// Debugging
 	CCompilerLog	*m_pLogger;
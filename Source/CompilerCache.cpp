@@ -0,0 +1,233 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+#include "stdafx.h"
+#include "FamiTrackerDoc.h"
+#include "SeqInstrument.h"
+#include "InstrumentFDS.h"
+#include "TrackerChannel.h"
+#include "PatternCompiler.h"
+#include "Chunk.h"
+#include "CompilerCache.h"
+#include <algorithm>
+
+static_assert(std::tuple_size<decltype(CCompilerCache::stChunkKey::Versions)>::value == SEQ_COUNT + 1,
+	"An instrument key holds the versions of the instrument and of each of its sequences");
+
+bool CCompilerCache::stPatternKey::operator==(const stPatternKey &other) const
+{
+	return Version == other.Version && Settings == other.Settings && Pattern == other.Pattern && Channel == other.Channel &&
+		ChannelID == other.ChannelID && Chip == other.Chip && Length == other.Length && EffColumns == other.EffColumns &&
+		Tempo == other.Tempo;
+}
+
+bool CCompilerCache::stChunkKey::operator==(const stChunkKey &other) const
+{
+	return Type == other.Type && Index == other.Index && Versions == other.Versions;
+}
+
+std::size_t CCompilerCache::stKeyHash::operator()(const stPatternKey &Key) const
+{
+	std::size_t Hash = static_cast<std::size_t>(Key.Version);
+	Hash = Hash * 31 + Key.Settings;
+	Hash = Hash * 31 + Key.Pattern;
+	Hash = Hash * 31 + Key.Channel;
+	Hash = Hash * 31 + Key.Length;
+	Hash = Hash * 31 + Key.EffColumns;
+	return Hash;
+}
+
+std::size_t CCompilerCache::stKeyHash::operator()(const stChunkKey &Key) const
+{
+	std::size_t Hash = Key.Type;
+	Hash = Hash * 31 + Key.Index;
+	for (const auto &Version : Key.Versions)
+		Hash = Hash * 31 + static_cast<std::size_t>(Version);
+	return Hash;
+}
+
+CCompilerCache::stPatternKey CCompilerCache::MakePatternKey(const CFamiTrackerDoc *pDoc, const stSession &Session, int Track, int Pattern, int Channel)
+{
+	const CTrackerChannel *pChannel = pDoc->GetChannel(Channel);
+
+	return {
+		pDoc->GetPatternVersion(Track, Channel, Pattern), Session.Settings, Pattern, Channel, pChannel->GetID(), pChannel->GetChip(),
+		pDoc->GetPatternLength(Track), pDoc->GetEffColumns(Track, Channel), pDoc->GetSongTempo(Track) != 0,
+	};
+}
+
+CCompilerCache::stChunkKey CCompilerCache::MakeInstrumentKey(const CInstrument *pInstrument, int Index)
+{
+	// CInstrument::Compile reads the instrument and the item counts of its sequences
+	stChunkKey Key {CHUNK_INSTRUMENT, Index, {pInstrument->GetVersion()}};
+
+	if (auto pSeqInst = dynamic_cast<const CSeqInstrument *>(pInstrument)) {
+		const int Count = pInstrument->GetType() == INST_FDS ? CInstrumentFDS::SEQUENCE_COUNT : SEQ_COUNT;
+		for (int i = 0; i < Count; ++i)
+			if (const CSequence *pSeq = pSeqInst->GetSequence(i))
+				Key.Versions[i + 1] = pSeq->GetVersion();
+	}
+
+	return Key;
+}
+
+std::vector<unsigned char> CCompilerCache::MakeSettings(const CFamiTrackerDoc *pDoc, const unsigned int *pInstList, const unsigned char *pDPCMList)
+{
+	std::vector<unsigned char> Settings;
+	const auto Append = [&Settings] (const void *pData, std::size_t Size) {
+		auto p = static_cast<const unsigned char *>(pData);
+		Settings.insert(Settings.end(), p, p + Size);
+	};
+	const auto AppendValue = [&Append] (auto Value) {
+		Append(&Value, sizeof(Value));
+	};
+
+	Append(pInstList, sizeof(unsigned int) * MAX_INSTRUMENTS);
+	Append(pDPCMList, sizeof(DPCM_List_t));
+	for (int i = 0; i < MAX_INSTRUMENTS; ++i)
+		AppendValue(pDoc->GetInstrumentType(i));
+	for (int i = 0; i < MAX_GROOVE; ++i)
+		AppendValue(pDoc->GetGroove(i) != NULL ? pDoc->GetGroove(i)->GetSize() + 1 : 0);
+	AppendValue(pDoc->GetExpansionChip());
+	AppendValue(pDoc->GetLinearPitch());
+	AppendValue(pDoc->GetSpeedSplitPoint());
+
+	return Settings;
+}
+
+CCompilerCache::stChunkEntry CCompilerCache::RecordChunk(const CChunk &Chunk, int Begin, int Size)
+{
+	stChunkEntry Entry {{}, Size};
+
+	for (int i = Begin; i < Chunk.GetLength(); ++i) {
+		ASSERT(!Chunk.IsDataBank(i));
+		const bool Reference = Chunk.IsDataReference(i);
+		Entry.Items.push_back({Chunk.GetData(i), static_cast<unsigned char>(Chunk.GetDataSize(i)), Reference ? Chunk.GetDataRefName(i) : ""});
+	}
+
+	return Entry;
+}
+
+void CCompilerCache::ReplayChunk(const stChunkEntry &Entry, CChunk &Chunk)
+{
+	for (const auto &Item : Entry.Items) {
+		if (!Item.Label.empty())
+			Chunk.StoreReference(Item.Label.c_str());
+		else if (Item.Size == 1)
+			Chunk.StoreByte(static_cast<unsigned char>(Item.Data));
+		else
+			Chunk.StoreWord(Item.Data);
+	}
+}
+
+CCompilerCache::stSession CCompilerCache::Begin()
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+
+	stSession Session {m_iSettings, ++m_iGeneration};
+	m_Running.insert(Session.Generation);
+	return Session;
+}
+
+void CCompilerCache::SetSettings(stSession &Session, std::vector<unsigned char> Settings)
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+
+	// Patterns compiled with the previous settings are no longer found, and are forgotten by End()
+	if (Settings != m_vSettings) {
+		m_vSettings = std::move(Settings);
+		++m_iSettings;
+	}
+	Session.Settings = m_iSettings;
+}
+
+void CCompilerCache::End(const stSession &Session)
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+
+	m_Running.erase(m_Running.find(Session.Generation));
+
+	// Entries used by a session that is still running are kept for it
+	const unsigned long long Oldest = m_Running.empty() ? Session.Generation : std::min(*m_Running.begin(), Session.Generation);
+	const auto Evict = [Oldest] (auto &Items) {
+		for (auto it = Items.begin(); it != Items.end(); )
+			it = it->second.LastUsed < Oldest ? Items.erase(it) : std::next(it);
+	};
+	Evict(m_Patterns);
+	Evict(m_Chunks);
+}
+
+void CCompilerCache::Clear()
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+
+	m_Patterns.clear();
+	m_Chunks.clear();
+	m_vSettings.clear();
+	++m_iSettings;
+}
+
+namespace {
+
+template <typename Map, typename Key, typename Entry>
+bool FindItem(Map &Items, const Key &K, Entry &E, unsigned long long Generation)
+{
+	auto it = Items.find(K);
+	if (it == Items.end())
+		return false;
+
+	it->second.LastUsed = std::max(it->second.LastUsed, Generation);
+	E = it->second.Entry;
+	return true;
+}
+
+template <typename Map, typename Key, typename Entry>
+void StoreItem(Map &Items, const Key &K, const Entry &E, unsigned long long Generation)
+{
+	auto &Item = Items[K];
+	Item.Entry = E;
+	Item.LastUsed = std::max(Item.LastUsed, Generation);
+}
+
+} // namespace
+
+bool CCompilerCache::Find(const stSession &Session, const stPatternKey &Key, stPatternEntry &Entry)
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+	return FindItem(m_Patterns, Key, Entry, Session.Generation);
+}
+
+void CCompilerCache::Store(const stSession &Session, const stPatternKey &Key, const stPatternEntry &Entry)
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+	StoreItem(m_Patterns, Key, Entry, Session.Generation);
+}
+
+bool CCompilerCache::Find(const stSession &Session, const stChunkKey &Key, stChunkEntry &Entry)
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+	return FindItem(m_Chunks, Key, Entry, Session.Generation);
+}
+
+void CCompilerCache::Store(const stSession &Session, const stChunkKey &Key, const stChunkEntry &Entry)
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+	StoreItem(m_Chunks, Key, Entry, Session.Generation);
+}
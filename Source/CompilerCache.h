@@ -0,0 +1,163 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class CFamiTrackerDoc;
+class CInstrument;
+class CChunk;
+
+/*!
+	\brief Data compiled by earlier exports of one document, so that repeated exports only
+	compile the patterns, sequences, instruments and grooves that changed.
+	\details Entries are keyed by the versions of the objects they were compiled from, which
+	change on every write, so looking an entry up never reads the module data itself. Several
+	compilers may use the cache at once; each one works within its own session.
+*/
+class CCompilerCache
+{
+public:
+	/*!	\brief Everything about one pattern that its compiled data depends on, besides the
+		settings of the session. */
+	struct stPatternKey {
+		unsigned long long Version;		// From CPatternData::GetPatternVersion
+		unsigned int Settings;
+		int Pattern;
+		int Channel;
+		int ChannelID;
+		int Chip;
+		unsigned int Length;
+		unsigned int EffColumns;
+		bool Tempo;
+
+		bool operator==(const stPatternKey &other) const;
+	};
+
+	struct stPatternEntry {
+		std::vector<char> Data;
+		unsigned int Hash;
+		std::string Log;		// Warnings printed while compiling
+	};
+
+	/*!	\brief The versions of the objects one sequence, instrument or groove chunk is compiled from. */
+	struct stChunkKey {
+		int Type;		// chunk_type_t
+		int Index;
+		std::array<unsigned long long, 6> Versions;
+
+		bool operator==(const stChunkKey &other) const;
+	};
+
+	/*!	\brief The data items of a chunk, with references kept by label name since label IDs
+		belong to one compiler. */
+	struct stChunkEntry {
+		struct stItem {
+			unsigned short Data;
+			unsigned char Size;
+			std::string Label;		// References only
+		};
+		std::vector<stItem> Items;
+		int Size;		// Size reported by the compiling function
+	};
+
+	/*!	\brief The settings and lifetime of the entries used by one export. */
+	struct stSession {
+		unsigned int Settings;
+		unsigned long long Generation;
+	};
+
+public:
+	/*!	\brief Builds the key of a pattern.
+		\param pDoc The document.
+		\param Session The session the pattern is compiled in.
+		\param Track The track index.
+		\param Pattern The pattern index.
+		\param Channel The channel index.
+		\return The pattern key. */
+	static stPatternKey MakePatternKey(const CFamiTrackerDoc *pDoc, const stSession &Session, int Track, int Pattern, int Channel);
+	/*!	\brief Builds the key of a compiled instrument.
+		\param pInstrument The instrument.
+		\param Index The index passed to CInstrument::Compile.
+		\return The chunk key. */
+	static stChunkKey MakeInstrumentKey(const CInstrument *pInstrument, int Index);
+	/*!	\brief Collects the module settings read by CPatternCompiler::CompileData.
+		\param pDoc The document.
+		\param pInstList The instrument assignment of the compiler.
+		\param pDPCMList The DPCM lookup table of the compiler, a DPCM_List_t.
+		\return The settings, to be passed to SetSettings. */
+	static std::vector<unsigned char> MakeSettings(const CFamiTrackerDoc *pDoc, const unsigned int *pInstList, const unsigned char *pDPCMList);
+
+	/*!	\brief Records the data items stored into a chunk.
+		\param Chunk The chunk.
+		\param Begin The index of the first item to record.
+		\param Size The size reported by the compiling function.
+		\return The cache entry. */
+	static stChunkEntry RecordChunk(const CChunk &Chunk, int Begin, int Size);
+	/*!	\brief Stores recorded data items into a chunk.
+		\param Entry The cache entry.
+		\param Chunk The chunk. */
+	static void ReplayChunk(const stChunkEntry &Entry, CChunk &Chunk);
+
+	/*!	\brief Starts an export.
+		\return The session. */
+	stSession Begin();
+	/*!	\brief Sets the settings of a session, before its patterns are looked up.
+		\param Session The session.
+		\param Settings Module settings read by CPatternCompiler::CompileData. Patterns compiled
+		with other settings are not found within the session. */
+	void	SetSettings(stSession &Session, std::vector<unsigned char> Settings);
+	/*!	\brief Ends an export, and forgets the entries not used since the oldest running session began.
+		\param Session The session. */
+	void	End(const stSession &Session);
+	void	Clear();
+
+	bool	Find(const stSession &Session, const stPatternKey &Key, stPatternEntry &Entry);
+	void	Store(const stSession &Session, const stPatternKey &Key, const stPatternEntry &Entry);
+	bool	Find(const stSession &Session, const stChunkKey &Key, stChunkEntry &Entry);
+	void	Store(const stSession &Session, const stChunkKey &Key, const stChunkEntry &Entry);
+
+private:
+	struct stKeyHash {
+		std::size_t operator()(const stPatternKey &Key) const;
+		std::size_t operator()(const stChunkKey &Key) const;
+	};
+
+	template <typename T>
+	struct stItem {
+		T Entry;
+		unsigned long long LastUsed = 0;		// Generation of the latest session using the entry
+	};
+
+	mutable std::mutex m_Mutex;
+	std::vector<unsigned char> m_vSettings;
+	unsigned int m_iSettings = 0;
+	unsigned long long m_iGeneration = 0;
+	std::multiset<unsigned long long> m_Running;
+	std::unordered_map<stPatternKey, stItem<stPatternEntry>, stKeyHash> m_Patterns;
+	std::unordered_map<stChunkKey, stItem<stChunkEntry>, stKeyHash> m_Chunks;
+};
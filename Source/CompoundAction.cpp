@@ -81,6 +81,20 @@ void CCompoundAction::RestoreRedoState(CMainFrame *pMainFrm) const		// // //
 	(*m_pActionList.rbegin())->RestoreRedoState(pMainFrm);
 }
 
+void CCompoundAction::Compact(CUndoJournal &Journal)		// // //
+{
+	for (auto &x : m_pActionList)
+		x->Compact(Journal);
+}
+
+std::size_t CCompoundAction::GetMemorySize() const		// // //
+{
+	std::size_t Size = Action::GetMemorySize();
+	for (const auto &x : m_pActionList)
+		Size += x->GetMemorySize();
+	return Size;
+}
+
 void CCompoundAction::JoinAction(Action *const pAction)
 {
 	m_pActionList.emplace_back(pAction);
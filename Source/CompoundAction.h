@@ -45,6 +45,9 @@ public:
 	void RestoreUndoState(CMainFrame *pMainFrm) const;		// // //
 	void RestoreRedoState(CMainFrame *pMainFrm) const;		// // //
 
+	void Compact(CUndoJournal &Journal);		// // //
+	std::size_t GetMemorySize() const;		// // //
+
 	/*!	\brief Adds an action to the compound to be performed last (and undoed first).
 		\param pAction Pointer to the action object. */
 	void JoinAction(Action *const pAction);
@@ -47,5 +47,6 @@ public:
 	afx_msg void OnBnClickedChanmap();
 	afx_msg void OnBnClickedVelocity();
 	afx_msg void OnBnClickedArpeggiate();
+	afx_msg void OnBnClickedTimestampNotes();		// // //
 	afx_msg void OnCbnSelchangeOutdevices();
 };
@@ -49,6 +49,7 @@ BEGIN_MESSAGE_MAP(CConfigSound, CPropertyPage)
 	ON_WM_HSCROLL()
 	ON_CBN_SELCHANGE(IDC_SAMPLE_RATE, OnCbnSelchangeSampleRate)
 	ON_CBN_SELCHANGE(IDC_DEVICES, OnCbnSelchangeDevices)
+	ON_BN_CLICKED(IDC_DEVICE_RATE, OnBnClickedDeviceRate)
 END_MESSAGE_MAP()
 
 const int MAX_BUFFER_LEN = 500;	// 500 ms
@@ -91,6 +92,7 @@ BOOL CConfigSound::OnInitDialog()
 	pTrebleSliderFreq->SetPos(pSettings->Sound.iTrebleFilter);
 	pTrebleSliderDamping->SetPos(pSettings->Sound.iTrebleDamping);
 	pVolumeSlider->SetPos(pSettings->Sound.iMixVolume);
+	CheckDlgButton(IDC_DEVICE_RATE, pSettings->Sound.bDeviceRate ? BST_CHECKED : BST_UNCHECKED);		// // //
 
 	UpdateTexts();
 
@@ -137,6 +139,7 @@ BOOL CConfigSound::OnApply()
 	pSettings->Sound.iMixVolume		= static_cast<CSliderCtrl*>(GetDlgItem(IDC_VOLUME))->GetPos();
 
 	pSettings->Sound.iDevice		= pDevices->GetCurSel();
+	pSettings->Sound.bDeviceRate	= IsDlgButtonChecked(IDC_DEVICE_RATE) != 0;		// // //
 
 	theApp.LoadSoundConfig();
 
@@ -153,6 +156,11 @@ void CConfigSound::OnCbnSelchangeDevices()
 	SetModified();
 }
 
+void CConfigSound::OnBnClickedDeviceRate()		// // //
+{
+	SetModified();
+}
+
 void CConfigSound::UpdateTexts()
 {
 	CString Text;
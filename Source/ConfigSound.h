@@ -47,4 +47,5 @@ public:
 	afx_msg void OnCbnSelchangeSampleRate();
 	afx_msg void OnCbnSelchangeSampleSize();
 	afx_msg void OnCbnSelchangeDevices();
+	afx_msg void OnBnClickedDeviceRate();
 };
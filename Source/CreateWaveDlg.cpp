@@ -139,27 +139,19 @@ void CCreateWaveDlg::OnBnClickedBegin()
 
 
 	auto nchan = m_ctlChannelList.GetCount();
-	{
-		// Mute selected channels
-		pView->UnmuteAllChannels();
-		for (int i = 0; i < nchan; ++i) {
-			if (m_ctlChannelList.GetCheck(i) == BST_UNCHECKED)
-				pView->ToggleChannel(i);
-		}
 
-		CWavProgressDlg ProgressDlg;
-		// Show the render progress dialog, this will also start rendering
-		ProgressDlg.BeginRender(outPathC, EndType, EndParam, Track);
-		if (ProgressDlg.CancelRender)
-			goto end;
+	// Mute selected channels
+	pView->UnmuteAllChannels();
+	for (int i = 0; i < nchan; ++i) {
+		if (m_ctlChannelList.GetCheck(i) == BST_UNCHECKED)
+			pView->ToggleChannel(i);
 	}
 
+	// Every checked channel is rendered to its own file during the same pass as the mix
+	std::vector<stRenderStem> Stems;
 	if (IsDlgButtonChecked(IDC_SEPERATE_CHANNEL_EXPORT)) {
 		for (int i = 0; i < nchan; ++i) {
 			if (m_ctlChannelList.GetCheck(i) == BST_CHECKED) {
-				pView->MuteAllChannels();
-				pView->ToggleChannel(i);
-
 				// Write wav file to same name as above, but with a suffix before the extension.
 				CString chanNameC; m_ctlChannelList.GetText(i, chanNameC);
 
@@ -173,20 +165,14 @@ void CCreateWaveDlg::OnBnClickedBegin()
 				chanOutPath.replace_filename("");
 				chanOutPath += text + ".wav"s;
 
-				CString chanOutPathC = conv::to_t(chanOutPath.string()).c_str();
-
-				CWavProgressDlg ProgressDlg;
-				// Show the render progress dialog, this will also start rendering
-				ProgressDlg.BeginRender(chanOutPathC, EndType, EndParam, Track);
-
-				// if cancelled early, abort further rendering.
-				if (ProgressDlg.CancelRender)
-					break;
+				Stems.push_back({pDoc->GetChannelType(i), conv::to_t(chanOutPath.string()).c_str()});
 			}
 		}
 	}
 
-	end:
+	CWavProgressDlg ProgressDlg;
+	// Show the render progress dialog, this will also start rendering
+	ProgressDlg.BeginRender(outPathC, EndType, EndParam, Track, Stems);
 
 	// Unmute all channels
 	pView->UnmuteAllChannels();
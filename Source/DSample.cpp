@@ -19,6 +19,10 @@
 */
 
 #include "DSample.h"
+#include <atomic>		// // //
+
+// // // Source of sample versions, shared by every document
+static std::atomic<unsigned long long> NextVersion { 1 };
 
 /*
  * CDSample
@@ -28,6 +32,7 @@
  */
 
 CDSample::CDSample(unsigned int Size) :
+	m_iVersion(NextVersion++),		// // //
 	m_iSampleSize(Size),
 	m_pSampleData(new char[Size]),
 	m_pName(new char[MAX_NAME_SIZE]())
@@ -35,6 +40,7 @@ CDSample::CDSample(unsigned int Size) :
 }
 
 CDSample::CDSample(const CDSample &sample) :		// // //
+	m_iVersion(sample.m_iVersion),
 	m_iSampleSize(sample.m_iSampleSize),
 	m_pSampleData(new char[sample.m_iSampleSize]),
 	m_pName(new char[MAX_NAME_SIZE])
@@ -62,6 +68,7 @@ void CDSample::SetData(unsigned int Size, char *pData)
 {
 	m_pSampleData.reset(pData);		// // //
 	m_iSampleSize = Size;
+	Modified();		// // //
 }
 
 unsigned int CDSample::GetSize() const
@@ -69,17 +76,34 @@ unsigned int CDSample::GetSize() const
 	return m_iSampleSize;
 }
 
-char *CDSample::GetData() const
+const char *CDSample::GetData() const		// // //
+{
+	return m_pSampleData.get();
+}
+
+char *CDSample::EditData()		// // //
 {
+	Modified();
 	return m_pSampleData.get();
 }
 
 void CDSample::SetName(const char *pName)
 {
 	strncpy_s(m_pName.get(), MAX_NAME_SIZE, pName, MAX_NAME_SIZE);
+	Modified();		// // //
 }
 
 const char *CDSample::GetName() const
 {
 	return m_pName.get();
 }
+
+unsigned long long CDSample::GetVersion() const		// // //
+{
+	return m_iVersion;
+}
+
+void CDSample::Modified()		// // //
+{
+	m_iVersion = NextVersion++;
+}
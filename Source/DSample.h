@@ -40,7 +40,10 @@ public:
 	unsigned int GetSize() const;
 
 	// Get sample data
-	char *GetData() const;
+	const char *GetData() const;		// // //
+
+	// // // Get sample data for writing in place, this gives the sample a new version
+	char *EditData();
 
 	// Set sample name
 	void SetName(const char *pName);
@@ -48,6 +51,9 @@ public:
 	// Get sample name
 	const char *GetName() const;
 
+	// // // Changes whenever the sample is written to
+	unsigned long long GetVersion() const;
+
 public:
 	// Max size of a sample as supported by the NES, in bytes
 	static const int MAX_SIZE = 0x0FF1;
@@ -55,6 +61,11 @@ public:
 	static const int MAX_NAME_SIZE = 256;
 
 private:
+	void Modified();		// // //
+
+private:
+	unsigned long long m_iVersion;		// // //
+
 	// Sample data
 	unsigned int m_iSampleSize;
 	std::unique_ptr<char[]> m_pSampleData;		// // //
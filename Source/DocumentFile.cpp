@@ -21,6 +21,9 @@
 #include "stdafx.h"
 #include "ModuleException.h"
 #include "DocumentFile.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
 // #include <Windows.h>
 
 //
@@ -42,20 +45,88 @@ const char *CDocumentFile::FILE_END_ID	  = "END";
 const unsigned int CDocumentFile::MAX_BLOCK_SIZE = 0x80000;
 const unsigned int CDocumentFile::BLOCK_SIZE = 0x10000;
 
+namespace {
+
+bool g_bMapFiles = true;		// // //
+
+} // namespace
+
 // CDocumentFile
 
 CDocumentFile::CDocumentFile() : 
 	m_pBlockData(NULL),
+	m_pBlockView(NULL),
+	m_iMaxBlockSize(0),
+	m_hMapping(NULL),
+	m_pMapView(NULL),
+	m_iMapSize(0),
+	m_iMapPointer(0),
 	m_cBlockID(new char[16])
 {
 }
 
 CDocumentFile::~CDocumentFile()
 {
+	UnmapFile();
 	SAFE_RELEASE_ARRAY(m_pBlockData);
 	SAFE_RELEASE_ARRAY(m_cBlockID);
 }
 
+void CDocumentFile::EnableMapping(bool Enable)		// // //
+{
+	g_bMapFiles = Enable;
+}
+
+bool CDocumentFile::IsMapped() const
+{
+	return m_pMapView != NULL;
+}
+
+bool CDocumentFile::MapFile()		// // //
+{
+	// Maps the whole file read-only, the block reader then works on the mapping directly
+	// instead of copying each block to the heap. Falls back to regular reads on failure.
+
+	if (!g_bMapFiles || m_pMapView != NULL)
+		return m_pMapView != NULL;
+
+	const ULONGLONG Size = GetLength();
+	if (Size == 0 || Size > SIZE_MAX)
+		return false;
+
+	m_hMapping = ::CreateFileMapping(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (m_hMapping == NULL)
+		return false;
+
+	m_pMapView = static_cast<const char *>(::MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_pMapView == NULL) {
+		::CloseHandle(m_hMapping);
+		m_hMapping = NULL;
+		return false;
+	}
+
+	m_iMapSize = Size;
+	m_iMapPointer = GetPosition();
+	return true;
+}
+
+void CDocumentFile::UnmapFile()
+{
+	if (m_pMapView != NULL) {
+		// A block view into the mapping is no longer valid
+		if (m_pBlockView != m_pBlockData)
+			m_pBlockView = NULL;
+		::UnmapViewOfFile(m_pMapView);
+		m_pMapView = NULL;
+	}
+	if (m_hMapping != NULL) {
+		::CloseHandle(m_hMapping);
+		m_hMapping = NULL;
+	}
+	m_iMapSize = 0;
+	m_iMapPointer = 0;
+}
+
 bool CDocumentFile::Finished() const
 {
 	return m_bFileDone;
@@ -101,44 +172,43 @@ void CDocumentFile::CreateBlock(const char *ID, int Version)
 	m_iBlockSize	= 0;
 	m_iBlockVersion = Version & 0xFFFF;
 
-	m_iMaxBlockSize = BLOCK_SIZE;
-
-	m_pBlockData = new char[m_iMaxBlockSize];
+	// Keep the buffer of the previous block, it only ever grows
+	if (m_pBlockData == NULL || m_iMaxBlockSize < BLOCK_SIZE) {
+		SAFE_RELEASE_ARRAY(m_pBlockData);
+		m_iMaxBlockSize = BLOCK_SIZE;
+		m_pBlockData = new char[m_iMaxBlockSize];
+	}
 
 	ASSERT(m_pBlockData != NULL);
 }
 
-void CDocumentFile::ReallocateBlock()
+void CDocumentFile::ReallocateBlock(unsigned int Size)
 {
-	int OldSize = m_iMaxBlockSize;
-	m_iMaxBlockSize += BLOCK_SIZE;
-	char *pData = new char[m_iMaxBlockSize];
+	// Grow geometrically, so that writing a block of n bytes copies O(n) bytes in total
+	unsigned int NewSize = std::max(m_iMaxBlockSize, BLOCK_SIZE);
+	while (NewSize < Size)
+		NewSize = NewSize <= UINT_MAX / 2 ? NewSize * 2 : UINT_MAX;
+
+	char *pData = new char[NewSize];
 	ASSERT(pData != NULL);
-	memcpy(pData, m_pBlockData, OldSize);
+	if (m_pBlockData != NULL)
+		memcpy(pData, m_pBlockData, m_iBlockPointer);
 	SAFE_RELEASE_ARRAY(m_pBlockData);
 	m_pBlockData = pData;
+	m_iMaxBlockSize = NewSize;
 }
 
 void CDocumentFile::WriteBlock(const char *pData, unsigned int Size)
 {
 	ASSERT(m_pBlockData != NULL);
 
-	unsigned int WritePtr = 0;
-
 	// Allow block to grow in size
+	if (Size > m_iMaxBlockSize - m_iBlockPointer)
+		ReallocateBlock(m_iBlockPointer + Size);
 
 	unsigned Previous = m_iBlockPointer;
-	while (Size > 0) {
-		unsigned int WriteSize = (Size > BLOCK_SIZE) ? BLOCK_SIZE : Size;
-
-		if ((m_iBlockPointer + WriteSize) >= m_iMaxBlockSize)
-			ReallocateBlock();
-
-		memcpy(m_pBlockData + m_iBlockPointer, pData + WritePtr, WriteSize);
-		m_iBlockPointer += WriteSize;
-		Size -= WriteSize;
-		WritePtr += WriteSize;
-	}
+	memcpy(m_pBlockData + m_iBlockPointer, pData, Size);
+	m_iBlockPointer += Size;
 	m_iPreviousPointer = Previous;
 }
 
@@ -192,8 +262,6 @@ bool CDocumentFile::FlushBlock()
 		return false;
 	}
 
-	SAFE_RELEASE_ARRAY(m_pBlockData);
-
 	return true;
 }
 
@@ -205,6 +273,8 @@ void CDocumentFile::ValidateFile()
 
 	m_cFileHFTModule = 0;
 
+	MapFile();		// // //
+
 	CModuleException* e = new CModuleException();		// // // blank
 
 	// Check ident string
@@ -274,6 +344,14 @@ bool CDocumentFile::ReadBlock()
 	memset(m_cBlockID, 0, 16);
 
 	BytesRead = Read(m_cBlockID, 16);
+
+	// The end marker has no header beyond its ID
+	if (strcmp(m_cBlockID, FILE_END_ID) == 0 || BytesRead == 0) {
+		m_bFileDone = true;
+		m_iBlockSize = 0;
+		return false;
+	}
+
 	Read(&m_iBlockVersion, sizeof(unsigned int));
 	Read(&m_iBlockSize, sizeof(unsigned int));
 
@@ -283,16 +361,31 @@ bool CDocumentFile::ReadBlock()
 		return true;
 	}
 
-	SAFE_RELEASE_ARRAY(m_pBlockData);
-	m_pBlockData = new char[m_iBlockSize];
-
-	Read(m_pBlockData, m_iBlockSize);
-
-	if (strcmp(m_cBlockID, FILE_END_ID) == 0)
-		m_bFileDone = true;
-
-	if (BytesRead == 0)
-		m_bFileDone = true;
+	if (m_pMapView != NULL) {		// // // parse the block in place
+		if (m_iBlockSize > m_iMapSize - m_iMapPointer) {
+			// Parts of file is missing
+			m_bIncomplete = true;
+			memset(m_cBlockID, 0, 16);
+			return true;
+		}
+		m_pBlockView = m_pMapView + m_iMapPointer;
+		m_iPreviousPosition = m_iFilePosition;
+		m_iFilePosition = m_iMapPointer;
+		m_iMapPointer += m_iBlockSize;
+	}
+	else {
+		if (m_iBlockSize > m_iMaxBlockSize) {
+			SAFE_RELEASE_ARRAY(m_pBlockData);
+			m_pBlockData = new char[m_iBlockSize];
+			m_iMaxBlockSize = m_iBlockSize;
+		}
+		if (Read(m_pBlockData, m_iBlockSize) < m_iBlockSize) {
+			m_bIncomplete = true;
+			memset(m_cBlockID, 0, 16);
+			return true;
+		}
+		m_pBlockView = m_pBlockData;
+	}
 /*
 	if (GetPosition() == GetLength() && !m_bFileDone) {
 		// Parts of file is missing
@@ -326,13 +419,26 @@ void CDocumentFile::RollbackPointer(int count)
 // avoid using this as much as possible
 void CDocumentFile::RollbackFilePointer(int count)
 {
-	CFile::Seek((count * -1), CFile::current);
+	if (m_pMapView != NULL)		// // //
+		m_iMapPointer -= count;
+	else
+		CFile::Seek((count * -1), CFile::current);
+}
+
+void CDocumentFile::CheckBlockRead(unsigned int Size) const		// // //
+{
+	if (Size > m_iBlockSize || m_iBlockPointer > m_iBlockSize - Size) {
+		CModuleException *e = GetException();
+		e->AppendError("Unexpected end of block (reading %u bytes at 0x%X, block size 0x%X)", Size, m_iBlockPointer, m_iBlockSize);
+		e->Raise();
+	}
 }
 
 int CDocumentFile::GetBlockInt()
 {
+	CheckBlockRead(sizeof(int));
 	int Value;
-	memcpy(&Value, m_pBlockData + m_iBlockPointer, sizeof(Value));
+	memcpy(&Value, m_pBlockView + m_iBlockPointer, sizeof(Value));
 	m_iPreviousPointer = m_iBlockPointer;
 	m_iBlockPointer += sizeof(Value);
 	m_iPreviousPosition = m_iFilePosition;		// // //
@@ -342,8 +448,8 @@ int CDocumentFile::GetBlockInt()
 
 char CDocumentFile::GetBlockChar()
 {
-	char Value;
-	memcpy(&Value, m_pBlockData + m_iBlockPointer, sizeof(Value));
+	CheckBlockRead(sizeof(char));
+	char Value = m_pBlockView[m_iBlockPointer];
 	m_iPreviousPointer = m_iBlockPointer;
 	m_iBlockPointer += sizeof(Value);
 	m_iPreviousPosition = m_iFilePosition;		// // //
@@ -382,7 +488,8 @@ void CDocumentFile::GetBlock(void *Buffer, int Size)
 	ASSERT(Size < MAX_BLOCK_SIZE);
 	ASSERT(Buffer != NULL);
 
-	memcpy(Buffer, m_pBlockData + m_iBlockPointer, Size);
+	CheckBlockRead(Size);
+	memcpy(Buffer, m_pBlockView + m_iBlockPointer, Size);
 	m_iPreviousPointer = m_iBlockPointer;
 	m_iBlockPointer += Size;
 	m_iPreviousPosition = m_iFilePosition;		// // //
@@ -435,6 +542,13 @@ void CDocumentFile::RaiseModuleException(std::string Msg) const		// // //
 UINT CDocumentFile::Read(void *lpBuf, UINT nCount)		// // //
 {
 	m_iPreviousPosition = m_iFilePosition;
+	if (m_pMapView != NULL) {
+		m_iFilePosition = m_iMapPointer;
+		const UINT Count = static_cast<UINT>(std::min<ULONGLONG>(nCount, m_iMapSize - m_iMapPointer));
+		memcpy(lpBuf, m_pMapView + m_iMapPointer, Count);
+		m_iMapPointer += Count;
+		return Count;
+	}
 	m_iFilePosition = GetPosition();
 	return CFile::Read(lpBuf, nCount);
 }
@@ -445,3 +559,9 @@ void CDocumentFile::Write(const void *lpBuf, UINT nCount)		// // //
 	m_iFilePosition = GetPosition();
 	CFile::Write(lpBuf, nCount);
 }
+
+void CDocumentFile::Close()		// // //
+{
+	UnmapFile();
+	CFile::Close();
+}
@@ -76,6 +76,11 @@ public:
 	// // // Overrides
 	virtual UINT Read(void* lpBuf, UINT nCount);
 	virtual void Write(const void* lpBuf, UINT nCount);
+	virtual void Close();
+
+	// Loaded files are memory-mapped unless disabled here (for benchmarking)
+	static void	EnableMapping(bool Enable);
+	bool		IsMapped() const;
 
 public:
 	// Constants
@@ -95,7 +100,10 @@ private:
 	template<class T> void WriteBlockData(T Value);
 
 protected:
-	void ReallocateBlock();
+	void ReallocateBlock(unsigned int Size);
+	bool MapFile();
+	void UnmapFile();
+	void CheckBlockRead(unsigned int Size) const;
 
 protected:
 	unsigned int	m_iFileVersion;
@@ -106,10 +114,16 @@ protected:
 	char			*m_cBlockID;
 	unsigned int	m_iBlockSize;
 	unsigned int	m_iBlockVersion;
-	char			*m_pBlockData;
+	char			*m_pBlockData;		// Owned buffer, for writing and for reading unmapped files
+	const char		*m_pBlockView;		// Data of the block being read, in the mapping or in m_pBlockData
 
 	unsigned int	m_iMaxBlockSize;
 
+	HANDLE			m_hMapping;
+	const char		*m_pMapView;
+	ULONGLONG		m_iMapSize;
+	ULONGLONG		m_iMapPointer;
+
 	unsigned int	m_iBlockPointer;
 	unsigned int	m_iPreviousPointer;		// // //
 	ULONGLONG		m_iFilePosition, m_iPreviousPosition;		// // //
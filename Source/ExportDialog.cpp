@@ -34,6 +34,10 @@
 #include "CustomExporters.h"
 #include "DocumentWrapper.h"
 #include "MainFrm.h"
+#include "FamiTrackerView.h"
+#include "SoundGen.h"
+#include "WavProgressDlg.h"
+#include "VGMWriter.h"
 
 // Define internal exporters
 const LPTSTR CExportDialog::DEFAULT_EXPORT_NAMES[] = {
@@ -44,6 +48,7 @@ const LPTSTR CExportDialog::DEFAULT_EXPORT_NAMES[] = {
 	_T("BIN - Raw music data"),
 	_T("PRG - Clean 32kB ROM image"),
 	_T("ASM - Assembly source"),
+	_T("VGM - Video Game Music log"),
 };
 
 const exportFunc_t CExportDialog::DEFAULT_EXPORT_FUNCS[] = {
@@ -54,9 +59,10 @@ const exportFunc_t CExportDialog::DEFAULT_EXPORT_FUNCS[] = {
 	&CExportDialog::CreateBIN,
 	&CExportDialog::CreatePRG,
 	&CExportDialog::CreateASM,
+	&CExportDialog::CreateVGM,
 };
 
-const int CExportDialog::DEFAULT_EXPORTERS = 7;		// !! !!
+const int CExportDialog::DEFAULT_EXPORTERS = 8;
 
 // Remember last option when dialog is closed
 int CExportDialog::m_iExportOption = 0;
@@ -70,6 +76,7 @@ LPCTSTR CExportDialog::RAW_FILTER[]   = { _T("Raw song data (*.bin)"), _T(".bin"
 LPCTSTR CExportDialog::DPCMS_FILTER[] = { _T("DPCM sample bank (*.bin)"), _T(".bin") };
 LPCTSTR CExportDialog::PRG_FILTER[]   = { _T("NES program bank (*.prg)"), _T(".prg") };
 LPCTSTR CExportDialog::ASM_FILTER[]   = { _T("Assembly text (*.asm)"), _T(".asm") };
+LPCTSTR CExportDialog::VGM_FILTER[]   = { _T("VGM file (*.vgm)"), _T(".vgm") };
 
 // Compiler logger
 
@@ -147,6 +154,8 @@ BOOL CExportDialog::OnInitDialog()
 	SetDlgItemText(IDC_ARTIST, CString(pDoc->GetSongArtist()));
 	SetDlgItemText(IDC_COPYRIGHT, CString(pDoc->GetSongCopyright()));
 
+	CheckDlgButton(IDC_MERGE_PATTERNS, 1);		// // //
+
 	// Fill the export box
 	CComboBox *pTypeBox = static_cast<CComboBox*>(GetDlgItem(IDC_TYPE));
 
@@ -209,6 +218,7 @@ void CExportDialog::CreateNSF()
 	CFamiTrackerDoc *pDoc = CFamiTrackerDoc::GetDoc();
 	CString	DefFileName = pDoc->GetFileTitle();
 	CCompiler Compiler(pDoc, new CEditLog(GetDlgItem(IDC_OUTPUT)));
+	Compiler.SetMergePatternSuffixes(IsDlgButtonChecked(IDC_MERGE_PATTERNS) != 0);		// // //
 	CString Name, Artist, Copyright;
 	CString filter = LoadDefaultFilter(NSF_FILTER[0], NSF_FILTER[1]);
 	int MachineType = 0;
@@ -251,6 +261,7 @@ void CExportDialog::CreateNSFe()		// // //
 	CFamiTrackerDoc *pDoc = CFamiTrackerDoc::GetDoc();
 	CString	DefFileName = pDoc->GetFileTitle();
 	CCompiler Compiler(pDoc, new CEditLog(GetDlgItem(IDC_OUTPUT)));
+	Compiler.SetMergePatternSuffixes(IsDlgButtonChecked(IDC_MERGE_PATTERNS) != 0);		// // //
 	CString Name, Artist, Copyright;
 	CString filter = LoadDefaultFilter(NSFE_FILTER[0], NSFE_FILTER[1]);
 	int MachineType = 0;
@@ -293,6 +304,7 @@ void CExportDialog::CreateNSF2()
 	CFamiTrackerDoc* pDoc = CFamiTrackerDoc::GetDoc();
 	CString	DefFileName = pDoc->GetFileTitle();
 	CCompiler Compiler(pDoc, new CEditLog(GetDlgItem(IDC_OUTPUT)));
+	Compiler.SetMergePatternSuffixes(IsDlgButtonChecked(IDC_MERGE_PATTERNS) != 0);		// // //
 	CString Name, Artist, Copyright;
 	CString filter = LoadDefaultFilter(NSF2_FILTER[0], NSF2_FILTER[1]);
 	int MachineType = 0;
@@ -335,6 +347,7 @@ void CExportDialog::CreateNES()
 	CFamiTrackerDoc *pDoc = CFamiTrackerDoc::GetDoc();
 	CString	DefFileName = pDoc->GetFileTitle();
 	CCompiler Compiler(pDoc, new CEditLog(GetDlgItem(IDC_OUTPUT)));
+	Compiler.SetMergePatternSuffixes(IsDlgButtonChecked(IDC_MERGE_PATTERNS) != 0);		// // //
 	CString filter = LoadDefaultFilter(NES_FILTER[0], NES_FILTER[1]);
 
 	CFileDialog FileDialog(FALSE, NES_FILTER[1], DefFileName, OFN_HIDEREADONLY | OFN_OVERWRITEPROMPT, filter);
@@ -356,6 +369,7 @@ void CExportDialog::CreateBIN()
 {
 	CFamiTrackerDoc *pDoc = CFamiTrackerDoc::GetDoc();
 	CCompiler Compiler(pDoc, new CEditLog(GetDlgItem(IDC_OUTPUT)));
+	Compiler.SetMergePatternSuffixes(IsDlgButtonChecked(IDC_MERGE_PATTERNS) != 0);		// // //
 	CString MusicFilter = LoadDefaultFilter(RAW_FILTER[0], RAW_FILTER[1]);
 	CString DPCMFilter = LoadDefaultFilter(DPCMS_FILTER[0], DPCMS_FILTER[1]);
 	CString Name, Artist, Copyright;
@@ -421,6 +435,7 @@ void CExportDialog::CreatePRG()
 {
 	CFamiTrackerDoc *pDoc = CFamiTrackerDoc::GetDoc();
 	CCompiler Compiler(pDoc, new CEditLog(GetDlgItem(IDC_OUTPUT)));
+	Compiler.SetMergePatternSuffixes(IsDlgButtonChecked(IDC_MERGE_PATTERNS) != 0);		// // //
 	CString Filter = LoadDefaultFilter(PRG_FILTER[0], PRG_FILTER[1]);
 
 	CFileDialog FileDialog(FALSE, PRG_FILTER[1], _T("music.prg"), OFN_HIDEREADONLY | OFN_OVERWRITEPROMPT, Filter);
@@ -443,6 +458,7 @@ void CExportDialog::CreateASM()
 	// Currently not included
 	CFamiTrackerDoc *pDoc = CFamiTrackerDoc::GetDoc();
 	CCompiler Compiler(pDoc, new CEditLog(GetDlgItem(IDC_OUTPUT)));
+	Compiler.SetMergePatternSuffixes(IsDlgButtonChecked(IDC_MERGE_PATTERNS) != 0);		// // //
 	CString Name, Artist, Copyright;
 	int MachineType = 0;
 	bool ExtraData = IsDlgButtonChecked(IDC_CHECK_EXTRADATA);
@@ -481,6 +497,48 @@ void CExportDialog::CreateASM()
 	theApp.GetSettings()->SetPath(FileDialogMusic.GetPathName(), PATH_NSF);
 }
 
+void CExportDialog::CreateVGM()
+{
+	CFamiTrackerDoc *pDoc = CFamiTrackerDoc::GetDoc();
+	CString	DefFileName = pDoc->GetFileTitle();
+	CEditLog Log(GetDlgItem(IDC_OUTPUT));
+	CString Name, Artist, Copyright;
+	CString filter = LoadDefaultFilter(VGM_FILTER[0], VGM_FILTER[1]);
+
+	// Collect header info, the machine type is always the one of the module
+	GetDlgItemText(IDC_NAME, Name);
+	GetDlgItemText(IDC_ARTIST, Artist);
+	GetDlgItemText(IDC_COPYRIGHT, Copyright);
+
+	USES_CONVERSION;
+
+	pDoc->SetSongName(T2A(Name.GetBuffer()));
+	pDoc->SetSongArtist(T2A(Artist.GetBuffer()));
+	pDoc->SetSongCopyright(T2A(Copyright.GetBuffer()));
+
+	CFileDialog FileDialog(FALSE, VGM_FILTER[1], DefFileName, OFN_HIDEREADONLY | OFN_OVERWRITEPROMPT, filter);
+
+	FileDialog.m_pOFN->lpstrInitialDir = theApp.GetSettings()->GetPath(PATH_NSF);
+
+	if (FileDialog.DoModal() == IDCANCEL)
+		return;
+
+	Log.Clear();
+	const int Chips = pDoc->GetExpansionChip();
+	if (Chips & ~CVGMWriter::GetSupportedChips(Chips))
+		Log.WriteLog("Warning: VGM files cannot hold some of the expansion chips, their channels are left out.\r\n");
+
+	// Play the selected track once, a looping track loops back to the end of its intro
+	CString Path = FileDialog.GetPathName();
+	int Track = static_cast<CMainFrame*>(theApp.m_pMainWnd)->GetSelectedTrack();
+	CFamiTrackerView::GetView()->UnmuteAllChannels();
+	CWavProgressDlg ProgressDlg;
+	ProgressDlg.BeginRender(Path, SONG_LOOP_LIMIT, 1, Track, {}, RENDER_VGM);
+
+	Log.WriteLog("Done\r\n");
+	theApp.GetSettings()->SetPath(FileDialog.GetPathName(), PATH_NSF);
+}
+
 void CExportDialog::CreateCustom( CString name )
 {
 	theApp.GetCustomExporters()->SetCurrentExporter( name );
@@ -517,6 +575,7 @@ void CExportDialog::OnBnClickedPlay()
 
 	CFamiTrackerDoc *pDoc = CFamiTrackerDoc::GetDoc();
 	CCompiler Compiler(pDoc, new CEditLog(static_cast<CEdit*>(GetDlgItem(IDC_OUTPUT))));
+	Compiler.SetMergePatternSuffixes(IsDlgButtonChecked(IDC_MERGE_PATTERNS) != 0);		// // //
 
 	Compiler.ExportNSF(file, (IsDlgButtonChecked(IDC_PAL) != 0));
 
@@ -53,6 +53,7 @@ protected:
 	static LPCTSTR DPCMS_FILTER[2];
 	static LPCTSTR PRG_FILTER[2];
 	static LPCTSTR ASM_FILTER[2];
+	static LPCTSTR VGM_FILTER[2];
 
 #ifdef _DEBUG
 	CString m_strFile;
@@ -67,6 +68,7 @@ protected:
 	void CreateBIN();
 	void CreatePRG();
 	void CreateASM();
+	void CreateVGM();
 	void CreateCustom( CString name );
 
 	DECLARE_MESSAGE_MAP()
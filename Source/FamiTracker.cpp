@@ -170,7 +170,7 @@ BOOL CFamiTrackerApp::InitInstance()
 	m_pMIDI = new CMIDI();
 
 	// Create sound generator
-	m_pSoundGenerator = std::make_shared<CSoundGen>();
+	m_pSoundGenerator = std::make_shared<CSoundGen>(m_pSettings);		// // //
 
 	// Create channel map
 	m_pChannelMap = new CChannelMap();
@@ -225,7 +225,20 @@ BOOL CFamiTrackerApp::InitInstance()
 	// Handle command line export
 	if (cmdInfo.m_bExport) {
 		CCommandLineExport exporter;
-		exporter.CommandLineExport(cmdInfo.m_strFileName, cmdInfo.m_strExportFile, cmdInfo.m_strExportLogFile, cmdInfo.m_strExportDPCMFile);
+		exporter.CommandLineExport(cmdInfo.m_strFileName, cmdInfo.m_strExportFile, cmdInfo.m_strExportLogFile, cmdInfo.m_strExportDPCMFile,
+			!cmdInfo.m_bNoMergePatterns);		// // //
+
+		return FALSE;
+	}
+	if (cmdInfo.m_bRender) {
+		CCommandLineExport exporter;
+		exporter.BatchRender(cmdInfo.m_strRenderJobFile, cmdInfo.m_strRenderLogFile);
+
+		return FALSE;
+	}
+	if (cmdInfo.m_bBenchmark) {
+		CCommandLineExport exporter;
+		exporter.Benchmark(cmdInfo.m_strFileName, cmdInfo.m_iBenchmarkIterations, cmdInfo.m_strBenchmarkLogFile);
 
 		return FALSE;
 	}
@@ -580,7 +593,7 @@ bool CFamiTrackerApp::CheckSingleInstance(CFTCommandLineInfo &cmdInfo)
 	if (!GetSettings()->General.bSingleInstance)
 		return false;
 
-	if (cmdInfo.m_bExport)
+	if (cmdInfo.m_bExport || cmdInfo.m_bRender || cmdInfo.m_bBenchmark)
 		return false;
 
 	m_pInstanceMutex = new CMutex(FALSE, FT_SHARED_MUTEX_NAME);
@@ -947,11 +960,18 @@ CString MakeFloatString(float val, LPCTSTR format)
 CFTCommandLineInfo::CFTCommandLineInfo() : CCommandLineInfo(),
 	m_bLog(false),
 	m_bExport(false),
+	m_bNoMergePatterns(false),		// // //
+	m_bRender(false),
+	m_bBenchmark(false),
 	m_bPlay(false),
 	m_bHelp(false),		// // !!
 	m_strExportFile(_T("")),
 	m_strExportLogFile(_T("")),
-	m_strExportDPCMFile(_T(""))
+	m_strExportDPCMFile(_T("")),
+	m_strRenderJobFile(_T("")),
+	m_strRenderLogFile(_T("")),
+	m_iBenchmarkIterations(10),
+	m_strBenchmarkLogFile(_T(""))
 {
 }
 
@@ -966,6 +986,21 @@ void CFTCommandLineInfo::ParseParam(const TCHAR* pszParam, BOOL bFlag, BOOL bLas
 			m_bExport = true;
 			return;
 		}
+		// // // Keep patterns that end other patterns as separate copies (/nomerge)
+		else if (!_tcsicmp(pszParam, _T("nomerge"))) {
+			m_bNoMergePatterns = true;
+			return;
+		}
+		// Batch render to WAV (/render)
+		else if (!_tcsicmp(pszParam, _T("render"))) {
+			m_bRender = true;
+			return;
+		}
+		// Time loading and saving (/benchmark)
+		else if (!_tcsicmp(pszParam, _T("benchmark"))) {
+			m_bBenchmark = true;
+			return;
+		}
 		// Auto play (/play or /p)
 		else if (!_tcsicmp(pszParam, _T("play")) || !_tcsicmp(pszParam, _T("p"))) {
 			m_bPlay = true;
@@ -993,13 +1028,20 @@ void CFTCommandLineInfo::ParseParam(const TCHAR* pszParam, BOOL bFlag, BOOL bLas
 			errno_t err = freopen_s(&cout, "CON", "w", stdout);
 			// TODO: format this better
 			std::string helpmessage = "H-FamiTracker commandline help";
-;			helpmessage += "\nusage: H-FamiTracker [module file] [-play | -export | -nodump | -log]\n";
+;			helpmessage += "\nusage: H-FamiTracker [module file] [-play | -export | -render | -benchmark | -nodump | -log]\n";
 			helpmessage += "options:\n";
 			helpmessage += "play\t: automatically plays when the program starts\n";
 			helpmessage += "export\t: exports the module to a specified format. the format is determined by the filetype of the output.\n";
-			helpmessage += "\t-export [output file] [optional log file] [DPCM file for BIN export]\n";
+			helpmessage += "\t-export [output file] [optional log file] [DPCM file for BIN export] [-nomerge]\n";
+			helpmessage += "\t-nomerge stores every pattern separately, instead of storing a pattern that ends another one inside it.\n";
 			helpmessage += "\tthe following formats are available:\n";
-			helpmessage += "\t\t.nsf\n\t\t.nsfe\n\t\t.nsf2\t\t\t(generates NSF2 formatted file)\n\t\t.nes\n\t\t.bin\n\t\t.bin_aux\t\t(generates auxiliary data)\n\t\t.prg\n\t\t.asm\n\t\t.asm_aux\t\t(generates auxiliary data)\n\t\t.txt\n";
+			helpmessage += "\t\t.nsf\n\t\t.nsfe\n\t\t.nsf2\t\t\t(generates NSF2 formatted file)\n\t\t.nes\n\t\t.bin\n\t\t.bin_aux\t\t(generates auxiliary data)\n\t\t.prg\n\t\t.asm\n\t\t.asm_aux\t\t(generates auxiliary data)\n\t\t.txt\n\t\t.vgm\t\t\t(renders the first track)\n";
+			helpmessage += "render\t: renders many tracks to .wav or .vgm files in parallel, faster than real time.\n";
+			helpmessage += "\t-render [job file] [optional log file]\n";
+			helpmessage += "\teach line of the job file is: module track output.wav [loops | seconds followed by s]\n";
+			helpmessage += "\ttracks start at 1, paths with spaces must be quoted, lines starting with # are ignored.\n";
+			helpmessage += "benchmark\t: times loading, saving and NSF compiling of the module, with and without memory-mapped loading.\n";
+			helpmessage += "\t-benchmark [optional iteration count, default 10] [optional log file]\n";
 			helpmessage += "nodump\t: disables the crash dump generation, for cases where these are undesirable\n";
 			helpmessage += "log\t: enables the register logger, available in debug builds only\n";
 			helpmessage += "Press enter to continue . . .";
@@ -1008,6 +1050,24 @@ void CFTCommandLineInfo::ParseParam(const TCHAR* pszParam, BOOL bFlag, BOOL bLas
 		}
 	}
 	else {
+		// Store job file name, then log filename
+		if (m_bRender) {
+			if (m_strRenderJobFile.GetLength() == 0)
+				m_strRenderJobFile = CString(pszParam);
+			else if (m_strRenderLogFile.GetLength() == 0)
+				m_strRenderLogFile = CString(pszParam);
+			return;
+		}
+		// Store iteration count, then log filename
+		if (m_bBenchmark) {
+			if (m_strFileName == pszParam)		// the module
+				return;
+			if (m_strBenchmarkLogFile.GetLength() == 0 && _istdigit(pszParam[0]))
+				m_iBenchmarkIterations = _ttoi(pszParam);
+			else if (m_strBenchmarkLogFile.GetLength() == 0)
+				m_strBenchmarkLogFile = CString(pszParam);
+			return;
+		}
 		// Store NSF name, then log filename
 		if (m_bExport == true) {
 			if (m_strExportFile.GetLength() == 0)
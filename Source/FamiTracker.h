@@ -54,10 +54,17 @@ public:
 	bool m_bHelp;		// !! !!
 	bool m_bLog;
 	bool m_bExport;
+	bool m_bNoMergePatterns;		// // //
+	bool m_bRender;
+	bool m_bBenchmark;
 	bool m_bPlay;
 	CString m_strExportFile;
 	CString m_strExportLogFile;
 	CString m_strExportDPCMFile;
+	CString m_strRenderJobFile;
+	CString m_strRenderLogFile;
+	int m_iBenchmarkIterations;
+	CString m_strBenchmarkLogFile;
 };
 
 class CMainFrame;		// // //
@@ -46,6 +46,7 @@
 #include <string>		// // //
 #include <array>		// // //
 #include <unordered_map>		// // //
+#include <unordered_set>		// // //
 
 #include "FamiTracker.h"
 #include "ChannelState.h"		// // //
@@ -69,6 +70,8 @@
 #include "Bookmark.h"		// // //
 #include "BookmarkCollection.h"		// // //
 #include "BookmarkManager.h"		// // //
+#include "CompilerCache.h"		// // //
+#include "PlaybackInstrument.h"		// // //
 #include "APU/APU.h"
 #include "str_conv/str_conv.hpp"
 
@@ -275,6 +278,11 @@ END_MESSAGE_MAP()
 // CFamiTrackerDoc construction/destruction
 
 CFamiTrackerDoc::CFamiTrackerDoc() :
+	CFamiTrackerDoc(theApp.GetSoundGenerator())		// // //
+{
+}
+
+CFamiTrackerDoc::CFamiTrackerDoc(CSoundGen *pSoundGen) :		// // //
 	m_bFileLoaded(false),
 	m_bFileLoadFailed(false),
 	m_iRegisteredChannels(0),
@@ -282,6 +290,8 @@ CFamiTrackerDoc::CFamiTrackerDoc() :
 	m_bDisplayComment(false),
 	m_pInstrumentManager(new CInstrumentManager(this)),
 	m_pBookmarkManager(new CBookmarkManager(MAX_TRACKS)),
+	m_pCompilerCache(std::make_unique<CCompilerCache>()),		// // //
+	m_pSoundGen(pSoundGen),		// // //
 	m_bUseExternalOPLLChip(false),
 	m_bUseSurveyMixing(false),
 	m_iPlaybackRate(0),
@@ -298,10 +308,8 @@ CFamiTrackerDoc::CFamiTrackerDoc() :
 	memset(m_pGrooveTable, 0, sizeof(CGroove*) * MAX_GROOVE);		// // //
 
 	// Register this object to the sound generator
-	CSoundGen *pSoundGen = theApp.GetSoundGenerator();
-
-	if (pSoundGen)
-		pSoundGen->AssignDocument(this);
+	if (m_pSoundGen)
+		m_pSoundGen->AssignDocument(this);
 }
 
 CFamiTrackerDoc::~CFamiTrackerDoc()
@@ -332,6 +340,17 @@ CFamiTrackerDoc *CFamiTrackerDoc::GetDoc()
 	return static_cast<CFamiTrackerDoc*>(pFrame->GetActiveDocument());
 }
 
+std::unique_ptr<CFamiTrackerDoc> CFamiTrackerDoc::LoadOffline(LPCTSTR lpszPathName, CSoundGen *pSoundGen)		// // //
+{
+	ASSERT(pSoundGen != nullptr && pSoundGen->IsOffline());
+
+	// Same as OnOpenDocument(), without the frame window and the application's generator
+	std::unique_ptr<CFamiTrackerDoc> pDoc(new CFamiTrackerDoc(pSoundGen));
+	if (!pDoc->OpenDocument(lpszPathName))
+		return nullptr;
+	return pDoc;
+}
+
 // Synchronization
 BOOL CFamiTrackerDoc::LockDocument() const
 {
@@ -372,8 +391,8 @@ BOOL CFamiTrackerDoc::OnOpenDocument(LPCTSTR lpszPathName)
 	// This function is called by the GUI to load a file
 
 	//DeleteContents();
-	theApp.GetSoundGenerator()->ResetDumpInstrument();
-	theApp.GetSoundGenerator()->SetRecordChannel(-1);		// // //
+	m_pSoundGen->ResetDumpInstrument();
+	m_pSoundGen->SetRecordChannel(-1);		// // //
 
 	m_csDocumentLock.Lock();
 
@@ -448,10 +467,8 @@ void CFamiTrackerDoc::OnCloseDocument()
 	// Document object is about to be deleted
 
 	// Remove itself from sound generator
-	CSoundGen *pSoundGen = theApp.GetSoundGenerator();
-
-	if (pSoundGen)
-		pSoundGen->RemoveDocument();
+	if (m_pSoundGen)
+		m_pSoundGen->RemoveDocument();
 
 	CDocument::OnCloseDocument();
 }
@@ -461,8 +478,9 @@ void CFamiTrackerDoc::DeleteContents()
 	// Current document is being unloaded, clear and reset variables and memory
 	// Delete everything because the current object is being reused in SDI
 
-	// Make sure player is stopped
-	theApp.StopPlayerAndWait();
+	// Make sure player is stopped, offline generators only play within CSoundGen::RenderOffline
+	if (!m_pSoundGen || !m_pSoundGen->IsOffline())		// // //
+		theApp.StopPlayerAndWait();
 
 	m_csDocumentLock.Lock();
 
@@ -483,6 +501,8 @@ void CFamiTrackerDoc::DeleteContents()
 
 	m_pInstrumentManager->ClearAll();		// // //
 	m_pBookmarkManager->ClearAll();		// // //
+	m_PlaybackSequences.clear();		// // //
+	PublishPlayback();		// // //
 
 	// Clear number of tracks
 	m_iTrackCount = 1;
@@ -583,10 +603,11 @@ void CFamiTrackerDoc::CreateEmpty()
 
 	// Document is avaliable
 	m_bFileLoaded = true;
+	PublishPlayback();		// // //
 
 	m_csDocumentLock.Unlock();
 
-	theApp.GetSoundGenerator()->DocumentPropertiesChanged(this);
+	m_pSoundGen->DocumentPropertiesChanged(this);
 }
 
 //
@@ -1405,8 +1426,6 @@ bool CFamiTrackerDoc::WriteBlock_Patterns(CDocumentFile *pDocFile, const int Ver
 
 	pDocFile->CreateBlock(FILE_BLOCK_PATTERNS, Version);
 
-	stChanNote *Note;		// // //
-
 	for (unsigned t = 0; t < m_iTrackCount; ++t) {
 		for (unsigned i = 0; i < m_iChannelsAvailable; ++i) {
 			for (unsigned x = 0; x < MAX_PATTERN; ++x) {
@@ -1430,7 +1449,7 @@ bool CFamiTrackerDoc::WriteBlock_Patterns(CDocumentFile *pDocFile, const int Ver
 
 					for (unsigned y = 0; y < PatternLen; y++) {
 						if (!m_pTracks[t]->IsCellFree(i, x, y)) {
-							Note = m_pTracks[t]->GetPatternData(i, x, y);		// // //
+							const stChanNote *Note = &m_pTracks[t]->GetNote(i, x, y);		// // //
 							// AssertFileData(Note, "Cannot create note");
 							pDocFile->WriteBlockInt(y);
 
@@ -1579,7 +1598,9 @@ BOOL CFamiTrackerDoc::OpenDocument(LPCTSTR lpszPathName)
 	m_bFileLoadFailed = false;
 	m_bBackupDone = false;		// // //
 
-	theApp.GetSoundGenerator()->DocumentPropertiesChanged(this);
+	PublishPlayback();		// // //
+
+	m_pSoundGen->DocumentPropertiesChanged(this);
 
 	return TRUE;
 }
@@ -1721,8 +1742,8 @@ BOOL CFamiTrackerDoc::OpenDocumentOld(CFile *pOpenFile)
 								if (ImportedNote.ExtraStuff2 < 0xFF)
 									ImportedNote.ExtraStuff2++;
 							}
-							stChanNote *Note;
-							Note = pTrack->GetPatternData(x, c, i);
+							stChanNote Data;		// // //
+							stChanNote *Note = &Data;
 							Note->EffNumber[0]	= static_cast<effect_t>(ImportedNote.ExtraStuff1);
 							Note->EffParam[0]	= ImportedNote.ExtraStuff2;
 							Note->Instrument	= ImportedNote.Instrument;
@@ -1736,6 +1757,7 @@ BOOL CFamiTrackerDoc::OpenDocumentOld(CFile *pOpenFile)
 							if (Note->EffNumber[0] < EF_COUNT)		// // //
 								// read FamiTracker 0.5.0 beta+ effect type order as 0CC effect type order
 								Note->EffNumber[0] = EFF_CONVERSION_050.first[Note->EffNumber[0]];
+							pTrack->SetNote(x, c, i, Data);
 						}
 					}
 				}
@@ -1889,6 +1911,9 @@ BOOL CFamiTrackerDoc::OpenDocumentNew(CDocumentFile &DocumentFile)
 	}
 #endif
 
+	// // // Identical patterns, e.g. of tracks that were duplicated, share one copy
+	CPatternData::SharePatterns(m_pTracks, m_iTrackCount);
+
 	return TRUE;
 }
 
@@ -2519,8 +2544,8 @@ void CFamiTrackerDoc::ReadBlock_Patterns(CDocumentFile *pDocFile, const int Vers
 				Row = AssertRange(pDocFile->GetBlockInt(), 0, 0xFF, "Row index");		// // //
 
 			try {
-				stChanNote *Note = pTrack->GetPatternData(Channel, Pattern, Row);
-				*Note = stChanNote { };		// // //
+				stChanNote Data { };		// // //
+				stChanNote *Note = &Data;
 
 				Note->Note = AssertRange<MODULE_ERROR_STRICT>(		// // //
 					pDocFile->GetBlockChar(), NONE, ECHO, "Note value");
@@ -2653,6 +2678,8 @@ void CFamiTrackerDoc::ReadBlock_Patterns(CDocumentFile *pDocFile, const int Vers
 					}
 				}
 				*/
+
+				pTrack->SetNote(Channel, Pattern, Row, Data);		// // //
 			}
 			catch (CModuleException *e) {
 				e->AppendError("At row %02X,", Row);
@@ -3133,7 +3160,7 @@ bool CFamiTrackerDoc::ImportDetune(CFamiTrackerDoc *pImported)		// // //
 	for (int i = 0; i < 6; i++) for (int j = 0; j < NOTE_COUNT; j++)
 		m_iDetuneTable[i][j] = pImported->GetDetuneOffset(i, j);
 
-	theApp.GetSoundGenerator()->LoadMachineSettings();		// // //
+	m_pSoundGen->LoadMachineSettings();		// // //
 	return true;
 }
 
@@ -3174,6 +3201,8 @@ bool CFamiTrackerDoc::ImportTrack(int Track, CFamiTrackerDoc *pImported, int *pI
 	// Copy patterns
 	for (unsigned int p = 0; p < MAX_PATTERN; ++p) {
 		for (unsigned int c = 0; c < GetAvailableChannels(); ++c) {
+			if (pImported->IsPatternEmpty(Track, c, p))		// // //
+				continue;
 			for (unsigned int r = 0; r < pImported->GetPatternLength(Track); ++r) {
 				// Get note
 				pImported->GetDataAtPattern(Track, p, c, r, &data);
@@ -3794,7 +3823,7 @@ void CFamiTrackerDoc::SetNoteData(unsigned int Track, unsigned int Frame, unsign
 	// Get notes from the pattern
 	CPatternData *pTrack = GetTrack(Track);
 	int Pattern = pTrack->GetFramePattern(Frame, Channel);
-	memcpy(pTrack->GetPatternData(Channel, Pattern, Row), pData, sizeof(stChanNote));
+	pTrack->SetNote(Channel, Pattern, Row, *pData);		// // //
 	SetModifiedFlag();
 }
 
@@ -3806,9 +3835,9 @@ void CFamiTrackerDoc::GetNoteData(unsigned int Track, unsigned int Frame, unsign
 	ASSERT(Row < MAX_PATTERN_LENGTH);
 	ASSERT(pData != NULL);
 	// Sets the notes of the pattern
-	CPatternData *pTrack = GetTrack(Track);
+	const CPatternData *pTrack = GetTrack(Track);
 	int Pattern = pTrack->GetFramePattern(Frame, Channel);
-	memcpy(pData, pTrack->GetPatternData(Channel, Pattern, Row), sizeof(stChanNote));
+	*pData = pTrack->GetNote(Channel, Pattern, Row);		// // //
 }
 
 void CFamiTrackerDoc::SetDataAtPattern(unsigned int Track, unsigned int Pattern, unsigned int Channel, unsigned int Row, const stChanNote *pData)
@@ -3820,7 +3849,7 @@ void CFamiTrackerDoc::SetDataAtPattern(unsigned int Track, unsigned int Pattern,
 	ASSERT(pData != NULL);
 	// Set a note to a direct pattern
 	CPatternData *pTrack = GetTrack(Track);
-	memcpy(pTrack->GetPatternData(Channel, Pattern, Row), pData, sizeof(stChanNote));
+	pTrack->SetNote(Channel, Pattern, Row, *pData);		// // //
 	SetModifiedFlag();
 }
 
@@ -3833,8 +3862,17 @@ void CFamiTrackerDoc::GetDataAtPattern(unsigned int Track, unsigned int Pattern,
 	ASSERT(pData != NULL);
 
 	// Get note from a direct pattern
-	CPatternData *pTrack = GetTrack(Track);
-	memcpy(pData, pTrack->GetPatternData(Channel, Pattern, Row), sizeof(stChanNote));
+	const CPatternData *pTrack = GetTrack(Track);
+	*pData = pTrack->GetNote(Channel, Pattern, Row);		// // //
+}
+
+bool CFamiTrackerDoc::IsInstrumentInPattern(unsigned int Track, unsigned int Pattern, unsigned int Channel, unsigned int Instrument) const		// // //
+{
+	ASSERT(Track < MAX_TRACKS);
+	ASSERT(Pattern < MAX_PATTERN);
+	ASSERT(Channel < MAX_CHANNELS);
+
+	return GetTrack(Track)->IsInstrumentInPattern(Channel, Pattern, Instrument);
 }
 
 bool CFamiTrackerDoc::InsertRow(unsigned int Track, unsigned int Frame, unsigned int Channel, unsigned int Row)
@@ -3850,13 +3888,11 @@ bool CFamiTrackerDoc::InsertRow(unsigned int Track, unsigned int Frame, unsigned
 	stChanNote Note { };		// // //
 
 	for (unsigned int i = PatternLen - 1; i > Row; i--) {
-		memcpy(
-			pTrack->GetPatternData(Channel, Pattern, i), 
-			pTrack->GetPatternData(Channel, Pattern, i - 1), 
-			sizeof(stChanNote));
+		const stChanNote Prev = pTrack->GetNote(Channel, Pattern, i - 1);		// // //
+		pTrack->SetNote(Channel, Pattern, i, Prev);
 	}
 
-	*pTrack->GetPatternData(Channel, Pattern, Row) = Note;
+	pTrack->SetNote(Channel, Pattern, Row, Note);
 
 	SetModifiedFlag();
 
@@ -3896,7 +3932,7 @@ bool CFamiTrackerDoc::ClearRow(unsigned int Track, unsigned int Frame, unsigned
 
 	CPatternData *pTrack = GetTrack(Track);
 	int Pattern = pTrack->GetFramePattern(Frame, Channel);
-	*pTrack->GetPatternData(Channel, Pattern, Row) = stChanNote { };		// // //
+	pTrack->SetNote(Channel, Pattern, Row, stChanNote { });		// // //
 	
 	SetModifiedFlag();
 
@@ -3912,7 +3948,8 @@ bool CFamiTrackerDoc::ClearRowField(unsigned int Track, unsigned int Frame, unsi
 
 	CPatternData *pTrack = GetTrack(Track);
 	int Pattern = pTrack->GetFramePattern(Frame, Channel);
-	stChanNote *pNote = pTrack->GetPatternData(Channel, Pattern, Row);
+	stChanNote Note = pTrack->GetNote(Channel, Pattern, Row);		// // //
+	stChanNote *pNote = &Note;
 
 	switch (Column) {
 		case C_NOTE:			// Note
@@ -3953,6 +3990,7 @@ bool CFamiTrackerDoc::ClearRowField(unsigned int Track, unsigned int Frame, unsi
 			pNote->EffParam[3] = 0;
 			break;
 	}
+	pTrack->SetNote(Channel, Pattern, Row, Note);
 	
 	SetModifiedFlag();
 
@@ -3973,13 +4011,11 @@ bool CFamiTrackerDoc::RemoveNote(unsigned int Track, unsigned int Frame, unsigne
 	unsigned int PatternLen = pTrack->GetPatternLength();
 
 	for (unsigned int i = Row - 1; i < (PatternLen - 1); i++) {
-		memcpy(
-			pTrack->GetPatternData(Channel, Pattern, i), 
-			pTrack->GetPatternData(Channel, Pattern, i + 1),
-			sizeof(stChanNote));
+		const stChanNote Next = pTrack->GetNote(Channel, Pattern, i + 1);		// // //
+		pTrack->SetNote(Channel, Pattern, i, Next);
 	}
 
-	*pTrack->GetPatternData(Channel, Pattern, PatternLen - 1) = Note;
+	pTrack->SetNote(Channel, Pattern, PatternLen - 1, Note);
 
 	SetModifiedFlag();
 
@@ -4012,13 +4048,8 @@ void CFamiTrackerDoc::CopyPattern(unsigned int Track, int Target, int Source, in
 	// Copy one pattern to another
 	ASSERT(Track < MAX_TRACKS);
 
-	int PatternLen = GetPatternLength(Track);
-	stChanNote Data;
-
-	for (int i = 0; i < PatternLen; ++i) {
-		GetDataAtPattern(Track, Source, Channel, i, &Data);
-		SetDataAtPattern(Track, Target, Channel, i, &Data);
-	}
+	CPatternData *pTrack = GetTrack(Track);
+	pTrack->CopyPattern(Channel, Target, *pTrack, Channel, Source);		// // // copy-on-write
 
 	SetModifiedFlag();
 }
@@ -4121,13 +4152,8 @@ bool CFamiTrackerDoc::CloneFrame(unsigned int Track, unsigned int Frame)		// //
 		return false;
 
 	// copy old patterns into new
-	for (int i = 0; i < Channels; ++i) {
-		for(unsigned int j = 0; j < MAX_PATTERN_LENGTH; j++) {
-			stChanNote note;
-			GetNoteData(Track, Frame - 1, i, j, &note);
-			SetNoteData(Track, Frame, i, j, &note);
-		}
-	}
+	for (int i = 0; i < Channels; ++i)
+		CopyPattern(Track, GetPatternAtFrame(Track, Frame, i), GetPatternAtFrame(Track, Frame - 1, i), i);		// // //
 
 	SetModifiedFlag();
 
@@ -4356,7 +4382,7 @@ void CFamiTrackerDoc::SelectExpansionChip(unsigned int Chip, bool Move)
 					for (int f = 0; f < MAX_FRAMES; f++)
 						pNew->SetFramePattern(f, newIndex[j], pTrack->GetFramePattern(f, oldIndex[j]));
 					for (int p = 0; p < MAX_PATTERN; p++)
-						memcpy(pNew->GetPatternData(newIndex[j], p, 0), pTrack->GetPatternData(oldIndex[j], p, 0), MAX_PATTERN_LENGTH * sizeof(stChanNote));
+						pNew->CopyPattern(newIndex[j], p, *pTrack, oldIndex[j], p);		// // //
 				}
 			}
 			SAFE_RELEASE(pTrack);
@@ -4386,7 +4412,7 @@ void CFamiTrackerDoc::SetupChannels(unsigned int Chip)
 	m_iExpansionChip = Chip;
 
 	// Register the channels
-	theApp.GetSoundGenerator()->RegisterChannels(Chip, this); 
+	m_pSoundGen->RegisterChannels(Chip, this); 
 
 	m_iChannelsAvailable = GetChannelCount();
 
@@ -4400,10 +4426,10 @@ void CFamiTrackerDoc::SetupChannels(unsigned int Chip)
 void CFamiTrackerDoc::ApplyExpansionChip()
 {
 	// Tell the sound emulator to switch expansion chip
-	theApp.GetSoundGenerator()->SelectChip(m_iExpansionChip);
+	m_pSoundGen->SelectChip(m_iExpansionChip);
 
 	// Change period tables
-	theApp.GetSoundGenerator()->LoadMachineSettings();		// // //
+	m_pSoundGen->LoadMachineSettings();		// // //
 
 	SetModifiedFlag();
 	SetExceededFlag();			// // //
@@ -4486,7 +4512,7 @@ void CFamiTrackerDoc::SetNamcoChannels(int Channels, bool Move)
 					for (int f = 0; f < MAX_FRAMES; f++)
 						pNew->SetFramePattern(f, newIndex[j], pTrack->GetFramePattern(f, oldIndex[j]));
 					for (int p = 0; p < MAX_PATTERN; p++)
-						memcpy(pNew->GetPatternData(newIndex[j], p, 0), pTrack->GetPatternData(oldIndex[j], p, 0), MAX_PATTERN_LENGTH * sizeof(stChanNote));
+						pNew->CopyPattern(newIndex[j], p, *pTrack, oldIndex[j], p);		// // //
 				}
 			}
 			SAFE_RELEASE(pTrack);
@@ -4552,9 +4578,10 @@ void CFamiTrackerDoc::ConvertSequence(stSequence *pOldSequence, CSequence *pNewS
 unsigned int CFamiTrackerDoc::GetFirstFreePattern(unsigned int Track, unsigned int Channel) const
 {
 	CPatternData *pTrack = GetTrack(Track);
+	const auto InUse = pTrack->GetPatternsInUse(Channel);		// // //
 
 	for (int i = 0; i < MAX_PATTERN; ++i) {
-		if (!pTrack->IsPatternInUse(Channel, i) && pTrack->IsPatternEmpty(Channel, i))
+		if (!InUse[i] && pTrack->IsPatternEmpty(Channel, i))
 			return i;
 	}
 
@@ -4566,6 +4593,198 @@ bool CFamiTrackerDoc::IsPatternEmpty(unsigned int Track, unsigned int Channel, u
 	return GetTrack(Track)->IsPatternEmpty(Channel, Pattern);
 }
 
+std::size_t CFamiTrackerDoc::GetPatternMemory(unsigned int &Patterns) const		// // //
+{
+	// Bytes used by pattern rows of all tracks, patterns shared between tracks count once
+	std::unordered_set<const void *> Counted;
+	std::size_t Size = 0;
+	Patterns = 0;
+	for (unsigned int i = 0; i < m_iTrackCount; ++i) {
+		Size += m_pTracks[i]->CountPatternMemory(Counted);
+		Patterns += m_pTracks[i]->GetAllocatedPatternCount();
+	}
+	return Size;
+}
+
+bool stPlaybackMark::operator==(const stPlaybackMark &other) const		// // //
+{
+	return Track == other.Track && Frame == other.Frame && Row == other.Row && Highlight == other.Highlight && Persist == other.Persist;
+}
+
+bool stPlaybackSettings::ExpansionEnabled(int Chip) const		// // //
+{
+	return (ExpansionChip & Chip) == Chip;
+}
+
+int stPlaybackSettings::GetChannelIndex(int ID) const		// // //
+{
+	for (int i = 0; i < ChannelCount; ++i)
+		if (ChannelID[i] == ID)
+			return i;
+	return -1;
+}
+
+const stPlaybackMark *stPlaybackSettings::GetMarkAt(unsigned int Track, unsigned int Frame, unsigned int Row) const		// // //
+{
+	for (const auto &Mark : Marks)
+		if (Mark.Track == Track && Mark.Frame == Frame && Mark.Row == Row && Mark.Highlight != -1)
+			return &Mark;
+	return nullptr;
+}
+
+int stPlaybackSettings::GetHighlightAt(unsigned int Track, unsigned int Frame, unsigned int Row) const		// // //
+{
+	// The closest mark at or before the row, as in CFamiTrackerDoc::GetHighlightAt
+	const CBookmark Pos(Frame, Row);
+	unsigned int Min = Pos.Distance(CBookmark { });
+	int First = Highlight.First;
+	for (const auto &Mark : Marks) {
+		if (Mark.Track != Track)
+			continue;
+		const unsigned Dist = Pos.Distance(CBookmark(Mark.Frame, Mark.Row));
+		if (Dist <= Min) {
+			Min = Dist;
+			if (Mark.Highlight != -1 && (Mark.Persist || Mark.Frame == Frame))
+				First = Mark.Highlight;
+		}
+	}
+	return First;
+}
+
+bool stPlaybackSettings::operator==(const stPlaybackSettings &other) const		// // //
+{
+	return FrameRate == other.FrameRate && ExpansionChip == other.ExpansionChip && ChannelCount == other.ChannelCount &&
+		std::equal(ChannelID, ChannelID + ChannelCount, other.ChannelID) && Highlight == other.Highlight && Marks == other.Marks;
+}
+
+std::shared_ptr<const CPatternData> CFamiTrackerDoc::GetPlaybackTrack(unsigned int Track) const		// // //
+{
+	ASSERT(Track < MAX_TRACKS);
+	return std::atomic_load(&m_pPlaybackTracks[Track]);
+}
+
+std::shared_ptr<CInstrument> CFamiTrackerDoc::GetPlaybackInstrument(unsigned int Index) const		// // //
+{
+	ASSERT(Index < MAX_INSTRUMENTS);
+	const auto pCopy = std::atomic_load(&m_pPlaybackInstruments[Index]);
+	return pCopy ? pCopy->GetInstrument() : nullptr;
+}
+
+std::shared_ptr<const CGroove> CFamiTrackerDoc::GetPlaybackGroove(unsigned int Index) const		// // //
+{
+	ASSERT(Index < MAX_GROOVE);
+	return std::atomic_load(&m_pPlaybackGrooves[Index]);
+}
+
+std::shared_ptr<const stPlaybackSettings> CFamiTrackerDoc::GetPlaybackSettings() const		// // //
+{
+	return std::atomic_load(&m_pPlaybackSettings);
+}
+
+unsigned long long CFamiTrackerDoc::GetPlaybackVersion() const		// // //
+{
+	return m_iPlaybackVersion;
+}
+
+void CFamiTrackerDoc::PublishPlayback()		// // //
+{
+	// The player keeps the copy it loaded until its next tick, and releases it then.
+	// Tracks are only written by this thread, so their versions can be read directly.
+	// The player compares track copies itself, see CPlayerKeyframes::ValidateTrack.
+	for (unsigned int i = 0; i < MAX_TRACKS; ++i) {
+		const CPatternData *pTrack = m_pTracks[i];
+		const auto pCopy = std::atomic_load(&m_pPlaybackTracks[i]);
+		if (!pTrack) {
+			if (pCopy)
+				std::atomic_store(&m_pPlaybackTracks[i], std::shared_ptr<const CPatternData>());
+		}
+		else if (!pCopy || pCopy->GetVersion() != pTrack->GetVersion())
+			std::atomic_store(&m_pPlaybackTracks[i], std::shared_ptr<const CPatternData>(std::make_shared<CPatternData>(*pTrack)));
+	}
+
+	bool Changed = false;
+
+	// Instruments are copied along with the sequences and samples they use; a sequence or
+	// sample is copied once and shared by every instrument copy that uses it
+	const auto GetSequence = [this] (int InstType, int SeqType, int Index) {
+		auto &pCopy = m_PlaybackSequences[std::make_tuple(InstType, SeqType, Index)];
+		const CSequence *pSeq = m_pInstrumentManager->GetSequence(InstType, SeqType, Index);
+		if (!pSeq)
+			pCopy.reset();
+		else if (!pCopy || pCopy->GetVersion() != pSeq->GetVersion())
+			pCopy = std::make_shared<CSequence>(*pSeq);
+		return pCopy;
+	};
+	const auto GetDSample = [this] (int Index) {
+		auto &pCopy = m_pPlaybackSamples[Index];
+		const CDSample *pSample = GetDSampleManager()->GetDSample(Index);
+		if (!pSample)
+			pCopy.reset();
+		else if (!pCopy || pCopy->GetVersion() != pSample->GetVersion())
+			pCopy = std::make_shared<CDSample>(*pSample);
+		return pCopy;
+	};
+	for (unsigned int i = 0; i < MAX_INSTRUMENTS; ++i) {
+		const auto pInst = m_pInstrumentManager->GetInstrument(i);
+		const auto pCopy = std::atomic_load(&m_pPlaybackInstruments[i]);
+		if (!pInst) {
+			if (pCopy) {
+				std::atomic_store(&m_pPlaybackInstruments[i], std::shared_ptr<const CPlaybackInstrument>());
+				Changed = true;
+			}
+			continue;
+		}
+		auto Versions = CPlaybackInstrument::GetVersions(*pInst);
+		if (!pCopy || !pCopy->IsCurrent(Versions)) {
+			std::atomic_store(&m_pPlaybackInstruments[i], std::shared_ptr<const CPlaybackInstrument>(
+				std::make_shared<CPlaybackInstrument>(*pInst, std::move(Versions), GetSequence, GetDSample)));
+			Changed = true;
+		}
+	}
+
+	for (int i = 0; i < MAX_GROOVE; ++i) {
+		const CGroove *pGroove = m_pGrooveTable[i];
+		const auto pCopy = std::atomic_load(&m_pPlaybackGrooves[i]);
+		if (!pGroove) {
+			if (pCopy) {
+				std::atomic_store(&m_pPlaybackGrooves[i], std::shared_ptr<const CGroove>());
+				Changed = true;
+			}
+		}
+		else if (!pCopy || pCopy->GetVersion() != pGroove->GetVersion()) {
+			std::atomic_store(&m_pPlaybackGrooves[i], std::shared_ptr<const CGroove>(std::make_shared<CGroove>(*pGroove)));
+			Changed = true;
+		}
+	}
+
+	// Settings are small, so they are rebuilt and compared instead of versioned
+	std::shared_ptr<stPlaybackSettings> pSettings;
+	if (m_bFileLoaded) {
+		pSettings = std::make_shared<stPlaybackSettings>();
+		pSettings->FrameRate = GetFrameRate();
+		pSettings->ExpansionChip = m_iExpansionChip;
+		pSettings->ChannelCount = GetChannelCount();
+		for (int i = 0; i < CHANNELS; ++i)
+			pSettings->ChannelID[i] = i < pSettings->ChannelCount ? m_pChannels[i]->GetID() : -1;
+		pSettings->Highlight = m_vHighlight;
+		for (unsigned int i = 0; i < m_iTrackCount; ++i) {
+			const CBookmarkCollection *pCol = m_pBookmarkManager->GetCollection(i);
+			for (unsigned j = 0, Count = pCol ? pCol->GetCount() : 0; j < Count; ++j) {
+				const CBookmark *pMark = pCol->GetBookmark(j);
+				pSettings->Marks.push_back({i, pMark->m_iFrame, pMark->m_iRow, pMark->m_Highlight.First, pMark->m_bPersist});
+			}
+		}
+	}
+	const auto pCopy = std::atomic_load(&m_pPlaybackSettings);
+	if (pSettings ? !pCopy || !(*pCopy == *pSettings) : pCopy != nullptr) {
+		std::atomic_store(&m_pPlaybackSettings, std::shared_ptr<const stPlaybackSettings>(pSettings));
+		Changed = true;
+	}
+
+	if (Changed)
+		++m_iPlaybackVersion;
+}
+
 // Channel interface, these functions must be synchronized!!!
 
 int CFamiTrackerDoc::GetChannelType(int Channel) const
@@ -5103,12 +5322,19 @@ unsigned int CFamiTrackerDoc::ScanActualLength(unsigned int Track, unsigned int
 
 	memset(RowVisited, 0, MAX_FRAMES * MAX_PATTERN_LENGTH);		// // //
 
+	// // // Rows of frames without any of these effects are counted without reading them
+	static const effect_t FLOW_EFFECTS[] = {EF_JUMP, EF_SKIP, EF_HALT};
+	unsigned int CheckedFrame = MAX_FRAMES;
+	bool HasEffects = true;
+
 	while (bScanning) {
+		if (f != CheckedFrame) {
+			CheckedFrame = f;
+			HasEffects = HasEffectsAtFrame(Track, f, FLOW_EFFECTS);
+		}
 		bool hasJump = false;
-		for (int j = 0; j < GetChannelCount(); ++j) {
-			stChanNote *Note;
-			Note = m_pTracks[Track]->GetPatternData(j, m_pTracks[Track]->GetFramePattern(f, j), r);
-			GetNoteData(Track, f, j, r, Note);
+		for (int j = 0; j < GetChannelCount() && HasEffects; ++j) {
+			const stChanNote *Note = &m_pTracks[Track]->GetNote(j, m_pTracks[Track]->GetFramePattern(f, j), r);		// // //
 			for (unsigned l = 0; l < GetEffColumns(Track, j) + 1; ++l) {
 				switch (Note->EffNumber[l]) {
 					case EF_JUMP:
@@ -5156,6 +5382,19 @@ unsigned int CFamiTrackerDoc::ScanActualLength(unsigned int Track, unsigned int
 	return FirstLoop + SecondLoop * (Count - 1);		// // //
 }
 
+template <std::size_t N>
+bool CFamiTrackerDoc::HasEffectsAtFrame(unsigned int Track, unsigned int Frame, const effect_t (&Effects)[N]) const		// // //
+{
+	const CPatternData *pTrack = m_pTracks[Track];
+	for (int j = 0; j < GetChannelCount(); ++j) {
+		const unsigned int Pattern = pTrack->GetFramePattern(Frame, j);
+		for (effect_t Effect : Effects)
+			if (pTrack->IsEffectInPattern(j, Pattern, Effect))
+				return true;
+	}
+	return false;
+}
+
 double CFamiTrackerDoc::GetStandardLength(int Track, unsigned int ExtraLoops) const		// // //
 {
 	char RowVisited[MAX_FRAMES][MAX_PATTERN_LENGTH];
@@ -5179,13 +5418,21 @@ double CFamiTrackerDoc::GetStandardLength(int Track, unsigned int ExtraLoops) co
 
 	memset(RowVisited, 0, MAX_FRAMES * MAX_PATTERN_LENGTH);
 
+	// // // Rows of frames without any of these effects are counted without reading them
+	static const effect_t FLOW_EFFECTS[] = {EF_JUMP, EF_SKIP, EF_HALT, EF_SPEED, EF_GROOVE};
+	unsigned int CheckedFrame = MAX_FRAMES;
+	bool HasEffects = true;
+
 	unsigned int f = 0;
 	unsigned int r = 0;
 	while (bScanning) {
+		if (f != CheckedFrame) {
+			CheckedFrame = f;
+			HasEffects = HasEffectsAtFrame(Track, f, FLOW_EFFECTS);
+		}
 		bool hasJump = false;
-		for (int j = 0; j < GetChannelCount(); ++j) {
-			stChanNote* Note;
-			Note = m_pTracks[Track]->GetPatternData(j, m_pTracks[Track]->GetFramePattern(f, j), r);
+		for (int j = 0; j < GetChannelCount() && HasEffects; ++j) {
+			const stChanNote *Note = &m_pTracks[Track]->GetNote(j, m_pTracks[Track]->GetFramePattern(f, j), r);		// // //
 			for (unsigned l = 0; l < GetEffColumns(Track, j) + 1; ++l) {
 				switch (Note->EffNumber[l]) {
 				case EF_JUMP:
@@ -5258,13 +5505,9 @@ void CFamiTrackerDoc::RemoveUnusedInstruments()
 			bool Used = false;
 			for (unsigned int j = 0; j < m_iTrackCount; ++j) {
 				for (unsigned int Channel = 0; Channel < m_iChannelsAvailable; ++Channel) {
-					for (unsigned int Frame = 0; Frame < m_pTracks[j]->GetFrameCount(); ++Frame) {
+					for (unsigned int Frame = 0; Frame < m_pTracks[j]->GetFrameCount() && !Used; ++Frame) {
 						unsigned int Pattern = m_pTracks[j]->GetFramePattern(Frame, Channel);
-						for (unsigned int Row = 0; Row < m_pTracks[j]->GetPatternLength(); ++Row) {
-							stChanNote *pNote = m_pTracks[j]->GetPatternData(Channel, Pattern, Row);
-							if (pNote->Instrument == i)
-								Used = true;
-						}
+						Used = m_pTracks[j]->IsInstrumentInPattern(Channel, Pattern, i);		// // //
 					}
 				}
 			}
@@ -5298,14 +5541,10 @@ void CFamiTrackerDoc::RemoveUnusedPatterns()
 {
 	for (unsigned int i = 0; i < m_iTrackCount; ++i) {
 		for (unsigned int c = 0; c < m_iChannelsAvailable; ++c) {
+			// Check if pattern is used in frame list
+			const auto InUse = m_pTracks[i]->GetPatternsInUse(c);		// // //
 			for (unsigned int p = 0; p < MAX_PATTERN; ++p) {
-				bool bRemove(true);
-				// Check if pattern is used in frame list
-				unsigned int FrameCount = m_pTracks[i]->GetFrameCount();
-				for (unsigned int f = 0; f < FrameCount; ++f) {
-					bRemove = (m_pTracks[i]->GetFramePattern(f, c) == p) ? false : bRemove;
-				}
-				if (bRemove)
+				if (!InUse[p])
 					m_pTracks[i]->ClearPattern(c, p);
 			}
 		}
@@ -5325,8 +5564,10 @@ void CFamiTrackerDoc::RemoveUnusedSamples()		// // //
 			for (unsigned int j = 0; j < m_iTrackCount; ++j) {
 				for (unsigned int Frame = 0; Frame < m_pTracks[j]->GetFrameCount(); ++Frame) {
 					unsigned int Pattern = m_pTracks[j]->GetFramePattern(Frame, CHANID_2A03_DPCM);
+					if (m_pTracks[j]->IsPatternEmpty(CHANID_2A03_DPCM, Pattern))		// // //
+						continue;
 					for (unsigned int Row = 0; Row < m_pTracks[j]->GetPatternLength(); ++Row) {
-						stChanNote *pNote = m_pTracks[j]->GetPatternData(CHANID_2A03_DPCM, Pattern, Row);
+						const stChanNote *pNote = &m_pTracks[j]->GetNote(CHANID_2A03_DPCM, Pattern, Row);		// // //
 						int Index = pNote->Instrument;
 						if (pNote->Note < NOTE_C || pNote->Note > NOTE_B || Index == MAX_INSTRUMENTS) continue;		// // //
 						if (GetInstrumentType(Index) != INST_2A03) continue;
@@ -5352,12 +5593,26 @@ void CFamiTrackerDoc::RemoveUnusedSamples()		// // //
 	SetExceededFlag();
 }
 
+unsigned long long CFamiTrackerDoc::GetPatternVersion(unsigned int Track, unsigned int Channel, unsigned int Pattern) const		// // //
+{
+	ASSERT(Track < MAX_TRACKS);
+	ASSERT(Channel < MAX_CHANNELS);
+	ASSERT(Pattern < MAX_PATTERN);
+
+	return m_pTracks[Track] != NULL ? m_pTracks[Track]->GetPatternVersion(Channel, Pattern) : 0;
+}
+
+CCompilerCache &CFamiTrackerDoc::GetCompilerCache() const		// // //
+{
+	return *m_pCompilerCache;
+}
+
 bool CFamiTrackerDoc::ArePatternsSame(unsigned int Track, unsigned int Channel, unsigned int Pattern1, unsigned int Pattern2) const		// // //
 {
+	if (m_pTracks[Track]->IsPatternEmpty(Channel, Pattern1) != m_pTracks[Track]->IsPatternEmpty(Channel, Pattern2))
+		return false;
 	for (unsigned int r = 0, Count = m_pTracks[Track]->GetPatternLength(); r < Count; ++r)
-		if (::memcmp(m_pTracks[Track]->GetPatternData(Channel, Pattern1, r),
-					 m_pTracks[Track]->GetPatternData(Channel, Pattern2, r),
-					 sizeof(stChanNote)))
+		if (m_pTracks[Track]->GetNote(Channel, Pattern1, r) != m_pTracks[Track]->GetNote(Channel, Pattern2, r))		// // //
 			return false;
 	return true;
 }
@@ -5379,9 +5634,7 @@ void CFamiTrackerDoc::PopulateUniquePatterns(unsigned int Track)		// // //
 		pNew->SetEffectColumnCount(c, GetEffColumns(Track, c));
 		for (int f = 0; f < Frames; f++) {
 			pNew->SetFramePattern(f, c, f);
-			for (int r = 0; r < Rows; r++)
-				memcpy(pNew->GetPatternData(c, f, r),
-				pTrack->GetPatternData(c, pTrack->GetFramePattern(f, c), r), sizeof(stChanNote));
+			pNew->CopyPattern(c, f, *pTrack, c, pTrack->GetFramePattern(f, c));		// // //
 		}
 	}
 
@@ -5408,11 +5661,12 @@ void CFamiTrackerDoc::SwapInstruments(int First, int Second)
 		for (int j = 0; j < MAX_PATTERN; ++j) {
 			for (unsigned int k = 0; k < Count; ++k) {
 				for (int l = 0; l < MAX_PATTERN_LENGTH; ++l) {
-					stChanNote *pData = pTrack->GetPatternData(k, j, l);
-					if (pData->Instrument == First)
-						pData->Instrument = Second;
-					else if (pData->Instrument == Second)
-						pData->Instrument = First;
+					stChanNote Note = pTrack->GetNote(k, j, l);		// // //
+					if (Note.Instrument == First)
+						Note.Instrument = Second;
+					else if (Note.Instrument == Second)
+						Note.Instrument = First;
+					pTrack->SetNote(k, j, l, Note);
 				}
 			}
 		}
@@ -5440,27 +5694,34 @@ static void UpdateEchoTranspose(stChanNote *Note, int *Value, unsigned int EffCo
 
 stFullState *CFamiTrackerDoc::RetrieveSoundState(unsigned int Track, unsigned int Frame, unsigned int Row, int Channel)
 {
-	stFullState *S = new stFullState(m_iRegisteredChannels);
+	return RetrieveSoundState(*GetTrack(Track), m_pChannels, m_iRegisteredChannels, GetSpeedSplitPoint(),		// // //
+		[this] (unsigned int Index) { return m_pGrooveTable[Index] != nullptr; }, Frame, Row);
+}
+
+stFullState *CFamiTrackerDoc::RetrieveSoundState(const CPatternData &Track, const CTrackerChannel *const *pChannels, int ChannelCount,
+	unsigned int SpeedSplitPoint, const std::function<bool (unsigned int)> &HasGroove, unsigned int Frame, unsigned int Row)		// // //
+{
+	stFullState *S = new stFullState(ChannelCount);
 
-	for (int c = 0; c < m_iRegisteredChannels; c++) {
-		S->State[c].ChannelIndex = GetChannelType(c);
+	for (int c = 0; c < ChannelCount; c++) {
+		S->State[c].ChannelIndex = pChannels[c]->GetID();
 		// S->State[c].Mute = CFamiTrackerView::GetView()->IsChannelMuted(i);
 	}
 	
 	stChanNote Note;
 	int totalRows = 0;
-	int *BufferPos = new int[m_iRegisteredChannels];
-	int (*Transpose)[ECHO_BUFFER_LENGTH + 1] = new int[m_iRegisteredChannels][ECHO_BUFFER_LENGTH + 1]();
-	memset(BufferPos, -1, m_iRegisteredChannels * sizeof(int));
+	int *BufferPos = new int[ChannelCount];
+	int (*Transpose)[ECHO_BUFFER_LENGTH + 1] = new int[ChannelCount][ECHO_BUFFER_LENGTH + 1]();
+	memset(BufferPos, -1, ChannelCount * sizeof(int));
 	bool maskFDS = false; // no need to create per-channel array since only one FDS channel exists
 						  // may not be the case in future additions
 
 	while (true) {
-		for (int c = m_iRegisteredChannels - 1; c >= 0; c--) {
+		for (int c = ChannelCount - 1; c >= 0; c--) {
 			// if (Channel != -1) c = GetChannelIndex(Channel);
 			stChannelState *State = &S->State[c];
-			int EffColumns = GetEffColumns(Track, c);
-			GetNoteData(Track, Frame, c, Row, &Note);
+			int EffColumns = Track.GetEffectColumnCount(c);
+			Note = Track.GetNote(c, Track.GetFramePattern(Frame, c), Row);
 		
 			if (Note.Note != NONE && Note.Note != RELEASE) {
 				for (int i = 0; i < std::min(BufferPos[c], ECHO_BUFFER_LENGTH + 1); i++) {
@@ -5505,7 +5766,7 @@ stFullState *CFamiTrackerDoc::RetrieveSoundState(unsigned int Track, unsigned in
 				if (Note.Vol != MAX_VOLUME)
 					State->Volume = Note.Vol;
 		
-			CTrackerChannel *ch = GetChannel(c);
+			const CTrackerChannel *ch = pChannels[c];
 			ASSERT(ch != NULL);
 
 			// Why are effect columns processed from right to left?
@@ -5522,14 +5783,14 @@ stFullState *CFamiTrackerDoc::RetrieveSoundState(unsigned int Track, unsigned in
 				case EF_HALT:
 					Row = Frame = 0; goto outer;
 				case EF_SPEED:
-					if (S->Speed == -1 && (xy < GetSpeedSplitPoint() || GetSongTempo(Track) == 0)) {
+					if (S->Speed == -1 && (xy < SpeedSplitPoint || Track.GetSongTempo() == 0)) {
 						S->Speed = xy; if (S->Speed < 1) S->Speed = 1;
 						S->GroovePos = -2;
 					}
-					else if (S->Tempo == -1 && xy >= GetSpeedSplitPoint()) S->Tempo = xy;
+					else if (S->Tempo == -1 && xy >= SpeedSplitPoint) S->Tempo = xy;
 					continue;
 				case EF_GROOVE:
-					if (S->GroovePos == -1 && xy < MAX_GROOVE && m_pGrooveTable[xy] != nullptr) {
+					if (S->GroovePos == -1 && xy < MAX_GROOVE && HasGroove(xy)) {
 						S->GroovePos = totalRows;
 						S->Speed = xy;
 					}
@@ -5610,13 +5871,13 @@ stFullState *CFamiTrackerDoc::RetrieveSoundState(unsigned int Track, unsigned in
 		}
 	outer:
 		if (Row) Row--;
-		else if (Frame) Row = GetFrameLength(Track, --Frame) - 1;
+		else if (Frame) Row = GetFrameLength(Track, ChannelCount, --Frame) - 1;
 		else break;
 		totalRows++;
 	}
-	if (S->GroovePos == -1 && GetSongGroove(Track)) {
-		unsigned Index = GetSongSpeed(Track);
-		if (Index < MAX_GROOVE && m_pGrooveTable[Index] != nullptr) {
+	if (S->GroovePos == -1 && Track.GetSongGroove()) {
+		unsigned Index = Track.GetSongSpeed();
+		if (Index < MAX_GROOVE && HasGroove(Index)) {
 			S->GroovePos = totalRows;
 			S->Speed = Index;
 		}
@@ -5677,17 +5938,21 @@ void CFamiTrackerDoc::SetExceededFlag(bool Exceed)
 }
 
 int CFamiTrackerDoc::GetFrameLength(unsigned int Track, unsigned int Frame) const
+{
+	return GetFrameLength(*GetTrack(Track), GetChannelCount(), Frame);		// // //
+}
+
+int CFamiTrackerDoc::GetFrameLength(const CPatternData &Track, int ChannelCount, unsigned int Frame)		// // //
 {
 	// // // moved from PatternEditor.cpp
-	const int PatternLength = GetPatternLength(Track);	// default length
+	const int PatternLength = Track.GetPatternLength();	// default length
 	
 	int HaltPoint = PatternLength;
 
 	for (int j = 0; j < PatternLength; ++j) {
-		for (int i = 0; i < GetChannelCount(); ++i) {
-			int Columns = GetEffColumns(Track, i) + 1;
-			stChanNote Note;
-			GetNoteData(Track, Frame, i, j, &Note);
+		for (int i = 0; i < ChannelCount; ++i) {
+			int Columns = Track.GetEffectColumnCount(i) + 1;
+			const stChanNote &Note = Track.GetNote(i, Track.GetFramePattern(Frame, i), j);		// // //
 			// First look for pattern data, allow this to cancel earlier pattern lengths
 			/*
 			if (Note.Note != NONE || Note.Instrument != MAX_INSTRUMENTS || Note.Vol != 0x10)
@@ -27,6 +27,7 @@
 #include <vector>
 #include <string>		// !! !!
 #include <memory>		// // //
+#include <atomic>		// // //
 
 #include "GlobalChipCount.h"
 
@@ -109,12 +110,47 @@ struct stJSONOptionalData {
 #include "PatternEditorTypes.h"		// // //
 // #include "FrameEditorTypes.h"		// // //
 
+#include <map>		// // //
+#include <functional>		// // //
+#include <tuple>		// // //
+
 // External classes
 class CTrackerChannel;
 class CDocumentFile;
 class stFullState;		// // //
 class CSeqInstrument;		// // // TODO: move to instrument manager
 class CDSample;		// // //
+class CCompilerCache;		// // //
+class CPlaybackInstrument;		// // //
+class CSoundGen;		// // //
+
+// // // A bookmark as seen by the player, its highlight is -1 if it does not change the highlight
+struct stPlaybackMark {
+	unsigned int Track;
+	unsigned int Frame;
+	unsigned int Row;
+	int Highlight;
+	bool Persist;
+
+	bool operator==(const stPlaybackMark &other) const;
+};
+
+// // // Module settings read by the player on every tick, published along with the tracks
+struct stPlaybackSettings {
+	unsigned int FrameRate;
+	unsigned int ExpansionChip;
+	int ChannelCount;
+	int ChannelID[CHANNELS];
+	stHighlight Highlight;
+	std::vector<stPlaybackMark> Marks;
+
+	bool ExpansionEnabled(int Chip) const;
+	int GetChannelIndex(int ID) const;		// Returns -1 if not found
+	const stPlaybackMark *GetMarkAt(unsigned int Track, unsigned int Frame, unsigned int Row) const;		// Only marks that change the highlight
+	int GetHighlightAt(unsigned int Track, unsigned int Frame, unsigned int Row) const;		// Same as CFamiTrackerDoc::GetHighlightAt(...).First
+
+	bool operator==(const stPlaybackSettings &other) const;
+};
 
 //
 // I'll try to organize this class, things are quite messy right now!
@@ -124,11 +160,19 @@ class CFamiTrackerDoc : public CDocument, public CFTMComponentInterface
 {
 protected: // create from serialization only
 	CFamiTrackerDoc();
+	explicit CFamiTrackerDoc(CSoundGen *pSoundGen);		// // //
 	DECLARE_DYNCREATE(CFamiTrackerDoc)
 
 	// Static functions
 public:
 	static CFamiTrackerDoc* GetDoc();
+	/*!	\brief Loads a module for an offline sound generator instead of the application's one.
+		\details The document is assigned to the generator, and is loaded on the calling thread,
+		which must be the one that created the generator.
+		\param lpszPathName The module file.
+		\param pSoundGen The generator, created with Offline set.
+		\return The document, or nullptr if the module could not be loaded. */
+	static std::unique_ptr<CFamiTrackerDoc> LoadOffline(LPCTSTR lpszPathName, CSoundGen *pSoundGen);		// // //
 
 
 	// Other
@@ -200,6 +244,26 @@ public:
 
 	bool			IsPatternEmpty(unsigned int Track, unsigned int Channel, unsigned int Pattern) const;
 	bool			ArePatternsSame(unsigned int Track, unsigned int Channel, unsigned int Pattern1, unsigned int Pattern2) const;		// // //
+	std::size_t		GetPatternMemory(unsigned int &Patterns) const;		// // //
+	unsigned long long GetPatternVersion(unsigned int Track, unsigned int Channel, unsigned int Pattern) const;		// // //
+
+	// // // Compiled data kept between exports of this document
+	CCompilerCache	&GetCompilerCache() const;
+
+	// // // Player access to tracks. A published track is a const copy sharing its patterns
+	// with the document, so the audio thread can read it without locking the document
+	// while the editor keeps writing. PublishPlayback() swaps in a new copy of every track
+	// changed since the last call; it is called by the editing thread after each action, undo
+	// and redo, not per note, since publishing makes the next write to a shared pattern copy it.
+	// Instruments, grooves and module settings are published the same way, as whole copies.
+	std::shared_ptr<const CPatternData> GetPlaybackTrack(unsigned int Track) const;
+	std::shared_ptr<CInstrument> GetPlaybackInstrument(unsigned int Index) const;
+	std::shared_ptr<const CGroove> GetPlaybackGroove(unsigned int Index) const;
+	std::shared_ptr<const stPlaybackSettings> GetPlaybackSettings() const;		// Null while no module is loaded
+	void			PublishPlayback();
+	// // // Changes whenever PublishPlayback() swaps in new instruments, grooves or settings, so saved
+	// player states can be discarded. Track copies are not counted, they carry their own versions.
+	unsigned long long GetPlaybackVersion() const;
 
 	void			MakeKraid();				// // // Easter Egg
 
@@ -209,6 +273,7 @@ public:
 
 	void			SetDataAtPattern(unsigned int Track, unsigned int Pattern, unsigned int Channel, unsigned int Row, const stChanNote *pData);
 	void			GetDataAtPattern(unsigned int Track, unsigned int Pattern, unsigned int Channel, unsigned int Row, stChanNote *pData) const;
+	bool			IsInstrumentInPattern(unsigned int Track, unsigned int Pattern, unsigned int Channel, unsigned int Instrument) const;		// // //
 
 	void			ClearPatterns(unsigned int Track);
 	void			ClearPattern(unsigned int Track, unsigned int Frame, unsigned int Channel);
@@ -315,6 +380,7 @@ public:
 	void			SetGroove(int Index, const CGroove* Groove);
 
 	int				GetFrameLength(unsigned int Track, unsigned int Frame) const;
+	static int		GetFrameLength(const CPatternData &Track, int ChannelCount, unsigned int Frame);		// // //
 
 	// Track management functions
 	int				AddTrack();
@@ -368,6 +434,9 @@ public:
 	void			RemoveUnusedPatterns();
 	void			SwapInstruments(int First, int Second);
 	stFullState*	RetrieveSoundState(unsigned int Track, unsigned int Frame, unsigned int Row, int Channel);		// // //
+	// // // The same from published data, for the player thread
+	static stFullState *RetrieveSoundState(const CPatternData &Track, const CTrackerChannel *const *pChannels, int ChannelCount,
+		unsigned int SpeedSplitPoint, const std::function<bool (unsigned int)> &HasGroove, unsigned int Frame, unsigned int Row);
 
 	// For file version compability
 	static void		ConvertSequence(stSequence *pOldSequence, CSequence *pNewSequence, int Type);
@@ -513,6 +582,10 @@ private:
 	CPatternData*	GetTrack(unsigned int Track) const;
 	void			SwapTracks(unsigned int Track1, unsigned int Track2);
 
+	// // // Whether any pattern at a frame might use one of the effects, from the pattern summaries
+	template <std::size_t N>
+	bool			HasEffectsAtFrame(unsigned int Track, unsigned int Frame, const effect_t (&Effects)[N]) const;
+
 	void			SetupChannels(unsigned int Chip);
 	void			ApplyExpansionChip();
 	int				GetChannelPosition(int Channel, unsigned int Chip);		// // //
@@ -561,6 +634,14 @@ private:
 
 	// Patterns and song data
 	CPatternData	*m_pTracks[MAX_TRACKS];						// List of all tracks
+	std::shared_ptr<const CPatternData> m_pPlaybackTracks[MAX_TRACKS];		// // // Published copies, accessed with std::atomic_load / atomic_store
+	std::shared_ptr<const CPlaybackInstrument> m_pPlaybackInstruments[MAX_INSTRUMENTS];		// // //
+	std::shared_ptr<const CGroove> m_pPlaybackGrooves[MAX_GROOVE];		// // //
+	std::shared_ptr<const stPlaybackSettings> m_pPlaybackSettings;		// // //
+	std::atomic<unsigned long long> m_iPlaybackVersion {0};		// // //
+	// // // Copies shared by the published instruments, only used by PublishPlayback
+	std::map<std::tuple<int, int, int>, std::shared_ptr<const CSequence>> m_PlaybackSequences;
+	std::shared_ptr<const CDSample> m_pPlaybackSamples[MAX_DSAMPLES];
 
 	unsigned int	m_iTrackCount;								// Number of tracks added
 	unsigned int	m_iChannelsAvailable;						// Number of channels added
@@ -568,6 +649,9 @@ private:
 	// Instruments, samples and sequences
 	CInstrumentManager *m_pInstrumentManager;					// // //
 	CBookmarkManager *m_pBookmarkManager;						// // //
+
+	std::unique_ptr<CCompilerCache> m_pCompilerCache;			// // //
+	CSoundGen		*m_pSoundGen;								// // // The generator this document is assigned to
 	CGroove			*m_pGrooveTable[MAX_GROOVE];				// // // Grooves
 
 	// Module properties
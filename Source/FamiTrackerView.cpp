@@ -44,6 +44,7 @@
 #include "RecordSettingsDlg.h"
 #include "SplitKeyboardDlg.h"
 #include "NoteQueue.h"
+#include "LiveNoteRouter.h"		// // //
 
 #include <cmath>
 #include <assert.h>
@@ -326,7 +327,6 @@ CFamiTrackerView::CFamiTrackerView() :
 	m_iSplitInstrument(MAX_INSTRUMENTS),		// // //
 	m_iSplitTranspose(0),		// // //
 	m_iNoteCorrection(),
-	m_pNoteQueue(new CNoteQueue { }),
 	m_pPatternEditor(new CPatternEditor()),
 	m_nDropEffect(DROPEFFECT_NONE),
 	m_bDragSource(false)
@@ -374,7 +374,6 @@ CFamiTrackerView::~CFamiTrackerView()
 
 	// Release allocated objects
 	SAFE_RELEASE(m_pPatternEditor);
-	SAFE_RELEASE(m_pNoteQueue);		// // //
 }
 
 
@@ -551,6 +550,7 @@ void CFamiTrackerView::InvalidateCursor()
 	{
 		LastPosition = p;
 		static_cast<CMainFrame*>(GetParentFrame())->ResetFind();		// // //
+		PublishLiveNoteRoute();		// // //
 	}
 }
 
@@ -920,6 +920,10 @@ void CFamiTrackerView::PeriodicUpdate()
 	CMainFrame *pMainFrm = static_cast<CMainFrame*>(GetParentFrame());
 	ASSERT_VALID(pMainFrm);
 
+	// // // Edits made outside of undoable actions still reach the player
+	pDoc->PublishPlayback();
+	PublishLiveNoteRoute();		// // //
+
 	CSoundGen *pSoundGen = theApp.GetSoundGenerator();
 
 	if (pSoundGen != NULL) {
@@ -1643,13 +1647,11 @@ void CFamiTrackerView::PlayerTick()
 	while (m_iAutoArpPtr != OldPtr);
 }
 
-bool CFamiTrackerView::PlayerGetNote(int Track, int Frame, int Channel, int Row, stChanNote &NoteData)
+bool CFamiTrackerView::PlayerFilterNote(int Channel, int Columns, stChanNote &NoteData)		// // //
 {
-	CFamiTrackerDoc *pDoc = GetDocument();
+	// NoteData is the row the player read, keep only what a muted channel lets through
 	bool ValidCommand = false;
 
-	pDoc->GetNoteData(Track, Frame, Channel, Row, &NoteData);
-
 	if (!IsChannelMuted(Channel)) {
 		// Let view know what is about to play
 		PlayerPlayNote(Channel, &NoteData);
@@ -1663,8 +1665,6 @@ bool CFamiTrackerView::PlayerGetNote(int Track, int Frame, int Channel, int Row,
 			EF_SUNSOFT_ENV_TYPE, EF_SUNSOFT_NOISE, EF_SUNSOFT_ENV_HI, EF_SUNSOFT_ENV_LO,
 			EF_N163_WAVE_BUFFER
 		};
-		int Columns = pDoc->GetEffColumns(Track, Channel) + 1;
-
 		NoteData.Note		= HALT;
 		NoteData.Octave		= 0;
 		NoteData.Instrument = 0;
@@ -1713,6 +1713,7 @@ void CFamiTrackerView::SetFollowMode(bool Mode)
 {
 	m_bFollowMode = Mode;
 	m_pPatternEditor->SetFollowMove(Mode);
+	PublishLiveNoteRoute();		// // //
 }
 
 bool CFamiTrackerView::GetFollowMode() const
@@ -1933,6 +1934,7 @@ void CFamiTrackerView::OnEditSplitKeyboard()		// // //
 			m_iSplitInstrument = MAX_INSTRUMENTS;
 			m_iSplitTranspose = 0;
 		}
+		PublishLiveNoteRoute();		// // //
 	}
 }
 
@@ -2205,35 +2207,16 @@ void CFamiTrackerView::InsertNote(int Note, int Octave, int Channel, int Velocit
 /// Note playing routines
 //////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void CFamiTrackerView::PlayNote(unsigned int Channel, unsigned int Note, unsigned int Octave, unsigned int Velocity) const
+void CFamiTrackerView::PlayNote(unsigned int Channel, unsigned int Note, unsigned int Octave, unsigned int Velocity, std::int64_t Time) const
 {
 	// Play a note in a channel
-	stChanNote NoteData { };		// // //
-
-	NoteData.Note		= Note;
-	NoteData.Octave		= Octave;
-	NoteData.Instrument	= GetInstrument();
-	if (theApp.GetSettings()->Midi.bMidiVelocity)
-		NoteData.Vol = Velocity / 8;
-/*
-	if (theApp.GetSettings()->General.iEditStyle == EDIT_STYLE_IT)
-		NoteData.Instrument	= m_iLastInstrument;
-	else
-		NoteData.Instrument	= GetInstrument();
-*/
-	int MidiNote = MIDI_NOTE(Octave, Note);		// // //
 	CFamiTrackerDoc *pDoc = GetDocument();
 
-	SplitAdjustChannel(Channel, NoteData);
-	if (Channel < static_cast<unsigned>(pDoc->GetChannelCount())) {
-		int ret = pDoc->GetChannelIndex(m_pNoteQueue->Trigger(MidiNote, pDoc->GetChannelType(Channel)));
-		if (ret != -1) {
-			if (IsSplitEnabled(MidiNote, ret)) 	// // //
-				SplitKeyboardAdjust(NoteData);
-			pDoc->GetChannel(ret)->SetNote(NoteData, NOTE_PRIO_2);
-			theApp.GetSoundGenerator()->ForceReloadInstrument(ret);		// // //
-		}
-	}
+	// // // The router picks the channel and note data, the same way for notes from the MIDI input thread
+	PublishLiveNoteRoute();
+	stRoutedNote Routed;
+	if (GetLiveNoteRouter()->Trigger(Channel, Note, Octave, Velocity, Routed))
+		theApp.GetSoundGenerator()->QueueLiveNote(Routed, Time);
 
 	if (theApp.GetSettings()->General.bPreviewFullRow) {
 		stChanNote ChanNote;
@@ -2250,23 +2233,21 @@ void CFamiTrackerView::PlayNote(unsigned int Channel, unsigned int Note, unsigne
 	}
 }
 
-void CFamiTrackerView::ReleaseNote(unsigned int Channel, unsigned int Note, unsigned int Octave) const
+void CFamiTrackerView::ReleaseNote(unsigned int Channel, unsigned int Note, unsigned int Octave, std::int64_t Time) const
 {
 	// Releases a channel
-	stChanNote NoteData { };		// // //
-
-	NoteData.Note = RELEASE;
-	NoteData.Instrument = GetInstrument();
-
-	SplitAdjustChannel(Channel, NoteData);		// // //
 	CFamiTrackerDoc *pDoc = GetDocument();		// // //
-	if (Channel < static_cast<unsigned>(pDoc->GetChannelCount())) {
-		int ch = pDoc->GetChannelIndex(m_pNoteQueue->Cut(MIDI_NOTE(Octave, Note), pDoc->GetChannelType(Channel)));
-	//	int ch = pDoc->GetChannelIndex(m_pNoteQueue->Release(MIDI_NOTE(Octave, Note), pDoc->GetChannelType(Channel)));
-		if (ch != -1)
-			theApp.GetSoundGenerator()->QueueNote(ch, NoteData, NOTE_PRIO_2);
+	PublishLiveNoteRoute();		// // //
+	stRoutedNote Routed;
+	int ch = -1;
+	if (GetLiveNoteRouter()->Cut(Channel, Note, Octave, RELEASE, Routed)) {
+		theApp.GetSoundGenerator()->QueueLiveNote(Routed, Time);
+		ch = Routed.Channel;
+	}
 
+	if (Channel < static_cast<unsigned>(pDoc->GetChannelCount())) {
 		if (theApp.GetSettings()->General.bPreviewFullRow) {
+			stChanNote NoteData { };
 			NoteData.Note = HALT;
 			NoteData.Instrument = MAX_INSTRUMENTS;
 
@@ -2279,22 +2260,22 @@ void CFamiTrackerView::ReleaseNote(unsigned int Channel, unsigned int Note, unsi
 	}
 }
 
-void CFamiTrackerView::HaltNote(unsigned int Channel, unsigned int Note, unsigned int Octave) const
+void CFamiTrackerView::HaltNote(unsigned int Channel, unsigned int Note, unsigned int Octave, std::int64_t Time) const
 {
 	// Halts a channel
-	stChanNote NoteData { };		// // //
-
-	NoteData.Note = HALT;
-	NoteData.Instrument = GetInstrument();
-
-	SplitAdjustChannel(Channel, NoteData);		// // //
 	CFamiTrackerDoc *pDoc = GetDocument();		// // //
-	if (Channel < static_cast<unsigned>(pDoc->GetChannelCount())) {
-		int ch = pDoc->GetChannelIndex(m_pNoteQueue->Cut(MIDI_NOTE(Octave, Note), pDoc->GetChannelType(Channel)));
-		if (ch != -1)
-			theApp.GetSoundGenerator()->QueueNote(ch, NoteData, NOTE_PRIO_2);
+	PublishLiveNoteRoute();		// // //
+	stRoutedNote Routed;
+	int ch = -1;
+	if (GetLiveNoteRouter()->Cut(Channel, Note, Octave, HALT, Routed)) {
+		theApp.GetSoundGenerator()->QueueLiveNote(Routed, Time);
+		ch = Routed.Channel;
+	}
 
+	if (Channel < static_cast<unsigned>(pDoc->GetChannelCount())) {
 		if (theApp.GetSettings()->General.bPreviewFullRow) {
+			stChanNote NoteData { };
+			NoteData.Note = HALT;
 			NoteData.Instrument = MAX_INSTRUMENTS;
 
 			int Channels = pDoc->GetChannelCount();
@@ -2315,14 +2296,9 @@ void CFamiTrackerView::HaltNoteSingle(unsigned int Channel) const
 	NoteData.Instrument = GetInstrument();
 
 	SplitAdjustChannel(Channel, NoteData);		// // // ?
-	CFamiTrackerDoc *pDoc = GetDocument();		// // //
-	if (Channel < static_cast<unsigned>(pDoc->GetChannelCount())) {
-		for (const auto &i : m_pNoteQueue->StopChannel(pDoc->GetChannelType(Channel))) {
-			int ch = pDoc->GetChannelIndex(i);
-			if (ch != -1)
-				theApp.GetSoundGenerator()->QueueNote(ch, NoteData, NOTE_PRIO_2);
-		}
-	}
+	PublishLiveNoteRoute();		// // //
+	for (int ch : GetLiveNoteRouter()->StopChannel(Channel))
+		theApp.GetSoundGenerator()->QueueNote(ch, NoteData, NOTE_PRIO_2);
 
 	if (theApp.GetSoundGenerator()->IsPlaying())
 		theApp.GetSoundGenerator()->QueueNote(Channel, NoteData, NOTE_PRIO_2);
@@ -2343,7 +2319,7 @@ static void FixNoise(unsigned int &MidiNote, unsigned int &Octave, unsigned int
 */
 
 // Play a note
-void CFamiTrackerView::TriggerMIDINote(unsigned int Channel, unsigned int MidiNote, unsigned int Velocity, bool Insert)
+void CFamiTrackerView::TriggerMIDINote(unsigned int Channel, unsigned int MidiNote, unsigned int Velocity, bool Insert, std::int64_t Time, bool Played)
 {
 	CFamiTrackerDoc *pDoc = GetDocument();
 
@@ -2365,8 +2341,8 @@ void CFamiTrackerView::TriggerMIDINote(unsigned int Channel, unsigned int MidiNo
 		}
 	}
 
-	if (!(theApp.IsPlaying() && m_bEditEnable && !m_bFollowMode))		// // //
-		PlayNote(Channel, Note, Octave, Velocity);
+	if (!Played && !(theApp.IsPlaying() && m_bEditEnable && !m_bFollowMode))		// // //
+		PlayNote(Channel, Note, Octave, Velocity, Time);
 
 	if (Insert)
 		InsertNote(Note, Octave, Channel, Velocity + 1);
@@ -2378,6 +2354,8 @@ void CFamiTrackerView::TriggerMIDINote(unsigned int Channel, unsigned int MidiNo
 	UpdateArpDisplay();
 
 	m_iLastMIDINote = MidiNote;
+	if (!Played)		// // // The MIDI input thread has recorded it already
+		GetLiveNoteRouter()->SetLastNote(MidiNote);
 
 	m_iAutoArpKeyCount = 0;
 
@@ -2390,7 +2368,7 @@ void CFamiTrackerView::TriggerMIDINote(unsigned int Channel, unsigned int MidiNo
 }
 
 // Cut the currently playing note
-void CFamiTrackerView::CutMIDINote(unsigned int Channel, unsigned int MidiNote, bool InsertCut)
+void CFamiTrackerView::CutMIDINote(unsigned int Channel, unsigned int MidiNote, bool InsertCut, std::int64_t Time, bool Played)
 {
 	CFamiTrackerDoc *pDoc = GetDocument();
 
@@ -2408,26 +2386,26 @@ void CFamiTrackerView::CutMIDINote(unsigned int Channel, unsigned int MidiNote,
 	UpdateArpDisplay();
 
 	// Cut note
-	if (!(theApp.IsPlaying() && m_bEditEnable && !m_bFollowMode))		// // //
+	if (!Played && !(theApp.IsPlaying() && m_bEditEnable && !m_bFollowMode))		// // //
 		if (m_bEditEnable) {
 			if (m_iLastMIDINote == MidiNote)
-				HaltNote(Channel, Note, Octave);
+				HaltNote(Channel, Note, Octave, Time);
 		}
 		else
-			HaltNote(Channel, Note, Octave);
+			HaltNote(Channel, Note, Octave, Time);
 
 	if (InsertCut)
 		InsertNote(HALT, 0, Channel, 0);
 
 	// IT-mode, cut note on cuts
-	if (theApp.GetSettings()->General.iEditStyle == EDIT_STYLE_IT)
-		HaltNote(Channel, Note, Octave);		// // //
+	if (!Played && theApp.GetSettings()->General.iEditStyle == EDIT_STYLE_IT)
+		HaltNote(Channel, Note, Octave, Time);		// // //
 
 	TRACE("%i: Cut note %i on channel %i\n", GetTickCount(), MidiNote, Channel);
 }
 
 // Release the currently playing note
-void CFamiTrackerView::ReleaseMIDINote(unsigned int Channel, unsigned int MidiNote, bool InsertCut)
+void CFamiTrackerView::ReleaseMIDINote(unsigned int Channel, unsigned int MidiNote, bool InsertCut, std::int64_t Time, bool Played)
 {
 	CFamiTrackerDoc *pDoc = GetDocument();
 
@@ -2445,20 +2423,20 @@ void CFamiTrackerView::ReleaseMIDINote(unsigned int Channel, unsigned int MidiNo
 	UpdateArpDisplay();
 
 	// Cut note
-	if (!(theApp.IsPlaying() && m_bEditEnable && !m_bFollowMode))		// // //
+	if (!Played && !(theApp.IsPlaying() && m_bEditEnable && !m_bFollowMode))		// // //
 		if (m_bEditEnable) {
 			if (m_iLastMIDINote == MidiNote)
-				ReleaseNote(Channel, Note, Octave);
+				ReleaseNote(Channel, Note, Octave, Time);
 		}
 		else
-			ReleaseNote(Channel, Note, Octave);
+			ReleaseNote(Channel, Note, Octave, Time);
 
 	if (InsertCut)
 		InsertNote(RELEASE, 0, Channel, 0);
 
 	// IT-mode, release note
-	if (theApp.GetSettings()->General.iEditStyle == EDIT_STYLE_IT)
-		ReleaseNote(Channel, Note, Octave);		// // //
+	if (!Played && theApp.GetSettings()->General.iEditStyle == EDIT_STYLE_IT)
+		ReleaseNote(Channel, Note, Octave, Time);		// // //
 
 	TRACE("%i: Release note %i on channel %i\n", GetTickCount(), MidiNote, Channel);
 }
@@ -2488,98 +2466,142 @@ void CFamiTrackerView::UpdateNoteQueues()		// // //
 	ASSERT_VALID(pDoc);
 	const int Channels = pDoc->GetChannelCount();
 
-	m_pNoteQueue->ClearMaps();
+	CNoteQueue Queue;
 
 	if (m_bEditEnable)
 		for (int i = 0; i < Channels; ++i) {
 			unsigned ID = pDoc->GetChannelType(i);
 			if (ID != -1)
-				m_pNoteQueue->AddMap({ID});
+				Queue.AddMap({ID});
 		}
 	else {
-		m_pNoteQueue->AddMap({CHANID_2A03_TRIANGLE});
-		m_pNoteQueue->AddMap({CHANID_2A03_NOISE});
-		m_pNoteQueue->AddMap({CHANID_2A03_DPCM});
+		Queue.AddMap({CHANID_2A03_TRIANGLE});
+		Queue.AddMap({CHANID_2A03_NOISE});
+		Queue.AddMap({CHANID_2A03_DPCM});
 
 		if (pDoc->ExpansionEnabled(SNDCHIP_VRC6)) {
-			m_pNoteQueue->AddMap({CHANID_VRC6_PULSE1, CHANID_VRC6_PULSE2});
-			m_pNoteQueue->AddMap({CHANID_VRC6_SAWTOOTH});
+			Queue.AddMap({CHANID_VRC6_PULSE1, CHANID_VRC6_PULSE2});
+			Queue.AddMap({CHANID_VRC6_SAWTOOTH});
 		}
 
 		if (pDoc->ExpansionEnabled(SNDCHIP_FDS))
-			m_pNoteQueue->AddMap({CHANID_FDS});
+			Queue.AddMap({CHANID_FDS});
 
 		if (pDoc->ExpansionEnabled(SNDCHIP_MMC5))
-			m_pNoteQueue->AddMap({CHANID_2A03_SQUARE1, CHANID_2A03_SQUARE2, CHANID_MMC5_SQUARE1, CHANID_MMC5_SQUARE2});
+			Queue.AddMap({CHANID_2A03_SQUARE1, CHANID_2A03_SQUARE2, CHANID_MMC5_SQUARE1, CHANID_MMC5_SQUARE2});
 		else
-			m_pNoteQueue->AddMap({CHANID_2A03_SQUARE1, CHANID_2A03_SQUARE2});
+			Queue.AddMap({CHANID_2A03_SQUARE1, CHANID_2A03_SQUARE2});
 
 		if (pDoc->ExpansionEnabled(SNDCHIP_N163)) {
 			std::vector<unsigned> n;
 			int Channels = pDoc->GetNamcoChannels();
 			for (int i = 0; i < Channels; ++i)
 				n.push_back(CHANID_N163_CH1 + i);
-			m_pNoteQueue->AddMap(n);
+			Queue.AddMap(n);
 		}
 
 		if (pDoc->ExpansionEnabled(SNDCHIP_5B) && pDoc->ExpansionEnabled(SNDCHIP_AY) && pDoc->ExpansionEnabled(SNDCHIP_SSG)) {
-				m_pNoteQueue->AddMap({ CHANID_5B_CH1, CHANID_5B_CH2, CHANID_5B_CH3, CHANID_AY_CH1, CHANID_AY_CH2, CHANID_AY_CH3, CHANID_YM2149F_CH1, CHANID_YM2149F_CH2, CHANID_YM2149F_CH3 });
+				Queue.AddMap({ CHANID_5B_CH1, CHANID_5B_CH2, CHANID_5B_CH3, CHANID_AY_CH1, CHANID_AY_CH2, CHANID_AY_CH3, CHANID_YM2149F_CH1, CHANID_YM2149F_CH2, CHANID_YM2149F_CH3 });
 
 		} else if (pDoc->ExpansionEnabled(SNDCHIP_5B) && pDoc->ExpansionEnabled(SNDCHIP_AY)) {
-			m_pNoteQueue->AddMap({ CHANID_5B_CH1, CHANID_5B_CH2, CHANID_5B_CH3, CHANID_AY_CH1, CHANID_AY_CH2, CHANID_AY_CH3 });
+			Queue.AddMap({ CHANID_5B_CH1, CHANID_5B_CH2, CHANID_5B_CH3, CHANID_AY_CH1, CHANID_AY_CH2, CHANID_AY_CH3 });
 
 		} else if (pDoc->ExpansionEnabled(SNDCHIP_5B) && pDoc->ExpansionEnabled(SNDCHIP_SSG)) {
-			m_pNoteQueue->AddMap({ CHANID_5B_CH1, CHANID_5B_CH2, CHANID_5B_CH3, CHANID_YM2149F_CH1, CHANID_YM2149F_CH2, CHANID_YM2149F_CH3 });
+			Queue.AddMap({ CHANID_5B_CH1, CHANID_5B_CH2, CHANID_5B_CH3, CHANID_YM2149F_CH1, CHANID_YM2149F_CH2, CHANID_YM2149F_CH3 });
 
 		} else if (pDoc->ExpansionEnabled(SNDCHIP_AY) && pDoc->ExpansionEnabled(SNDCHIP_SSG)) {
-			m_pNoteQueue->AddMap({ CHANID_AY_CH1, CHANID_AY_CH2, CHANID_AY_CH3, CHANID_YM2149F_CH1, CHANID_YM2149F_CH2, CHANID_YM2149F_CH3 });
+			Queue.AddMap({ CHANID_AY_CH1, CHANID_AY_CH2, CHANID_AY_CH3, CHANID_YM2149F_CH1, CHANID_YM2149F_CH2, CHANID_YM2149F_CH3 });
 
 		} else {
 			if (pDoc->ExpansionEnabled(SNDCHIP_5B))
-				m_pNoteQueue->AddMap({ CHANID_5B_CH1, CHANID_5B_CH2, CHANID_5B_CH3 });
+				Queue.AddMap({ CHANID_5B_CH1, CHANID_5B_CH2, CHANID_5B_CH3 });
 
 			if (pDoc->ExpansionEnabled(SNDCHIP_AY))
-				m_pNoteQueue->AddMap({ CHANID_AY_CH1, CHANID_AY_CH2, CHANID_AY_CH3 });
+				Queue.AddMap({ CHANID_AY_CH1, CHANID_AY_CH2, CHANID_AY_CH3 });
 
 			if (pDoc->ExpansionEnabled(SNDCHIP_SSG))
-				m_pNoteQueue->AddMap({ CHANID_YM2149F_CH1, CHANID_YM2149F_CH2, CHANID_YM2149F_CH3 });
+				Queue.AddMap({ CHANID_YM2149F_CH1, CHANID_YM2149F_CH2, CHANID_YM2149F_CH3 });
 		}
 
 		if (pDoc->ExpansionEnabled(SNDCHIP_AY8930))
-			m_pNoteQueue->AddMap({ CHANID_AY8930_CH1, CHANID_AY8930_CH2, CHANID_AY8930_CH3 });
+			Queue.AddMap({ CHANID_AY8930_CH1, CHANID_AY8930_CH2, CHANID_AY8930_CH3 });
 
 		if (pDoc->ExpansionEnabled(SNDCHIP_5E01)) {
-			m_pNoteQueue->AddMap({ CHANID_5E01_SQUARE1, CHANID_5E01_SQUARE2 });
+			Queue.AddMap({ CHANID_5E01_SQUARE1, CHANID_5E01_SQUARE2 });
 			for (unsigned int i = 0; i < 3; ++i)
-				m_pNoteQueue->AddMap({ CHANID_5E01_WAVEFORM + i });
+				Queue.AddMap({ CHANID_5E01_WAVEFORM + i });
 		}
 
 		if (pDoc->ExpansionEnabled(SNDCHIP_7E02)) {
-			m_pNoteQueue->AddMap({ CHANID_7E02_SQUARE1, CHANID_7E02_SQUARE2 });
+			Queue.AddMap({ CHANID_7E02_SQUARE1, CHANID_7E02_SQUARE2 });
 			for (unsigned int i = 0; i < 3; ++i)
-				m_pNoteQueue->AddMap({ CHANID_7E02_WAVEFORM + i });
+				Queue.AddMap({ CHANID_7E02_WAVEFORM + i });
 		}
 
 		if (pDoc->ExpansionEnabled(SNDCHIP_VRC7) && pDoc->ExpansionEnabled(SNDCHIP_OPLL)) {
-			m_pNoteQueue->AddMap({ CHANID_VRC7_CH1, CHANID_VRC7_CH2, CHANID_VRC7_CH3, CHANID_VRC7_CH4, CHANID_VRC7_CH5, CHANID_VRC7_CH6, CHANID_OPLL_CH1, CHANID_OPLL_CH2, CHANID_OPLL_CH3, CHANID_OPLL_CH4, CHANID_OPLL_CH5, CHANID_OPLL_CH6, CHANID_OPLL_CH7, CHANID_OPLL_CH8, CHANID_OPLL_CH9 });
+			Queue.AddMap({ CHANID_VRC7_CH1, CHANID_VRC7_CH2, CHANID_VRC7_CH3, CHANID_VRC7_CH4, CHANID_VRC7_CH5, CHANID_VRC7_CH6, CHANID_OPLL_CH1, CHANID_OPLL_CH2, CHANID_OPLL_CH3, CHANID_OPLL_CH4, CHANID_OPLL_CH5, CHANID_OPLL_CH6, CHANID_OPLL_CH7, CHANID_OPLL_CH8, CHANID_OPLL_CH9 });
 		} else {
 			if (pDoc->ExpansionEnabled(SNDCHIP_VRC7))
-				m_pNoteQueue->AddMap({ CHANID_VRC7_CH1, CHANID_VRC7_CH2, CHANID_VRC7_CH3, CHANID_VRC7_CH4, CHANID_VRC7_CH5, CHANID_VRC7_CH6 });
+				Queue.AddMap({ CHANID_VRC7_CH1, CHANID_VRC7_CH2, CHANID_VRC7_CH3, CHANID_VRC7_CH4, CHANID_VRC7_CH5, CHANID_VRC7_CH6 });
 
 			if (pDoc->ExpansionEnabled(SNDCHIP_OPLL))
-				m_pNoteQueue->AddMap({ CHANID_OPLL_CH1, CHANID_OPLL_CH2, CHANID_OPLL_CH3, CHANID_OPLL_CH4, CHANID_OPLL_CH5, CHANID_OPLL_CH6, CHANID_OPLL_CH7, CHANID_OPLL_CH8, CHANID_OPLL_CH9 });
+				Queue.AddMap({ CHANID_OPLL_CH1, CHANID_OPLL_CH2, CHANID_OPLL_CH3, CHANID_OPLL_CH4, CHANID_OPLL_CH5, CHANID_OPLL_CH6, CHANID_OPLL_CH7, CHANID_OPLL_CH8, CHANID_OPLL_CH9 });
 		}
 
 		if (pDoc->ExpansionEnabled(SNDCHIP_6581))
-			m_pNoteQueue->AddMap({ CHANID_6581_CH1, CHANID_6581_CH2, CHANID_6581_CH3 });
+			Queue.AddMap({ CHANID_6581_CH1, CHANID_6581_CH2, CHANID_6581_CH3 });
 
 	}
 
 //	for (int i = 0; i < Channels; ++i)
 //		if (IsChannelMuted(i))
-//			m_pNoteQueue->MuteChannel(pDoc->GetChannelType(i));
+//			Queue.MuteChannel(pDoc->GetChannelType(i));
+
+	GetLiveNoteRouter()->SetNoteQueue(std::move(Queue));
+	PublishLiveNoteRoute();
+}
+
+CLiveNoteRouter *CFamiTrackerView::GetLiveNoteRouter() const		// // //
+{
+	return theApp.GetMIDI()->GetLiveNoteRouter();
+}
+
+void CFamiTrackerView::GetLiveNoteRoute(stLiveNoteRoute &Route) const		// // //
+{
+	const CFamiTrackerDoc *pDoc = GetDocument();
+	const CSettings *pSettings = theApp.GetSettings();
+
+	// The full row preview reads pattern data, which only the view may do
+	Route.bMidiThread = !pSettings->General.bPreviewFullRow;
+	Route.bPreview = !(theApp.IsPlaying() && m_bEditEnable && !m_bFollowMode);
+	Route.bEditEnable = m_bEditEnable;
+	Route.bChannelMap = pSettings->Midi.bMidiChannelMap;
+	Route.bMidiVelocity = pSettings->Midi.bMidiVelocity;
+	Route.bITEditStyle = pSettings->General.iEditStyle == EDIT_STYLE_IT;
+	Route.bRelease = DoRelease();
+	Route.iCursorChannel = m_pPatternEditor->GetChannel();
+	Route.iAvailableChannels = pDoc->GetAvailableChannels();
+	Route.iInstrument = GetInstrument();
+	Route.iLastVolume = m_iLastVolume;
+	Route.iSplitNote = m_iSplitNote;
+	Route.iSplitChannel = m_iSplitChannel;
+	Route.iSplitInstrument = m_iSplitInstrument;
+	Route.iSplitTranspose = m_iSplitTranspose;
+	Route.iChannelCount = pDoc->GetChannelCount();
+	for (int i = 0; i < Route.iChannelCount; ++i)
+		Route.iChannelType[i] = pDoc->GetChannelType(i);
+}
+
+void CFamiTrackerView::PublishLiveNoteRoute() const		// // //
+{
+	// Called whenever the state used to route notes may have changed, the MIDI input thread
+	// plays notes with the last route published
+	stLiveNoteRoute Route;
+	GetLiveNoteRoute(Route);
+	GetLiveNoteRouter()->SetRoute(Route);
 }
 
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// Tracker input routines
 //////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -3746,8 +3768,13 @@ void CFamiTrackerView::TranslateMidiMessage()
 	if (!pMIDI || !pDoc)
 		return;
 
+	// // // Notes that arrive from now on are played with the current view state
+	PublishLiveNoteRoute();
+
 	unsigned char Message, Channel, Data1, Data2;
-	while (pMIDI->ReadMessage(Message, Channel, Data1, Data2)) {
+	std::int64_t Time;		// // //
+	bool Played;
+	while (pMIDI->ReadMessage(Message, Channel, Data1, Data2, Time, Played)) {
 
 		if (Message != 0x0F) {
 			if (!theApp.GetSettings()->Midi.bMidiChannelMap)
@@ -3770,7 +3797,7 @@ void CFamiTrackerView::TranslateMidiMessage()
 
 		switch (Message) {
 			case MIDI_MSG_NOTE_ON:
-				TriggerMIDINote(Channel, Data1, Data2, true);
+				TriggerMIDINote(Channel, Data1, Data2, true, Time, Played);
 				AfxFormatString3(Status, IDS_MIDI_MESSAGE_ON_FORMAT,
 					MakeIntString(Data1 % 12),
 					MakeIntString(Data1 / 12),
@@ -3780,9 +3807,9 @@ void CFamiTrackerView::TranslateMidiMessage()
 			case MIDI_MSG_NOTE_OFF:
 				// MIDI key is released, don't input note break into pattern
 				if (DoRelease())
-					ReleaseMIDINote(Channel, Data1, false);
+					ReleaseMIDINote(Channel, Data1, false, Time, Played);
 				else
-					CutMIDINote(Channel, Data1, false);
+					CutMIDINote(Channel, Data1, false, Time, Played);
 				Status.Format(IDS_MIDI_MESSAGE_OFF);
 				break;
 
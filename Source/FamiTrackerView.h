@@ -31,6 +31,7 @@
 
 #include "PatternEditorTypes.h"		// // //
 #include "FamiTrackerViewMessage.h"		// // //
+#include "LiveNoteScheduler.h"		// // //
 #include "utils/input.h"
 
 // External classes
@@ -38,7 +39,8 @@ class CFamiTrackerDoc;
 class CPatternEditor;
 class CFrameEditor;
 class Action;
-class CNoteQueue;		// // //
+struct stLiveNoteRoute;		// // //
+class CLiveNoteRouter;		// // //
 
 // TODO move general tracker state variables to the mainframe instead of the view, such as selected octave, instrument etc
 
@@ -99,12 +101,15 @@ public:
 
 	// Player callback (TODO move to new interface)
 	void		 PlayerTick();
-	bool		 PlayerGetNote(int Track, int Frame, int Channel, int Row, stChanNote &NoteData);
+	bool		 PlayerFilterNote(int Channel, int Columns, stChanNote &NoteData);		// // //
 	void		 PlayerPlayNote(int Channel, stChanNote *pNote);
 
 	void		 MakeSilent();
 	void		 RegisterKeyState(int Channel, int Note);
 
+	// // // Live note routing, for notes played from the MIDI input thread
+	void		 PublishLiveNoteRoute() const;
+
 	// Note preview
 	bool		 PreviewNote(Keycode Key);
 	void		 PreviewRelease(Keycode Key);
@@ -222,18 +227,22 @@ private:
 	void	SplitAdjustChannel(unsigned int &Channel, const stChanNote &Note) const;		// // //
 
 	// MIDI note functions
-	void	TriggerMIDINote(unsigned int Channel, unsigned int MidiNote, unsigned int Velocity, bool Insert);
-	void	ReleaseMIDINote(unsigned int Channel, unsigned int MidiNote, bool InsertCut);
-	void	CutMIDINote(unsigned int Channel, unsigned int MidiNote, bool InsertCut);
+	// // // Time is when the input arrived, from CLiveNoteScheduler::Now()
+	// Played is set if the MIDI input thread has already played the note
+	void	TriggerMIDINote(unsigned int Channel, unsigned int MidiNote, unsigned int Velocity, bool Insert, std::int64_t Time = CLiveNoteScheduler::Now(), bool Played = false);
+	void	ReleaseMIDINote(unsigned int Channel, unsigned int MidiNote, bool InsertCut, std::int64_t Time = CLiveNoteScheduler::Now(), bool Played = false);
+	void	CutMIDINote(unsigned int Channel, unsigned int MidiNote, bool InsertCut, std::int64_t Time = CLiveNoteScheduler::Now(), bool Played = false);
 
 	// Note handling
-	void	PlayNote(unsigned int Channel, unsigned int Note, unsigned int Octave, unsigned int Velocity) const;
-	void	ReleaseNote(unsigned int Channel, unsigned int Note, unsigned int Octave) const;		// // //
-	void	HaltNote(unsigned int Channel, unsigned int Note, unsigned int Octave) const;		// // //
+	void	PlayNote(unsigned int Channel, unsigned int Note, unsigned int Octave, unsigned int Velocity, std::int64_t Time) const;		// // //
+	void	ReleaseNote(unsigned int Channel, unsigned int Note, unsigned int Octave, std::int64_t Time) const;		// // //
+	void	HaltNote(unsigned int Channel, unsigned int Note, unsigned int Octave, std::int64_t Time) const;		// // //
 	void	HaltNoteSingle(unsigned int Channel) const;		// // //
 
 	void	UpdateArpDisplay();
 	void	UpdateNoteQueues();		// // //
+	void	GetLiveNoteRoute(stLiveNoteRoute &Route) const;		// // //
+	CLiveNoteRouter *GetLiveNoteRouter() const;		// // //
 
 	// Mute methods
 	bool	IsChannelSolo(unsigned int Channel) const;
@@ -319,7 +328,6 @@ private:
 	int					m_iSplitTranspose;
 
 	std::unordered_map<Keycode, int> m_iNoteCorrection;			// // // correction from changing octaves
-	CNoteQueue			*m_pNoteQueue;							// // // Note queue for handling note triggers
 
 	// MIDI
 	unsigned int		m_iLastMIDINote;
@@ -20,6 +20,10 @@
 
 #include "stdafx.h"
 #include "Groove.h"
+#include <atomic>		// // //
+
+// // // Source of groove versions, shared by every document
+static std::atomic<unsigned long long> NextVersion { 1 };
 
 CGroove::CGroove(int Speed)
 {
@@ -30,6 +34,7 @@ void CGroove::Copy(const CGroove *Source)
 {
 	SetSize(Source->GetSize());
 	memcpy(m_iEntry, Source->m_iEntry, MAX_GROOVE_SIZE);
+	Modified();		// // //
 }
 
 void CGroove::Clear(unsigned char Speed)
@@ -37,6 +42,7 @@ void CGroove::Clear(unsigned char Speed)
 	m_iLength = (Speed > 0);
 	memset(m_iEntry, 0, MAX_GROOVE_SIZE);
 	SetEntry(0, Speed);
+	Modified();		// // //
 }
 
 unsigned char CGroove::GetEntry(int Index) const
@@ -51,6 +57,7 @@ void CGroove::SetEntry(unsigned char Index, unsigned char Value)
 {
 	if (Index >= m_iLength) return;
 	m_iEntry[Index] = Value;
+	Modified();		// // //
 }
 
 unsigned char CGroove::GetSize() const
@@ -64,6 +71,7 @@ void CGroove::SetSize(unsigned char Size)
 	if (m_iLength < Size) for (unsigned char i = m_iLength; i < Size; i++)
 		m_iEntry[i] = 0;
 	m_iLength = Size;
+	Modified();		// // //
 }
 
 float CGroove::GetAverage() const
@@ -74,4 +82,14 @@ float CGroove::GetAverage() const
 		for (unsigned char i = 0; i < m_iLength; i++) Total += m_iEntry[i];
 		return Total / m_iLength;
 	}
-}
\ No newline at end of file
+}
+
+unsigned long long CGroove::GetVersion() const		// // //
+{
+	return m_iVersion;
+}
+
+void CGroove::Modified()		// // //
+{
+	m_iVersion = NextVersion++;
+}
@@ -34,7 +34,10 @@ public:
 	unsigned char GetSize() const;
 	void SetSize(unsigned char Size);
 	float GetAverage() const;
+	unsigned long long GetVersion() const;		// // // Changes whenever the groove is written to
 private:
+	void Modified();		// // //
+	unsigned long long m_iVersion;		// // //
 	unsigned char m_iLength;
 	unsigned char m_iEntry[MAX_GROOVE_SIZE];
 };
\ No newline at end of file
@@ -22,6 +22,7 @@
 #pragma once
 
 #include <memory>
+#include "APU/StateArchive.h"		// // //
 
 class CChannelHandlerInterface;
 class CInstrument;
@@ -57,6 +58,13 @@ public:
 		\sa CChannelHandler::CreateInstHandler
 		\sa CChannelHandler::m_bForceReload */
 	virtual void LoadInstrument(std::shared_ptr<CInstrument> pInst) = 0;
+	/*!	\brief Loads a newer copy of the current instrument while a note may be playing.
+		\details The channel handler calls this method when the editor publishes a change to the
+		instrument being played. The default implementation loads the copy as a new instrument;
+		handlers which keep per-note state may override it to carry that state over.
+		\param pInst Pointer to the newer copy of the instrument, of the same type.
+		\sa CFamiTrackerDoc::PublishPlayback */
+	virtual void ReloadInstrument(std::shared_ptr<CInstrument> pInst) { LoadInstrument(pInst); }		// // //
 	/*!	\brief Runs the instrument by one tick and updates the channel state.
 		\details The channel handler calls this method on every tick to allow continuous control of
 		the channel state from the instrument handler. */
@@ -69,6 +77,12 @@ public:
 		\details The method does not specify whether a note can be released for multiple times until
 		another new note is triggered. */
 	virtual void ReleaseInstrument() = 0;
+	/*!	\brief Saves or restores the state of the instrument handler.
+		\details The channel handler loads the same instrument into a new handler before restoring
+		it, so implementations only archive what changes while the instrument plays.
+		\param State The archive.
+		\sa CChannelHandler::SerializeState */
+	virtual void SerializeState(CStateArchive &State) { State(m_iVolume, m_iNoteOffset, m_iPitchOffset); }		// // //
 
 protected:
 	/*!	\brief An interface to the underlying channel handler.
@@ -47,6 +47,7 @@ void CInstHandlerDPCM::TriggerInstrument()
 			pInterface->WriteDCOffset(pDPCMInst->GetSampleDeltaValue(Octave, Note));
 			pInterface->SetLoopOffset(pDPCMInst->GetSampleLoopOffset(Octave, Note));
 			pInterface->PlaySample(pSamp, pDPCMInst->GetSamplePitch(Octave, Note));
+			m_pPlayingInstrument = m_pInstrument;		// // //
 		}
 	}
 }
@@ -58,3 +59,9 @@ void CInstHandlerDPCM::ReleaseInstrument()
 void CInstHandlerDPCM::UpdateInstrument()
 {
 }
+
+void CInstHandlerDPCM::SerializeState(CStateArchive &State)		// // //
+{
+	CInstHandler::SerializeState(State);
+	State.Object(m_pPlayingInstrument);
+}
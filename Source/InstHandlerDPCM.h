@@ -31,4 +31,9 @@ public:
 	void TriggerInstrument() override;
 	void ReleaseInstrument() override;
 	void UpdateInstrument() override;
+	void SerializeState(CStateArchive &State) override;		// // //
+
+private:
+	// // // The APU reads the sample from the instrument copy which triggered it, keep it alive
+	std::shared_ptr<const CInstrument> m_pPlayingInstrument;
 };
@@ -54,6 +54,12 @@ void CInstHandlerOPLL::UpdateInstrument()
 	m_bUpdate = false;
 }
 
+void CInstHandlerOPLL::SerializeState(CStateArchive &State)		// // //
+{
+	CInstHandler::SerializeState(State);
+	State(m_bUpdate);
+}
+
 void CInstHandlerOPLL::UpdateRegs()
 {
 	m_bUpdate = true;
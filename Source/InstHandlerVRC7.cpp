@@ -55,6 +55,12 @@ void CInstHandlerVRC7::UpdateInstrument()
 	m_bUpdate = false;
 }
 
+void CInstHandlerVRC7::SerializeState(CStateArchive &State)		// // //
+{
+	CInstHandler::SerializeState(State);
+	State(m_bUpdate);
+}
+
 void CInstHandlerVRC7::UpdateRegs()
 {
 	m_bUpdate = true;
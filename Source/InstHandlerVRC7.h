@@ -32,6 +32,7 @@ public:
 	void TriggerInstrument() override;
 	void ReleaseInstrument() override;
 	void UpdateInstrument() override;
+	void SerializeState(CStateArchive &State) override;		// // //
 private:
 	void UpdateRegs();
 	bool m_bUpdate = false;
@@ -21,13 +21,17 @@
 #include "stdafx.h"
 #include "InstrumentManagerInterface.h"		// // //
 #include "Instrument.h"
+#include <atomic>		// // //
 
 /*
  * Class CInstrument, base class for instruments
  *
  */
 
-CInstrument::CInstrument(inst_type_t type) : m_iType(type), m_pInstManager(nullptr)		// // //
+// // // Source of instrument versions, shared by every document
+static std::atomic<unsigned long long> NextVersion { 1 };
+
+CInstrument::CInstrument(inst_type_t type) : m_iType(type), m_pInstManager(nullptr), m_iVersion(NextVersion++)		// // //
 {
 	memset(m_cName, 0, INST_NAME_MAX);
 }
@@ -68,8 +72,15 @@ inst_type_t CInstrument::GetType() const		// // //
 	return m_iType;
 }
 
+unsigned long long CInstrument::GetVersion() const		// // //
+{
+	return m_iVersion;
+}
+
 void CInstrument::InstrumentChanged() const
 {
+	m_iVersion = NextVersion++;		// // //
+
 	// Set modified flag
 	if (m_pInstManager)		// // //
 		m_pInstManager->InstrumentChanged();
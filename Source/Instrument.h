@@ -71,6 +71,9 @@ public:
 	virtual bool LoadFile(CInstrumentFile *pFile, int iVersion) = 0;	// Loads from an FTI file
 	virtual int Compile(CChunk *pChunk, int Index) = 0;					// // // Compiles the instrument for NSF generation
 	virtual bool CanRelease() const = 0;
+
+	// // // Changes whenever the instrument is written to, not counting its sequences
+	unsigned long long GetVersion() const;
 protected:
 	virtual void CloneFrom(const CInstrument *pInst);					// // // virtual copying
 	void InstrumentChanged() const;
@@ -80,4 +83,7 @@ protected:
 	char m_cName[INST_NAME_MAX];
 	inst_type_t m_iType;		// // //
 	CInstrumentManagerInterface *m_pInstManager;		// // //
+
+private:
+	mutable unsigned long long m_iVersion;		// // // Set by InstrumentChanged()
 };
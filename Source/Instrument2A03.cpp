@@ -57,6 +57,7 @@ void CInstrument2A03::CloneFrom(const CInstrument *pInst)
 			for (int j = 0; j < NOTE_RANGE; ++j) {
 				SetSampleIndex(i, j, pNew->GetSampleIndex(i, j));
 				SetSamplePitch(i, j, pNew->GetSamplePitch(i, j));
+				SetSampleLoopOffset(i, j, pNew->GetSampleLoopOffset(i, j));		// // //
 				SetSampleDeltaValue(i, j, pNew->GetSampleDeltaValue(i, j));
 			}
 		}
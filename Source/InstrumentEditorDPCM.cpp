@@ -73,7 +73,7 @@ void CDMCFileSoundDialog::OnFileNameChange()
 			ULONGLONG size = file.GetLength();
 			size = std::min<ULONGLONG>(size, CDSample::MAX_SIZE);
 			CDSample *pSample = new CDSample((int)size);
-			file.Read(pSample->GetData(), (int)size);
+			file.Read(pSample->EditData(), (int)size);		// // //
 			theApp.GetSoundGenerator()->PreviewSample(pSample, 0, DEFAULT_PREVIEW_PITCH);
 			file.Close();
 			m_strLastFile = GetPathName();
@@ -284,9 +284,10 @@ bool CInstrumentEditorDPCM::LoadSample(const CString &FilePath, const CString &F
 
 	CDSample *pNewSample = new CDSample(Size + AddSize);
 
-	SampleFile.Read(pNewSample->GetData(), Size);
+	char *pData = pNewSample->EditData();		// // //
+	SampleFile.Read(pData, Size);
 	// Pad uneven sizes with AAh
-	memset(pNewSample->GetData() + Size, 0xAA, AddSize);
+	memset(pData + Size, 0xAA, AddSize);
 
 	pNewSample->SetName(FileName);
 
@@ -80,6 +80,7 @@ void CInstrumentFDS::CloneFrom(const CInstrument *pInst)
 		SetModulationDelay(pNew->GetModulationDelay());
 		SetModulationDepth(pNew->GetModulationDepth());
 		SetModulationSpeed(pNew->GetModulationSpeed());
+		SetModulationEnable(pNew->GetModulationEnable());		// // //
 
 		// Copy sequences
 		for (int i = 0; i < SEQUENCE_COUNT; ++i)		// // //
@@ -436,5 +437,7 @@ CSequence *CInstrumentFDS::GetSequence(int SeqType) const		// // //
 
 void CInstrumentFDS::SetSequence(int SeqType, CSequence *pSeq)
 {
+	if (m_pSequence[SeqType].get() != pSeq)		// // //
+		InstrumentChanged();
 	m_pSequence[SeqType].reset(pSeq);
 }
@@ -35,6 +35,7 @@
 CInstrumentRecorder::CInstrumentRecorder(CSoundGen *pSG) :
 	m_pSoundGen(pSG),
 	m_iRecordChannel(-1),
+	m_iRecordChip(SNDCHIP_NONE),		// // //
 	m_iDumpCount(0),
 	m_iRecordWaveCache(nullptr)
 {
@@ -91,7 +92,8 @@ void CInstrumentRecorder::RecordInstrument(const unsigned Tick, CFamiTrackerView
 	int Detune = 0x7FFFFFFF;
 	int ID = m_iRecordChannel;
 
-	int Chip = m_pDocument->GetChannel(m_pDocument->GetChannelIndex(m_iRecordChannel))->GetChip();
+	// // // Called from the player thread, the document is not read here
+	const int Chip = m_iRecordChip;
 	const auto REG = [&] (int x) { return m_pSoundGen->GetReg(Chip, x); };
 
 	switch (Chip) {
@@ -130,7 +132,7 @@ void CInstrumentRecorder::RecordInstrument(const unsigned Tick, CFamiTrackerView
 
 	CDetuneTable::type_t Table;
 	switch (Chip) {
-		case SNDCHIP_NONE:  case SNDCHIP_5E01: case SNDCHIP_7E02: Table = m_pDocument->GetMachine() == PAL ? CDetuneTable::DETUNE_PAL : CDetuneTable::DETUNE_NTSC; break;
+		case SNDCHIP_NONE:  case SNDCHIP_5E01: case SNDCHIP_7E02: Table = m_pSoundGen->GetMachineType() == PAL ? CDetuneTable::DETUNE_PAL : CDetuneTable::DETUNE_NTSC; break;
 		case SNDCHIP_VRC6:  Table = m_iRecordChannel == CHANID_VRC6_SAWTOOTH ? CDetuneTable::DETUNE_SAW : CDetuneTable::DETUNE_NTSC; break;
 		case SNDCHIP_VRC7:  case SNDCHIP_OPLL: Table = CDetuneTable::DETUNE_VRC7; break;
 		case SNDCHIP_FDS:   Table = CDetuneTable::DETUNE_FDS; break;
@@ -260,9 +262,20 @@ void CInstrumentRecorder::RecordInstrument(const unsigned Tick, CFamiTrackerView
 		FinalizeRecordInstrument();
 }
 
-CInstrument* CInstrumentRecorder::GetRecordInstrument(unsigned Tick) const
+CInstrument* CInstrumentRecorder::GetRecordInstrument(unsigned Tick)		// // //
 {
-	return m_pDumpCache[Tick / m_stRecordSetting.Interval - (m_pSoundGen->IsPlaying() ? 1 : 0)];
+	const unsigned Slot = Tick / m_stRecordSetting.Interval - (m_pSoundGen->IsPlaying() ? 1 : 0);
+	CInstrument *pInst = m_pDumpCache[Slot];
+	auto Inst = dynamic_cast<CSeqInstrument*>(pInst);
+	if (Inst != nullptr && m_pDocument->GetInstrumentCount() < MAX_INSTRUMENTS) {
+		Inst->RegisterManager(m_pDocument->GetInstrumentManager());
+		for (int i = 0; i < SEQ_COUNT; i++)
+			if (m_pDumpSequences[Slot][i]) {
+				Inst->SetSeqIndex(i, m_pDocument->GetFreeSequence(Inst->GetType(), i));
+				Inst->SetSequence(i, m_pDumpSequences[Slot][i].release());
+			}
+	}
+	return pInst;
 }
 
 int CInstrumentRecorder::GetRecordChannel() const
@@ -317,6 +330,9 @@ void CInstrumentRecorder::ResetRecordCache()
 	m_pDumpInstrument = &m_pDumpCache[0];
 	for (int i = 0; i < SEQ_COUNT; i++)
 		m_pSequenceCache[i]->Clear();
+	for (auto &Sequences : m_pDumpSequences)		// // //
+		for (auto &pSeq : Sequences)
+			pSeq.reset();
 }
 
 void CInstrumentRecorder::ReleaseCurrent()
@@ -329,12 +345,15 @@ void CInstrumentRecorder::ReleaseCurrent()
 
 void CInstrumentRecorder::InitRecordInstrument()
 {
-	CTrackerChannel *pChan = m_pDocument->GetChannel(m_pDocument->GetChannelIndex(m_iRecordChannel));
-	if (m_pDocument->GetInstrumentCount() >= MAX_INSTRUMENTS) {
+	// // // Also called from the player thread, so the document is not read here. Sequences
+	// get their indices when the instrument is added, see GetRecordInstrument
+	const CTrackerChannel *pChan = m_pSoundGen->GetTrackerChannel(m_iRecordChannel);
+	if (pChan == nullptr) {
 		m_iDumpCount = 0; m_iRecordChannel = -1; return;
 	}
+	m_iRecordChip = pChan->GetChip();
 	inst_type_t Type = INST_NONE; // optimize this
-	switch (pChan->GetChip()) {
+	switch (m_iRecordChip) {
 	case SNDCHIP_NONE: case SNDCHIP_MMC5: Type = INST_2A03; break;
 	case SNDCHIP_VRC6: Type = INST_VRC6; break;
 	// case SNDCHIP_VRC7: Type = INST_VRC7; break;
@@ -357,10 +376,8 @@ void CInstrumentRecorder::InitRecordInstrument()
 	case INST_2A03: case INST_VRC6: case INST_N163: case INST_S5B:
 		CSeqInstrument *Inst = dynamic_cast<CSeqInstrument*>(*m_pDumpInstrument);
 		ASSERT(Inst != NULL);
-		for (int i = 0; i < SEQ_COUNT; i++) {
+		for (int i = 0; i < SEQ_COUNT; i++)
 			Inst->SetSeqEnable(i, 1);
-			Inst->SetSeqIndex(i, m_pDocument->GetFreeSequence(Type, i));
-		}
 		m_pSequenceCache[SEQ_ARPEGGIO]->SetSetting(SETTING_ARP_FIXED);
 		// m_pSequenceCache[SEQ_PITCH]->SetSetting(SETTING_PITCH_ABSOLUTE);
 		// m_pSequenceCache[SEQ_HIPITCH]->SetSetting(SETTING_PITCH_ABSOLUTE);
@@ -381,13 +398,16 @@ void CInstrumentRecorder::FinalizeRecordInstrument()
 	CInstrumentFDS *FDSInst = dynamic_cast<CInstrumentFDS*>(*m_pDumpInstrument);
 	CInstrumentN163 *N163Inst = dynamic_cast<CInstrumentN163*>(*m_pDumpInstrument);
 	if (Inst != NULL) {
-		(*m_pDumpInstrument)->RegisterManager(m_pDocument->GetInstrumentManager());
+		// // // Kept until GetRecordInstrument, since the document must not be written here
+		const auto Slot = m_pDumpInstrument - m_pDumpCache;
 		for (int i = 0; i < SEQ_COUNT; i++) {
 			if (Inst->GetSeqEnable(i) != 0) {
 				m_pSequenceCache[i]->SetLoopPoint(m_pSequenceCache[i]->GetItemCount() - 1);
-				Inst->SetSequence(i, m_pSequenceCache[i]);
+				m_pDumpSequences[Slot][i].reset(m_pSequenceCache[i]);
+				m_pSequenceCache[i] = new CSequence();
 			}
-			m_pSequenceCache[i] = new CSequence();
+			else
+				m_pSequenceCache[i]->Clear();
 		}
 	}
 	switch (InstType) {
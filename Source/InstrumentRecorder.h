@@ -22,6 +22,7 @@
 #pragma once
 
 #include "FamiTrackerTypes.h"
+#include <memory>		// // //
 
 class CSequence;
 class CInstrument;
@@ -46,7 +47,8 @@ public:
 	void			StopRecording(CFamiTrackerView *pView);
 	void			RecordInstrument(const unsigned Tick, CFamiTrackerView *pView);
 
-	CInstrument		*GetRecordInstrument(unsigned Tick) const;
+	// // // Adds the recorded sequences to the document, call from the main thread only
+	CInstrument		*GetRecordInstrument(unsigned Tick);
 	int				GetRecordChannel() const;
 	void			SetRecordChannel(int Channel);;
 	stRecordSetting *GetRecordSetting() const;;
@@ -67,10 +69,13 @@ public:
 private:
 	CSoundGen		*m_pSoundGen;
 	int				m_iRecordChannel;
+	int				m_iRecordChip;		// // // Chip of the recorded channel
 	int				m_iDumpCount;
 	CInstrument		**m_pDumpInstrument;
 	CInstrument		*m_pDumpCache[MAX_INSTRUMENTS];
 	CSequence		*m_pSequenceCache[SEQ_COUNT];
+	// // // Finished sequences of each recorded instrument, stored in the document by GetRecordInstrument
+	std::unique_ptr<CSequence> m_pDumpSequences[MAX_INSTRUMENTS][SEQ_COUNT];
 	stRecordSetting	m_stRecordSetting;
 	char			*m_iRecordWaveCache;
 	int				m_iRecordWaveSize;
@@ -81,6 +81,7 @@ void CInstrumentSID::CloneFrom(const CInstrument *pInst)
 		SetFilterEnd(pNew->GetFilterEnd());
 		SetFilterSpeed(pNew->GetFilterSpeed());
 		SetFilterMode(pNew->GetFilterMode());
+		SetFilterPass(pNew->GetFilterPass());		// // //
 
 	}
 }
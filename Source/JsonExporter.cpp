@@ -231,7 +231,7 @@ void to_json(json& j, const CDSample& dpcm) {
 //		{"samples", json::array()},
 		{"values", json::array()},
 	};
-	char* data = dpcm.GetData();
+	const char* data = dpcm.GetData();
 	if (data != nullptr)
 	{
 		for (std::size_t i = 0, n = dpcm.GetSize(); i < n; ++i)
@@ -0,0 +1,209 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+#include "stdafx.h"
+#include "LiveNoteRouter.h"
+#include "MIDI.h"
+
+void CLiveNoteRouter::SetRoute(const stLiveNoteRoute &Route)
+{
+	std::lock_guard<std::mutex> Lock(m_Lock);
+	m_Route = Route;
+}
+
+void CLiveNoteRouter::SetNoteQueue(CNoteQueue &&Queue)
+{
+	std::lock_guard<std::mutex> Lock(m_Lock);
+	m_NoteQueue = std::move(Queue);
+}
+
+void CLiveNoteRouter::SetLastNote(unsigned MidiNote)
+{
+	std::lock_guard<std::mutex> Lock(m_Lock);
+	m_iLastMidiNote = MidiNote;
+}
+
+bool CLiveNoteRouter::Trigger(unsigned Channel, unsigned Note, unsigned Octave, unsigned Velocity, stRoutedNote &Routed)
+{
+	std::lock_guard<std::mutex> Lock(m_Lock);
+	return TriggerImpl(Channel, Note, Octave, Velocity, Routed);
+}
+
+bool CLiveNoteRouter::Cut(unsigned Channel, unsigned Note, unsigned Octave, unsigned Value, stRoutedNote &Routed)
+{
+	std::lock_guard<std::mutex> Lock(m_Lock);
+	return CutImpl(Channel, Note, Octave, Value, Routed);
+}
+
+std::vector<int> CLiveNoteRouter::StopChannel(unsigned Channel)
+{
+	std::lock_guard<std::mutex> Lock(m_Lock);
+	std::vector<int> Channels;
+	if (Channel < static_cast<unsigned>(m_Route.iChannelCount))
+		for (const auto &i : m_NoteQueue.StopChannel(m_Route.iChannelType[Channel])) {
+			int ch = GetChannelIndex(i);
+			if (ch != -1)
+				Channels.push_back(ch);
+		}
+	return Channels;
+}
+
+bool CLiveNoteRouter::RouteMidiMessage(unsigned char Message, unsigned char MsgChannel, unsigned char Data1, unsigned char Data2,
+									   stRoutedNote *pNotes, int &Count)
+{
+	// Same as CFamiTrackerView::TranslateMidiMessage and the MIDI note functions, without the pattern input
+	std::lock_guard<std::mutex> Lock(m_Lock);
+	Count = 0;
+
+	if (!m_Route.bMidiThread)
+		return false;
+
+	unsigned Channel = MsgChannel;
+	if (!m_Route.bChannelMap)
+		Channel = m_Route.iCursorChannel;
+	if (static_cast<int>(Channel) > m_Route.iAvailableChannels - 1)
+		Channel = m_Route.iAvailableChannels - 1;
+
+	if (Message == MIDI_MSG_NOTE_ON && Data2 == 0)
+		Message = MIDI_MSG_NOTE_OFF;
+
+	Data1 -= 24;
+	if (Data1 > 127)
+		return true;
+
+	unsigned MidiNote = Data1;
+	if (MidiNote >= NOTE_COUNT) MidiNote = NOTE_COUNT - 1;
+	unsigned Octave = GET_OCTAVE(MidiNote);
+	unsigned Note = GET_NOTE(MidiNote);
+
+	switch (Message) {
+	case MIDI_MSG_NOTE_ON:
+	{
+		unsigned Velocity = Data2;
+		if (!m_Route.bMidiVelocity)
+			Velocity = m_Route.bITEditStyle ? m_Route.iLastVolume * 8 : 127;
+		if (m_Route.bPreview && TriggerImpl(Channel, Note, Octave, Velocity, pNotes[Count]))
+			++Count;
+		m_iLastMidiNote = MidiNote;
+		return true;
+	}
+	case MIDI_MSG_NOTE_OFF:
+	{
+		const unsigned Value = m_Route.bRelease ? RELEASE : HALT;
+		if (m_Route.bPreview && (!m_Route.bEditEnable || m_iLastMidiNote == MidiNote))
+			if (CutImpl(Channel, Note, Octave, Value, pNotes[Count]))
+				++Count;
+		if (m_Route.bITEditStyle)
+			if (CutImpl(Channel, Note, Octave, Value, pNotes[Count]))
+				++Count;
+		return true;
+	}
+	}
+
+	return false;
+}
+
+int CLiveNoteRouter::GetChannelIndex(int ChanID) const
+{
+	for (int i = 0; i < m_Route.iChannelCount; ++i)
+		if (m_Route.iChannelType[i] == ChanID)
+			return i;
+	return -1;
+}
+
+bool CLiveNoteRouter::IsSplitEnabled(int MidiNote, int Channel) const
+{
+	if (m_Route.iSplitNote == -1)
+		return false;
+	if (Channel >= 0 && Channel < m_Route.iChannelCount) {
+		const int ID = m_Route.iChannelType[Channel];
+		if (ID == CHANID_2A03_NOISE || ID == CHANID_5E01_NOISE || ID == CHANID_7E02_NOISE)
+			return false;
+		return MidiNote <= m_Route.iSplitNote;
+	}
+	return false;
+}
+
+void CLiveNoteRouter::SplitKeyboardAdjust(stChanNote &Note) const
+{
+	ASSERT(Note.Note >= NOTE_C && Note.Note <= NOTE_B);
+	int MidiNote = MIDI_NOTE(Note.Octave, Note.Note) + m_Route.iSplitTranspose;
+	if (MidiNote < 0) MidiNote = 0;
+	if (MidiNote >= NOTE_COUNT) MidiNote = NOTE_COUNT - 1;
+	Note.Octave = GET_OCTAVE(MidiNote);
+	Note.Note = GET_NOTE(MidiNote);
+
+	if (m_Route.iSplitInstrument != MAX_INSTRUMENTS)
+		Note.Instrument = m_Route.iSplitInstrument;
+}
+
+void CLiveNoteRouter::SplitAdjustChannel(unsigned &Channel, const stChanNote &Note) const
+{
+	if (m_Route.bEditEnable || m_Route.iSplitChannel == -1) return;
+	if (m_Route.iSplitNote != -1 && MIDI_NOTE(Note.Octave, Note.Note) <= m_Route.iSplitNote) {
+		int Index = GetChannelIndex(m_Route.iSplitChannel);
+		if (Index != -1) Channel = Index;
+	}
+}
+
+bool CLiveNoteRouter::TriggerImpl(unsigned Channel, unsigned Note, unsigned Octave, unsigned Velocity, stRoutedNote &Routed)
+{
+	stChanNote NoteData { };
+
+	NoteData.Note		= Note;
+	NoteData.Octave		= Octave;
+	NoteData.Instrument	= m_Route.iInstrument;
+	if (m_Route.bMidiVelocity)
+		NoteData.Vol = Velocity / 8;
+
+	int MidiNote = MIDI_NOTE(Octave, Note);
+
+	SplitAdjustChannel(Channel, NoteData);
+	if (Channel < static_cast<unsigned>(m_Route.iChannelCount)) {
+		int ret = GetChannelIndex(m_NoteQueue.Trigger(MidiNote, m_Route.iChannelType[Channel]));
+		if (ret != -1) {
+			if (IsSplitEnabled(MidiNote, ret))
+				SplitKeyboardAdjust(NoteData);
+			Routed = stRoutedNote {m_Route.iChannelType[ret], ret, NoteData, true};
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool CLiveNoteRouter::CutImpl(unsigned Channel, unsigned Note, unsigned Octave, unsigned Value, stRoutedNote &Routed)
+{
+	stChanNote NoteData { };
+
+	NoteData.Note = Value;
+	NoteData.Instrument = m_Route.iInstrument;
+
+	SplitAdjustChannel(Channel, NoteData);
+	if (Channel < static_cast<unsigned>(m_Route.iChannelCount)) {
+		int ch = GetChannelIndex(m_NoteQueue.Cut(MIDI_NOTE(Octave, Note), m_Route.iChannelType[Channel]));
+		if (ch != -1) {
+			Routed = stRoutedNote {m_Route.iChannelType[ch], ch, NoteData, false};
+			return true;
+		}
+	}
+
+	return false;
+}
@@ -0,0 +1,129 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#pragma once
+
+#include <mutex>
+#include <cstdint>
+#include "APU/Types.h"
+#include "PatternNote.h"
+#include "NoteQueue.h"
+
+/*!
+	\brief The view state that decides where a live note is played. The view publishes a copy
+	whenever it may have changed, so that MIDI input can be played without the view.
+*/
+struct stLiveNoteRoute
+{
+	bool bMidiThread = false;		// MIDI notes may be played from the input thread
+	bool bPreview = false;			// Notes are played, not only recorded during playback
+	bool bEditEnable = false;
+	bool bChannelMap = false;		// MIDI channels select tracks
+	bool bMidiVelocity = false;
+	bool bITEditStyle = false;
+	bool bRelease = false;			// The selected instrument has a release sequence
+	int iCursorChannel = 0;
+	int iAvailableChannels = 0;
+	unsigned iInstrument = 0;
+	int iLastVolume = MAX_VOLUME;
+	int iSplitNote = -1;
+	int iSplitChannel = -1;			// Channel ID, -1 if notes stay on their track
+	unsigned iSplitInstrument = MAX_INSTRUMENTS;
+	int iSplitTranspose = 0;
+	int iChannelCount = 0;
+	int iChannelType[CHANNELS] = { };
+};
+
+/*!
+	\brief A note chosen for a physical channel by the router.
+*/
+struct stRoutedNote
+{
+	int ChanID;
+	int Channel;		// Track index
+	stChanNote Note;
+	bool ForceReload;	// Reload the instrument, for note-ons
+};
+
+/*!
+	\brief Picks the physical channel and note data for notes played live from the keyboard or MIDI.
+	\details The note queue and the last published route are guarded by one lock, so notes may be
+	routed from both the main thread and the MIDI input thread.
+*/
+class CLiveNoteRouter
+{
+public:
+	/*!	\brief Publishes the view state used to route notes.
+		\param Route The new route. */
+	void SetRoute(const stLiveNoteRoute &Route);
+	/*!	\brief Replaces the note queue, after the channel layout or edit mode changes.
+		\param Queue The new note queue. */
+	void SetNoteQueue(CNoteQueue &&Queue);
+	/*!	\brief Records the last MIDI note triggered, which alone may be cut in edit mode.
+		\param MidiNote The MIDI note number. */
+	void SetLastNote(unsigned MidiNote);
+
+	/*!	\brief Routes a note-on.
+		\param Channel The track index the note was played on.
+		\param Note The note value.
+		\param Octave The octave.
+		\param Velocity The velocity, after the volume settings have been applied.
+		\param Routed Receives the routed note.
+		\return True if a channel plays the note. */
+	bool Trigger(unsigned Channel, unsigned Note, unsigned Octave, unsigned Velocity, stRoutedNote &Routed);
+	/*!	\brief Routes a note-off.
+		\param Channel The track index the note was played on.
+		\param Note The note value.
+		\param Octave The octave.
+		\param Value Either HALT or RELEASE.
+		\param Routed Receives the routed note.
+		\return True if a channel stops playing the note. */
+	bool Cut(unsigned Channel, unsigned Note, unsigned Octave, unsigned Value, stRoutedNote &Routed);
+	/*!	\brief Stops every note played from a track.
+		\param Channel The track index.
+		\return The track indices of the physical channels that were playing. */
+	std::vector<int> StopChannel(unsigned Channel);
+
+	/*!	\brief Plays a MIDI note message from the MIDI input thread, as the view would.
+		\param Message The message type, MIDI_MSG_NOTE_ON or MIDI_MSG_NOTE_OFF.
+		\param MsgChannel The MIDI channel.
+		\param Data1 The note number.
+		\param Data2 The velocity.
+		\param pNotes Receives up to two routed notes.
+		\param Count Receives the number of routed notes.
+		\return True if the message was handled, false if the view must play it itself. */
+	bool RouteMidiMessage(unsigned char Message, unsigned char MsgChannel, unsigned char Data1, unsigned char Data2,
+						  stRoutedNote *pNotes, int &Count);
+
+private:
+	int GetChannelIndex(int ChanID) const;
+	bool IsSplitEnabled(int MidiNote, int Channel) const;
+	void SplitKeyboardAdjust(stChanNote &Note) const;
+	void SplitAdjustChannel(unsigned &Channel, const stChanNote &Note) const;
+	bool TriggerImpl(unsigned Channel, unsigned Note, unsigned Octave, unsigned Velocity, stRoutedNote &Routed);
+	bool CutImpl(unsigned Channel, unsigned Note, unsigned Octave, unsigned Value, stRoutedNote &Routed);
+
+private:
+	std::mutex m_Lock;
+	stLiveNoteRoute m_Route;
+	CNoteQueue m_NoteQueue;
+	unsigned m_iLastMidiNote = 0;
+};
@@ -0,0 +1,63 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+#include "LiveNoteScheduler.h"
+#include <chrono>
+
+std::int64_t CLiveNoteScheduler::Now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+CLiveNoteScheduler::CLiveNoteScheduler() :
+	m_iTickCycles(1),
+	m_iTickLength(1),
+	m_iWindowStart(0)
+{
+}
+
+void CLiveNoteScheduler::SetTickLength(std::uint32_t Cycles, std::uint32_t ClockRate)
+{
+	m_iTickCycles = Cycles ? Cycles : 1;
+	m_iTickLength = ClockRate ? static_cast<std::int64_t>(m_iTickCycles) * 1000000 / ClockRate : 1;
+	if (m_iTickLength < 1)
+		m_iTickLength = 1;
+}
+
+void CLiveNoteScheduler::BeginTick(std::int64_t Time)
+{
+	m_iWindowStart = Time - m_iTickLength;
+}
+
+std::uint32_t CLiveNoteScheduler::Place(std::int64_t Time) const
+{
+	const std::int64_t Offset = Time - m_iWindowStart;
+	if (Offset <= 0)
+		return 0;		// Late, play it right away
+	if (Offset >= m_iTickLength)
+		return m_iTickCycles - 1;		// Stamped after the tick started
+	return static_cast<std::uint32_t>(Offset * m_iTickCycles / m_iTickLength);
+}
+
+std::int64_t CLiveNoteScheduler::GetTickLength() const
+{
+	return m_iTickLength;
+}
@@ -0,0 +1,66 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#pragma once
+
+#include <cstdint>
+
+/*!
+	\brief Places live input events at a CPU cycle within the tick that plays them.
+	\details Input events are stamped with Now() when they arrive. The sound thread calls
+	BeginTick() when it starts emulating a tick, and every event stamped during the tick length
+	before that point is placed at the same relative position within the tick. Each event is
+	therefore delayed by exactly one tick length, instead of waiting for whatever remains of the
+	current tick; this removes up to a full tick of jitter between events at the cost of a constant
+	delay. Events older than that are late and go at the start of the tick.
+*/
+class CLiveNoteScheduler
+{
+public:
+	/*!	\brief Obtains the current time on the clock used to stamp input events.
+		\return A monotonic time in microseconds. */
+	static std::int64_t Now();
+
+	CLiveNoteScheduler();
+
+	/*!	\brief Sets the length of a tick.
+		\param Cycles The number of CPU cycles emulated per tick.
+		\param ClockRate The CPU clock rate, in Hz. */
+	void SetTickLength(std::uint32_t Cycles, std::uint32_t ClockRate);
+
+	/*!	\brief Starts placing the events of a new tick.
+		\param Time The time at which emulation of the tick starts, from Now(). */
+	void BeginTick(std::int64_t Time);
+
+	/*!	\brief Places an input event within the current tick.
+		\param Time The time stamp of the event, from Now().
+		\return The cycle offset from the start of the tick, less than the tick length. */
+	std::uint32_t Place(std::int64_t Time) const;
+
+	/*!	\brief Obtains the length of a tick.
+		\return The tick length in microseconds. */
+	std::int64_t GetTickLength() const;
+
+private:
+	std::uint32_t m_iTickCycles;
+	std::int64_t m_iTickLength;		// Microseconds
+	std::int64_t m_iWindowStart;	// Events stamped at this time are placed at cycle 0
+};
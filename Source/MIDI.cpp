@@ -23,6 +23,9 @@
 #include "PatternNote.h"		// // //
 #include "FamiTrackerViewMessage.h"		// // //
 #include "MIDI.h"
+#include "LiveNoteScheduler.h"		// // //
+#include "LiveNoteRouter.h"		// // //
+#include "SoundGen.h"		// // //
 #include "Settings.h"
 
 /*
@@ -58,7 +61,8 @@ CMIDI::CMIDI() :
 	m_MidiQueue(MAX_QUEUE),
 	m_hMIDIIn(NULL),
 	m_hMIDIOut(NULL),
-	m_iTimingCounter(0)
+	m_iTimingCounter(0),
+	m_pLiveNoteRouter(std::make_unique<CLiveNoteRouter>())		// // //
 {
 	// Allow only one single midi object
 	ASSERT( m_pInstance == NULL );
@@ -207,7 +211,7 @@ void CMIDI::SetOutputDevice(int Device)
 	OpenDevices();
 }
 
-void CMIDI::Enqueue(unsigned char MsgType, unsigned char MsgChannel, unsigned char Data1, unsigned char Data2)
+void CMIDI::Enqueue(unsigned char MsgType, unsigned char MsgChannel, unsigned char Data1, unsigned char Data2, std::int64_t Time, bool Played)		// // //
 {
 	// Ehh, dropped events are fine I guess...
 	(void) m_MidiQueue.try_push(MidiMessage{
@@ -216,6 +220,8 @@ void CMIDI::Enqueue(unsigned char MsgType, unsigned char MsgChannel, unsigned ch
 		(char)Data1,
 		(char)Data2,
 		(char)m_iTimingCounter,
+		Time,		// // //
+		Played,
 	});
 }
 
@@ -235,7 +241,7 @@ void CMIDI::Event(unsigned char Status, unsigned char Data1, unsigned char Data2
 		if (m_bMasterSync) {
 			if (++m_iTimingCounter == 6) {
 				m_iTimingCounter = 0;
-				Enqueue(MsgType, MsgChannel, Data1, Data2);
+				Enqueue(MsgType, MsgChannel, Data1, Data2, CLiveNoteScheduler::Now(), false);		// // //
 				pView->PostMessage(WM_USER_MIDI_EVENT);
 			}
 		}
@@ -250,15 +256,29 @@ void CMIDI::Event(unsigned char Status, unsigned char Data1, unsigned char Data2
 		switch (MsgType) {
 			case MIDI_MSG_NOTE_OFF:
 			case MIDI_MSG_NOTE_ON:
+			{
+				// // // The callback runs as the message arrives, so play the note from here
+				// instead of waiting for the view. The view still reads it for pattern input.
+				const std::int64_t Time = CLiveNoteScheduler::Now();
+				stRoutedNote Notes[2];
+				int Count = 0;
+				const bool Played = m_pLiveNoteRouter->RouteMidiMessage(MsgType, MsgChannel, Data1, Data2, Notes, Count);
+				if (CSoundGen *pSoundGen = theApp.GetSoundGenerator())
+					for (int i = 0; i < Count; ++i)
+						pSoundGen->QueueMidiLiveNote(Notes[i], Time);
+				Enqueue(MsgType, MsgChannel, Data1, Data2, Time, Played);
+				pView->PostMessage(WM_USER_MIDI_EVENT);
+				break;
+			}
 			case MIDI_MSG_PITCH_WHEEL:
-				Enqueue(MsgType, MsgChannel, Data1, Data2);
+				Enqueue(MsgType, MsgChannel, Data1, Data2, CLiveNoteScheduler::Now(), false);		// // //
 				pView->PostMessage(WM_USER_MIDI_EVENT);
 				break;
 		}
 	}
 }
 
-bool CMIDI::ReadMessage(unsigned char & Message, unsigned char & Channel, unsigned char & Data1, unsigned char & Data2)
+bool CMIDI::ReadMessage(unsigned char & Message, unsigned char & Channel, unsigned char & Data1, unsigned char & Data2, std::int64_t & Time, bool & Played)		// // //
 {
 	bool Result = false;
 
@@ -270,6 +290,8 @@ bool CMIDI::ReadMessage(unsigned char & Message, unsigned char & Channel, unsign
 		Data1	= pMidiMessage->Data1;
 		Data2	= pMidiMessage->Data2;
 		m_iQuant = pMidiMessage->Quantization;
+		Time	= pMidiMessage->Time;		// // //
+		Played	= pMidiMessage->Played;
 
 		m_MidiQueue.pop();
 	}
@@ -282,6 +304,11 @@ int CMIDI::GetQuantization() const
 	return m_iQuant;
 }
 
+CLiveNoteRouter *CMIDI::GetLiveNoteRouter() const		// // //
+{
+	return m_pLiveNoteRouter.get();
+}
+
 void CMIDI::ToggleInput()
 {
 	if (m_bInStarted)
@@ -21,8 +21,12 @@
 #pragma once
 
 #include <mmsystem.h>
+#include <cstdint>
+#include <memory>
 #include "rigtorp/SPSCQueue.h"
 
+class CLiveNoteRouter;		// // //
+
 const int MIDI_MSG_NOTE_OFF			= 0x08;
 const int MIDI_MSG_NOTE_ON			= 0x09;
 const int MIDI_MSG_AFTER_TOUCH		= 0x0A;
@@ -39,6 +43,8 @@ struct MidiMessage {
 	char Data1;
 	char Data2;
 	char Quantization;
+	std::int64_t Time;		// // // Arrival time, from CLiveNoteScheduler::Now()
+	bool Played;			// // // Already played from the input thread
 };
 
 class CMIDI : public CObject
@@ -53,12 +59,13 @@ public:
 	bool	OpenDevices(void);
 	bool	CloseDevices(void);
 
-	bool	ReadMessage(unsigned char & Message, unsigned char & Channel, unsigned char & Data1, unsigned char & Data2);
+	bool	ReadMessage(unsigned char & Message, unsigned char & Channel, unsigned char & Data1, unsigned char & Data2, std::int64_t & Time, bool & Played);		// // //
 	void	WriteNote(unsigned char Channel, unsigned char Note, unsigned char Octave, unsigned char Velocity);
 	void	ResetOutput();
 	void	ToggleInput();
 
 	int		GetQuantization() const;
+	CLiveNoteRouter	*GetLiveNoteRouter() const;		// // //
 
 	bool	IsOpened() const;
 	bool	IsAvailable() const;
@@ -79,7 +86,7 @@ public:
 	// Private methods
 private:
 	void	Event(unsigned char Status, unsigned char Data1, unsigned char Data2);
-	void	Enqueue(unsigned char MsgType, unsigned char MsgChannel, unsigned char Data1, unsigned char Data2);
+	void	Enqueue(unsigned char MsgType, unsigned char MsgChannel, unsigned char Data1, unsigned char Data2, std::int64_t Time, bool Played);		// // //
 
 	// Constants
 private:
@@ -105,6 +112,9 @@ private:
 	int		m_iQuant;
 	int		m_iTimingCounter;
 
+	// // // Routes notes played live, shared with the view
+	std::unique_ptr<CLiveNoteRouter> m_pLiveNoteRouter;
+
 	// Device handles
 	HMIDIIN	 m_hMIDIIn;
 	HMIDIOUT m_hMIDIOut;
@@ -830,6 +830,7 @@ void CMainFrame::SetTempo(int Tempo)
 	Tempo = std::max(Tempo, MinTempo);
 	Tempo = std::min(Tempo, MAX_TEMPO);
 	pDoc->SetSongTempo(m_iTrack, Tempo);
+	pDoc->PublishPlayback();		// // // The player reads the speed from the published track
 	theApp.GetSoundGenerator()->ResetTempo();
 
 	if (m_wndDialogBar.GetDlgItemInt(IDC_TEMPO) != Tempo)
@@ -849,6 +850,7 @@ void CMainFrame::SetSpeed(int Speed)
 		Speed = std::min(Speed, MaxSpeed);		// // //
 	}
 	pDoc->SetSongSpeed(m_iTrack, Speed);
+	pDoc->PublishPlayback();		// // // The player reads the speed from the published track
 	theApp.GetSoundGenerator()->ResetTempo();
 
 	if (m_wndDialogBar.GetDlgItemInt(IDC_SPEED) != Speed)
@@ -1013,6 +1015,9 @@ void CMainFrame::SelectInstrument(int Index)
 
 	// Save selected instrument
 	m_iInstrument = Index;
+
+	if (auto pView = static_cast<CFamiTrackerView*>(GetActiveView()))		// // //
+		pView->PublishLiveNoteRoute();
 }
 
 int CMainFrame::GetSelectedInstrument() const
@@ -2967,9 +2972,9 @@ bool CMainFrame::AddAction(Action *pAction)
 
 	// Add action to history.
 	CFamiTrackerDoc	*pDoc = (CFamiTrackerDoc*)GetActiveDocument();			// // //
-	if (m_history->GetUndoLevel() == History::MAX_LEVELS)
+	pDoc->PublishPlayback();		// // //
+	if (m_history->Push(pAction))		// // //
 		pDoc->SetExceededFlag();
-	m_history->Push(pAction);
 
 	return true;
 }
@@ -2999,6 +3004,7 @@ void CMainFrame::OnEditUndo()
 	}
 
 	CFamiTrackerDoc	*pDoc = (CFamiTrackerDoc*)GetActiveDocument();			// // //
+	pDoc->PublishPlayback();		// // //
 	if (!m_history->CanUndo() && !pDoc->GetExceededFlag())
 		pDoc->SetModifiedFlag(false);
 }
@@ -3011,6 +3017,7 @@ void CMainFrame::OnEditRedo()
 		pAction->RestoreUndoState(this);		// // //
 		pAction->Redo(this);
 		pAction->RestoreRedoState(this);		// // //
+		static_cast<CFamiTrackerDoc*>(GetActiveDocument())->PublishPlayback();		// // //
 	}
 }
 
@@ -26,6 +26,7 @@
 #include "MainFrm.h"
 #include "PatternEditor.h"
 #include "PatternAction.h"
+#include <type_traits>		// // //
 
 // // // Pattern editor state class
 
@@ -53,6 +54,34 @@ void CPatternEditorState::ApplyState(CPatternEditor *pEditor) const
 // // // for note writes
 #define STATE_EXPAND(st) (st)->Track, (st)->Cursor.m_iFrame, (st)->Cursor.m_iChannel, (st)->Cursor.m_iRow
 
+namespace {
+
+// // // Journal key of a pattern cell, ordered by channel so that consecutive rows differ by 1
+std::uint32_t CellKey(int Frame, int Channel, int Row)
+{
+	return (static_cast<std::uint32_t>(Channel) * MAX_FRAMES + Frame) * MAX_PATTERN_LENGTH + Row;
+}
+
+int KeyFrame(std::uint32_t Key)
+{
+	return Key / MAX_PATTERN_LENGTH % MAX_FRAMES;
+}
+
+int KeyChannel(std::uint32_t Key)
+{
+	return Key / MAX_PATTERN_LENGTH / MAX_FRAMES;
+}
+
+int KeyRow(std::uint32_t Key)
+{
+	return Key % MAX_PATTERN_LENGTH;
+}
+
+static_assert(std::is_trivially_copyable<stChanNote>::value, "Journal cells are copied as bytes");
+static_assert(sizeof(stChanNote) <= CUndoJournal::MAX_CELL_SIZE, "stChanNote does not fit in a journal cell");
+
+} // namespace
+
 CPatternAction::CPatternAction(int iAction) : 
 	Action(iAction),
 	m_pUndoState(nullptr),
@@ -366,6 +395,16 @@ void CPatternAction::Undo(CMainFrame *pMainFrm) const
 	}
 }
 
+std::size_t CPatternAction::GetMemorySize() const		// // //
+{
+	std::size_t Size = Action::GetMemorySize();
+	for (const CPatternClipData *pClip : {m_pClipData, static_cast<const CPatternClipData*>(m_pUndoClipData),
+		static_cast<const CPatternClipData*>(m_pAuxiliaryClipData)})
+		if (pClip)
+			Size += pClip->GetAllocSize();
+	return Size;
+}
+
 void CPatternAction::Redo(CMainFrame *pMainFrm) const
 {
 	CFamiTrackerView *pView = static_cast<CFamiTrackerView*>(pMainFrm->GetActiveView());
@@ -392,26 +431,132 @@ void CPatternAction::Redo(CMainFrame *pMainFrm) const
 
 
 CPSelectionAction::CPSelectionAction(int iAction) :
-	CPatternAction(iAction), m_pUndoClipData(nullptr)
+	CPatternAction(iAction), m_pUndoClipData(nullptr),
+	m_bHasAfter(false), m_pJournal(nullptr), m_hCells(CUndoJournal::NO_ENTRY)		// // //
 {
 }
 
 CPSelectionAction::~CPSelectionAction()
 {
 	SAFE_RELEASE(m_pUndoClipData);
+	if (m_pJournal)		// // //
+		m_pJournal->Release(m_hCells);
 }
 
 bool CPSelectionAction::SaveState(const CMainFrame *pMainFrm)
 {
-	const CPatternEditor *pPatternEditor = static_cast<CFamiTrackerView*>(pMainFrm->GetActiveView())->GetPatternEditor();
-	m_pUndoClipData = pPatternEditor->CopyRaw(m_pUndoState->Selection);
+	CFamiTrackerView *pView = static_cast<CFamiTrackerView*>(pMainFrm->GetActiveView());
+	const CPatternEditor *pPatternEditor = pView->GetPatternEditor();
+
+	// // // The edit reads the selection, or only the cursor cell when nothing is selected
+	CSelection Sel = m_pUndoState->Selection;
+	if (!m_pUndoState->IsSelecting)
+		Sel.m_cpStart = Sel.m_cpEnd = m_pUndoState->Cursor;
+	m_pUndoClipData = pPatternEditor->CopyRaw(Sel);
+
+	// // // Every cell the edit may write
+	CFamiTrackerDoc *pDoc = pView->GetDocument();
+	const int Track = m_pUndoState->Track;
+	const int Frames = pDoc->GetFrameCount(Track);
+	auto it = GetIterators(pMainFrm);
+	do for (int i = it.first.m_iChannel; i <= it.second.m_iChannel; ++i) {
+		const int Frame = (it.first.m_iFrame % Frames + Frames) % Frames;
+		stCell Cell;
+		Cell.Key = CellKey(Frame, i, it.first.m_iRow);
+		it.first.Get(i, &Cell.Before);
+		m_Cells.push_back(Cell);
+	} while (++it.first <= it.second);
+
 	return true;
 }
 
 void CPSelectionAction::Undo(CMainFrame *pMainFrm) const
 {
-	CPatternEditor *pPatternEditor = static_cast<CFamiTrackerView*>(pMainFrm->GetActiveView())->GetPatternEditor();
-	pPatternEditor->PasteRaw(m_pUndoClipData, m_pUndoState->Selection.m_cpStart);
+	if (m_pJournal) {		// // //
+		ReplayCells(pMainFrm, false);
+		return;
+	}
+	// // // Not in the history yet, e.g. the edit failed
+	CFamiTrackerDoc *pDoc = static_cast<CFamiTrackerView*>(pMainFrm->GetActiveView())->GetDocument();
+	for (const auto &Cell : m_Cells) {
+		stChanNote Note = Cell.Before;
+		pDoc->SetNoteData(m_pUndoState->Track, KeyFrame(Cell.Key), KeyChannel(Cell.Key), KeyRow(Cell.Key), &Note);
+	}
+}
+
+void CPSelectionAction::Redo(CMainFrame *pMainFrm) const		// // //
+{
+	if (m_pJournal) {
+		ReplayCells(pMainFrm, true);
+		return;
+	}
+	Perform(pMainFrm);
+
+	// The cells after the edit are read here rather than in SaveRedoState, which only the last
+	// action of a compound action receives; the clip is not needed past this point
+	const CFamiTrackerDoc *pDoc = static_cast<CFamiTrackerView*>(pMainFrm->GetActiveView())->GetDocument();
+	for (auto &Cell : m_Cells)
+		pDoc->GetNoteData(m_pUndoState->Track, KeyFrame(Cell.Key), KeyChannel(Cell.Key), KeyRow(Cell.Key), &Cell.After);
+	m_bHasAfter = true;
+	SAFE_RELEASE(m_pUndoClipData);
+}
+
+void CPSelectionAction::Compact(CUndoJournal &Journal)		// // //
+{
+	if (!m_bHasAfter)
+		return;
+	Journal.Begin(sizeof(stChanNote));
+	RecordCells(Journal);
+	m_hCells = Journal.Commit();
+	m_pJournal = &Journal;
+
+	std::vector<stCell>().swap(m_Cells);
+}
+
+std::size_t CPSelectionAction::GetMemorySize() const		// // //
+{
+	std::size_t Size = CPatternAction::GetMemorySize() + m_Cells.capacity() * sizeof(stCell);
+	if (m_pUndoClipData)
+		Size += m_pUndoClipData->GetAllocSize();
+	return Size;
+}
+
+bool CPSelectionAction::MergeCells(const CPSelectionAction &Other)		// // //
+{
+	if (!m_pJournal || m_hCells == CUndoJournal::NO_ENTRY || !Other.m_bHasAfter)
+		return false;
+	const CPatternEditorState &a = *m_pUndoState;
+	const CPatternEditorState &b = *Other.m_pUndoState;
+	if (a.Track != b.Track || a.IsSelecting != b.IsSelecting)
+		return false;
+	if (a.IsSelecting ? (a.Selection.m_cpStart != b.Selection.m_cpStart || a.Selection.m_cpEnd != b.Selection.m_cpEnd) :
+		a.Cursor != b.Cursor)
+		return false;
+
+	m_pJournal->Begin(sizeof(stChanNote));
+	Other.RecordCells(*m_pJournal);
+	if (!m_pJournal->CommitInto(m_hCells))
+		return false;
+	*m_pRedoState = *Other.m_pRedoState;
+	return true;
+}
+
+void CPSelectionAction::RecordCells(CUndoJournal &Journal) const		// // //
+{
+	for (const auto &Cell : m_Cells)
+		Journal.Record(Cell.Key, &Cell.Before, &Cell.After);
+}
+
+void CPSelectionAction::ReplayCells(CMainFrame *pMainFrm, bool Redo) const		// // //
+{
+	CFamiTrackerDoc *pDoc = static_cast<CFamiTrackerView*>(pMainFrm->GetActiveView())->GetDocument();
+	const int Track = m_pUndoState->Track;
+	m_pJournal->Replay(m_hCells, [&] (const CUndoJournal::stCell &Cell) {
+		stChanNote Note;
+		pDoc->GetNoteData(Track, KeyFrame(Cell.Key), KeyChannel(Cell.Key), KeyRow(Cell.Key), &Note);
+		Cell.Apply(&Note, Redo);
+		pDoc->SetNoteData(Track, KeyFrame(Cell.Key), KeyChannel(Cell.Key), KeyRow(Cell.Key), &Note);
+	});
 }
 
 
@@ -610,7 +755,7 @@ CPActionClearSel::CPActionClearSel() :
 {
 }
 
-void CPActionClearSel::Redo(CMainFrame *pMainFrm) const
+void CPActionClearSel::Perform(CMainFrame *pMainFrm) const
 {
 	DeleteSelection(pMainFrm, m_pUndoState->Selection);
 }
@@ -671,6 +816,12 @@ void CPActionDeleteAtSel::Redo(CMainFrame *pMainFrm) const
 	pPatternEditor->CancelSelection();
 }
 
+std::size_t CPActionDeleteAtSel::GetMemorySize() const		// // //
+{
+	return CPatternAction::GetMemorySize() +
+		(m_pUndoHead ? m_pUndoHead->GetAllocSize() : 0) + (m_pUndoTail ? m_pUndoTail->GetAllocSize() : 0);
+}
+
 
 
 CPActionInsertAtSel::CPActionInsertAtSel() :
@@ -738,6 +889,12 @@ void CPActionInsertAtSel::Redo(CMainFrame *pMainFrm) const
 		pPatternEditor->PasteRaw(m_pUndoHead, m_cpHeadPos);
 }
 
+std::size_t CPActionInsertAtSel::GetMemorySize() const		// // //
+{
+	return CPatternAction::GetMemorySize() +
+		(m_pUndoHead ? m_pUndoHead->GetAllocSize() : 0) + (m_pUndoTail ? m_pUndoTail->GetAllocSize() : 0);
+}
+
 
 
 CPActionTranspose::CPActionTranspose(transpose_t Type) :
@@ -745,7 +902,7 @@ CPActionTranspose::CPActionTranspose(transpose_t Type) :
 {
 }
 
-void CPActionTranspose::Redo(CMainFrame *pMainFrm) const
+void CPActionTranspose::Perform(CMainFrame *pMainFrm) const
 {
 	CFamiTrackerDoc *pDoc = static_cast<CFamiTrackerView*>(pMainFrm->GetActiveView())->GetDocument();
 	auto it = GetIterators(pMainFrm);
@@ -799,6 +956,13 @@ void CPActionTranspose::Redo(CMainFrame *pMainFrm) const
 	} while (++it.first <= it.second);
 }
 
+bool CPActionTranspose::Merge(const Action *Other)		// // //
+{
+	// Repeated transposes of the same notes undo as one
+	const CPActionTranspose *pAction = dynamic_cast<const CPActionTranspose*>(Other);
+	return pAction && MergeCells(*pAction);
+}
+
 
 
 CPActionScrollValues::CPActionScrollValues(int Amount) :
@@ -806,7 +970,7 @@ CPActionScrollValues::CPActionScrollValues(int Amount) :
 {
 }
 
-void CPActionScrollValues::Redo(CMainFrame *pMainFrm) const
+void CPActionScrollValues::Perform(CMainFrame *pMainFrm) const
 {
 	CFamiTrackerDoc *pDoc = static_cast<CFamiTrackerView*>(pMainFrm->GetActiveView())->GetDocument();
 	CPatternEditor *pPatternEditor = static_cast<CFamiTrackerView*>(pMainFrm->GetActiveView())->GetPatternEditor();
@@ -879,6 +1043,12 @@ void CPActionScrollValues::Redo(CMainFrame *pMainFrm) const
 	} while (++it.first <= it.second);
 }
 
+bool CPActionScrollValues::Merge(const Action *Other)		// // //
+{
+	const CPActionScrollValues *pAction = dynamic_cast<const CPActionScrollValues*>(Other);
+	return pAction && MergeCells(*pAction);
+}
+
 
 
 CPActionInterpolate::CPActionInterpolate() :
@@ -895,7 +1065,7 @@ bool CPActionInterpolate::SaveState(const CMainFrame *pMainFrm)
 	return CPSelectionAction::SaveState(pMainFrm);
 }
 
-void CPActionInterpolate::Redo(CMainFrame *pMainFrm) const
+void CPActionInterpolate::Perform(CMainFrame *pMainFrm) const
 {
 	auto it = GetIterators(pMainFrm);
 	CFamiTrackerDoc *pDoc = static_cast<CFamiTrackerView*>(pMainFrm->GetActiveView())->GetDocument();
@@ -1003,7 +1173,7 @@ bool CPActionReverse::SaveState(const CMainFrame *pMainFrm)
 	return CPSelectionAction::SaveState(pMainFrm);
 }
 
-void CPActionReverse::Redo(CMainFrame *pMainFrm) const
+void CPActionReverse::Perform(CMainFrame *pMainFrm) const
 {
 	auto it = GetIterators(pMainFrm);
 	const CSelection &Sel = m_pUndoState->Selection;
@@ -1048,7 +1218,7 @@ bool CPActionReplaceInst::SaveState(const CMainFrame *pMainFrm)
 	return CPSelectionAction::SaveState(pMainFrm);
 }
 
-void CPActionReplaceInst::Redo(CMainFrame *pMainFrm) const
+void CPActionReplaceInst::Perform(CMainFrame *pMainFrm) const
 {
 	CFamiTrackerDoc *pDoc = static_cast<CFamiTrackerView*>(pMainFrm->GetActiveView())->GetDocument();
 	auto it = GetIterators(pMainFrm);
@@ -1121,7 +1291,7 @@ bool CPActionStretch::SaveState(const CMainFrame *pMainFrm)
 	return CPSelectionAction::SaveState(pMainFrm);
 }
 
-void CPActionStretch::Redo(CMainFrame *pMainFrm) const
+void CPActionStretch::Perform(CMainFrame *pMainFrm) const
 {
 	CFamiTrackerDoc *pDoc = static_cast<CFamiTrackerView*>(pMainFrm->GetActiveView())->GetDocument();
 	auto it = GetIterators(pMainFrm);
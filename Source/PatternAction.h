@@ -109,6 +109,8 @@ public:
 	void RestoreUndoState(CMainFrame *pMainFrm) const;		// // //
 	void RestoreRedoState(CMainFrame *pMainFrm) const;		// // //
 
+	std::size_t GetMemorySize() const;		// // //
+
 public:
 	void SetPaste(CPatternClipData *pClipData);
 	void SetPasteMode(paste_mode_t Mode);		// // //
@@ -145,6 +147,9 @@ private:
 /*!
 	\brief Specialization of the pattern action class for actions operating on a selection without
 	modifying its span.
+	\details The action copies the edited cells before and after it performs the edit, keeping a
+	clip of the selection only while the edit runs. Once in the history it stores only the cells
+	that changed in the history's journal, and later undos and redos replay them.
 */
 class CPSelectionAction : public CPatternAction
 {
@@ -154,8 +159,32 @@ protected:
 protected:
 	bool SaveState(const CMainFrame *pMainFrm);
 	void Undo(CMainFrame *pMainFrm) const;
+	void Redo(CMainFrame *pMainFrm) const;		// // //
+	void Compact(CUndoJournal &Journal);		// // //
+	std::size_t GetMemorySize() const;		// // //
+
+	/*!	\brief Performs the edit on the pattern data, the first time the action is redone.
+		\param pMainFrm Pointer to the main frame. */
+	virtual void Perform(CMainFrame *pMainFrm) const = 0;		// // //
+
+	/*!	\brief Coalesces a following action on the same selection into this one.
+		\param Other The following action, which has not entered the history yet.
+		\return Whether the actions were combined. */
+	bool MergeCells(const CPSelectionAction &Other);		// // //
 protected:
-	CPatternClipData *m_pUndoClipData;
+	mutable CPatternClipData *m_pUndoClipData;		// // // Source of Perform, released once it ran
+private:
+	struct stCell {		// // //
+		std::uint32_t Key;
+		stChanNote Before, After;
+	};
+	void RecordCells(CUndoJournal &Journal) const;		// // //
+	void ReplayCells(CMainFrame *pMainFrm, bool Redo) const;		// // //
+private:
+	mutable std::vector<stCell> m_Cells;		// // // Edited cells until the action is compacted
+	mutable bool m_bHasAfter;
+	CUndoJournal *m_pJournal;
+	CUndoJournal::handle_t m_hCells;
 };
 
 // // // built-in pattern action subtypes
@@ -228,7 +257,7 @@ class CPActionClearSel : public CPSelectionAction
 public:
 	CPActionClearSel();
 private:
-	void Redo(CMainFrame *pMainFrm) const;
+	void Perform(CMainFrame *pMainFrm) const;
 };
 
 class CPActionDeleteAtSel : public CPatternAction
@@ -240,6 +269,7 @@ private:
 	bool SaveState(const CMainFrame *pMainFrm);
 	void Undo(CMainFrame *pMainFrm) const;
 	void Redo(CMainFrame *pMainFrm) const;
+	std::size_t GetMemorySize() const;		// // //
 private:
 	CCursorPos m_cpTailPos;
 	CPatternClipData *m_pUndoHead, *m_pUndoTail;
@@ -254,6 +284,7 @@ private:
 	bool SaveState(const CMainFrame *pMainFrm);
 	void Undo(CMainFrame *pMainFrm) const;
 	void Redo(CMainFrame *pMainFrm) const;
+	std::size_t GetMemorySize() const;		// // //
 private:
 	CCursorPos m_cpHeadPos, m_cpTailPos;
 	CPatternClipData *m_pUndoHead, *m_pUndoTail;
@@ -264,7 +295,8 @@ class CPActionTranspose : public CPSelectionAction
 public:
 	CPActionTranspose(transpose_t Type);
 private:
-	void Redo(CMainFrame *pMainFrm) const;
+	void Perform(CMainFrame *pMainFrm) const;
+	bool Merge(const Action *Other);		// // //
 private:
 	transpose_t m_iTransposeMode;
 };
@@ -274,7 +306,8 @@ class CPActionScrollValues : public CPSelectionAction
 public:
 	CPActionScrollValues(int Amount);
 private:
-	void Redo(CMainFrame *pMainFrm) const;
+	void Perform(CMainFrame *pMainFrm) const;
+	bool Merge(const Action *Other);		// // //
 private:
 	int m_iAmount;
 };
@@ -285,7 +318,7 @@ public:
 	CPActionInterpolate();
 private:
 	bool SaveState(const CMainFrame *pMainFrm);
-	void Redo(CMainFrame *pMainFrm) const;
+	void Perform(CMainFrame *pMainFrm) const;
 private:
 	int m_iSelectionSize;
 };
@@ -296,7 +329,7 @@ public:
 	CPActionReverse();
 private:
 	bool SaveState(const CMainFrame *pMainFrm);
-	void Redo(CMainFrame *pMainFrm) const;
+	void Perform(CMainFrame *pMainFrm) const;
 };
 
 class CPActionReplaceInst : public CPSelectionAction
@@ -305,7 +338,7 @@ public:
 	CPActionReplaceInst(unsigned Index);
 private:
 	bool SaveState(const CMainFrame *pMainFrm);
-	void Redo(CMainFrame *pMainFrm) const;
+	void Perform(CMainFrame *pMainFrm) const;
 private:
 	unsigned m_iInstrumentIndex;
 };
@@ -346,7 +379,7 @@ public:
 	CPActionStretch(std::vector<int> Stretch);
 private:
 	bool SaveState(const CMainFrame *pMainFrm);
-	void Redo(CMainFrame *pMainFrm) const;
+	void Perform(CMainFrame *pMainFrm) const;
 private:
 	std::vector<int> m_iStretchMap;
 };
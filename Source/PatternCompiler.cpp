@@ -1119,7 +1119,7 @@ void CPatternCompiler::Print(std::string_view text, T... args) const
 	if (!m_pLogger || text.empty())
 		return;
 
-	static TCHAR buf[256];
+	TCHAR buf[256];		// // // Patterns may be compiled concurrently
 
 	_sntprintf_s(buf, sizeof(buf), _TRUNCATE, text.data(), args...);
 
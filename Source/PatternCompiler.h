@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <vector>
+
 class CFamiTrackerDoc;
 class CCompilerLog;
 
@@ -22,16 +22,22 @@
 #include "FamiTrackerTypes.h"		// // //
 #include "PatternData.h"
 #include <algorithm>		// // // std::swap
+#include <atomic>
+#include <unordered_map>
 
 // Defaults when creating new modules
 const unsigned CPatternData::DEFAULT_ROW_COUNT	= 128;
 const CString CPatternData::DEFAULT_TITLE = _T("New track");		// // //
 const stHighlight CPatternData::DEFAULT_HIGHLIGHT = {4, 16, 0};		// // //
 
+// // // Source of track and pattern versions, shared by every document (batch renders load several at once)
+static std::atomic<unsigned long long> NextVersion { 1 };
+
 // This class contains pattern data
 // A list of these objects exists inside the document one for each song
 
 CPatternData::CPatternData(unsigned int PatternLength) :		// // //
+	m_iVersion(NextVersion++),		// // //
 	m_sTrackName(DEFAULT_TITLE),		// // //
 	m_iPatternLength(PatternLength),
 	m_iFrameCount(1),
@@ -40,47 +46,47 @@ CPatternData::CPatternData(unsigned int PatternLength) :		// // //
 	m_bUseGroove(false),		// // //
 	m_vRowHighlight(DEFAULT_HIGHLIGHT),		// // //
 	m_iFrameList(),		// // //
-	m_pPatternData(),
 	m_iEffectColumns()
 {
-	// // // Pre-allocate pattern 0 for all channels
-	for (int i = 0; i < MAX_CHANNELS; ++i)
-		AllocatePattern(i, 0);
+	// // // Patterns are allocated on the first write
 }
 
 CPatternData::~CPatternData()
 {
-	// Deallocate memory
-	for (int i = 0; i < MAX_CHANNELS; ++i) {
-		for (int j = 0; j < MAX_PATTERN; ++j) {
-			SAFE_RELEASE_ARRAY(m_pPatternData[i][j]);
-		}
-	}
 }
 
-bool CPatternData::IsCellFree(unsigned int Channel, unsigned int Pattern, unsigned int Row) const
+unsigned long long CPatternData::GetVersion() const		// // //
+{
+	return m_iVersion;
+}
+
+void CPatternData::Modified()		// // //
+{
+	m_iVersion = NextVersion++;
+}
+
+bool CPatternData::IsFree(const stChanNote &Note)		// // //
 {
-	const stChanNote *pNote = GetPatternData(Channel, Pattern, Row);
+	return Note.Note == NONE &&
+		Note.EffNumber[0] == EF_NONE && Note.EffNumber[1] == EF_NONE &&
+		Note.EffNumber[2] == EF_NONE && Note.EffNumber[3] == EF_NONE &&
+		Note.Vol == MAX_VOLUME && Note.Instrument == MAX_INSTRUMENTS;
+}
 
-	return !pNote || pNote->Note == NONE &&		// // //
-		pNote->EffNumber[0] == EF_NONE && pNote->EffNumber[1] == EF_NONE &&
-		pNote->EffNumber[2] == EF_NONE && pNote->EffNumber[3] == EF_NONE &&
-		pNote->Vol == MAX_VOLUME && pNote->Instrument == MAX_INSTRUMENTS;
+bool CPatternData::IsCellFree(unsigned int Channel, unsigned int Pattern, unsigned int Row) const
+{
+	return IsFree(GetNote(Channel, Pattern, Row));		// // //
 }
 
 bool CPatternData::IsPatternEmpty(unsigned int Channel, unsigned int Pattern) const
 {
 	// Unallocated pattern means empty
-	if (!m_pPatternData[Channel][Pattern])
+	const stPattern *pData = FindPattern(Channel, Pattern);
+	if (!pData)
 		return true;
 
-	// Check if allocated pattern is empty
-	for (unsigned int i = 0; i < m_iPatternLength; ++i) {
-		if (!IsCellFree(Channel, Pattern, i))
-			return false;
-	}
-
-	return true;
+	// // // Check if any row within the pattern length is occupied
+	return (pData->Occupied << (MAX_PATTERN_LENGTH - m_iPatternLength)).none();
 }
 
 bool CPatternData::IsPatternInUse(unsigned int Channel, unsigned int Pattern) const
@@ -94,32 +100,212 @@ bool CPatternData::IsPatternInUse(unsigned int Channel, unsigned int Pattern) co
 	return false;
 }
 
-stChanNote *CPatternData::GetPatternData(unsigned int Channel, unsigned int Pattern, unsigned int Row) const
+std::bitset<MAX_PATTERN> CPatternData::GetPatternsInUse(unsigned int Channel) const		// // //
+{
+	std::bitset<MAX_PATTERN> InUse;
+	for (unsigned i = 0; i < m_iFrameCount; ++i)
+		InUse.set(m_iFrameList[i][Channel]);
+	return InUse;
+}
+
+bool CPatternData::HasRowsPastLength(const stPattern &Data) const		// // //
+{
+	return (Data.Occupied >> m_iPatternLength).any();
+}
+
+bool CPatternData::IsInstrumentInPattern(unsigned int Channel, unsigned int Pattern, unsigned int Instrument) const		// // //
+{
+	const stPattern *pData = FindPattern(Channel, Pattern);
+	if (!pData || Instrument >= MAX_INSTRUMENTS || !pData->Instruments[Instrument])
+		return false;
+	if (!HasRowsPastLength(*pData))
+		return true;
+
+	for (unsigned int i = 0; i < m_iPatternLength && i < pData->Rows.size(); ++i)
+		if (pData->Rows[i].Instrument == Instrument)
+			return true;
+	return false;
+}
+
+bool CPatternData::IsEffectInPattern(unsigned int Channel, unsigned int Pattern, effect_t Effect) const		// // //
 {
-	// Private method, may return NULL
-	if (!m_pPatternData[Channel][Pattern])
+	const stPattern *pData = FindPattern(Channel, Pattern);
+	if (!pData || Effect == EF_NONE || Effect >= EF_COUNT || !pData->Effects[Effect])
+		return false;
+	if (!HasRowsPastLength(*pData))
+		return true;
+
+	for (unsigned int i = 0; i < m_iPatternLength && i < pData->Rows.size(); ++i)
+		for (int c = 0; c < MAX_EFFECT_COLUMNS; ++c)
+			if (pData->Rows[i].EffNumber[c] == Effect)
+				return true;
+	return false;
+}
+
+std::size_t CPatternData::GetPatternHash(unsigned int Channel, unsigned int Pattern) const		// // //
+{
+	const stPattern *pData = FindPattern(Channel, Pattern);
+	return pData ? pData->Hash : 0;
+}
+
+unsigned long long CPatternData::GetPatternVersion(unsigned int Channel, unsigned int Pattern) const		// // //
+{
+	const stPattern *pData = FindPattern(Channel, Pattern);
+	return pData ? pData->Version : 0;
+}
+
+unsigned int CPatternData::GetFirstChangedFrame(const CPatternData &Other) const		// // //
+{
+	if (m_iPatternLength != Other.m_iPatternLength || m_iSongSpeed != Other.m_iSongSpeed ||
+		m_iSongTempo != Other.m_iSongTempo || m_bUseGroove != Other.m_bUseGroove ||
+		!(m_vRowHighlight == Other.m_vRowHighlight) ||
+		!std::equal(std::begin(m_iEffectColumns), std::end(m_iEffectColumns), std::begin(Other.m_iEffectColumns)))
+		return 0;
+
+	const unsigned int Frames = std::min(m_iFrameCount, Other.m_iFrameCount);
+	for (unsigned int i = 0; i < Frames; ++i)
+		for (unsigned int j = 0; j < MAX_CHANNELS; ++j) {
+			const unsigned int Pattern = m_iFrameList[i][j];
+			if (Pattern != Other.m_iFrameList[i][j] || GetPatternVersion(j, Pattern) != Other.GetPatternVersion(j, Pattern))
+				return i;
+		}
+	return Frames;
+}
+
+const CPatternData::stPattern *CPatternData::FindPattern(unsigned int Channel, unsigned int Pattern) const		// // //
+{
+	const auto &Patterns = m_vPatterns[Channel];
+	if (Pattern >= Patterns.size())
 		return nullptr;
+	return Patterns[Pattern].get();
+}
 
-	return m_pPatternData[Channel][Pattern] + Row;
+const stChanNote &CPatternData::GetNote(unsigned int Channel, unsigned int Pattern, unsigned int Row) const		// // //
+{
+	static const stChanNote BLANK { };
+
+	const stPattern *pData = FindPattern(Channel, Pattern);
+	if (!pData || Row >= pData->Rows.size())
+		return BLANK;
+	return pData->Rows[Row];
 }
 
-stChanNote *CPatternData::GetPatternData(unsigned int Channel, unsigned int Pattern, unsigned int Row)
+void CPatternData::SetNote(unsigned int Channel, unsigned int Pattern, unsigned int Row, const stChanNote &Note)		// // //
 {
-	if (!m_pPatternData[Channel][Pattern])		// Allocate pattern if accessed for the first time
-		AllocatePattern(Channel, Pattern);
+	// Also keeps blank notes from allocating patterns
+	if (GetNote(Channel, Pattern, Row) == Note)
+		return;
+
+	stPattern &Data = GetWritablePattern(Channel, Pattern, Row);
+	UpdateSummary(Data, Row, Data.Rows[Row], -1);
+	Data.Rows[Row] = Note;
+	UpdateSummary(Data, Row, Note, 1);
+	Data.Version = NextVersion++;
+	Modified();
+}
 
-	return m_pPatternData[Channel][Pattern] + Row;
+CPatternData::stPattern &CPatternData::GetWritablePattern(unsigned int Channel, unsigned int Pattern, unsigned int Row)
+{
+	auto &Patterns = m_vPatterns[Channel];
+	if (Pattern >= Patterns.size())
+		Patterns.resize(Pattern + 1);
+
+	pattern_t &pData = Patterns[Pattern];
+	if (!pData) {		// Allocate pattern if accessed for the first time
+		pData = std::make_shared<stPattern>();
+		pData->Rows.resize(m_iPatternLength);
+	}
+	else if (pData.use_count() > 1)		// // // Shared with other patterns or a copy of the track, copy before writing
+		pData = std::make_shared<stPattern>(*pData);
+
+	// Rows past the pattern length are kept, but only allocated once written to
+	if (Row >= pData->Rows.size())
+		pData->Rows.resize(MAX_PATTERN_LENGTH);
+
+	return *pData;
 }
 
-void CPatternData::AllocatePattern(unsigned int Channel, unsigned int Pattern)
+void CPatternData::UpdateSummary(stPattern &Data, unsigned int Row, const stChanNote &Note, int Sign)		// // //
 {
-	// Allocate memory
-	m_pPatternData[Channel][Pattern] = new stChanNote[MAX_PATTERN_LENGTH];
+	// Adds a row to the summary, or removes it if Sign is negative
+	static const stChanNote BLANK { };
+	if (Note == BLANK)
+		return;
+
+	std::size_t Hash = Row;
+	Hash = Hash * 31 + (Note.Note | Note.Octave << 8 | Note.Vol << 16 | Note.Instrument << 24);
+	for (int i = 0; i < MAX_EFFECT_COLUMNS; ++i)
+		Hash = Hash * 31 + (Note.EffNumber[i] | Note.EffParam[i] << 8);
+	Data.Hash ^= static_cast<std::size_t>(Hash * 0x9E3779B97F4A7C15ull);
+
+	if (Note.Instrument < MAX_INSTRUMENTS)
+		Data.Instruments[Note.Instrument] += Sign;
+	for (int i = 0; i < MAX_EFFECT_COLUMNS; ++i)
+		if (Note.EffNumber[i] != EF_NONE && Note.EffNumber[i] < EF_COUNT)
+			Data.Effects[Note.EffNumber[i]] += Sign;
+	Data.Occupied.set(Row, Sign > 0 && !IsFree(Note));
+}
 
-	// Clear memory
-	stChanNote Blank { };		// // //
-	for (int i = 0; i < MAX_PATTERN_LENGTH; ++i)
-		memcpy(m_pPatternData[Channel][Pattern] + i, &Blank, sizeof(stChanNote));
+void CPatternData::CopyPattern(unsigned int Channel, unsigned int Pattern, const CPatternData &Source, unsigned int SrcChannel, unsigned int SrcPattern)		// // //
+{
+	const auto &SrcPatterns = Source.m_vPatterns[SrcChannel];
+	if (SrcPattern >= SrcPatterns.size() || !SrcPatterns[SrcPattern]) {
+		ClearPattern(Channel, Pattern);
+		return;
+	}
+
+	auto &Patterns = m_vPatterns[Channel];
+	if (Pattern >= Patterns.size())
+		Patterns.resize(Pattern + 1);
+	Patterns[Pattern] = SrcPatterns[SrcPattern];
+	Modified();
+}
+
+void CPatternData::SharePatterns(CPatternData *const *pTracks, unsigned int Count)		// // //
+{
+	std::unordered_multimap<std::size_t, pattern_t> Unique;
+
+	for (unsigned int t = 0; t < Count; ++t) {
+		pTracks[t]->Modified();
+		for (auto &Patterns : pTracks[t]->m_vPatterns) {
+			for (auto &pData : Patterns) {
+				if (!pData)
+					continue;
+				if (pData->Occupied.none()) {		// nothing that would be saved
+					pData.reset();
+					continue;
+				}
+				auto Range = Unique.equal_range(pData->Hash);
+				auto it = std::find_if(Range.first, Range.second, [&] (const auto &x) { return x.second->Rows == pData->Rows; });
+				if (it != Range.second)
+					pData = it->second;
+				else
+					Unique.emplace(pData->Hash, pData);
+			}
+			while (!Patterns.empty() && !Patterns.back())
+				Patterns.pop_back();
+		}
+	}
+}
+
+std::size_t CPatternData::CountPatternMemory(std::unordered_set<const void *> &Counted) const		// // //
+{
+	std::size_t Size = 0;
+	for (const auto &Patterns : m_vPatterns) {
+		Size += Patterns.capacity() * sizeof(pattern_t);
+		for (const auto &pData : Patterns)
+			if (pData && Counted.insert(pData.get()).second)
+				Size += sizeof(stPattern) + pData->Rows.capacity() * sizeof(stChanNote);
+	}
+	return Size;
+}
+
+unsigned int CPatternData::GetAllocatedPatternCount() const		// // //
+{
+	unsigned int Count = 0;
+	for (const auto &Patterns : m_vPatterns)
+		Count += static_cast<unsigned int>(std::count_if(Patterns.begin(), Patterns.end(), [] (const pattern_t &p) { return p != nullptr; }));
+	return Count;
 }
 
 void CPatternData::ClearEverything()
@@ -131,17 +317,18 @@ void CPatternData::ClearEverything()
 	m_iFrameCount = 1;
 	
 	// Patterns, deallocate everything
-	for (int i = 0; i < MAX_CHANNELS; ++i) {
-		for (int j = 0; j < MAX_PATTERN; ++j) {
-			ClearPattern(i, j);
-		}
-	}
+	for (auto &Patterns : m_vPatterns)		// // //
+		Patterns.clear();
+	Modified();
 }
 
 void CPatternData::ClearPattern(unsigned int Channel, unsigned int Pattern)
 {
 	// Deletes a specified pattern in a channel
-	SAFE_RELEASE_ARRAY(m_pPatternData[Channel][Pattern]);
+	auto &Patterns = m_vPatterns[Channel];
+	if (Pattern < Patterns.size())
+		Patterns[Pattern].reset();
+	Modified();
 }
 
 CString CPatternData::GetTitle() const
@@ -182,36 +369,43 @@ bool CPatternData::GetSongGroove() const		// // //
 void CPatternData::SetTitle(CString str)
 {
 	m_sTrackName = str;
+	Modified();
 }
 
 void CPatternData::SetPatternLength(unsigned int Length)
 {
 	m_iPatternLength = Length;
+	Modified();
 }
 
 void CPatternData::SetFrameCount(unsigned int Count)
 {
 	m_iFrameCount = Count;
+	Modified();
 }
 
 void CPatternData::SetSongSpeed(unsigned int Speed)
 {
 	m_iSongSpeed = Speed;
+	Modified();
 }
 
 void CPatternData::SetSongTempo(unsigned int Tempo)
 {
 	m_iSongTempo = Tempo;
+	Modified();
 }
 
 void CPatternData::SetEffectColumnCount(int Channel, int Count)
 {
 	m_iEffectColumns[Channel] = Count;
+	Modified();
 }
 
 void CPatternData::SetSongGroove(bool Groove)		// // //
 {
 	m_bUseGroove = Groove;
+	Modified();
 }
 
 unsigned int CPatternData::GetFramePattern(unsigned int Frame, unsigned int Channel) const
@@ -222,11 +416,13 @@ unsigned int CPatternData::GetFramePattern(unsigned int Frame, unsigned int Chan
 void CPatternData::SetFramePattern(unsigned int Frame, unsigned int Channel, unsigned int Pattern)
 {
 	m_iFrameList[Frame][Channel] = Pattern;
+	Modified();
 }
 
 void CPatternData::SetHighlight(const stHighlight Hl)		// // //
 {
 	m_vRowHighlight = Hl;
+	Modified();
 }
 
 stHighlight CPatternData::GetRowHighlight() const
@@ -239,7 +435,6 @@ void CPatternData::SwapChannels(unsigned int First, unsigned int Second)		// //
 	for (int i = 0; i < MAX_FRAMES; i++) {
 		std::swap(m_iFrameList[i][First], m_iFrameList[i][Second]);
 	}
-	for (int i = 0; i < MAX_PATTERN; i++) {
-		std::swap(m_pPatternData[First][i], m_pPatternData[Second][i]);
-	}
+	m_vPatterns[First].swap(m_vPatterns[Second]);
+	Modified();
 }
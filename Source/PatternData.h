@@ -22,6 +22,11 @@
 
 
 #include "PatternNote.h"		// // //
+#include <array>
+#include <bitset>
+#include <memory>
+#include <unordered_set>
+#include <vector>
 
 // // // Highlight settings
 struct stHighlight {
@@ -46,20 +51,54 @@ const unsigned int DEFAULT_SPEED      = 6;
 // TODO rename to CTrack perhaps?
 
 // CPatternData holds all notes in the patterns
+//
+// // // A copy shares the rows of every pattern with the original, and either one copies
+// a pattern before writing to it. The player reads a const copy of each track, which
+// stays valid while the editor writes to the track (see CFamiTrackerDoc::PublishPlayback).
 class CPatternData
 {
 public:
 	CPatternData(unsigned int PatternLength = DEFAULT_ROW_COUNT);		// // //
 	~CPatternData();
 
+	// // // Changes whenever the track is written to. No two tracks share a version unless
+	// one is an unchanged copy of the other.
+	unsigned long long GetVersion() const;
+
 	bool IsCellFree(unsigned int Channel, unsigned int Pattern, unsigned int Row) const;
 	bool IsPatternEmpty(unsigned int Channel, unsigned int Pattern) const;
 	bool IsPatternInUse(unsigned int Channel, unsigned int Pattern) const;
+	std::bitset<MAX_PATTERN> GetPatternsInUse(unsigned int Channel) const;		// // //
+
+	// // // Pattern summaries, these only look at rows within the pattern length.
+	// They take time proportional to the pattern length only when rows past it are used.
+	bool IsInstrumentInPattern(unsigned int Channel, unsigned int Pattern, unsigned int Instrument) const;
+	bool IsEffectInPattern(unsigned int Channel, unsigned int Pattern, effect_t Effect) const;		// in any effect column
+	std::size_t GetPatternHash(unsigned int Channel, unsigned int Pattern) const;		// of all rows, 0 for empty patterns
+	// Changes whenever the pattern is written to, 0 for unallocated patterns. Patterns with
+	// the same version hold the same rows, even in different tracks.
+	unsigned long long GetPatternVersion(unsigned int Channel, unsigned int Pattern) const;
+	// // // First frame that may play differently in Other, 0 if the track settings differ, or the
+	// lower frame count if no frame differs. Compares pattern versions, not rows.
+	unsigned int GetFirstChangedFrame(const CPatternData &Other) const;
 
 	void ClearEverything();
 	void ClearPattern(unsigned int Channel, unsigned int Pattern);
 
-	stChanNote *GetPatternData(unsigned int Channel, unsigned int Pattern, unsigned int Row);
+	// // // Read-only access, never allocates. Unallocated rows read as blank notes.
+	const stChanNote &GetNote(unsigned int Channel, unsigned int Pattern, unsigned int Row) const;
+	// Allocates the pattern or unshares it from other patterns if needed, and updates its summary
+	void SetNote(unsigned int Channel, unsigned int Pattern, unsigned int Row, const stChanNote &Note);
+
+	// // // Makes a pattern a copy of another one, which may be in a different track or channel.
+	// Both share their rows until either is written to.
+	void CopyPattern(unsigned int Channel, unsigned int Pattern, const CPatternData &Source, unsigned int SrcChannel, unsigned int SrcPattern);
+	// Lets identical patterns of all given tracks share their rows, and releases blank patterns
+	static void SharePatterns(CPatternData *const *pTracks, unsigned int Count);
+
+	// Bytes used by the rows of allocated patterns, skipping those already in Counted
+	std::size_t CountPatternMemory(std::unordered_set<const void *> &Counted) const;
+	unsigned int GetAllocatedPatternCount() const;
 
 	CString GetTitle() const;
 	unsigned int GetPatternLength() const;
@@ -86,8 +125,25 @@ public:
 	void SwapChannels(unsigned int First, unsigned int Second);		// // //
 
 private:
-	stChanNote *GetPatternData(unsigned int Channel, unsigned int Pattern, unsigned int Row) const;
-	void AllocatePattern(unsigned int Channel, unsigned int Patterns);
+	// // // Rows of one pattern and a summary of them, shared copy-on-write between patterns
+	struct stPattern {
+		std::vector<stChanNote> Rows;
+		std::bitset<MAX_PATTERN_LENGTH> Occupied;				// Rows that are not free cells
+		std::array<unsigned short, MAX_INSTRUMENTS> Instruments {};	// Rows using each instrument
+		std::array<unsigned short, EF_COUNT> Effects {};		// Effect columns using each effect
+		std::size_t Hash = 0;									// XOR of the hashes of all non-blank rows
+		unsigned long long Version = 0;
+	};
+	using pattern_t = std::shared_ptr<stPattern>;
+
+	const stPattern *FindPattern(unsigned int Channel, unsigned int Pattern) const;
+	stPattern &GetWritablePattern(unsigned int Channel, unsigned int Pattern, unsigned int Row);
+	bool HasRowsPastLength(const stPattern &Data) const;
+
+	void Modified();		// // //
+
+	static bool IsFree(const stChanNote &Note);
+	static void UpdateSummary(stPattern &Data, unsigned int Row, const stChanNote &Note, int Sign);
 
 public:
 	// // // moved from CFamiTrackerDoc
@@ -97,6 +153,8 @@ public:
 private:
 	static const unsigned DEFAULT_ROW_COUNT;
 
+	unsigned long long m_iVersion;			// // //
+
 	// Track parameters
 	CString      m_sTrackName;				// // // moved
 	unsigned int m_iPatternLength;			// Amount of rows in one pattern
@@ -114,6 +172,8 @@ private:
 	// List of the patterns assigned to frames
 	unsigned char m_iFrameList[MAX_FRAMES][MAX_CHANNELS];		
 
-	// All accesses to m_pPatternData must go through GetPatternData()
-	stChanNote *m_pPatternData[MAX_CHANNELS][MAX_PATTERN];
+	// // // Patterns of each channel, up to the highest allocated index. A pattern holds
+	// m_iPatternLength rows when allocated, or MAX_PATTERN_LENGTH once a row past that is written.
+	// All writes must go through SetNote()
+	std::vector<pattern_t> m_vPatterns[MAX_CHANNELS];
 };
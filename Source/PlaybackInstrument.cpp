@@ -0,0 +1,133 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+#include "stdafx.h"
+#include "FamiTrackerTypes.h"
+#include "Instrument.h"
+#include "SeqInstrument.h"
+#include "Instrument2A03.h"
+#include "InstrumentFDS.h"
+#include "Sequence.h"
+#include "DSample.h"
+#include "PlaybackInstrument.h"
+
+namespace {
+
+int GetSequenceCount(const CInstrument &Instrument)
+{
+	// FDS instruments own their sequences and only have three
+	return Instrument.GetType() == INST_FDS ? CInstrumentFDS::SEQUENCE_COUNT : SEQ_COUNT;
+}
+
+} // namespace
+
+std::vector<unsigned long long> CPlaybackInstrument::GetVersions(const CInstrument &Instrument)
+{
+	std::vector<unsigned long long> Versions {Instrument.GetVersion()};
+
+	if (auto pSeqInst = dynamic_cast<const CSeqInstrument *>(&Instrument))
+		for (int i = 0, Count = GetSequenceCount(Instrument); i < Count; ++i) {
+			const CSequence *pSeq = pSeqInst->GetSeqEnable(i) ? pSeqInst->GetSequence(i) : nullptr;
+			Versions.push_back(pSeq ? pSeq->GetVersion() : 0);
+		}
+
+	if (auto pInst2A03 = dynamic_cast<const CInstrument2A03 *>(&Instrument))
+		for (int i = 0; i < OCTAVE_RANGE; ++i)
+			for (int j = 0; j < NOTE_RANGE; ++j) {
+				const CDSample *pSample = pInst2A03->GetDSample(i, j);
+				Versions.push_back(pSample ? pSample->GetVersion() : 0);
+			}
+
+	return Versions;
+}
+
+CPlaybackInstrument::CPlaybackInstrument(const CInstrument &Instrument, std::vector<unsigned long long> Versions,
+										 const sequence_source_t &GetSequence, const sample_source_t &GetDSample) :
+	m_pInstrument(Instrument.Clone()),
+	m_pSequence(SEQ_COUNT),
+	m_pDSample(MAX_DSAMPLES),
+	m_iVersions(std::move(Versions))
+{
+	const inst_type_t Type = Instrument.GetType();
+
+	if (auto pSeqInst = dynamic_cast<const CSeqInstrument *>(&Instrument))
+		if (Type != INST_FDS)		// Cloned along with the instrument
+			for (int i = 0; i < SEQ_COUNT; ++i)
+				if (pSeqInst->GetSeqEnable(i))		// The player never reads disabled sequences
+					m_pSequence[i] = GetSequence(Type, i, pSeqInst->GetSeqIndex(i));
+
+	if (auto pInst2A03 = dynamic_cast<const CInstrument2A03 *>(&Instrument))
+		for (int i = 0; i < OCTAVE_RANGE; ++i)
+			for (int j = 0; j < NOTE_RANGE; ++j)
+				if (int Index = pInst2A03->GetSampleIndex(i, j))
+					if (!m_pDSample[Index - 1])
+						m_pDSample[Index - 1] = GetDSample(Index - 1);
+
+	m_pInstrument->RegisterManager(this);
+}
+
+std::shared_ptr<CInstrument> CPlaybackInstrument::GetInstrument() const
+{
+	return std::shared_ptr<CInstrument>(shared_from_this(), m_pInstrument.get());
+}
+
+bool CPlaybackInstrument::IsCurrent(const std::vector<unsigned long long> &Versions) const
+{
+	return m_iVersions == Versions;
+}
+
+CSequence *CPlaybackInstrument::GetSequence(int InstType, int SeqType, int Index) const
+{
+	// The copy only asks for its own sequences. Nothing writes to them; see the todo on
+	// CInstrumentManagerInterface::GetSequence
+	ASSERT(InstType == m_pInstrument->GetType());
+	return const_cast<CSequence *>(m_pSequence[SeqType].get());
+}
+
+void CPlaybackInstrument::SetSequence(int InstType, int SeqType, int Index, CSequence *pSeq)
+{
+	ASSERT(false);
+}
+
+int CPlaybackInstrument::AddSequence(int InstType, int SeqType, CSequence *pSeq, CSeqInstrument *pInst)
+{
+	ASSERT(false);
+	return -1;
+}
+
+const CDSample *CPlaybackInstrument::GetDSample(int Index) const
+{
+	return m_pDSample[Index].get();
+}
+
+void CPlaybackInstrument::SetDSample(int Index, CDSample *pSamp)
+{
+	ASSERT(false);
+}
+
+int CPlaybackInstrument::AddDSample(CDSample *pSamp)
+{
+	ASSERT(false);
+	return -1;
+}
+
+void CPlaybackInstrument::InstrumentChanged() const
+{
+}
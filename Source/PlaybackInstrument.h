@@ -0,0 +1,80 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#pragma once
+
+#include "InstrumentManagerInterface.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+class CInstrument;
+
+/*!
+	\brief A copy of an instrument which the player reads while the editor keeps writing to the
+	original (see CFamiTrackerDoc::PublishPlayback).
+	\details The copy is registered to this object instead of the document's instrument manager,
+	so its sequences and DPCM samples resolve to copies held here. Copies of unchanged sequences
+	and samples are shared between instruments, just as the originals are.
+*/
+class CPlaybackInstrument : public CInstrumentManagerInterface, public std::enable_shared_from_this<CPlaybackInstrument>
+{
+public:
+	using sequence_source_t = std::function<std::shared_ptr<const CSequence>(int InstType, int SeqType, int Index)>;
+	using sample_source_t = std::function<std::shared_ptr<const CDSample>(int Index)>;
+
+	/*!	\brief Collects the versions an instrument is played from.
+		\param Instrument The instrument, registered to the document's instrument manager.
+		\return The version of the instrument, followed by those of every sequence and DPCM sample
+		it uses. */
+	static std::vector<unsigned long long> GetVersions(const CInstrument &Instrument);
+
+	/*!	\brief Copies an instrument.
+		\param Instrument The instrument, registered to the document's instrument manager.
+		\param Versions The versions returned by GetVersions.
+		\param GetSequence Returns a copy of a sequence of the document.
+		\param GetDSample Returns a copy of a DPCM sample of the document. */
+	CPlaybackInstrument(const CInstrument &Instrument, std::vector<unsigned long long> Versions,
+						const sequence_source_t &GetSequence, const sample_source_t &GetDSample);
+
+	/*!	\brief Returns the copy of the instrument, which keeps this object alive.
+		\return Pointer to the instrument. */
+	std::shared_ptr<CInstrument> GetInstrument() const;
+	/*!	\brief Checks whether the copy is still up to date.
+		\param Versions The versions returned by GetVersions for the original.
+		\return True if the original has not changed since it was copied. */
+	bool IsCurrent(const std::vector<unsigned long long> &Versions) const;
+
+	// from interface
+	CSequence *GetSequence(int InstType, int SeqType, int Index) const override;
+	void SetSequence(int InstType, int SeqType, int Index, CSequence *pSeq) override;
+	int AddSequence(int InstType, int SeqType, CSequence *pSeq, CSeqInstrument *pInst) override;
+	const CDSample *GetDSample(int Index) const override;
+	void SetDSample(int Index, CDSample *pSamp) override;
+	int AddDSample(CDSample *pSamp) override;
+	void InstrumentChanged() const override;
+
+private:
+	std::unique_ptr<CInstrument> m_pInstrument;
+	std::vector<std::shared_ptr<const CSequence>> m_pSequence;		// By sequence type
+	std::vector<std::shared_ptr<const CDSample>> m_pDSample;		// By sample index
+	std::vector<unsigned long long> m_iVersions;
+};
@@ -0,0 +1,137 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+#include "stdafx.h"
+#include "PlayerKeyframes.h"
+#include "PatternData.h"
+
+void CPlayerKeyframes::Invalidate()
+{
+	m_bStale = true;
+}
+
+bool CPlayerKeyframes::Validate(unsigned long long Version)
+{
+	const bool Stale = m_bStale.exchange(false);
+	if (!Stale && Version == m_iVersion)
+		return true;
+
+	if (Stale)
+		++m_iSetupVersion;
+	Clear();
+	m_iVersion = Version;
+	return false;
+}
+
+unsigned int CPlayerKeyframes::ValidateTrack(int Track, const std::shared_ptr<const CPatternData> &pTrack)
+{
+	auto &pOld = m_pTracks[Track];
+	if (pOld == pTrack)
+		return MAX_FRAMES;
+
+	// Keyframes before the first changed frame were taken before any changed row was read
+	const unsigned int Frame = !pOld ? MAX_FRAMES : !pTrack ? 0 :
+		pOld->GetVersion() == pTrack->GetVersion() ? MAX_FRAMES : pOld->GetFirstChangedFrame(*pTrack);
+	if (Frame != MAX_FRAMES) {
+		Drop(m_Keyframes.lower_bound(key_t {Track, Frame, 0}), m_Keyframes.lower_bound(key_t {Track + 1, 0, 0}));
+		++m_iDropVersion;
+	}
+	pOld = pTrack;
+	return Frame;
+}
+
+void CPlayerKeyframes::Clear()
+{
+	Drop(m_Keyframes.begin(), m_Keyframes.end());
+	for (auto &pTrack : m_pTracks)
+		pTrack.reset();
+	++m_iDropVersion;
+}
+
+unsigned long long CPlayerKeyframes::GetSetupVersion() const
+{
+	return m_iSetupVersion;
+}
+
+unsigned long long CPlayerKeyframes::GetDropVersion() const
+{
+	return m_iDropVersion;
+}
+
+bool CPlayerKeyframes::IsDue(int Track, int Frame, int Row) const
+{
+	return Row % INTERVAL == 0 && !IsFull() && !m_Keyframes.count(key_t {Track, Frame, Row});
+}
+
+bool CPlayerKeyframes::IsFull() const
+{
+	return m_iSize >= MAX_SIZE;
+}
+
+CPlayerKeyframes::stKeyframe CPlayerKeyframes::Allocate()
+{
+	if (!m_Pool.empty()) {
+		stKeyframe Keyframe = std::move(m_Pool.back());
+		m_Pool.pop_back();
+		return Keyframe;
+	}
+
+	stKeyframe Keyframe;
+	Keyframe.Player.reserve(m_iPlayerSize);
+	Keyframe.APU.reserve(m_iAPUSize);
+	return Keyframe;
+}
+
+void CPlayerKeyframes::Store(int Track, int Frame, int Row, stKeyframe Keyframe)
+{
+	m_iPlayerSize = Keyframe.Player.size();
+	m_iAPUSize = Keyframe.APU.size();
+	const std::size_t Size = m_iPlayerSize + m_iAPUSize;
+	if (m_Keyframes.emplace(key_t {Track, Frame, Row}, std::move(Keyframe)).second)
+		m_iSize += Size;
+}
+
+const CPlayerKeyframes::stKeyframe *CPlayerKeyframes::Find(int Track, int &Frame, int &Row) const
+{
+	// The last keyframe not after the row
+	auto it = m_Keyframes.upper_bound(key_t {Track, Frame, Row});
+	if (it == m_Keyframes.begin() || std::get<0>((--it)->first) != Track)
+		return nullptr;
+
+	Frame = std::get<1>(it->first);
+	Row = std::get<2>(it->first);
+	return &it->second;
+}
+
+void CPlayerKeyframes::Drop(map_t::iterator First, map_t::iterator Last)
+{
+	for (auto it = First; it != Last; ++it) {
+		stKeyframe &Keyframe = it->second;
+		m_iSize -= Keyframe.Player.size() + Keyframe.APU.size();
+		if (m_Pool.size() < POOL_SIZE) {
+			// The buffers keep their capacity, the instruments are released
+			Keyframe.Player.clear();
+			Keyframe.Objects.clear();
+			Keyframe.APU.clear();
+			m_Pool.push_back(std::move(Keyframe));
+		}
+	}
+	m_Keyframes.erase(First, Last);
+}
@@ -0,0 +1,119 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#pragma once
+
+#include "APU/StateArchive.h"
+#include "FamiTrackerTypes.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+class CPatternData;
+
+/*!
+	\brief Snapshots of the player taken at the start of some rows, so that playback can start
+	anywhere by restoring the nearest earlier snapshot and running forward from it.
+	\details A keyframe holds the player, the channel handlers and the APU exactly as they were
+	before the row was read, so running forward from it sounds the same as having played the
+	track from the beginning. Keyframes are only valid for the published module data they were
+	taken with: a change to the instruments, grooves or settings drops all of them (see
+	CFamiTrackerDoc::GetPlaybackVersion), and a change to a track drops its keyframes from the first
+	frame that changed. Keyframes are taken while playing and by a pass that runs while the player
+	is stopped (see CSoundGen::UpdateKeyframePass). Only the player thread uses this object, except
+	for Invalidate().
+*/
+class CPlayerKeyframes
+{
+public:
+	struct stKeyframe {
+		std::vector<uint8_t> Player;		// From CSoundGen::SerializePlayerState
+		CStateArchive::object_list_t Objects;		// Instruments referred to by Player
+		std::vector<uint8_t> APU;		// From CAPU::SaveState
+	};
+
+	static const int INTERVAL = 16;		// Rows between keyframes
+	static const std::size_t MAX_SIZE = 64 * 1024 * 1024;		// Total size of the stored states
+
+public:
+	/*!	\brief Drops every keyframe before the next use, for changes that do not show up in the
+		playback version, such as the machine type or the APU setup. May be called from any thread. */
+	void	Invalidate();
+	/*!	\brief Drops every keyframe if the module data changed since they were taken.
+		\param Version The playback version of the document.
+		\return True if the stored keyframes are still valid. */
+	bool	Validate(unsigned long long Version);
+	/*!	\brief Drops the keyframes of a track from the first frame that changed since they were taken.
+		\param Track The track index.
+		\param pTrack The published copy of the track.
+		\return The first frame that changed, or MAX_FRAMES if none did. */
+	unsigned int ValidateTrack(int Track, const std::shared_ptr<const CPatternData> &pTrack);
+	void	Clear();
+
+	/*!	\brief Changes whenever Invalidate() takes effect, so that a generator building keyframes
+		can set itself up again. */
+	unsigned long long GetSetupVersion() const;
+	/*!	\brief Changes whenever module data that keyframes depend on changes, so that a pass
+		building keyframes can start over from the ones left. */
+	unsigned long long GetDropVersion() const;
+
+	/*!	\brief Checks whether a keyframe should be taken before a row is read.
+		\param Track The track index.
+		\param Frame The frame index.
+		\param Row The row index.
+		\return True if the row starts an interval, has no keyframe yet, and there is room. */
+	bool	IsDue(int Track, int Frame, int Row) const;
+	bool	IsFull() const;
+	/*!	\brief Gets an empty keyframe to take. Its buffers are those of a dropped keyframe, or
+		are reserved to the size of the last keyframe, so that taking one rarely allocates. */
+	stKeyframe Allocate();
+	void	Store(int Track, int Frame, int Row, stKeyframe Keyframe);
+	/*!	\brief Finds the keyframe to start playing a row from.
+		\param Track The track index.
+		\param Frame The frame index, replaced with that of the keyframe.
+		\param Row The row index, replaced with that of the keyframe.
+		\return The latest keyframe at or before the row within the same track, or nullptr if
+		there is none. */
+	const stKeyframe *Find(int Track, int &Frame, int &Row) const;
+
+private:
+	using key_t = std::tuple<int, int, int>;		// Track, frame, row
+	using map_t = std::map<key_t, stKeyframe>;
+
+	void	Drop(map_t::iterator First, map_t::iterator Last);
+
+	static const std::size_t POOL_SIZE = 128;		// Dropped keyframes kept for their buffers
+
+	map_t m_Keyframes;
+	std::size_t m_iSize = 0;
+	unsigned long long m_iVersion = 0;
+	std::atomic<bool> m_bStale {true};
+	unsigned long long m_iSetupVersion = 0;
+	unsigned long long m_iDropVersion = 0;
+	std::shared_ptr<const CPatternData> m_pTracks[MAX_TRACKS];		// Copies the keyframes of each track were taken with
+	std::vector<stKeyframe> m_Pool;
+	std::size_t m_iPlayerSize = 0;		// Sizes of the last keyframe taken
+	std::size_t m_iAPUSize = 0;
+};
@@ -0,0 +1,82 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+#include "RegisterJournal.h"
+
+CRegisterJournal::CRegisterJournal(std::size_t Capacity) :
+	m_iHead(0),
+	m_iCycle(0),
+	m_pSink(nullptr)
+{
+	std::size_t Size = 1;
+	while (Size < Capacity)
+		Size <<= 1;
+	m_iMask = Size - 1;
+
+	m_pSlots = std::make_unique<stSlot[]>(Size);
+	for (std::size_t i = 0; i < Size; ++i) {
+		m_pSlots[i].Seq.store(BUSY, std::memory_order_relaxed);
+		m_pSlots[i].Cycle.store(0, std::memory_order_relaxed);
+		m_pSlots[i].Data.store(0, std::memory_order_relaxed);
+	}
+}
+
+void CRegisterJournal::Push(int Chip, uint16_t Address, uint8_t Value)
+{
+	const uint64_t Index = m_iHead.load(std::memory_order_relaxed);
+	stSlot &Slot = m_pSlots[Index & m_iMask];
+
+	Slot.Seq.store(BUSY, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	Slot.Cycle.store(m_iCycle, std::memory_order_relaxed);
+	Slot.Data.store((uint64_t(uint32_t(Chip)) << 24) | (uint64_t(Address) << 8) | Value, std::memory_order_relaxed);
+	Slot.Seq.store(Index, std::memory_order_release);
+
+	m_iHead.store(Index + 1, std::memory_order_release);
+
+	if (m_pSink)
+		m_pSink->OnWrite({m_iCycle, Chip, Address, Value});
+}
+
+bool CRegisterJournal::Load(uint64_t Index, stWrite &Out) const
+{
+	const stSlot &Slot = m_pSlots[Index & m_iMask];
+
+	if (Slot.Seq.load(std::memory_order_acquire) != Index)
+		return false;
+	const uint64_t Cycle = Slot.Cycle.load(std::memory_order_relaxed);
+	const uint64_t Data = Slot.Data.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (Slot.Seq.load(std::memory_order_relaxed) != Index)
+		return false;
+
+	Out.Cycle = Cycle;
+	Out.Chip = static_cast<int>(Data >> 24);
+	Out.Address = static_cast<uint16_t>(Data >> 8);
+	Out.Value = static_cast<uint8_t>(Data);
+	return true;
+}
+
+CRegisterJournalReader::CRegisterJournalReader(const CRegisterJournal &Journal) :
+	m_Journal(Journal),
+	m_iPos(Journal.GetWriteCount()),
+	m_iDropped(0)
+{
+}
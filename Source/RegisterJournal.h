@@ -0,0 +1,175 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+class IRegisterSink;
+
+/*!
+	\brief A lock-free ring buffer of cycle-stamped register writes.
+	\details The journal has a single writer, the thread running the sound emulation. Any number of
+	CRegisterJournalReader objects may consume it from other threads without blocking the writer.
+	Readers falling more than one buffer length behind lose the oldest writes.
+*/
+class CRegisterJournal
+{
+public:
+	/*!	\brief A single register write. */
+	struct stWrite {
+		uint64_t Cycle;		// CPU cycles since the APU was last reset
+		int Chip;			// SNDCHIP_* identifier
+		uint16_t Address;	// Register address, after address port translation
+		uint8_t Value;
+	};
+
+	/*!	\brief Constructor of the write journal.
+		\param Capacity Number of writes kept, rounded up to a power of two. */
+	explicit CRegisterJournal(std::size_t Capacity = DEFAULT_CAPACITY);
+
+	CRegisterJournal(const CRegisterJournal &) = delete;
+	CRegisterJournal &operator=(const CRegisterJournal &) = delete;
+
+	/*!	\brief Sets the time stamp of all subsequent writes. Writer thread only.
+		\param Cycle The current CPU cycle. */
+	void SetCycle(uint64_t Cycle) { m_iCycle = Cycle; }
+
+	/*!	\brief Appends a write to the journal. Writer thread only.
+		\param Chip The sound chip identifier.
+		\param Address The register address.
+		\param Value The written value. */
+	void Push(int Chip, uint16_t Address, uint8_t Value);
+
+	/*!	\brief Attaches a sink receiving every subsequent write, without loss, on the writer thread.
+		\param pSink The sink, or nullptr to detach. */
+	void SetSink(IRegisterSink *pSink) { m_pSink = pSink; }
+
+	/*!	\brief Obtains the attached sink.
+		\return The sink, or nullptr. */
+	IRegisterSink *GetSink() const { return m_pSink; }
+
+	/*!	\brief Obtains the number of writes appended since construction.
+		\return The write count. */
+	uint64_t GetWriteCount() const { return m_iHead.load(std::memory_order_acquire); }
+
+	/*!	\brief Obtains the number of writes kept by the journal.
+		\return The capacity. */
+	std::size_t GetCapacity() const { return m_iMask + 1; }
+
+public:
+	static const std::size_t DEFAULT_CAPACITY = 0x4000;
+
+private:
+	friend class CRegisterJournalReader;
+
+	// Each slot is a small seqlock: Seq holds the index of the write stored in the slot,
+	// or BUSY while the writer is overwriting it.
+	struct stSlot {
+		std::atomic<uint64_t> Seq;
+		std::atomic<uint64_t> Cycle;
+		std::atomic<uint64_t> Data;
+	};
+
+	static const uint64_t BUSY = ~0ull;
+
+	/*!	\brief Copies a write out of the journal.
+		\param Index The absolute index of the write.
+		\param Out Receives the write.
+		\return False if the write was overwritten before or while it was read. */
+	bool Load(uint64_t Index, stWrite &Out) const;
+
+private:
+	std::unique_ptr<stSlot[]> m_pSlots;
+	std::size_t m_iMask;
+	std::atomic<uint64_t> m_iHead;
+	uint64_t m_iCycle;
+	IRegisterSink *m_pSink;
+};
+
+/*!
+	\brief A lossless consumer of register writes.
+	\details Unlike CRegisterJournalReader, a sink is called synchronously by the thread running the
+	sound emulation, so it sees every write in order, and it must return quickly.
+*/
+class IRegisterSink
+{
+public:
+	virtual ~IRegisterSink() = default;
+
+	/*!	\brief Called for every register write.
+		\param Write The register write. */
+	virtual void OnWrite(const CRegisterJournal::stWrite &Write) = 0;
+
+	/*!	\brief Called when the DPCM sample memory of a chip changes.
+		\param Cycle The current CPU cycle.
+		\param Chip The sound chip identifier.
+		\param pData The sample data, or nullptr if the sample memory was cleared.
+		\param Size The size of the sample data in bytes. */
+	virtual void OnSample(uint64_t Cycle, int Chip, const char *pData, int Size) = 0;
+};
+
+/*!
+	\brief A consumer of a register write journal.
+	\details Each reader keeps its own position, so readers never affect each other or the writer.
+	A reader only sees writes appended after its construction.
+*/
+class CRegisterJournalReader
+{
+public:
+	/*!	\brief Constructor of the journal reader.
+		\param Journal The journal to read from. It must outlive the reader. */
+	explicit CRegisterJournalReader(const CRegisterJournal &Journal);
+
+	/*!	\brief Reads all writes appended since the last call, in order.
+		\param f Callable invoked with a const CRegisterJournal::stWrite & for each write.
+		\return The number of writes read. */
+	template <typename F>
+	std::size_t Poll(F f) {
+		const uint64_t Head = m_Journal.GetWriteCount();
+		std::size_t Count = 0;
+		CRegisterJournal::stWrite w;
+		while (m_iPos < Head) {
+			if (Head - m_iPos > m_Journal.GetCapacity() || !m_Journal.Load(m_iPos, w)) {
+				const uint64_t Oldest = m_Journal.GetWriteCount() - m_Journal.GetCapacity() + 1;
+				m_iDropped += Oldest - m_iPos;
+				m_iPos = Oldest;
+				continue;
+			}
+			f(static_cast<const CRegisterJournal::stWrite &>(w));
+			++m_iPos;
+			++Count;
+		}
+		return Count;
+	}
+
+	/*!	\brief Obtains the number of writes that were overwritten before this reader could read them.
+		\return The dropped write count. */
+	uint64_t GetDroppedCount() const { return m_iDropped; }
+
+private:
+	const CRegisterJournal &m_Journal;
+	uint64_t m_iPos;
+	uint64_t m_iDropped;
+};
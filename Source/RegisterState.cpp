@@ -18,39 +18,67 @@
 ** along with this program. If not, see https://www.gnu.org/licenses/.
 */
 
-#include "stdafx.h"
 #include "RegisterState.h"
+#include "RegisterJournal.h"
+#include "APU/StateArchive.h"		// // //
 
 CRegisterLogger::CRegisterLogger() :
-	m_mRegister(),
+	m_iTick(0),
 	m_iPort(0),
 	m_bAutoIncrement(false),
-	m_bBlocked(false)
+	m_bBlocked(false),
+	m_pJournal(nullptr),
+	m_iChip(0)
 {
 }
 
+void CRegisterState::SerializeState(CStateArchive &State)		// // //
+{
+	State(m_iValue, m_iWriteTick, m_iNewTick);
+}
+
 void CRegisterLogger::Reset()
 {
-	for (auto &r : m_mRegister)
-		r.second.Reset();
+	for (auto &r : m_Registers)
+		r.Reset();
+}
+
+void CRegisterLogger::SerializeState(CStateArchive &State)		// // //
+{
+	State(m_iTick, m_iPort, m_bAutoIncrement);
+	for (auto &r : m_Registers)
+		r.SerializeState(State);
 }
 
 bool CRegisterLogger::AddRegisterRange(unsigned Low, unsigned High)
 {
-	for (unsigned i = Low; i <= High; ++i)
-		if (m_mRegister.find(i) != m_mRegister.end()) // conflict
+	for (const auto &r : m_Ranges)
+		if (Low <= r.High && r.Low <= High) // conflict
 			return false;
 
-	for (unsigned i = Low; i <= High; ++i)
-		m_mRegister[i] = CRegisterState { };
-	m_mWarpValues[++High] = Low;
+	m_Ranges.push_back({Low, High, static_cast<unsigned>(m_Registers.size())});
+	m_Registers.resize(m_Registers.size() + (High - Low + 1), CRegisterState {&m_iTick});
 	return true;
 }
 
+void CRegisterLogger::SetJournal(CRegisterJournal *pJournal, int Chip)
+{
+	m_pJournal = pJournal;
+	m_iChip = Chip;
+}
+
+int CRegisterLogger::FindRegister(unsigned Address) const
+{
+	for (const auto &r : m_Ranges)
+		if (Address >= r.Low && Address <= r.High)
+			return r.Index + (Address - r.Low);
+	return -1;
+}
+
 bool CRegisterLogger::SetPort(unsigned Address)
 {
 	m_iPort = Address;
-	return m_mRegister.find(m_iPort) != m_mRegister.end();
+	return FindRegister(m_iPort) != -1;
 }
 
 void CRegisterLogger::SetAutoincrement(bool Enable)
@@ -60,28 +88,32 @@ void CRegisterLogger::SetAutoincrement(bool Enable)
 
 bool CRegisterLogger::Write(uint8_t Value)
 {
-	if (m_mRegister.find(m_iPort) == m_mRegister.end())
+	int Index = FindRegister(m_iPort);
+	if (Index == -1)
 		return false;
 
-	m_mRegister.at(m_iPort).Update(Value);
-	if (m_bAutoIncrement)
-		if (m_mWarpValues.find(++m_iPort) != m_mWarpValues.end())
-			m_iPort = m_mWarpValues[m_iPort];
+	m_Registers[Index].Update(Value);
+	if (m_pJournal && !m_bBlocked)
+		m_pJournal->Push(m_iChip, static_cast<uint16_t>(m_iPort), Value);
+
+	if (m_bAutoIncrement) {
+		++m_iPort;
+		for (const auto &r : m_Ranges)
+			if (m_iPort == r.High + 1) {
+				m_iPort = r.Low;
+				break;
+			}
+	}
 
 	return true;
 }
 
 CRegisterState *CRegisterLogger::GetRegister(unsigned Address)
 {
-	if (m_mRegister.find(Address) == m_mRegister.end())
+	int Index = FindRegister(Address);
+	if (Index == -1)
 		return nullptr;
-	return &m_mRegister.at(Address);
-}
-
-void CRegisterLogger::Step()
-{
-	for (auto &r : m_mRegister)
-		r.second.Step();
+	return &m_Registers[Index];
 }
 
 CRegisterLoggerBlock::CRegisterLoggerBlock(CRegisterLogger *Logger) :
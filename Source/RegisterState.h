@@ -21,25 +21,34 @@
 
 #pragma once
 
-#include <unordered_map>
+#include <cstdint>
+#include <vector>
+
+class CStateArchive;		// // //
+
+class CRegisterJournal;
 
 /*!
 	\brief A class which manages writes to a single APU register.
+	\details Time information is measured against the tick counter of the owning register logger,
+	so stepping the logger does not need to visit every register.
 */
 class CRegisterState
 {
 public:
-	/*!	\brief Constructor of the register state. */
-	CRegisterState() : m_iValue(0), m_iWriteClock(0), m_iNewClock(0) { }
+	/*!	\brief Constructor of the register state.
+		\param pTick Pointer to the tick counter of the owning logger. */
+	explicit CRegisterState(const unsigned *pTick) :
+		m_pTick(pTick), m_iValue(0), m_iWriteTick(*pTick - DECAY_RATE), m_iNewTick(*pTick - DECAY_RATE) { }
 
 	/*!	\brief Resets the register's content. */
-	void Reset() { m_iValue = m_iWriteClock = m_iNewClock = 0; }
+	void Reset() { m_iValue = 0; m_iWriteTick = m_iNewTick = *m_pTick - DECAY_RATE; }
 
 	/*!	\brief Writes a value to the register.
 		\param Val The new register value. */
 	void Update(uint8_t Val) {
-		if (m_iValue != Val) m_iNewClock = DECAY_RATE;
-		m_iValue = Val; m_iWriteClock = DECAY_RATE;
+		if (m_iValue != Val) m_iNewTick = *m_pTick;
+		m_iValue = Val; m_iWriteTick = *m_pTick;
 	}
 
 	/*!	\brief Obtains the register value.
@@ -47,27 +56,36 @@ public:
 	uint8_t GetValue() const { return m_iValue; }
 
 	/*!	\brief Obtains the number of ticks since the last time the register value was updated.
-		\return Number of elapsed ticks. */
-	unsigned int GetLastUpdatedTime() const { return DECAY_RATE - m_iWriteClock; }
+		\return Number of elapsed ticks, at most DECAY_RATE. */
+	unsigned int GetLastUpdatedTime() const { return Elapsed(m_iWriteTick); }
 
 	/*!	\brief Obtains the number of ticks since the last time a new register value was written.
-		\return Number of elapsed ticks. */
-	unsigned int GetNewValueTime() const { return DECAY_RATE - m_iNewClock; }
-
-	/*!	\brief Steps one tick and updates the register state's time information. */
-	void Step() { if (m_iWriteClock) --m_iWriteClock; if (m_iNewClock) --m_iNewClock; }
+		\return Number of elapsed ticks, at most DECAY_RATE. */
+	unsigned int GetNewValueTime() const { return Elapsed(m_iNewTick); }
+	/*!	\brief Saves or restores the register's content and time information.
+		\param State The archive to save into or restore from. */
+	void SerializeState(CStateArchive &State);		// // //
 
 public:
 	static const unsigned int DECAY_RATE = 15;
 
 private:
+	unsigned int Elapsed(unsigned int Tick) const {
+		unsigned int Diff = *m_pTick - Tick;
+		return Diff < DECAY_RATE ? Diff : DECAY_RATE;
+	}
+
+private:
+	const unsigned *m_pTick;
 	uint8_t m_iValue;
-	unsigned int m_iWriteClock;
-	unsigned int m_iNewClock;
+	unsigned int m_iWriteTick;
+	unsigned int m_iNewTick;
 };
 
 /*!
 	\brief A class which logs writes to all registers of a sound chip.
+	\details Registers are stored in a flat table indexed through a short list of address ranges.
+	If a journal is attached, every logged write is also appended to it.
 */
 class CRegisterLogger
 {
@@ -77,6 +95,9 @@ public:
 	/*!	\brief Constructor of the register logger. */
 	CRegisterLogger();
 
+	CRegisterLogger(const CRegisterLogger &) = delete;
+	CRegisterLogger &operator=(const CRegisterLogger &) = delete;
+
 	/*!	\brief Resets the values of all registers. */
 	void Reset();
 
@@ -89,6 +110,11 @@ public:
 		\return Whether the registers were successfully added. */
 	bool AddRegisterRange(unsigned Low, unsigned High);
 
+	/*!	\brief Attaches a write journal to the register logger.
+		\param pJournal The journal receiving all unblocked writes, or nullptr to detach.
+		\param Chip The sound chip identifier recorded with each write. */
+	void SetJournal(CRegisterJournal *pJournal, int Chip);
+
 	/*!	\brief Changes the address value for all future register writes.
 		\param Address The new address value.
 		\return True if the register at the given address exists. */
@@ -109,20 +135,39 @@ public:
 	CRegisterState *GetRegister(unsigned Address);
 
 	/*!	\brief Steps one tick and updates the time information of all registers. */
-	void Step();
+	void Step() { ++m_iTick; }
+	/*!	\brief Saves or restores the address port, the tick counter and every register.
+		\details The journal and the address ranges are configuration and are left alone.
+		\param State The archive to save into or restore from. */
+	void SerializeState(CStateArchive &State);		// // //
+
+protected:
+	struct stRegisterRange {
+		unsigned Low;
+		unsigned High;
+		unsigned Index;		// Position of Low in m_Registers
+	};
+
+	/*!	\brief Finds the table index of a register.
+		\return The index into m_Registers, or -1 if the given address does not exist. */
+	int FindRegister(unsigned Address) const;
 
 protected:
-	std::unordered_map<unsigned, CRegisterState> m_mRegister;
-	std::unordered_map<unsigned, unsigned> m_mWarpValues;
+	std::vector<CRegisterState> m_Registers;
+	std::vector<stRegisterRange> m_Ranges;
+	unsigned int m_iTick;
 	unsigned int m_iPort;
 	bool m_bAutoIncrement;
 	bool m_bBlocked;
+	CRegisterJournal *m_pJournal;
+	int m_iChip;
 };
 
 /*!
 	\brief A class which allows internal changes to the register state without causing external changes
 	due to logging.
-	\details A register logger is blocked during the lifetime of a CRegisterLoggerBlock object. The
+	\details A register logger is blocked during the lifetime of a CRegisterLoggerBlock object. Writes
+	to a blocked logger update the register states, but are not recorded in the write journal. The
 	address port of the logger before blocking remains after the block's destruction.
 */
 class CRegisterLoggerBlock
@@ -194,7 +194,8 @@ void CSampleEditorDlg::OnBnClickedDelete()
 	TRACE(_T("Removing selected part from sample, start: %i, end %i (diff: %i)\n"), StartSample, EndSample, EndSample - StartSample);
 
 	// Remove the selected part
-	memmove(m_pSample->GetData() + StartSample, m_pSample->GetData() + EndSample, m_pSample->GetSize() - EndSample);
+	char *pSampleData = m_pSample->EditData();		// // //
+	memmove(pSampleData + StartSample, pSampleData + EndSample, m_pSample->GetSize() - EndSample);
 	int NewSize = m_pSample->GetSize() - (EndSample - StartSample);
 
 	// Reallocate
@@ -219,7 +220,9 @@ void CSampleEditorDlg::OnBnClickedTilt()
 	int Nr = 10;
 	int Step = (Diff * 8) / Nr;
 	int Cntr = rand() % Step;
-	char *pData = m_pSample->GetData();
+	// // // Edit a new buffer, so that the sample gets a new version
+	char *pData = new char[m_pSample->GetSize()];
+	memcpy(pData, m_pSample->GetData(), m_pSample->GetSize());
 
 	for (int i = StartSample; i < EndSample; ++i) {
 		for (int j = 0; j < 8; ++j) {
@@ -229,6 +232,7 @@ void CSampleEditorDlg::OnBnClickedTilt()
 			}
 		}
 	}
+	m_pSample->SetData(m_pSample->GetSize(), pData);
 
 	UpdateSampleView();
 	SelectionChanged();
@@ -19,10 +19,9 @@
 */
 
 #include "stdafx.h"
-#include "FamiTracker.h" // theApp.getSoundGenerator()
+#include <algorithm>		// // //
 #include "APU/Types.h"
 #include "FamiTrackerTypes.h"
-#include "SoundGen.h"
 
 #include "Instrument.h"
 #include "SeqInstrument.h"
@@ -57,6 +56,35 @@ void CSeqInstHandler::LoadInstrument(std::shared_ptr<CInstrument> pInst)
 	}
 }
 
+void CSeqInstHandler::ReloadInstrument(std::shared_ptr<CInstrument> pInst)		// // //
+{
+	// Changed sequences are new copies, which LoadInstrument would restart
+	seq_state_t State[SEQ_COUNT];
+	int Pointer[SEQ_COUNT];
+	bool Enabled[SEQ_COUNT];
+	for (std::size_t i = 0; i < SEQ_COUNT; i++) {
+		State[i] = m_iSeqState[i];
+		Pointer[i] = m_iSeqPointer[i];
+		Enabled[i] = m_pSequence[i] != nullptr && m_iSeqState[i] != SEQ_STATE_DISABLED;
+	}
+
+	LoadInstrument(pInst);
+
+	for (std::size_t i = 0; i < SEQ_COUNT; i++)
+		if (Enabled[i] && m_pSequence[i] != nullptr && m_iSeqState[i] != SEQ_STATE_DISABLED) {
+			const int Items = m_pSequence[i]->GetItemCount();
+			m_iSeqState[i] = State[i];
+			m_iSeqPointer[i] = Items > 0 ? std::min(Pointer[i], Items - 1) : 0;
+		}
+}
+
+void CSeqInstHandler::SerializeState(CStateArchive &State)		// // //
+{
+	// The sequences themselves are set up by LoadInstrument
+	CInstHandler::SerializeState(State);
+	State(m_iSeqState, m_iSeqPointer, m_iDutyParam);
+}
+
 void CSeqInstHandler::TriggerInstrument()
 {
 	for (std::size_t i = 0; i < sizeof(m_pSequence) / sizeof(CInstrument*); i++) if (m_pSequence[i] != nullptr) {
@@ -127,7 +155,7 @@ void CSeqInstHandler::UpdateInstrument()
 						--m_iSeqPointer[i];
 					}
 				}
-				theApp.GetSoundGenerator()->SetSequencePlayPos(m_pSequence[i], m_iSeqPointer[i]);
+				m_pInterface->SetSequencePlayPos(m_pSequence[i], m_iSeqPointer[i]);
 			}
 			break;
 
@@ -139,7 +167,7 @@ void CSeqInstHandler::UpdateInstrument()
 				break;
 			}
 			m_iSeqState[i] = SEQ_STATE_HALT;
-			theApp.GetSoundGenerator()->SetSequencePlayPos(m_pSequence[i], -1);
+			m_pInterface->SetSequencePlayPos(m_pSequence[i], -1);
 			break;
 
 		case SEQ_STATE_HALT:
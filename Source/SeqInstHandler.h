@@ -50,9 +50,13 @@ public:
 	CSeqInstHandler(CChannelHandlerInterface* pInterface, int Vol, int Duty);
 
 	void LoadInstrument(std::shared_ptr<CInstrument> pInst) override;
+	/*!	\brief Loads a newer copy of the current instrument, keeping the position of every
+		sequence which is still enabled. */
+	void ReloadInstrument(std::shared_ptr<CInstrument> pInst) override;		// // //
 	void TriggerInstrument() override;
 	void ReleaseInstrument() override;
 	void UpdateInstrument() override;
+	void SerializeState(CStateArchive &State) override;		// // //
 
 	/*!	\brief Obtains the current sequence state of a given sequence type.
 		\param Index The sequence type, which should be a member of sequence_t.
@@ -69,6 +69,15 @@ void CSeqInstHandlerN163::UpdateInstrument()
 	m_bForceUpdate = false;
 }
 
+void CSeqInstHandlerN163::SerializeState(CStateArchive &State)		// // //
+{
+	CSeqInstHandler::SerializeState(State);
+	bool Swapped = m_pBufferCurrent != m_cBuffer;
+	State(m_cBuffer, Swapped, m_bForceUpdate);
+	m_pBufferCurrent = Swapped ? m_cBuffer + CInstrumentN163::MAX_WAVE_SIZE : m_cBuffer;
+	m_pBufferPrevious = Swapped ? m_cBuffer : m_cBuffer + CInstrumentN163::MAX_WAVE_SIZE;
+}
+
 void CSeqInstHandlerN163::RequestWaveUpdate()
 {
 	m_bForceUpdate = true;
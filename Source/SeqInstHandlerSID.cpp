@@ -40,6 +40,13 @@ void CSeqInstHandlerSID::LoadInstrument(std::shared_ptr<CInstrument> pInst)		//
 		//	UpdateTables(pSIDInst.get());
 }
 
+void CSeqInstHandlerSID::SerializeState(CStateArchive &State)		// // //
+{
+	CSeqInstHandler::SerializeState(State);
+	State(m_pPWMValue, m_pPWMStart, m_pPWMEnd, m_pPWMSpeed, m_pPWMMode, m_pPWMDirection);
+	State(m_pFilterValue, m_pFilterStart, m_pFilterEnd, m_pFilterSpeed, m_pFilterMode, m_pFilterPass, m_pFilterDirection);
+}
+
 void CSeqInstHandlerSID::TriggerInstrument()
 {
 	CSeqInstHandler::TriggerInstrument();
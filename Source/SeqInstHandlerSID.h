@@ -54,6 +54,7 @@ public:
 		\details This reimplementation calls the channel interface to write the contents of the
 		instrument waveform to the FDS sound channel. */
 	void UpdateInstrument() override;
+	void SerializeState(CStateArchive &State) override;		// // //
 
 private:
 	void UpdateTables(const CInstrumentSID* pInst);
@@ -30,6 +30,12 @@ void CSeqInstHandlerSawtooth::TriggerInstrument()
 					m_pSequence[SEQ_VOLUME]->GetSetting() == SETTING_VOL_64_STEPS;
 }
 
+void CSeqInstHandlerSawtooth::SerializeState(CStateArchive &State)		// // //
+{
+	CSeqInstHandler::SerializeState(State);
+	State(m_bIgnoreDuty);
+}
+
 bool CSeqInstHandlerSawtooth::IsDutyIgnored() const
 {
 	return m_bIgnoreDuty;
@@ -42,6 +42,7 @@ public:
 		\details This reimplementation checks whether the current instrument uses a 64-step volume
 		sequence. */
 	void TriggerInstrument() override;
+	void SerializeState(CStateArchive &State) override;		// // //
 
 	/*!	\brief Queries whether the duty sequence should be ignored when calculating the volume.
 		\return Whether the current instrument uses a 64-step volume sequence. */
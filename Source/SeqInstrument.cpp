@@ -242,6 +242,7 @@ CSequence *CSeqInstrument::GetSequence(int SeqType) const		// // //
 void CSeqInstrument::SetSequence(int SeqType, CSequence *pSeq)		// // //
 {
 	m_pInstManager->SetSequence(m_iType, SeqType, m_iSeqIndex[SeqType], pSeq);
+	InstrumentChanged();		// // // Compiled instruments are keyed by version
 }
 
 bool CSeqInstrument::CanRelease() const
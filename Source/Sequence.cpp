@@ -20,12 +20,26 @@
 
 #include "stdafx.h"
 #include "Sequence.h"
+#include <atomic>		// // //
+
+// // // Source of sequence versions, shared by every document
+static std::atomic<unsigned long long> NextVersion { 1 };
 
 CSequence::CSequence()
 {
 	Clear();
 }
 
+unsigned long long CSequence::GetVersion() const		// // //
+{
+	return m_iVersion;
+}
+
+void CSequence::Modified()		// // //
+{
+	m_iVersion = NextVersion++;
+}
+
 void CSequence::Clear()
 {
 	m_iItemCount = 0;
@@ -36,6 +50,7 @@ void CSequence::Clear()
 	memset(m_cValues, 0, sizeof(char) * MAX_SEQUENCE_ITEMS);
 
 	m_iPlaying = -1;
+	Modified();		// // //
 }
 
 bool CSequence::operator==(const CSequence &other)		// // //
@@ -50,6 +65,7 @@ bool CSequence::operator==(const CSequence &other)		// // //
 void CSequence::SetItem(int Index, signed char Value)
 {
 	m_cValues[Index] = Value;
+	Modified();		// // //
 }
 
 void CSequence::SetItemCount(unsigned int Count)
@@ -62,6 +78,7 @@ void CSequence::SetItemCount(unsigned int Count)
 		m_iLoopPoint = -1;
 	if (m_iReleasePoint > m_iItemCount)
 		m_iReleasePoint = -1;
+	Modified();		// // //
 }
 
 void CSequence::SetLoopPoint(unsigned int Point)
@@ -69,6 +86,7 @@ void CSequence::SetLoopPoint(unsigned int Point)
 	m_iLoopPoint = Point;
 	if (m_iLoopPoint > m_iItemCount)		// // //
 		m_iLoopPoint = -1;
+	Modified();		// // //
 }
 
 void CSequence::SetReleasePoint(unsigned int Point)
@@ -76,11 +94,13 @@ void CSequence::SetReleasePoint(unsigned int Point)
 	m_iReleasePoint = Point;
 	if (m_iReleasePoint > m_iItemCount)		// // //
 		m_iReleasePoint = -1;
+	Modified();		// // //
 }
 
 void CSequence::SetSetting(seq_setting_t Setting)		// // //
 {
 	m_iSetting = Setting;
+	Modified();		// // //
 }
 
 signed char CSequence::GetItem(int Index) const
@@ -117,4 +137,5 @@ void CSequence::Copy(const CSequence *pSeq)
 	m_iSetting = pSeq->m_iSetting;
 
 	memcpy(m_cValues, pSeq->m_cValues, MAX_SEQUENCE_ITEMS);
+	Modified();		// // //
 }
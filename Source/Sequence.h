@@ -107,7 +107,15 @@ public:
 	void		 SetSetting(seq_setting_t Setting);			// // //
 	void		 Copy(const CSequence *pSeq);
 
+	// // // Changes whenever the sequence is written to
+	unsigned long long GetVersion() const;
+
+private:
+	void		 Modified();		// // //
+
 private:
+	unsigned long long m_iVersion;		// // //
+
 	// Sequence data
 	unsigned int m_iItemCount;
 	unsigned int m_iLoopPoint;
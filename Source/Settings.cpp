@@ -154,6 +154,7 @@ void CSettings::SetupSettings()
 	SETTING_INT("Sound", "Treble filter freq", 12000, &Sound.iTrebleFilter);
 	SETTING_INT("Sound", "Treble filter damping", 24, &Sound.iTrebleDamping);
 	SETTING_INT("Sound", "Volume", 100, &Sound.iMixVolume);
+	SETTING_BOOL("Sound", "Render at device rate", true, &Sound.bDeviceRate);		// // //
 
 	// Midi
 	SETTING_INT("MIDI", "Device", 0, &Midi.iMidiDevice);
@@ -163,6 +164,7 @@ void CSettings::SetupSettings()
 	SETTING_BOOL("MIDI", "Channel map", false, &Midi.bMidiChannelMap);
 	SETTING_BOOL("MIDI", "Velocity control", false,	&Midi.bMidiVelocity);
 	SETTING_BOOL("MIDI", "Auto Arpeggio", false, &Midi.bMidiArpeggio);
+	SETTING_BOOL("MIDI", "Timestamped notes", false, &Midi.bTimestampNotes);		// // //
 
 	// Appearance
 	SETTING_INT("Appearance", "Background", DEFAULT_COLOR_SCHEME.BACKGROUND, &Appearance.iColBackground);
@@ -252,11 +254,13 @@ void CSettings::SetupSettings()
 	// Emulation
 		// VRC7
 	SETTING_INT("Emulation", "VRC7 hardware patch", 9, &Emulation.iVRC7Patch);
+	SETTING_BOOL("Emulation", "OPLL native rate", false, &Emulation.bOPLLNativeRate);		// // //
 		// FDS
 	SETTING_INT("Emulation", "2C33 lowpass filter cutoff", 2000, &Emulation.iFDSLowpass);
 		// N163
 	SETTING_BOOL("Emulation", "N163 multiplexing", true, &Emulation.bNamcoMixing);
 	SETTING_INT("Emulation", "N163 lowpass filter cutoff", 12000, &Emulation.iN163Lowpass);
+	SETTING_INT("Emulation", "Emulation threads", 0, &Emulation.iEmulationThreads);
 }
 
 template<class T>
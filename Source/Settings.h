@@ -174,6 +174,7 @@ public:
 		int		iTrebleFilter;
 		int		iTrebleDamping;
 		int		iMixVolume;
+		bool	bDeviceRate;		// // // Run the APU at the stream rate instead of resampling
 	} Sound;
 
 	struct {
@@ -184,6 +185,7 @@ public:
 		bool	bMidiChannelMap;
 		bool	bMidiVelocity;
 		bool	bMidiArpeggio;
+		bool	bTimestampNotes;		// // // Play live notes at the time they arrived within a tick
 	} Midi;
 
 	struct {
@@ -286,6 +288,9 @@ public:
 		int		iN163Lowpass;
 		// VRC7
 		int		iVRC7Patch;
+		bool	bOPLLNativeRate;		// // // Also the OPLL
+		// Expansion chips emulated in parallel on this many threads, 0 = serial
+		int		iEmulationThreads;
 	} Emulation;
 
 	CString InstrumentMenuPath;
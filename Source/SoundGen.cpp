@@ -39,9 +39,18 @@
 #include "MainFrm.h"
 #include "SoundInterface.h"
 #include "WaveFile.h"		// // //
+#include "VGMWriter.h"
+#include "str_conv/str_conv.hpp"
 #include "APU/APU.h"
 #include "ChannelHandler.h"
 #include "ChannelsN163.h" // N163 channel count
+#include "ChannelsVRC7.h"		// // //
+#include "ChannelsS5B.h"		// // //
+#include "ChannelsAY8930.h"		// // //
+#include "ChannelsAY.h"		// // //
+#include "ChannelsYM2149F.h"		// // //
+#include "ChannelsOPLL.h"		// // //
+#include "Channels6581.h"		// // //
 #include "DSample.h"		// // //
 #include "SoundGen.h"
 #include "InstrumentRecorder.h"		// // //
@@ -50,6 +59,7 @@
 #include "MIDI.h"
 #include "ChannelFactory.h"		// // // test
 #include "DetuneTable.h"		// // //
+#include <algorithm>
 #include <iostream>
 #include <stdexcept>
 
@@ -65,9 +75,6 @@
 // Write a file with the volume table
 //#define WRITE_VOLUME_FILE
 
-// // // Log VGM output (experimental)
-//#define WRITE_VGM
-
 // Enable audio dithering
 //#define DITHERING
 
@@ -115,11 +122,24 @@ int dither(long size);
 // the default window message limit is 10000. Let's use 8192 for our replacement queue.
 static constexpr size_t MESSAGE_QUEUE_SIZE = 8192;
 
-CSoundGen::CSoundGen() :
+// // // Live notes are drained once per tick, this holds far more than anyone can play in one
+static constexpr size_t LIVE_NOTE_QUEUE_SIZE = 256;
+
+// // // Ticks run to reach the row playback starts from before estimating the state instead,
+// enough to reach any row from the keyframe before it at speed 32
+static constexpr int MAX_SEEK_TICKS = CPlayerKeyframes::INTERVAL * 32;
+
+// // // Ticks the background keyframe pass runs per tick of the player
+static constexpr int KEYFRAME_PASS_TICKS = 4;
+
+CSoundGen::CSoundGen(CSettings *pSettings, bool Offline) :
 	m_pInstRecorder(new CInstrumentRecorder(this)),
 	m_MessageQueue(MESSAGE_QUEUE_SIZE),
+	m_LiveNotes(LIVE_NOTE_QUEUE_SIZE),		// // //
+	m_MidiLiveNotes(LIVE_NOTE_QUEUE_SIZE),		// // //
 	m_pDocument(NULL),
 	m_pTrackerView(NULL),
+	m_pSettings(pSettings),		// // //
 	m_pSoundInterface(NULL),
 	m_pSoundStream(NULL),
 	m_pVisualizerWnd(NULL),
@@ -144,15 +164,20 @@ CSoundGen::CSoundGen() :
 	m_iMachineType(NTSC),
 	m_bRequestRenderStart(false),
 	m_bRendering(false),
+	m_bOffline(Offline),		// // //
 	m_iBPMCachePosition(0),
-	m_iRegisterStream(),
+	m_iRenderLoopRow(-1),
 	m_bWaveChanged(0),		// // //
 	m_iQueuedFrame(-1),
 	m_iPlayTrack(0),
 	m_iPlayFrame(0),
 	m_iPlayRow(0),
 	m_bDirty(false),
-	m_pSequencePlayPos(NULL),
+	m_bSeeking(false),		// // //
+	m_bExactState(false),
+	m_iExactFrame(-1),
+	m_iExactRow(-1),
+	m_iSequencePlayVersion(0),		// // //
 	m_iSequencePlayPos(0),
 	m_iSequenceTimeout(0)
 {
@@ -160,6 +185,10 @@ CSoundGen::CSoundGen() :
 		throw std::runtime_error("Could not create CSoundGen::m_hInterruptEvent");
 	}
 
+	// // // An offline generator plays on the thread that creates it
+	if (m_bOffline)
+		m_audioThreadID = std::this_thread::get_id();
+
 	TRACE("SoundGen: Object created\n");
 
 	// Create APU
@@ -173,6 +202,7 @@ CSoundGen::CSoundGen() :
 
 	// Create all kinds of channels
 	CreateChannels();
+	std::fill(std::begin(m_iLiveNoteCycle), std::end(m_iLiveNoteCycle), -1);		// // //
 
 	// Initialize emulation/mixer objects
 	UseSurveyMix = false;
@@ -181,8 +211,7 @@ CSoundGen::CSoundGen() :
 	SurveyMixLevels.resize(CHIP_LEVEL_COUNT);
 	std::fill(SurveyMixLevels.begin(), SurveyMixLevels.end(), 0);
 	UseExtOPLL = false;
-	OPLLDefaultPatchSet = theApp.GetSettings()->Emulation.iVRC7Patch;
-	OPLLDefaultPatchSet = theApp.GetSettings()->Emulation.iVRC7Patch;
+	OPLLDefaultPatchSet = m_pSettings->Emulation.iVRC7Patch;
 
 	OPLLHardwarePatchBytes.resize(19 * 8);
 	std::fill(OPLLHardwarePatchBytes.begin(), OPLLHardwarePatchBytes.end(), 0);
@@ -212,6 +241,20 @@ CSoundGen::~CSoundGen()
 // Object initialization, local
 //
 
+// // // Makes all handlers of type T use the shared registers of the first one
+template <typename T>
+static void ShareChipRegisters(CChannelHandler *const (&pChannels)[CHANNELS])
+{
+	T *pFirst = nullptr;
+	for (CChannelHandler *pChannel : pChannels)
+		if (auto pChan = dynamic_cast<T *>(pChannel)) {
+			if (pFirst)
+				pChan->ShareRegisters(*pFirst);
+			else
+				pFirst = pChan;
+		}
+}
+
 void CSoundGen::CreateChannels()
 {
 	// Only called once!
@@ -321,20 +364,30 @@ void CSoundGen::CreateChannels()
 	AssignChannel(new CTrackerChannel(_T("6581 SID 2"), _T("SI2"), SNDCHIP_6581, CHANID_6581_CH2));
 	AssignChannel(new CTrackerChannel(_T("6581 SID 3"), _T("SI3"), SNDCHIP_6581, CHANID_6581_CH3));
 
+	// // // Channels of one chip share some registers, each generator has its own set
+	ShareChipRegisters<CChannelHandlerVRC7>(m_pChannels);
+	ShareChipRegisters<CChannelHandlerS5B>(m_pChannels);
+	ShareChipRegisters<CChannelHandlerAY8930>(m_pChannels);
+	ShareChipRegisters<CChannelHandlerAY>(m_pChannels);
+	ShareChipRegisters<CChannelHandlerYM2149F>(m_pChannels);
+	ShareChipRegisters<CChannelHandlerOPLL>(m_pChannels);
+	ShareChipRegisters<CChannelHandler6581>(m_pChannels);
 }
 
 void CSoundGen::AssignChannel(CTrackerChannel *pTrackerChannel)		// // //
 {
-	static CChannelFactory F {}; // test
+	static const CChannelFactory F {}; // test
 	chan_id_t ID = pTrackerChannel->GetID();
 
 	CChannelHandler *pRenderer = F.Produce(ID);
 	if (pRenderer)
 		pRenderer->SetChannelID(ID);
 
-	static size_t Pos = 0;		// // // test
+	// Next free slot, CreateChannels() clears both arrays first
+	const size_t Pos = std::find(std::begin(m_pTrackerChannels), std::end(m_pTrackerChannels), nullptr) - std::begin(m_pTrackerChannels);
+	ASSERT(Pos < CHANNELS);
 	m_pTrackerChannels[Pos] = pTrackerChannel;
-	m_pChannels[Pos++] = pRenderer;
+	m_pChannels[Pos] = pRenderer;
 }
 
 //
@@ -343,8 +396,8 @@ void CSoundGen::AssignChannel(CTrackerChannel *pTrackerChannel)		// // //
 
 void CSoundGen::AssignDocument(CFamiTrackerDoc *pDoc)
 {
-	// Called from main thread
-	ASSERT(GetCurrentThreadId() == theApp.m_nThreadID);
+	// Called from main thread, or the thread of an offline generator
+	ASSERT(m_bOffline || GetCurrentThreadId() == theApp.m_nThreadID);		// // //
 
 	// Ignore all but the first document (as new documents are used to import files)
 	if (m_pDocument != NULL)
@@ -415,8 +468,8 @@ void CSoundGen::RegisterChannels(int Chip, CFamiTrackerDoc *pDoc)
 	// This method will add channels to the document object, depending on the expansion chip used.
 	// Called from the document object (from the main thread)
 
-	// Called from main thread
-	ASSERT(GetCurrentThreadId() == theApp.m_nThreadID);
+	// Called from main thread, or the thread of an offline generator
+	ASSERT(m_bOffline || GetCurrentThreadId() == theApp.m_nThreadID);		// // //
 
 	// This affects the sound channel interface so it must be synchronized
 	pDoc->LockDocument();
@@ -439,6 +492,10 @@ void CSoundGen::RegisterChannels(int Chip, CFamiTrackerDoc *pDoc)
 
 void CSoundGen::SelectChip(int Chip)
 {
+	// // // Offline generators set up the chip of their document in RenderOffline()
+	if (m_bOffline)
+		return;
+
 	if (IsPlaying()) {
 		StopPlayer();
 	}
@@ -472,6 +529,7 @@ void CSoundGen::DocumentPropertiesChanged(CFamiTrackerDoc *pDocument)
 		return;
 	ASSERT(pDocument != NULL);
 
+	m_Keyframes.Invalidate();		// // //
 	SetupVibratoTable(pDocument->GetVibratoStyle());		// // //
 
 	machine_t Machine = pDocument->GetMachine();
@@ -666,7 +724,7 @@ void CSoundGen::DocumentPropertiesChanged(CFamiTrackerDoc *pDocument)
 
 	m_iSpeedSplitPoint = pDocument->GetSpeedSplitPoint();
 
-	CSettings* pSettings = theApp.GetSettings();
+	CSettings* pSettings = m_pSettings;
 
 	// Set survey mix level object. Will be used by CCompiler for mixe chunk.
 	SurveyMixLevels.at(CHIP_LEVEL_APU1) = static_cast<int16_t>(pSettings->ChipLevels.iSurveyMixAPU1);
@@ -943,7 +1001,7 @@ bool CSoundGen::ResetAudioDevice()
 	ASSERT(std::this_thread::get_id() == m_audioThreadID);
 	ASSERT(m_pSoundInterface != NULL);
 
-	CSettings *pSettings = theApp.GetSettings();
+	CSettings *pSettings = m_pSettings;
 
 	// unsigned int SampleSize = pSettings->Sound.iSampleSize; (always 16)
 	unsigned int SampleRate	= pSettings->Sound.iSampleRate;
@@ -980,6 +1038,14 @@ bool CSoundGen::ResetAudioDevice()
 	}
 
 	int ResampleRate = m_pSoundStream->GetSampleRate();
+
+	// // // Blip_Buffer already band-limits and resamples from the CPU clock, so running it
+	// at the stream rate makes the sinc pass in FillBuffer() unnecessary. The configured
+	// rate is kept for WAV export (see OnStartRender), and libsamplerate remains for
+	// streams outside the range the APU is set up for.
+	if (pSettings->Sound.bDeviceRate && ResampleRate >= MIN_DEVICE_RATE && ResampleRate <= MAX_DEVICE_RATE)
+		SampleRate = ResampleRate;
+	m_iPlaybackRate = SampleRate;
 	m_resamplerArgs.src_ratio = (double) ResampleRate / (double) SampleRate;
 
 	// Create a buffer
@@ -996,6 +1062,30 @@ bool CSoundGen::ResetAudioDevice()
 			m_pVisualizerWnd->SetSampleRate(ResampleRate);
 	}
 
+	if (!SetupAPU(SampleRate))
+		return false;
+
+	m_bAudioClipping = false;
+	m_bBufferUnderrun = false;
+	m_bBufferTimeout = false;
+	m_iClipCounter = 0;
+
+	TRACE(
+		"SoundGen: Created sound channel with params: %i Hz, 16 bits, %u ms (-> %u samples), APU at %u Hz%s, %u-sample blocks\n",
+		ResampleRate, BufferLen, m_iBufSizeSamples, SampleRate, m_resamplerArgs.src_ratio != 1.0 ? " (resampled)" : "",
+		m_pAPU->GetBlockSamples());
+
+	return true;
+}
+
+bool CSoundGen::SetupAPU(unsigned int SampleRate)
+{
+	// Configures the APU for the current document, called with the APU lock held
+
+	CSettings *pSettings = m_pSettings;
+
+	m_Keyframes.Invalidate();		// // // Saved APU states only load into the same setup
+
 	if (!m_pAPU->SetupSound(SampleRate, 1, (m_iMachineType == NTSC) ? MACHINE_NTSC : MACHINE_PAL))
 		return false;
 
@@ -1036,7 +1126,8 @@ bool CSoundGen::ResetAudioDevice()
 			OPLLDefaultPatchSet,
 			UseExtOPLL,
 			OPLLHardwarePatchBytes,
-			OPLLHardwarePatchNames
+			OPLLHardwarePatchNames,
+			pSettings->Emulation.bOPLLNativeRate
 		);
 
 		// Update blip-buffer filtering and hardware-based expansion mixing
@@ -1077,14 +1168,16 @@ bool CSoundGen::ResetAudioDevice()
 		}
 	}
 
-	m_bAudioClipping = false;
-	m_bBufferUnderrun = false;
-	m_bBufferTimeout = false;
-	m_iClipCounter = 0;
+	// Offline renders already run one job per core
+	m_pAPU->SetEmulationThreads(m_bOffline ? 0 : std::max(pSettings->Emulation.iEmulationThreads, 0));
 
-	TRACE(
-		"SoundGen: Created sound channel with params: %i Hz, 16 bits, %u ms (-> %u samples)\n",
-		ResampleRate, BufferLen, m_iBufSizeSamples);
+	// // // Hand the device one period of audio at a time instead of a whole frame, so that
+	// buffers shorter than a frame do not run dry while the rest of the frame is emulated
+	unsigned int BlockSamples = 0;
+	if (!m_bOffline && m_pSoundStream)
+		BlockSamples = static_cast<unsigned int>(
+			uint64_t(m_pSoundStream->PeriodSizeFrames()) * SampleRate / m_pSoundStream->GetSampleRate());
+	m_pAPU->SetBlockSamples(BlockSamples);
 
 	return true;
 }
@@ -1172,7 +1265,9 @@ void CSoundGen::FlushBuffer(int16_t const * pBuffer, uint32_t Size)
 	// May only be called from sound player thread
 	ASSERT(std::this_thread::get_id() == m_audioThreadID);
 
-	if (!m_pSoundStream)
+	if (!m_pSoundStream && !m_bOffline)
+		return;
+	if (m_bSeeking)		// // // Nothing is heard while running forward to the first row
 		return;
 
 	FillBuffer(pBuffer, Size);
@@ -1226,10 +1321,10 @@ void CSoundGen::FillBuffer(int16_t const * pBuffer, uint32_t Size)
 	}
 
 	if (m_bRendering) {
-		// Output to file
-		ASSERT(m_pWaveFile);		// // //
+		// Output to file, VGM renders discard the audio
 		// This code needs to be changed if we add stereo support.
-		m_pWaveFile->WriteWave((char *) pBuffer, 2 * Size);
+		if (m_pWaveFile)		// // //
+			m_pWaveFile->WriteWave((char *) pBuffer, 2 * Size);
 		return;
 	}
 
@@ -1417,9 +1512,9 @@ void CSoundGen::BeginPlayer(play_mode_t Mode, int Track)
 	// Called from player thread
 	ASSERT(std::this_thread::get_id() == m_audioThreadID);
 	ASSERT(m_pDocument != NULL);
-	ASSERT(m_pTrackerView != NULL);
+	ASSERT(m_pTrackerView != NULL || m_bOffline);
 
-	if (!m_pDocument || !m_pSoundStream || !m_pDocument->IsFileLoaded())
+	if (!m_pDocument || (!m_pSoundStream && !m_bOffline) || !m_pDocument->IsFileLoaded())
 		return;
 
 	switch (Mode) {
@@ -1455,6 +1550,11 @@ void CSoundGen::BeginPlayer(play_mode_t Mode, int Track)
 			break;
 	}
 
+	// // // Keyframes taken with other module data cannot be restored
+	m_Keyframes.Validate(m_pDocument->GetPlaybackVersion());
+	if (const auto pSettings = m_pDocument->GetPlaybackSettings())
+		m_pPlaySettings = pSettings;
+
 	m_bPlaying			= true;
 	m_bHaltRequest      = false;
 	m_bDoHalt			= false;		// // //
@@ -1467,13 +1567,11 @@ void CSoundGen::BeginPlayer(play_mode_t Mode, int Track)
 	m_iPlayMode			= Mode;
 	m_bDirty			= true;
 	m_iPlayTrack		= Track;
+	LoadPlayTrack();		// // //
+	m_Keyframes.ValidateTrack(m_iPlayTrack, m_pPlayTrackData);		// // //
 
 	memset(m_bFramePlayed, false, sizeof(bool) * MAX_FRAMES);
 
-#ifdef WRITE_VGM		// // //
-	std::queue<int>().swap(m_iRegisterStream);
-#endif
-
 	{		// // // 050B
 		m_iRowTickCount = 0;
 
@@ -1487,39 +1585,290 @@ void CSoundGen::BeginPlayer(play_mode_t Mode, int Track)
 	ResetTempo();
 	ResetAPU();
 
+	// The VGM file starts from the same reset state as the APU
+	if (m_bRendering && m_pVGMWriter)
+		m_pAPU->SetRegisterSink(m_pVGMWriter.get());
+
 	MakeSilent();
 
-	m_pTrackerView->MakeSilent();
+	if (m_pTrackerView != NULL)
+		m_pTrackerView->MakeSilent();
 
-	if (theApp.GetSettings()->General.bRetrieveChanState)		// // //
-		ApplyGlobalState();
+	m_iExactFrame = m_iExactRow = -1;		// // //
+	m_bExactState = !m_bPlayLooping;
+	if (m_iPlayFrame != 0 || m_iPlayRow != 0) {
+		if (m_pSettings->General.bRetrieveChanState)
+			SeekPlayer(m_iPlayFrame, m_iPlayRow);
+		else
+			m_bExactState = false;
+	}
 
 	if (m_pInstRecorder->GetRecordChannel() != -1)		// // //
 		m_pInstRecorder->StartRecording();
 }
 
+void CSoundGen::SeekPlayer(int Frame, int Row)		// // //
+{
+	// Plays the track silently up to the row, from the nearest keyframe or else from the start,
+	// so that playback goes on exactly as if the track had been played up to there. If that takes
+	// too long, the state is estimated from the effects in the pattern data instead.
+	const bool Looping = m_bPlayLooping;
+	m_bPlayLooping = false;
+	m_bSeeking = true;
+
+	const auto Restart = [&] (int f, int r) {
+		m_iPlayFrame = f;
+		m_iPlayRow = r;
+		m_bHaltRequest = false;
+		m_bDoHalt = false;
+		m_iJumpToPattern = -1;
+		m_iSkipToRow = -1;
+		ResetTempo();
+		MakeSilent();
+	};
+
+	int KeyFrame = Frame;
+	int KeyRow = Row;
+	const CPlayerKeyframes::stKeyframe *pKeyframe = m_Keyframes.Find(m_iPlayTrack, KeyFrame, KeyRow);
+	if (!pKeyframe || !RestoreKeyframe(*pKeyframe))
+		Restart(0, 0);
+	const bool Reached = SeekFrom(Frame, Row);
+
+	if (!Reached) {
+		// The row is too far from a keyframe, or only reached after a jump back if at all
+		Restart(Frame, Row);
+		ApplyGlobalState();
+	}
+
+	m_bPlayLooping = Looping;
+	m_bSeeking = false;
+	m_bExactState = Reached && !Looping;
+
+	m_iPlayTicks = 0;
+	m_iFramesPlayed = 0;
+	m_iRowsPlayed = 0;
+	memset(m_bFramePlayed, false, sizeof(bool) * MAX_FRAMES);
+	m_bDirty = true;
+}
+
+bool CSoundGen::SeekFrom(int Frame, int Row)		// // //
+{
+	// Runs whole ticks until the row is about to be read, taking keyframes on the way.
+	// This runs within one tick of the player thread, so it gives up after MAX_SEEK_TICKS.
+	m_bExactState = true;
+	m_iExactFrame = m_iExactRow = -1;
+
+	for (int Ticks = 0; IsPlaying() && !m_bHaltRequest; ++Ticks) {
+		if (m_iTempoAccum <= 0) {
+			if (m_iPlayFrame == Frame && m_iPlayRow == Row)
+				return true;
+			if (m_iPlayFrame > Frame || (m_iPlayFrame == Frame && m_iPlayRow > Row))		// Jumped over it
+				return false;
+			CheckKeyframe();
+			if (!m_bExactState)
+				return false;
+		}
+		if (Ticks == MAX_SEEK_TICKS)
+			return false;
+		RunFrame();
+		PlayChannelNotes();
+		UpdatePlayer();
+		UpdateChannels();
+		UpdateAPU();
+	}
+
+	return false;
+}
+
+bool CSoundGen::UpdateExactState()		// // //
+{
+	// Called before a row is read. Once playback goes back, rows are no longer played the way
+	// they are when the track is played from the start.
+	if (m_iPlayFrame < m_iExactFrame || (m_iPlayFrame == m_iExactFrame && m_iPlayRow <= m_iExactRow))
+		m_bExactState = false;
+	m_iExactFrame = m_iPlayFrame;
+	m_iExactRow = m_iPlayRow;
+	return m_bExactState;
+}
+
+void CSoundGen::CheckKeyframe()		// // //
+{
+	if (UpdateExactState() && !m_bRendering && m_Keyframes.IsDue(m_iPlayTrack, m_iPlayFrame, m_iPlayRow))
+		CaptureKeyframe(m_Keyframes);
+}
+
+void CSoundGen::CaptureKeyframe(CPlayerKeyframes &Keyframes)		// // //
+{
+	auto l = DeferLock();
+	if (m_bSeeking)
+		l.lock();
+	else if (!l.try_lock())		// Taken at a later row instead
+		return;
+	CPlayerKeyframes::stKeyframe Keyframe = Keyframes.Allocate();
+	m_pAPU->SaveState(Keyframe.APU);
+	l.unlock();
+
+	CStateArchive State = CStateArchive::Saving(Keyframe.Player, &Keyframe.Objects);
+	SerializePlayerState(State);
+	Keyframes.Store(m_iPlayTrack, m_iPlayFrame, m_iPlayRow, std::move(Keyframe));
+}
+
+bool CSoundGen::RestoreKeyframe(const CPlayerKeyframes::stKeyframe &Keyframe)		// // //
+{
+	MakeSilent();
+
+	CStateArchive State = CStateArchive::Loading(Keyframe.Player, &Keyframe.Objects);
+	SerializePlayerState(State);
+	if (!State.IsValid())
+		return false;
+
+	auto l = Lock();
+	return m_pAPU->LoadState(Keyframe.APU);
+}
+
+void CSoundGen::SerializePlayerState(CStateArchive &State)		// // //
+{
+	State(m_iPlayFrame, m_iPlayRow, m_iTempo, m_iSpeed, m_iGrooveIndex, m_iGroovePosition);
+	State(m_iTempoAccum, m_iTempoDecrement, m_iTempoRemainder, m_bUpdateRow);
+	State(m_iJumpToPattern, m_iSkipToRow, m_bDoHalt, m_iLastHighlight);
+
+	for (int i = 0; i < CHANNELS; ++i) {
+		const bool Present = m_pChannels[i] != nullptr;
+		bool Saved = Present;
+		State(Saved);
+		if (Saved != Present) {
+			State.Reject();
+			return;
+		}
+		if (m_pChannels[i])
+			m_pChannels[i]->SerializeState(State);
+	}
+}
+
+bool CSoundGen::SetupKeyframePass()		// // //
+{
+	// Set up like this generator, so that the APU states it saves load into this one
+	m_iKeyframeSetup = m_Keyframes.GetSetupVersion();
+	if (!m_pKeyframeGen) {
+		m_pKeyframeGen = std::make_unique<CSoundGen>(m_pSettings, true);
+		m_pKeyframeGen->AssignDocument(m_pDocument);
+	}
+	else
+		m_pKeyframeGen->DocumentPropertiesChanged(m_pDocument);
+
+	CSoundGen &Gen = *m_pKeyframeGen;
+	Gen.m_iMachineType = m_iMachineType;
+	{
+		auto l = Gen.Lock();
+		const bool Ready = Gen.SetupAPU(m_iPlaybackRate);
+		if (Ready) {
+			Gen.m_pAPU->SetEmulationThreads(m_pAPU->GetEmulationThreads());
+			Gen.m_pAPU->SetBlockSamples(m_pAPU->GetBlockSamples());
+		}
+		l.unlock();
+		if (!Ready) {
+			m_pKeyframeGen.reset();
+			return false;
+		}
+	}
+	Gen.OnSetChip(m_pPlaySettings->ExpansionChip, 0);
+	Gen.LoadMachineSettings();
+
+	StartKeyframePass();
+	return true;
+}
+
+void CSoundGen::StartKeyframePass()		// // //
+{
+	// Goes on from the last keyframe of the selected track, or from its start
+	CSoundGen &Gen = *m_pKeyframeGen;
+	m_iKeyframeDrops = m_Keyframes.GetDropVersion();
+
+	Gen.BeginPlayer(MODE_PLAY_START, m_iPlayTrack);
+	Gen.m_bSeeking = true;
+	int Frame = MAX_FRAMES;
+	int Row = 0;
+	if (const CPlayerKeyframes::stKeyframe *pKeyframe = m_Keyframes.Find(m_iPlayTrack, Frame, Row))
+		if (!Gen.RestoreKeyframe(*pKeyframe))
+			Gen.BeginPlayer(MODE_PLAY_START, m_iPlayTrack);
+}
+
+void CSoundGen::UpdateKeyframePass()		// // //
+{
+	// A generator of its own plays the selected track silently, a few ticks per tick, and takes
+	// the keyframes that playing from the cursor restores. It starts over from the keyframes left
+	// whenever the module data they depend on changes.
+	if (m_iKeyframeSetup != m_Keyframes.GetSetupVersion() && !SetupKeyframePass())
+		return;
+	if (!m_pKeyframeGen)
+		return;
+
+	CSoundGen &Gen = *m_pKeyframeGen;
+	if (m_iKeyframeDrops != m_Keyframes.GetDropVersion() || Gen.m_iPlayTrack != m_iPlayTrack)
+		StartKeyframePass();
+
+	// The copies the keyframes were validated against in OnIdle()
+	Gen.m_pPlaySettings = m_pPlaySettings;
+	Gen.m_pPlayTrackData = m_pPlayTrackData;
+	Gen.m_iFrameRate = m_iFrameRate;
+
+	for (int i = 0; i < KEYFRAME_PASS_TICKS && Gen.IsPlaying(); ++i) {
+		// Done once playback halts or goes back, or there is no room left
+		bool Done = Gen.m_bHaltRequest || m_Keyframes.IsFull();
+		if (!Done && Gen.m_iTempoAccum <= 0) {
+			Done = !Gen.UpdateExactState();
+			if (!Done && m_Keyframes.IsDue(Gen.m_iPlayTrack, Gen.m_iPlayFrame, Gen.m_iPlayRow))
+				Gen.CaptureKeyframe(m_Keyframes);
+		}
+		if (Done) {
+			auto l = Gen.Lock();
+			Gen.HaltPlayer();
+			break;
+		}
+		Gen.RunFrame();
+		Gen.PlayChannelNotes();
+		Gen.UpdatePlayer();
+		Gen.UpdateChannels();
+		Gen.UpdateAPU();
+	}
+}
+
 void CSoundGen::ApplyGlobalState()		// // //
 {
-	int Frame = IsPlaying() ? GetPlayerFrame() : m_pTrackerView->GetSelectedFrame();
-	int Row = IsPlaying() ? GetPlayerRow() : m_pTrackerView->GetSelectedRow();
-	if (stFullState *State = m_pDocument->RetrieveSoundState(GetPlayerTrack(), Frame, Row, -1)) {
+	// Runs on the player thread, so the state is estimated from the published copies
+	const auto pTrack = m_pDocument->GetPlaybackTrack(m_iPlayTrack);
+	const auto pSettings = m_pDocument->GetPlaybackSettings();
+	if (!pTrack || !pSettings)
+		return;
+
+	const CTrackerChannel *pChannels[CHANNELS] = { };
+	for (int i = 0; i < pSettings->ChannelCount; ++i) {
+		pChannels[i] = GetTrackerChannel(pSettings->ChannelID[i]);
+		if (!pChannels[i])
+			return;
+	}
+
+	int Frame = GetPlayerFrame();
+	int Row = GetPlayerRow();
+	if (stFullState *State = CFamiTrackerDoc::RetrieveSoundState(*pTrack, pChannels, pSettings->ChannelCount, m_iSpeedSplitPoint,
+		[this] (unsigned int Index) { return GetGroove(Index) != nullptr; }, Frame, Row)) {
 		if (State->Tempo != -1)
 			m_iTempo = State->Tempo;
 		if (State->GroovePos >= 0) {
 			m_iGroovePosition = State->GroovePos;
 			if (State->Speed >= 0)
 				m_iGrooveIndex = State->Speed;
-			if (m_pDocument->GetGroove(m_iGrooveIndex) != NULL)
-				m_iSpeed = m_pDocument->GetGroove(m_iGrooveIndex)->GetEntry(m_iGroovePosition);
+			if (const auto pGroove = GetGroove(m_iGrooveIndex))		// // //
+				m_iSpeed = pGroove->GetEntry(m_iGroovePosition);
 		}
 		else {
 			if (State->Speed >= 0)
 				m_iSpeed = State->Speed;
 			m_iGrooveIndex = -1;
 		}
-		m_iLastHighlight = m_pDocument->GetHighlightAt(GetPlayerTrack(), Frame, Row).First;
+		m_iLastHighlight = pSettings->GetHighlightAt(m_iPlayTrack, Frame, Row);
 		SetupSpeed();
-		for (int i = 0; i < m_pDocument->GetChannelCount(); i++) {
+		for (int i = 0; i < pSettings->ChannelCount; i++) {
 			for (int j = 0; j < sizeof(m_pTrackerChannels) / sizeof(CTrackerChannel*); ++j)		// // // pick this out later
 				if (m_pChannels[j] && m_pTrackerChannels[j]->GetID() == State->State[i].ChannelIndex) {
 					m_pChannels[j]->ApplyChannelState(&State->State[i]); break;
@@ -1696,77 +2045,6 @@ void CSoundGen::HaltPlayer()
 		m_pTrackerView->PostAudioMessage(AM_PLAYER, m_iPlayFrame, m_iPlayRow);
 		m_pInstRecorder->StopRecording(m_pTrackerView);		// // //
 	}
-
-#ifdef WRITE_VGM		// // //
-	CFile vgm("test.vgm", CFile::modeCreate | CFile::modeWrite | CFile::typeBinary);
-	int c = 0;
-	for (int i = 0; i < 0x100; ++i)
-		vgm.Write(&c, 1);
-	int Delay = 0;
-	int DelayTotal = 0;
-	const long long VGM_SAMPLE_RATE = 44100;
-
-	while (!m_iRegisterStream.empty()) { // TODO: move this to a separate thread
-		int Val = m_iRegisterStream.front();
-		m_iRegisterStream.pop();
-		if (Val == 0x62) {
-			++Delay;
-			++DelayTotal;
-		}
-		else {
-			if (Delay) {
-				int Samples = static_cast<int>(VGM_SAMPLE_RATE * Delay / m_iFrameRate);
-				while (Samples > 0xFFFF) {
-					Samples -= 0xFFFF;
-					c = 0xFFFF61;
-					vgm.Write(&c, 3);
-				}
-				if (Samples == static_cast<int>(VGM_SAMPLE_RATE / CAPU::FRAME_RATE_NTSC)) { // 735
-					c = 0x62;
-					vgm.Write(&c, 1);
-				}
-				else if (Samples == static_cast<int>(VGM_SAMPLE_RATE / CAPU::FRAME_RATE_PAL)) { // 882
-					c = 0x63;
-					vgm.Write(&c, 1);
-				}
-				else {
-					c = 0x61 | (Samples << 8);
-					vgm.Write(&c, 3);
-				}
-				Delay = 0;
-			}
-			vgm.Write(&Val, 1);
-			Val = m_iRegisterStream.front();
-			m_iRegisterStream.pop();
-			vgm.Write(&Val, 1);
-			Val = m_iRegisterStream.front();
-			m_iRegisterStream.pop();
-			vgm.Write(&Val, 1);
-		}
-	}
-	c = 0x66;
-	vgm.Write(&c, 1);
-
-	vgm.Seek(0, CFile::begin);
-	char Header[256] = {'V', 'g', 'm', ' '};
-	*reinterpret_cast<int*>(Header + 0x04) = static_cast<int>(vgm.GetLength()) - 4;
-	*reinterpret_cast<int*>(Header + 0x08) = 0x161;
-	*reinterpret_cast<int*>(Header + 0x18) = static_cast<int>(VGM_SAMPLE_RATE * DelayTotal / m_iFrameRate);
-	*reinterpret_cast<int*>(Header + 0x24) = m_iFrameRate;
-	*reinterpret_cast<int*>(Header + 0x34) = 0xCC;
-	*reinterpret_cast<int*>(Header + 0x84) = CAPU::BASE_FREQ_NTSC;
-	if (m_pDocument) { // TODO: do this in BeginPlayer
-		if (m_pDocument->ExpansionEnabled(SNDCHIP_FDS))
-			*reinterpret_cast<int*>(Header + 0x84) |= 0x80000000;
-		if (m_pDocument->ExpansionEnabled(SNDCHIP_5B)) {
-			*reinterpret_cast<int*>(Header + 0x74) = CAPU::BASE_FREQ_NTSC / 2;
-			*reinterpret_cast<int*>(Header + 0x78) = 0x0110;
-		}
-	}
-
-	vgm.Write(Header, 256);
-	vgm.Close();
-#endif
 }
 
 void CSoundGen::ResetAPU()
@@ -1776,25 +2054,6 @@ void CSoundGen::ResetAPU()
 
 	// Reset the APU
 	m_pAPU->Reset();
-
-	// Enable all channels
-	// 2A03 series
-	WriteRegister(0x4015, 0x0F); WriteRegister(0x4017, 0x00);
-
-	WriteRegister(0x4115, 0x0F); WriteRegister(0x4117, 0x00);
-
-	WriteRegister(0x4215, 0x0F); WriteRegister(0x4217, 0x00);
-
-	// FDS
-	WriteRegister(0x4023, 0x02);
-	WriteRegister(0x4023, 0x83);
-
-	// N163
-	WriteRegister(0xE7FF, 0x00);
-
-	// MMC5
-	WriteRegister(0x5015, 0x03);
-
 	m_pAPU->ClearSample();		// // //
 }
 
@@ -1819,6 +2078,11 @@ CRegisterState *CSoundGen::GetRegState(unsigned Chip, unsigned Reg) const		// //
 	return m_pAPU->GetRegState(Chip, Reg);
 }
 
+const CRegisterJournal &CSoundGen::GetRegisterJournal() const
+{
+	return m_pAPU->GetRegisterJournal();
+}
+
 double CSoundGen::GetChannelFrequency(unsigned Chip, int Channel) const		// // //
 {
 	return m_pAPU->GetFreq(Chip, Channel);
@@ -1849,6 +2113,7 @@ void CSoundGen::ResetState()
 {
 	// Called when a new module is loaded
 	m_iPlayTrack = 0;
+	m_Keyframes.Invalidate();		// // //
 }
 
 // Get tempo values from the document
@@ -1859,21 +2124,27 @@ void CSoundGen::ResetTempo()
 	if (!m_pDocument)
 		return;
 
-	m_iSpeed = m_pDocument->GetSongSpeed(m_iPlayTrack);
-	m_iTempo = m_pDocument->GetSongTempo(m_iPlayTrack);
-	m_iLastHighlight = m_pDocument->GetHighlight().First;		// // //
+	// // // Read from the published copies, since this also runs on the player thread
+	const auto pTrack = m_pDocument->GetPlaybackTrack(m_iPlayTrack);
+	const auto pSettings = m_pDocument->GetPlaybackSettings();
+	if (!pTrack || !pSettings)
+		return;
+
+	m_iSpeed = pTrack->GetSongSpeed();
+	m_iTempo = pTrack->GetSongTempo();
+	m_iLastHighlight = pSettings->Highlight.First;		// // //
 
 	m_iTempoAccum = 0;
 
-	if (m_pDocument->GetSongGroove(m_iPlayTrack) && m_pDocument->GetGroove(m_iSpeed) != NULL) {		// // //
+	const auto pGroove = pTrack->GetSongGroove() ? GetGroove(m_iSpeed) : nullptr;
+	if (pGroove) {		// // //
 		m_iGrooveIndex = m_iSpeed;
 		m_iGroovePosition = 0;
-		if (m_pDocument->GetGroove(m_iGrooveIndex) != NULL)
-			m_iSpeed = m_pDocument->GetGroove(m_iGrooveIndex)->GetEntry(m_iGroovePosition);
+		m_iSpeed = pGroove->GetEntry(m_iGroovePosition);
 	}
 	else {
 		m_iGrooveIndex = -1;
-		if (m_pDocument->GetSongGroove(m_iPlayTrack))
+		if (pTrack->GetSongGroove())
 			m_iSpeed = DEFAULT_SPEED;
 	}
 	SetupSpeed();
@@ -1906,9 +2177,10 @@ float CSoundGen::GetTempo() const
 
 	float Speed;
 	if (m_iGrooveIndex != -1) {
-		if (m_pDocument->GetGroove(m_iGrooveIndex) == NULL)
+		const auto pGroove = GetGroove(m_iGrooveIndex);		// // //
+		if (!pGroove)
 			Speed = DEFAULT_SPEED;
-		else Speed = m_pDocument->GetGroove(m_iGrooveIndex)->GetAverage();
+		else Speed = pGroove->GetAverage();
 	}
 	else Speed = static_cast<float>(m_iSpeed);
 
@@ -1929,7 +2201,7 @@ float CSoundGen::GetAverageBPM() const		// // // 050B
 float CSoundGen::GetCurrentBPM() const		// // //
 {
 	float EngineSpeed = static_cast<float>(m_pDocument->GetFrameRate());
-	float BPM = std::min(IsPlaying() && theApp.GetSettings()->Display.bAverageBPM ? GetAverageBPM() : GetTempo(),
+	float BPM = std::min(IsPlaying() && m_pSettings->Display.bAverageBPM ? GetAverageBPM() : GetTempo(),
 						 EngineSpeed * 15);		// // // 050B
 	return static_cast<float>(BPM * 4. / (m_iLastHighlight ? m_iLastHighlight : 4));
 }
@@ -1939,10 +2211,11 @@ void CSoundGen::RunFrame()
 	// Called from player thread
 	ASSERT(std::this_thread::get_id() == m_audioThreadID);
 	ASSERT(m_pDocument != NULL);
-	ASSERT(m_pTrackerView != NULL);
+	ASSERT(m_pTrackerView != NULL || m_bOffline);
 
 	// View callback
-	m_pTrackerView->PlayerTick();
+	if (m_pTrackerView != NULL && !m_bSeeking)		// // //
+		m_pTrackerView->PlayerTick();
 
 	if (IsPlaying()) {
 
@@ -1958,6 +2231,9 @@ void CSoundGen::RunFrame()
 				if (m_iRowsPlayed >= m_iRenderEndParam && m_iTempoAccum <= 0)		// // //
 					m_bRequestRenderStop = m_bHaltRequest = true;
 			}
+			// The song ends here, the VGM file leaves out the silent frames after it
+			if (m_bRequestRenderStop && m_pVGMWriter)
+				CloseVGMFile();
 		}
 
 		++m_iRowTickCount;		// // // 050B
@@ -1967,20 +2243,21 @@ void CSoundGen::RunFrame()
 		if (m_iTempoAccum <= 0) {
 			// Enable this to skip rows on high tempos
 //			while (m_iTempoAccum <= 0)  {
-			if (m_iGrooveIndex != -1 && m_pDocument->GetGroove(m_iGrooveIndex) != NULL) {		// // //
-				m_iSpeed = m_pDocument->GetGroove(m_iGrooveIndex)->GetEntry(m_iGroovePosition);
+			if (const auto pGroove = m_iGrooveIndex != -1 ? GetGroove(m_iGrooveIndex) : nullptr) {		// // //
+				m_iSpeed = pGroove->GetEntry(m_iGroovePosition);
 				SetupSpeed();
 				m_iGroovePosition++;
 			}
 				m_iStepRows++;
 //			}
 			m_bUpdateRow = true;
+			if (m_pVGMWriter && m_iRenderRow == m_iRenderLoopRow)
+				m_pVGMWriter->MarkLoop(m_pAPU->GetCycleCount());
 			ReadPatternRow();
 			++m_iRenderRow;
 
-			if (auto pMark = m_pDocument->GetBookmarkAt(m_iPlayTrack, m_iPlayFrame, m_iPlayRow))		// // //
-				if (pMark->m_Highlight.First != -1)
-					m_iLastHighlight = pMark->m_Highlight.First;
+			if (auto pMark = m_pPlaySettings->GetMarkAt(m_iPlayTrack, m_iPlayFrame, m_iPlayRow))		// // //
+				m_iLastHighlight = pMark->Highlight;
 
 			// // // 050B
 			m_fBPMCacheValue[m_iBPMCachePosition] = GetTempo();		// // // 050B
@@ -1997,7 +2274,7 @@ void CSoundGen::RunFrame()
 void CSoundGen::CheckControl()
 {
 	// This function takes care of jumping and skipping
-	ASSERT(m_pTrackerView != NULL);
+	ASSERT(m_pTrackerView != NULL || m_bOffline);
 
 	if (IsPlaying()) {
 		if (m_bDoHalt) {		// // //
@@ -2029,7 +2306,7 @@ void CSoundGen::CheckControl()
 
 	if (m_bDirty) {
 		m_bDirty = false;
-		if (!m_bRendering)
+		if (!m_bRendering && !m_bSeeking && m_pTrackerView != NULL)		// // //
 			m_pTrackerView->PostAudioMessage(AM_PLAYER, m_iPlayFrame, m_iPlayRow);
 	}
 }
@@ -2045,6 +2322,7 @@ void CSoundGen::LoadMachineSettings()		// // //
 
 	ASSERT(m_pAPU != NULL);
 
+	m_Keyframes.Invalidate();		// // //
 	m_iMachineType = m_pDocument->GetMachine();		// // // 050B
 
 	int BaseFreq	= (m_iMachineType == NTSC) ? CAPU::BASE_FREQ_NTSC  : CAPU::BASE_FREQ_PAL;
@@ -2057,6 +2335,7 @@ void CSoundGen::LoadMachineSettings()		// // //
 
 	// Number of cycles between each APU update
 	m_iUpdateCycles = BaseFreq / Rate;
+	m_LiveNoteScheduler.SetTickLength(m_iUpdateCycles, BaseFreq);		// // //
 
 	{
 		auto l = Lock();
@@ -2152,12 +2431,15 @@ void CSoundGen::EvaluateGlobalEffects(stChanNote *NoteData, int EffColumns)
 			// Oxx: Sets groove to xx
 			// currently does not support starting at arbitrary index of a groove
 			case EF_GROOVE:		// // //
-				if (m_pDocument->GetGroove(EffParam % MAX_GROOVE) == NULL) break;
+			{
+				const auto pGroove = GetGroove(EffParam % MAX_GROOVE);
+				if (!pGroove) break;
 				m_iGrooveIndex = EffParam % MAX_GROOVE;
-				m_iSpeed = m_pDocument->GetGroove(m_iGrooveIndex)->GetEntry(0);
+				m_iSpeed = pGroove->GetEntry(0);
 				m_iGroovePosition = 1;
 				SetupSpeed();
 				break;
+			}
 
 			// Bxx: Jump to pattern xx
 			case EF_JUMP:
@@ -2188,7 +2470,7 @@ void CSoundGen::EvaluateGlobalEffects(stChanNote *NoteData, int EffColumns)
 
 // File rendering functions
 
-bool CSoundGen::RenderToFile(LPTSTR pFile, render_end_t SongEndType, int SongEndParam, int Track)
+bool CSoundGen::RenderToFile(LPTSTR pFile, render_end_t SongEndType, int SongEndParam, int Track, const std::vector<stRenderStem> &Stems, render_format_t Format)
 {
 	// Called from main thread
 	ASSERT(GetCurrentThreadId() == theApp.m_nThreadID);
@@ -2202,33 +2484,100 @@ bool CSoundGen::RenderToFile(LPTSTR pFile, render_end_t SongEndType, int SongEnd
 
 	auto l = Lock();
 
-	m_iRenderEndWhen = SongEndType;
-	m_iRenderEndParam = SongEndParam;
-	m_iRenderTrack = Track;
-	m_iRenderRowCount = 0;
-	m_iRenderRow = 0;
+	SetupRenderLength(m_pDocument, SongEndType, SongEndParam, Track, Format);
 
-	if (m_iRenderEndWhen == SONG_TIME_LIMIT) {
-		// This variable is stored in seconds, convert to frames
-		m_iRenderEndParam *= m_pDocument->GetFrameRate();
-	}
-	else if (m_iRenderEndWhen == SONG_LOOP_LIMIT) {
-		m_iRenderEndParam = m_pDocument->ScanActualLength(Track, m_iRenderEndParam);		// // //
-		m_iRenderRowCount = m_iRenderEndParam;
+	ASSERT(!m_bRendering);
+	ASSERT(m_pWaveFile == nullptr && m_pVGMWriter == nullptr);
+	ASSERT(m_RenderStems.empty());
+	if (Format == RENDER_VGM) {
+		if (!OpenVGMFile(pFile)) {
+			m_pTrackerView->PostAudioMessage(AM_ERROR, IDS_FILE_OPEN_ERROR);
+			return false;
+		}
+		m_bRequestRenderStart = true;
+		PostGuiMessage(WM_USER_START_RENDER, 0, 0);
+		return true;
 	}
 
-	ASSERT(!m_bRendering);
-	ASSERT(m_pWaveFile == nullptr);
 	m_pWaveFile = std::make_unique<CWaveFile>();
 	// Unfortunately, destructor doesn't cleanup object. Only CloseFile() does.
 	if (!m_pWaveFile ||
-		!m_pWaveFile->OpenFile(pFile, theApp.GetSettings()->Sound.iSampleRate, 16, 1)) {
+		!m_pWaveFile->OpenFile(pFile, m_pSettings->Sound.iSampleRate, 16, 1)) {
 		m_pTrackerView->PostAudioMessage(AM_ERROR, IDS_FILE_OPEN_ERROR);
 		return false;
 	}
+
+	for (const auto &Stem : Stems) {
+		auto pStemFile = std::make_unique<CStemWaveFile>();
+		if (!pStemFile->OpenFile(const_cast<LPTSTR>((LPCTSTR)Stem.File), m_pSettings->Sound.iSampleRate)) {
+			CloseStemFiles();
+			m_pWaveFile->CloseFile();
+			m_pWaveFile.reset();
+			m_pTrackerView->PostAudioMessage(AM_ERROR, IDS_FILE_OPEN_ERROR);
+			return false;
+		}
+		m_RenderStems.emplace_back(Stem.ChanID, std::move(pStemFile));
+	}
+
+	m_bRequestRenderStart = true;
+	PostGuiMessage(WM_USER_START_RENDER, 0, 0);
+
+	return true;
+}
+
+bool CSoundGen::RenderOffline(LPTSTR pFile, render_end_t SongEndType, int SongEndParam, int Track, render_format_t Format)
+{
+	// Called from the thread that created this generator, which never starts a player thread.
+	// The document belongs to this generator alone, so nothing else reads or writes it.
+	ASSERT(m_bOffline && !m_audioThread.joinable());
+	ASSERT(std::this_thread::get_id() == m_audioThreadID);
+	ASSERT(m_pDocument != NULL && m_pDocument->IsFileLoaded());
+
+	const unsigned int SampleRate = m_pSettings->Sound.iSampleRate;
+
+	// Same setup as ResetAudioDevice() and OnSetChip(), AssignDocument() has set up the channels
+	m_iMachineType = m_pDocument->GetMachine();
+	{
+		auto l = Lock();
+		if (!SetupAPU(SampleRate))
+			return false;
+		auto config = CAPUConfig(m_pAPU);
+		config.SetExternalSound(m_pDocument->GetExpansionChip());
+	}
+
+	SetupRenderLength(m_pDocument, SongEndType, SongEndParam, Track, Format);
+
+	LoadMachineSettings();
+	ResetAPU();
+	HaltPlayer();
+
+	if (Format == RENDER_VGM) {
+		if (!OpenVGMFile(pFile))
+			return false;
+	}
 	else {
-		m_bRequestRenderStart = true;
-		PostGuiMessage(WM_USER_START_RENDER, 0, 0);
+		m_pWaveFile = std::make_unique<CWaveFile>();
+		if (!m_pWaveFile->OpenFile(pFile, SampleRate, 16, 1)) {
+			m_pWaveFile.reset();
+			return false;
+		}
+	}
+
+	// Same as OnStartRender(), then run the player loop until StopRendering()
+	ResetBuffer();
+	m_bRequestRenderStop = false;
+	m_bStoppingRender = false;
+	m_bRendering = true;
+	m_iDelayedStart = 5;	// Wait 5 frames until player starts
+	m_iDelayedEnd = 5;
+
+	while (m_bRendering) {
+		if (m_maybeSelfMessage) {
+			GuiMessage message = *m_maybeSelfMessage;
+			m_maybeSelfMessage = {};
+			DispatchGuiMessage(message);
+		}
+		OnIdle();
 	}
 
 	return true;
@@ -2251,14 +2600,82 @@ void CSoundGen::StopRendering()
 	m_bRequestRenderStop = false;		// // //
 	m_iPlayFrame = 0;
 	m_iPlayRow = 0;
-	m_pWaveFile->CloseFile();		// // //
-	m_pWaveFile.reset();
+	if (m_pWaveFile) {
+		m_pWaveFile->CloseFile();		// // //
+		m_pWaveFile.reset();
+	}
+	if (m_pVGMWriter)
+		CloseVGMFile();
+	m_pAPU->SetStems({ }, 0);
+	CloseStemFiles();
+
+	// // // Back to the rate ResetAudioDevice() picked for playback
+	if (!m_bOffline && m_iPlaybackRate && m_iPlaybackRate != static_cast<unsigned>(m_pSettings->Sound.iSampleRate))
+		SetupAPU(m_iPlaybackRate);
 
 	ResetBuffer();
 	ResetAPU();		// // //
 	HaltPlayer();
 }
 
+void CSoundGen::SetupRenderLength(const CFamiTrackerDoc *pDoc, render_end_t SongEndType, int SongEndParam, int Track, render_format_t Format)
+{
+	m_iRenderEndWhen = SongEndType;
+	m_iRenderEndParam = SongEndParam;
+	m_iRenderTrack = Track;
+	m_iRenderRowCount = 0;
+	m_iRenderRow = 0;
+	m_iRenderLoopRow = -1;
+
+	if (m_iRenderEndWhen == SONG_TIME_LIMIT) {
+		// This variable is stored in seconds, convert to frames
+		m_iRenderEndParam *= pDoc->GetFrameRate();
+	}
+	else if (m_iRenderEndWhen == SONG_LOOP_LIMIT) {
+		m_iRenderEndParam = pDoc->ScanActualLength(Track, m_iRenderEndParam);		// // //
+		m_iRenderRowCount = m_iRenderEndParam;
+
+		// Every loop after the first one has the same length, the intro is the difference
+		if (Format == RENDER_VGM) {
+			const unsigned int First = pDoc->ScanActualLength(Track, 1);
+			const unsigned int Second = pDoc->ScanActualLength(Track, 2);
+			if (Second > First)
+				m_iRenderLoopRow = 2 * First - Second;
+		}
+	}
+}
+
+bool CSoundGen::OpenVGMFile(LPTSTR pFile)
+{
+	auto pWriter = std::make_unique<CVGMWriter>();
+	const uint32_t Clock = (m_pDocument->GetMachine() == NTSC) ? CAPU::BASE_FREQ_NTSC : CAPU::BASE_FREQ_PAL;
+	if (!pWriter->Open(pFile, m_pDocument->GetExpansionChip(), Clock, m_pDocument->GetFrameRate()))
+		return false;
+
+	const CString Title = m_pDocument->GetTrackTitle(m_iRenderTrack);
+	const CString Name(m_pDocument->GetSongName());
+	const CString Artist(m_pDocument->GetSongArtist());
+	const CString Copyright(m_pDocument->GetSongCopyright());
+	pWriter->SetTags(conv::to_utf16(Title), conv::to_utf16(Name), conv::to_utf16(Artist), conv::to_utf16(Copyright));
+
+	m_pVGMWriter = std::move(pWriter);
+	return true;
+}
+
+void CSoundGen::CloseStemFiles()
+{
+	for (auto &Stem : m_RenderStems)
+		Stem.second->CloseFile();
+	m_RenderStems.clear();
+}
+
+void CSoundGen::CloseVGMFile()
+{
+	m_pAPU->SetRegisterSink(nullptr);
+	m_pVGMWriter->Close(m_pAPU->GetCycleCount());
+	m_pVGMWriter.reset();
+}
+
 void CSoundGen::GetRenderStat(int &Frame, int &Time, bool &Done, int &FramesToRender, int &Row, int &RowCount) const
 {
 	Frame = m_iFramesPlayed;
@@ -2279,11 +2696,22 @@ bool CSoundGen::IsBackgroundTask() const
 	return m_bRendering;
 }
 
+bool CSoundGen::IsOffline() const		// // //
+{
+	return m_bOffline;
+}
+
+CSettings *CSoundGen::GetSettings() const		// // //
+{
+	return m_pSettings;
+}
+
 // DPCM handling
 
 void CSoundGen::PlaySample(const CDSample *pSample, int Offset, int Pitch)
 {
 	SAFE_RELEASE(m_pPreviewSample);
+	m_bExactState = false;		// // //
 
 	// Sample may not be removed when used by the sample memory class!
 	m_pAPU->WriteSample(pSample->GetData(), pSample->GetSize());		// // //
@@ -2421,33 +2849,48 @@ void CSoundGen::OnIdle()
 	// Main loop for audio playback thread
 	//
 
-	if (!m_pDocument || !m_pSoundStream || !m_pDocument->IsFileLoaded()) {
+	if (!m_pDocument || (!m_pSoundStream && !m_bOffline) || !m_pDocument->IsFileLoaded()) {
+		Sleep(100);
+		return;
+	}
+
+	// // // Module settings and pattern data come from the copies published by the editor,
+	// so a tick never waits for the document lock and never skips
+	const unsigned long long Version = m_pDocument->GetPlaybackVersion();		// // // Read first, see CPlayerKeyframes
+	m_pPlaySettings = m_pDocument->GetPlaybackSettings();
+	if (!m_pPlaySettings) {
 		Sleep(100);
 		return;
 	}
+	LoadPlayTrack();
+	{		// // // Rows already played may have changed
+		const bool Valid = m_Keyframes.Validate(Version);
+		const unsigned int Changed = m_Keyframes.ValidateTrack(m_iPlayTrack, m_pPlayTrackData);
+		if (!Valid || Changed <= static_cast<unsigned int>(m_iPlayFrame))
+			m_bExactState = false;
+	}
 
 	++m_iFrameCounter;
 
-	// Access the document object, skip if access wasn't granted to avoid gaps in audio playback
-	if (m_pDocument->LockDocument(0)) {
+	// Read module framerate
+	m_iFrameRate = m_pPlaySettings->FrameRate;
 
-		// Read module framerate
-		m_iFrameRate = m_pDocument->GetFrameRate();
+	if (IsPlaying() && m_iTempoAccum <= 0)		// // // Before the row is read
+		CheckKeyframe();
 
-		RunFrame();
+	RunFrame();
 
-		// Play queued notes
-		PlayChannelNotes();
+	// // // Take the notes played live since the last tick
+	ReadLiveNotes();
 
-		// Update player
-		UpdatePlayer();
+	// Play queued notes
+	PlayChannelNotes();
 
-		// Channel updates (instruments, effects etc)
-		UpdateChannels();
+	// Update player
+	UpdatePlayer();
 
-		// Unlock document
-		m_pDocument->UnlockDocument();
-	}
+	// Channel updates (instruments, effects etc)
+	UpdateChannels();
 
 	// Update APU registers
 	UpdateAPU();
@@ -2486,6 +2929,37 @@ void CSoundGen::OnIdle()
 		delete m_pPreviewSample;
 		m_pPreviewSample = NULL;
 	}
+
+	// // // Keyframes for playing from the cursor, built while the player is stopped
+	if (!m_bOffline && !IsPlaying() && !m_bRendering && m_pSettings->General.bRetrieveChanState)
+		UpdateKeyframePass();
+}
+
+void CSoundGen::ReadLiveNotes()		// // //
+{
+	// Live notes go straight to the channels, and the channel is refreshed at the cycle
+	// within this tick that matches the time the note was played (see CLiveNoteScheduler)
+	const bool Timestamps = m_pSettings->Midi.bTimestampNotes;
+	m_LiveNoteScheduler.BeginTick(CLiveNoteScheduler::Now());
+
+	const auto Read = [&] (rigtorp::SPSCQueue<stLiveNote> &Queue) {
+		while (auto pNote = Queue.front()) {
+			const stRoutedNote &Routed = pNote->Routed;
+			stChanNote Note = Routed.Note;
+			m_pTrackerChannels[Routed.ChanID]->SetNote(Note, NOTE_PRIO_2);
+			if (Routed.ForceReload)
+				m_pChannels[Routed.ChanID]->ForceReloadInstrument();
+			m_bExactState = false;		// Not part of the track
+			if (Timestamps)
+				m_iLiveNoteCycle[Routed.ChanID] = m_LiveNoteScheduler.Place(pNote->Time);
+			// MIDI out is written here, since the MIDI input callback must not call it
+			if (m_pTrackerView != NULL)
+				theApp.GetMIDI()->WriteNote(Routed.Channel, Note.Note, Note.Octave, Note.Vol);
+			Queue.pop();
+		}
+	};
+	Read(m_LiveNotes);
+	Read(m_MidiLiveNotes);
 }
 
 void CSoundGen::PlayChannelNotes()
@@ -2493,23 +2967,26 @@ void CSoundGen::PlayChannelNotes()
 	// Read notes
 	for (int i = 0; i < CHANNELS; ++i) {		// // //
 		int Index = m_pTrackerChannels[i]->GetID();
-		int Channel = m_pDocument->GetChannelIndex(m_pTrackerChannels[Index]->GetID());
+		int Channel = m_pPlaySettings->GetChannelIndex(m_pTrackerChannels[Index]->GetID());		// // //
 		if (Channel == -1) continue;
 
 		// Run auto-arpeggio, if enabled
-		int Arpeggio = m_pTrackerView->GetAutoArpeggio(Channel);
+		int Arpeggio = m_pTrackerView != NULL && !m_bSeeking ? m_pTrackerView->GetAutoArpeggio(Channel) : 0;		// // //
 		if (Arpeggio > 0) {
 			m_pChannels[Index]->Arpeggiate(Arpeggio);
+			m_bExactState = false;		// // //
 		}
 
 		// Check if new note data has been queued for playing
 		if (m_pTrackerChannels[Index]->NewNoteData()) {
 			stChanNote Note = m_pTrackerChannels[Index]->GetNote();
-			PlayNote(Index, &Note, m_pDocument->GetEffColumns(m_iPlayTrack, Channel) + 1);
+			PlayNote(Index, &Note, m_pPlayTrackData->GetEffectColumnCount(Channel) + 1);		// // //
 		}
 
 		// Pitch wheel
-		int Pitch = m_pTrackerChannels[Index]->GetPitch();
+		int Pitch = m_bSeeking ? 0 : m_pTrackerChannels[Index]->GetPitch();		// // //
+		if (Pitch != 0)
+			m_bExactState = false;
 		m_pChannels[Index]->SetPitch(Pitch);
 
 		// Update volume meters
@@ -2529,7 +3006,7 @@ void CSoundGen::UpdatePlayer()
 
 	if (m_bPlaying) {
 		if (m_iTempoAccum <= 0) {
-			int TicksPerSec = m_pDocument->GetFrameRate();
+			int TicksPerSec = m_iFrameRate;		// // //
 			m_iTempoAccum += (m_iTempo ? 60 * TicksPerSec : m_iSpeed) - m_iTempoRemainder;		// // //
 		}
 		m_iTempoAccum -= m_iTempoDecrement;
@@ -2560,10 +3037,12 @@ void CSoundGen::UpdateAPU()
 		unsigned int PrevChip = SNDCHIP_NONE;		// // // 050B
 		for (int i = 0; i < CHANNELS; ++i) {
 			if (m_pChannels[i] != NULL) {
+				if (m_iLiveNoteCycle[i] != -1)		// // // Refreshed below
+					continue;
 				m_pChannels[i]->RefreshChannel();
 				m_pChannels[i]->FinishTick();		// // //
 				unsigned int Chip = m_pTrackerChannels[i]->GetChip();
-				if (m_pDocument->ExpansionEnabled(Chip)) {
+				if (m_pPlaySettings->ExpansionEnabled(Chip)) {		// // //
 					int Delay = (Chip == PrevChip) ? 150 : 250;
 
 					AddCyclesUnlessEndOfFrame(Delay);
@@ -2573,10 +3052,25 @@ void CSoundGen::UpdateAPU()
 				}
 			}
 		}
-#ifdef WRITE_VGM		// // //
-		if (m_bPlaying)
-			m_iRegisterStream.push(0x62);		// // //
-#endif
+
+		// // // Channels with a live note, in the order the notes were played
+		int LiveChannels[CHANNELS];
+		int LiveCount = 0;
+		for (int i = 0; i < CHANNELS; ++i)
+			if (m_pChannels[i] != NULL && m_iLiveNoteCycle[i] != -1)
+				LiveChannels[LiveCount++] = i;
+		std::stable_sort(LiveChannels, LiveChannels + LiveCount, [&] (int a, int b) {
+			return m_iLiveNoteCycle[a] < m_iLiveNoteCycle[b];
+		});
+		for (int n = 0; n < LiveCount; ++n) {
+			const int i = LiveChannels[n];
+			if (m_iLiveNoteCycle[i] > m_iConsumedCycles) {
+				AddCyclesUnlessEndOfFrame(m_iLiveNoteCycle[i] - m_iConsumedCycles);
+				m_pAPU->Process();
+			}
+			m_pChannels[i]->RefreshChannel();
+			m_pChannels[i]->FinishTick();
+		}
 
 		// Finish the audio frame
 		if (m_iConsumedCycles > m_iUpdateCycles) {
@@ -2588,7 +3082,7 @@ void CSoundGen::UpdateAPU()
 	};
 
 	{
-		if (m_bRendering) {
+		if (m_bRendering || m_bSeeking) {		// // //
 			auto l = Lock();
 			UpdateAPUImpl();
 			l.unlock();
@@ -2599,11 +3093,15 @@ void CSoundGen::UpdateAPU()
 				UpdateAPUImpl();
 				l.unlock();
 			}
-			else TRACE("SoundGen: APU mutex lock failed\n");
+			else {
+				TRACE("SoundGen: APU mutex lock failed\n");
+				m_bExactState = false;		// // // The tick was skipped
+			}
 		}
 	}
 
 	m_iConsumedCycles = 0;
+	std::fill(std::begin(m_iLiveNoteCycle), std::end(m_iLiveNoteCycle), -1);		// // //
 
 #ifdef LOGGING
 	if (m_bPlaying)
@@ -2653,9 +3151,22 @@ void CSoundGen::OnResetPlayer(WPARAM wParam, LPARAM lParam)
 void CSoundGen::OnStartRender(WPARAM wParam, LPARAM lParam)
 {
 	auto l = Lock();
+
+	// // // Playback may run the APU at the device rate, files are written at the configured rate
+	const unsigned int RenderRate = m_pSettings->Sound.iSampleRate;
+	const bool Ready = RenderRate == m_iPlaybackRate || SetupAPU(RenderRate);
+	if (!Ready)
+		m_pTrackerView->PostAudioMessage(AM_ERROR, IDS_SOUND_BUFFER_ERROR, MB_ICONERROR);
+
+	// The stems start out reset, ResetBuffer() brings the mix to the same state
+	std::vector<std::pair<int, IAudioCallback *>> Stems;
+	for (const auto &Stem : m_RenderStems)
+		Stems.emplace_back(Stem.first, Stem.second.get());
+	m_pAPU->SetStems(Stems, std::thread::hardware_concurrency());
+
 	ResetBuffer();
 	m_bRequestRenderStart = false;
-	m_bRequestRenderStop = false;
+	m_bRequestRenderStop = !Ready;		// // // Closes the files through StopRendering()
 	m_bStoppingRender = false;		// // //
 	m_bRendering = true;
 	m_iDelayedStart = 5;	// Wait 5 frames until player starts
@@ -2674,6 +3185,7 @@ void CSoundGen::OnPreviewSample(WPARAM wParam, LPARAM lParam)
 
 void CSoundGen::OnWriteAPU(WPARAM wParam, LPARAM lParam)
 {
+	m_bExactState = false;		// // //
 	m_pAPU->Write((uint16_t)wParam, (uint8_t)lParam);
 }
 
@@ -2691,6 +3203,7 @@ void CSoundGen::OnSetChip(WPARAM wParam, LPARAM lParam)
 {
 	int Chip = static_cast<int>(wParam);
 
+	m_Keyframes.Invalidate();		// // //
 	auto l = Lock();
 
 	{
@@ -2712,6 +3225,8 @@ void CSoundGen::OnRemoveDocument(WPARAM wParam, LPARAM lParam)
 	// Remove document and view pointers
 	m_pDocument = NULL;
 	m_pTrackerView = NULL;
+	m_Keyframes.Invalidate();		// // //
+	m_pKeyframeGen.reset();		// // // It plays the same document
 	m_pInstRecorder->SetDumpCount(0);		// // //
 	m_pInstRecorder->ReleaseCurrent();
 	// m_pInstRecorder->ResetDumpInstrument();
@@ -2723,7 +3238,7 @@ void CSoundGen::OnRemoveDocument(WPARAM wParam, LPARAM lParam)
 
 void CSoundGen::RegisterKeyState(int Channel, int Note)
 {
-	if (m_pTrackerView != NULL)
+	if (m_pTrackerView != NULL && !m_bSeeking)		// // //
 		m_pTrackerView->PostAudioMessage(AM_NOTE_EVENT, Channel, Note);
 }
 
@@ -2742,14 +3257,32 @@ bool CSoundGen::HasWaveChanged() const
 
 // Player state functions
 
+void CSoundGen::LoadPlayTrack()		// // //
+{
+	// Taken once per tick, so that a tick never sees part of an edit. The editor
+	// copies any pattern it writes to while this copy shares it.
+	m_pPlayTrackData = m_pDocument->GetPlaybackTrack(m_iPlayTrack);
+	if (!m_pPlayTrackData) {
+		static const std::shared_ptr<const CPatternData> EMPTY = std::make_shared<CPatternData>();
+		m_pPlayTrackData = EMPTY;
+	}
+}
+
 void CSoundGen::ReadPatternRow()
 {
-	const int Channels = m_pDocument->GetChannelCount();
-	stChanNote NoteData;
+	const stPlaybackSettings &Settings = *m_pPlaySettings;		// // //
+	const CPatternData &Track = *m_pPlayTrackData;		// // //
 
-	for (int i = 0; i < Channels; ++i) {
-		if (m_pTrackerView->PlayerGetNote(m_iPlayTrack, m_iPlayFrame, i, m_iPlayRow, NoteData))
-			QueueNote(i, NoteData, NOTE_PRIO_1);
+	for (int i = 0; i < Settings.ChannelCount; ++i) {
+		stChanNote NoteData = Track.GetNote(i, Track.GetFramePattern(m_iPlayFrame, i), m_iPlayRow);		// // //
+		if (m_pTrackerView == NULL || m_bSeeking)		// // // offline render or seek, nothing is muted
+			QueueChannelNote(i, Settings.ChannelID[i], NoteData, NOTE_PRIO_1);
+		else {
+			if (m_pTrackerView->IsChannelMuted(i))		// // //
+				m_bExactState = false;
+			if (m_pTrackerView->PlayerFilterNote(i, Track.GetEffectColumnCount(i) + 1, NoteData))
+				QueueChannelNote(i, Settings.ChannelID[i], NoteData, NOTE_PRIO_1);
+		}
 	}
 	if (m_bDoHalt) {		// // //
 		m_bHaltRequest = true;
@@ -2758,7 +3291,7 @@ void CSoundGen::ReadPatternRow()
 
 void CSoundGen::PlayerStepRow()
 {
-	const int PatternLen = m_pDocument->GetPatternLength(m_iPlayTrack);
+	const int PatternLen = m_pPlayTrackData->GetPatternLength();		// // //
 
 	if (++m_iPlayRow >= PatternLen) {
 		m_iPlayRow = 0;
@@ -2773,17 +3306,18 @@ void CSoundGen::PlayerStepRow()
 
 void CSoundGen::PlayerStepFrame()
 {
-	const int Frames = m_pDocument->GetFrameCount(m_iPlayTrack);
+	const int Frames = m_pPlayTrackData->GetFrameCount();		// // //
 
 	m_bFramePlayed[m_iPlayFrame] = true;
 
-	if (m_iQueuedFrame == -1) {
+	if (m_iQueuedFrame == -1 || m_bSeeking) {		// // // Kept for the actual playback
 		if (++m_iPlayFrame >= Frames)
 			m_iPlayFrame = 0;
 	}
 	else {
 		m_iPlayFrame = m_iQueuedFrame;
 		m_iQueuedFrame = -1;
+		m_bExactState = false;		// // //
 	}
 
 	++m_iFramesPlayed;
@@ -2793,7 +3327,7 @@ void CSoundGen::PlayerStepFrame()
 
 void CSoundGen::PlayerJumpTo(int Frame)
 {
-	const int Frames = m_pDocument->GetFrameCount(m_iPlayTrack);
+	const int Frames = m_pPlayTrackData->GetFrameCount();		// // //
 
 	m_bFramePlayed[m_iPlayFrame] = true;
 
@@ -2812,8 +3346,8 @@ void CSoundGen::PlayerJumpTo(int Frame)
 
 void CSoundGen::PlayerSkipTo(int Row)
 {
-	const int Frames = m_pDocument->GetFrameCount(m_iPlayTrack);
-	const int Rows = m_pDocument->GetPatternLength(m_iPlayTrack);
+	const int Frames = m_pPlayTrackData->GetFrameCount();		// // //
+	const int Rows = m_pPlayTrackData->GetPatternLength();		// // //
 
 	m_bFramePlayed[m_iPlayFrame] = true;
 
@@ -2836,16 +3370,43 @@ void CSoundGen::QueueNote(int Channel, stChanNote &NoteData, note_prio_t Priorit
 	if (m_pDocument == NULL)
 		return;
 
-	// Queue a note for play
-	m_pDocument->GetChannel(Channel)->SetNote(NoteData, Priority);
-	theApp.GetMIDI()->WriteNote(Channel, NoteData.Note, NoteData.Octave, NoteData.Vol);
+	// Queue a note for play. The document's channels belong to the main sound generator,
+	// so look up this generator's own channel with the same ID.
+	m_bExactState = false;		// // // Not part of the track
+	QueueChannelNote(Channel, m_pDocument->GetChannel(Channel)->GetID(), NoteData, Priority);		// // //
 }
 
-void CSoundGen::ForceReloadInstrument(int Channel)		// // //
+void CSoundGen::QueueChannelNote(int Channel, int ChanID, stChanNote &NoteData, note_prio_t Priority) const		// // //
 {
-	if (m_pDocument == NULL)
-		return;
-	m_pChannels[m_pDocument->GetChannel(Channel)->GetID()]->ForceReloadInstrument();
+	m_pTrackerChannels[ChanID]->SetNote(NoteData, Priority);
+	if (m_pTrackerView != NULL && !m_bSeeking)		// // //
+		theApp.GetMIDI()->WriteNote(Channel, NoteData.Note, NoteData.Octave, NoteData.Vol);
+}
+
+void CSoundGen::QueueLiveNote(const stRoutedNote &Note, std::int64_t Time)		// // //
+{
+	if (!m_LiveNotes.try_push(stLiveNote {Note, Time})) {
+		// Queue full, play it at the start of the next tick instead
+		stChanNote NoteData = Note.Note;
+		m_pTrackerChannels[Note.ChanID]->SetNote(NoteData, NOTE_PRIO_2);
+		if (Note.ForceReload)
+			m_pChannels[Note.ChanID]->ForceReloadInstrument();
+		m_bExactState = false;		// // //
+		if (m_pTrackerView != NULL)
+			theApp.GetMIDI()->WriteNote(Note.Channel, NoteData.Note, NoteData.Octave, NoteData.Vol);
+	}
+}
+
+void CSoundGen::QueueMidiLiveNote(const stRoutedNote &Note, std::int64_t Time)		// // //
+{
+	if (!m_MidiLiveNotes.try_push(stLiveNote {Note, Time})) {
+		// Queue full, play it at the start of the next tick without the MIDI out echo
+		stChanNote NoteData = Note.Note;
+		m_pTrackerChannels[Note.ChanID]->SetNote(NoteData, NOTE_PRIO_2);
+		if (Note.ForceReload)
+			m_pChannels[Note.ChanID]->ForceReloadInstrument();
+		m_bExactState = false;		// // //
+	}
 }
 
 int	CSoundGen::GetPlayerRow() const
@@ -2863,6 +3424,19 @@ int CSoundGen::GetPlayerTrack() const
 	return m_iPlayTrack;
 }
 
+const CTrackerChannel *CSoundGen::GetTrackerChannel(int ChanID) const		// // //
+{
+	for (const CTrackerChannel *pChan : m_pTrackerChannels)
+		if (pChan && pChan->GetID() == ChanID)
+			return pChan;
+	return nullptr;
+}
+
+machine_t CSoundGen::GetMachineType() const		// // //
+{
+	return m_iMachineType;
+}
+
 int CSoundGen::GetPlayerTicks() const
 {
 	return m_iPlayTicks;
@@ -2873,6 +3447,7 @@ void CSoundGen::MoveToFrame(int Frame)
 	// Todo: synchronize
 	m_iPlayFrame = Frame;
 	m_iPlayRow = 0;
+	m_bExactState = false;		// // //
 }
 
 void CSoundGen::SetQueueFrame(int Frame)
@@ -2885,52 +3460,20 @@ int CSoundGen::GetQueueFrame() const
 	return m_iQueuedFrame;
 }
 
-// Verification
-
-void CSoundGen::WriteRegister(uint16_t Reg, uint8_t Value)
+std::shared_ptr<CInstrument> CSoundGen::GetPlaybackInstrument(int Index) const		// // //
 {
-#ifdef WRITE_VGM		// // //
-	static int S5B_Port = 0; // TODO: elevate to full object status
-	if (Reg >= 0x4000U && Reg <= 0x401FU) {
-		m_iRegisterStream.push(0xB4);
-		m_iRegisterStream.push(Reg & 0x1F);
-		m_iRegisterStream.push(Value);
-	}
-
-	else if (Reg >= 0x4040U && Reg <= 0x407FU) {
-		m_iRegisterStream.push(0xB4);
-		m_iRegisterStream.push(Reg & 0x7F);
-		m_iRegisterStream.push(Value);
-	}
-	else if (Reg >= 0x4080U && Reg <= 0x409EU) {
-		m_iRegisterStream.push(0xB4);
-		m_iRegisterStream.push((Reg & 0x1F) | 0x20);
-		m_iRegisterStream.push(Value);
-	}
-	else if (Reg == 0x4023U) {
-		m_iRegisterStream.push(0xB4);
-		m_iRegisterStream.push(0x3F);
-		m_iRegisterStream.push(Value);
-	}
-
-	else if (Reg == 0xC000)
-		S5B_Port = Value;
-	else if (Reg == 0xE000) {
-		m_iRegisterStream.push(0xA0);
-		m_iRegisterStream.push(S5B_Port);
-		m_iRegisterStream.push(Value);
-	}
-#endif
+	return m_pDocument ? m_pDocument->GetPlaybackInstrument(Index) : nullptr;
 }
 
-CFTMComponentInterface *CSoundGen::GetDocumentInterface() const
+std::shared_ptr<const CGroove> CSoundGen::GetGroove(int Index) const		// // //
 {
-	return static_cast<CFTMComponentInterface*>(m_pDocument);
+	return m_pDocument->GetPlaybackGroove(Index);
 }
 
 void CSoundGen::SetSequencePlayPos(const CSequence *pSequence, int Pos)
 {
-	if (pSequence == m_pSequencePlayPos) {
+	// // // The channels play copies of the sequence shown by the editor, see CFamiTrackerDoc::PublishPlayback
+	if (pSequence->GetVersion() == m_iSequencePlayVersion) {
 		m_iSequencePlayPos = Pos;
 		m_iSequenceTimeout = 5;
 	}
@@ -2938,7 +3481,7 @@ void CSoundGen::SetSequencePlayPos(const CSequence *pSequence, int Pos)
 
 int CSoundGen::GetSequencePlayPos(const CSequence *pSequence)
 {
-	if (m_pSequencePlayPos != pSequence)
+	if (m_iSequencePlayVersion != pSequence->GetVersion())		// // //
 		m_iSequencePlayPos = -1;
 
 	if (m_iSequenceTimeout == 0)
@@ -2947,7 +3490,7 @@ int CSoundGen::GetSequencePlayPos(const CSequence *pSequence)
 		--m_iSequenceTimeout;
 
 	int Ret = m_iSequencePlayPos;
-	m_pSequencePlayPos = pSequence;
+	m_iSequencePlayVersion = pSequence->GetVersion();		// // //
 	return Ret;
 }
 
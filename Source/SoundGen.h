@@ -29,15 +29,19 @@
 #include "libsamplerate/include/samplerate.h"
 #include "utils/handle_ptr.h"
 #include "yamc/fair_mutex.hpp"
-#include <queue>		// // //
 #include "Common.h"
 #include "FamiTrackerTypes.h"
+#include "LiveNoteScheduler.h"		// // //
+#include "LiveNoteRouter.h"		// // //
+#include "PatternNote.h"		// // //
+#include "PlayerKeyframes.h"		// // //
 
 #include <atomic>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <thread>
+#include <vector>
 
 const int VIBRATO_LENGTH = 256;
 const int TREMOLO_LENGTH = 256;
@@ -81,7 +85,17 @@ enum render_end_t {
 	SONG_LOOP_LIMIT
 };
 
-class stChanNote;		// // //
+enum render_format_t {
+	RENDER_WAV,
+	RENDER_VGM,				// Register writes of the chips CVGMWriter supports, see CVGMWriter
+};
+
+// A channel rendered to its own file alongside the mix
+struct stRenderStem {
+	int ChanID;
+	CString File;
+};
+
 struct stRecordSetting;
 
 enum note_prio_t;
@@ -89,18 +103,24 @@ enum note_prio_t;
 class CChannelHandler;
 class CFamiTrackerView;
 class CFamiTrackerDoc;
+class CPatternData;		// // //
 class CInstrument;		// // //
+class CGroove;		// // //
+struct stPlaybackSettings;		// // //
 class CSequence;		// // //
 class CAPU;
 class CSoundInterface;
 class CSoundStream;
 class CWaveFile;		// // //
+class CStemWaveFile;
+class CVGMWriter;
 class CVisualizerWnd;
 class CDSample;
 class CTrackerChannel;
-class CFTMComponentInterface;		// // //
 class CInstrumentRecorder;		// // //
 class CRegisterState;		// // //
+class CRegisterJournal;
+class CSettings;		// // //
 
 // CSoundGen
 
@@ -109,7 +129,9 @@ using FairMutex = yamc::fair::mutex;
 class CSoundGen : IAudioCallback
 {
 public:
-	CSoundGen();
+	/** Offline generators only render with RenderOffline(), on the thread that created them,
+		and play their own document (see CFamiTrackerDoc::LoadOffline). */
+	explicit CSoundGen(CSettings *pSettings, bool Offline = false);		// // //
 	virtual ~CSoundGen();
 
 private:		// // //
@@ -213,11 +235,19 @@ public:
 	int			 GetChannelVolume(int Channel) const;		// // //
 
 	// Rendering
-	bool		 RenderToFile(LPTSTR pFile, render_end_t SongEndType, int SongEndParam, int Track);
+	/** Stems are rendered during the same pass as the mix, see CAPU::SetStems(). WAV only.
+		A VGM render of a looping song with SONG_LOOP_LIMIT loops back to the end of the intro. */
+	bool		 RenderToFile(LPTSTR pFile, render_end_t SongEndType, int SongEndParam, int Track, const std::vector<stRenderStem> &Stems = {}, render_format_t Format = RENDER_WAV);
+	/** Renders a track of the assigned document to a file on the calling thread, with no
+		audio device, view or player thread. Only for offline generators, so batch rendering
+		creates one CSoundGen and document per job. Track is 0-based. */
+	bool		 RenderOffline(LPTSTR pFile, render_end_t SongEndType, int SongEndParam, int Track, render_format_t Format = RENDER_WAV);
 	void		 StopRendering();
 	void		 GetRenderStat(int &Frame, int &Time, bool &Done, int &FramesToRender, int &Row, int &RowCount) const;
 	bool		 IsRendering() const;
 	bool		 IsBackgroundTask() const;
+	bool		 IsOffline() const;		// // //
+	CSettings	 *GetSettings() const;		// // //
 
 	// Sample previewing
 	void		 PreviewSample(const CDSample *pSample, int Offset, int Pitch);		// // //
@@ -234,6 +264,8 @@ public:
 	// Other
 	uint8_t		GetReg(int Chip, int Reg) const;
 	CRegisterState *GetRegState(unsigned Chip, unsigned Reg) const;		// // //
+	/** Register write journal of the APU. Safe to read from any thread through a CRegisterJournalReader. */
+	const CRegisterJournal &GetRegisterJournal() const;
 	double		GetChannelFrequency(unsigned Chip, int Channel) const;		// // //
 	int		GetFDSModCounter() const;		// TODO: reading $4097 returns $00 for some reason, fix that and remove this hack instead
 	CString		RecallChannelState(int Channel) const;		// // //
@@ -243,7 +275,6 @@ public:
 	bool		HasWaveChanged() const;
 	void		ResetWaveChanged();
 
-	void		WriteRegister(uint16_t Reg, uint8_t Value);
 
 	void		RegisterKeyState(int Channel, int Note);
 
@@ -251,9 +282,15 @@ public:
 	int			GetPlayerRow() const;
 	int			GetPlayerFrame() const;
 	int			GetPlayerTrack() const;
+	const CTrackerChannel *GetTrackerChannel(int ChanID) const;		// // // Null if the channel does not exist
+	machine_t	GetMachineType() const;		// // //
 	int			GetPlayerTicks() const;
 	void		QueueNote(int Channel, stChanNote &NoteData, note_prio_t Priority) const;
-	void		ForceReloadInstrument(int Channel);		// // //
+	// // // Queues a note played live, stamped with CLiveNoteScheduler::Now() when the input arrived.
+	// The sound thread plays it at the matching cycle of a tick and echoes it to MIDI out.
+	// QueueLiveNote is called from the main thread only, QueueMidiLiveNote from the MIDI input thread only.
+	void		QueueLiveNote(const stRoutedNote &Note, std::int64_t Time);
+	void		QueueMidiLiveNote(const stRoutedNote &Note, std::int64_t Time);
 	void		MoveToFrame(int Frame);
 	void		SetQueueFrame(int Frame);
 	int			GetQueueFrame() const;
@@ -268,7 +305,8 @@ public:
 
 	bool HasDocument() const { return m_pDocument != NULL; };
 	CFamiTrackerDoc *GetDocument() const { return m_pDocument; };
-	CFTMComponentInterface *GetDocumentInterface() const;
+	// // // The copy of an instrument published for the player, see CFamiTrackerDoc::PublishPlayback
+	std::shared_ptr<CInstrument> GetPlaybackInstrument(int Index) const;
 
 	// Sequence play position
 	void SetSequencePlayPos(const CSequence *pSequence, int Pos);
@@ -290,6 +328,7 @@ private:
 
 	// Audio
 	bool		ResetAudioDevice();
+	bool		SetupAPU(unsigned int SampleRate);
 	void		CloseAudioDevice();
 	void		CloseAudio();
 	void FillBuffer(int16_t const * pBuffer, uint32_t Size);
@@ -300,11 +339,16 @@ private:
 	void		UpdateChannels();
 	void		UpdateAPU();
 	void		UpdatePlayer();
+	void		ReadLiveNotes();		// // //
 	void		PlayChannelNotes();
 	void	 	PlayNote(int Channel, stChanNote *NoteData, int EffColumns);
 	void		RunFrame();
 	void		CheckControl();
 	void		ResetBuffer();
+	void		SetupRenderLength(const CFamiTrackerDoc *pDoc, render_end_t SongEndType, int SongEndParam, int Track, render_format_t Format);
+	bool		OpenVGMFile(LPTSTR pFile);
+	void		CloseStemFiles();
+	void		CloseVGMFile();
 	void		BeginPlayer(play_mode_t Mode, int Track);
 	void		HaltPlayer();
 	void		MakeSilent();
@@ -321,12 +365,27 @@ private:
 	void		PlayerSkipTo(int Row);
 
 	void		ApplyGlobalState();		// // //
+	void		SeekPlayer(int Frame, int Row);		// // //
+	bool		SeekFrom(int Frame, int Row);		// // //
+	bool		UpdateExactState();		// // //
+	void		CheckKeyframe();		// // //
+	void		CaptureKeyframe(CPlayerKeyframes &Keyframes);		// // //
+	bool		RestoreKeyframe(const CPlayerKeyframes::stKeyframe &Keyframe);		// // //
+	void		SerializePlayerState(CStateArchive &State);		// // //
+	bool		SetupKeyframePass();		// // //
+	void		StartKeyframePass();		// // //
+	void		UpdateKeyframePass();		// // //
+	void		LoadPlayTrack();		// // //
+	void		QueueChannelNote(int Channel, int ChanID, stChanNote &NoteData, note_prio_t Priority) const;		// // //
+	std::shared_ptr<const CGroove> GetGroove(int Index) const;		// // //
 
 public:
 	static const double NEW_VIBRATO_DEPTH[];
 	static const double OLD_VIBRATO_DEPTH[];
 
 	static const int AUDIO_TIMEOUT = 2000;		// 2s buffer timeout
+	static const int MIN_DEVICE_RATE = 11025;	// // // Stream rates the APU runs at directly, see ResetAudioDevice()
+	static const int MAX_DEVICE_RATE = 192000;
 
 	//
 	// Private variables
@@ -344,11 +403,22 @@ private:
 	std::optional<GuiMessage> m_maybeSelfMessage;
 	rigtorp::SPSCQueue<GuiMessage> m_MessageQueue;
 
+	// // // Live notes, from the main thread and the MIDI input thread to the sound thread
+	struct stLiveNote {
+		stRoutedNote Routed;
+		std::int64_t Time;
+	};
+	rigtorp::SPSCQueue<stLiveNote> m_LiveNotes;
+	rigtorp::SPSCQueue<stLiveNote> m_MidiLiveNotes;
+	CLiveNoteScheduler m_LiveNoteScheduler;
+	int m_iLiveNoteCycle[CHANNELS];				// Cycle within the tick to refresh each channel at, -1 if none
+
 	// Objects
 	CChannelHandler		*m_pChannels[CHANNELS];
 	CTrackerChannel		*m_pTrackerChannels[CHANNELS];
 	CFamiTrackerDoc		*m_pDocument;
 	CFamiTrackerView	*m_pTrackerView;
+	CSettings			*m_pSettings;		// // //
 
 	// Sound
 	CSoundInterface				*m_pSoundInterface;
@@ -398,6 +468,7 @@ private:
 
 	// unsigned int		m_iResampleOutPtr;					// This will point in samples
 	uint32_t m_inputBufferSize;
+	unsigned int		m_iPlaybackRate = 0;				// // // APU rate during playback, the device rate if it needs no resampling
 	std::unique_ptr<float[]> m_pResampleInBuffer;
 	std::unique_ptr<float[]> m_pResampleOutBuffer;
 
@@ -466,6 +537,7 @@ private:
 	int					m_iRenderTrack;
 	unsigned int		m_iRenderRowCount;
 	int					m_iRenderRow;
+	const bool			m_bOffline;							// // // Renders without an audio device, see RenderOffline
 
 	int					m_iTempoDecrement;
 	int					m_iTempoRemainder;
@@ -476,9 +548,10 @@ private:
 	int					m_iBPMCacheTicks[AVERAGE_BPM_SIZE];
 	int					m_iBPMCachePosition;
 
-	std::queue<int>		m_iRegisterStream;					// // // vgm export
-
 	std::unique_ptr<CWaveFile> m_pWaveFile;
+	std::unique_ptr<CVGMWriter> m_pVGMWriter;		// Replaces m_pWaveFile when rendering to VGM
+	int					m_iRenderLoopRow;					// Row the VGM file loops back to, or -1
+	std::vector<std::pair<int, std::unique_ptr<CStemWaveFile>>> m_RenderStems;		// Channel ID and file of every stem
 
 	// FDS & N163 waves
 	volatile bool		m_bWaveChanged;
@@ -487,6 +560,8 @@ private:
 	// Player state
 	int					m_iQueuedFrame;					// Queued frame
 	int					m_iPlayTrack;					// Current track that is playing
+	std::shared_ptr<const CPatternData> m_pPlayTrackData;	// // // Published copy of that track, see LoadPlayTrack()
+	std::shared_ptr<const stPlaybackSettings> m_pPlaySettings;	// // // Published module settings, loaded with the track
 	int					m_iPlayFrame;					// Current frame to play
 	int					m_iPlayRow;						// Current row to play
 	bool				m_bDirty;						// Row/frame has changed
@@ -494,8 +569,18 @@ private:
 	unsigned int		m_iRowsPlayed;					// Total number of rows played since start
 	bool				m_bFramePlayed[MAX_FRAMES];		// true for each frame played
 
+	// // // Keyframes, see CPlayerKeyframes
+	CPlayerKeyframes	m_Keyframes;
+	bool				m_bSeeking;						// Running forward to the row playback starts from
+	mutable std::atomic<bool> m_bExactState;			// Playback matches playing the track from the start
+	int					m_iExactFrame;					// Latest row read while the state was exact
+	int					m_iExactRow;
+	std::unique_ptr<CSoundGen> m_pKeyframeGen;			// Offline generator of the background pass, see UpdateKeyframePass()
+	unsigned long long	m_iKeyframeSetup = 0;			// Setup version it was set up for
+	unsigned long long	m_iKeyframeDrops = 0;			// Drop version its pass started at
+
 	// Sequence play visualization
-	const CSequence		*m_pSequencePlayPos;
+	unsigned long long	m_iSequencePlayVersion;		// // // Copies played by the channels keep the version of the original
 	int					m_iSequencePlayPos;
 	int					m_iSequenceTimeout;
 
@@ -23,6 +23,7 @@
 //
 
 #include "stdafx.h"
+#include <algorithm>
 #include <cstdio>
 #include <utility>  // std::move
 #include "Common.h"
@@ -328,6 +329,14 @@ CSoundStream *CSoundInterface::OpenFloatChannel(const int InputChannels, int Buf
 	hr = pAudioClient->GetBufferSize(&bufferFrameCount);
 	if (FAILED(hr)) return nullptr;
 
+	// // // Get the period the audio engine reads the buffer in (usually 10 ms), so that
+	// CSoundGen can hand over audio in blocks of that size.
+	REFERENCE_TIME devicePeriodTime;
+	hr = pAudioClient->GetDevicePeriod(&devicePeriodTime, nullptr);
+	if (FAILED(hr)) return nullptr;
+	auto periodFrameCount = (unsigned int)(devicePeriodTime * SampleRate / 10'000'000);
+	periodFrameCount = std::clamp(periodFrameCount, 1u, (unsigned int)bufferFrameCount);
+
 	// Open stream's buffer writing interface.
 	ComPtr<IAudioRenderClient> pAudioRenderClient;
 	hr = pAudioClient->GetService(
@@ -350,6 +359,7 @@ CSoundStream *CSoundInterface::OpenFloatChannel(const int InputChannels, int Buf
 		std::move(bufferEvent),
 		SampleRate,
 		bufferFrameCount,
+		periodFrameCount,
 		4,  // bytesPerSample = 4 for float
 		InputChannels,
 		OutputChannels);
@@ -372,6 +382,7 @@ CSoundStream::CSoundStream(
 	HandlePtr bufferEvent,
 	unsigned int iSampleRate,
 	unsigned int bufferFrameCount,
+	unsigned int periodFrameCount,
 	unsigned int bytesPerSample,
 	unsigned int inputChannels,
 	unsigned int outputChannels)
@@ -384,6 +395,7 @@ CSoundStream::CSoundStream(
 	m_hTask(nullptr),
 	m_iSampleRate(iSampleRate),
 	m_bufferFrameCount(bufferFrameCount),
+	m_periodFrameCount(periodFrameCount),
 	m_bytesPerSample(bytesPerSample),
 	m_inputChannels(inputChannels),
 	m_outputChannels(outputChannels)
@@ -484,6 +496,10 @@ uint32_t CSoundStream::TotalBufferSizeFrames() const {
 	return m_bufferFrameCount;
 }
 
+uint32_t CSoundStream::PeriodSizeFrames() const {
+	return m_periodFrameCount;
+}
+
 uint32_t CSoundStream::TotalBufferSizeBytes() const {
 	return FramesToPubBytes(m_bufferFrameCount);
 }
@@ -67,6 +67,7 @@ public:
 		HandlePtr bufferEvent,
 		unsigned int iSampleRate,
 		unsigned int bufferFrameCount,
+		unsigned int periodFrameCount,
 		unsigned int bytesPerSample,
 		unsigned int inputChannels,
 		unsigned int outputChannels);
@@ -84,6 +85,9 @@ public:
 
 	uint32_t TotalBufferSizeFrames() const;
 
+	/// Get the device period, the number of frames the audio engine reads at a time.
+	uint32_t PeriodSizeFrames() const;
+
 	/// Get public/input buffer size. If upmixing mono to stereo, this is mono.
 	uint32_t TotalBufferSizeBytes() const;
 
@@ -122,6 +126,7 @@ private:
 	// Configuration
 	unsigned int m_iSampleRate;
 	unsigned int m_bufferFrameCount;
+	unsigned int m_periodFrameCount;
 	unsigned int m_bytesPerSample;
 
 	// Public, picked by user, 1 for mono sound.
@@ -22,7 +22,6 @@
 #include "../resource.h"
 #include "SpeedDlg.h"
 
-const int RATE_MIN = 16;		// // //
 const int RATE_MAX = 1000;
 
 // CSpeedDlg dialog
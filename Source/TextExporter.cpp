@@ -869,7 +869,7 @@ const CString& CTextExport::ImportFile(LPCTSTR FileName, CFamiTrackerDoc *pDoc)
 							sResult.Format(_T("Line %d column %d: DPCM sample %d overflow, increase size used in %s."), t.line, t.GetColumn(), dpcm_index, CT[CT_DPCMDEF]);
 							return sResult;
 						}
-						*(dpcm_sample->GetData() + dpcm_pos) = (char)(i);
+						*(dpcm_sample->EditData() + dpcm_pos) = (char)(i);		// // //
 						++dpcm_pos;
 					}
 				}
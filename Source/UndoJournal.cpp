@@ -0,0 +1,292 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+#include "UndoJournal.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+// Cell encoding: the key difference from the previous cell and the byte mask as
+// LEB128 varints, then the old and new value of each changed byte.
+
+namespace {
+
+void PutVarint(std::vector<unsigned char> &Out, std::uint32_t x)
+{
+	while (x >= 0x80) {
+		Out.push_back(static_cast<unsigned char>(x | 0x80));
+		x >>= 7;
+	}
+	Out.push_back(static_cast<unsigned char>(x));
+}
+
+const unsigned char *GetVarint(const unsigned char *p, std::uint32_t &x)
+{
+	x = 0;
+	for (int Shift = 0; ; Shift += 7) {
+		const unsigned char b = *p++;
+		x |= static_cast<std::uint32_t>(b & 0x7F) << Shift;
+		if (!(b & 0x80))
+			return p;
+	}
+}
+
+} // namespace
+
+void CUndoJournal::stCell::Apply(void *pCell, bool Redo) const
+{
+	unsigned char *pBytes = static_cast<unsigned char *>(pCell);
+	const unsigned char *pSource = Redo ? New : Old;
+	for (std::uint32_t m = Mask, i = 0; m; m >>= 1, ++i)
+		if (m & 1)
+			pBytes[i] = pSource[i];
+}
+
+CUndoJournal::CUndoJournal() :
+	m_iDiscarded(0),
+	m_iLiveSize(0),
+	m_iNextSerial(1),
+	m_iCellSize(0)
+{
+}
+
+void CUndoJournal::Begin(std::size_t CellSize)
+{
+	assert(CellSize > 0 && CellSize <= MAX_CELL_SIZE);
+	m_iCellSize = CellSize;
+	m_Pending.clear();
+}
+
+void CUndoJournal::Record(std::uint32_t Key, const void *pOld, const void *pNew)
+{
+	if (!std::memcmp(pOld, pNew, m_iCellSize))
+		return;
+	stPending Cell;
+	Cell.Key = Key;
+	std::memcpy(Cell.Old, pOld, m_iCellSize);
+	std::memcpy(Cell.New, pNew, m_iCellSize);
+	m_Pending.push_back(Cell);
+}
+
+void CUndoJournal::SortPending()
+{
+	// Callers usually record in key order, sort only when they did not
+	const auto ByKey = [] (const stPending &a, const stPending &b) { return a.Key < b.Key; };
+	if (!std::is_sorted(m_Pending.begin(), m_Pending.end(), ByKey))
+		std::stable_sort(m_Pending.begin(), m_Pending.end(), ByKey);
+
+	// Merge repeated keys, keeping the first old and the last new contents
+	auto Out = m_Pending.begin();
+	for (auto it = m_Pending.begin(); it != m_Pending.end(); ++it) {
+		if (Out != m_Pending.begin() && (Out - 1)->Key == it->Key)
+			std::memcpy((Out - 1)->New, it->New, m_iCellSize);
+		else
+			*Out++ = *it;
+	}
+	m_Pending.erase(Out, m_Pending.end());
+}
+
+void CUndoJournal::Encode(const stCell &Cell, std::uint32_t &PrevKey)
+{
+	PutVarint(m_Arena, Cell.Key - PrevKey);
+	PutVarint(m_Arena, Cell.Mask);
+	for (std::uint32_t m = Cell.Mask, i = 0; m; m >>= 1, ++i)
+		if (m & 1) {
+			m_Arena.push_back(Cell.Old[i]);
+			m_Arena.push_back(Cell.New[i]);
+		}
+	PrevKey = Cell.Key;
+}
+
+const unsigned char *CUndoJournal::Decode(const unsigned char *p, stCell &Cell)
+{
+	std::uint32_t Delta;
+	p = GetVarint(p, Delta);
+	Cell.Key += Delta;
+	p = GetVarint(p, Cell.Mask);
+	for (std::uint32_t m = Cell.Mask, i = 0; m; m >>= 1, ++i)
+		if (m & 1) {
+			Cell.Old[i] = *p++;
+			Cell.New[i] = *p++;
+		}
+	return p;
+}
+
+CUndoJournal::handle_t CUndoJournal::Commit()
+{
+	SortPending();
+
+	stEntry Entry { };
+	Entry.Serial = m_iNextSerial;
+	Entry.Offset = m_Arena.size() + m_iDiscarded;
+	Entry.CellSize = static_cast<std::uint8_t>(m_iCellSize);
+	Entry.Live = true;
+
+	std::uint32_t PrevKey = 0;
+	stCell Cell;
+	for (const auto &x : m_Pending) {
+		Cell.Key = x.Key;
+		Cell.Mask = 0;
+		for (std::size_t i = 0; i < m_iCellSize; ++i)
+			if (x.Old[i] != x.New[i]) {
+				Cell.Mask |= 1u << i;
+				Cell.Old[i] = x.Old[i];
+				Cell.New[i] = x.New[i];
+			}
+		if (Cell.Mask) {
+			Encode(Cell, PrevKey);
+			++Entry.Cells;
+		}
+	}
+	m_Pending.clear();
+
+	if (!Entry.Cells)
+		return NO_ENTRY;
+
+	Entry.Size = m_Arena.size() + m_iDiscarded - Entry.Offset;
+	m_iLiveSize += Entry.Size;
+	m_Entries.push_back(Entry);
+	return m_iNextSerial++;
+}
+
+bool CUndoJournal::CommitInto(handle_t Entry)
+{
+	SortPending();
+
+	if (m_Entries.empty() || m_Entries.back().Serial != Entry || !m_Entries.back().Live ||
+		m_Entries.back().CellSize != m_iCellSize) {
+		m_Pending.clear();
+		return false;
+	}
+	stEntry &Target = m_Entries.back();
+
+	std::vector<stCell> Cells;
+	Cells.reserve(Target.Cells);
+	Replay(Entry, [&Cells] (const stCell &Cell) { Cells.push_back(Cell); });
+
+	// The entry is last in the arena, so it can be rewritten in place
+	m_Arena.resize(Target.Offset - m_iDiscarded);
+	m_iLiveSize -= Target.Size;
+	Target.Cells = 0;
+
+	std::uint32_t PrevKey = 0;
+	const auto Emit = [&] (const stCell &Cell) {
+		if (Cell.Mask) {
+			Encode(Cell, PrevKey);
+			++Target.Cells;
+		}
+	};
+
+	auto a = Cells.cbegin();
+	auto b = m_Pending.cbegin();
+	while (a != Cells.cend() || b != m_Pending.cend()) {
+		if (b == m_Pending.cend() || (a != Cells.cend() && a->Key < b->Key)) {
+			Emit(*a++);
+			continue;
+		}
+		stCell Cell;
+		Cell.Key = b->Key;
+		Cell.Mask = 0;
+		const bool Both = a != Cells.cend() && a->Key == b->Key;
+		for (std::size_t i = 0; i < m_iCellSize; ++i) {
+			const unsigned char Old = Both && (a->Mask >> i & 1) ? a->Old[i] : b->Old[i];
+			if (Old != b->New[i]) {
+				Cell.Mask |= 1u << i;
+				Cell.Old[i] = Old;
+				Cell.New[i] = b->New[i];
+			}
+		}
+		Emit(Cell);
+		if (Both)
+			++a;
+		++b;
+	}
+	m_Pending.clear();
+
+	Target.Size = m_Arena.size() + m_iDiscarded - Target.Offset;
+	m_iLiveSize += Target.Size;
+	return true;
+}
+
+void CUndoJournal::Release(handle_t Entry)
+{
+	if (Entry == NO_ENTRY || m_Entries.empty() || Entry < m_Entries.front().Serial || Entry > m_Entries.back().Serial)
+		return;
+	stEntry &Target = m_Entries[static_cast<std::size_t>(Entry - m_Entries.front().Serial)];
+	if (!Target.Live)
+		return;
+	Target.Live = false;
+	m_iLiveSize -= Target.Size;
+	Reclaim();
+}
+
+void CUndoJournal::Reclaim()
+{
+	while (!m_Entries.empty() && !m_Entries.back().Live) {
+		m_Arena.resize(m_Entries.back().Offset - m_iDiscarded);
+		m_Entries.pop_back();
+	}
+	while (!m_Entries.empty() && !m_Entries.front().Live)
+		m_Entries.pop_front();
+
+	if (m_Entries.empty()) {
+		m_iDiscarded += m_Arena.size();
+		m_Arena.clear();
+	}
+	else {
+		// Move the live entries down once the released space in front of them dominates
+		const std::size_t Front = m_Entries.front().Offset - m_iDiscarded;
+		if (Front > m_Arena.size() / 2) {
+			m_Arena.erase(m_Arena.begin(), m_Arena.begin() + Front);
+			m_iDiscarded += Front;
+		}
+	}
+	if (m_Arena.capacity() > 4 * m_Arena.size())
+		m_Arena.shrink_to_fit();
+}
+
+const CUndoJournal::stEntry *CUndoJournal::Find(handle_t Entry) const
+{
+	if (Entry == NO_ENTRY || m_Entries.empty() || Entry < m_Entries.front().Serial || Entry > m_Entries.back().Serial)
+		return nullptr;
+	const stEntry &x = m_Entries[static_cast<std::size_t>(Entry - m_Entries.front().Serial)];
+	return x.Live ? &x : nullptr;
+}
+
+std::size_t CUndoJournal::GetCellCount(handle_t Entry) const
+{
+	const stEntry *pEntry = Find(Entry);
+	return pEntry ? pEntry->Cells : 0;
+}
+
+std::size_t CUndoJournal::GetSize() const
+{
+	return m_iLiveSize + m_Entries.size() * sizeof(stEntry);
+}
+
+void CUndoJournal::Clear()
+{
+	m_iDiscarded += m_Arena.size();
+	m_Arena.clear();
+	m_Arena.shrink_to_fit();
+	m_Entries.clear();
+	m_iLiveSize = 0;
+	m_Pending.clear();
+}
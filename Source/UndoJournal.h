@@ -0,0 +1,155 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+/*!
+	\brief A shared arena of cell-level differences, used by undoable actions.
+	\details Each entry holds the cells changed by one edit, as the bytes that differ before and
+	after it. Cells are identified by a key chosen by the caller, and stored sorted by key with
+	the key difference from the previous cell, so runs of neighbouring cells cost a few bytes of
+	addressing each. Entries live back to back in one buffer; releasing the oldest or newest entry
+	returns its space, which matches how History drops actions.
+*/
+class CUndoJournal
+{
+public:
+	/*!	\brief Identifies an entry. Entries are numbered from 1 in the order they are committed. */
+	using handle_t = std::uint64_t;
+
+	static const handle_t NO_ENTRY = 0;
+
+	/*!	\brief Largest cell size, in bytes. */
+	static const std::size_t MAX_CELL_SIZE = 16;
+
+	/*!	\brief A changed cell, as read back from an entry. */
+	struct stCell {
+		std::uint32_t Key;
+		std::uint32_t Mask;		// Bit n is set if byte n of the cell changed
+		unsigned char Old[MAX_CELL_SIZE];		// Only the bytes in Mask are meaningful
+		unsigned char New[MAX_CELL_SIZE];
+
+		/*!	\brief Writes the changed bytes into a cell.
+			\param pCell The cell, holding the contents after the edit if Redo is false and
+			before it otherwise.
+			\param Redo Whether to write the contents after the edit instead of before. */
+		void Apply(void *pCell, bool Redo) const;
+	};
+
+	CUndoJournal();
+
+	CUndoJournal(const CUndoJournal &) = delete;
+	CUndoJournal &operator=(const CUndoJournal &) = delete;
+
+	/*!	\brief Starts collecting the cells of a new entry, dropping any cells collected before.
+		\param CellSize The size of every cell in bytes, at most MAX_CELL_SIZE. */
+	void Begin(std::size_t CellSize);
+
+	/*!	\brief Adds a cell to the entry being collected. Unchanged cells are skipped. When a key is
+		recorded more than once, the entry keeps its first old and its last new contents.
+		\param Key The cell key.
+		\param pOld The cell contents before the edit.
+		\param pNew The cell contents after the edit. */
+	void Record(std::uint32_t Key, const void *pOld, const void *pNew);
+
+	/*!	\brief Stores the collected cells as a new entry.
+		\return The new entry, or NO_ENTRY if no cell changed. */
+	handle_t Commit();
+
+	/*!	\brief Coalesces the collected cells into an existing entry, as if both edits were one.
+		\details Cells that end up with the same contents as before the first edit are dropped.
+		\param Entry The entry to extend. It must be the newest entry in the journal.
+		\return False if Entry is not the newest entry; the collected cells are dropped either way. */
+	bool CommitInto(handle_t Entry);
+
+	/*!	\brief Releases an entry. Its space is reused once every entry older or newer than it is
+		released as well.
+		\param Entry The entry, or NO_ENTRY. */
+	void Release(handle_t Entry);
+
+	/*!	\brief Reads back the cells of an entry, in key order.
+		\param Entry The entry, or NO_ENTRY.
+		\param f Callable invoked with a const CUndoJournal::stCell & for each cell.
+		\return The number of cells read. */
+	template <typename F>
+	std::size_t Replay(handle_t Entry, F f) const {
+		const stEntry *pEntry = Find(Entry);
+		if (!pEntry)
+			return 0;
+		const unsigned char *p = &m_Arena[pEntry->Offset - m_iDiscarded];
+		stCell Cell;
+		Cell.Key = 0;
+		for (std::uint32_t i = 0; i < pEntry->Cells; ++i) {
+			p = Decode(p, Cell);
+			f(static_cast<const stCell &>(Cell));
+		}
+		return pEntry->Cells;
+	}
+
+	/*!	\brief Obtains the number of cells in an entry.
+		\param Entry The entry.
+		\return The cell count, or 0 if the entry does not exist. */
+	std::size_t GetCellCount(handle_t Entry) const;
+
+	/*!	\brief Obtains the memory held by entries that are not released yet.
+		\return The size in bytes. */
+	std::size_t GetSize() const;
+
+	/*!	\brief Releases every entry. */
+	void Clear();
+
+private:
+	struct stEntry {
+		handle_t Serial;
+		std::size_t Offset;		// Position in the arena, plus m_iDiscarded
+		std::size_t Size;
+		std::uint32_t Cells;
+		std::uint8_t CellSize;
+		bool Live;
+	};
+
+	struct stPending {
+		std::uint32_t Key;
+		unsigned char Old[MAX_CELL_SIZE];
+		unsigned char New[MAX_CELL_SIZE];
+	};
+
+	const stEntry *Find(handle_t Entry) const;
+	void SortPending();
+	void Encode(const stCell &Cell, std::uint32_t &PrevKey);
+	static const unsigned char *Decode(const unsigned char *p, stCell &Cell);
+	void Reclaim();
+
+private:
+	std::vector<unsigned char> m_Arena;
+	std::deque<stEntry> m_Entries;		// Consecutive serials, including released entries not reclaimed yet
+	std::size_t m_iDiscarded;			// Bytes removed from the front of the arena so far
+	std::size_t m_iLiveSize;
+	handle_t m_iNextSerial;
+
+	std::vector<stPending> m_Pending;
+	std::size_t m_iCellSize;
+};
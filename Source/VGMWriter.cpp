@@ -0,0 +1,366 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+#include "VGMWriter.h"
+#include <algorithm>
+#include <chrono>
+#include "APU/Types.h"
+#include "APU/APU.h"
+
+namespace {
+
+// VGM commands
+const uint8_t CMD_YM2413 = 0x51;
+const uint8_t CMD_AY8910 = 0xA0;
+const uint8_t CMD_NES_APU = 0xB4;
+const uint8_t CMD_WAIT = 0x61;
+const uint8_t CMD_WAIT_NTSC = 0x62;		// 735 samples
+const uint8_t CMD_WAIT_PAL = 0x63;		// 882 samples
+const uint8_t CMD_END = 0x66;
+const uint8_t CMD_DATA_BLOCK = 0x67;
+const uint8_t CMD_WAIT_SHORT = 0x70;	// 0x70 + n - 1 waits n samples, up to 16
+
+const uint8_t DATA_NES_RAM = 0xC2;
+const uint16_t DPCM_ADDRESS = 0xC000;
+
+const uint32_t VGM_VERSION = 0x171;
+const uint32_t HEADER_SIZE = 0x100;
+const uint32_t CLOCK_VRC7_FLAG = 0x80000000;	// YM2413 clock, emulate the VRC7 patch set
+const uint32_t CLOCK_FDS_FLAG = 0x80000000;		// NES APU clock, FDS present
+
+const uint8_t AY_TYPE_AY8910 = 0x00;
+const uint8_t AY_TYPE_YM2149 = 0x10;
+const uint8_t AY_FLAG_LEGACY = 0x01;
+
+} // namespace
+
+CVGMWriter::CVGMWriter() :
+	m_iChips(0),
+	m_iFMChip(SNDCHIP_NONE),
+	m_iPSGChip(SNDCHIP_NONE),
+	m_iClock(CAPU::BASE_FREQ_NTSC),
+	m_iFrameRate(CAPU::FRAME_RATE_NTSC),
+	m_pLastSample(nullptr),
+	m_iLastSampleSize(0),
+	m_Queue(QUEUE_CAPACITY),
+	m_iFilePos(0),
+	m_iSamplePos(0),
+	m_iLoopOffset(0),
+	m_iLoopSample(0),
+	m_iGD3Offset(0),
+	m_bSuccess(false)
+{
+}
+
+CVGMWriter::~CVGMWriter()
+{
+	if (IsOpen())
+		Close(0);
+}
+
+int CVGMWriter::GetSupportedChips(int Chips)
+{
+	int Supported = Chips & SNDCHIP_FDS;
+	if (Chips & SNDCHIP_VRC7)
+		Supported |= SNDCHIP_VRC7;
+	else
+		Supported |= Chips & SNDCHIP_OPLL;
+	if (Chips & SNDCHIP_5B)
+		Supported |= SNDCHIP_5B;
+	else if (Chips & SNDCHIP_SSG)
+		Supported |= SNDCHIP_SSG;
+	else
+		Supported |= Chips & SNDCHIP_AY;
+	return Supported;
+}
+
+bool CVGMWriter::Open(const std::filesystem::path &Path, int Chips, uint32_t Clock, int FrameRate)
+{
+	if (IsOpen())
+		return false;
+
+	m_File.open(Path, std::ios::binary | std::ios::trunc);
+	if (!m_File)
+		return false;
+
+	m_iChips = GetSupportedChips(Chips);
+	m_iFMChip = m_iChips & (SNDCHIP_VRC7 | SNDCHIP_OPLL);
+	m_iPSGChip = m_iChips & (SNDCHIP_5B | SNDCHIP_SSG | SNDCHIP_AY);
+	m_iClock = Clock;
+	m_iFrameRate = FrameRate;
+	m_pLastSample = nullptr;
+	m_iLastSampleSize = 0;
+
+	m_Buffer.clear();
+	m_Buffer.reserve(CHUNK_SIZE + HEADER_SIZE);
+	m_Sample.clear();
+	m_iFilePos = 0;
+	m_iSamplePos = 0;
+	m_iLoopOffset = 0;
+	m_iLoopSample = 0;
+	m_iGD3Offset = 0;
+	m_bSuccess = true;
+
+	// Reserve the header, it is filled in once the song has ended
+	m_Buffer.resize(HEADER_SIZE);
+
+	// CAPU::Reset() leaves these without logging them
+	Emit(CMD_NES_APU); Emit<uint8_t>(0x15); Emit<uint8_t>(0x0F);
+	Emit(CMD_NES_APU); Emit<uint8_t>(0x17); Emit<uint8_t>(0x00);
+	if (m_iChips & SNDCHIP_FDS) {
+		Emit(CMD_NES_APU); Emit<uint8_t>(0x3F); Emit<uint8_t>(0x83);		// $4023, enable sound I/O
+	}
+
+	m_Thread = std::thread(&CVGMWriter::ThreadProc, this);
+	return true;
+}
+
+void CVGMWriter::SetTags(const std::u16string &Title, const std::u16string &Game,
+	const std::u16string &Author, const std::u16string &Date)
+{
+	m_Tags[0] = Title;
+	m_Tags[1] = Game;
+	m_Tags[2] = Author;
+	m_Tags[3] = Date;
+}
+
+void CVGMWriter::MarkLoop(uint64_t Cycle)
+{
+	Push({stEvent::LOOP, 0, 0, 0, Cycle});
+}
+
+bool CVGMWriter::Close(uint64_t Cycle)
+{
+	if (!IsOpen())
+		return false;
+
+	Push({stEvent::END, 0, 0, 0, Cycle});
+	m_Wake.notify_one();
+	m_Thread.join();
+
+	m_File.close();
+	return m_bSuccess && !m_File.fail();
+}
+
+bool CVGMWriter::IsOpen() const
+{
+	return m_Thread.joinable();
+}
+
+void CVGMWriter::OnWrite(const CRegisterJournal::stWrite &Write)
+{
+	const uint16_t a = Write.Address;
+	switch (Write.Chip) {
+	case SNDCHIP_NONE:
+		if (a <= 0x4013 || a == 0x4015 || a == 0x4017)
+			Push({stEvent::COMMAND, CMD_NES_APU, static_cast<uint8_t>(a & 0x1F), Write.Value, Write.Cycle});
+		break;
+	case SNDCHIP_FDS:
+		if (!(m_iChips & SNDCHIP_FDS))
+			break;
+		if (a >= 0x4040 && a <= 0x407F)		// Wave RAM
+			Push({stEvent::COMMAND, CMD_NES_APU, static_cast<uint8_t>(a & 0x7F), Write.Value, Write.Cycle});
+		else if (a >= 0x4080 && a <= 0x409E)
+			Push({stEvent::COMMAND, CMD_NES_APU, static_cast<uint8_t>((a & 0x1F) | 0x20), Write.Value, Write.Cycle});
+		break;
+	case SNDCHIP_VRC7: case SNDCHIP_OPLL:
+		if (Write.Chip == m_iFMChip)
+			Push({stEvent::COMMAND, CMD_YM2413, static_cast<uint8_t>(a), Write.Value, Write.Cycle});
+		break;
+	case SNDCHIP_5B: case SNDCHIP_SSG: case SNDCHIP_AY:
+		if (Write.Chip == m_iPSGChip)
+			Push({stEvent::COMMAND, CMD_AY8910, static_cast<uint8_t>(a), Write.Value, Write.Cycle});
+		break;
+	}
+}
+
+void CVGMWriter::OnSample(uint64_t Cycle, int Chip, const char *pData, int Size)
+{
+	// The sample stays in memory after it is cleared, so only new samples matter
+	if (Chip != SNDCHIP_NONE || !pData || Size <= 0)
+		return;
+	if (pData == m_pLastSample && Size == m_iLastSampleSize)
+		return;
+	m_pLastSample = pData;
+	m_iLastSampleSize = Size;
+
+	auto pCopy = std::make_unique<std::vector<uint8_t>>(pData, pData + Size);
+	Push({stEvent::DATA, 0, 0, 0, Cycle, std::move(pCopy)});
+}
+
+void CVGMWriter::Push(stEvent &&Event)
+{
+	// Wake the writer early enough that the emulation thread rarely has to wait
+	if (m_Queue.size() >= QUEUE_CAPACITY / 2)
+		m_Wake.notify_one();
+	while (!m_Queue.try_push(std::move(Event))) {
+		m_Wake.notify_one();
+		std::this_thread::yield();
+	}
+}
+
+void CVGMWriter::ThreadProc()
+{
+	std::unique_lock<std::mutex> Lock(m_Mutex);
+
+	for (;;) {
+		while (stEvent *pEvent = m_Queue.front()) {
+			// Convert from absolute positions, so rounding never accumulates
+			const uint64_t Sample = pEvent->Cycle * SAMPLE_RATE / m_iClock;
+			if (Sample > m_iSamplePos) {
+				WriteWait(Sample - m_iSamplePos);
+				m_iSamplePos = Sample;
+			}
+
+			switch (pEvent->Type) {
+			case stEvent::COMMAND:
+				Emit(pEvent->Command);
+				Emit(pEvent->Address);
+				Emit(pEvent->Value);
+				break;
+			case stEvent::DATA:
+				m_Sample = std::move(*pEvent->pData);
+				WriteSampleBlock();
+				break;
+			case stEvent::LOOP:
+				m_iLoopOffset = m_iFilePos + m_Buffer.size();
+				m_iLoopSample = m_iSamplePos;
+				WriteSampleBlock();		// The loop may play a sample loaded before it
+				break;
+			case stEvent::END:
+				m_Queue.pop();
+				Emit(CMD_END);
+				WriteGD3();
+				Flush();
+				WriteHeader();
+				return;
+			}
+			m_Queue.pop();
+
+			if (m_Buffer.size() >= CHUNK_SIZE)
+				Flush();
+		}
+
+		m_Wake.wait_for(Lock, std::chrono::milliseconds(10));
+	}
+}
+
+void CVGMWriter::WriteWait(uint64_t Samples)
+{
+	while (Samples > 0) {
+		if (Samples == 735) {
+			Emit(CMD_WAIT_NTSC);
+			return;
+		}
+		if (Samples == 882) {
+			Emit(CMD_WAIT_PAL);
+			return;
+		}
+		if (Samples <= 16) {
+			Emit(static_cast<uint8_t>(CMD_WAIT_SHORT + Samples - 1));
+			return;
+		}
+		const uint16_t Wait = static_cast<uint16_t>(std::min<uint64_t>(Samples, 0xFFFF));
+		Emit(CMD_WAIT);
+		Emit(Wait);
+		Samples -= Wait;
+	}
+}
+
+void CVGMWriter::WriteSampleBlock()
+{
+	if (m_Sample.empty())
+		return;
+	Emit(CMD_DATA_BLOCK);
+	Emit<uint8_t>(0x66);
+	Emit(DATA_NES_RAM);
+	Emit(static_cast<uint32_t>(m_Sample.size() + 2));
+	Emit(DPCM_ADDRESS);
+	m_Buffer.insert(m_Buffer.end(), m_Sample.begin(), m_Sample.end());
+}
+
+void CVGMWriter::WriteGD3()
+{
+	// Track, game, system and author names in English and Japanese, release date, ripper, notes
+	const std::u16string System = u"NES/Famicom";
+	const std::u16string *const Strings[] = {
+		&m_Tags[0], &m_Tags[0], &m_Tags[1], &m_Tags[1], &System, &System, &m_Tags[2], &m_Tags[2], &m_Tags[3], nullptr, nullptr,
+	};
+
+	uint32_t Length = 0;
+	for (auto pStr : Strings)
+		Length += 2 * ((pStr ? pStr->size() : 0) + 1);
+
+	m_iGD3Offset = static_cast<uint32_t>(m_iFilePos + m_Buffer.size());
+	Emit<uint32_t>(0x20336447);		// "Gd3 "
+	Emit<uint32_t>(0x100);
+	Emit(Length);
+	for (auto pStr : Strings) {
+		if (pStr)
+			for (char16_t c : *pStr)
+				Emit<uint16_t>(c);
+		Emit<uint16_t>(0);
+	}
+}
+
+void CVGMWriter::WriteHeader()
+{
+	m_Buffer.clear();
+	m_Buffer.resize(HEADER_SIZE);
+	const auto Put = [&] (std::size_t Offset, uint32_t Value) {
+		for (int i = 0; i < 4; ++i)
+			m_Buffer[Offset + i] = static_cast<uint8_t>(Value >> (i * 8));
+	};
+
+	Put(0x00, 0x206D6756);		// "Vgm "
+	Put(0x04, static_cast<uint32_t>(m_iFilePos - 0x04));
+	Put(0x08, VGM_VERSION);
+	if (m_iFMChip)
+		Put(0x10, CAPU::BASE_FREQ_VRC7 | (m_iFMChip == SNDCHIP_VRC7 ? CLOCK_VRC7_FLAG : 0));
+	Put(0x14, m_iGD3Offset - 0x14);
+	Put(0x18, static_cast<uint32_t>(m_iSamplePos));
+	if (m_iLoopOffset) {
+		Put(0x1C, static_cast<uint32_t>(m_iLoopOffset - 0x1C));
+		Put(0x20, static_cast<uint32_t>(m_iSamplePos - m_iLoopSample));
+	}
+	Put(0x24, m_iFrameRate);
+	Put(0x34, HEADER_SIZE - 0x34);
+	if (m_iPSGChip) {
+		Put(0x74, CAPU::BASE_FREQ_NTSC / 2);
+		m_Buffer[0x78] = m_iPSGChip == SNDCHIP_AY ? AY_TYPE_AY8910 : AY_TYPE_YM2149;
+		m_Buffer[0x79] = AY_FLAG_LEGACY;
+	}
+	Put(0x84, m_iClock | ((m_iChips & SNDCHIP_FDS) ? CLOCK_FDS_FLAG : 0));
+
+	m_File.seekp(0);
+	m_File.write(reinterpret_cast<const char *>(m_Buffer.data()), m_Buffer.size());
+	m_File.flush();
+	if (!m_File)
+		m_bSuccess = false;
+}
+
+void CVGMWriter::Flush()
+{
+	m_File.write(reinterpret_cast<const char *>(m_Buffer.data()), m_Buffer.size());
+	if (!m_File)
+		m_bSuccess = false;
+	m_iFilePos += m_Buffer.size();
+	m_Buffer.clear();
+}
@@ -0,0 +1,149 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "RegisterJournal.h"
+#include "rigtorp/SPSCQueue.h"
+
+/*!
+	\brief A streaming VGM 1.71 file writer fed by the register write path of CAPU.
+	\details The writer is attached to CAPU as its register sink. Writes of the supported chips are
+	converted to VGM commands on the emulation thread and handed through a bounded queue to a
+	background thread, which turns cycle stamps into coalesced waits and writes the file in
+	fixed-size chunks. Memory use does not depend on the length of the song.
+
+	Supported chips are the 2A03 (with DPCM samples), the FDS, one YM2413 (VRC7 if present,
+	otherwise the OPLL) and one AY-3-8910 family PSG (5B if present, otherwise the YM2149F or
+	the AY-3-8910). Writes to every other chip are dropped.
+*/
+class CVGMWriter : public IRegisterSink
+{
+public:
+	CVGMWriter();
+	~CVGMWriter();
+
+	CVGMWriter(const CVGMWriter &) = delete;
+	CVGMWriter &operator=(const CVGMWriter &) = delete;
+
+	/*!	\brief Obtains the expansion chips a VGM file can hold.
+		\param Chips The SNDCHIP_* flags of a module.
+		\return The subset of Chips written to VGM files. */
+	static int GetSupportedChips(int Chips);
+
+	/*!	\brief Creates the file and starts the writer thread.
+		\param Path The output file.
+		\param Chips The SNDCHIP_* flags of the module.
+		\param Clock The CPU clock of the emulated machine, in Hz.
+		\param FrameRate The engine tick rate, in Hz.
+		\return True if the file was created. */
+	bool Open(const std::filesystem::path &Path, int Chips, uint32_t Clock, int FrameRate);
+
+	/*!	\brief Sets the GD3 tags, written when the file is closed. Call before Close().
+		\param Title The track title.
+		\param Game The module name.
+		\param Author The module author.
+		\param Date The module copyright. */
+	void SetTags(const std::u16string &Title, const std::u16string &Game,
+		const std::u16string &Author, const std::u16string &Date);
+
+	/*!	\brief Sets the loop point of the file. Call from the emulation thread, at most once.
+		\param Cycle The CPU cycle the song loops back to. */
+	void MarkLoop(uint64_t Cycle);
+
+	/*!	\brief Ends the song, waits for the writer thread and finalizes the file.
+		\param Cycle The CPU cycle the song ends at.
+		\return True if the whole file was written successfully. */
+	bool Close(uint64_t Cycle);
+
+	/*!	\brief Checks whether the writer has an open file.
+		\return True between Open() and Close(). */
+	bool IsOpen() const;
+
+	void OnWrite(const CRegisterJournal::stWrite &Write) override;
+	void OnSample(uint64_t Cycle, int Chip, const char *pData, int Size) override;
+
+public:
+	static const uint32_t SAMPLE_RATE = 44100;
+	static const std::size_t QUEUE_CAPACITY = 0x4000;
+	static const std::size_t CHUNK_SIZE = 0x10000;
+
+private:
+	struct stEvent {
+		enum event_t : uint8_t { COMMAND, DATA, LOOP, END } Type;
+		uint8_t Command;
+		uint8_t Address;
+		uint8_t Value;
+		uint64_t Cycle;
+		std::unique_ptr<std::vector<uint8_t>> pData = nullptr;		// DPCM sample, DATA only
+	};
+
+	void Push(stEvent &&Event);
+	void ThreadProc();
+	void WriteWait(uint64_t Samples);
+	void WriteSampleBlock();
+	void WriteGD3();
+	void WriteHeader();
+	void Flush();
+
+	template <typename T>
+	void Emit(T Value, int Bytes = sizeof(T)) {
+		for (int i = 0; i < Bytes; ++i)
+			m_Buffer.push_back(static_cast<uint8_t>(static_cast<uint64_t>(Value) >> (i * 8)));
+	}
+
+private:
+	// Emulation thread
+	int m_iChips;
+	int m_iFMChip;						// SNDCHIP_VRC7, SNDCHIP_OPLL or SNDCHIP_NONE
+	int m_iPSGChip;						// SNDCHIP_5B, SNDCHIP_SSG, SNDCHIP_AY or SNDCHIP_NONE
+	uint32_t m_iClock;
+	int m_iFrameRate;
+	const char *m_pLastSample;
+	int m_iLastSampleSize;
+	std::u16string m_Tags[4];
+
+	// Handoff
+	rigtorp::SPSCQueue<stEvent> m_Queue;
+	std::mutex m_Mutex;
+	std::condition_variable m_Wake;
+	std::thread m_Thread;
+
+	// Writer thread
+	std::ofstream m_File;
+	std::vector<uint8_t> m_Buffer;
+	std::vector<uint8_t> m_Sample;		// Contents of the DPCM sample memory
+	uint64_t m_iFilePos;				// Bytes written to m_File
+	uint64_t m_iSamplePos;				// Samples covered by waits
+	uint64_t m_iLoopOffset;				// File offset of the loop point, or 0
+	uint64_t m_iLoopSample;
+	uint32_t m_iGD3Offset;
+	bool m_bSuccess;
+};
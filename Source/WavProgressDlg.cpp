@@ -53,12 +53,14 @@ END_MESSAGE_MAP()
 
 // CWavProgressDlg message handlers
 
-void CWavProgressDlg::BeginRender(CString &File, render_end_t LengthType, int LengthParam, int Track)
+void CWavProgressDlg::BeginRender(CString &File, render_end_t LengthType, int LengthParam, int Track, const std::vector<stRenderStem> &Stems, render_format_t Format)
 {
 	m_iSongEndType = LengthType;
 	m_iSongEndParam = LengthParam;
 	m_sFile = File;
 	m_iTrack = Track;
+	m_Stems = Stems;
+	m_iFormat = Format;
 
 	if (m_sFile.GetLength() > 0)
 		DoModal();
@@ -82,7 +84,7 @@ BOOL CWavProgressDlg::OnInitDialog()
 	AfxFormatString1(FileStr, IDS_WAVE_PROGRESS_FILE_FORMAT, m_sFile);
 	SetDlgItemText(IDC_PROGRESS_FILE, FileStr);
 
-	if (!pSoundGen->RenderToFile(m_sFile.GetBuffer(), m_iSongEndType, m_iSongEndParam, m_iTrack))
+	if (!pSoundGen->RenderToFile(m_sFile.GetBuffer(), m_iSongEndType, m_iSongEndParam, m_iTrack, m_Stems, m_iFormat))
 		EndDialog(0);
 
 	m_dwStartTime = GetTickCount();
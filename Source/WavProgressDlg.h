@@ -31,7 +31,7 @@ public:
 	CWavProgressDlg(CWnd* pParent = NULL);   // standard constructor
 	virtual ~CWavProgressDlg();
 
-	void BeginRender(CString &File, render_end_t LengthType, int LengthParam, int Track);
+	void BeginRender(CString &File, render_end_t LengthType, int LengthParam, int Track, const std::vector<stRenderStem> &Stems = {}, render_format_t Format = RENDER_WAV);
 
 // Dialog Data
 	enum { IDD = IDD_WAVE_PROGRESS };
@@ -45,6 +45,8 @@ protected:
 	int		m_iTimerPeriod; // Refresh rate depending on playback
 	
 	CString m_sFile;
+	std::vector<stRenderStem> m_Stems;
+	render_format_t m_iFormat = RENDER_WAV;
 
 public:
 	bool CancelRender = false;
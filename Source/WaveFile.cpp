@@ -103,3 +103,19 @@ void CWaveFile::WriteWave(char *Data, int Size)
 	}
 }
 
+
+bool CStemWaveFile::OpenFile(LPTSTR Filename, int SampleRate)
+{
+	return m_File.OpenFile(Filename, SampleRate, 16, 1);
+}
+
+void CStemWaveFile::CloseFile()
+{
+	m_File.CloseFile();
+}
+
+void CStemWaveFile::FlushBuffer(int16_t const * Buffer, uint32_t Size)
+{
+	// Called from the stem's emulation thread
+	m_File.WriteWave((char *) Buffer, 2 * Size);
+}
@@ -23,6 +23,7 @@
 
 #include "stdafx.h"		// // //
 #include <mmsystem.h>
+#include "Common.h"
 
 class CWaveFile
 {
@@ -39,3 +40,16 @@ class CWaveFile
 
 };
 
+// A 16-bit mono WAV file CAPU renders a stem into, see CAPU::SetStems()
+class CStemWaveFile : public IAudioCallback
+{
+	public:
+		bool	OpenFile(LPTSTR Filename, int SampleRate);
+		void	CloseFile();
+		void	FlushBuffer(int16_t const * Buffer, uint32_t Size) override;
+
+	private:
+		CWaveFile		m_File;
+
+};
+
@@ -0,0 +1,1225 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+// Headless per-chip throughput benchmark.
+//
+// Every chip is driven by a scripted register write stream (a short arpeggio
+// with volume changes on every channel), rendered without any audio device,
+// and timed. The checksum column is a hash of the mixed output, so it doubles
+// as a quick check that an optimization did not change the rendered audio.
+//
+// Usage: apu-bench [-s seconds] [-r samplerate] [-device samplerate] [-b samples] [-j threads] [-t] [-stems] [-vgm dir] [-simd level] [chip ...]
+//
+// -device also plays every selected chip for a device running at that rate, once
+// with Blip_Buffer set to the device rate and once at -r followed by the
+// libsamplerate pass CSoundGen uses otherwise, and prints the time and latency
+// of both (see CSoundGen::ResetAudioDevice).
+//
+// -b flushes the output every that many samples instead of once per frame (see
+// CAPU::SetBlockSamples). The checksums must not change. Every selected chip is
+// also played with 5, 3 and 1 ms blocks and compared against whole frames, with
+// the delay from each register write to the flush that delivers it, and the
+// longest wall time spent producing a single flush; that time must stay well
+// below the block length for a device buffer of that size not to run dry.
+//
+// -j emulates the expansion chips on that many threads (see CAPU::SetEmulationThreads).
+// The "Multi" script drives VRC7, FDS, N163 and 6581 at once; its checksum must
+// not depend on -j.
+//
+// The "MMC5PCM" script plays the MMC5 sampler (see CMMC5::Process); its
+// checksum is the regression check for that path.
+//
+// -stems also renders a stem of every channel of the selected chips (see CAPU::SetStems),
+// on -j threads. The timings include the stems; the checksums must not change.
+//
+// -vgm also streams the register writes of every selected chip to <dir>/<chip>.vgm
+// (see CVGMWriter), looping from the first scripted frame. The timings include it.
+//
+// -t prints the register write journal (cycle, chip, address, value) of every
+// selected chip instead of timing it, for diffing write streams.
+//
+// -simd forces the post-filter kernels (see PostFilter.h) to none, sse2, avx2 or neon.
+// The checksums must be the same at every level. When a chip that runs a post-filter
+// (FDS, N163, VRC7, OPLL) is selected, every supported level is also checked bit for
+// bit against the scalar kernels, and the run fails on any difference.
+//
+// After the table, the Blip_Buffer kernels (impulse insertion, mix_samples and the
+// read_samples clamp) of every supported level are timed on their own and compared
+// sample for sample against the scalar code.
+//
+// When a PSG (5B, AY8930, AY-3-8910, YM2149F) is selected, it also plays a script
+// made of short tone periods and the fastest noise and envelope, the worst case
+// for the shared event loop in PSG.h.
+//
+// Every selected chip is also saved mid-way with CAPU::SaveState, restored into a
+// second CAPU, and both are played on; the run fails unless their output after the
+// save point is identical.
+//
+// When the VRC7 or OPLL is selected, it is also run with emu2413 at the output rate
+// once per frame and at its native rate between the writes, and the two are compared.
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include "APU/APU.h"
+#include "APU/PostFilter.h"
+#include "samplerate.h"
+#include "VGMWriter.h"
+
+namespace {
+
+const int WRITE_DELAY_SAME_CHIP = 150;		// Same spacing CSoundGen::UpdateAPU uses
+const int FRAME_CYCLES = CAPU::BASE_FREQ_NTSC / CAPU::FRAME_RATE_NTSC;
+
+/// Discards audio but keeps a running hash of it.
+class CBenchCallback : public IAudioCallback {
+public:
+	void FlushBuffer(int16_t const *Buffer, uint32_t Size) override {
+		for (uint32_t i = 0; i < Size; ++i)
+			m_iChecksum = (m_iChecksum ^ static_cast<uint16_t>(Buffer[i])) * 16777619u;
+		m_iSamples += Size;
+		if (m_pCapture)
+			m_pCapture->insert(m_pCapture->end(), Buffer, Buffer + Size);
+		if (m_pAPU) {
+			const auto Now = std::chrono::steady_clock::now();
+			m_FlushCycles.push_back(m_pAPU->GetCycleCount());
+			if (m_iFlushes++)
+				m_fWorstFlush = std::max(m_fWorstFlush, std::chrono::duration<double>(Now - m_LastFlush).count());
+			m_LastFlush = Now;
+		}
+	}
+
+	uint64_t m_iSamples = 0;
+	uint32_t m_iChecksum = 2166136261u;
+	std::vector<int16_t> *m_pCapture = nullptr;		// Optional copy of the output
+
+	// Flush timing, only recorded if m_pAPU is set
+	const CAPU *m_pAPU = nullptr;
+	std::vector<uint64_t> m_FlushCycles;		// Cycle count at each flush
+	uint64_t m_iFlushes = 0;
+	double m_fWorstFlush = 0.0;		// Longest wall time between two flushes, in seconds
+	std::chrono::steady_clock::time_point m_LastFlush;
+};
+
+/// Issues register writes at CPU cycle offsets within the current frame.
+class CScriptWriter {
+public:
+	explicit CScriptWriter(CAPU &APU) : m_APU(APU) { }
+
+	void Write(uint16_t Address, uint8_t Value) {
+		m_APU.Write(Address, Value);
+	}
+
+	/// Writes Value to Reg of a chip with separate address and data ports.
+	void WritePort(uint16_t AddrPort, uint16_t DataPort, uint8_t Reg, uint8_t Value) {
+		Write(AddrPort, Reg);
+		Write(DataPort, Value);
+	}
+
+	/// Moves on to the next channel's writes.
+	void NextChannel() {
+		m_APU.AddCycles(WRITE_DELAY_SAME_CHIP);
+		m_iFrameTime += WRITE_DELAY_SAME_CHIP;
+	}
+
+	void EndFrame() {
+		m_APU.AddCycles(FRAME_CYCLES - m_iFrameTime);
+		m_APU.Process();
+		m_iFrameTime = 0;
+	}
+
+private:
+	CAPU &m_APU;
+	int m_iFrameTime = 0;
+};
+
+// Script helpers
+
+/// Frequency of Channel at Frame: a looping arpeggio, one note every 6 frames,
+/// each channel a different interval above the root.
+double NoteFreq(int Frame, int Channel)
+{
+	static const int ARPEGGIO[] = {0, 4, 7, 12, 7, 4, 2, 5, 9, 14, 9, 5};
+	const int Step = (Frame / 6) % static_cast<int>(std::size(ARPEGGIO));
+	const int Semitone = ARPEGGIO[Step] + Channel * 3 - 9;
+	return 220.0 * std::pow(2.0, Semitone / 12.0);
+}
+
+bool NoteOn(int Frame)
+{
+	return Frame % 6 == 0;
+}
+
+/// Decaying 4-bit volume envelope, restarted on every note.
+int NoteVolume(int Frame)
+{
+	return 15 - std::min(Frame % 6 * 2, 15);
+}
+
+unsigned Period(double Divider, double Freq, unsigned Max)
+{
+	double P = CAPU::BASE_FREQ_NTSC / (Divider * Freq) - 1.0;
+	return static_cast<unsigned>(std::clamp(P, 0.0, double(Max)));
+}
+
+unsigned PhaseRate(double Scale, double Freq, unsigned Max)
+{
+	double F = Freq * Scale / CAPU::BASE_FREQ_NTSC;
+	return static_cast<unsigned>(std::clamp(F, 0.0, double(Max)));
+}
+
+// 2A03-style register sets, shared by 2A03, 5E01 and 7E02 at different bases
+
+void InitNES(CScriptWriter &w, uint16_t Base)
+{
+	w.Write(Base + 0x15, 0x0F);
+	w.Write(Base + 0x01, 0x08);		// sweep off
+	w.Write(Base + 0x05, 0x08);
+}
+
+void FrameNES(CScriptWriter &w, uint16_t Base, int Frame)
+{
+	for (int i = 0; i < 2; ++i) {
+		const uint16_t Reg = Base + i * 4;
+		unsigned P = Period(16.0, NoteFreq(Frame, i), 0x7FF);
+		w.Write(Reg + 0, 0x30 | (i << 6) | NoteVolume(Frame));
+		w.Write(Reg + 2, P & 0xFF);
+		if (NoteOn(Frame))
+			w.Write(Reg + 3, P >> 8);
+		w.NextChannel();
+	}
+	unsigned P = Period(32.0, NoteFreq(Frame, 2) / 2.0, 0x7FF);
+	w.Write(Base + 0x08, 0xFF);
+	w.Write(Base + 0x0A, P & 0xFF);
+	if (NoteOn(Frame))
+		w.Write(Base + 0x0B, P >> 8);
+	w.NextChannel();
+	w.Write(Base + 0x0C, 0x30 | (NoteOn(Frame + 3) ? 0x0C : 0x04));
+	w.Write(Base + 0x0E, (Frame * 5) & 0x0F);
+	w.NextChannel();
+}
+
+// AY-3-8910-style register sets, shared by 5B, AY8930, AY-3-8910 and YM2149F
+
+void InitPSG(CScriptWriter &w, uint16_t AddrPort, uint16_t DataPort)
+{
+	w.WritePort(AddrPort, DataPort, 0x07, 0x30);		// tones on, noise on channel A only
+	w.WritePort(AddrPort, DataPort, 0x0B, 0x00);
+	w.WritePort(AddrPort, DataPort, 0x0C, 0x08);
+	w.WritePort(AddrPort, DataPort, 0x0D, 0x0E);
+}
+
+void FramePSG(CScriptWriter &w, uint16_t AddrPort, uint16_t DataPort, int Frame)
+{
+	for (int i = 0; i < 3; ++i) {
+		unsigned P = Period(16.0, NoteFreq(Frame, i), 0xFFF);
+		w.WritePort(AddrPort, DataPort, i * 2, P & 0xFF);
+		w.WritePort(AddrPort, DataPort, i * 2 + 1, P >> 8);
+		w.WritePort(AddrPort, DataPort, 0x08 + i, i == 2 && Frame % 24 < 12 ? 0x10 : NoteVolume(Frame));
+		w.NextChannel();
+	}
+	w.WritePort(AddrPort, DataPort, 0x06, (Frame * 3) & 0x1F);
+}
+
+/// Worst case for the PSG event loop: short tone periods on every channel, the
+/// fastest noise and a repeating envelope at its shortest period.
+void InitPSGDense(CScriptWriter &w, uint16_t AddrPort, uint16_t DataPort)
+{
+	w.WritePort(AddrPort, DataPort, 0x07, 0x30);
+	w.WritePort(AddrPort, DataPort, 0x0B, 0x01);
+	w.WritePort(AddrPort, DataPort, 0x0C, 0x00);
+	w.WritePort(AddrPort, DataPort, 0x0D, 0x0A);
+	w.WritePort(AddrPort, DataPort, 0x0A, 0x10);
+}
+
+void FramePSGDense(CScriptWriter &w, uint16_t AddrPort, uint16_t DataPort, int Frame)
+{
+	for (int i = 0; i < 2; ++i) {
+		w.WritePort(AddrPort, DataPort, i * 2, static_cast<uint8_t>(3 + i + Frame % 5));
+		w.WritePort(AddrPort, DataPort, i * 2 + 1, 0x00);
+		w.WritePort(AddrPort, DataPort, 0x08 + i, NoteVolume(Frame) | 1);
+		w.NextChannel();
+	}
+	w.WritePort(AddrPort, DataPort, 0x04, static_cast<uint8_t>(7 + Frame % 3));
+	w.WritePort(AddrPort, DataPort, 0x06, 0x01);
+}
+
+// OPLL-style register sets, shared by VRC7 and YM2413
+
+void FrameFM(CScriptWriter &w, uint16_t AddrPort, uint16_t DataPort, int Channels, int Frame)
+{
+	for (int i = 0; i < Channels; ++i) {
+		double F = NoteFreq(Frame, i);
+		int Block = 0;
+		unsigned FNum = static_cast<unsigned>(F * (1 << 18) / 49716.0);
+		while (FNum >= 0x200 && Block < 7) {
+			FNum >>= 1;
+			++Block;
+		}
+		const bool Key = !NoteOn(Frame + 1);		// release just before each new note
+		w.WritePort(AddrPort, DataPort, 0x30 + i, ((i % 15 + 1) << 4) | (15 - NoteVolume(Frame)));
+		w.WritePort(AddrPort, DataPort, 0x10 + i, FNum & 0xFF);
+		w.WritePort(AddrPort, DataPort, 0x20 + i, (Key ? 0x10 : 0x00) | (Block << 1) | (FNum >> 8));
+		w.NextChannel();
+	}
+}
+
+struct stChipScript {
+	const char *Name;
+	int Chip;
+	void (*Init)(CScriptWriter &w);
+	void (*Frame)(CScriptWriter &w, int Frame);
+};
+
+const stChipScript SCRIPTS[] = {
+	{"2A03", SNDCHIP_NONE,
+		[] (CScriptWriter &w) { InitNES(w, 0x4000); },
+		[] (CScriptWriter &w, int Frame) { FrameNES(w, 0x4000, Frame); },
+	},
+	{"VRC6", SNDCHIP_VRC6,
+		[] (CScriptWriter &w) { w.Write(0x9003, 0x00); },
+		[] (CScriptWriter &w, int Frame) {
+			for (int i = 0; i < 2; ++i) {
+				const uint16_t Reg = 0x9000 + i * 0x1000;
+				unsigned P = Period(16.0, NoteFreq(Frame, i), 0xFFF);
+				w.Write(Reg + 0, ((Frame / 24 + i) % 8 << 4) | NoteVolume(Frame));
+				w.Write(Reg + 1, P & 0xFF);
+				w.Write(Reg + 2, 0x80 | (P >> 8));
+				w.NextChannel();
+			}
+			unsigned P = Period(14.0, NoteFreq(Frame, 2) / 2.0, 0xFFF);
+			w.Write(0xB000, NoteVolume(Frame) * 2);
+			w.Write(0xB001, P & 0xFF);
+			w.Write(0xB002, 0x80 | (P >> 8));
+			w.NextChannel();
+		},
+	},
+	{"VRC7", SNDCHIP_VRC7,
+		nullptr,
+		[] (CScriptWriter &w, int Frame) { FrameFM(w, 0x9010, 0x9030, 6, Frame); },
+	},
+	{"FDS", SNDCHIP_FDS,
+		[] (CScriptWriter &w) {
+			w.Write(0x4089, 0x80);		// wave RAM write enable
+			for (int i = 0; i < 64; ++i)
+				w.Write(0x4040 + i, static_cast<uint8_t>(32 + 31 * std::sin(i * 3.14159265 / 32.0)));
+			w.Write(0x4089, 0x00);
+			w.Write(0x408A, 0xFF);
+		},
+		[] (CScriptWriter &w, int Frame) {
+			unsigned F = PhaseRate(64.0 * 65536.0, NoteFreq(Frame, 0), 0xFFF);
+			unsigned M = PhaseRate(64.0 * 65536.0 / 64.0, NoteFreq(Frame, 0) * 2.0, 0xFFF);
+			w.Write(0x4080, 0x80 | (NoteVolume(Frame) * 2));
+			w.Write(0x4082, F & 0xFF);
+			w.Write(0x4083, F >> 8);
+			if (NoteOn(Frame)) {
+				w.Write(0x4087, 0x80);		// halt modulator while filling its table
+				for (int i = 0; i < 32; ++i)
+					w.Write(0x4088, i < 8 || i >= 24 ? 1 : 7);
+			}
+			w.Write(0x4084, 0x80 | (Frame % 12));
+			w.Write(0x4086, M & 0xFF);
+			w.Write(0x4087, M >> 8);
+			w.NextChannel();
+		},
+	},
+	{"MMC5", SNDCHIP_MMC5,
+		[] (CScriptWriter &w) { w.Write(0x5015, 0x03); w.Write(0x5010, 0x01); },
+		[] (CScriptWriter &w, int Frame) {
+			for (int i = 0; i < 2; ++i) {
+				const uint16_t Reg = 0x5000 + i * 4;
+				unsigned P = Period(16.0, NoteFreq(Frame, i), 0x7FF);
+				w.Write(Reg + 0, 0x30 | (i << 6) | NoteVolume(Frame));
+				w.Write(Reg + 2, P & 0xFF);
+				if (NoteOn(Frame))
+					w.Write(Reg + 3, P >> 8);
+				w.NextChannel();
+			}
+			for (int i = 0; i < 8; ++i) {
+				w.Write(0x5011, static_cast<uint8_t>(0x80 + 0x38 * std::sin((Frame * 8 + i) * 0.9)));
+				w.NextChannel();
+			}
+		},
+	},
+	{"MMC5PCM", SNDCHIP_MMC5,
+		[] (CScriptWriter &w) { w.Write(0x5010, 0x01); },
+		[] (CScriptWriter &w, int Frame) {
+			// Walks the built-in samples (including the looping one and silence) at changing
+			// pitches and volumes, with raw DAC writes in between
+			if (Frame % 20 == 0)
+				w.Write(0x5112, (Frame / 20) % 6);
+			const unsigned Pitch = 0x60 + (Frame * 37) % 0x1C0;
+			w.Write(0x5113, Pitch & 0xFF);
+			w.Write(0x5114, Pitch >> 8);
+			w.Write(0x5115, NoteVolume(Frame));
+			w.NextChannel();
+			if (Frame % 8 == 4)
+				for (int i = 0; i < 4; ++i) {
+					w.Write(0x5011, static_cast<uint8_t>(0x80 + 0x60 * std::sin((Frame + i) * 1.3)));
+					w.NextChannel();
+				}
+		},
+	},
+	{"N163", SNDCHIP_N163,
+		[] (CScriptWriter &w) {
+			w.Write(0xF800, 0x80);		// auto-increment from address 0
+			for (int i = 0; i < 16; ++i)
+				w.Write(0x4800, static_cast<uint8_t>((i < 8 ? 0xFF : 0x00) ^ (i * 0x11)));
+		},
+		[] (CScriptWriter &w, int Frame) {
+			for (int i = 0; i < 8; ++i) {
+				const uint8_t Reg = 0x40 + i * 8;
+				unsigned F = PhaseRate(15.0 * 65536.0 * 32.0 * 8.0, NoteFreq(Frame, i), 0x3FFFF);
+				w.Write(0xF800, 0x80 | Reg);
+				w.Write(0x4800, F & 0xFF);
+				w.Write(0x4800, 0x00);
+				w.Write(0x4800, (F >> 8) & 0xFF);
+				w.Write(0x4800, 0x00);
+				w.Write(0x4800, ((256 - 32) & 0xFC) | (F >> 16));
+				w.Write(0x4800, 0x00);
+				w.Write(0x4800, 0x00);
+				w.Write(0x4800, (i == 7 ? 0x70 : 0x00) | NoteVolume(Frame));
+				w.NextChannel();
+			}
+		},
+	},
+	{"5B", SNDCHIP_5B,
+		[] (CScriptWriter &w) { InitPSG(w, 0xC000, 0xE000); },
+		[] (CScriptWriter &w, int Frame) { FramePSG(w, 0xC000, 0xE000, Frame); },
+	},
+	{"AY8930", SNDCHIP_AY8930,
+		[] (CScriptWriter &w) { InitPSG(w, 0xC001, 0xE001); },
+		[] (CScriptWriter &w, int Frame) { FramePSG(w, 0xC001, 0xE001, Frame); },
+	},
+	{"AY", SNDCHIP_AY,
+		[] (CScriptWriter &w) { InitPSG(w, 0xC002, 0xE002); },
+		[] (CScriptWriter &w, int Frame) { FramePSG(w, 0xC002, 0xE002, Frame); },
+	},
+	{"YM2149F", SNDCHIP_SSG,
+		[] (CScriptWriter &w) { InitPSG(w, 0xC003, 0xE003); },
+		[] (CScriptWriter &w, int Frame) { FramePSG(w, 0xC003, 0xE003, Frame); },
+	},
+	{"5E01", SNDCHIP_5E01,
+		[] (CScriptWriter &w) { InitNES(w, 0x4100); },
+		[] (CScriptWriter &w, int Frame) { FrameNES(w, 0x4100, Frame); },
+	},
+	{"7E02", SNDCHIP_7E02,
+		[] (CScriptWriter &w) { InitNES(w, 0x4200); },
+		[] (CScriptWriter &w, int Frame) { FrameNES(w, 0x4200, Frame); },
+	},
+	{"OPLL", SNDCHIP_OPLL,
+		nullptr,
+		[] (CScriptWriter &w, int Frame) { FrameFM(w, 0x6000, 0x6001, 9, Frame); },
+	},
+	{"6581", SNDCHIP_6581,
+		[] (CScriptWriter &w) {
+			w.Write(0xD417, 0xF1);		// resonance, filter voice 1
+			w.Write(0xD418, 0x1F);		// lowpass, full volume
+		},
+		[] (CScriptWriter &w, int Frame) {
+			static const uint8_t WAVEFORMS[] = {0x40, 0x20, 0x10};
+			for (int i = 0; i < 3; ++i) {
+				const uint16_t Reg = 0xD400 + i * 7;
+				unsigned F = PhaseRate(16777216.0, NoteFreq(Frame, i), 0xFFFF);
+				w.Write(Reg + 0, F & 0xFF);
+				w.Write(Reg + 1, F >> 8);
+				w.Write(Reg + 2, 0x00);
+				w.Write(Reg + 3, (Frame / 4 + i) & 0x0F);
+				w.Write(Reg + 5, 0x09);
+				w.Write(Reg + 6, 0xA4);
+				w.Write(Reg + 4, WAVEFORMS[i] | (NoteOn(Frame + 1) ? 0 : 1));
+				w.NextChannel();
+			}
+			w.Write(0xD416, (Frame * 4) & 0xFF);
+		},
+	},
+};
+
+/// Runs the scripts of every chip in Chips together, like a module using several expansion chips.
+void InitMulti(CScriptWriter &w, int Chips)
+{
+	for (const auto &s : SCRIPTS)
+		if ((s.Chip & Chips) && s.Init)
+			s.Init(w);
+}
+
+void FrameMulti(CScriptWriter &w, int Chips, int Frame)
+{
+	for (const auto &s : SCRIPTS)
+		if (s.Chip & Chips)
+			s.Frame(w, Frame);
+}
+
+const int MULTI_CHIPS = SNDCHIP_VRC7 | SNDCHIP_FDS | SNDCHIP_N163 | SNDCHIP_6581;
+
+const stChipScript MULTI_SCRIPT = {"Multi", MULTI_CHIPS,
+	[] (CScriptWriter &w) { InitMulti(w, MULTI_CHIPS); },
+	[] (CScriptWriter &w, int Frame) { FrameMulti(w, MULTI_CHIPS, Frame); },
+};
+
+#define PSG_DENSE_SCRIPT(Name, Chip, Port) {Name, Chip, \
+		[] (CScriptWriter &w) { InitPSGDense(w, Port, Port + 0x2000); }, \
+		[] (CScriptWriter &w, int Frame) { FramePSGDense(w, Port, Port + 0x2000, Frame); }, \
+	}
+
+const stChipScript PSG_DENSE_SCRIPTS[] = {
+	PSG_DENSE_SCRIPT("5B", SNDCHIP_5B, 0xC000),
+	PSG_DENSE_SCRIPT("AY8930", SNDCHIP_AY8930, 0xC001),
+	PSG_DENSE_SCRIPT("AY", SNDCHIP_AY, 0xC002),
+	PSG_DENSE_SCRIPT("YM2149F", SNDCHIP_SSG, 0xC003),
+};
+
+#undef PSG_DENSE_SCRIPT
+
+struct stRunOptions {
+	int SampleRate = 48000;
+	bool Trace = false;
+	bool OPLLNativeRate = false;
+	unsigned Threads = 0;
+	uint32_t BlockSamples = 0;
+	bool Stems = false;
+	const char *VGMDir = nullptr;
+	std::vector<int16_t> *pCapture = nullptr;
+};
+
+std::unique_ptr<CAPU> CreateAPU(IAudioCallback &Callback, int Chip, const stRunOptions &Options,
+	std::vector<CBenchCallback> *pStemCallbacks = nullptr)
+{
+	auto pAPU = std::make_unique<CAPU>(&Callback);
+	if (!pAPU->SetupSound(Options.SampleRate, 1, MACHINE_NTSC))
+		return nullptr;
+
+	{
+		auto config = CAPUConfig(pAPU.get());
+		const EmulatorConfig Emu { };
+		const MixerConfig Mix { };
+
+		config.SetExternalSound(Chip);
+		config.SetupEmulation(Emu.N163DisableMultiplexing, 9, false, Emu.UseOPLLPatchBytes, Emu.UseVRC7PatchNames,
+			Options.OPLLNativeRate);
+		config.SetupMixer(30, 12000, 24, 100, false, Mix.FDSLowpass, Mix.N163Lowpass, Mix.DeviceMixOffsets);
+		for (int i = 0; i < CHIP_LEVEL_COUNT; ++i)
+			config.SetChipLevel(static_cast<chip_level_t>(i), 0.0f);
+	}
+
+	pAPU->SetEmulationThreads(Options.Threads);
+	pAPU->SetBlockSamples(Options.BlockSamples);
+
+	if (pStemCallbacks) {
+		std::vector<std::pair<int, IAudioCallback *>> Stems;
+		for (int i = 0; i < CHANNELS; ++i) {
+			const int Owner = CAPU::GetChannelChip(i);
+			if (Owner == SNDCHIP_NONE || (Owner & Chip))
+				Stems.emplace_back(i, nullptr);
+		}
+		pStemCallbacks->resize(Stems.size());
+		for (size_t i = 0; i < Stems.size(); ++i)
+			Stems[i].second = &(*pStemCallbacks)[i];
+		pAPU->SetStems(Stems, std::max(Options.Threads, 1u));
+	}
+
+	// Same as CSoundGen::OnSetChip
+	pAPU->Write(0x4015, 0x0F);
+	pAPU->Write(0x4017, 0x00);
+
+	return pAPU;
+}
+
+struct stBenchResult {
+	double Seconds;
+	uint64_t Cycles;
+	uint64_t Samples;
+	uint32_t Checksum;
+};
+
+stBenchResult RunScript(const stChipScript &Script, int Frames, const stRunOptions &Options)
+{
+	CBenchCallback Callback;
+	std::vector<CBenchCallback> StemCallbacks;
+	auto pAPU = CreateAPU(Callback, Script.Chip, Options, Options.Stems ? &StemCallbacks : nullptr);
+	if (!pAPU) {
+		std::fprintf(stderr, "%s: could not allocate sound buffer\n", Script.Name);
+		std::exit(1);
+	}
+
+	CVGMWriter VGM;
+	if (Options.VGMDir) {
+		const auto Path = std::filesystem::path(Options.VGMDir) / (std::string(Script.Name) + ".vgm");
+		if (!VGM.Open(Path, Script.Chip, CAPU::BASE_FREQ_NTSC, CAPU::FRAME_RATE_NTSC)) {
+			std::fprintf(stderr, "%s: could not create %s\n", Script.Name, Path.string().c_str());
+			std::exit(1);
+		}
+		VGM.SetTags(u"APU benchmark", u"apu-bench", u"", u"");
+		pAPU->SetRegisterSink(&VGM);
+	}
+
+	CScriptWriter Writer(*pAPU);
+	if (Script.Init)
+		Script.Init(Writer);
+	Writer.EndFrame();
+	Callback = CBenchCallback { };
+	Callback.m_pCapture = Options.pCapture;
+	for (CBenchCallback &Stem : StemCallbacks)
+		Stem = CBenchCallback { };
+
+	CRegisterJournalReader Reader(pAPU->GetRegisterJournal());
+	auto PrintWrite = [&] (const CRegisterJournal::stWrite &w) {
+		std::printf("%10llu %-8s $%04X $%02X\n", static_cast<unsigned long long>(w.Cycle), Script.Name, w.Address, w.Value);
+	};
+
+	const auto Start = std::chrono::steady_clock::now();
+	if (VGM.IsOpen())
+		VGM.MarkLoop(pAPU->GetCycleCount());
+	for (int i = 0; i < Frames; ++i) {
+		Script.Frame(Writer, i);
+		Writer.EndFrame();
+		if (Options.Trace)
+			Reader.Poll(PrintWrite);
+	}
+	if (VGM.IsOpen()) {
+		pAPU->SetRegisterSink(nullptr);
+		if (!VGM.Close(pAPU->GetCycleCount())) {
+			std::fprintf(stderr, "%s: could not write the VGM file\n", Script.Name);
+			std::exit(1);
+		}
+	}
+	const auto End = std::chrono::steady_clock::now();
+
+	for (const CBenchCallback &Stem : StemCallbacks)
+		if (Stem.m_iSamples != Callback.m_iSamples) {
+			std::fprintf(stderr, "%s: stem length differs from the mix\n", Script.Name);
+			std::exit(1);
+		}
+
+	return stBenchResult {
+		std::chrono::duration<double>(End - Start).count(),
+		uint64_t(Frames) * FRAME_CYCLES,
+		Callback.m_iSamples,
+		Callback.m_iChecksum,
+	};
+}
+
+/// Signal-to-error ratio in dB of Test against Reference, after compensating
+/// for the latency of Test (up to MaxLag samples).
+double CompareOutput(const std::vector<int16_t> &Reference, const std::vector<int16_t> &Test, int MaxLag, int &BestLag)
+{
+	double Best = -INFINITY;
+	BestLag = 0;
+	for (int Lag = 0; Lag <= MaxLag; ++Lag) {
+		const size_t Count = std::min(Reference.size(), Test.size() - std::min<size_t>(Test.size(), Lag));
+		double Signal = 0.0, Error = 0.0;
+		for (size_t i = 0; i < Count; ++i) {
+			const double d = double(Test[i + Lag]) - Reference[i];
+			Signal += double(Reference[i]) * Reference[i];
+			Error += d * d;
+		}
+		const double Ratio = Error > 0.0 ? 10.0 * std::log10(Signal / Error) : INFINITY;
+		if (Ratio > Best) {
+			Best = Ratio;
+			BestLag = Lag;
+		}
+	}
+	return Best;
+}
+
+/// Plays Script with emu2413 resampling its output once per frame (the legacy
+/// mode) and at its native rate through Blip_Buffer, and prints both.
+void CompareOPLLModes(const stChipScript &Script, int Frames, int SampleRate)
+{
+	std::vector<int16_t> Output[2];
+	stBenchResult Result[2];
+	for (int i = 0; i < 2; ++i) {
+		stRunOptions Options;
+		Options.SampleRate = SampleRate;
+		Options.OPLLNativeRate = i == 1;
+		Options.pCapture = &Output[i];
+		Result[i] = RunScript(Script, Frames, Options);
+	}
+
+	int Lag;
+	const double Ratio = CompareOutput(Output[0], Output[1], 64, Lag);
+
+	std::printf("\n%s emulation rate\n", Script.Name);
+	std::printf("%-8s %10s %10s  %s\n", "Mode", "Wall (ms)", "Realtime", "Difference");
+	std::printf("%-8s %10.1f %9.1fx  %s\n", "Frame", Result[0].Seconds * 1000.0,
+		Frames / double(CAPU::FRAME_RATE_NTSC) / Result[0].Seconds, "reference");
+	std::printf("%-8s %10.1f %9.1fx  %.1f dB SNR, %d samples later\n", "Native", Result[1].Seconds * 1000.0,
+		Frames / double(CAPU::FRAME_RATE_NTSC) / Result[1].Seconds, Ratio, Lag);
+}
+
+/// Plays the dense PSG scripts of the chips in Selected, and prints their speed and
+/// checksums like the main table.
+void BenchPSGDense(const std::vector<const stChipScript *> &Selected, int Frames, const stRunOptions &Options)
+{
+	bool Header = false;
+	for (const stChipScript &Script : PSG_DENSE_SCRIPTS) {
+		if (std::none_of(Selected.begin(), Selected.end(), [&] (const stChipScript *s) { return s->Chip == Script.Chip; }))
+			continue;
+		if (!Header) {
+			std::printf("\nPSG event loop (short periods, fastest noise and envelope)\n");
+			std::printf("%-8s %10s %14s %10s  %-8s\n", "Chip", "Wall (ms)", "Mcycles/s", "Realtime", "Checksum");
+			Header = true;
+		}
+		const stBenchResult r = RunScript(Script, Frames, Options);
+		std::printf("%-8s %10.1f %14.2f %9.1fx  %08X\n", Script.Name, r.Seconds * 1000.0,
+			r.Cycles / r.Seconds / 1e6, Frames / double(CAPU::FRAME_RATE_NTSC) / r.Seconds, r.Checksum);
+	}
+}
+
+/// Plays half of Script, saves the state of the CAPU a third into a frame, and plays the
+/// rest. Then loads that state into a second CAPU set up the same way, plays the rest
+/// on it too, and compares both outputs after the save point sample for sample.
+bool CompareStateRestore(const stChipScript &Script, int Frames, const stRunOptions &Options)
+{
+	const int Saved = Frames / 2;
+	std::vector<uint8_t> State;
+	std::vector<int16_t> Output[2];
+	double SaveSeconds = 0.0, LoadSeconds = 0.0;
+	bool Loaded = false;
+
+	for (int Pass = 0; Pass < 2; ++Pass) {
+		CBenchCallback Callback;
+		std::vector<CBenchCallback> StemCallbacks;
+		auto pAPU = CreateAPU(Callback, Script.Chip, Options, Options.Stems ? &StemCallbacks : nullptr);
+		if (!pAPU) {
+			std::fprintf(stderr, "%s: could not allocate sound buffer\n", Script.Name);
+			std::exit(1);
+		}
+
+		CScriptWriter Writer(*pAPU);
+		if (Pass == 0) {
+			if (Script.Init)
+				Script.Init(Writer);
+			Writer.EndFrame();
+			for (int i = 0; i < Saved; ++i) {
+				Script.Frame(Writer, i);
+				Writer.EndFrame();
+			}
+			// Mid-frame, with synthesized deltas not yet ended in the Blip_Buffers
+			pAPU->AddCycles(FRAME_CYCLES / 3);
+			pAPU->Process();
+			const auto Start = std::chrono::steady_clock::now();
+			pAPU->SaveState(State);
+			SaveSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		}
+		else {
+			const auto Start = std::chrono::steady_clock::now();
+			Loaded = pAPU->LoadState(State);
+			LoadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		}
+
+		Callback.m_pCapture = &Output[Pass];
+		for (int i = Saved; i < Frames; ++i) {
+			Script.Frame(Writer, i);
+			Writer.EndFrame();
+		}
+	}
+
+	const bool Exact = Loaded && Output[0] == Output[1];
+	std::printf("%-8s %10.1f %10.1f %10.1f  %s\n", Script.Name, State.size() / 1024.0,
+		SaveSeconds * 1e6, LoadSeconds * 1e6, !Loaded ? "REJECTED" : Exact ? "bit-exact" : "MISMATCH");
+	return Exact;
+}
+
+/// Plays Script the two ways CSoundGen can feed a device running at DeviceRate: with
+/// Blip_Buffer producing that rate directly, and at SampleRate followed by the
+/// libsamplerate pass CSoundGen::FillBuffer runs (SRC_SINC_MEDIUM_QUALITY, one
+/// src_process call per frame). Prints the time of each and the delay the
+/// resampler adds, measured against the direct output.
+bool CompareDeviceRate(const stChipScript &Script, int Frames, int SampleRate, int DeviceRate)
+{
+	std::vector<int16_t> Direct, Rendered;
+	stRunOptions Options;
+	Options.SampleRate = DeviceRate;
+	Options.pCapture = &Direct;
+	const stBenchResult DirectResult = RunScript(Script, Frames, Options);
+	Options.SampleRate = SampleRate;
+	Options.pCapture = &Rendered;
+	const stBenchResult RenderResult = RunScript(Script, Frames, Options);
+
+	int Error;
+	SRC_STATE *pState = src_new(SRC_SINC_MEDIUM_QUALITY, 1, &Error);
+	if (!pState) {
+		std::fprintf(stderr, "%s: %s\n", Script.Name, src_strerror(Error));
+		return false;
+	}
+
+	const double Ratio = double(DeviceRate) / SampleRate;
+	const size_t Block = SampleRate / CAPU::FRAME_RATE_NTSC;
+	std::vector<float> In(Block), Out(static_cast<size_t>(std::ceil(Block * Ratio)) + 64);
+	std::vector<int16_t> Resampled;
+	Resampled.reserve(static_cast<size_t>(Rendered.size() * Ratio) + Out.size());
+
+	SRC_DATA Args = { };
+	Args.src_ratio = Ratio;
+	double SRCSeconds = 0.0;
+	for (size_t Pos = 0; Pos < Rendered.size(); Pos += Block) {
+		const long Count = static_cast<long>(std::min(Block, Rendered.size() - Pos));
+		const auto Start = std::chrono::steady_clock::now();
+		src_short_to_float_array(Rendered.data() + Pos, In.data(), Count);
+		for (long Used = 0; Used < Count; ) {
+			Args.data_in = In.data() + Used;
+			Args.input_frames = Count - Used;
+			Args.data_out = Out.data();
+			Args.output_frames = static_cast<long>(Out.size());
+			if ((Error = src_process(pState, &Args)) != 0) {
+				std::fprintf(stderr, "%s: %s\n", Script.Name, src_strerror(Error));
+				src_delete(pState);
+				return false;
+			}
+			Used += Args.input_frames_used;
+			const size_t Offset = Resampled.size();
+			Resampled.resize(Offset + Args.output_frames_gen);
+			src_float_to_short_array(Out.data(), Resampled.data() + Offset, Args.output_frames_gen);
+		}
+		SRCSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+	}
+	src_delete(pState);
+
+	// The sinc filter delays by a few dozen samples; only the start is compared to keep this quick
+	const size_t COMPARE_SAMPLES = static_cast<size_t>(DeviceRate) * 2;
+	if (Direct.size() > COMPARE_SAMPLES)
+		Direct.resize(COMPARE_SAMPLES);
+	int Lag;
+	CompareOutput(Direct, Resampled, 256, Lag);
+
+	const double Emulated = Frames / double(CAPU::FRAME_RATE_NTSC);
+	const double Total = RenderResult.Seconds + SRCSeconds;
+	std::printf("%-8s %-10s %10.1f %9.1fx  %s\n", Script.Name, "Direct", DirectResult.Seconds * 1000.0,
+		Emulated / DirectResult.Seconds, "reference");
+	std::printf("%-8s %-10s %10.1f %9.1fx  %.2f ms latency (%d samples), SRC %.0f%% of the time\n",
+		"", "Resampled", Total * 1000.0, Emulated / Total, Lag * 1000.0 / DeviceRate, Lag, SRCSeconds * 100.0 / Total);
+	return true;
+}
+
+/// Plays Script in blocks of each of BLOCK_MS milliseconds (see CAPU::SetBlockSamples)
+/// and with whole frames, and prints for each the time, the mean and longest delay
+/// from a register write to the flush that delivers its first sample, the longest
+/// wall time taken by one flush, and whether the output matches whole frames.
+bool CompareBlockSizes(const stChipScript &Script, int Frames, const stRunOptions &Options)
+{
+	const double BLOCK_MS[] = {0.0, 5.0, 3.0, 1.0};		// 0 is whole frames, the reference
+	std::vector<int16_t> Reference;
+	bool Exact = true;
+
+	for (double Milliseconds : BLOCK_MS) {
+		stRunOptions BlockOptions = Options;
+		BlockOptions.BlockSamples = static_cast<uint32_t>(Options.SampleRate * Milliseconds / 1000.0);
+		BlockOptions.Stems = false;
+
+		CBenchCallback Callback;
+		auto pAPU = CreateAPU(Callback, Script.Chip, BlockOptions);
+		if (!pAPU) {
+			std::fprintf(stderr, "%s: could not allocate sound buffer\n", Script.Name);
+			std::exit(1);
+		}
+
+		CScriptWriter Writer(*pAPU);
+		if (Script.Init)
+			Script.Init(Writer);
+		Writer.EndFrame();
+		std::vector<int16_t> Output;
+		Callback = CBenchCallback { };
+		Callback.m_pCapture = &Output;
+		Callback.m_pAPU = pAPU.get();
+		Callback.m_FlushCycles.reserve(static_cast<size_t>(Frames) * (FRAME_CYCLES / 1000 + 2));
+
+		// Each write is matched with the first flush at or after its cycle
+		CRegisterJournalReader Reader(pAPU->GetRegisterJournal());
+		std::vector<uint64_t> WriteCycles;
+		uint64_t Latency = 0, WorstLatency = 0, Writes = 0;
+		size_t Flush = 0;
+		const auto MatchWrites = [&] {
+			for (uint64_t Cycle : WriteCycles) {
+				while (Flush < Callback.m_FlushCycles.size() && Callback.m_FlushCycles[Flush] < Cycle)
+					++Flush;
+				if (Flush == Callback.m_FlushCycles.size())
+					break;
+				Latency += Callback.m_FlushCycles[Flush] - Cycle;
+				WorstLatency = std::max(WorstLatency, Callback.m_FlushCycles[Flush] - Cycle);
+				++Writes;
+			}
+			WriteCycles.clear();
+		};
+
+		const auto Start = std::chrono::steady_clock::now();
+		for (int i = 0; i < Frames; ++i) {
+			Script.Frame(Writer, i);
+			Writer.EndFrame();
+			Reader.Poll([&] (const CRegisterJournal::stWrite &w) { WriteCycles.push_back(w.Cycle); });
+			MatchWrites();
+		}
+		const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+
+		const char *Result = "reference";
+		if (Milliseconds == 0.0)
+			Reference = std::move(Output);
+		else if (Output == Reference)
+			Result = "bit-exact";
+		else {
+			Result = "MISMATCH";
+			Exact = false;
+		}
+
+		const double CyclesToMs = 1000.0 / CAPU::BASE_FREQ_NTSC;
+		char Name[16];
+		if (Milliseconds == 0.0)
+			std::snprintf(Name, sizeof(Name), "Frame");
+		else
+			std::snprintf(Name, sizeof(Name), "%u", BlockOptions.BlockSamples);
+		std::printf("%-8s %-7s %10.1f %10llu %10.2f %10.2f %11.1f  %s\n", Milliseconds == 0.0 ? Script.Name : "", Name,
+			Seconds * 1000.0, static_cast<unsigned long long>(Callback.m_iFlushes),
+			Writes ? Latency * CyclesToMs / Writes : 0.0, WorstLatency * CyclesToMs,
+			Callback.m_fWorstFlush * 1e6, Result);
+	}
+	return Exact;
+}
+
+/// Runs the post-filter kernels of every supported level over the same random
+/// blocks as the scalar kernels, and prints their speed and whether they match.
+bool ComparePostFilters()
+{
+	const std::size_t MAX_BLOCK = 2048;
+	const std::size_t FRAME_SAMPLES = 800;		// 48 kHz at 60 Hz
+	const int ROUNDS = 400;
+	const float ALPHAS[] = {1.0f, 0.5f, 0.2371f, 0.0123f, 1e-4f};		// 0.5 produces ties for roundf
+	const double GAINS[] = {1.0, 4.6, 0.3337, 20.0, -2.5};				// 20 clamps most samples
+
+	uint32_t Seed = 0x12345678u;
+	auto Random = [&] {
+		Seed ^= Seed << 13;
+		Seed ^= Seed >> 17;
+		Seed ^= Seed << 5;
+		return Seed;
+	};
+
+	struct stCase {
+		std::vector<int16_t> Input;
+		std::vector<int32_t> Raw;
+		std::size_t Offset;
+		float Alpha;
+		double Gain;
+	};
+	std::vector<stCase> Cases(ROUNDS);
+	for (int i = 0; i < ROUNDS; ++i) {
+		stCase &c = Cases[i];
+		// Short blocks exercise the scalar tails, long ones the vector loops
+		const std::size_t Size = i < 64 ? i : i == ROUNDS - 1 ? MAX_BLOCK : 1 + Random() % MAX_BLOCK;
+		c.Offset = Random() % 8;		// unaligned starts
+		c.Alpha = ALPHAS[i % std::size(ALPHAS)];
+		c.Gain = GAINS[i % std::size(GAINS)];
+		for (std::size_t j = 0; j < c.Offset + Size; ++j) {
+			const uint32_t r = Random();
+			c.Input.push_back((r & 0x300) ? static_cast<int16_t>(r >> 16) : (r & 1) ? -32768 : 32767);
+			c.Raw.push_back(static_cast<int32_t>(r % 0x20001) - 0x10000);
+		}
+	}
+
+	struct stOutput {
+		std::vector<int16_t> Lowpass, Average;
+		std::vector<float> LowpassState;
+		std::vector<int32_t> AverageLast;
+	};
+	auto Run = [&] (simd_t Level, stOutput &Out) {
+		float State = 0.f;
+		int32_t Last = 0;
+		for (const stCase &c : Cases) {
+			const std::size_t Size = c.Input.size() - c.Offset;
+			std::vector<int16_t> Data(c.Input.begin() + c.Offset, c.Input.end());
+			PostFilter::Lowpass(Level, Data, c.Alpha, State);
+			Out.Lowpass.insert(Out.Lowpass.end(), Data.begin(), Data.end());
+			Out.LowpassState.push_back(State);
+
+			std::vector<int16_t> Averaged(Size);
+			PostFilter::ScaleAverage(Level, c.Raw.data() + c.Offset, Averaged.data(), Size, c.Gain, Last);
+			Out.Average.insert(Out.Average.end(), Averaged.begin(), Averaged.end());
+			Out.AverageLast.push_back(Last);
+		}
+	};
+
+	// Throughput over a frame-sized block, in Msamples/s
+	auto Time = [&] (auto &&Kernel) {
+		const int REPEAT = 20000;
+		const auto Start = std::chrono::steady_clock::now();
+		for (int i = 0; i < REPEAT; ++i)
+			Kernel();
+		const double Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+		return REPEAT * double(FRAME_SAMPLES) / Seconds / 1e6;
+	};
+
+	stOutput Reference;
+	Run(SIMD_NONE, Reference);
+
+	bool Match = true;
+	std::printf("\nPost-filter kernels\n");
+	std::printf("%-8s %14s %14s  %s\n", "Level", "Lowpass Ms/s", "Average Ms/s", "Accuracy");
+	for (int i = SIMD_NONE; i < SIMD_COUNT; ++i) {
+		const simd_t Level = static_cast<simd_t>(i);
+		if (!IsSimdSupported(Level))
+			continue;
+
+		stOutput Out;
+		Run(Level, Out);
+		const bool Exact = Out.Lowpass == Reference.Lowpass && Out.Average == Reference.Average &&
+			Out.AverageLast == Reference.AverageLast &&
+			!std::memcmp(Out.LowpassState.data(), Reference.LowpassState.data(), Out.LowpassState.size() * sizeof(float));
+		Match = Match && Exact;
+
+		std::vector<int16_t> Block(Reference.Lowpass.begin(), Reference.Lowpass.begin() + FRAME_SAMPLES);
+		std::vector<int32_t> Raw(Cases.back().Raw.begin(), Cases.back().Raw.begin() + FRAME_SAMPLES);
+		float State = 0.f;
+		int32_t Last = 0;
+		const double Lowpass = Time([&] { PostFilter::Lowpass(Level, Block, 0.2371f, State); });
+		const double Average = Time([&] { PostFilter::ScaleAverage(Level, Raw.data(), Block.data(), Block.size(), 4.6, Last); });
+		std::printf("%-8s %14.1f %14.1f  %s\n", GetSimdName(Level), Lowpass, Average,
+			Level == SIMD_NONE ? "reference" : Exact ? "bit-exact" : "MISMATCH");
+	}
+	return Match;
+}
+
+/// Times the Blip_Buffer kernels of every supported level on the same random input
+/// and compares the output against the scalar code (SIMD_NONE).
+bool CompareBlipKernels()
+{
+	const int FRAMES = 300;
+	const int DELTAS = 4000;		// impulses per frame
+	const blip_nclock_t FRAME_CLOCKS = FRAME_CYCLES;
+	const int SAMPLE_RATE = 48000;
+
+	// Same random stream for every level
+	struct stInput {
+		std::vector<blip_nclock_t> Times;
+		std::vector<int> Amplitudes;
+		std::vector<blip_amplitude_t> Samples;
+	} Input;
+	uint32_t Seed = 0x9E3779B9u;
+	auto Random = [&] {
+		Seed ^= Seed << 13;
+		Seed ^= Seed >> 17;
+		Seed ^= Seed << 5;
+		return Seed;
+	};
+	for (int i = 0; i < DELTAS; ++i) {
+		Input.Times.push_back(static_cast<blip_nclock_t>(uint64_t(i) * FRAME_CLOCKS / DELTAS));
+		Input.Amplitudes.push_back(static_cast<int>(Random() % 512) - 256);
+	}
+	for (int i = 0; i < 1024; ++i)
+		Input.Samples.push_back(static_cast<blip_amplitude_t>(Random() >> 16));
+
+	struct stResult {
+		std::vector<int16_t> Output;
+		double Synth, Mix, Read;		// seconds
+	};
+	auto Run = [&] (simd_t Level) {
+		SetSimdLevel(Level);
+		stResult r { { }, 0.0, 0.0, 0.0 };
+		Blip_Buffer Buffer(SAMPLE_RATE, CAPU::BASE_FREQ_NTSC);
+		Buffer.bass_freq(30);
+		Blip_Synth<blip_good_quality> Synth;
+		Synth.volume(1.0, 400);
+		Synth.treble_eq(blip_eq_t(-24, 12000, SAMPLE_RATE));
+		std::vector<int16_t> Block(SAMPLE_RATE / 10);
+
+		for (int f = 0; f < FRAMES; ++f) {
+			auto t0 = std::chrono::steady_clock::now();
+			for (int i = 0; i < DELTAS; ++i)
+				Synth.update(Input.Times[i], Input.Amplitudes[(i + f) % DELTAS], &Buffer);
+			auto t1 = std::chrono::steady_clock::now();
+			const blip_nsamp_t Count = std::min<blip_nsamp_t>(Buffer.count_samples(FRAME_CLOCKS), blip_nsamp_t(Input.Samples.size()));
+			Buffer.mix_samples(Input.Samples.data() + f % 8, Count - 8);
+			auto t2 = std::chrono::steady_clock::now();
+			Buffer.end_frame(FRAME_CLOCKS);
+			const blip_nsamp_t Read = Buffer.read_samples(Block.data(), Buffer.samples_avail());
+			auto t3 = std::chrono::steady_clock::now();
+			r.Output.insert(r.Output.end(), Block.begin(), Block.begin() + Read);
+			r.Synth += std::chrono::duration<double>(t1 - t0).count();
+			r.Mix += std::chrono::duration<double>(t2 - t1).count();
+			r.Read += std::chrono::duration<double>(t3 - t2).count();
+		}
+		return r;
+	};
+
+	const simd_t Active = GetSimdLevel();
+	const stResult Reference = Run(SIMD_NONE);
+	const double Samples = double(Reference.Output.size());
+
+	bool Match = true;
+	std::printf("\nBlip_Buffer kernels\n");
+	std::printf("%-8s %14s %14s %14s  %s\n", "Level", "Impulses M/s", "Mix Ms/s", "Read Ms/s", "Accuracy");
+	for (int i = SIMD_NONE; i < SIMD_COUNT; ++i) {
+		const simd_t Level = static_cast<simd_t>(i);
+		if (!IsSimdSupported(Level))
+			continue;
+		const stResult r = Level == SIMD_NONE ? Reference : Run(Level);
+		const bool Exact = r.Output == Reference.Output;
+		Match = Match && Exact;
+		std::printf("%-8s %14.1f %14.1f %14.1f  %s\n", GetSimdName(Level),
+			double(FRAMES) * DELTAS / r.Synth / 1e6, Samples / r.Mix / 1e6, Samples / r.Read / 1e6,
+			Level == SIMD_NONE ? "reference" : Exact ? "bit-exact" : "MISMATCH");
+	}
+	SetSimdLevel(Active);
+	return Match;
+}
+
+bool MatchesName(const char *Name, const char *Arg)
+{
+	while (*Name && *Arg)
+		if (std::toupper(static_cast<unsigned char>(*Name++)) != std::toupper(static_cast<unsigned char>(*Arg++)))
+			return false;
+	return !*Name && !*Arg;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	double Seconds = 60.0;
+	int DeviceRate = 0;
+	stRunOptions Options;
+	std::vector<const stChipScript *> Scripts, Selected;
+	for (const auto &s : SCRIPTS)
+		Scripts.push_back(&s);
+	Scripts.push_back(&MULTI_SCRIPT);
+
+	for (int i = 1; i < argc; ++i) {
+		if (!std::strcmp(argv[i], "-s") && i + 1 < argc)
+			Seconds = std::atof(argv[++i]);
+		else if (!std::strcmp(argv[i], "-r") && i + 1 < argc)
+			Options.SampleRate = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-device") && i + 1 < argc)
+			DeviceRate = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-b") && i + 1 < argc)
+			Options.BlockSamples = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-j") && i + 1 < argc)
+			Options.Threads = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-t"))
+			Options.Trace = true;
+		else if (!std::strcmp(argv[i], "-stems"))
+			Options.Stems = true;
+		else if (!std::strcmp(argv[i], "-vgm") && i + 1 < argc)
+			Options.VGMDir = argv[++i];
+		else if (!std::strcmp(argv[i], "-simd") && i + 1 < argc) {
+			const char *Name = argv[++i];
+			int Level = SIMD_NONE;
+			while (Level < SIMD_COUNT && !MatchesName(GetSimdName(static_cast<simd_t>(Level)), Name))
+				++Level;
+			if (Level == SIMD_COUNT || !IsSimdSupported(static_cast<simd_t>(Level))) {
+				std::fprintf(stderr, "%s: unsupported SIMD level %s\n", argv[0], Name);
+				return 1;
+			}
+			SetSimdLevel(static_cast<simd_t>(Level));
+		}
+		else {
+			auto it = std::find_if(Scripts.begin(), Scripts.end(), [&] (const stChipScript *s) {
+				return MatchesName(s->Name, argv[i]);
+			});
+			if (it == Scripts.end()) {
+				std::fprintf(stderr, "Usage: %s [-s seconds] [-r samplerate] [-device samplerate] [-b samples] [-j threads] [-t] [-stems] [-vgm dir] [-simd level] [chip ...]\nChips:", argv[0]);
+				for (const stChipScript *s : Scripts)
+					std::fprintf(stderr, " %s", s->Name);
+				std::fprintf(stderr, "\n");
+				return 1;
+			}
+			Selected.push_back(*it);
+		}
+	}
+	if (Selected.empty())
+		Selected = Scripts;
+
+	const int Frames = std::max(1, static_cast<int>(Seconds * CAPU::FRAME_RATE_NTSC));
+
+	if (Options.Trace) {
+		for (const stChipScript *Script : Selected)
+			RunScript(*Script, Frames, Options);
+		return 0;
+	}
+
+	std::printf("%d frames (%.1f s emulated) at %d Hz, 2A03 always enabled, %u emulation threads, %s kernels%s\n\n",
+		Frames, Frames / double(CAPU::FRAME_RATE_NTSC), Options.SampleRate, std::max(Options.Threads, 1u),
+		GetSimdName(GetSimdLevel()), Options.Stems ? ", per-channel stems" : "");
+	std::printf("%-8s %10s %14s %14s %10s  %-8s\n", "Chip", "Wall (ms)", "Mcycles/s", "ksamples/s", "Realtime", "Checksum");
+	for (const stChipScript *Script : Selected) {
+		const stBenchResult r = RunScript(*Script, Frames, Options);
+		std::printf("%-8s %10.1f %14.2f %14.1f %9.1fx  %08X\n", Script->Name,
+			r.Seconds * 1000.0,
+			r.Cycles / r.Seconds / 1e6,
+			r.Samples / r.Seconds / 1e3,
+			Frames / double(CAPU::FRAME_RATE_NTSC) / r.Seconds,
+			r.Checksum);
+	}
+
+	BenchPSGDense(Selected, Frames, Options);
+	for (const stChipScript *Script : Selected)
+		if (Script->Chip == SNDCHIP_VRC7 || Script->Chip == SNDCHIP_OPLL)
+			CompareOPLLModes(*Script, Frames, Options.SampleRate);
+
+	std::printf("\nState save and restore (see CAPU::SaveState)\n");
+	std::printf("%-8s %10s %10s %10s  %s\n", "Chip", "Size (KB)", "Save (us)", "Load (us)", "Output");
+	bool Restored = true;
+	for (const stChipScript *Script : Selected)
+		Restored = CompareStateRestore(*Script, Frames, Options) && Restored;
+	if (!Restored) {
+		std::fprintf(stderr, "restored states do not reproduce the output\n");
+		return 1;
+	}
+
+	std::printf("\nOutput blocks (see CAPU::SetBlockSamples), write latency in emulated time\n");
+	std::printf("%-8s %-7s %10s %10s %10s %10s %11s  %s\n", "Chip", "Block", "Wall (ms)", "Flushes",
+		"Mean (ms)", "Max (ms)", "Worst (us)", "Output");
+	bool Blocked = true;
+	for (const stChipScript *Script : Selected)
+		Blocked = CompareBlockSizes(*Script, Frames, Options) && Blocked;
+	if (!Blocked) {
+		std::fprintf(stderr, "output blocks change the rendered audio\n");
+		return 1;
+	}
+
+	if (DeviceRate) {
+		std::printf("\nDevice at %d Hz: Blip_Buffer at %d Hz vs %d Hz + libsamplerate (medium sinc)\n",
+			DeviceRate, DeviceRate, Options.SampleRate);
+		std::printf("%-8s %-10s %10s %10s  %s\n", "Chip", "Path", "Wall (ms)", "Realtime", "Output");
+		for (const stChipScript *Script : Selected)
+			if (!CompareDeviceRate(*Script, Frames, Options.SampleRate, DeviceRate))
+				return 1;
+	}
+
+	if (!CompareBlipKernels()) {
+		std::fprintf(stderr, "Blip_Buffer kernels differ from the scalar code\n");
+		return 1;
+	}
+
+	const int POST_FILTER_CHIPS = SNDCHIP_FDS | SNDCHIP_N163 | SNDCHIP_VRC7 | SNDCHIP_OPLL;
+	if (std::any_of(Selected.begin(), Selected.end(), [&] (const stChipScript *s) { return s->Chip & POST_FILTER_CHIPS; }))
+		if (!ComparePostFilters()) {
+			std::fprintf(stderr, "post-filter kernels differ from the scalar reference\n");
+			return 1;
+		}
+
+	return 0;
+}
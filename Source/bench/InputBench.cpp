@@ -0,0 +1,288 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+// Real-time benchmark of the live note input path, from an input event to the
+// sample that plays it.
+//
+// A producer thread stands in for the MIDI input callback: it sends note events
+// at random intervals, stamped with CLiveNoteScheduler::Now(), through a
+// rigtorp::SPSCQueue. The main thread stands in for the sound thread of
+// CSoundGen: every tick it drains the queue, writes each note to the 2A03 at a
+// cycle within the tick, and plays the tick into a simulated audio device that
+// consumes samples in real time and accepts at most one buffer length ahead of
+// them. The APU flushes in blocks, as it does for a device (see
+// CAPU::SetBlockSamples), so writing a block waits for space in the buffer the
+// same way CSoundGen::PlayBuffer does.
+//
+// The latency of a note is the time at which the device plays the first sample
+// after its register write, minus its time stamp. The run is done twice: once
+// applying every note at the start of the tick, as CSoundGen did before live
+// notes carried time stamps, and once placing it within the tick with
+// CLiveNoteScheduler. Mean, minimum, maximum and standard deviation (jitter) are
+// printed for both; device underruns are counted and the run fails if the
+// timestamped jitter is not below the tick-start jitter.
+//
+// Usage: input-bench [-s seconds] [-r samplerate] [-l buffer ms] [-b samples] [-n notes per second]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include "APU/APU.h"
+#include "LiveNoteScheduler.h"
+#include "rigtorp/SPSCQueue.h"
+
+namespace {
+
+const int WRITE_DELAY_SAME_CHIP = 150;		// Same spacing CSoundGen::UpdateAPU uses
+const int FRAME_CYCLES = CAPU::BASE_FREQ_NTSC / CAPU::FRAME_RATE_NTSC;
+const std::size_t QUEUE_SIZE = 256;
+
+struct stRunOptions {
+	double Seconds = 5.0;
+	int SampleRate = 48000;
+	double BufferMs = 10.0;
+	uint32_t BlockSamples = 48;
+	double NotesPerSecond = 20.0;
+};
+
+struct stInputEvent {
+	std::int64_t Time;
+	uint8_t Note;
+};
+
+/// Audio device consuming samples in real time, with a buffer of fixed length.
+class CDeviceCallback : public IAudioCallback {
+public:
+	CDeviceCallback(int SampleRate, uint64_t BufferSamples) :
+		m_iSampleRate(SampleRate), m_iBufferSamples(BufferSamples), m_iStart(CLiveNoteScheduler::Now())
+	{
+	}
+
+	void FlushBuffer(int16_t const *, uint32_t Size) override {
+		// Wait until the samples fit in the buffer
+		const uint64_t End = m_iWritten + Size;
+		if (End > m_iBufferSamples) {
+			const std::int64_t Ready = PlayTime(End - m_iBufferSamples);
+			const std::int64_t Now = CLiveNoteScheduler::Now();
+			if (Ready > Now)
+				std::this_thread::sleep_for(std::chrono::microseconds(Ready - Now));
+		}
+
+		// Restart the device if it ran dry
+		const std::int64_t Now = CLiveNoteScheduler::Now();
+		if (PlayTime(m_iWritten) < Now) {
+			if (m_iWritten)
+				++m_iUnderruns;
+			m_iStart = Now - m_iWritten * 1000000 / m_iSampleRate;
+		}
+		m_iWritten = End;
+
+		// Samples written so far are now scheduled for good
+		auto it = m_Pending.begin();
+		for (; it != m_Pending.end() && it->Sample < m_iWritten; ++it)
+			m_Latency.push_back((PlayTime(it->Sample) - it->Time) / 1000.0);
+		m_Pending.erase(m_Pending.begin(), it);
+	}
+
+	/// Records an input event played from Sample on.
+	void AddNote(uint64_t Sample, std::int64_t Time) {
+		m_Pending.push_back({Sample, Time});
+	}
+
+	/// Time at which the device plays Sample.
+	std::int64_t PlayTime(uint64_t Sample) const {
+		return m_iStart + static_cast<std::int64_t>(Sample * 1000000 / m_iSampleRate);
+	}
+
+	std::vector<double> m_Latency;		// Per note, in milliseconds
+	uint64_t m_iUnderruns = 0;
+
+private:
+	struct stPending {
+		uint64_t Sample;
+		std::int64_t Time;
+	};
+
+	const int m_iSampleRate;
+	const uint64_t m_iBufferSamples;
+	std::int64_t m_iStart;				// Time at which sample 0 plays
+	uint64_t m_iWritten = 0;
+	std::vector<stPending> m_Pending;
+};
+
+struct stResult {
+	std::size_t Notes = 0;
+	std::size_t Dropped = 0;
+	uint64_t Underruns = 0;
+	double Mean = 0.0, Min = 0.0, Max = 0.0, Jitter = 0.0;
+};
+
+stResult RunInput(const stRunOptions &Options, bool Timestamped)
+{
+	stResult Result;
+	const uint64_t BufferSamples = static_cast<uint64_t>(Options.BufferMs * Options.SampleRate / 1000.0);
+	CDeviceCallback Device(Options.SampleRate, std::max<uint64_t>(BufferSamples, Options.BlockSamples));
+
+	CAPU APU(&Device);
+	if (!APU.SetupSound(Options.SampleRate, 1, MACHINE_NTSC))
+		return Result;
+	{
+		auto config = CAPUConfig(&APU);
+		const MixerConfig Mix { };
+		config.SetExternalSound(SNDCHIP_NONE);
+		config.SetupMixer(30, 12000, 24, 100, false, Mix.FDSLowpass, Mix.N163Lowpass, Mix.DeviceMixOffsets);
+	}
+	APU.SetBlockSamples(Options.BlockSamples);
+	APU.Write(0x4015, 0x0F);
+	APU.Write(0x4001, 0x08);
+
+	CLiveNoteScheduler Scheduler;
+	Scheduler.SetTickLength(FRAME_CYCLES, CAPU::BASE_FREQ_NTSC);
+
+	// Synthetic event source
+	rigtorp::SPSCQueue<stInputEvent> Queue(QUEUE_SIZE);
+	std::atomic<bool> Stop {false};
+	std::atomic<std::size_t> Dropped {0};
+	std::thread Producer([&] {
+		std::mt19937 Rng(Timestamped ? 1 : 2);
+		std::exponential_distribution<double> Interval(Options.NotesPerSecond);
+		uint8_t Note = 0;
+		while (!Stop.load(std::memory_order_relaxed)) {
+			std::this_thread::sleep_for(std::chrono::duration<double>(Interval(Rng)));
+			if (!Queue.try_push(stInputEvent {CLiveNoteScheduler::Now(), Note++}))
+				Dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+	});
+
+	struct stPlaced {
+		uint32_t Cycle;
+		stInputEvent Event;
+	};
+	std::vector<stPlaced> Notes;
+
+	const int Ticks = std::max(1, static_cast<int>(Options.Seconds * CAPU::FRAME_RATE_NTSC));
+	for (int Tick = 0; Tick < Ticks; ++Tick) {
+		Scheduler.BeginTick(CLiveNoteScheduler::Now());
+		Notes.clear();
+		while (auto pEvent = Queue.front()) {
+			Notes.push_back({Timestamped ? Scheduler.Place(pEvent->Time) : 0, *pEvent});
+			Queue.pop();
+		}
+		std::stable_sort(Notes.begin(), Notes.end(), [] (const stPlaced &a, const stPlaced &b) { return a.Cycle < b.Cycle; });
+
+		// Pattern channels first, then every live note at its cycle
+		int Consumed = 0;
+		for (int i = 0; i < 4; ++i) {
+			APU.AddCycles(WRITE_DELAY_SAME_CHIP);
+			APU.Process();
+			Consumed += WRITE_DELAY_SAME_CHIP;
+		}
+		for (const auto &x : Notes) {
+			if (static_cast<int>(x.Cycle) > Consumed) {
+				APU.AddCycles(x.Cycle - Consumed);
+				APU.Process();
+				Consumed = x.Cycle;
+			}
+			const unsigned Period = 0xFE + (x.Event.Note % 12) * 8;
+			APU.Write(0x4000, 0xB0 | (x.Event.Note & 1 ? 0x0F : 0x08));
+			APU.Write(0x4002, Period & 0xFF);
+			APU.Write(0x4003, Period >> 8);
+			Device.AddNote((APU.GetCycleCount() * Options.SampleRate + CAPU::BASE_FREQ_NTSC - 1) / CAPU::BASE_FREQ_NTSC, x.Event.Time);
+		}
+		APU.AddCycles(FRAME_CYCLES - Consumed);
+		APU.Process();
+	}
+
+	Stop = true;
+	Producer.join();
+
+	const auto &Latency = Device.m_Latency;
+	Result.Notes = Latency.size();
+	Result.Dropped = Dropped;
+	Result.Underruns = Device.m_iUnderruns;
+	if (!Latency.empty()) {
+		double Sum = 0.0, SumSq = 0.0;
+		for (double x : Latency) {
+			Sum += x;
+			SumSq += x * x;
+		}
+		Result.Mean = Sum / Latency.size();
+		Result.Jitter = std::sqrt(std::max(0.0, SumSq / Latency.size() - Result.Mean * Result.Mean));
+		Result.Min = *std::min_element(Latency.begin(), Latency.end());
+		Result.Max = *std::max_element(Latency.begin(), Latency.end());
+	}
+	return Result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	stRunOptions Options;
+	for (int i = 1; i < argc; ++i) {
+		if (!std::strcmp(argv[i], "-s") && i + 1 < argc)
+			Options.Seconds = std::atof(argv[++i]);
+		else if (!std::strcmp(argv[i], "-r") && i + 1 < argc)
+			Options.SampleRate = std::atoi(argv[++i]);
+		else if (!std::strcmp(argv[i], "-l") && i + 1 < argc)
+			Options.BufferMs = std::atof(argv[++i]);
+		else if (!std::strcmp(argv[i], "-b") && i + 1 < argc)
+			Options.BlockSamples = static_cast<uint32_t>(std::atoi(argv[++i]));
+		else if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+			Options.NotesPerSecond = std::atof(argv[++i]);
+		else {
+			std::fprintf(stderr, "Usage: %s [-s seconds] [-r samplerate] [-l buffer ms] [-b samples] [-n notes per second]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (Options.SampleRate <= 0 || Options.BufferMs <= 0.0 || Options.NotesPerSecond <= 0.0) {
+		std::fprintf(stderr, "%s: invalid options\n", argv[0]);
+		return 1;
+	}
+
+	std::printf("%.1f s at %d Hz, %.1f ms device buffer, %u sample blocks, %.1f notes/s, %.2f ms ticks\n\n",
+		Options.Seconds, Options.SampleRate, Options.BufferMs, Options.BlockSamples, Options.NotesPerSecond,
+		1000.0 * FRAME_CYCLES / CAPU::BASE_FREQ_NTSC);
+	std::printf("%-12s %8s %8s %10s %10s %10s %10s %10s\n",
+		"Placement", "Notes", "Dropped", "Mean ms", "Min ms", "Max ms", "Jitter ms", "Underruns");
+
+	const stResult TickStart = RunInput(Options, false);
+	const stResult Timestamped = RunInput(Options, true);
+	for (const auto &[Name, r] : {std::make_pair("Tick start", TickStart), std::make_pair("Timestamped", Timestamped)})
+		std::printf("%-12s %8zu %8zu %10.2f %10.2f %10.2f %10.2f %10llu\n", Name, r.Notes, r.Dropped,
+			r.Mean, r.Min, r.Max, r.Jitter, static_cast<unsigned long long>(r.Underruns));
+
+	if (!TickStart.Notes || !Timestamped.Notes) {
+		std::fprintf(stderr, "no notes were played\n");
+		return 1;
+	}
+	if (Timestamped.Jitter >= TickStart.Jitter) {
+		std::fprintf(stderr, "timestamped placement does not reduce jitter\n");
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,307 @@
+/*
+** Dn-FamiTracker - NES/Famicom sound tracker
+** Copyright (C) 2020-2025 D.P.C.M.
+** FamiTracker Copyright (C) 2005-2020 Jonathan Liss
+** 0CC-FamiTracker Copyright (C) 2014-2018 HertzDevil
+**
+** This program is free software: you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation, either version 3 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program. If not, see https://www.gnu.org/licenses/.
+*/
+
+// Headless benchmark of the undo journal on whole tracks.
+//
+// A track of 256 frames of 256 rows is filled with a pseudo-random song, and
+// selection edits over all of it (transpose, volume scroll, instrument replace,
+// reverse, stretch) are recorded into a CUndoJournal the way CPSelectionAction
+// does, then undone and redone. Each edit reports the time to perform, record
+// and undo it, and the bytes its entry takes next to the single full clip
+// CPSelectionAction used to keep. A run of repeated transposes is then coalesced
+// into one entry (see CPActionTranspose::Merge).
+//
+// Every undo must bring back the track exactly as it was before the edit, and
+// every redo the track after it; the run fails otherwise.
+//
+// Usage: undo-bench [-c channels] [-n repeats]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "UndoJournal.h"
+
+namespace {
+
+const int FRAMES = 256;
+const int ROWS = 256;
+
+const unsigned char NONE = 0;
+const unsigned char NOTE_B = 12;
+const unsigned char MAX_VOLUME = 0x10;
+const unsigned char MAX_INSTRUMENTS = 0x40;
+
+/// Same layout as stChanNote.
+struct stCell {
+	unsigned char Note = NONE;
+	unsigned char Octave = 0;
+	unsigned char Vol = MAX_VOLUME;
+	unsigned char Instrument = MAX_INSTRUMENTS;
+	unsigned char EffNumber[4] = { };
+	unsigned char EffParam[4] = { };
+};
+
+static_assert(sizeof(stCell) == 12, "stCell must match stChanNote");
+
+/// A track with one pattern per frame, so every cell is addressed by its frame.
+class CTrack {
+public:
+	explicit CTrack(int Channels) : m_iChannels(Channels), m_Cells(std::size_t(Channels) * FRAMES * ROWS) { }
+
+	int GetChannels() const { return m_iChannels; }
+	std::size_t GetCellCount() const { return m_Cells.size(); }
+
+	stCell &At(int Channel, int Frame, int Row) { return m_Cells[Index(Channel, Frame, Row)]; }
+	const stCell &At(int Channel, int Frame, int Row) const { return m_Cells[Index(Channel, Frame, Row)]; }
+	stCell &At(std::uint32_t Key) { return m_Cells[Key]; }
+
+	/// Same order as the keys CPSelectionAction uses: by channel, then frame, then row.
+	static std::uint32_t Key(int Channel, int Frame, int Row) {
+		return (static_cast<std::uint32_t>(Channel) * FRAMES + Frame) * ROWS + Row;
+	}
+
+	bool operator==(const CTrack &Other) const {
+		return !std::memcmp(m_Cells.data(), Other.m_Cells.data(), m_Cells.size() * sizeof(stCell));
+	}
+
+private:
+	std::size_t Index(int Channel, int Frame, int Row) const { return Key(Channel, Frame, Row); }
+
+	int m_iChannels;
+	std::vector<stCell> m_Cells;
+};
+
+void FillSong(CTrack &Track)
+{
+	std::uint32_t Seed = 12345;
+	const auto Next = [&Seed] { Seed = Seed * 1103515245u + 12345u; return Seed >> 16; };
+	for (int c = 0; c < Track.GetChannels(); ++c)
+		for (int f = 0; f < FRAMES; ++f)
+			for (int r = 0; r < ROWS; ++r) {
+				stCell &Cell = Track.At(c, f, r);
+				if (r % 4 == 0 || Next() % 3 == 0) {		// mostly busy channels
+					Cell.Note = 1 + Next() % NOTE_B;
+					Cell.Octave = 2 + Next() % 4;
+					Cell.Instrument = Next() % 8;
+					Cell.Vol = Next() % 2 ? Next() % MAX_VOLUME : MAX_VOLUME;
+				}
+				if (Next() % 8 == 0) {
+					Cell.EffNumber[0] = 1 + Next() % 20;
+					Cell.EffParam[0] = static_cast<unsigned char>(Next());
+				}
+			}
+}
+
+// Selection edits over the whole track, in the spirit of the CPSelectionAction subclasses
+
+void Transpose(CTrack &Track)
+{
+	for (int c = 0; c < Track.GetChannels(); ++c)
+		for (int f = 0; f < FRAMES; ++f)
+			for (int r = 0; r < ROWS; ++r) {
+				stCell &Cell = Track.At(c, f, r);
+				if (Cell.Note < 1 || Cell.Note > NOTE_B)
+					continue;
+				int Midi = Cell.Octave * NOTE_B + Cell.Note - 1 + 1;
+				Midi = std::min(Midi, NOTE_B * 8 - 1);
+				Cell.Note = static_cast<unsigned char>(Midi % NOTE_B + 1);
+				Cell.Octave = static_cast<unsigned char>(Midi / NOTE_B);
+			}
+}
+
+void ScrollVolume(CTrack &Track)
+{
+	for (int c = 0; c < Track.GetChannels(); ++c)
+		for (int f = 0; f < FRAMES; ++f)
+			for (int r = 0; r < ROWS; ++r) {
+				stCell &Cell = Track.At(c, f, r);
+				if (Cell.Vol != MAX_VOLUME)
+					Cell.Vol = (Cell.Vol + 1) % MAX_VOLUME;
+			}
+}
+
+void ReplaceInstrument(CTrack &Track)
+{
+	for (int c = 0; c < Track.GetChannels(); ++c)
+		for (int f = 0; f < FRAMES; ++f)
+			for (int r = 0; r < ROWS; ++r) {
+				stCell &Cell = Track.At(c, f, r);
+				if (Cell.Instrument != MAX_INSTRUMENTS)
+					Cell.Instrument = 3;
+			}
+}
+
+void Reverse(CTrack &Track)
+{
+	for (int c = 0; c < Track.GetChannels(); ++c)
+		for (int a = 0, b = FRAMES * ROWS - 1; a < b; ++a, --b)
+			std::swap(Track.At(c, a / ROWS, a % ROWS), Track.At(c, b / ROWS, b % ROWS));
+}
+
+void Stretch(CTrack &Track)		// double speed: every other row, then blanks
+{
+	for (int c = 0; c < Track.GetChannels(); ++c) {
+		for (int i = 0; i < FRAMES * ROWS / 2; ++i)
+			Track.At(c, i / ROWS, i % ROWS) = Track.At(c, i * 2 / ROWS, i * 2 % ROWS);
+		for (int i = FRAMES * ROWS / 2; i < FRAMES * ROWS; ++i)
+			Track.At(c, i / ROWS, i % ROWS) = stCell { };
+	}
+}
+
+struct stEdit {
+	const char *Name;
+	void (*Apply)(CTrack &);
+};
+
+const stEdit EDITS[] = {
+	{"Transpose",  Transpose},
+	{"Volume",     ScrollVolume},
+	{"ReplInst",   ReplaceInstrument},
+	{"Reverse",    Reverse},
+	{"Stretch",    Stretch},
+};
+
+double Seconds(std::chrono::steady_clock::time_point Start)
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+}
+
+/// Records the difference between two tracks as an entry, as CPSelectionAction::Compact does.
+void RecordTrack(CUndoJournal &Journal, const CTrack &Before, const CTrack &After)
+{
+	for (int c = 0; c < Before.GetChannels(); ++c)
+		for (int f = 0; f < FRAMES; ++f)
+			for (int r = 0; r < ROWS; ++r)
+				Journal.Record(CTrack::Key(c, f, r), &Before.At(c, f, r), &After.At(c, f, r));
+}
+
+void Replay(const CUndoJournal &Journal, CUndoJournal::handle_t Entry, CTrack &Track, bool Redo)
+{
+	Journal.Replay(Entry, [&] (const CUndoJournal::stCell &Cell) {
+		Cell.Apply(&Track.At(Cell.Key), Redo);
+	});
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+	int Channels = 8;
+	int Repeats = 3;
+	for (int i = 1; i < argc; ++i) {
+		if (!std::strcmp(argv[i], "-c") && i + 1 < argc)
+			Channels = std::max(1, std::atoi(argv[++i]));
+		else if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+			Repeats = std::max(1, std::atoi(argv[++i]));
+		else {
+			std::fprintf(stderr, "Usage: %s [-c channels] [-n repeats]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	CTrack Song(Channels);
+	FillSong(Song);
+	CTrack Track = Song;
+	const double ClipKB = Song.GetCellCount() * sizeof(stCell) / 1024.0;
+
+	std::printf("%d channels x %d frames x %d rows, %d runs of each edit, best time kept\n\n", Channels, FRAMES, ROWS, Repeats);
+	std::printf("%-10s %10s %10s %10s %10s %12s %10s  %s\n",
+		"Edit", "Cells", "Edit (ms)", "Rec (ms)", "Undo (ms)", "Entry (KB)", "Clip (KB)", "Replay");
+
+	CUndoJournal Journal;
+	bool Exact = true;
+	for (const stEdit &Edit : EDITS) {
+		double EditTime = 1e9, RecordTime = 1e9, UndoTime = 1e9;
+		std::size_t Cells = 0, Size = 0;
+		bool Match = true;
+		for (int n = 0; n < Repeats; ++n) {
+			Track = Song;
+			const CTrack Before = Track;
+			auto Start = std::chrono::steady_clock::now();
+			Edit.Apply(Track);
+			EditTime = std::min(EditTime, Seconds(Start));
+			const CTrack After = Track;
+
+			const std::size_t OldSize = Journal.GetSize();
+			Start = std::chrono::steady_clock::now();
+			Journal.Begin(sizeof(stCell));
+			RecordTrack(Journal, Before, Track);
+			const auto Entry = Journal.Commit();
+			RecordTime = std::min(RecordTime, Seconds(Start));
+			Cells = Journal.GetCellCount(Entry);
+			Size = Journal.GetSize() - OldSize;
+
+			Start = std::chrono::steady_clock::now();
+			Replay(Journal, Entry, Track, false);
+			UndoTime = std::min(UndoTime, Seconds(Start));
+			Match = Match && Track == Before;
+			Replay(Journal, Entry, Track, true);
+			Match = Match && Track == After;
+			Journal.Release(Entry);
+		}
+		std::printf("%-10s %10zu %10.2f %10.2f %10.2f %12.1f %10.1f  %s\n", Edit.Name, Cells,
+			EditTime * 1e3, RecordTime * 1e3, UndoTime * 1e3, Size / 1024.0, ClipKB, Match ? "exact" : "MISMATCH");
+		Exact = Exact && Match;
+	}
+
+	// Repeated transposes of the same selection coalesce into one entry
+	const int STEPS = 12;
+	Track = Song;
+	const CTrack Original = Track;
+	Journal.Begin(sizeof(stCell));
+	CUndoJournal::handle_t Entry = CUndoJournal::NO_ENTRY;
+	auto Start = std::chrono::steady_clock::now();
+	for (int i = 0; i < STEPS; ++i) {
+		CTrack Before = Track;
+		Transpose(Track);
+		Journal.Begin(sizeof(stCell));
+		RecordTrack(Journal, Before, Track);
+		if (Entry == CUndoJournal::NO_ENTRY || !Journal.CommitInto(Entry))
+			Entry = Journal.Commit();
+	}
+	const double MergeTime = Seconds(Start);
+	const CTrack Final = Track;
+	Replay(Journal, Entry, Track, false);
+	bool Match = Track == Original;
+	Replay(Journal, Entry, Track, true);
+	Match = Match && Track == Final;
+	std::printf("\n%d transposes coalesced: %zu cells, %.1f KB, %.2f ms including the edits, %s\n",
+		STEPS, Journal.GetCellCount(Entry), Journal.GetSize() / 1024.0, MergeTime * 1e3, Match ? "exact" : "MISMATCH");
+	Exact = Exact && Match;
+
+	// Writing the original notes back as another edit cancels the entry out
+	const CTrack Before = Track;
+	Track = Original;
+	Journal.Begin(sizeof(stCell));
+	RecordTrack(Journal, Before, Track);
+	Journal.CommitInto(Entry);
+	std::printf("Reverted by a further edit: %zu cells left in the entry\n", Journal.GetCellCount(Entry));
+	Exact = Exact && Journal.GetCellCount(Entry) == 0 && Track == Original;
+	Journal.Release(Entry);
+
+	if (!Exact) {
+		std::fprintf(stderr, "undo journal does not restore the edited tracks\n");
+		return 1;
+	}
+	return 0;
+}
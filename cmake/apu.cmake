@@ -0,0 +1,155 @@
+# Headless sound emulation core (CAPU, CMixer and every CSoundChip/CSoundChip2).
+# Nothing in here may depend on MFC or the Win32 API, so the same sources can be
+# driven offline (batch rendering, benchmarks) on any platform.
+
+add_library(apu STATIC
+        # Emulator cores
+        Source/APU/digital-sound-antiques/emu2413.c
+        Source/APU/digital-sound-antiques/emu2413.h
+
+        Source/APU/mesen/BaseFdsChannel.h
+        Source/APU/mesen/FdsAudio.h
+        Source/APU/mesen/ModChannel.h
+        Source/APU/mesen/Namco163Audio.h
+
+        Source/APU/nsfplay/xgm/xtypes.h
+        Source/APU/nsfplay/xgm/devices/device.h
+        Source/APU/nsfplay/xgm/devices/devinfo.h
+        Source/APU/nsfplay/xgm/devices/Sound/nes_apu.cpp
+        Source/APU/nsfplay/xgm/devices/Sound/nes_apu.h
+        Source/APU/nsfplay/xgm/devices/Sound/nes_dmc.cpp
+        Source/APU/nsfplay/xgm/devices/Sound/nes_dmc.h
+        Source/APU/nsfplay/xgm/devices/Sound/5e01_apu.cpp
+        Source/APU/nsfplay/xgm/devices/Sound/5e01_apu.h
+        Source/APU/nsfplay/xgm/devices/Sound/5e01_dmc.cpp
+        Source/APU/nsfplay/xgm/devices/Sound/5e01_dmc.h
+        Source/APU/nsfplay/xgm/devices/Sound/7e02_apu.cpp
+        Source/APU/nsfplay/xgm/devices/Sound/7e02_apu.h
+        Source/APU/nsfplay/xgm/devices/Sound/7e02_dmc.cpp
+        Source/APU/nsfplay/xgm/devices/Sound/7e02_dmc.h
+
+        Source/APU/residfp/Dac.cpp
+        Source/APU/residfp/EnvelopeGenerator.cpp
+        Source/APU/residfp/ExternalFilter.cpp
+        Source/APU/residfp/Filter.cpp
+        Source/APU/residfp/Filter6581.cpp
+        Source/APU/residfp/Filter8580.cpp
+        Source/APU/residfp/FilterModelConfig.cpp
+        Source/APU/residfp/FilterModelConfig8580.cpp
+        Source/APU/residfp/Integrator.cpp
+        Source/APU/residfp/Integrator8580.cpp
+        Source/APU/residfp/OpAmp.cpp
+        Source/APU/residfp/resample/SincResampler.cpp
+        Source/APU/residfp/SID.cpp
+        Source/APU/residfp/Spline.cpp
+        Source/APU/residfp/version.cc
+        Source/APU/residfp/Voice.cpp
+        Source/APU/residfp/WaveformCalculator.cpp
+        Source/APU/residfp/WaveformGenerator.cpp
+
+        # Libraries
+        Source/Blip_Buffer/Blip_Buffer.cpp
+        Source/Blip_Buffer/Blip_Buffer.h
+        Source/Blip_Buffer/Blip_Simd.cpp
+
+        # Sources
+        Source/APU/2A03.cpp
+        Source/APU/2A03.h
+        Source/APU/2A03Chan.h
+        Source/APU/5E01.cpp
+        Source/APU/5E01.h
+        Source/APU/6581.cpp
+        Source/APU/6581.h
+        Source/APU/7E02.cpp
+        Source/APU/7E02.h
+        Source/APU/APU.cpp
+        Source/APU/APU.h
+        Source/APU/AY.h
+        Source/APU/AY8930.h
+        Source/APU/Channel.h
+        Source/APU/ChannelLevelState.h
+        Source/APU/FDS.cpp
+        Source/APU/FDS.h
+        Source/APU/Mixer.cpp
+        Source/APU/Mixer.h
+        Source/APU/MMC5.cpp
+        Source/APU/MMC5.h
+        Source/APU/N163.cpp
+        Source/APU/N163.h
+        Source/APU/OPLL.cpp
+        Source/APU/OPLL.h
+        Source/APU/PostFilter.cpp
+        Source/APU/PostFilter.h
+        Source/APU/PSG.cpp
+        Source/APU/PSG.h
+        Source/APU/S5B.h
+        Source/APU/Simd.cpp
+        Source/APU/Simd.h
+        Source/APU/SoundChip.cpp
+        Source/APU/SoundChip.h
+        Source/APU/SoundChip2.cpp
+        Source/APU/SoundChip2.h
+        Source/APU/Square.cpp
+        Source/APU/Square.h
+        Source/APU/StateArchive.cpp
+        Source/APU/StateArchive.h
+        Source/APU/Types.h
+        Source/APU/VRC6.cpp
+        Source/APU/VRC6.h
+        Source/APU/VRC7.cpp
+        Source/APU/VRC7.h
+        Source/APU/WorkerPool.cpp
+        Source/APU/WorkerPool.h
+        Source/APU/YM2149F.h
+        Source/Common.h
+        Source/LiveNoteScheduler.cpp
+        Source/LiveNoteScheduler.h
+        Source/RegisterJournal.cpp
+        Source/RegisterJournal.h
+        Source/RegisterState.cpp
+        Source/RegisterState.h
+        Source/VGMWriter.cpp
+        Source/VGMWriter.h
+        )
+
+target_include_directories(apu PUBLIC . Source)
+target_compile_features(apu PUBLIC cxx_std_17)
+
+find_package(Threads REQUIRED)
+target_link_libraries(apu PUBLIC Threads::Threads)
+
+# The Windows build adds libsamplerate through its own CMakeLists. Elsewhere, build
+# the converters directly from the bundled sources and their hardcoded config.h,
+# for the resampling comparison in apu-bench.
+if (NOT WIN32)
+    add_library(samplerate STATIC EXCLUDE_FROM_ALL
+            Source/libsamplerate/src/samplerate.c
+            Source/libsamplerate/src/src_linear.c
+            Source/libsamplerate/src/src_sinc.c
+            Source/libsamplerate/src/src_zoh.c
+            )
+    target_include_directories(samplerate PUBLIC Source/libsamplerate/include PRIVATE Source/libsamplerate/src)
+    target_compile_definitions(samplerate PRIVATE HAVE_CONFIG_H)
+    target_link_libraries(samplerate PRIVATE m)
+endif ()
+
+# Per-chip throughput benchmark, driven by scripted register writes.
+add_executable(apu-bench
+        Source/bench/APUBench.cpp
+        )
+target_link_libraries(apu-bench apu samplerate)
+
+# Undo journal benchmark on whole tracks (see CUndoJournal).
+add_executable(undo-bench
+        Source/bench/UndoBench.cpp
+        Source/UndoJournal.cpp
+        Source/UndoJournal.h
+        )
+target_include_directories(undo-bench PRIVATE Source)
+target_compile_features(undo-bench PRIVATE cxx_std_17)
+
+# Live note input latency and jitter, against a simulated audio device (see CLiveNoteScheduler).
+add_executable(input-bench
+        Source/bench/InputBench.cpp
+        )
+target_link_libraries(input-bench apu)
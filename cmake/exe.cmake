@@ -67,6 +67,7 @@ add_executable(${exe}
         # Libraries
         Source/Blip_Buffer/Blip_Buffer.cpp
         Source/Blip_Buffer/Blip_Buffer.h
+        Source/Blip_Buffer/Blip_Simd.cpp
 
         Source/FFT/FftBuffer.h
         Source/FFT/FftComplex.hpp
@@ -165,19 +166,28 @@ add_executable(${exe}
         Source/APU/MMC5.h
         Source/APU/N163.cpp
         Source/APU/N163.h
-        Source/APU/S5B.cpp
+        Source/APU/PostFilter.cpp
+        Source/APU/PostFilter.h
+        Source/APU/PSG.cpp
+        Source/APU/PSG.h
         Source/APU/S5B.h
+        Source/APU/Simd.cpp
+        Source/APU/Simd.h
         Source/APU/SoundChip.cpp
         Source/APU/SoundChip.h
         Source/APU/SoundChip2.cpp
         Source/APU/SoundChip2.h
         Source/APU/Square.cpp
         Source/APU/Square.h
+        Source/APU/StateArchive.cpp
+        Source/APU/StateArchive.h
         Source/APU/Types.h
         Source/APU/VRC6.cpp
         Source/APU/VRC6.h
         Source/APU/VRC7.cpp
         Source/APU/VRC7.h
+        Source/APU/WorkerPool.cpp
+        Source/APU/WorkerPool.h
 		
         Source/AboutDlg.cpp
         Source/AboutDlg.h
@@ -234,6 +244,8 @@ add_executable(${exe}
         Source/Common.h
         Source/Compiler.cpp
         Source/Compiler.h
+        Source/CompilerCache.cpp
+        Source/CompilerCache.h
         Source/CompoundAction.cpp
         Source/CompoundAction.h
         Source/ConfigAppearance.cpp
@@ -367,6 +379,10 @@ add_executable(${exe}
         Source/InstrumentVRC7.cpp
         Source/InstrumentVRC7.h
         Source/IntRange.h
+        Source/LiveNoteRouter.cpp
+        Source/LiveNoteRouter.h
+        Source/LiveNoteScheduler.cpp
+        Source/LiveNoteScheduler.h
         Source/MainFrm.cpp
         Source/MainFrm.h
         Source/MIDI.cpp
@@ -404,8 +420,14 @@ add_executable(${exe}
         Source/PCMImport.h
         Source/PerformanceDlg.cpp
         Source/PerformanceDlg.h
+        Source/PlaybackInstrument.cpp
+        Source/PlaybackInstrument.h
+        Source/PlayerKeyframes.cpp
+        Source/PlayerKeyframes.h
         Source/RecordSettingsDlg.cpp
         Source/RecordSettingsDlg.h
+        Source/RegisterJournal.cpp
+        Source/RegisterJournal.h
         Source/RegisterState.cpp
         Source/RegisterState.h
         Source/SampleEditorDlg.cpp
@@ -466,6 +488,10 @@ add_executable(${exe}
         Source/TrackerChannel.h
         Source/TransposeDlg.cpp
         Source/TransposeDlg.h
+        Source/UndoJournal.cpp
+        Source/UndoJournal.h
+        Source/VGMWriter.cpp
+        Source/VGMWriter.h
         Source/VersionChecker.cpp
         Source/VersionChecker.h
         Source/VersionCheckerDlg.cpp
@@ -728,6 +728,9 @@
 #define IDC_OPLL_PATCHNAME18            1599
 #define IDC_OPLL_PATCHNAME19            1600
 #define IDC_OPLL_PATCHNAME0             1600
+#define IDC_DEVICE_RATE                 1601
+#define IDC_TIMESTAMP_NOTES             1602
+#define IDC_MERGE_PATTERNS              1603
 #define IDS_FIND_BEGIN                  9001
 #define IDS_FIND_END                    9002
 #define ID_TRACKER_PLAY                 32771
@@ -1003,7 +1006,7 @@
 #ifndef APSTUDIO_READONLY_SYMBOLS
 #define _APS_NEXT_RESOURCE_VALUE        380
 #define _APS_NEXT_COMMAND_VALUE         33215
-#define _APS_NEXT_CONTROL_VALUE         1537
+#define _APS_NEXT_CONTROL_VALUE         1604
 #define _APS_NEXT_SYMED_VALUE           179
 #endif
 #endif